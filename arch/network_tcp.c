@@ -21,6 +21,15 @@
 
 #include <string.h>  // memset
 
+#ifdef UA_ENABLE_TCP_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#if UA_MULTITHREADING >= 200
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL 0
 #endif
@@ -50,13 +59,9 @@ connection_releaserecvbuffer(UA_Connection *connection,
     UA_ByteString_deleteMembers(buf);
 }
 
+/* Send the full buffer. The buffer is not freed. */
 static UA_StatusCode
-connection_write(UA_Connection *connection, UA_ByteString *buf) {
-    if(connection->state == UA_CONNECTIONSTATE_CLOSED) {
-        UA_ByteString_deleteMembers(buf);
-        return UA_STATUSCODE_BADCONNECTIONCLOSED;
-    }
-
+connection_sendBuffer(UA_Connection *connection, const UA_ByteString *buf) {
     /* Prevent OS signals when sending to a closed socket */
     int flags = 0;
     flags |= MSG_NOSIGNAL;
@@ -72,47 +77,30 @@ connection_write(UA_Connection *connection, UA_ByteString *buf) {
                      bytes_to_send, flags);
             if(n < 0 && UA_ERRNO != UA_INTERRUPTED && UA_ERRNO != UA_AGAIN) {
                 connection->close(connection);
-                UA_ByteString_deleteMembers(buf);
                 return UA_STATUSCODE_BADCONNECTIONCLOSED;
             }
         } while(n < 0);
         nWritten += (size_t)n;
     } while(nWritten < buf->length);
-
-    /* Free the buffer */
-    UA_ByteString_deleteMembers(buf);
     return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
-connection_recv(UA_Connection *connection, UA_ByteString *response,
-                UA_UInt32 timeout) {
-    if(connection->state == UA_CONNECTIONSTATE_CLOSED)
-        return UA_STATUSCODE_BADCONNECTIONCLOSED;
-
-    /* Listen on the socket for the given timeout until a message arrives */
-    fd_set fdset;
-    FD_ZERO(&fdset);
-    UA_fd_set(connection->sockfd, &fdset);
-    UA_UInt32 timeout_usec = timeout * 1000;
-    struct timeval tmptv = {(long int)(timeout_usec / 1000000),
-                            (int)(timeout_usec % 1000000)};
-    int resultsize = UA_select(connection->sockfd+1, &fdset, NULL, NULL, &tmptv);
-
-    /* No result */
-    if(resultsize == 0)
-        return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
-
-    if(resultsize == -1) {
-        /* The call to select was interrupted. Act as if it timed out. */
-        if(UA_ERRNO == EINTR)
-            return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
+connection_write(UA_Connection *connection, UA_ByteString *buf) {
+    UA_StatusCode retval = UA_STATUSCODE_BADCONNECTIONCLOSED;
+    if(connection->state != UA_CONNECTIONSTATE_CLOSED)
+        retval = connection_sendBuffer(connection, buf);
 
-        /* The error cannot be recovered. Close the connection. */
-        connection->close(connection);
-        return UA_STATUSCODE_BADCONNECTIONCLOSED;
-    }
+    /* Free the buffer */
+    UA_ByteString_deleteMembers(buf);
+    return retval;
+}
 
+/* Read from the socket without waiting for it to become readable. Returns
+ * UA_STATUSCODE_GOOD with an empty response if no data is available. */
+static UA_StatusCode
+connection_recvSocket(UA_Connection *connection, UA_ByteString *response,
+                      UA_UInt32 timeout) {
     UA_Boolean internallyAllocated = !response->length;
 
     /* Allocate the buffer  */
@@ -141,6 +129,8 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
     if(ret < 0) {
         if(internallyAllocated)
             UA_ByteString_deleteMembers(response);
+        else
+            response->length = 0; /* No bytes were received */
         if(UA_ERRNO == UA_INTERRUPTED || (timeout > 0) ?
            false : (UA_ERRNO == UA_EAGAIN || UA_ERRNO == UA_WOULDBLOCK))
             return UA_STATUSCODE_GOOD; /* statuscode_good but no data -> retry */
@@ -153,6 +143,38 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+connection_recv(UA_Connection *connection, UA_ByteString *response,
+                UA_UInt32 timeout) {
+    if(connection->state == UA_CONNECTIONSTATE_CLOSED)
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+    /* Listen on the socket for the given timeout until a message arrives */
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    UA_fd_set(connection->sockfd, &fdset);
+    UA_UInt32 timeout_usec = timeout * 1000;
+    struct timeval tmptv = {(long int)(timeout_usec / 1000000),
+                            (int)(timeout_usec % 1000000)};
+    int resultsize = UA_select(connection->sockfd+1, &fdset, NULL, NULL, &tmptv);
+
+    /* No result */
+    if(resultsize == 0)
+        return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
+
+    if(resultsize == -1) {
+        /* The call to select was interrupted. Act as if it timed out. */
+        if(UA_ERRNO == EINTR)
+            return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
+
+        /* The error cannot be recovered. Close the connection. */
+        connection->close(connection);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    return connection_recvSocket(connection, response, timeout);
+}
+
 
 /***************************/
 /* Server NetworkLayer TCP */
@@ -162,11 +184,39 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
 #define NOHELLOTIMEOUT 120000 /* timeout in ms before close the connection
                                * if server does not receive Hello Message */
 
+#ifndef UA_TCP_BUFFERPOOLSIZE
+# define UA_TCP_BUFFERPOOLSIZE 32 /* Maximum number of unused buffers that are
+                                   * kept for reuse per network layer */
+#endif
+
+/* Buffers of the pool are prefixed with a header that remembers their
+ * capacity. The length of a send buffer is adjusted to the message size before
+ * sending. So the capacity cannot be taken from the ByteString. */
+typedef struct PooledBuffer {
+    SLIST_ENTRY(PooledBuffer) next;
+    size_t capacity;
+} PooledBuffer;
+
 typedef struct ConnectionEntry {
     UA_Connection connection;
     LIST_ENTRY(ConnectionEntry) pointers;
+#ifdef UA_ENABLE_TCP_EPOLL
+    /* Connections that have not yet received a HEL message, ordered by their
+     * opening date. Only used by the epoll network layer. */
+    UA_Boolean opening;
+    TAILQ_ENTRY(ConnectionEntry) openingPointers;
+#endif
 } ConnectionEntry;
 
+/* Additional socket that is watched in listen, e.g. for PubSub */
+typedef struct WatchedSocket {
+    LIST_ENTRY(WatchedSocket) pointers;
+    UA_SOCKET sockfd;
+    UA_Boolean readable; /* Set in listen until the callback is called */
+    void (*callback)(UA_Server *server, void *context);
+    void *context;
+} WatchedSocket;
+
 typedef struct {
     const UA_Logger *logger;
     UA_UInt16 port;
@@ -175,8 +225,263 @@ typedef struct {
     UA_UInt16 serverSocketsSize;
     LIST_HEAD(, ConnectionEntry) connections;
     UA_UInt16 connectionsSize;
+    LIST_HEAD(, WatchedSocket) watchedSockets;
+
+    /* Released send and receive buffers are kept in a free-list. All buffers
+     * of the pool have the same size, derived from the connection config. */
+    size_t bufferSize;
+    SLIST_HEAD(, PooledBuffer) freeBuffers;
+    size_t freeBuffersSize;
+    UA_NetworkStatistics *statistics; /* Taken from the network layer during
+                                       * startup for the pool counters */
+    UA_LOCK_TYPE(bufferPoolMutex)
+#ifdef UA_ENABLE_TCP_EPOLL
+    int epollfd; /* -1 for the select-based network layer */
+    TAILQ_HEAD(, ConnectionEntry) openingConnections;
+    UA_DateTime acceptResume; /* The server sockets are removed from epoll
+                               * until then when the descriptors ran out.
+                               * 0 if connections are accepted. */
+#endif
+#if UA_MULTITHREADING >= 200
+    int wakeupPipe[2]; /* Self-pipe to interrupt the waiting in listen. The
+                        * read end is watched together with the sockets. */
+#endif
 } ServerNetworkLayerTCP;
 
+/* Buffers up to the pool buffer size are taken from the free-list if
+ * possible. Larger buffers are allocated with the header but are freed on
+ * release. */
+static UA_StatusCode
+ServerNetworkLayerTCP_allocBuffer(ServerNetworkLayerTCP *layer,
+                                  size_t length, UA_ByteString *buf) {
+    PooledBuffer *pb = NULL;
+    UA_LOCK(layer->bufferPoolMutex);
+    if(length <= layer->bufferSize) {
+        pb = SLIST_FIRST(&layer->freeBuffers);
+        if(pb) {
+            SLIST_REMOVE_HEAD(&layer->freeBuffers, next);
+            layer->freeBuffersSize--;
+        }
+    }
+    if(layer->statistics) {
+        if(pb)
+            layer->statistics->bufferPoolHitCount++;
+        else
+            layer->statistics->bufferPoolMissCount++;
+    }
+    UA_UNLOCK(layer->bufferPoolMutex);
+
+    if(!pb) {
+        size_t capacity = (length > layer->bufferSize) ? length : layer->bufferSize;
+        pb = (PooledBuffer*)UA_malloc(sizeof(PooledBuffer) + capacity);
+        if(!pb)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        pb->capacity = capacity;
+    }
+
+    buf->data = (UA_Byte*)pb + sizeof(PooledBuffer);
+    buf->length = length;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerTCP_releaseBuffer(ServerNetworkLayerTCP *layer,
+                                    UA_ByteString *buf) {
+    if(!buf->data)
+        return;
+    PooledBuffer *pb = (PooledBuffer*)(buf->data - sizeof(PooledBuffer));
+    buf->data = NULL;
+    buf->length = 0;
+
+    if(pb->capacity == layer->bufferSize) {
+        UA_LOCK(layer->bufferPoolMutex);
+        if(layer->freeBuffersSize < UA_TCP_BUFFERPOOLSIZE) {
+            SLIST_INSERT_HEAD(&layer->freeBuffers, pb, next);
+            layer->freeBuffersSize++;
+            pb = NULL;
+        }
+        UA_UNLOCK(layer->bufferPoolMutex);
+    }
+    UA_free(pb);
+}
+
+#if UA_MULTITHREADING >= 200
+
+static UA_StatusCode
+ServerNetworkLayerTCP_openWakeupPipe(ServerNetworkLayerTCP *layer) {
+    if(layer->wakeupPipe[0] >= 0)
+        return UA_STATUSCODE_GOOD;
+    if(pipe(layer->wakeupPipe) != 0) {
+        layer->wakeupPipe[0] = -1;
+        layer->wakeupPipe[1] = -1;
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Could not create the wakeup pipe: %s", errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    for(size_t i = 0; i < 2; i++) {
+        fcntl(layer->wakeupPipe[i], F_SETFL,
+              fcntl(layer->wakeupPipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(layer->wakeupPipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerTCP_closeWakeupPipe(ServerNetworkLayerTCP *layer) {
+    for(size_t i = 0; i < 2; i++) {
+        if(layer->wakeupPipe[i] >= 0)
+            close(layer->wakeupPipe[i]);
+        layer->wakeupPipe[i] = -1;
+    }
+}
+
+/* Consume all pending wakeups */
+static void
+ServerNetworkLayerTCP_drainWakeupPipe(ServerNetworkLayerTCP *layer) {
+    char buf[64];
+    while(read(layer->wakeupPipe[0], buf, sizeof(buf)) > 0) {}
+}
+
+/* A full pipe already has a wakeup pending. So a failed write is ignored. */
+static void
+ServerNetworkLayerTCP_wakeup(UA_ServerNetworkLayer *nl) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    if(layer->wakeupPipe[1] < 0)
+        return;
+    char c = 0;
+    ssize_t res = write(layer->wakeupPipe[1], &c, 1);
+    (void)res;
+}
+
+#endif
+
+#ifdef UA_ENABLE_TCP_EPOLL
+/* The watched sockets are level-triggered. The callback does not need to
+ * receive all pending messages at once. */
+static UA_StatusCode
+ServerNetworkLayerTCPEpoll_addWatchedSocket(ServerNetworkLayerTCP *layer,
+                                            WatchedSocket *w) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(struct epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.ptr = w;
+    if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD, w->sockfd, &ev) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Could not register the watched socket %i "
+                         "with epoll: %s", (int)w->sockfd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
+static UA_StatusCode
+ServerNetworkLayerTCP_watchSocket(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd,
+                                  void (*callback)(UA_Server *server, void *context),
+                                  void *context) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(w->sockfd == sockfd)
+            return UA_STATUSCODE_BADENTRYEXISTS;
+    }
+
+    w = (WatchedSocket*)UA_malloc(sizeof(WatchedSocket));
+    if(!w)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    w->sockfd = sockfd;
+    w->readable = false;
+    w->callback = callback;
+    w->context = context;
+
+#ifdef UA_ENABLE_TCP_EPOLL
+    /* Sockets watched before the start are registered during the start */
+    if(layer->epollfd >= 0) {
+        UA_StatusCode retval = ServerNetworkLayerTCPEpoll_addWatchedSocket(layer, w);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_free(w);
+            return retval;
+        }
+    }
+#endif
+
+    LIST_INSERT_HEAD(&layer->watchedSockets, w, pointers);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerTCP_unwatchSocket(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(w->sockfd == sockfd)
+            break;
+    }
+    if(!w)
+        return;
+#ifdef UA_ENABLE_TCP_EPOLL
+    if(layer->epollfd >= 0)
+        epoll_ctl(layer->epollfd, EPOLL_CTL_DEL, w->sockfd, NULL);
+#endif
+    LIST_REMOVE(w, pointers);
+    UA_free(w);
+}
+
+/* Call the callbacks of the readable watched sockets. A callback may unwatch
+ * other sockets. So the list is searched again after every callback. */
+static void
+ServerNetworkLayerTCP_notifyWatched(ServerNetworkLayerTCP *layer, UA_Server *server) {
+    WatchedSocket *w;
+    do {
+        LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+            if(w->readable)
+                break;
+        }
+        if(w) {
+            w->readable = false;
+            w->callback(server, w->context);
+        }
+    } while(w);
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_getsendbuffer(UA_Connection *connection,
+                                    size_t length, UA_ByteString *buf) {
+    UA_SecureChannel *channel = connection->channel;
+    if(channel && channel->config.sendBufferSize < length)
+        return UA_STATUSCODE_BADCOMMUNICATIONERROR;
+    return ServerNetworkLayerTCP_allocBuffer((ServerNetworkLayerTCP*)connection->handle,
+                                             length, buf);
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_getrecvbuffer(UA_Connection *connection, UA_ByteString *buf) {
+    size_t bufferSize = 16384; /* Use as default for a new SecureChannel */
+    UA_SecureChannel *channel = connection->channel;
+    if(channel && channel->config.recvBufferSize > 0)
+        bufferSize = channel->config.recvBufferSize;
+    return ServerNetworkLayerTCP_allocBuffer((ServerNetworkLayerTCP*)connection->handle,
+                                             bufferSize, buf);
+}
+
+static void
+ServerNetworkLayerTCP_releasebuffer(UA_Connection *connection, UA_ByteString *buf) {
+    ServerNetworkLayerTCP_releaseBuffer((ServerNetworkLayerTCP*)connection->handle, buf);
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCP_write(UA_Connection *connection, UA_ByteString *buf) {
+    UA_StatusCode retval = UA_STATUSCODE_BADCONNECTIONCLOSED;
+    if(connection->state != UA_CONNECTIONSTATE_CLOSED)
+        retval = connection_sendBuffer(connection, buf);
+
+    /* Return the buffer to the pool */
+    ServerNetworkLayerTCP_releasebuffer(connection, buf);
+    return retval;
+}
+
 static void
 ServerNetworkLayerTCP_freeConnection(UA_Connection *connection) {
     UA_free(connection);
@@ -199,6 +504,10 @@ purgeFirstConnectionWithoutChannel(ServerNetworkLayerTCP *layer) {
         if(e->connection.channel == NULL) {
             LIST_REMOVE(e, pointers);
             layer->connectionsSize--;
+#ifdef UA_ENABLE_TCP_EPOLL
+            if(e->opening)
+                TAILQ_REMOVE(&layer->openingConnections, e, openingPointers);
+#endif
             UA_close(e->connection.sockfd);
             e->connection.free(&e->connection);
             return true;
@@ -261,15 +570,38 @@ ServerNetworkLayerTCP_add(UA_ServerNetworkLayer *nl, ServerNetworkLayerTCP *laye
     memset(c, 0, sizeof(UA_Connection));
     c->sockfd = newsockfd;
     c->handle = layer;
-    c->send = connection_write;
+    c->send = ServerNetworkLayerTCP_write;
     c->close = ServerNetworkLayerTCP_close;
     c->free = ServerNetworkLayerTCP_freeConnection;
-    c->getSendBuffer = connection_getsendbuffer;
-    c->releaseSendBuffer = connection_releasesendbuffer;
-    c->releaseRecvBuffer = connection_releaserecvbuffer;
+    c->getSendBuffer = ServerNetworkLayerTCP_getsendbuffer;
+    c->releaseSendBuffer = ServerNetworkLayerTCP_releasebuffer;
+    c->releaseRecvBuffer = ServerNetworkLayerTCP_releasebuffer;
     c->state = UA_CONNECTIONSTATE_OPENING;
     c->openingDate = UA_DateTime_nowMonotonic();
 
+#ifdef UA_ENABLE_TCP_EPOLL
+    e->opening = false;
+
+    /* Register for edge-triggered readiness notifications. Data that arrived
+     * before the registration is reported right away. */
+    if(layer->epollfd >= 0) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(struct epoll_event));
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = e;
+        if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD, newsockfd, &ev) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                               "Connection %i | Could not register the socket "
+                               "with epoll: %s", (int)newsockfd, errno_str));
+            UA_free(e);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        e->opening = true;
+        TAILQ_INSERT_TAIL(&layer->openingConnections, e, openingPointers);
+    }
+#endif
+
     /* Add to the linked list */
     LIST_INSERT_HEAD(&layer->connections, e, pointers);
     if(nl->statistics) {
@@ -388,6 +720,7 @@ ServerNetworkLayerTCP_start(UA_ServerNetworkLayer *nl, const UA_String *customHo
     UA_initialize_architecture_network();
 
     ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    layer->statistics = nl->statistics;
 
     /* Get addrinfo of the server and create server sockets */
     char hostname[512];
@@ -422,6 +755,12 @@ ServerNetworkLayerTCP_start(UA_ServerNetworkLayer *nl, const UA_String *customHo
     }
     UA_freeaddrinfo(res);
 
+#if UA_MULTITHREADING >= 200
+    UA_StatusCode retval = ServerNetworkLayerTCP_openWakeupPipe(layer);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+#endif
+
     /* Get the discovery url from the hostname */
     UA_String du = UA_STRING_NULL;
     char discoveryUrlBuffer[256];
@@ -467,6 +806,21 @@ setFDSet(ServerNetworkLayerTCP *layer, fd_set *fdset) {
             highestfd = (UA_Int32)e->connection.sockfd;
     }
 
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        UA_fd_set(w->sockfd, fdset);
+        if((UA_Int32)w->sockfd > highestfd)
+            highestfd = (UA_Int32)w->sockfd;
+    }
+
+#if UA_MULTITHREADING >= 200
+    if(layer->wakeupPipe[0] >= 0) {
+        UA_fd_set(layer->wakeupPipe[0], fdset);
+        if(layer->wakeupPipe[0] > highestfd)
+            highestfd = layer->wakeupPipe[0];
+    }
+#endif
+
     return highestfd;
 }
 
@@ -492,6 +846,11 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
         return UA_STATUSCODE_GOOD;
     }
 
+#if UA_MULTITHREADING >= 200
+    if(layer->wakeupPipe[0] >= 0 && UA_fd_isset(layer->wakeupPipe[0], &fdset))
+        ServerNetworkLayerTCP_drainWakeupPipe(layer);
+#endif
+
     /* Accept new connections via the server sockets */
     for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++) {
         if(!UA_fd_isset(layer->serverSockets[i], &fdset))
@@ -542,13 +901,16 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
                     (int)(e->connection.sockfd));
 
         UA_ByteString buf = UA_BYTESTRING_NULL;
-        UA_StatusCode retval = connection_recv(&e->connection, &buf, 0);
+        UA_StatusCode retval = ServerNetworkLayerTCP_getrecvbuffer(&e->connection, &buf);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = connection_recv(&e->connection, &buf, 0);
 
-        if(retval == UA_STATUSCODE_GOOD) {
-            /* Process packets */
+        /* Process packets */
+        if(retval == UA_STATUSCODE_GOOD && buf.length > 0)
             UA_Server_processBinaryMessage(server, &e->connection, &buf);
-            connection_releaserecvbuffer(&e->connection, &buf);
-        } else if(retval == UA_STATUSCODE_BADCONNECTIONCLOSED) {
+        ServerNetworkLayerTCP_releasebuffer(&e->connection, &buf);
+
+        if(retval == UA_STATUSCODE_BADCONNECTIONCLOSED) {
             /* The socket is shutdown but not closed */
             UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
                         "Connection %i | Closed",
@@ -562,6 +924,12 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
             }
         }
     }
+
+    /* Notify the readable watched sockets */
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers)
+        w->readable = UA_fd_isset(w->sockfd, &fdset);
+    ServerNetworkLayerTCP_notifyWatched(layer, server);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -609,6 +977,29 @@ ServerNetworkLayerTCP_deleteMembers(UA_ServerNetworkLayer *nl) {
         }
     }
 
+    /* The watched sockets are not owned by the network layer */
+    WatchedSocket *w, *w_tmp;
+    LIST_FOREACH_SAFE(w, &layer->watchedSockets, pointers, w_tmp) {
+        LIST_REMOVE(w, pointers);
+        UA_free(w);
+    }
+
+#ifdef UA_ENABLE_TCP_EPOLL
+    if(layer->epollfd >= 0)
+        UA_close(layer->epollfd);
+#endif
+#if UA_MULTITHREADING >= 200
+    ServerNetworkLayerTCP_closeWakeupPipe(layer);
+#endif
+
+    /* Free the pooled buffers */
+    PooledBuffer *pb;
+    while((pb = SLIST_FIRST(&layer->freeBuffers))) {
+        SLIST_REMOVE_HEAD(&layer->freeBuffers, next);
+        UA_free(pb);
+    }
+    UA_LOCK_DESTROY(layer->bufferPoolMutex)
+
     /* Free the layer */
     UA_free(layer);
 }
@@ -623,6 +1014,11 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
     nl.start = ServerNetworkLayerTCP_start;
     nl.listen = ServerNetworkLayerTCP_listen;
     nl.stop = ServerNetworkLayerTCP_stop;
+#if UA_MULTITHREADING >= 200
+    nl.wakeup = ServerNetworkLayerTCP_wakeup;
+#endif
+    nl.watchSocket = ServerNetworkLayerTCP_watchSocket;
+    nl.unwatchSocket = ServerNetworkLayerTCP_unwatchSocket;
     nl.handle = NULL;
 
     ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP*)
@@ -635,9 +1031,371 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
     layer->port = port;
     layer->maxConnections = maxConnections;
 
+    /* Pooled buffers can hold a full chunk in either direction */
+    layer->bufferSize = 16384;
+    if(config.recvBufferSize > layer->bufferSize)
+        layer->bufferSize = config.recvBufferSize;
+    if(config.sendBufferSize > layer->bufferSize)
+        layer->bufferSize = config.sendBufferSize;
+    SLIST_INIT(&layer->freeBuffers);
+    LIST_INIT(&layer->watchedSockets);
+    UA_LOCK_INIT(layer->bufferPoolMutex)
+#ifdef UA_ENABLE_TCP_EPOLL
+    layer->epollfd = -1;
+    TAILQ_INIT(&layer->openingConnections);
+    layer->acceptResume = 0;
+#endif
+#if UA_MULTITHREADING >= 200
+    layer->wakeupPipe[0] = -1;
+    layer->wakeupPipe[1] = -1;
+#endif
+
     return nl;
 }
 
+#ifdef UA_ENABLE_TCP_EPOLL
+
+/*********************************/
+/* Server NetworkLayer TCP Epoll */
+/*********************************/
+
+/* The epoll network layer shares the connection handling with the select-based
+ * layer. But sockets are registered once with an edge-triggered epoll instance.
+ * So the cost of an iteration depends on the number of sockets with activity
+ * and not on the number of open connections. Also, the socket descriptors are
+ * not limited by FD_SETSIZE. */
+
+#define EPOLL_MAXEVENTS 64
+#define ACCEPTBACKOFF 100 /* Time in ms before accepting is retried when the
+                           * socket descriptors ran out */
+
+/* The server sockets are level-triggered. Pending connections are accepted with
+ * the next call to listen. */
+static UA_StatusCode
+ServerNetworkLayerTCPEpoll_addServerSockets(ServerNetworkLayerTCP *layer) {
+    for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(struct epoll_event));
+        ev.events = EPOLLIN;
+        ev.data.ptr = &layer->serverSockets[i];
+        if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD,
+                     layer->serverSockets[i], &ev) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                             "Could not register the server socket "
+                             "with epoll: %s", errno_str));
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+    layer->acceptResume = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* A pending connection cannot be accepted without a free descriptor. As the
+ * server sockets are level-triggered, epoll would report them again right away
+ * and the loop would spin. So they are removed from epoll until a connection is
+ * closed or the backoff time has passed. */
+static void
+ServerNetworkLayerTCPEpoll_pauseAccept(ServerNetworkLayerTCP *layer) {
+    UA_LOG_SOCKET_ERRNO_WRAP(
+        UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                       "Pause accepting connections for %ims: %s",
+                       ACCEPTBACKOFF, errno_str));
+    for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++)
+        epoll_ctl(layer->epollfd, EPOLL_CTL_DEL, layer->serverSockets[i], NULL);
+    layer->acceptResume = UA_DateTime_nowMonotonic() +
+        (ACCEPTBACKOFF * UA_DATETIME_MSEC);
+}
+
+static void
+ServerNetworkLayerTCPEpoll_resumeAccept(ServerNetworkLayerTCP *layer) {
+    UA_LOG_DEBUG(layer->logger, UA_LOGCATEGORY_NETWORK,
+                 "Resume accepting connections");
+    ServerNetworkLayerTCPEpoll_addServerSockets(layer);
+}
+
+static void
+ServerNetworkLayerTCPEpoll_removeConnection(UA_ServerNetworkLayer *nl,
+                                            ServerNetworkLayerTCP *layer,
+                                            UA_Server *server, ConnectionEntry *e) {
+    LIST_REMOVE(e, pointers);
+    layer->connectionsSize--;
+    if(e->opening)
+        TAILQ_REMOVE(&layer->openingConnections, e, openingPointers);
+    /* Closing the socket also removes it from the epoll instance */
+    UA_close(e->connection.sockfd);
+    UA_Server_removeConnection(server, &e->connection);
+    if(nl->statistics)
+        nl->statistics->currentConnectionCount--;
+
+    /* A descriptor was freed */
+    if(layer->acceptResume != 0)
+        ServerNetworkLayerTCPEpoll_resumeAccept(layer);
+}
+
+/* The opening connections are ordered by their opening date. So only the
+ * connections that actually timed out are visited. Connections that have
+ * received a HEL message in the meantime are dropped from the queue. */
+static void
+ServerNetworkLayerTCPEpoll_checkHelloTimeout(UA_ServerNetworkLayer *nl,
+                                             ServerNetworkLayerTCP *layer,
+                                             UA_Server *server) {
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    ConnectionEntry *e;
+    while((e = TAILQ_FIRST(&layer->openingConnections))) {
+        if(e->connection.state == UA_CONNECTIONSTATE_OPENING &&
+           now <= e->connection.openingDate + (NOHELLOTIMEOUT * UA_DATETIME_MSEC))
+            break;
+
+        TAILQ_REMOVE(&layer->openingConnections, e, openingPointers);
+        e->opening = false;
+        if(e->connection.state != UA_CONNECTIONSTATE_OPENING)
+            continue;
+
+        UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | Closed by the server (no Hello Message)",
+                    (int)(e->connection.sockfd));
+        if(nl->statistics)
+            nl->statistics->connectionTimeoutCount++;
+        ServerNetworkLayerTCPEpoll_removeConnection(nl, layer, server, e);
+    }
+}
+
+static void
+ServerNetworkLayerTCPEpoll_accept(UA_ServerNetworkLayer *nl,
+                                  ServerNetworkLayerTCP *layer,
+                                  UA_SOCKET serverSocket) {
+    /* Accept until no connection is pending anymore */
+    while(true) {
+        struct sockaddr_storage remote;
+        socklen_t remote_size = sizeof(remote);
+        UA_SOCKET newsockfd = UA_accept(serverSocket, (struct sockaddr*)&remote,
+                                        &remote_size);
+        if(newsockfd == UA_INVALID_SOCKET) {
+            if(UA_ERRNO == EMFILE || UA_ERRNO == ENFILE ||
+               UA_ERRNO == ENOBUFS || UA_ERRNO == ENOMEM)
+                ServerNetworkLayerTCPEpoll_pauseAccept(layer);
+            return;
+        }
+
+        UA_LOG_TRACE(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | New TCP connection on server socket %i",
+                    (int)newsockfd, (int)serverSocket);
+
+        if(ServerNetworkLayerTCP_add(nl, layer, (UA_Int32)newsockfd,
+                                     &remote) != UA_STATUSCODE_GOOD)
+            UA_close(newsockfd);
+    }
+}
+
+/* The socket is edge-triggered. So it is read until no more data is
+ * available. */
+static void
+ServerNetworkLayerTCPEpoll_recv(UA_ServerNetworkLayer *nl,
+                                ServerNetworkLayerTCP *layer,
+                                UA_Server *server, ConnectionEntry *e) {
+    UA_LOG_TRACE(layer->logger, UA_LOGCATEGORY_NETWORK,
+                 "Connection %i | Activity on the socket",
+                 (int)(e->connection.sockfd));
+
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    while(true) {
+        if(e->connection.state == UA_CONNECTIONSTATE_CLOSED) {
+            retval = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            break;
+        }
+        UA_ByteString buf = UA_BYTESTRING_NULL;
+        retval = ServerNetworkLayerTCP_getrecvbuffer(&e->connection, &buf);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = connection_recvSocket(&e->connection, &buf, 0);
+        UA_Boolean received = (retval == UA_STATUSCODE_GOOD && buf.length > 0);
+        if(received)
+            UA_Server_processBinaryMessage(server, &e->connection, &buf);
+        ServerNetworkLayerTCP_releasebuffer(&e->connection, &buf);
+        if(!received)
+            break;
+    }
+
+    if(retval == UA_STATUSCODE_BADCONNECTIONCLOSED) {
+        /* The socket is shutdown but not closed */
+        UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
+                    "Connection %i | Closed",
+                    (int)(e->connection.sockfd));
+        ServerNetworkLayerTCPEpoll_removeConnection(nl, layer, server, e);
+    }
+}
+
+static UA_Boolean
+isServerSocketEvent(ServerNetworkLayerTCP *layer, struct epoll_event *ev) {
+    return (ev->data.ptr >= (void*)layer->serverSockets &&
+            ev->data.ptr < (void*)&layer->serverSockets[layer->serverSocketsSize]);
+}
+
+static UA_Boolean
+isWakeupEvent(ServerNetworkLayerTCP *layer, struct epoll_event *ev) {
+#if UA_MULTITHREADING >= 200
+    return (ev->data.ptr == (void*)layer->wakeupPipe);
+#else
+    return false;
+#endif
+}
+
+static WatchedSocket *
+getWatchedSocket(ServerNetworkLayerTCP *layer, struct epoll_event *ev) {
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(ev->data.ptr == (void*)w)
+            return w;
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCPEpoll_start(UA_ServerNetworkLayer *nl,
+                                 const UA_String *customHostname) {
+    UA_StatusCode retval = ServerNetworkLayerTCP_start(nl, customHostname);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    layer->epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if(layer->epollfd < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Could not create the epoll instance: %s", errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    retval = ServerNetworkLayerTCPEpoll_addServerSockets(layer);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    WatchedSocket *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        retval = ServerNetworkLayerTCPEpoll_addWatchedSocket(layer, w);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+#if UA_MULTITHREADING >= 200
+    /* The wakeup pipe is level-triggered and drained in listen */
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(struct epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.ptr = layer->wakeupPipe;
+    if(epoll_ctl(layer->epollfd, EPOLL_CTL_ADD, layer->wakeupPipe[0], &ev) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Could not register the wakeup pipe "
+                         "with epoll: %s", errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+ServerNetworkLayerTCPEpoll_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
+                                  UA_UInt16 timeout) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    if(layer->serverSocketsSize == 0 || layer->epollfd < 0)
+        return UA_STATUSCODE_GOOD;
+
+    ServerNetworkLayerTCPEpoll_checkHelloTimeout(nl, layer, server);
+
+    if(layer->acceptResume != 0 &&
+       UA_DateTime_nowMonotonic() >= layer->acceptResume)
+        ServerNetworkLayerTCPEpoll_resumeAccept(layer);
+
+    struct epoll_event events[EPOLL_MAXEVENTS];
+    int n = epoll_wait(layer->epollfd, events, EPOLL_MAXEVENTS, timeout);
+    if(n < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_DEBUG(layer->logger, UA_LOGCATEGORY_NETWORK,
+                         "Epoll wait failed with %s", errno_str));
+        // we will retry, so do not return bad
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Take the events of the watched sockets out of the batch before any
+     * callback is called */
+    for(int i = 0; i < n; i++) {
+        WatchedSocket *w = getWatchedSocket(layer, &events[i]);
+        if(w) {
+            w->readable = true;
+            events[i].data.ptr = NULL;
+        }
+    }
+
+    /* Read from established sockets first. Accepting new connections may purge
+     * connections with a pending event from the same batch. */
+    for(int i = 0; i < n; i++) {
+        if(!events[i].data.ptr)
+            continue;
+        if(isWakeupEvent(layer, &events[i])) {
+#if UA_MULTITHREADING >= 200
+            ServerNetworkLayerTCP_drainWakeupPipe(layer);
+#endif
+            continue;
+        }
+        if(!isServerSocketEvent(layer, &events[i]))
+            ServerNetworkLayerTCPEpoll_recv(nl, layer, server,
+                                            (ConnectionEntry*)events[i].data.ptr);
+    }
+
+    /* Notify the readable watched sockets */
+    ServerNetworkLayerTCP_notifyWatched(layer, server);
+
+    /* Accept new connections via the server sockets */
+    for(int i = 0; i < n; i++) {
+        if(events[i].data.ptr && isServerSocketEvent(layer, &events[i]))
+            ServerNetworkLayerTCPEpoll_accept(nl, layer,
+                                              *(UA_SOCKET*)events[i].data.ptr);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerTCPEpoll_stop(UA_ServerNetworkLayer *nl, UA_Server *server) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
+                "Shutting down the TCP network layer");
+
+    /* Close the server sockets */
+    for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++) {
+        UA_shutdown(layer->serverSockets[i], 2);
+        UA_close(layer->serverSockets[i]);
+    }
+    layer->serverSocketsSize = 0;
+
+    /* Close and remove the open connections */
+    ConnectionEntry *e, *e_tmp;
+    LIST_FOREACH_SAFE(e, &layer->connections, pointers, e_tmp) {
+        ServerNetworkLayerTCP_close(&e->connection);
+        ServerNetworkLayerTCPEpoll_removeConnection(nl, layer, server, e);
+    }
+
+    if(layer->epollfd >= 0) {
+        UA_close(layer->epollfd);
+        layer->epollfd = -1;
+    }
+
+    UA_deinitialize_architecture_network();
+}
+
+UA_ServerNetworkLayer
+UA_ServerNetworkLayerTCPEpoll(UA_ConnectionConfig config, UA_UInt16 port,
+                              UA_UInt16 maxConnections, UA_Logger *logger) {
+    UA_ServerNetworkLayer nl =
+        UA_ServerNetworkLayerTCP(config, port, maxConnections, logger);
+    nl.start = ServerNetworkLayerTCPEpoll_start;
+    nl.listen = ServerNetworkLayerTCPEpoll_listen;
+    nl.stop = ServerNetworkLayerTCPEpoll_stop;
+    return nl;
+}
+
+#endif /* UA_ENABLE_TCP_EPOLL */
+
 typedef struct TCPClientConnection {
     struct addrinfo hints, *server;
     UA_DateTime connStart;
@@ -154,6 +154,32 @@ void UA_sleep_ms(unsigned long ms);
 #define UA_UNLOCK(mutexName) UA_assert(--(mutexName##Counter) == 0); \
                              pthread_mutex_unlock(&mutexName);
 #define UA_LOCK_ASSERT(mutexName, num) UA_assert(mutexName##Counter == num);
+
+/* Reader/writer lock. The counter tracks the exclusive holder (and is
+ * compatible with UA_LOCK_ASSERT). The number of readers is only tracked for
+ * debug assertions. */
+#define UA_RWLOCK_TYPE(lockName) pthread_rwlock_t lockName; \
+                                 int lockName##Counter; \
+                                 volatile size_t lockName##Readers;
+#define UA_RWLOCK_INIT(lockName) pthread_rwlock_init(&lockName, NULL); \
+                                 lockName##Counter = 0; \
+                                 lockName##Readers = 0;
+#define UA_RWLOCK_DESTROY(lockName) pthread_rwlock_destroy(&lockName);
+#define UA_WRLOCK(lockName) pthread_rwlock_wrlock(&lockName); \
+                            lockName##Counter++; \
+                            UA_assert(lockName##Counter == 1);
+#define UA_WRUNLOCK(lockName) lockName##Counter--; \
+                              UA_assert(lockName##Counter == 0); \
+                              pthread_rwlock_unlock(&lockName);
+#define UA_RDLOCK(lockName) pthread_rwlock_rdlock(&lockName); \
+                            UA_assert(UA_atomic_addSize(&lockName##Readers, 1) > 0);
+#define UA_RDUNLOCK(lockName) UA_assert(UA_atomic_subSize(&lockName##Readers, 1) != (size_t)-1); \
+                              pthread_rwlock_unlock(&lockName);
+#define UA_RDLOCK_TRY(lockName, success) \
+    success = (pthread_rwlock_tryrdlock(&lockName) == 0); \
+    if(success) { UA_assert(UA_atomic_addSize(&lockName##Readers, 1) > 0); }
+#define UA_RWLOCK_ISEXCLUSIVE(lockName) (lockName##Counter > 0)
+#define UA_RWLOCK_ASSERT(lockName) UA_assert(lockName##Counter == 1 || lockName##Readers > 0);
 #else
 #define UA_LOCK_TYPE(mutexName)
 #define UA_LOCK_INIT(mutexName)
@@ -161,6 +187,16 @@ void UA_sleep_ms(unsigned long ms);
 #define UA_LOCK(mutexName)
 #define UA_UNLOCK(mutexName)
 #define UA_LOCK_ASSERT(mutexName, num)
+#define UA_RWLOCK_TYPE(lockName)
+#define UA_RWLOCK_INIT(lockName)
+#define UA_RWLOCK_DESTROY(lockName)
+#define UA_WRLOCK(lockName)
+#define UA_WRUNLOCK(lockName)
+#define UA_RDLOCK(lockName)
+#define UA_RDUNLOCK(lockName)
+#define UA_RDLOCK_TRY(lockName, success) success = true;
+#define UA_RWLOCK_ISEXCLUSIVE(lockName) true
+#define UA_RWLOCK_ASSERT(lockName)
 #endif
 
 #include <open62541/architecture_functions.h>
@@ -118,6 +118,16 @@
 #define UA_LOCK(mutexName)
 #define UA_UNLOCK(mutexName)
 #define UA_LOCK_ASSERT(mutexName, num)
+#define UA_RWLOCK_TYPE(lockName)
+#define UA_RWLOCK_INIT(lockName)
+#define UA_RWLOCK_DESTROY(lockName)
+#define UA_WRLOCK(lockName)
+#define UA_WRUNLOCK(lockName)
+#define UA_RDLOCK(lockName)
+#define UA_RDUNLOCK(lockName)
+#define UA_RDLOCK_TRY(lockName, success) success = true;
+#define UA_RWLOCK_ISEXCLUSIVE(lockName) true
+#define UA_RWLOCK_ASSERT(lockName)
 #endif
 
 #include <open62541/architecture_functions.h>
@@ -150,6 +150,28 @@ void UA_sleep_ms(unsigned long ms);
 #define UA_UNLOCK(mutexName) UA_assert(--(mutexName##Counter) == 0); \
                              LeaveCriticalSection(&mutexName);
 #define UA_LOCK_ASSERT(mutexName, num) UA_assert(mutexName##Counter == num);
+#define UA_RWLOCK_TYPE(lockName) SRWLOCK lockName; \
+                                 int lockName##Counter; \
+                                 volatile size_t lockName##Readers;
+#define UA_RWLOCK_INIT(lockName) InitializeSRWLock(&lockName); \
+                                 lockName##Counter = 0; \
+                                 lockName##Readers = 0;
+#define UA_RWLOCK_DESTROY(lockName)
+#define UA_WRLOCK(lockName) AcquireSRWLockExclusive(&lockName); \
+                            lockName##Counter++; \
+                            UA_assert(lockName##Counter == 1);
+#define UA_WRUNLOCK(lockName) lockName##Counter--; \
+                              UA_assert(lockName##Counter == 0); \
+                              ReleaseSRWLockExclusive(&lockName);
+#define UA_RDLOCK(lockName) AcquireSRWLockShared(&lockName); \
+                            UA_assert(UA_atomic_addSize(&lockName##Readers, 1) > 0);
+#define UA_RDUNLOCK(lockName) UA_assert(UA_atomic_subSize(&lockName##Readers, 1) != (size_t)-1); \
+                              ReleaseSRWLockShared(&lockName);
+#define UA_RDLOCK_TRY(lockName, success) \
+    success = (TryAcquireSRWLockShared(&lockName) != 0); \
+    if(success) { UA_assert(UA_atomic_addSize(&lockName##Readers, 1) > 0); }
+#define UA_RWLOCK_ISEXCLUSIVE(lockName) (lockName##Counter > 0)
+#define UA_RWLOCK_ASSERT(lockName) UA_assert(lockName##Counter == 1 || lockName##Readers > 0);
 #else
 #define UA_LOCK_TYPE(mutexName)
 #define UA_LOCK_TYPE_POINTER(mutexName)
@@ -158,6 +180,16 @@ void UA_sleep_ms(unsigned long ms);
 #define UA_LOCK(mutexName)
 #define UA_UNLOCK(mutexName)
 #define UA_LOCK_ASSERT(mutexName, num)
+#define UA_RWLOCK_TYPE(lockName)
+#define UA_RWLOCK_INIT(lockName)
+#define UA_RWLOCK_DESTROY(lockName)
+#define UA_WRLOCK(lockName)
+#define UA_WRUNLOCK(lockName)
+#define UA_RDLOCK(lockName)
+#define UA_RDUNLOCK(lockName)
+#define UA_RDLOCK_TRY(lockName, success) success = true;
+#define UA_RWLOCK_ISEXCLUSIVE(lockName) true
+#define UA_RWLOCK_ASSERT(lockName)
 #endif
 
 #include <open62541/architecture_functions.h>
@@ -355,8 +355,9 @@ UA_STATIC_ASSERT(sizeof(bool) == 1, cannot_overlay_integers_with_large_bool);
  * -----------------
  * Atomic operations that synchronize across processor cores (for
  * multithreading). Only the inline-functions defined next are used. Replace
- * with architecture-specific operations if necessary. */
-#if UA_MULTITHREADING >= 200
+ * with architecture-specific operations if necessary. They are required as
+ * soon as the API is thread-safe, since readers may share the service lock. */
+#if UA_MULTITHREADING >= 100
     #ifdef _MSC_VER /* Visual Studio */
     #define UA_atomic_sync() _ReadWriteBarrier()
     #else /* GCC/Clang */
@@ -368,7 +369,7 @@ UA_STATIC_ASSERT(sizeof(bool) == 1, cannot_overlay_integers_with_large_bool);
 
 static UA_INLINE void *
 UA_atomic_xchg(void * volatile * addr, void *newptr) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedExchangePointer(addr, newptr);
 #else /* GCC/Clang */
@@ -383,7 +384,7 @@ UA_atomic_xchg(void * volatile * addr, void *newptr) {
 
 static UA_INLINE void *
 UA_atomic_cmpxchg(void * volatile * addr, void *expected, void *newptr) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedCompareExchangePointer(addr, expected, newptr);
 #else /* GCC/Clang */
@@ -398,9 +399,27 @@ UA_atomic_cmpxchg(void * volatile * addr, void *expected, void *newptr) {
 #endif
 }
 
+static UA_INLINE uint32_t
+UA_atomic_cmpxchgUInt32(volatile uint32_t *addr, uint32_t expected, uint32_t newval) {
+#if UA_MULTITHREADING >= 100
+#ifdef _MSC_VER /* Visual Studio */
+    return (uint32_t)_InterlockedCompareExchange((volatile long*)addr,
+                                                 (long)newval, (long)expected);
+#else /* GCC/Clang */
+    return __sync_val_compare_and_swap(addr, expected, newval);
+#endif
+#else
+    uint32_t old = *addr;
+    if(old == expected) {
+        *addr = newval;
+    }
+    return old;
+#endif
+}
+
 static UA_INLINE uint32_t
 UA_atomic_addUInt32(volatile uint32_t *addr, uint32_t increase) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedExchangeAdd(addr, increase) + increase;
 #else /* GCC/Clang */
@@ -414,7 +433,7 @@ UA_atomic_addUInt32(volatile uint32_t *addr, uint32_t increase) {
 
 static UA_INLINE size_t
 UA_atomic_addSize(volatile size_t *addr, size_t increase) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedExchangeAdd(addr, increase) + increase;
 #else /* GCC/Clang */
@@ -428,7 +447,7 @@ UA_atomic_addSize(volatile size_t *addr, size_t increase) {
 
 static UA_INLINE uint32_t
 UA_atomic_subUInt32(volatile uint32_t *addr, uint32_t decrease) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedExchangeSub(addr, decrease) - decrease;
 #else /* GCC/Clang */
@@ -442,7 +461,7 @@ UA_atomic_subUInt32(volatile uint32_t *addr, uint32_t decrease) {
 
 static UA_INLINE size_t
 UA_atomic_subSize(volatile size_t *addr, size_t decrease) {
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #ifdef _MSC_VER /* Visual Studio */
     return _InterlockedExchangeSub(addr, decrease) - decrease;
 #else /* GCC/Clang */
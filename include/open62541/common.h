@@ -191,6 +191,8 @@ typedef struct {
     size_t rejectedConnectionCount;
     size_t connectionTimeoutCount;
     size_t connectionAbortCount;
+    size_t bufferPoolHitCount;  /* Send/receive buffers reused from the pool */
+    size_t bufferPoolMissCount; /* Send/receive buffers newly allocated */
 } UA_NetworkStatistics;
 
 typedef struct {
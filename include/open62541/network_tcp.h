@@ -27,6 +27,18 @@ UA_ServerNetworkLayer UA_EXPORT
 UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
                          UA_UInt16 maxConnections, UA_Logger *logger);
 
+#ifdef UA_ENABLE_TCP_EPOLL
+/* Initializes a TCP network layer that uses edge-triggered epoll (Linux only)
+ * instead of select. The cost per iteration depends on the number of sockets
+ * with activity and not on the number of open connections. And the number of
+ * sockets is not limited by FD_SETSIZE.
+ *
+ * The parameters are the same as for UA_ServerNetworkLayerTCP. */
+UA_ServerNetworkLayer UA_EXPORT
+UA_ServerNetworkLayerTCPEpoll(UA_ConnectionConfig config, UA_UInt16 port,
+                              UA_UInt16 maxConnections, UA_Logger *logger);
+#endif
+
 UA_Connection UA_EXPORT
 UA_ClientConnectionTCP(UA_ConnectionConfig config, const UA_String endpointUrl,
                        UA_UInt32 timeout, UA_Logger *logger);
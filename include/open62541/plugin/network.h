@@ -176,6 +176,35 @@ struct UA_ServerNetworkLayer {
     UA_StatusCode (*listen)(UA_ServerNetworkLayer *nl, UA_Server *server,
                             UA_UInt16 timeout);
 
+    /* Interrupt the waiting in listen (optional). The current or the next call
+     * to listen returns without waiting for the timeout. Called from other
+     * threads when they hand over work to the server main loop. So this has
+     * to be thread-safe.
+     *
+     * @param nl The network layer */
+    void (*wakeup)(UA_ServerNetworkLayer *nl);
+
+    /* Watch an additional socket in listen (optional). The callback is called
+     * from listen when data can be read from the socket. So messages of other
+     * protocols, e.g. PubSub, are received without polling. Sockets can be
+     * watched before the network layer is started.
+     *
+     * @param nl The network layer
+     * @param sockfd The socket. Can be watched only once.
+     * @param callback Called from listen when the socket is readable
+     * @param context Forwarded to the callback
+     * @return Returns UA_STATUSCODE_GOOD or an error code. */
+    UA_StatusCode (*watchSocket)(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd,
+                                 void (*callback)(UA_Server *server, void *context),
+                                 void *context);
+
+    /* Stop watching a socket (optional). Has to be called before the socket is
+     * closed.
+     *
+     * @param nl The network layer
+     * @param sockfd The socket */
+    void (*unwatchSocket)(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd);
+
     /* Close the network socket and all open connections. Afterwards, the
      * network layer can be safely deleted.
      *
@@ -264,6 +264,7 @@ typedef struct UA_ReferenceTarget {
     ZIP_ENTRY(UA_ReferenceTarget) nameTreeFields;
     UA_UInt32 targetIdHash;   /* Hash of the target's NodeId */
     UA_UInt32 targetNameHash; /* Hash of the target's BrowseName */
+    UA_UInt32 sequence;       /* Insertion order within the ReferenceKind */
 
     /* Emulate the queue.h structure so we don't have to include it in the
      * public API */
@@ -287,6 +288,8 @@ ZIP_PROTOTYPE(UA_ReferenceTargetNameTree, UA_ReferenceTarget, UA_UInt32)
 typedef struct {
     UA_Byte referenceTypeIndex;
     UA_Boolean isInverse;
+    UA_UInt32 nextSequence; /* Sequence number of the next added target. The
+                             * queue is ordered by the sequence numbers. */
 
     /* Emulate the queue.h structure so we don't have to include it in the
      * public API */
@@ -438,6 +441,12 @@ typedef struct {
      * memory being cleaned up. Don't forget to also set `value->hasValue` to
      * true to indicate the presence of a value.
      *
+     * MonitoredItems with the same sampling interval share the samples of a
+     * node. The sampling then reads the value with the session of the server
+     * administrator. The access level of the MonitoredItem's session is
+     * checked by the server. See the section on :ref:`sampling` in the
+     * server documentation.
+     *
      * @param server The server executing the callback
      * @param sessionId The identifier of the session
      * @param sessionContext Additional data attached to the session in the
@@ -571,6 +580,11 @@ typedef struct {
     UA_Byte accessLevel;
     UA_Double minimumSamplingInterval;
     UA_Boolean historizing;
+
+    /* Members specific to open62541 */
+#if UA_MULTITHREADING >= 200
+    UA_Boolean threadSafe; /* The value callbacks can be called concurrently */
+#endif
 } UA_VariableNode;
 
 /**
@@ -865,7 +879,10 @@ typedef struct {
     void (*deleteNode)(void *nsCtx, UA_Node *node);
 
     /* ``Get`` returns a pointer to an immutable node. ``Release`` indicates
-     * that the pointer is no longer accessed afterwards. */
+     * that the pointer is no longer accessed afterwards. With
+     * UA_MULTITHREADING >= 100, ``Get`` and ``Release`` can be called
+     * concurrently from the read-only services. All other methods are called
+     * with exclusive access to the nodestore. */
     const UA_Node * (*getNode)(void *nsCtx, const UA_NodeId *nodeId);
 
     void (*releaseNode)(void *nsCtx, const UA_Node *node);
@@ -67,6 +67,14 @@ struct UA_PubSubChannel {
     UA_StatusCode (*receive)(UA_PubSubChannel * channel, UA_ByteString *,
                              UA_ExtensionObject *transportSettings, UA_UInt32 timeout);
 
+    /* Receive up to messagesSize pending messages at once (optional). Waits at
+     * most timeout (usec) for the first message, but not for the following
+     * ones. The length of the buffers is the available space. It is set to
+     * the received size of the first received messages. */
+    UA_StatusCode (*receiveBatch)(UA_PubSubChannel *channel, UA_ByteString *messages,
+                                  size_t messagesSize, size_t *received,
+                                  UA_ExtensionObject *transportSettings, UA_UInt32 timeout);
+
     /* Closing the connection and implicit free of the channel structures. */
     UA_StatusCode (*close)(UA_PubSubChannel *channel);
 
@@ -338,6 +338,11 @@ struct UA_SecurityPolicy {
     /* The policy uri that identifies the implemented algorithms */
     UA_ByteString policyUri;
 
+    /* The cryptographic operations can be called from several threads at the
+     * same time. Otherwise the policy has shared state (e.g. a random number
+     * generator) and the calls must be serialized. */
+    UA_Boolean threadSafe;
+
     /* The local certificate is specific for each SecurityPolicy since it
      * depends on the used key length. */
     UA_ByteString localCertificate;
@@ -159,6 +159,34 @@ struct UA_ServerConfig {
 
 #if UA_MULTITHREADING >= 200
     UA_UInt16 nThreads; /* Experimental feature */
+
+    /* Worker threads for the asymmetric cryptography of OpenSecureChannel and
+     * ActivateSession. With zero (default), the handshakes are processed
+     * synchronously. With a nonzero value, the operations of the
+     * SecurityPolicies are called concurrently. So the crypto workers are only
+     * started if all SecurityPolicies are thread-safe (see the threadSafe
+     * flag). This is the case for the OpenSSL SecurityPolicies. */
+    UA_UInt16 nCryptoThreads;
+
+    /* Split the operations of large Read, Browse and TranslateBrowsePaths
+     * requests into slices of this many operations. The slices are processed
+     * in parallel by the worker threads and the thread running the server
+     * main loop. The results keep their position in the response. With zero
+     * (default), the operations are processed sequentially. The value
+     * callbacks of VariableNodes (onRead, DataSource, external value) are not
+     * called concurrently from the slices, unless the node is marked with
+     * ``UA_Server_setVariableNodeThreadSafe``.
+     *
+     * The service lock is not held for the entire request. The calling thread
+     * releases it while it waits for the slices of the workers. And every
+     * operation releases it around the calls into userland (value callbacks,
+     * access control). So the callbacks can use the public API, also to write
+     * to the information model. But other requests are processed in these
+     * gaps. A sliced request sees the writes that were done in the meantime.
+     * And the operations of a Write or Call request are no longer atomic
+     * against other requests, which can read or modify the information model
+     * between two of its operations. */
+    size_t operationSliceSize;
 #endif
 
     /**
@@ -239,6 +267,14 @@ struct UA_ServerConfig {
     UA_DurationRange samplingIntervalLimits; /* in ms (must not be less than 5) */
     UA_UInt32Range queueSizeLimits; /* Negotiated with the client */
 
+    /* Sample the MonitoredItems on the value of a variable only when the value
+     * is written, instead of polling in the sampling interval. This applies to
+     * variables that store the value in the node (no DataSource, onRead
+     * callback or value backend). The mode is selected when the sampler is
+     * created and again when a DataSource, value callback or value backend
+     * is set for the node. */
+    UA_Boolean samplingOnWrite;
+
     /* Limits for PublishRequests */
     UA_UInt32 maxPublishReqPerSession;
 
@@ -313,6 +349,14 @@ UA_ServerConfig_setCustomHostname(UA_ServerConfig *config,
 UA_Server UA_EXPORT *
 UA_Server_newWithConfig(const UA_ServerConfig *config);
 
+/* Creates a new server with the nodes restored from a nodestore image instead
+ * of creating namespace zero. The config is moved into the server as for
+ * UA_Server_newWithConfig. Returns NULL if the image cannot be loaded. See the
+ * section on the :ref:`nodestore image<nodestore-image>`. */
+UA_Server UA_EXPORT *
+UA_Server_newWithNodestoreImage(const UA_ServerConfig *config,
+                                const UA_ByteString *image);
+
 void UA_EXPORT UA_Server_delete(UA_Server *server);
 
 UA_ServerConfig UA_EXPORT *
@@ -951,6 +995,16 @@ UA_Server_setVariableNode_valueBackend(UA_Server *server,
                                        const UA_NodeId nodeId,
                                        const UA_ValueBackend valueBackend);
 
+#if UA_MULTITHREADING >= 200
+/* Declare that the value callbacks of the VariableNode (onRead, DataSource,
+ * external value) can be called concurrently. Then they are not serialized
+ * when the operations of a request are processed in parallel (see the
+ * operationSliceSize in the server config). */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setVariableNodeThreadSafe(UA_Server *server, const UA_NodeId nodeId,
+                                    UA_Boolean threadSafe);
+#endif
+
 /**
  * .. _local-monitoreditems:
  *
@@ -960,7 +1014,33 @@ UA_Server_setVariableNode_valueBackend(UA_Server *server,
  * MonitoredItems are used with the Subscription mechanism of OPC UA to
  * transported notifications for data changes and events. MonitoredItems can
  * also be registered locally. Notifications are then forwarded to a
- * user-defined callback instead of a remote client. */
+ * user-defined callback instead of a remote client.
+ *
+ * .. _sampling:
+ *
+ * Sampling
+ * ^^^^^^^^
+ *
+ * DataChange MonitoredItems of the same node, attribute, IndexRange and
+ * sampling interval share a sampler. The value is read once per interval and
+ * handed to all MonitoredItems of the sampler. This applies to the
+ * MonitoredItems of different sessions (and to local MonitoredItems).
+ *
+ * The shared read is done with the session of the server administrator. So
+ * DataSources and onRead callbacks see the ``sessionId`` and
+ * ``sessionContext`` of the admin session and not of the client that created
+ * the MonitoredItem. Before the value is handed to a MonitoredItem, the server
+ * checks the AccessLevel and the UserAccessLevel of the node (via the access
+ * control plugin) for the session of the MonitoredItem. If the read is not
+ * allowed, the MonitoredItem receives the StatusCode instead of the value. The
+ * access control can thus restrict which sessions see a value, but a callback
+ * cannot return different values to different sessions for a shared sampler.
+ * Use the access control to deny the read for a session instead.
+ *
+ * The user-dependent attributes (UserWriteMask, UserAccessLevel and
+ * UserExecutable) are sampled separately for every session with the session
+ * of the MonitoredItem. The first sample when a MonitoredItem is created is
+ * always read with its own session. */
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 
@@ -1170,6 +1250,36 @@ UA_Server_addObjectNode(UA_Server *server, const UA_NodeId requestedNewNodeId,
                                nodeContext, outNewNodeId);
 }
 
+/* Instantiate an ObjectType many times below the same parent. The instances
+ * and their children are the same as with ``UA_Server_addObjectNode``. But the
+ * children are copied from the cached declarations of the type in one pass and
+ * the references to the parent, the type definitions and the methods are added
+ * with a single edit of these nodes. This is much faster for large numbers of
+ * instances.
+ *
+ * Either all instances are created or none. The ObjectType must not be
+ * abstract and every instance needs a BrowseName. The attributes are used for
+ * all instances. An empty DisplayName is set to the BrowseName of the instance.
+ *
+ * @param server The server object
+ * @param instancesSize The number of instances
+ * @param requestedNewNodeIds Array of requested NodeIds or ``NULL`` to assign
+ *        random numeric NodeIds in namespace zero
+ * @param browseNames Array of the BrowseNames of the instances
+ * @param nodeContexts Array of node contexts or ``NULL``
+ * @param outNewNodeIds Array of ``instancesSize`` NodeIds that receives the
+ *        NodeIds of the instances or ``NULL``
+ * @return Returns a status code */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_addObjectNodes(UA_Server *server, size_t instancesSize,
+                         const UA_NodeId *requestedNewNodeIds,
+                         const UA_NodeId parentNodeId,
+                         const UA_NodeId referenceTypeId,
+                         const UA_QualifiedName *browseNames,
+                         const UA_NodeId typeDefinition,
+                         const UA_ObjectAttributes attr,
+                         void **nodeContexts, UA_NodeId *outNewNodeIds);
+
 static UA_INLINE UA_THREADSAFE UA_StatusCode
 UA_Server_addObjectTypeNode(UA_Server *server, const UA_NodeId requestedNewNodeId,
                             const UA_NodeId parentNodeId,
@@ -1348,6 +1458,41 @@ UA_Server_deleteReference(UA_Server *server, const UA_NodeId sourceNodeId,
                           const UA_ExpandedNodeId targetNodeId,
                           UA_Boolean deleteBidirectional);
 
+/**
+ * .. _nodestore-image:
+ *
+ * Nodestore Image
+ * ---------------
+ * Creating namespace zero and the nodes of the application with AddNodes takes
+ * time at every start of the server. The nodes can instead be saved once as an
+ * image and restored with ``UA_Server_newWithNodestoreImage``. The image
+ * contains the namespace array and all nodes with their attributes and
+ * references in a compact binary encoding. The restored nodes are inserted
+ * into the nodestore directly. AddNodes is not replayed and the consistency
+ * checks of AddNodes are skipped.
+ *
+ * The members of the nodes that are pointers are not part of the image. These
+ * are the node contexts, DataSources, value callbacks, value backends, method
+ * callbacks and the lifecycles of the type nodes. Variables with a DataSource or
+ * an external value are restored with an empty value. The server sets the
+ * callbacks of namespace zero (and of the PubSub information model) again. All
+ * other callbacks have to be set by the application after the server was
+ * created. The constructors of the nodes are not called again. The
+ * ``threadSafe`` flag of VariableNodes describes the callbacks and is also not
+ * saved. Set it again with ``UA_Server_setVariableNodeThreadSafe`` together
+ * with the callbacks.
+ *
+ * Values of custom DataTypes can only be restored if the DataTypes are
+ * configured in the ``customDataTypes`` of the server config. The image is
+ * specific to the build of the library and should be recreated after an
+ * update. During loading, the image is only read sequentially and not
+ * retained. So a memory-mapped file can be passed without copying it first. */
+
+/* Encode all nodes of the server into an image. The image is allocated and has
+ * to be cleared by the caller. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_saveNodestoreImage(UA_Server *server, UA_ByteString *image);
+
 /**
  * .. _events:
  *
@@ -1405,6 +1550,36 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId, const UA_NodeId originId,
                        UA_ByteString *outEventId, const UA_Boolean deleteEventNode);
 
+/**
+ * Transient events are not represented as nodes. They are described by a list
+ * of fields instead. The SimpleAttributeOperands of the EventFilters are
+ * evaluated against the BrowsePaths of the fields. The standard fields
+ * `EventId`, `EventType`, `SourceNode` and `ReceiveTime` are generated
+ * automatically and take precedence over the fields with the same
+ * BrowsePath. Fields that are not provided are returned as empty variants.
+ * This avoids the creation and deletion of nodes for events that are triggered
+ * at a high rate. */
+
+typedef struct {
+    size_t browsePathSize; /* BrowsePath relative to the event */
+    UA_QualifiedName *browsePath;
+    UA_Variant value;
+} UA_EventField;
+
+/* Triggers a transient event on the origin node
+ *
+ * @param server The server object
+ * @param eventType The type of the event. Must be a subtype of BaseEventType.
+ * @param originId The node that emits the event
+ * @param fieldsSize The number of event fields
+ * @param fields The event fields. Not modified or consumed.
+ * @param outEventId The EventId of the new event. Can be NULL.
+ * @return The StatusCode of the UA_Server_triggerTransientEvent method */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_triggerTransientEvent(UA_Server *server, const UA_NodeId eventType,
+                                const UA_NodeId originId, size_t fieldsSize,
+                                const UA_EventField *fields, UA_ByteString *outEventId);
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
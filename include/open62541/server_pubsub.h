@@ -544,7 +544,14 @@ UA_Server_DataSetReader_getConfig(UA_Server *server, UA_NodeId dataSetReaderIden
  * and then the list of target Variables are created in the Subscriber AddressSpace.
  * TargetVariables are a list of variables that are to be added in the Subscriber AddressSpace.
  * It defines a list of Variable mappings between received DataSet fields and added Variables
- * in the Subscriber AddressSpace. */
+ * in the Subscriber AddressSpace.
+ *
+ * In a frozen ReaderGroup with the rtLevel UA_PUBSUB_RT_FIXED_SIZE, fields whose target
+ * variable has an external value backend (see UA_Server_setVariableNode_valueBackend)
+ * are decoded directly from the receive buffer into the external DataValue. This
+ * applies to scalars of fixed-size builtin types that match the FieldMetaData. No
+ * memory is allocated and the information model is not written for these fields. The
+ * userWrite callback of the external value backend is not called. */
 
 /* Return Status Code after creating TargetVariables in Subscriber AddressSpace */
 UA_StatusCode UA_EXPORT
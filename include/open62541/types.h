@@ -669,9 +669,26 @@ typedef struct UA_DataType UA_DataType;
 typedef enum {
     UA_VARIANT_DATA,          /* The data has the same lifecycle as the
                                  variant */
-    UA_VARIANT_DATA_NODELETE /* The data is "borrowed" by the variant and
+    UA_VARIANT_DATA_NODELETE, /* The data is "borrowed" by the variant and
                                  shall not be deleted at the end of the
                                  variant's lifecycle. */
+    UA_VARIANT_DATA_SHARED    /* The data is immutable and reference-counted.
+                                 Copying the variant takes a reference instead
+                                 of copying the data. The data is freed when
+                                 the last reference is cleared. The server
+                                 uses this for large array values of
+                                 VariableNodes. Shared data must not be
+                                 modified. UA_Variant_setRange writes into
+                                 a new shared copy.
+
+                                 The values that the server hands to user
+                                 callbacks (onRead, onWrite, local
+                                 MonitoredItems, historizing) can be shared.
+                                 They are read-only. A copy of them is shared
+                                 as well. Call UA_Variant_unshare before
+                                 modifying the copy. The values returned by
+                                 UA_Server_read and UA_Server_readValue are
+                                 never shared. */
 } UA_VariantStorageType;
 
 typedef struct {
@@ -802,6 +819,14 @@ UA_StatusCode UA_EXPORT
 UA_Variant_setRangeCopy(UA_Variant *v, const void *array,
                         size_t arraySize, const UA_NumericRange range);
 
+/* Replace shared data (UA_VARIANT_DATA_SHARED) with a private copy that can be
+ * modified. Does nothing if the variant is not shared.
+ *
+ * @param v The variant
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_unshare(UA_Variant *v);
+
 /**
  * .. _extensionobject:
  *
@@ -23,6 +23,12 @@ modification history
 #include <openssl/x509.h>
 #include <openssl/hmac.h>
 #include <openssl/aes.h>
+#include <openssl/asn1.h>
+#include <limits.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
 
 #include "securitypolicy_openssl_common.h"
 
@@ -90,6 +96,12 @@ UA_copyCertificate (UA_ByteString * dst,
     return UA_STATUSCODE_GOOD;                        
 }
 
+EVP_PKEY *
+UA_OpenSSL_LoadPrivateKey (const UA_ByteString * privateKey) {
+    const unsigned char * pkey = privateKey->data;
+    return d2i_PrivateKey (EVP_PKEY_RSA, NULL, &pkey, (long) privateKey->length);
+}
+
 static UA_StatusCode
 UA_OpenSSL_RSA_Public_Verify (const UA_ByteString * message,
                               const EVP_MD *        evpMd,
@@ -152,6 +164,30 @@ UA_OpenSSL_RSA_PKCS1_V15_SHA256_Verify (const UA_ByteString * msg,
                                          NID_sha256, signature);                                         
 }
 
+/* Get the length of the first DER-encoded certificate in the ByteString. The
+ * ByteString can contain a chain of certificates. Only the ASN.1 header of the
+ * first certificate is decoded to get its length. */
+
+static UA_StatusCode
+UA_OpenSSL_X509_GetFirstCertificateLength (const UA_ByteString * certificate,
+                                           size_t *              derLength) {
+    const unsigned char * p = certificate->data;
+    long contentLength = 0;
+    int tag = 0;
+    int xclass = 0;
+    if (certificate->length > LONG_MAX ||
+        ASN1_get_object (&p, &contentLength, &tag, &xclass,
+                         (long) certificate->length) & 0x80 ||
+        tag != V_ASN1_SEQUENCE) {
+        return UA_STATUSCODE_BADCERTIFICATEINVALID;
+    }
+    *derLength = (size_t) (p - certificate->data) + (size_t) contentLength;
+    if (*derLength > certificate->length) {
+        return UA_STATUSCODE_BADCERTIFICATEINVALID;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Get certificate thumbprint, and allocate the buffer.
  * 
  */
@@ -172,42 +208,58 @@ UA_Openssl_X509_GetCertificateThumbprint (const UA_ByteString * certficate,
             return UA_STATUSCODE_BADINTERNALERROR;
         }
     }
-    const unsigned char * pTemp = certficate->data;
-    X509 * x509Certificate = d2i_X509 (NULL, &pTemp, (long) certficate->length);
-    if (x509Certificate == NULL) {
+    /* The thumbprint is the SHA1 digest of the DER-encoded (first)
+     * certificate. No need to parse the certificate for that. */
+    size_t derLength = 0;
+    if (UA_OpenSSL_X509_GetFirstCertificateLength (certficate, &derLength) !=
+        UA_STATUSCODE_GOOD) {
         if (bThumbPrint) {
             UA_ByteString_deleteMembers (pThumbprint);
         }
         return UA_STATUSCODE_BADINTERNALERROR;
     }
-
-    if (X509_digest (x509Certificate, EVP_sha1(), pThumbprint->data, NULL) 
-        != 1) {
+    if (EVP_Digest (certficate->data, derLength, pThumbprint->data,
+                    NULL, EVP_sha1(), NULL) != 1) {
         if (bThumbPrint) {
             UA_ByteString_deleteMembers (pThumbprint);
         }
-    return UA_STATUSCODE_BADINTERNALERROR;
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
-    X509_free(x509Certificate);
 
     return UA_STATUSCODE_GOOD;                                              
 }
 
+/* Compare the first certificate of a chain with the first certificate of the
+ * stored remote certificate. Compares the DER bytes without decoding. */
+
+UA_StatusCode
+UA_OpenSSL_X509_compare (const UA_ByteString * cert,
+                         const UA_ByteString * remoteCert) {
+    size_t certLength = 0;
+    size_t remoteCertLength = 0;
+    if (UA_OpenSSL_X509_GetFirstCertificateLength (cert, &certLength) !=
+        UA_STATUSCODE_GOOD ||
+        UA_OpenSSL_X509_GetFirstCertificateLength (remoteCert,
+                                                   &remoteCertLength) !=
+        UA_STATUSCODE_GOOD) {
+        return UA_STATUSCODE_BADCERTIFICATEINVALID;
+    }
+    if (certLength != remoteCertLength ||
+        memcmp (cert->data, remoteCert->data, certLength) != 0) {
+        return UA_STATUSCODE_UNCERTAINSUBNORMAL;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 UA_Openssl_RSA_Private_Decrypt (UA_ByteString *       data, 
-                               const UA_ByteString * privateKey,
+                               EVP_PKEY *            evpKey,
                                UA_Int16              padding) {
-    if (data == NULL || privateKey == NULL) {
+    if (data == NULL || evpKey == NULL) {
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    const unsigned char * pkey = privateKey->data;
-    EVP_PKEY * evpKey = d2i_PrivateKey(EVP_PKEY_RSA, NULL, 
-                        &pkey, (long) privateKey->length);
-    if (evpKey == NULL) {
-        return UA_STATUSCODE_BADINVALIDARGUMENT;
-    }
-    
+
     UA_Int32 keySize = RSA_size(get_pkey_rsa(evpKey));  
     size_t cipherOffset = 0;
     size_t outOffset = 0;
@@ -222,7 +274,6 @@ UA_Openssl_RSA_Private_Decrypt (UA_ByteString *       data,
                            padding
                            );
         if (decryptedBytes < 0) {
-            EVP_PKEY_free(evpKey);
             return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
         }
         memcpy(data->data + outOffset, buf, (size_t) decryptedBytes);
@@ -230,13 +281,12 @@ UA_Openssl_RSA_Private_Decrypt (UA_ByteString *       data,
         outOffset += (size_t) decryptedBytes;
     }
     data->length = outOffset;
-    EVP_PKEY_free(evpKey);
     return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
 UA_Openssl_RSA_Oaep_Decrypt (UA_ByteString *       data, 
-                             const UA_ByteString * privateKey) {
+                             EVP_PKEY *            privateKey) {
     return  UA_Openssl_RSA_Private_Decrypt (data, privateKey, 
                                             RSA_PKCS1_OAEP_PADDING);
 }
@@ -450,32 +500,26 @@ UA_Openssl_RSA_Public_GetKeyLength (X509 *     publicKeyX509,
 }
 
 UA_StatusCode 
-UA_Openssl_RSA_Private_GetKeyLength (const UA_ByteString * privateKey,
-                                     UA_Int32 *            keyLen) {
-    const unsigned char * pkey = privateKey->data;
-    EVP_PKEY * evpKey = d2i_PrivateKey(EVP_PKEY_RSA, NULL, 
-                          &pkey, (long) privateKey->length);
-    if (evpKey == NULL) {
+UA_Openssl_RSA_Private_GetKeyLength (EVP_PKEY *   privateKey,
+                                     UA_Int32 *   keyLen) {
+    if (privateKey == NULL) {
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
-    *keyLen = RSA_size(get_pkey_rsa(evpKey));                                           
-    EVP_PKEY_free (evpKey);
+    *keyLen = RSA_size(get_pkey_rsa(privateKey));
 
     return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode 
 UA_Openssl_RSA_Private_Sign (const UA_ByteString * message,
-                     const UA_ByteString * privateKey,
+                     EVP_PKEY *            evpKey,
                      const EVP_MD *        evpMd,
                      UA_Int16              padding,                     
                      UA_ByteString *       outSignature) { 
     EVP_MD_CTX *     mdctx        = NULL;                                  
     int              opensslRet;
     EVP_PKEY_CTX *   evpKeyCtx;  
-    EVP_PKEY *       evpKey       = NULL;
     UA_StatusCode    ret;
-    const unsigned char * pkey = NULL;
 
     mdctx = EVP_MD_CTX_create ();
     if (mdctx == NULL) {
@@ -483,12 +527,6 @@ UA_Openssl_RSA_Private_Sign (const UA_ByteString * message,
         goto errout;
     }
 
-    pkey = privateKey->data;
-    evpKey = d2i_PrivateKey(EVP_PKEY_RSA, NULL, 
-                        &pkey, (long) privateKey->length);
-    if (evpKey == NULL) {
-        return UA_STATUSCODE_BADINVALIDARGUMENT;
-    }
     opensslRet = EVP_DigestSignInit (mdctx, &evpKeyCtx, evpMd, NULL, evpKey);
     if (opensslRet != 1) {
         ret = UA_STATUSCODE_BADINTERNALERROR;
@@ -509,9 +547,6 @@ UA_Openssl_RSA_Private_Sign (const UA_ByteString * message,
 
     ret = UA_STATUSCODE_GOOD;
 errout:
-    if (evpKey != NULL) {
-        EVP_PKEY_free (evpKey);
-    }
     if (mdctx != NULL) {
         EVP_MD_CTX_destroy (mdctx);
     }
@@ -520,213 +555,12 @@ errout:
 
 UA_StatusCode 
 UA_Openssl_RSA_PKCS1_V15_SHA256_Sign (const UA_ByteString * message,
-                                      const UA_ByteString * privateKey,
+                                      EVP_PKEY *            privateKey,
                                       UA_ByteString *       outSignature) {
     return UA_Openssl_RSA_Private_Sign (message, privateKey, EVP_sha256(), 
                 NID_sha256, outSignature); 
 }    
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
-                               const UA_ByteString *     key,
-                               const UA_ByteString *     signature
-                              ) {
-    unsigned char buf[SHA256_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA256_DIGEST_LENGTH, buf};
-
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, message->length, 
-              mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;     
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }                  
-}
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             UA_ByteString *           signature
-                             ) {
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, 
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-} 
-
-static UA_StatusCode
-UA_OpenSSL_Decrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/) {
-    UA_ByteString    ivCopy    = {0, NULL};
-    UA_ByteString    cipherTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx       = NULL;
-    UA_StatusCode    ret;  
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &cipherTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-    
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }                                
-   
-    /* call EVP_* to decrypt */
-    
-    opensslRet = EVP_DecryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* EVP_DecryptFinal() will return an error code if padding is enabled 
-     * and the final block is not correctly formatted.  
-     */
-    EVP_CIPHER_CTX_set_padding (ctx, 0); 
-    opensslRet = EVP_DecryptUpdate (ctx, data->data, &outLen, 
-                                    cipherTxt.data, (int) cipherTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }   
-    opensslRet = EVP_DecryptFinal_ex (ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
-
-errout:
-    UA_ByteString_deleteMembers (&ivCopy);
-    UA_ByteString_deleteMembers (&cipherTxt);  
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;   
-}
-
-static UA_StatusCode
-UA_OpenSSL_Encrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key, 
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/
-                    ) {
-
-    UA_ByteString    ivCopy   = {0, NULL};
-    UA_ByteString    plainTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx      = NULL;
-    UA_StatusCode    ret;  
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &plainTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-    
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
-
-    /* call EVP_* to encrypt */
-
-    opensslRet = EVP_EncryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen, 
-                                    plainTxt.data, (int) plainTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* 
-     * Buffer passed to EVP_EncryptFinal() must be after data just
-     * encrypted to avoid overwriting it.
-     */
-    opensslRet = EVP_EncryptFinal_ex(ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
-
-errout:
-    UA_ByteString_deleteMembers (&ivCopy);
-    UA_ByteString_deleteMembers (&plainTxt);  
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
-}
-
-UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key, 
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_256_cbc (), data);                                
-}
-
-UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt (const UA_ByteString * iv,
-                            const UA_ByteString * key, 
-                            UA_ByteString *       data  /* [in/out]*/
-                            ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_256_cbc (), data);
-}
-
-UA_StatusCode 
-UA_OpenSSL_X509_compare (const UA_ByteString * cert, 
-                         const X509 *          bcert) {
-
-    const unsigned char * pData = cert->data;    
-    X509 * acert = d2i_X509 (NULL, &pData, 
-                             (long) cert->length);
-    if (acert == NULL) {
-        return UA_STATUSCODE_BADCERTIFICATEINVALID;
-    }
-    int opensslRet = X509_cmp (acert, bcert);
-    X509_free (acert);
-
-    if (opensslRet == 0)
-        return UA_STATUSCODE_GOOD;
-    return UA_STATUSCODE_UNCERTAINSUBNORMAL;
-}
-
 UA_StatusCode
 UA_OpenSSL_RSA_PKCS1_V15_SHA1_Verify (const UA_ByteString * msg,
                                       X509 *                publicKeyX509,
@@ -737,7 +571,7 @@ UA_OpenSSL_RSA_PKCS1_V15_SHA1_Verify (const UA_ByteString * msg,
 
 UA_StatusCode 
 UA_Openssl_RSA_PKCS1_V15_SHA1_Sign (const UA_ByteString * message,
-                                    const UA_ByteString * privateKey,
+                                    EVP_PKEY *            privateKey,
                                     UA_ByteString *       outSignature) {
     return UA_Openssl_RSA_Private_Sign (message, privateKey, EVP_sha1(), 
                                         NID_sha1, outSignature); 
@@ -824,42 +658,9 @@ UA_Openssl_Random_Key_PSHA1_Derive (const UA_ByteString *     secret,
     return UA_STATUSCODE_GOOD;                                         
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             const UA_ByteString *     signature
-                             ) {
-    unsigned char buf[SHA1_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA1_DIGEST_LENGTH, buf};
-
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data, message->length, 
-              mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;     
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }                  
-}
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign (const UA_ByteString *     message,
-                           const UA_ByteString *     key,
-                           UA_ByteString *           signature
-                           ) {
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data, 
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-} 
-
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt (UA_ByteString *       data, 
-                                  const UA_ByteString * privateKey) {
+                                  EVP_PKEY *            privateKey) {
     return  UA_Openssl_RSA_Private_Decrypt (data, privateKey, 
                                             RSA_PKCS1_PADDING);                                      
 }
@@ -883,20 +684,199 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt (UA_ByteString * data,
     return ret; 
 }
 
+/* Symmetric cipher and HMAC contexts */
+
+#if OPENSSL_VERSION_NUMBER < 0x1010000fL
+static HMAC_CTX *
+HMAC_CTX_new (void) {
+    HMAC_CTX * ctx = (HMAC_CTX *) UA_malloc (sizeof (HMAC_CTX));
+    if (ctx != NULL) {
+        HMAC_CTX_init (ctx);
+    }
+    return ctx;
+}
+
+static void
+HMAC_CTX_free (HMAC_CTX * ctx) {
+    if (ctx != NULL) {
+        HMAC_CTX_cleanup (ctx);
+        UA_free (ctx);
+    }
+}
+#endif
+
+void
+UA_OpenSSL_SymmetricContext_init (UA_OpenSSL_SymmetricContext * ctx) {
+    ctx->cipherCtx = NULL;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    ctx->macCtx    = NULL;
+#else
+    ctx->hmacCtx   = NULL;
+#endif
+}
+
+void
+UA_OpenSSL_SymmetricContext_clear (UA_OpenSSL_SymmetricContext * ctx) {
+    if (ctx->cipherCtx != NULL) {
+        EVP_CIPHER_CTX_free (ctx->cipherCtx);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (ctx->macCtx != NULL) {
+        EVP_MAC_CTX_free (ctx->macCtx);
+    }
+#else
+    if (ctx->hmacCtx != NULL) {
+        HMAC_CTX_free (ctx->hmacCtx);
+    }
+#endif
+    UA_OpenSSL_SymmetricContext_init (ctx);
+}
+
+/* The key schedule is computed once. The IV is set for every message. */
+
 UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key, 
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_128_cbc (), data);                                
+UA_OpenSSL_SymmetricContext_setEncryptingKey (UA_OpenSSL_SymmetricContext * ctx,
+                                              const EVP_CIPHER *            cipherAlg,
+                                              const UA_ByteString *         key,
+                                              UA_Boolean                    encrypt) {
+    if ((size_t) EVP_CIPHER_key_length (cipherAlg) != key->length) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if (ctx->cipherCtx == NULL) {
+        ctx->cipherCtx = EVP_CIPHER_CTX_new ();
+        if (ctx->cipherCtx == NULL) {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+    if (EVP_CipherInit_ex (ctx->cipherCtx, cipherAlg, NULL, key->data, NULL,
+                           encrypt ? 1 : 0) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    /* The messages are padded to the block size by the SecureChannel */
+    EVP_CIPHER_CTX_set_padding (ctx->cipherCtx, 0);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setSigningKey (UA_OpenSSL_SymmetricContext * ctx,
+                                           const EVP_MD *                md,
+                                           const UA_ByteString *         key) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    /* Key a fresh context. It is only duplicated afterwards. */
+    EVP_MAC * mac = EVP_MAC_fetch (NULL, OSSL_MAC_NAME_HMAC, NULL);
+    if (mac == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    EVP_MAC_CTX * macCtx = EVP_MAC_CTX_new (mac);
+    EVP_MAC_free (mac);
+    if (macCtx == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string (OSSL_MAC_PARAM_DIGEST,
+                                                  (char *) (uintptr_t) EVP_MD_get0_name (md), 0);
+    params[1] = OSSL_PARAM_construct_end ();
+    if (EVP_MAC_init (macCtx, key->data, key->length, params) != 1) {
+        EVP_MAC_CTX_free (macCtx);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if (ctx->macCtx != NULL) {
+        EVP_MAC_CTX_free (ctx->macCtx);
+    }
+    ctx->macCtx = macCtx;
+#else
+    if (ctx->hmacCtx == NULL) {
+        ctx->hmacCtx = HMAC_CTX_new ();
+        if (ctx->hmacCtx == NULL) {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+    if (HMAC_Init_ex (ctx->hmacCtx, key->data, (int) key->length, md, NULL) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encrypts or decrypts (depending on the key setup) in place */
+
+UA_StatusCode
+UA_OpenSSL_Sym_Cipher (UA_OpenSSL_SymmetricContext * ctx,
+                       const UA_ByteString *         iv,
+                       UA_ByteString *               data  /* [in/out]*/) {
+    if (ctx->cipherCtx == NULL ||
+        (size_t) EVP_CIPHER_CTX_iv_length (ctx->cipherCtx) != iv->length) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Keep the cipher and key. Only reset the IV. */
+    if (EVP_CipherInit_ex (ctx->cipherCtx, NULL, NULL, NULL, iv->data, -1) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    int outLen;
+    int tmpLen;
+    if (EVP_CipherUpdate (ctx->cipherCtx, data->data, &outLen, data->data,
+                          (int) data->length) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    /* Fails if the length is not a multiple of the block size */
+    if (EVP_CipherFinal_ex (ctx->cipherCtx, data->data + outLen, &tmpLen) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    data->length = (size_t) (outLen + tmpLen);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key, 
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
+UA_OpenSSL_HMAC_Sign (UA_OpenSSL_SymmetricContext * ctx,
+                      const UA_ByteString *         message,
+                      UA_ByteString *               signature) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (ctx->macCtx == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Reuse the key from the last initialization */
+    size_t macLen = 0;
+    if (EVP_MAC_init (ctx->macCtx, NULL, 0, NULL) != 1 ||
+        EVP_MAC_update (ctx->macCtx, message->data, message->length) != 1 ||
+        EVP_MAC_final (ctx->macCtx, signature->data, &macLen,
+                       signature->length) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    signature->length = macLen;
+#else
+    if (ctx->hmacCtx == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Reuse the key from the last initialization */
+    unsigned int macLen = 0;
+    if (HMAC_Init_ex (ctx->hmacCtx, NULL, 0, NULL, NULL) != 1 ||
+        HMAC_Update (ctx->hmacCtx, message->data, message->length) != 1 ||
+        HMAC_Final (ctx->hmacCtx, signature->data, &macLen) != 1) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    signature->length = macLen;
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_OpenSSL_HMAC_Verify (UA_OpenSSL_SymmetricContext * ctx,
+                        const UA_ByteString *         message,
+                        const UA_ByteString *         signature) {
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    UA_ByteString mac = {EVP_MAX_MD_SIZE, buf};
+    UA_StatusCode ret = UA_OpenSSL_HMAC_Sign (ctx, message, &mac);
+    if (ret != UA_STATUSCODE_GOOD) {
+        return ret;
+    }
+    if (signature->length != mac.length ||
+        CRYPTO_memcmp (signature->data, mac.data, mac.length) != 0) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return UA_STATUSCODE_GOOD;
 }
 
 #endif
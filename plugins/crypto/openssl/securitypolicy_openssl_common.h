@@ -14,6 +14,8 @@
 #ifdef UA_ENABLE_ENCRYPTION_OPENSSL
 
 #include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
 
 _UA_BEGIN_DECLS
 
@@ -23,6 +25,10 @@ void UA_Openssl_Init(void);
 UA_StatusCode
 UA_copyCertificate(UA_ByteString *dst, const UA_ByteString *src);
 
+/* Parse the DER-encoded private key. Returns NULL if that fails. */
+EVP_PKEY *
+UA_OpenSSL_LoadPrivateKey(const UA_ByteString *privateKey);
+
 UA_StatusCode
 UA_OpenSSL_RSA_PKCS1_V15_SHA256_Verify(const UA_ByteString *msg,
                                        X509 *publicKeyX509,
@@ -32,8 +38,11 @@ UA_Openssl_X509_GetCertificateThumbprint(const UA_ByteString *certficate,
                                          UA_ByteString *pThumbprint,
                                          bool bThumbPrint);
 UA_StatusCode
+UA_OpenSSL_X509_compare(const UA_ByteString *cert,
+                        const UA_ByteString *remoteCert);
+UA_StatusCode
 UA_Openssl_RSA_Oaep_Decrypt(UA_ByteString *data,
-                            const UA_ByteString *privateKey);   
+                            EVP_PKEY *privateKey);   
 UA_StatusCode
 UA_Openssl_RSA_OAEP_Encrypt(UA_ByteString *data, /* The data that is encrypted. 
                                                     The encrypted data will overwrite 
@@ -50,35 +59,12 @@ UA_Openssl_RSA_Public_GetKeyLength(X509 *publicKeyX509, UA_Int32 *keyLen);
 
 UA_StatusCode 
 UA_Openssl_RSA_PKCS1_V15_SHA256_Sign(const UA_ByteString *data,
-                                     const UA_ByteString *privateKey,
+                                     EVP_PKEY *privateKey,
                                      UA_ByteString *outSignature);
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify(const UA_ByteString *message,
-                              const UA_ByteString *key,
-                              const UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key, 
-                               UA_ByteString *data  /* [in/out]*/);
-
-UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key, 
-                               UA_ByteString *data  /* [in/out]*/);
-
 UA_StatusCode 
-UA_OpenSSL_X509_compare(const UA_ByteString *cert, const X509 *b);
-
-UA_StatusCode 
-UA_Openssl_RSA_Private_GetKeyLength(const UA_ByteString *privateKey,
-                                    UA_Int32 *keyLen) ;
+UA_Openssl_RSA_Private_GetKeyLength(EVP_PKEY *privateKey,
+                                    UA_Int32 *keyLen);
 
 UA_StatusCode
 UA_OpenSSL_RSA_PKCS1_V15_SHA1_Verify(const UA_ByteString *msg,
@@ -87,40 +73,63 @@ UA_OpenSSL_RSA_PKCS1_V15_SHA1_Verify(const UA_ByteString *msg,
 
 UA_StatusCode 
 UA_Openssl_RSA_PKCS1_V15_SHA1_Sign(const UA_ByteString *message,
-                                   const UA_ByteString *privateKey,
+                                   EVP_PKEY *privateKey,
                                    UA_ByteString *outSignature);
 UA_StatusCode 
 UA_Openssl_Random_Key_PSHA1_Derive(const UA_ByteString *secret,
                                    const UA_ByteString *seed, 
                                    UA_ByteString *out);
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            const UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign(const UA_ByteString *message,
-                          const UA_ByteString *key,
-                          UA_ByteString *signature);
-
-UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt(UA_ByteString *data, 
-                                 const UA_ByteString *privateKey);
+                                 EVP_PKEY *privateKey);
 
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Encrypt(UA_ByteString *data, 
                                  size_t paddingSize,
                                  X509 *publicX509);
 
+/* Symmetric cipher and HMAC contexts for one direction of a SecureChannel. They
+ * are keyed when the symmetric keys are set and reused for every chunk. */
+typedef struct {
+    EVP_CIPHER_CTX *cipherCtx;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    EVP_MAC_CTX *macCtx;
+#else
+    HMAC_CTX *hmacCtx;
+#endif
+} UA_OpenSSL_SymmetricContext;
+
+void
+UA_OpenSSL_SymmetricContext_init(UA_OpenSSL_SymmetricContext *ctx);
+
+void
+UA_OpenSSL_SymmetricContext_clear(UA_OpenSSL_SymmetricContext *ctx);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setEncryptingKey(UA_OpenSSL_SymmetricContext *ctx,
+                                             const EVP_CIPHER *cipherAlg,
+                                             const UA_ByteString *key,
+                                             UA_Boolean encrypt);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setSigningKey(UA_OpenSSL_SymmetricContext *ctx,
+                                          const EVP_MD *md,
+                                          const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_Sym_Cipher(UA_OpenSSL_SymmetricContext *ctx,
+                      const UA_ByteString *iv,
+                      UA_ByteString *data  /* [in/out]*/);
+
 UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key, 
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_HMAC_Sign(UA_OpenSSL_SymmetricContext *ctx,
+                     const UA_ByteString *message,
+                     UA_ByteString *signature);
 
 UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key, 
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_HMAC_Verify(UA_OpenSSL_SymmetricContext *ctx,
+                       const UA_ByteString *message,
+                       const UA_ByteString *signature);
 
 _UA_END_DECLS
 
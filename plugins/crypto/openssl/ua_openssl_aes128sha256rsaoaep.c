@@ -29,7 +29,7 @@
 #define UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MAXASYMKEYLENGTH 512
 
 typedef struct {
-    UA_ByteString localPrivateKey;
+    EVP_PKEY *localPrivateKey; /* parsed once */
     UA_ByteString localCertThumbprint;
     const UA_Logger *logger;
 } Policy_Context_Aes128Sha256RsaOaep;
@@ -41,6 +41,8 @@ typedef struct {
     UA_ByteString remoteSymSigningKey;
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
+    UA_OpenSSL_SymmetricContext localSymContext;
+    UA_OpenSSL_SymmetricContext remoteSymContext;
 
     Policy_Context_Aes128Sha256RsaOaep *policyContext;
     UA_ByteString remoteCertificate;
@@ -60,19 +62,18 @@ UA_Policy_Aes128Sha256RsaOaep_New_Context(UA_SecurityPolicy *securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* copy the local private key and add a NULL to the end */
+    /* parse the local private key once */
 
-    UA_StatusCode retval =
-        UA_copyCertificate(&context->localPrivateKey, &localPrivateKey);
-    if(retval != UA_STATUSCODE_GOOD) {
+    context->localPrivateKey = UA_OpenSSL_LoadPrivateKey(&localPrivateKey);
+    if(context->localPrivateKey == NULL) {
         UA_free(context);
-        return retval;
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    retval = UA_Openssl_X509_GetCertificateThumbprint(
+    UA_StatusCode retval = UA_Openssl_X509_GetCertificateThumbprint(
         &securityPolicy->localCertificate, &context->localCertThumbprint, true);
     if(retval != UA_STATUSCODE_GOOD) {
-        UA_ByteString_deleteMembers(&context->localPrivateKey);
+        EVP_PKEY_free(context->localPrivateKey);
         UA_free(context);
         return retval;
     }
@@ -96,7 +97,7 @@ UA_Policy_Aes128Sha256RsaOaep_Clear_Context(UA_SecurityPolicy *policy) {
 
     Policy_Context_Aes128Sha256RsaOaep *pc =
         (Policy_Context_Aes128Sha256RsaOaep *)policy->policyContext;
-    UA_ByteString_deleteMembers(&pc->localPrivateKey);
+    EVP_PKEY_free(pc->localPrivateKey);
     UA_ByteString_deleteMembers(&pc->localCertThumbprint);
     UA_free(pc);
     return;
@@ -124,6 +125,8 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->localSymContext);
+    UA_OpenSSL_SymmetricContext_init(&context->remoteSymContext);
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -139,6 +142,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
     if(context->remoteCertificateX509 == NULL) {
         UA_ByteString_clear(&context->remoteCertificate);
         UA_free(context);
+        return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
     }
 
     context->policyContext =
@@ -168,6 +172,8 @@ UA_ChannelModule_Aes128Sha256RsaOaep_Delete_Context(void *channelContext) {
         UA_ByteString_deleteMembers(&cc->remoteSymSigningKey);
         UA_ByteString_deleteMembers(&cc->remoteSymEncryptingKey);
         UA_ByteString_deleteMembers(&cc->remoteSymIv);
+        UA_OpenSSL_SymmetricContext_clear(&cc->localSymContext);
+        UA_OpenSSL_SymmetricContext_clear(&cc->remoteSymContext);
 
         UA_LOG_INFO(
             cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
@@ -232,7 +238,7 @@ UA_Asym_Aes128Sha256RsaOaep_Decrypt(const UA_SecurityPolicy *securityPolicy,
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_StatusCode ret =
-        UA_Openssl_RSA_Oaep_Decrypt(data, &cc->policyContext->localPrivateKey);
+        UA_Openssl_RSA_Oaep_Decrypt(data, cc->policyContext->localPrivateKey);
     return ret;
 }
 
@@ -246,7 +252,8 @@ UA_Asym_Aes128Sha256RsaOaep_getRemoteSignatureSize(const UA_SecurityPolicy *secu
         (const Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_Int32 keyLen;
     UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
-    UA_assert(keyLen == 256); /* 256 bytes 2048 bit */
+    UA_assert(keyLen >= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MINASYMKEYLENGTH &&
+              keyLen <= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MAXASYMKEYLENGTH);
     return (size_t)keyLen;
 }
 
@@ -259,8 +266,9 @@ UA_AsySig_Aes128Sha256RsaOaep_getLocalSignatureSize(const UA_SecurityPolicy *sec
     Policy_Context_Aes128Sha256RsaOaep *pc =
         (Policy_Context_Aes128Sha256RsaOaep *)securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength(&pc->localPrivateKey, &keyLen);
-    UA_assert(keyLen == 256); /* 256 bytes 2048 bits */
+    UA_Openssl_RSA_Private_GetKeyLength(pc->localPrivateKey, &keyLen);
+    UA_assert(keyLen >= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MINASYMKEYLENGTH &&
+              keyLen <= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MAXASYMKEYLENGTH);
 
     return (size_t)keyLen;
 }
@@ -349,7 +357,10 @@ UA_ChannelModule_Aes128Sha256RsaOaep_setLocalSymSigningKey(void *channelContext,
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_ByteString_deleteMembers(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey(&cc->localSymContext, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -360,7 +371,11 @@ UA_ChannelM_Aes128Sha256RsaOaep_setLocalSymEncryptingKey(void *channelContext,
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_ByteString_deleteMembers(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey(&cc->localSymContext,
+                                                        EVP_aes_128_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -402,7 +417,10 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymSigningKey(void *channelContext,
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey(&cc->remoteSymContext, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -413,7 +431,11 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymEncryptingKey(void *channelContext,
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey(&cc->remoteSymContext,
+                                                        EVP_aes_128_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -436,7 +458,7 @@ UA_AsySig_Aes128Sha256RsaOaep_sign(const UA_SecurityPolicy *securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR;
     Policy_Context_Aes128Sha256RsaOaep *pc =
         (Policy_Context_Aes128Sha256RsaOaep *)securityPolicy->policyContext;
-    return UA_Openssl_RSA_PKCS1_V15_SHA256_Sign(message, &pc->localPrivateKey, signature);
+    return UA_Openssl_RSA_PKCS1_V15_SHA256_Sign(message, pc->localPrivateKey, signature);
 }
 
 static UA_StatusCode
@@ -467,7 +489,7 @@ UA_SymSig_Aes128Sha256RsaOaep_verify(const UA_SecurityPolicy *securityPolicy,
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_Verify(&cc->remoteSymContext, message, signature);
 }
 
 static UA_StatusCode
@@ -480,7 +502,7 @@ UA_SymSig_Aes128Sha256RsaOaep_sign(const UA_SecurityPolicy *securityPolicy,
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_Sign(&cc->localSymContext, message, signature);
 }
 
 static size_t
@@ -496,8 +518,7 @@ UA_SymEn_Aes128Sha256RsaOaep_decrypt(const UA_SecurityPolicy *securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Sym_Cipher(&cc->remoteSymContext, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -508,8 +529,7 @@ UA_SymEn_Aes128Sha256RsaOaep_encrypt(const UA_SecurityPolicy *securityPolicy,
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Sym_Cipher(&cc->localSymContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -520,7 +540,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_compareCertificate(const void *channelContext,
 
     const Channel_Context_Aes128Sha256RsaOaep *cc =
         (const Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_X509_compare(certificate, cc->remoteCertificateX509);
+    return UA_OpenSSL_X509_compare(certificate, &cc->remoteCertificate);
 }
 
 static size_t
@@ -538,8 +558,9 @@ UA_AsymEn_Aes128Sha256RsaOaep_getLocalKeyLength(const UA_SecurityPolicy *securit
     Policy_Context_Aes128Sha256RsaOaep *pc =
         (Policy_Context_Aes128Sha256RsaOaep *)securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength(&pc->localPrivateKey, &keyLen);
-    UA_assert(keyLen == 256); /* 256 bytes 2048 bits */
+    UA_Openssl_RSA_Private_GetKeyLength(pc->localPrivateKey, &keyLen);
+    UA_assert(keyLen >= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MINASYMKEYLENGTH &&
+              keyLen <= UA_SECURITYPOLICY_AES128SHA256RSAOAEP_MAXASYMKEYLENGTH);
 
     return (size_t)keyLen * 8;
 }
@@ -563,6 +584,7 @@ UA_SecurityPolicy_Aes128Sha256RsaOaep(UA_SecurityPolicy *policy,
     UA_Openssl_Init();
     memset(policy, 0, sizeof(UA_SecurityPolicy));
     policy->logger = logger;
+    policy->threadSafe = true;
     policy->policyUri =
         UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Aes128_Sha256_RsaOaep\0");
 
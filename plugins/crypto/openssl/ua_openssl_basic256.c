@@ -23,7 +23,7 @@
 #define UA_SHA1_LENGTH                                               20
 
 typedef struct {
-    UA_ByteString             localPrivateKey;
+    EVP_PKEY *                localPrivateKey; /* parsed once */
     UA_ByteString             localCertThumbprint;
     const UA_Logger *         logger;
 } Policy_Context_Basic256;
@@ -35,6 +35,8 @@ typedef struct {
     UA_ByteString             remoteSymSigningKey;
     UA_ByteString             remoteSymEncryptingKey;
     UA_ByteString             remoteSymIv;
+    UA_OpenSSL_SymmetricContext localSymContext;
+    UA_OpenSSL_SymmetricContext remoteSymContext;
 
     Policy_Context_Basic256 * policyContext;
     UA_ByteString             remoteCertificate;
@@ -51,21 +53,20 @@ UA_Policy_Basic256_New_Context (UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* copy the local private key and add a NULL to the end */
-    
-    UA_StatusCode retval = UA_copyCertificate (&context->localPrivateKey,
-                                               &localPrivateKey);
-    if (retval != UA_STATUSCODE_GOOD) {
+    /* parse the local private key once */
+
+    context->localPrivateKey = UA_OpenSSL_LoadPrivateKey (&localPrivateKey);
+    if (context->localPrivateKey == NULL) {
         UA_free (context);
-        return retval; 
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    retval = UA_Openssl_X509_GetCertificateThumbprint (
+    UA_StatusCode retval = UA_Openssl_X509_GetCertificateThumbprint (
                          &securityPolicy->localCertificate,
                          &context->localCertThumbprint, true
                          );
     if (retval != UA_STATUSCODE_GOOD) {
-        UA_ByteString_deleteMembers (&context->localPrivateKey);
+        EVP_PKEY_free (context->localPrivateKey);
         UA_free (context);
         return retval; 
     }
@@ -90,7 +91,7 @@ UA_Policy_Basic256_Clear_Context (UA_SecurityPolicy *policy) {
 
     /* delete all allocated members in the context */
 
-    UA_ByteString_deleteMembers (&ctx->localPrivateKey);
+    EVP_PKEY_free (ctx->localPrivateKey);
     UA_ByteString_deleteMembers (&ctx->localCertThumbprint);
     UA_free (ctx);   
 
@@ -119,6 +120,8 @@ UA_ChannelModule_Basic256_New_Context (const UA_SecurityPolicy * securityPolicy,
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->localSymContext);
+    UA_OpenSSL_SymmetricContext_init(&context->remoteSymContext);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate, 
                                                remoteCertificate);
@@ -164,6 +167,8 @@ UA_ChannelModule_Basic256_Delete_Context (void * channelContext) {
         UA_ByteString_deleteMembers (&cc->remoteSymSigningKey);
         UA_ByteString_deleteMembers (&cc->remoteSymEncryptingKey);
         UA_ByteString_deleteMembers (&cc->remoteSymIv);
+        UA_OpenSSL_SymmetricContext_clear (&cc->localSymContext);
+        UA_OpenSSL_SymmetricContext_clear (&cc->remoteSymContext);
         UA_LOG_INFO (cc->policyContext->logger, 
                  UA_LOGCATEGORY_SECURITYPOLICY, 
                  "The basic256 security policy channel with openssl is deleted.");   
@@ -209,7 +214,10 @@ UA_ChannelModule_Basic256_setLocalSymSigningKey (void *                channelCo
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey (&cc->localSymContext, EVP_sha1 (), key);
 }
 
 static UA_StatusCode
@@ -221,7 +229,11 @@ UA_ChannelModule_Basic256_setLocalSymEncryptingKey (void *                channe
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey (&cc->localSymContext,
+                                                         EVP_aes_256_cbc (), key, true);
 }
 
 static UA_StatusCode
@@ -245,7 +257,10 @@ UA_ChannelModule_Basic256_setRemoteSymSigningKey (void *                channelC
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey (&cc->remoteSymContext, EVP_sha1 (), key);
 }
 
 static UA_StatusCode
@@ -257,7 +272,11 @@ UA_ChannelModule_Basic256_setRemoteSymEncryptingKey (void *                chann
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey (&cc->remoteSymContext,
+                                                         EVP_aes_256_cbc (), key, false);
 }
 
 static UA_StatusCode
@@ -281,7 +300,7 @@ UA_ChannelModule_Basic256_compareCertificate (const void *          channelConte
 
     const Channel_Context_Basic256 * cc = 
                      (const Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_X509_compare (certificate, cc->remoteCertificateX509);
+    return UA_OpenSSL_X509_compare (certificate, &cc->remoteCertificate);
 }
 
 static size_t
@@ -307,7 +326,7 @@ UA_AsySig_Basic256_getLocalSignatureSize (const UA_SecurityPolicy * securityPoli
     Policy_Context_Basic256 * pc = 
                (Policy_Context_Basic256 *) securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength (&pc->localPrivateKey, &keyLen);
+    UA_Openssl_RSA_Private_GetKeyLength (pc->localPrivateKey, &keyLen);
 
     return (size_t) keyLen; 
 }
@@ -341,7 +360,7 @@ UA_AsySig_Basic256_Sign (const UA_SecurityPolicy * securityPolicy,
 
     Policy_Context_Basic256 * pc = 
                (Policy_Context_Basic256 *) securityPolicy->policyContext;
-    return UA_Openssl_RSA_PKCS1_V15_SHA1_Sign (message, &pc->localPrivateKey,
+    return UA_Openssl_RSA_PKCS1_V15_SHA1_Sign (message, pc->localPrivateKey,
                                                signature);
 }
 
@@ -392,7 +411,7 @@ UA_AsymEn_Basic256_getLocalKeyLength (const UA_SecurityPolicy * securityPolicy,
     Policy_Context_Basic256 * pc = 
                (Policy_Context_Basic256 *) securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength (&pc->localPrivateKey, &keyLen);
+    UA_Openssl_RSA_Private_GetKeyLength (pc->localPrivateKey, &keyLen);
 
     return (size_t) keyLen * 8; 
 }
@@ -407,7 +426,7 @@ UA_AsymEn_Basic256_Decrypt (const UA_SecurityPolicy * securityPolicy,
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     UA_StatusCode ret = UA_Openssl_RSA_Oaep_Decrypt (data, 
-                        &cc->policyContext->localPrivateKey);
+                        cc->policyContext->localPrivateKey);
     return ret;                        
 }
 
@@ -477,7 +496,7 @@ UA_SymEn_Basic256_Encrypt (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_Sym_Cipher (&cc->localSymContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -487,7 +506,7 @@ UA_SymEn_Basic256_Decrypt (const UA_SecurityPolicy * securityPolicy,
     if(securityPolicy == NULL || channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;    
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_Sym_Cipher (&cc->remoteSymContext, &cc->remoteSymIv, data);
 }
 
 static size_t 
@@ -512,9 +531,7 @@ UA_SymSig_Basic256_Verify (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message, 
-                                        &cc->remoteSymSigningKey, 
-                                        signature);   
+    return UA_OpenSSL_HMAC_Verify (&cc->remoteSymContext, message, signature);
 }
 
 static UA_StatusCode 
@@ -527,7 +544,7 @@ UA_SymSig_Basic256_Sign (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_Sign (&cc->localSymContext, message, signature);
 }
 
 /* the main entry of Basic256 */
@@ -548,6 +565,7 @@ UA_SecurityPolicy_Basic256 (UA_SecurityPolicy * policy,
     UA_Openssl_Init ();
     memset(policy, 0, sizeof(UA_SecurityPolicy));
     policy->logger = logger;
+    policy->threadSafe = true;
     policy->policyUri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic256\0");
 
     /* set ChannelModule context  */
@@ -29,7 +29,7 @@
 #define UA_SECURITYPOLICY_BASIC256SHA256_MAXASYMKEYLENGTH 512
 
 typedef struct {
-    UA_ByteString             localPrivateKey;
+    EVP_PKEY *                localPrivateKey; /* parsed once */
     UA_ByteString             localCertThumbprint;
     const UA_Logger *         logger;    
 } Policy_Context_Basic256Sha256;
@@ -41,6 +41,8 @@ typedef struct {
     UA_ByteString remoteSymSigningKey;
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
+    UA_OpenSSL_SymmetricContext localSymContext;
+    UA_OpenSSL_SymmetricContext remoteSymContext;
 
     Policy_Context_Basic256Sha256 * policyContext;
     UA_ByteString                   remoteCertificate;
@@ -59,21 +61,20 @@ UA_Policy_New_Context (UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* copy the local private key and add a NULL to the end */
-    
-    UA_StatusCode retval = UA_copyCertificate (&context->localPrivateKey,
-                                               &localPrivateKey);
-    if (retval != UA_STATUSCODE_GOOD) {
+    /* parse the local private key once */
+
+    context->localPrivateKey = UA_OpenSSL_LoadPrivateKey (&localPrivateKey);
+    if (context->localPrivateKey == NULL) {
         UA_free (context);
-        return retval; 
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    retval = UA_Openssl_X509_GetCertificateThumbprint (
+    UA_StatusCode retval = UA_Openssl_X509_GetCertificateThumbprint (
                          &securityPolicy->localCertificate,
                          &context->localCertThumbprint, true
                          );
     if (retval != UA_STATUSCODE_GOOD) {
-        UA_ByteString_deleteMembers (&context->localPrivateKey);
+        EVP_PKEY_free (context->localPrivateKey);
         UA_free (context);
         return retval; 
     }
@@ -97,7 +98,7 @@ UA_Policy_Clear_Context (UA_SecurityPolicy *policy) {
 
     Policy_Context_Basic256Sha256 * pc = (Policy_Context_Basic256Sha256 *)
         policy->policyContext;
-    UA_ByteString_deleteMembers (&pc->localPrivateKey);
+    EVP_PKEY_free (pc->localPrivateKey);
     UA_ByteString_deleteMembers (&pc->localCertThumbprint);
     UA_free (pc);        
     return;
@@ -125,6 +126,8 @@ UA_ChannelModule_New_Context (const UA_SecurityPolicy * securityPolicy,
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->localSymContext);
+    UA_OpenSSL_SymmetricContext_init(&context->remoteSymContext);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate, 
                                                remoteCertificate);
@@ -140,6 +143,7 @@ UA_ChannelModule_New_Context (const UA_SecurityPolicy * securityPolicy,
     if (context->remoteCertificateX509 == NULL) {
         UA_ByteString_clear (&context->remoteCertificate); 
         UA_free (context);
+        return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
     }
 
     context->policyContext = (Policy_Context_Basic256Sha256 *) 
@@ -169,6 +173,8 @@ UA_ChannelModule_Delete_Context (void * channelContext) {
         UA_ByteString_deleteMembers (&cc->remoteSymSigningKey);
         UA_ByteString_deleteMembers (&cc->remoteSymEncryptingKey);
         UA_ByteString_deleteMembers (&cc->remoteSymIv);
+        UA_OpenSSL_SymmetricContext_clear (&cc->localSymContext);
+        UA_OpenSSL_SymmetricContext_clear (&cc->remoteSymContext);
 
         UA_LOG_INFO (cc->policyContext->logger, 
                  UA_LOGCATEGORY_SECURITYPOLICY, 
@@ -236,7 +242,7 @@ UA_Asym_Basic256Sha256_Decrypt (const UA_SecurityPolicy *securityPolicy,
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *)
                                            channelContext;
     UA_StatusCode ret = UA_Openssl_RSA_Oaep_Decrypt (data, 
-                        &cc->policyContext->localPrivateKey);
+                        cc->policyContext->localPrivateKey);
     return ret;                        
 }
 
@@ -250,7 +256,8 @@ UA_Asym_Basic256Sha256_getRemoteSignatureSize (
     const Channel_Context_Basic256Sha256 * cc = (const Channel_Context_Basic256Sha256 *) channelContext;
     UA_Int32 keyLen;
     UA_Openssl_RSA_Public_GetKeyLength (cc->remoteCertificateX509, &keyLen);
-    UA_assert (keyLen == 256); /* 256 bytes 2048 bit */
+    UA_assert (keyLen >= UA_SECURITYPOLICY_BASIC256SHA256_MINASYMKEYLENGTH &&
+               keyLen <= UA_SECURITYPOLICY_BASIC256SHA256_MAXASYMKEYLENGTH);
     return (size_t) keyLen; 
 }
 
@@ -263,8 +270,9 @@ UA_AsySig_Basic256Sha256_getLocalSignatureSize (const UA_SecurityPolicy *securit
     Policy_Context_Basic256Sha256 * pc = 
                (Policy_Context_Basic256Sha256 *) securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength (&pc->localPrivateKey, &keyLen);
-    UA_assert (keyLen == 256); /* 256 bytes 2048 bits */
+    UA_Openssl_RSA_Private_GetKeyLength (pc->localPrivateKey, &keyLen);
+    UA_assert (keyLen >= UA_SECURITYPOLICY_BASIC256SHA256_MINASYMKEYLENGTH &&
+               keyLen <= UA_SECURITYPOLICY_BASIC256SHA256_MAXASYMKEYLENGTH);
 
     return (size_t) keyLen; 
 }
@@ -351,7 +359,10 @@ UA_ChannelModule_Basic256Sha256_setLocalSymSigningKey (void * channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey (&cc->localSymContext, EVP_sha256 (), key);
 }
 
 static UA_StatusCode
@@ -361,7 +372,11 @@ UA_ChannelM_Basic256Sha256_setLocalSymEncryptingKey (void * channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey (&cc->localSymContext,
+                                                         EVP_aes_256_cbc (), key, true);
 }
 
 static UA_StatusCode
@@ -401,7 +416,10 @@ UA_ChannelM_Basic256Sha256_setRemoteSymSigningKey (void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setSigningKey (&cc->remoteSymContext, EVP_sha256 (), key);
 }
 
 static UA_StatusCode
@@ -411,7 +429,11 @@ UA_ChannelM_Basic256Sha256_setRemoteSymEncryptingKey (void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
     UA_ByteString_deleteMembers(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    UA_StatusCode retval = UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return UA_OpenSSL_SymmetricContext_setEncryptingKey (&cc->remoteSymContext,
+                                                         EVP_aes_256_cbc (), key, false);
 }
 
 static UA_StatusCode
@@ -434,7 +456,7 @@ UA_AsySig_Basic256Sha256_sign (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR; 
     Policy_Context_Basic256Sha256 * pc = 
                (Policy_Context_Basic256Sha256 *) securityPolicy->policyContext;
-    return UA_Openssl_RSA_PKCS1_V15_SHA256_Sign (message, &pc->localPrivateKey,
+    return UA_Openssl_RSA_PKCS1_V15_SHA256_Sign (message, pc->localPrivateKey,
                                                  signature);
 }
 
@@ -466,9 +488,7 @@ UA_SymSig_Basic256Sha256_verify (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify (message, 
-                                          &cc->remoteSymSigningKey, 
-                                          signature);   
+    return UA_OpenSSL_HMAC_Verify (&cc->remoteSymContext, message, signature);
 }
 
 static UA_StatusCode 
@@ -481,7 +501,7 @@ UA_SymSig_Basic256Sha256_sign (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_Sign (&cc->localSymContext, message, signature);
 }
 
 static size_t
@@ -497,7 +517,7 @@ UA_SymEn_Basic256Sha256_decrypt (const UA_SecurityPolicy * securityPolicy,
     if(securityPolicy == NULL || channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;    
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_Sym_Cipher (&cc->remoteSymContext, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -508,7 +528,7 @@ UA_SymEn_Basic256Sha256_encrypt (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_Sym_Cipher (&cc->localSymContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -519,7 +539,7 @@ UA_ChannelM_Basic256Sha256_compareCertificate (const void *channelContext,
     
     const Channel_Context_Basic256Sha256 * cc = 
                      (const Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_X509_compare (certificate, cc->remoteCertificateX509);
+    return UA_OpenSSL_X509_compare (certificate, &cc->remoteCertificate);
 }
 
 static size_t 
@@ -537,8 +557,9 @@ UA_AsymEn_Basic256Sha256_getLocalKeyLength (const UA_SecurityPolicy * securityPo
     Policy_Context_Basic256Sha256 * pc = 
                (Policy_Context_Basic256Sha256 *) securityPolicy->policyContext;
     UA_Int32 keyLen;
-    UA_Openssl_RSA_Private_GetKeyLength (&pc->localPrivateKey, &keyLen);
-    UA_assert (keyLen == 256); /* 256 bytes 2048 bits */
+    UA_Openssl_RSA_Private_GetKeyLength (pc->localPrivateKey, &keyLen);
+    UA_assert (keyLen >= UA_SECURITYPOLICY_BASIC256SHA256_MINASYMKEYLENGTH &&
+               keyLen <= UA_SECURITYPOLICY_BASIC256SHA256_MAXASYMKEYLENGTH);
 
     return (size_t) keyLen * 8; 
 }
@@ -562,6 +583,7 @@ UA_SecurityPolicy_Basic256Sha256(UA_SecurityPolicy * policy,
     UA_Openssl_Init ();
     memset(policy, 0, sizeof(UA_SecurityPolicy));
     policy->logger = logger;
+    policy->threadSafe = true;
     policy->policyUri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256\0");
 
     /* set ChannelModule context  */
@@ -131,6 +131,7 @@ UA_SecurityPolicy_None(UA_SecurityPolicy *policy, const UA_ByteString localCerti
                        const UA_Logger *logger) {
     policy->policyContext = (void *)(uintptr_t)logger;
     policy->policyUri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#None");
+    policy->threadSafe = true;
     policy->logger = logger;
     UA_ByteString_copy(&localCertificate, &policy->localCertificate);
 
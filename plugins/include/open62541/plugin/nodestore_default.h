@@ -14,7 +14,10 @@ _UA_BEGIN_DECLS
 /* The HashMap Nodestore holds all nodes in RAM in single hash-map. Lookip is
  * done based on hashing/comparison of the NodeId with close to O(1) lookup
  * time. However, sometimes the underlying array has to be resized when nodes
- * are added/removed. This can take O(n) time. */
+ * are added/removed. This can take O(n) time.
+ *
+ * getNode, getNodeCopy and releaseNode do not take a lock. They can run
+ * concurrently with one writer that inserts, replaces or removes nodes. */
 UA_EXPORT UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns);
 
@@ -109,6 +109,23 @@ UA_EXPORT UA_StatusCode
 UA_ServerConfig_addNetworkLayerTCP(UA_ServerConfig *conf, UA_UInt16 portNumber,
                                    UA_UInt32 sendBufferSize, UA_UInt32 recvBufferSize);
 
+#ifdef UA_ENABLE_TCP_EPOLL
+/* Adds a TCP network layer based on epoll (Linux only) with custom buffer
+ * sizes. Use this instead of UA_ServerConfig_addNetworkLayerTCP for servers
+ * with many concurrent connections.
+ *
+ * @param conf The configuration to manipulate
+ * @param portNumber The port number for the tcp network layer
+ * @param sendBufferSize The size in bytes for the network send buffer. Pass 0
+ *        to use defaults.
+ * @param recvBufferSize The size in bytes for the network receive buffer.
+ *        Pass 0 to use defaults.
+ */
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_addNetworkLayerTCPEpoll(UA_ServerConfig *conf, UA_UInt16 portNumber,
+                                        UA_UInt32 sendBufferSize, UA_UInt32 recvBufferSize);
+#endif
+
 #ifdef UA_ENABLE_WEBSOCKET_SERVER
 /* Adds a Websocket network layer with custom buffer sizes
  *
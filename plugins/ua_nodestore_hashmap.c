@@ -19,12 +19,31 @@
  *
  * - Tombstone or non-matching NodeId: continue searching
  * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - NULL: Abort the search
+ *
+ * Concurrent Reads
+ * ----------------
+ * getNode, getNodeCopy, releaseNode and iterate do not take a lock. They can
+ * run concurrently with each other and with one writer (insertNode,
+ * replaceNode, removeNode). Writers are serialized by the server lock.
+ *
+ * Writers never change the content of a published entry. A replaced node is a
+ * new entry. A resized table is a new table that is published by swapping the
+ * table pointer. Memory that readers might still access is retired and freed
+ * with epoch-based reclamation: Readers register in the current epoch during
+ * the lookup. A writer advances the epoch once the readers of the previous
+ * epoch have left. Memory retired in epoch e is freed when the epoch is e+2.
+ *
+ * The table holds one reference to every entry it contains. Readers take a
+ * reference only if the count is not zero. An entry with a refCount of zero is
+ * removed from the table. It is retired and the lookup is repeated. */
 
 typedef struct UA_NodeMapEntry {
     struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
-    UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    struct UA_NodeMapEntry *retiredNext; /* List of retired entries */
+    UA_UInt32 retiredEpoch;
+    UA_UInt32 refCount; /* How many consumers have a reference to the node? Plus
+                         * one while the entry is in the table. Atomic. */
     UA_Node node;
 } UA_NodeMapEntry;
 
@@ -36,11 +55,24 @@ typedef struct {
     UA_UInt32 nodeIdHash;
 } UA_NodeMapSlot;
 
-typedef struct {
-    UA_NodeMapSlot *slots;
+typedef struct UA_NodeMapTable {
+    struct UA_NodeMapTable *retiredNext; /* List of retired tables */
+    UA_UInt32 retiredEpoch;
     UA_UInt32 size;
-    UA_UInt32 count;
     UA_UInt32 sizePrimeIndex;
+    UA_NodeMapSlot *slots; /* Allocated together with the table */
+} UA_NodeMapTable;
+
+typedef struct {
+    UA_NodeMapTable *table; /* The current table version. Swapped atomically. */
+    UA_UInt32 count;
+
+    /* Epoch-based reclamation. Entries are retired by readers releasing the
+     * last reference. Tables are only retired by writers. */
+    UA_UInt32 epoch;
+    UA_UInt32 readers[2]; /* Readers in the even/odd epoch */
+    UA_NodeMapEntry *retiredEntries;
+    UA_NodeMapTable *retiredTables;
 
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
@@ -80,16 +112,16 @@ higher_prime_index(UA_UInt32 n) {
 
 /* Returns an empty slot or null if the nodeid exists or if no empty slot is found. */
 static UA_NodeMapSlot *
-findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+findFreeSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid) {
     UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
+    UA_UInt32 size = t->size;
     UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow  */
     UA_UInt32 startIdx = (UA_UInt32)idx;
     UA_UInt32 hash2 = mod2(h, size);
 
     UA_NodeMapSlot *candidate = NULL;
     do {
-        UA_NodeMapSlot *slot = &ns->slots[(UA_UInt32)idx];
+        UA_NodeMapSlot *slot = &t->slots[(UA_UInt32)idx];
 
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* A Node with the NodeId does already exist */
@@ -113,38 +145,186 @@ findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
     return candidate;
 }
 
-/* The occupancy of the table after the call will be about 50% */
+/* Returns the slot and the entry that was found there. The entry is loaded only
+ * once. A concurrent writer may already have replaced it in the slot. */
+static UA_NodeMapSlot *
+findOccupiedSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid,
+                 UA_NodeMapEntry **outEntry) {
+    UA_UInt32 h = UA_NodeId_hash(nodeid);
+    UA_UInt32 size = t->size;
+    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
+    UA_UInt32 hash2 = mod2(h, size);
+    UA_UInt32 startIdx = (UA_UInt32)idx;
+
+    do {
+        UA_NodeMapSlot *slot= &t->slots[(UA_UInt32)idx];
+        UA_NodeMapEntry *entry = slot->entry;
+        if(entry > UA_NODEMAP_TOMBSTONE) {
+            if(slot->nodeIdHash == h &&
+               UA_NodeId_equal(&entry->node.head.nodeId, nodeid)) {
+                *outEntry = entry;
+                return slot;
+            }
+        } else {
+            if(entry == NULL)
+                return NULL; /* No further entry possible */
+        }
+
+        idx += hash2;
+        if(idx >= size)
+            idx -= size;
+    } while((UA_UInt32)idx != startIdx);
+
+    return NULL;
+}
+
+static UA_NodeMapTable *
+createTable(UA_UInt32 sizePrimeIndex) {
+    UA_UInt32 size = primes[sizePrimeIndex];
+    UA_NodeMapTable *t = (UA_NodeMapTable*)
+        UA_calloc(1, sizeof(UA_NodeMapTable) + (size * sizeof(UA_NodeMapSlot)));
+    if(!t)
+        return NULL;
+    t->size = size;
+    t->sizePrimeIndex = sizePrimeIndex;
+    t->slots = (UA_NodeMapSlot*)&t[1];
+    return t;
+}
+
+/***************************/
+/* Epoch-based Reclamation */
+/***************************/
+
+/* Register as a reader in the current epoch. Retry if the epoch was advanced
+ * in the meantime. Then the writer might not have seen the registration. */
+static UA_UInt32
+enterReader(UA_NodeMap *ns) {
+    while(true) {
+        UA_UInt32 epoch = ns->epoch;
+        UA_atomic_addUInt32(&ns->readers[epoch & 1], 1);
+        if(epoch == ns->epoch)
+            return epoch;
+        UA_atomic_subUInt32(&ns->readers[epoch & 1], 1);
+    }
+}
+
+static void
+leaveReader(UA_NodeMap *ns, UA_UInt32 epoch) {
+    UA_atomic_subUInt32(&ns->readers[epoch & 1], 1);
+}
+
+static void
+pushRetiredEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_NodeMapEntry *head;
+    do {
+        head = ns->retiredEntries;
+        entry->retiredNext = head;
+    } while(UA_atomic_cmpxchg((void * volatile *)&ns->retiredEntries,
+                              head, entry) != head);
+}
+
+/* Take a reference if the entry is still in the table */
+static UA_Boolean
+retainEntry(UA_NodeMapEntry *entry) {
+    UA_UInt32 count = entry->refCount;
+    while(count > 0) {
+        UA_UInt32 old = UA_atomic_cmpxchgUInt32(&entry->refCount, count, count + 1);
+        if(old == count)
+            return true;
+        count = old;
+    }
+    return false;
+}
+
+/* The last reference retires the entry. Can be called by readers. */
+static void
+releaseEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_assert(entry->refCount > 0);
+    if(UA_atomic_subUInt32(&entry->refCount, 1) > 0)
+        return;
+    entry->retiredEpoch = ns->epoch;
+    pushRetiredEntry(ns, entry);
+}
+
+static void
+deleteNodeMapEntry(UA_NodeMapEntry *entry) {
+    UA_Node_clear(&entry->node);
+    UA_free(entry);
+}
+
+/* Advance the epoch if possible and free what no reader can access anymore.
+ * Only called by writers. */
+static void
+reclaim(UA_NodeMap *ns) {
+    /* The epoch can be advanced when the readers of the previous epoch (same
+     * parity as the next epoch) have left */
+    UA_UInt32 epoch = ns->epoch;
+    if(ns->readers[(epoch + 1) & 1] == 0) {
+        epoch++;
+        ns->epoch = epoch;
+        UA_atomic_sync();
+    }
+
+    /* Free the retired entries */
+    UA_NodeMapEntry *entry = (UA_NodeMapEntry*)
+        UA_atomic_xchg((void * volatile *)&ns->retiredEntries, NULL);
+    while(entry) {
+        UA_NodeMapEntry *next = entry->retiredNext;
+        if(epoch - entry->retiredEpoch >= 2)
+            deleteNodeMapEntry(entry);
+        else
+            pushRetiredEntry(ns, entry);
+        entry = next;
+    }
+
+    /* Free the retired tables */
+    UA_NodeMapTable **prev = &ns->retiredTables;
+    UA_NodeMapTable *t;
+    while((t = *prev)) {
+        if(epoch - t->retiredEpoch >= 2) {
+            *prev = t->retiredNext;
+            UA_free(t);
+        } else {
+            prev = &t->retiredNext;
+        }
+    }
+}
+
+/*********************/
+/* Resize            */
+/*********************/
+
+/* The occupancy of the table after the call will be about 50%. The new table
+ * is published with an atomic pointer swap. */
 static UA_StatusCode
 expand(UA_NodeMap *ns) {
-    UA_UInt32 osize = ns->size;
+    UA_NodeMapTable *ot = ns->table;
+    UA_UInt32 osize = ot->size;
     UA_UInt32 count = ns->count;
     /* Resize only when table after removal of unused elements is either too
        full or too empty */
     if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
         return UA_STATUSCODE_GOOD;
 
-    UA_NodeMapSlot *oslots = ns->slots;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapSlot *nslots= (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
-    if(!nslots)
+    UA_NodeMapTable *nt = createTable(higher_prime_index(count * 2));
+    if(!nt)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    ns->slots = nslots;
-    ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
-
     /* recompute the position of every entry and insert the pointer */
     for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
-        if(oslots[i].entry <= UA_NODEMAP_TOMBSTONE)
+        if(ot->slots[i].entry <= UA_NODEMAP_TOMBSTONE)
             continue;
-        UA_NodeMapSlot *s = findFreeSlot(ns, &oslots[i].entry->node.head.nodeId);
+        UA_NodeMapSlot *s = findFreeSlot(nt, &ot->slots[i].entry->node.head.nodeId);
         UA_assert(s);
-        *s = oslots[i];
+        *s = ot->slots[i];
         ++j;
     }
 
-    UA_free(oslots);
+    /* Publish the new table. Readers may still use the old one. */
+    UA_atomic_xchg((void * volatile *)&ns->table, nt);
+    ot->retiredEpoch = ns->epoch;
+    ot->retiredNext = ns->retiredTables;
+    ns->retiredTables = ot;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -186,43 +366,17 @@ createEntry(UA_NodeClass nodeClass) {
     return entry;
 }
 
-static void
-deleteNodeMapEntry(UA_NodeMapEntry *entry) {
-    UA_Node_clear(&entry->node);
-    UA_free(entry);
-}
-
-static void
-cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
-    if(entry->deleted && entry->refCount == 0)
-        deleteNodeMapEntry(entry);
-}
-
-static UA_NodeMapSlot *
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
-    UA_UInt32 hash2 = mod2(h, size);
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-
+/* Lookup and take a reference. Must be called as a registered reader. */
+static UA_NodeMapEntry *
+retainEntryById(UA_NodeMap *ns, const UA_NodeId *nodeid) {
+    UA_NodeMapEntry *entry;
     do {
-        UA_NodeMapSlot *slot= &ns->slots[(UA_UInt32)idx];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
-            if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
-                return slot;
-        } else {
-            if(slot->entry == NULL)
-                return NULL; /* No further entry possible */
-        }
-
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx);
-
-    return NULL;
+        UA_NodeMapTable *t = ns->table;
+        if(!findOccupiedSlot(t, nodeid, &entry))
+            return NULL;
+        /* Repeat if the entry was replaced or removed in the meantime */
+    } while(!retainEntry(entry));
+    return entry;
 }
 
 /***********************/
@@ -237,6 +391,7 @@ UA_NodeMap_newNode(void *context, UA_NodeClass nodeClass) {
     return &entry->node;
 }
 
+/* Only for nodes that were not (yet) inserted */
 static void
 UA_NodeMap_deleteNode(void *context, UA_Node *node) {
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
@@ -247,11 +402,12 @@ UA_NodeMap_deleteNode(void *context, UA_Node *node) {
 static const UA_Node *
 UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    UA_UInt32 epoch = enterReader(ns);
+    UA_NodeMapEntry *entry = retainEntryById(ns, nodeid);
+    leaveReader(ns, epoch);
+    if(!entry)
         return NULL;
-    ++slot->entry->refCount;
-    return &slot->entry->node;
+    return &entry->node;
 }
 
 static void
@@ -260,49 +416,51 @@ UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
         return;
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_assert(&entry->node == node);
-    UA_assert(entry->refCount > 0);
-    --entry->refCount;
-    cleanupNodeMapEntry(entry);
+    releaseEntry((UA_NodeMap*)context, entry);
 }
 
 static UA_StatusCode
 UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
                        UA_Node **outNode) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    UA_UInt32 epoch = enterReader(ns);
+    UA_NodeMapEntry *entry = retainEntryById(ns, nodeid);
+    leaveReader(ns, epoch);
+    if(!entry)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_NodeMapEntry *entry = slot->entry;
+
+    UA_StatusCode retval = UA_STATUSCODE_BADOUTOFMEMORY;
     UA_NodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
-    if(!newItem)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    UA_StatusCode retval = UA_Node_copy(&entry->node, &newItem->node);
-    if(retval == UA_STATUSCODE_GOOD) {
-        newItem->orig = entry; /* Store the pointer to the original */
-        *outNode = &newItem->node;
-    } else {
-        deleteNodeMapEntry(newItem);
+    if(newItem) {
+        retval = UA_Node_copy(&entry->node, &newItem->node);
+        if(retval == UA_STATUSCODE_GOOD) {
+            newItem->orig = entry; /* Store the pointer to the original */
+            *outNode = &newItem->node;
+        } else {
+            deleteNodeMapEntry(newItem);
+        }
     }
+    releaseEntry(ns, entry);
     return retval;
 }
 
 static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapEntry *entry;
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns->table, nodeid, &entry);
     if(!slot)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
-    UA_NodeMapEntry *entry = slot->entry;
     slot->entry = UA_NODEMAP_TOMBSTONE;
     UA_atomic_sync(); /* Set the tombstone before cleaning up. E.g. if the
                        * nodestore is accessed from an interrupt. */
-    entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    releaseEntry(ns, entry); /* Release the reference of the table */
     --ns->count;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
+    if(ns->count * 8 < ns->table->size && ns->table->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
+    reclaim(ns);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -310,11 +468,12 @@ static UA_StatusCode
 UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    if(ns->size * 3 <= ns->count * 4) {
+    if(ns->table->size * 3 <= ns->count * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD)
             return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    UA_NodeMapTable *t = ns->table;
     UA_NodeMapSlot *slot;
     if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
        node->head.nodeId.identifier.numeric == 0) {
@@ -325,7 +484,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
          * val, we will reach the starting id again. E.g. adding a nodeset will
          * create children while there are still other nodes which need to be
          * created. Thus the node ids may collide. */
-        UA_UInt32 size = ns->size;
+        UA_UInt32 size = t->size;
         UA_UInt64 identifier = mod(50000 + size+1, UA_UINT32_MAX); /* Use 64bit to
                                                                     * avoid overflow */
         UA_UInt32 increase = mod2(ns->count+1, size);
@@ -334,7 +493,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 
         do {
             node->head.nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->head.nodeId);
+            slot = findFreeSlot(t, &node->head.nodeId);
             if(slot)
                 break;
             identifier += increase;
@@ -342,7 +501,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
                 identifier -= size;
         } while((UA_UInt32)identifier != startId);
     } else {
-        slot = findFreeSlot(ns, &node->head.nodeId);
+        slot = findFreeSlot(t, &node->head.nodeId);
     }
 
     if(!slot) {
@@ -381,12 +540,14 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
         ns->referenceTypeCounter++;
     }
 
-    /* Insert the node */
+    /* Insert the node. The table holds a reference. */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
+    newEntry->refCount = 1;
     slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-    UA_atomic_sync(); /* Set the hash first */
+    UA_atomic_sync(); /* Set the hash and the entry content first */
     slot->entry = newEntry;
     ++ns->count;
+    reclaim(ns);
     return retval;
 }
 
@@ -396,24 +557,26 @@ UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
 
     /* Find the node */
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &node->head.nodeId);
+    UA_NodeMapEntry *oldEntry;
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns->table, &node->head.nodeId, &oldEntry);
     if(!slot) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
 
     /* The node was already updated since the copy was made? */
-    UA_NodeMapEntry *oldEntry = slot->entry;
     if(oldEntry != newEntry->orig) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Replace the entry */
+    /* Replace the entry. The table reference moves to the new entry. */
+    newEntry->refCount = 1;
+    UA_atomic_sync(); /* Set the entry content first */
     slot->entry = newEntry;
     UA_atomic_sync();
-    oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    releaseEntry(ns, oldEntry);
+    reclaim(ns);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -429,32 +592,49 @@ static void
 UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
                    void *visitorContext) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    for(UA_UInt32 i = 0; i < ns->size; ++i) {
-        UA_NodeMapSlot *slot = &ns->slots[i];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
-            /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
-        }
+    /* Stay registered as a reader. So the table is not freed if the visitor
+     * resizes it. */
+    UA_UInt32 epoch = enterReader(ns);
+    UA_NodeMapTable *t = ns->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->slots[i].entry;
+        if(entry <= UA_NODEMAP_TOMBSTONE)
+            continue;
+        /* The visitor can delete the node. So refcount here. */
+        if(!retainEntry(entry))
+            continue;
+        visitor(visitorContext, &entry->node);
+        releaseEntry(ns, entry);
     }
+    leaveReader(ns, epoch);
 }
 
 static void
 UA_NodeMap_delete(void *context) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_UInt32 size = ns->size;
-    UA_NodeMapSlot *slots = ns->slots;
-    for(UA_UInt32 i = 0; i < size; ++i) {
-        if(slots[i].entry > UA_NODEMAP_TOMBSTONE) {
+    UA_NodeMapTable *t = ns->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->slots[i].entry;
+        if(entry > UA_NODEMAP_TOMBSTONE) {
             /* On debugging builds, check that all nodes were release */
-            UA_assert(slots[i].entry->refCount == 0);
+            UA_assert(entry->refCount == 1);
             /* Delete the node */
-            deleteNodeMapEntry(slots[i].entry);
+            deleteNodeMapEntry(entry);
         }
     }
-    UA_free(ns->slots);
+    UA_free(t);
+
+    /* No more readers. Free all retired memory. */
+    while(ns->retiredEntries) {
+        UA_NodeMapEntry *entry = ns->retiredEntries;
+        ns->retiredEntries = entry->retiredNext;
+        deleteNodeMapEntry(entry);
+    }
+    while(ns->retiredTables) {
+        t = ns->retiredTables;
+        ns->retiredTables = t->retiredNext;
+        UA_free(t);
+    }
 
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
@@ -466,21 +646,15 @@ UA_NodeMap_delete(void *context) {
 UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns) {
     /* Allocate and initialize the nodemap */
-    UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
+    UA_NodeMap *nodemap = (UA_NodeMap*)UA_calloc(1, sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
-    nodemap->count = 0;
-    nodemap->slots = (UA_NodeMapSlot*)
-        UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
-    if(!nodemap->slots) {
+    nodemap->table = createTable(higher_prime_index(UA_NODEMAP_MINSIZE));
+    if(!nodemap->table) {
         UA_free(nodemap);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    nodemap->referenceTypeCounter = 0;
-
     /* Populate the nodestore */
     ns->context = nodemap;
     ns->clear = UA_NodeMap_delete;
@@ -21,7 +21,8 @@ typedef struct NodeEntry NodeEntry;
 struct NodeEntry {
     ZIP_ENTRY(NodeEntry) zipfields;
     UA_UInt32 nodeIdHash;
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+    UA_UInt32 refCount; /* How many consumers have a reference to the node?
+                         * Atomic, readers can share the server lock. */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
     NodeEntry *orig;    /* If a copy is made to replace a node, track that we
                          * replace only the node from which the copy was made.
@@ -138,7 +139,7 @@ zipNsGetNode(void *nsCtx, const UA_NodeId *nodeId) {
     NodeEntry *entry = ZIP_FIND(NodeTree, &ns->root, &dummy);
     if(!entry)
         return NULL;
-    ++entry->refCount;
+    UA_atomic_addUInt32(&entry->refCount, 1);
     return (const UA_Node*)&entry->nodeId;
 }
 
@@ -148,8 +149,10 @@ zipNsReleaseNode(void *nsCtx, const UA_Node *node) {
         return;
     NodeEntry *entry = container_of(node, NodeEntry, nodeId);
     UA_assert(entry->refCount > 0);
-    --entry->refCount;
-    cleanupEntry(entry);
+    /* Only the last consumer may delete. Nodes are marked as deleted with
+     * exclusive access to the nodestore. */
+    if(UA_atomic_subUInt32(&entry->refCount, 1) == 0 && entry->deleted)
+        deleteEntry(entry);
 }
 
 static UA_StatusCode
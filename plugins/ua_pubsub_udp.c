@@ -7,10 +7,18 @@
  * Copyright (c) 2020 Fraunhofer IOSB (Author: Julius Pfrommer)
  */
 
+/* For recvmmsg. The amalgamation defines this in its prologue. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE
+#endif
+
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/plugin/pubsub_udp.h>
 #include <open62541/util.h>
 
+/* Maximum number of messages received with one system call */
+#define UA_PUBSUB_UDPMC_RECEIVEBATCH 16
+
 /* UDP multicast network layer specific internal data */
 typedef struct {
     int ai_family;                    /* Protocol family for socket. IPv4/IPv6 */
@@ -444,6 +452,26 @@ UA_PubSubChannelUDPMC_send(UA_PubSubChannel *channel, UA_ExtensionObject *transp
     return UA_STATUSCODE_GOOD;
 }
 
+/* Wait until a message can be received from the socket.
+ *
+ * @param timeout in usec
+ * @return UA_STATUSCODE_GOODNONCRITICALTIMEOUT if no message is pending */
+static UA_StatusCode
+UA_PubSubChannelUDPMC_wait(UA_PubSubChannel *channel, UA_UInt32 timeout) {
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    UA_fd_set(channel->sockfd, &fdset);
+    struct timeval tmptv = {(long int)(timeout / 1000000),
+                            (long int)(timeout % 1000000)};
+    int resultsize = UA_select(channel->sockfd+1, &fdset, NULL,
+                            NULL, &tmptv);
+    if(resultsize == 0)
+        return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
+    if(resultsize == -1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
 /**
  * Receive messages. The regist function should be called before.
  *
@@ -461,20 +489,10 @@ UA_PubSubChannelUDPMC_receive(UA_PubSubChannel *channel, UA_ByteString *message,
     UA_PubSubChannelDataUDPMC *channelConfigUDPMC = (UA_PubSubChannelDataUDPMC *) channel->handle;
 
     if(timeout > 0) {
-        fd_set fdset;
-        FD_ZERO(&fdset);
-        UA_fd_set(channel->sockfd, &fdset);
-        struct timeval tmptv = {(long int)(timeout / 1000000),
-                                (long int)(timeout % 1000000)};
-        int resultsize = UA_select(channel->sockfd+1, &fdset, NULL,
-                                NULL, &tmptv);
-        if(resultsize == 0) {
-            message->length = 0;
-            return UA_STATUSCODE_GOODNONCRITICALTIMEOUT;
-        }
-        if (resultsize == -1) {
+        UA_StatusCode res = UA_PubSubChannelUDPMC_wait(channel, timeout);
+        if(res != UA_STATUSCODE_GOOD) {
             message->length = 0;
-            return UA_STATUSCODE_BADINTERNALERROR;
+            return res;
         }
     }
 
@@ -494,6 +512,73 @@ UA_PubSubChannelUDPMC_receive(UA_PubSubChannel *channel, UA_ByteString *message,
     return UA_STATUSCODE_GOOD;
 }
 
+/**
+ * Receive all pending messages up to the number of buffers. Only the first
+ * message is waited for. On Linux the messages are received with a single
+ * recvmmsg call.
+ *
+ * @param timeout in usec | on windows platforms are only multiples of 1000usec possible
+ * @return
+ */
+static UA_StatusCode
+UA_PubSubChannelUDPMC_receiveBatch(UA_PubSubChannel *channel, UA_ByteString *messages,
+                                   size_t messagesSize, size_t *received,
+                                   UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    *received = 0;
+    if(!(channel->state == UA_PUBSUB_CHANNEL_PUB || channel->state == UA_PUBSUB_CHANNEL_PUB_SUB)) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "PubSub Connection receive failed. Invalid state.");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    UA_PubSubChannelDataUDPMC *channelConfigUDPMC = (UA_PubSubChannelDataUDPMC *) channel->handle;
+    if(channelConfigUDPMC->ai_family != PF_INET)
+        return UA_STATUSCODE_GOOD; //TODO implement recieve for IPv6
+
+    UA_StatusCode res = UA_PubSubChannelUDPMC_wait(channel, timeout);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+#ifdef __linux__
+    struct mmsghdr msgs[UA_PUBSUB_UDPMC_RECEIVEBATCH];
+    struct iovec iovs[UA_PUBSUB_UDPMC_RECEIVEBATCH];
+    while(*received < messagesSize) {
+        size_t batch = messagesSize - *received;
+        if(batch > UA_PUBSUB_UDPMC_RECEIVEBATCH)
+            batch = UA_PUBSUB_UDPMC_RECEIVEBATCH;
+        memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+        for(size_t i = 0; i < batch; i++) {
+            iovs[i].iov_base = messages[*received + i].data;
+            iovs[i].iov_len = messages[*received + i].length;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = recvmmsg(channel->sockfd, msgs, (unsigned int)batch, MSG_DONTWAIT, NULL);
+        if(n <= 0)
+            break;
+        for(size_t i = 0; i < (size_t)n; i++)
+            messages[*received + i].length = msgs[i].msg_len;
+        *received += (size_t)n;
+        if((size_t)n < batch)
+            break;
+    }
+#else
+    /* Poll the socket before every message */
+    while(*received < messagesSize) {
+        if(*received > 0 &&
+           UA_PubSubChannelUDPMC_wait(channel, 0) != UA_STATUSCODE_GOOD)
+            break;
+        UA_ByteString *message = &messages[*received];
+        ssize_t messageLength =
+            UA_recvfrom(channel->sockfd, message->data, message->length, 0, NULL, NULL);
+        if(messageLength <= 0)
+            break;
+        message->length = (size_t)messageLength;
+        (*received)++;
+    }
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
 /**
  * Close channel and free the channel data.
  *
@@ -529,6 +614,7 @@ TransportLayerUDPMC_addChannel(UA_PubSubConnectionConfig *connectionConfig) {
         pubSubChannel->unregist = UA_PubSubChannelUDPMC_unregist;
         pubSubChannel->send = UA_PubSubChannelUDPMC_send;
         pubSubChannel->receive = UA_PubSubChannelUDPMC_receive;
+        pubSubChannel->receiveBatch = UA_PubSubChannelUDPMC_receiveBatch;
         pubSubChannel->close = UA_PubSubChannelUDPMC_close;
         pubSubChannel->connectionConfig = connectionConfig;
     }
@@ -659,7 +659,8 @@ UA_Client_run_iterate(UA_Client *client, UA_UInt32 timeout) {
     /* Process timed (repeated) jobs */
     UA_DateTime now = UA_DateTime_nowMonotonic();
     UA_Timer_process(&client->timer, now,
-                     (UA_TimerExecutionCallback)clientExecuteRepeatedCallback, client);
+                     (UA_TimerExecutionCallback)clientExecuteRepeatedCallback,
+                     NULL, client);
 
     /* Make sure we have an open channel */
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
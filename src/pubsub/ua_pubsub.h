@@ -15,6 +15,7 @@
 
 #include "open62541_queue.h"
 #include "ua_pubsub_networkmessage.h"
+#include "ziptree.h"
 
 _UA_BEGIN_DECLS
 
@@ -28,6 +29,24 @@ typedef struct UA_WriterGroup UA_WriterGroup;
 struct UA_ReaderGroup;
 typedef struct UA_ReaderGroup UA_ReaderGroup;
 
+struct UA_DataSetReader;
+typedef struct UA_DataSetReader UA_DataSetReader;
+
+/* The DataSetReaders of a connection are indexed by the identifiers of the
+ * NetworkMessages they subscribe to. The hash covers all identifiers. Ties are
+ * broken by the identifiers. */
+typedef struct {
+    UA_UInt32 hash;
+    UA_PublisherIdDatatype publisherIdType;
+    UA_UInt64 publisherIdNumeric;
+    UA_String publisherIdString; /* Points into the reader config */
+    UA_UInt16 writerGroupId;
+    UA_UInt16 dataSetWriterId;
+} UA_DataSetReaderKey;
+
+ZIP_HEAD(UA_DataSetReaderIndex, UA_DataSetReader);
+typedef struct UA_DataSetReaderIndex UA_DataSetReaderIndex;
+
 /* The configuration structs (public part of PubSub entities) are defined in include/ua_plugin_pubsub.h */
 
 /**********************************************/
@@ -65,6 +84,7 @@ typedef struct UA_PubSubConnection{
     LIST_HEAD(UA_ListOfWriterGroup, UA_WriterGroup) writerGroups;
     LIST_HEAD(UA_ListOfPubSubReaderGroup, UA_ReaderGroup) readerGroups;
     size_t readerGroupsSize;
+    UA_DataSetReaderIndex readerIndex; /* DataSetReaders of all ReaderGroups */
     TAILQ_ENTRY(UA_PubSubConnection) listEntry;
     UA_UInt16 configurationFreezeCounter;
     /* This flag is 'read only' and is set internally based on the PubSub state. */
@@ -181,12 +201,16 @@ typedef enum {
 }UA_SubscribedDataSetEnumType;
 
 /* DataSetReader Type definition */
-typedef struct UA_DataSetReader {
+struct UA_DataSetReader {
     UA_DataSetReaderConfig config;
     /* implementation defined fields */
     UA_NodeId identifier;
     UA_NodeId linkedReaderGroup;
     LIST_ENTRY(UA_DataSetReader) listEntry;
+    ZIP_ENTRY(UA_DataSetReader) indexFields;
+    UA_Boolean indexed; /* Readers without a supported PublisherId are not
+                         * in the index of the connection */
+    UA_DataSetReaderKey indexKey;
     UA_SubscribedDataSetEnumType subscribedDataSetType;
     UA_TargetVariablesDataType subscribedDataSetTarget;
     /* TODO UA_SubscribedDataSetMirrorDataType subscribedDataSetMirror */
@@ -195,7 +219,7 @@ typedef struct UA_DataSetReader {
     /* This flag is 'read only' and is set internally based on the PubSub state. */
     UA_Boolean configurationFrozen;
     UA_NetworkMessageOffsetBuffer bufferedMessage;
-}UA_DataSetReader;
+};
 
 /* Process Network Message using DataSetReader */
 void UA_Server_DataSetReader_process(UA_Server *server, UA_DataSetReader *dataSetReader, UA_DataSetMessage* dataSetMsg);
@@ -215,6 +239,13 @@ UA_DataSetReader_setPubSubState(UA_Server *server, UA_PubSubState state, UA_Data
 /**********************************************/
 /* ReaderGroup Type Definition*/
 
+/* The messages pending for a ReaderGroup are received in batches into
+ * preallocated buffers. At most UA_READERGROUP_MAXBATCHES batches are processed
+ * per subscribe callback. */
+#define UA_READERGROUP_RECEIVEBATCH 16
+#define UA_READERGROUP_RECEIVEBUFFERSIZE 512
+#define UA_READERGROUP_MAXBATCHES 16
+
 struct UA_ReaderGroup {
     UA_ReaderGroupConfig config;
     UA_NodeId identifier;
@@ -225,6 +256,10 @@ struct UA_ReaderGroup {
     UA_UInt32 readersCount;
     UA_UInt64 subscribeCallbackId;
     UA_Boolean subscribeCallbackIsRegistered;
+    /* Watches the socket of the connection instead of the repeated subscribe
+     * callback. NULL if no network layer can watch the socket. */
+    UA_ServerNetworkLayer *subscribeNetworkLayer;
+    UA_Byte *receiveBuffer; /* UA_READERGROUP_RECEIVEBATCH buffers */
     UA_PubSubState state;
     /* This flag is 'read only' and is set internally based on the PubSub state. */
     UA_Boolean configurationFrozen;
@@ -261,6 +296,8 @@ UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup);
 UA_StatusCode
 UA_ReaderGroup_addSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup);
 void
+UA_ReaderGroup_removeSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup);
+void
 UA_ReaderGroup_subscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup);
 
 #endif /* UA_ENABLE_PUBSUB */
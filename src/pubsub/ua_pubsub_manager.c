@@ -68,6 +68,7 @@ UA_Server_addPubSubConnection(UA_Server *server,
     server->pubSubManager.connectionsSize++;
 
     LIST_INIT(&newConnectionsField->writerGroups);
+    ZIP_INIT(&newConnectionsField->readerIndex);
     newConnectionsField->config = tmpConnectionConfig;
 
     /* Open the channel */
@@ -12,6 +12,7 @@
 #ifdef UA_ENABLE_PUBSUB /* conditional compilation */
 
 #include "ua_pubsub_networkmessage.h"
+#include "ua_types_encoding_binary.h"
 
 const UA_Byte NM_VERSION_MASK = 15;
 const UA_Byte NM_PUBLISHER_ID_ENABLED_MASK = 16;
@@ -52,8 +53,113 @@ static UA_Boolean UA_NetworkMessage_ExtendedFlags1Enabled(const UA_NetworkMessag
 static UA_Boolean UA_NetworkMessage_ExtendedFlags2Enabled(const UA_NetworkMessage* src);
 static UA_Boolean UA_DataSetMessageHeader_DataSetFlags2Enabled(const UA_DataSetMessageHeader* src);
 
+/* Scalars of a builtin type without pointers have a fixed encoded size. The
+ * encoding mask of the variant is already in the buffer. */
+static UA_Boolean
+isFixedSizeScalar(const UA_Variant *v) {
+    return (v->type && v->type->pointerFree && v->data &&
+            v->type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO &&
+            UA_Variant_isScalar(v));
+}
+
+static void
+setCopyOp(UA_NetworkMessageCopyOp *op, size_t offset,
+          const void *src, const UA_DataType *type) {
+    op->offset = offset;
+    op->src = src;
+    op->type = type;
+    op->length = type->memSize;
+    op->opType = (type->overlayable) ? UA_PUBSUB_COPYOP_MEMCPY : UA_PUBSUB_COPYOP_SCALAR;
+}
+
+UA_StatusCode
+UA_NetworkMessage_compileBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer) {
+    UA_free(buffer->copyPlan);
+    buffer->copyPlan = NULL;
+    buffer->copyPlanSize = 0;
+    if(buffer->offsetsSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_NetworkMessageCopyOp *plan = (UA_NetworkMessageCopyOp*)
+        UA_calloc(buffer->offsetsSize, sizeof(UA_NetworkMessageCopyOp));
+    if(!plan)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    for(size_t i = 0; i < buffer->offsetsSize; ++i) {
+        UA_NetworkMessageOffset *o = &buffer->offsets[i];
+        UA_NetworkMessageCopyOp *op = &plan[i];
+        switch(o->contentType) {
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+        case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+            setCopyOp(op, o->offset, o->offsetData.value.value->value.data,
+                      &UA_TYPES[UA_TYPES_UINT16]);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE:
+            op->opType = UA_PUBSUB_COPYOP_DATAVALUE;
+            op->offset = o->offset;
+            op->src = o->offsetData.value.value;
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT: {
+            const UA_Variant *v = &o->offsetData.value.value->value;
+            if(isFixedSizeScalar(v)) {
+                setCopyOp(op, o->offset + 1, v->data, v->type);
+                break;
+            }
+            op->opType = UA_PUBSUB_COPYOP_VARIANT;
+            op->offset = o->offset;
+            op->src = v;
+            break;
+        }
+        default:
+            UA_free(plan);
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        /* The memcpy must not run over the end of the buffer */
+        if(op->offset + op->length > buffer->buffer.length) {
+            UA_free(plan);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+
+    buffer->copyPlan = plan;
+    buffer->copyPlanSize = buffer->offsetsSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runCopyPlan(UA_NetworkMessageOffsetBuffer *buffer) {
+    UA_StatusCode rv = UA_STATUSCODE_GOOD;
+    const UA_Byte *bufEnd = &buffer->buffer.data[buffer->buffer.length];
+    for(size_t i = 0; i < buffer->copyPlanSize; ++i) {
+        const UA_NetworkMessageCopyOp *op = &buffer->copyPlan[i];
+        UA_Byte *bufPos = &buffer->buffer.data[op->offset];
+        switch(op->opType) {
+        case UA_PUBSUB_COPYOP_MEMCPY:
+            memcpy(bufPos, op->src, op->length);
+            break;
+        case UA_PUBSUB_COPYOP_SCALAR:
+            rv = UA_encodeBinary(op->src, op->type, &bufPos, &bufEnd, NULL, NULL);
+            break;
+        case UA_PUBSUB_COPYOP_VARIANT:
+            rv = UA_Variant_encodeBinary((const UA_Variant*)op->src, &bufPos, bufEnd);
+            break;
+        case UA_PUBSUB_COPYOP_DATAVALUE:
+            rv = UA_DataValue_encodeBinary((const UA_DataValue*)op->src, &bufPos, bufEnd);
+            break;
+        default:
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        if(rv != UA_STATUSCODE_GOOD)
+            return rv;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_NetworkMessage_updateBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer){
+    if(buffer->copyPlan)
+        return runCopyPlan(buffer);
+
     UA_StatusCode rv = UA_STATUSCODE_GOOD;
     for (size_t i = 0; i < buffer->offsetsSize; ++i) {
         const UA_Byte *bufEnd = &buffer->buffer.data[buffer->buffer.length];
@@ -78,6 +184,27 @@ UA_NetworkMessage_updateBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer){
     return rv;
 }
 
+UA_Boolean
+UA_NetworkMessage_isOverlayableScalar(const UA_Variant *v) {
+    return (v->type && v->type->overlayable && v->data &&
+            v->type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO &&
+            UA_Variant_isScalar(v));
+}
+
+/* Decode the variant at the offset without allocation into the external value.
+ * The encoding mask must match the type of the external value. */
+static UA_StatusCode
+decodeExternalVariant(const UA_ByteString *src, size_t offset, UA_DataValue *dst) {
+    if(!dst || !UA_NetworkMessage_isOverlayableScalar(&dst->value))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    const UA_DataType *type = dst->value.type;
+    if(offset + 1 + type->memSize > src->length ||
+       src->data[offset] != (UA_Byte)(type->typeKind + 1))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    memcpy(dst->value.data, &src->data[offset + 1], type->memSize);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_NetworkMessage_updateBufferedNwMessage(UA_NetworkMessageOffsetBuffer *buffer,
                                           const UA_ByteString *src){
@@ -136,6 +263,12 @@ UA_NetworkMessage_updateBufferedNwMessage(UA_NetworkMessageOffsetBuffer *buffer,
             dsm->data.keyFrameData.dataSetFields[payloadCounter].hasValue = true;
             payloadCounter++;
             break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL:
+            rv = decodeExternalVariant(src, offset, *buffer->offsets[i].offsetData.externalValue);
+            if(rv != UA_STATUSCODE_GOOD)
+                return rv;
+            payloadCounter++;
+            break;
         default:
             return UA_STATUSCODE_BADNOTSUPPORTED;
         }
@@ -196,7 +196,9 @@ typedef enum {
     /* For subscriber RT */
     UA_PUBSUB_OFFSETTYPE_PUBLISHERID,
     UA_PUBSUB_OFFSETTYPE_WRITERGROUPID,
-    UA_PUBSUB_OFFSETTYPE_DATASETWRITERID
+    UA_PUBSUB_OFFSETTYPE_DATASETWRITERID,
+    /* Scalar variant decoded into the external value of the target variable */
+    UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL
     /* Add more offset types as needed */
 } UA_NetworkMessageOffsetType;
 
@@ -208,14 +210,36 @@ typedef struct {
             size_t valueBinarySize;
         } value;
         UA_DateTime *timestamp;
+        UA_DataValue **externalValue;
     } offsetData;
     size_t offset;
 } UA_NetworkMessageOffset;
 
+/* The copy plan is compiled from the offsets when the configuration of a
+ * WriterGroup is frozen. Scalar fields with a fixed encoding are copied
+ * directly into the buffer. Overlayable types are a plain memcpy. Only the
+ * remaining fields go through the generic encoding. */
+typedef enum {
+    UA_PUBSUB_COPYOP_MEMCPY,   /* Copy length bytes from src */
+    UA_PUBSUB_COPYOP_SCALAR,   /* Encode the scalar src of the given type */
+    UA_PUBSUB_COPYOP_VARIANT,  /* Encode the variant src */
+    UA_PUBSUB_COPYOP_DATAVALUE /* Encode the datavalue src */
+} UA_NetworkMessageCopyOpType;
+
+typedef struct {
+    UA_NetworkMessageCopyOpType opType;
+    size_t offset; /* Destination in the message buffer */
+    size_t length; /* Encoded length for memcpy */
+    const void *src;
+    const UA_DataType *type;
+} UA_NetworkMessageCopyOp;
+
 typedef struct {
     UA_ByteString buffer; /* The precomputed message buffer */
     UA_NetworkMessageOffset *offsets; /* Offsets for changes in the message buffer */
     size_t offsetsSize;
+    UA_NetworkMessageCopyOp *copyPlan; /* Compiled from the offsets */
+    size_t copyPlanSize;
     UA_Boolean RTsubscriberEnabled; /* Addtional offsets computation like publisherId, WGId if this bool enabled */
     UA_NetworkMessage *nm; /* The precomputed NetworkMessage for subscriber */
 } UA_NetworkMessageOffsetBuffer;
@@ -253,9 +277,18 @@ void UA_DataSetMessage_free(const UA_DataSetMessage* p);
  * NetworkMessage
  * ^^^^^^^^^^^^^^ */
 
+/* Compile the copy plan for the offsets of the buffered message. The sources
+ * referenced by the offsets must remain at a stable address. */
+UA_StatusCode
+UA_NetworkMessage_compileBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer);
+
 UA_StatusCode
 UA_NetworkMessage_updateBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer);
 
+/* Scalars of an overlayable type can be decoded in place */
+UA_Boolean
+UA_NetworkMessage_isOverlayableScalar(const UA_Variant *v);
+
 UA_StatusCode
 UA_NetworkMessage_updateBufferedNwMessage(UA_NetworkMessageOffsetBuffer *buffer,
                                           const UA_ByteString *src);
@@ -19,6 +19,10 @@ _UA_BEGIN_DECLS
 UA_StatusCode
 UA_Server_initPubSubNS0(UA_Server *server);
 
+/* Set the callbacks after the nodes were restored from a nodestore image */
+UA_StatusCode
+UA_Server_initPubSubNS0Callbacks(UA_Server *server);
+
 UA_StatusCode
 addPubSubConnectionRepresentation(UA_Server *server, UA_PubSubConnection *connection);
 
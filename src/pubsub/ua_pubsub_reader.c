@@ -31,6 +31,149 @@ UA_Server_ReaderGroup_clear(UA_Server* server, UA_ReaderGroup *readerGroup);
 static void
 UA_DataSetReader_clear(UA_Server *server, UA_DataSetReader *dataSetReader);
 
+/************************/
+/* DataSetReader Index  */
+/************************/
+
+static enum ZIP_CMP
+cmpDataSetReaderKey(const UA_DataSetReaderKey *a, const UA_DataSetReaderKey *b) {
+    if(a->hash != b->hash)
+        return (a->hash < b->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdType != b->publisherIdType)
+        return (a->publisherIdType < b->publisherIdType) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdNumeric != b->publisherIdNumeric)
+        return (a->publisherIdNumeric < b->publisherIdNumeric) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->writerGroupId != b->writerGroupId)
+        return (a->writerGroupId < b->writerGroupId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->dataSetWriterId != b->dataSetWriterId)
+        return (a->dataSetWriterId < b->dataSetWriterId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdString.length != b->publisherIdString.length)
+        return (a->publisherIdString.length < b->publisherIdString.length) ?
+            ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdString.length == 0)
+        return ZIP_CMP_EQ;
+    int cmp = memcmp(a->publisherIdString.data, b->publisherIdString.data,
+                     a->publisherIdString.length);
+    if(cmp == 0)
+        return ZIP_CMP_EQ;
+    return (cmp < 0) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_PROTOTYPE(UA_DataSetReaderIndex, UA_DataSetReader, UA_DataSetReaderKey)
+ZIP_IMPL(UA_DataSetReaderIndex, UA_DataSetReader, indexFields,
+         UA_DataSetReaderKey, indexKey, cmpDataSetReaderKey)
+
+static void
+hashDataSetReaderKey(UA_DataSetReaderKey *key) {
+    UA_UInt32 h = UA_ByteString_hash((UA_UInt32)key->publisherIdType,
+                                     (const UA_Byte*)&key->publisherIdNumeric,
+                                     sizeof(UA_UInt64));
+    h = UA_ByteString_hash(h, key->publisherIdString.data, key->publisherIdString.length);
+    h = UA_ByteString_hash(h, (const UA_Byte*)&key->writerGroupId, sizeof(UA_UInt16));
+    key->hash = UA_ByteString_hash(h, (const UA_Byte*)&key->dataSetWriterId,
+                                   sizeof(UA_UInt16));
+}
+
+/* Get the numeric PublisherId of the reader configuration */
+static UA_StatusCode
+getNumericPublisherId(const UA_Variant *pid, UA_PublisherIdDatatype *type,
+                      UA_UInt64 *numeric) {
+    if(!pid->data)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    if(pid->type == &UA_TYPES[UA_TYPES_BYTE]) {
+        *type = UA_PUBLISHERDATATYPE_BYTE;
+        *numeric = *(UA_Byte*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT16]) {
+        *type = UA_PUBLISHERDATATYPE_UINT16;
+        *numeric = *(UA_UInt16*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT32]) {
+        *type = UA_PUBLISHERDATATYPE_UINT32;
+        *numeric = *(UA_UInt32*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT64]) {
+        *type = UA_PUBLISHERDATATYPE_UINT64;
+        *numeric = *(UA_UInt64*)pid->data;
+    } else {
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Only the PublisherId types that can be received are indexed */
+static UA_StatusCode
+setReaderKey(const UA_DataSetReaderConfig *config, UA_DataSetReaderKey *key) {
+    memset(key, 0, sizeof(UA_DataSetReaderKey));
+    const UA_Variant *pid = &config->publisherId;
+    if(pid->data && pid->type == &UA_TYPES[UA_TYPES_STRING]) {
+        key->publisherIdType = UA_PUBLISHERDATATYPE_STRING;
+        key->publisherIdString = *(UA_String*)pid->data;
+    } else {
+        UA_StatusCode retval =
+            getNumericPublisherId(pid, &key->publisherIdType, &key->publisherIdNumeric);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+    key->writerGroupId = config->writerGroupId;
+    key->dataSetWriterId = config->dataSetWriterId;
+    hashDataSetReaderKey(key);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+setMessageKey(const UA_NetworkMessage *pMsg, UA_DataSetReaderKey *key) {
+    memset(key, 0, sizeof(UA_DataSetReaderKey));
+    key->publisherIdType = pMsg->publisherIdType;
+    switch(pMsg->publisherIdType) {
+    case UA_PUBLISHERDATATYPE_BYTE:
+        key->publisherIdNumeric = pMsg->publisherId.publisherIdByte;
+        break;
+    case UA_PUBLISHERDATATYPE_UINT16:
+        key->publisherIdNumeric = pMsg->publisherId.publisherIdUInt16;
+        break;
+    case UA_PUBLISHERDATATYPE_UINT32:
+        key->publisherIdNumeric = pMsg->publisherId.publisherIdUInt32;
+        break;
+    case UA_PUBLISHERDATATYPE_UINT64:
+        key->publisherIdNumeric = pMsg->publisherId.publisherIdUInt64;
+        break;
+    case UA_PUBLISHERDATATYPE_STRING:
+        key->publisherIdString = pMsg->publisherId.publisherIdString;
+        break;
+    default:
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    key->writerGroupId = pMsg->groupHeader.writerGroupId;
+    key->dataSetWriterId = *pMsg->payloadHeader.dataSetPayloadHeader.dataSetWriterIds;
+    hashDataSetReaderKey(key);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+UA_DataSetReader_addToIndex(UA_PubSubConnection *connection, UA_DataSetReader *reader) {
+    reader->indexed = (setReaderKey(&reader->config, &reader->indexKey) == UA_STATUSCODE_GOOD);
+    if(reader->indexed)
+        ZIP_INSERT(UA_DataSetReaderIndex, &connection->readerIndex, reader,
+                   ZIP_FFS32(UA_UInt32_random()));
+}
+
+static void
+UA_DataSetReader_removeFromIndex(UA_PubSubConnection *connection, UA_DataSetReader *reader) {
+    if(reader->indexed)
+        ZIP_REMOVE(UA_DataSetReaderIndex, &connection->readerIndex, reader);
+    reader->indexed = false;
+}
+
+/* Recompute the index from the DataSetReaders of all ReaderGroups */
+static void
+UA_PubSubConnection_rebuildReaderIndex(UA_PubSubConnection *connection) {
+    ZIP_INIT(&connection->readerIndex);
+    UA_ReaderGroup *readerGroup;
+    LIST_FOREACH(readerGroup, &connection->readerGroups, listEntry) {
+        UA_DataSetReader *reader;
+        LIST_FOREACH(reader, &readerGroup->readers, listEntry)
+            UA_DataSetReader_addToIndex(connection, reader);
+    }
+}
+
 static void
 UA_PubSubDSRDataSetField_sampleValue(UA_Server *server, UA_DataSetReader *dataSetReader,
                                      UA_DataValue *value, size_t fieldNumber) {
@@ -329,7 +472,7 @@ UA_Server_removeReaderGroup(UA_Server *server, UA_NodeId groupIdentifier) {
 
     /* Unregister subscribe callback */
     if(readerGroup->state == UA_PUBSUBSTATE_OPERATIONAL)
-        UA_PubSubManager_removeRepeatedPubSubCallback(server, readerGroup->subscribeCallbackId);
+        UA_ReaderGroup_removeSubscribeCallback(server, readerGroup);
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     /* To Do:RemoveGroupRepresentation(server, &readerGroup->identifier) */
@@ -382,6 +525,8 @@ UA_Server_ReaderGroup_clear(UA_Server* server, UA_ReaderGroup *readerGroup) {
         pConn->readerGroupsSize--;
 
     /* Delete ReaderGroup and its members */
+    UA_free(readerGroup->receiveBuffer);
+    readerGroup->receiveBuffer = NULL;
     UA_String_deleteMembers(&readerGroup->config.name);
     UA_NodeId_deleteMembers(&readerGroup->linkedConnection);
     UA_NodeId_deleteMembers(&readerGroup->identifier);
@@ -408,7 +553,7 @@ UA_ReaderGroup_setPubSubState(UA_Server *server, UA_PubSubState state, UA_Reader
                 case UA_PUBSUBSTATE_PAUSED:
                     break;
                 case UA_PUBSUBSTATE_OPERATIONAL:
-                    UA_PubSubManager_removeRepeatedPubSubCallback(server, readerGroup->subscribeCallbackId);
+                    UA_ReaderGroup_removeSubscribeCallback(server, readerGroup);
                     LIST_FOREACH(dataSetReader, &readerGroup->readers, listEntry){
                         UA_DataSetReader_setPubSubState(server, UA_PUBSUBSTATE_DISABLED, dataSetReader);
                     }
@@ -440,7 +585,7 @@ UA_ReaderGroup_setPubSubState(UA_Server *server, UA_PubSubState state, UA_Reader
             switch (readerGroup->state){
                 case UA_PUBSUBSTATE_DISABLED:
                     readerGroup->state = UA_PUBSUBSTATE_OPERATIONAL;
-                    UA_PubSubManager_removeRepeatedPubSubCallback(server, readerGroup->subscribeCallbackId);
+                    UA_ReaderGroup_removeSubscribeCallback(server, readerGroup);
                     LIST_FOREACH(dataSetReader, &readerGroup->readers, listEntry){
                         UA_DataSetReader_setPubSubState(server, UA_PUBSUBSTATE_OPERATIONAL, dataSetReader);
                     }
@@ -479,6 +624,49 @@ UA_ReaderGroup_setPubSubState(UA_Server *server, UA_PubSubState state, UA_Reader
     return UA_STATUSCODE_GOOD;
 }
 
+/* Fields whose target variable has an external value backend are decoded
+ * directly from the receive buffer into the external value. This requires a
+ * scalar of an overlayable type. The received value is then neither allocated
+ * nor written into the information model. */
+static void
+UA_DataSetReader_linkExternalValues(UA_Server *server, UA_DataSetReader *dsr,
+                                    UA_DataSetMessage *dsm) {
+    UA_NetworkMessageOffsetBuffer *bm = &dsr->bufferedMessage;
+    size_t field = 0;
+    for(size_t i = 0; i < bm->offsetsSize; i++) {
+        UA_NetworkMessageOffset *o = &bm->offsets[i];
+        if(o->contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT)
+            continue;
+        size_t f = field++;
+        if(f >= dsr->subscribedDataSetTarget.targetVariablesSize ||
+           f >= dsr->config.dataSetMetaData.fieldsSize)
+            break;
+
+        UA_FieldTargetDataType *tv = &dsr->subscribedDataSetTarget.targetVariables[f];
+        if(tv->attributeId != UA_ATTRIBUTEID_VALUE || tv->receiverIndexRange.length > 0)
+            continue;
+        const UA_VariableNode *node = (const UA_VariableNode*)
+            UA_NODESTORE_GET(server, &tv->targetNodeId);
+        if(!node)
+            continue;
+        UA_DataValue **ext = NULL;
+        if(node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+           node->valueBackend.backendType == UA_VALUEBACKENDTYPE_EXTERNAL)
+            ext = node->valueBackend.backend.external.value;
+        UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
+        if(!ext || !*ext || !UA_NetworkMessage_isOverlayableScalar(&(*ext)->value) ||
+           !UA_NodeId_equal(&dsr->config.dataSetMetaData.fields[f].dataType,
+                            &(*ext)->value.type->typeId))
+            continue;
+
+        UA_DataValue_delete(o->offsetData.value.value);
+        o->offsetData.externalValue = ext;
+        o->contentType = UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL;
+        /* Not written by UA_Server_DataSetReader_process */
+        UA_DataValue_clear(&dsm->data.keyFrameData.dataSetFields[f]);
+    }
+}
+
 UA_StatusCode
 UA_Server_freezeReaderGroupConfiguration(UA_Server *server, const UA_NodeId readerGroupId) {
     UA_ReaderGroup *rg = UA_ReaderGroup_findRGbyId(server, readerGroupId);
@@ -490,6 +678,8 @@ UA_Server_freezeReaderGroupConfiguration(UA_Server *server, const UA_NodeId read
     UA_PubSubConnection *pubSubConnection = UA_PubSubConnection_findConnectionbyId(server, pubSubConnectionId);
     pubSubConnection->configurationFreezeCounter++;
     pubSubConnection->configurationFrozen = UA_TRUE;
+    /* The DataSetReaders don't change until the configuration is unfrozen */
+    UA_PubSubConnection_rebuildReaderIndex(pubSubConnection);
     //ReaderGroup freeze
     rg->configurationFrozen = UA_TRUE;
     // TODO: Clarify on the freeze functionality in multiple DSR, multiple networkMessage conf in a RG
@@ -586,6 +776,7 @@ UA_Server_freezeReaderGroupConfiguration(UA_Server *server, const UA_NodeId read
         /* Fix the offsets necessary to decode */
         UA_NetworkMessage_calcSizeBinary(networkMessage, &dataSetReader->bufferedMessage);
         dataSetReader->bufferedMessage.nm = networkMessage;
+        UA_DataSetReader_linkExternalValues(server, dataSetReader, dsm);
     }
 
     return UA_STATUSCODE_GOOD;
@@ -650,92 +841,42 @@ UA_Server_setReaderGroupDisabled(UA_Server *server, const UA_NodeId readerGroupI
     return UA_ReaderGroup_setPubSubState(server, UA_PUBSUBSTATE_DISABLED, rg);
 }
 
-static UA_StatusCode
-checkReaderIdentifier(UA_Server *server, UA_NetworkMessage *pMsg, UA_DataSetReader *reader) {
-    if(!pMsg->groupHeaderEnabled &&
-       !pMsg->groupHeader.writerGroupIdEnabled &&
-       !pMsg->payloadHeaderEnabled) {
-        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                    "Cannot process DataSetReader without WriterGroup"
-                    "and DataSetWriter identifiers");
-        return UA_STATUSCODE_BADNOTIMPLEMENTED;
-    }
-
-    if((reader->config.writerGroupId == pMsg->groupHeader.writerGroupId) &&
-       (reader->config.dataSetWriterId == *pMsg->payloadHeader.dataSetPayloadHeader.dataSetWriterIds)) {
-        UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                     "DataSetReader found. Process NetworkMessage");
-        return UA_STATUSCODE_GOOD;
-    }
-
-    return UA_STATUSCODE_BADNOTFOUND;
-}
-
 static UA_StatusCode
 getReaderFromIdentifier(UA_Server *server, UA_NetworkMessage *pMsg,
                         UA_DataSetReader **dataSetReader, UA_PubSubConnection *pConnection) {
-    UA_StatusCode retval = UA_STATUSCODE_BADNOTFOUND;
     if(!pMsg->publisherIdEnabled) {
         UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
                     "Cannot process DataSetReader without PublisherId");
         return UA_STATUSCODE_BADNOTIMPLEMENTED; /* TODO: Handle DSR without PublisherId */
     }
 
-    UA_ReaderGroup* readerGroup;
-    LIST_FOREACH(readerGroup, &pConnection->readerGroups, listEntry) {
-        UA_DataSetReader *tmpReader;
-        LIST_FOREACH(tmpReader, &readerGroup->readers, listEntry) {
-            switch (pMsg->publisherIdType) {
-            case UA_PUBLISHERDATATYPE_BYTE:
-                if(tmpReader->config.publisherId.type == &UA_TYPES[UA_TYPES_BYTE] &&
-                   pMsg->publisherIdType == UA_PUBLISHERDATATYPE_BYTE &&
-                   pMsg->publisherId.publisherIdByte == *(UA_Byte*)tmpReader->config.publisherId.data) {
-                    retval = checkReaderIdentifier(server, pMsg, tmpReader);
-                }
-                break;
-            case UA_PUBLISHERDATATYPE_UINT16:
-                if(tmpReader->config.publisherId.type == &UA_TYPES[UA_TYPES_UINT16] &&
-                   pMsg->publisherIdType == UA_PUBLISHERDATATYPE_UINT16 &&
-                   pMsg->publisherId.publisherIdUInt16 == *(UA_UInt16*) tmpReader->config.publisherId.data) {
-                    retval = checkReaderIdentifier(server, pMsg, tmpReader);
-                }
-                break;
-            case UA_PUBLISHERDATATYPE_UINT32:
-                if(tmpReader->config.publisherId.type == &UA_TYPES[UA_TYPES_UINT32] &&
-                   pMsg->publisherIdType == UA_PUBLISHERDATATYPE_UINT32 &&
-                   pMsg->publisherId.publisherIdUInt32 == *(UA_UInt32*)tmpReader->config.publisherId.data) {
-                    retval = checkReaderIdentifier(server, pMsg, tmpReader);
-                }
-                break;
-            case UA_PUBLISHERDATATYPE_UINT64:
-                if(tmpReader->config.publisherId.type == &UA_TYPES[UA_TYPES_UINT64] &&
-                   pMsg->publisherIdType == UA_PUBLISHERDATATYPE_UINT64 &&
-                   pMsg->publisherId.publisherIdUInt64 == *(UA_UInt64*)tmpReader->config.publisherId.data) {
-                    retval = checkReaderIdentifier(server, pMsg, tmpReader);
-                }
-                break;
-            case UA_PUBLISHERDATATYPE_STRING:
-                if(tmpReader->config.publisherId.type == &UA_TYPES[UA_TYPES_STRING] &&
-                   pMsg->publisherIdType == UA_PUBLISHERDATATYPE_STRING &&
-                   UA_String_equal(&pMsg->publisherId.publisherIdString,
-                                   (UA_String*)tmpReader->config.publisherId.data)) {
-                    retval = checkReaderIdentifier(server, pMsg, tmpReader);
-                }
-                break;
-            default:
-                return UA_STATUSCODE_BADINTERNALERROR;
-            }
+    if((!pMsg->groupHeaderEnabled &&
+        !pMsg->groupHeader.writerGroupIdEnabled &&
+        !pMsg->payloadHeaderEnabled) ||
+       !pMsg->payloadHeader.dataSetPayloadHeader.dataSetWriterIds) {
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Cannot process DataSetReader without WriterGroup"
+                    "and DataSetWriter identifiers");
+        return UA_STATUSCODE_BADNOTIMPLEMENTED;
+    }
 
-            if(retval == UA_STATUSCODE_GOOD) {
-                *dataSetReader = tmpReader;
-                return UA_STATUSCODE_GOOD;
-            }
-        }
+    UA_DataSetReaderKey key;
+    UA_StatusCode retval = setMessageKey(pMsg, &key);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    UA_DataSetReader *reader =
+        ZIP_FIND(UA_DataSetReaderIndex, &pConnection->readerIndex, &key);
+    if(!reader) {
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Dataset reader not found. Check PublisherID, WriterGroupID and DatasetWriterID");
+        return UA_STATUSCODE_BADNOTFOUND;
     }
 
-    UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                "Dataset reader not found. Check PublisherID, WriterGroupID and DatasetWriterID");
-    return UA_STATUSCODE_BADNOTFOUND;
+    UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                 "DataSetReader found. Process NetworkMessage");
+    *dataSetReader = reader;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_ReaderGroup *
@@ -768,84 +909,198 @@ UA_DataSetReader *UA_ReaderGroup_findDSRbyId(UA_Server *server, UA_NodeId identi
     return NULL;
 }
 
-/* This callback triggers the collection and reception of NetworkMessages and the
- * contained DataSetMessages. */
-void UA_ReaderGroup_subscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
-    UA_PubSubConnection *connection =
-        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
-    UA_ByteString buffer;
-    if(UA_ByteString_allocBuffer(&buffer, 512) != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER, "Message buffer alloc failed!");
-        return;
+/* The RT path decodes the identifiers at fixed offsets into the buffered
+ * NetworkMessage of the reader. Only the identifiers that are enabled in the
+ * message are compared with the reader configuration. The PublisherId is
+ * decoded with the type of the buffered message, which can differ from the
+ * configured type. So the numeric values are compared. */
+static UA_Boolean
+UA_DataSetReader_checkRTIdentifiers(const UA_DataSetReader *reader,
+                                    const UA_NetworkMessage *pMsg) {
+    if(pMsg->publisherIdEnabled) {
+        UA_UInt64 msgPublisherId;
+        switch(pMsg->publisherIdType) {
+        case UA_PUBLISHERDATATYPE_BYTE:
+            msgPublisherId = pMsg->publisherId.publisherIdByte;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT16:
+            msgPublisherId = pMsg->publisherId.publisherIdUInt16;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT32:
+            msgPublisherId = pMsg->publisherId.publisherIdUInt32;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT64:
+            msgPublisherId = pMsg->publisherId.publisherIdUInt64;
+            break;
+        default:
+            return false;
+        }
+        UA_PublisherIdDatatype configType;
+        UA_UInt64 configPublisherId;
+        if(getNumericPublisherId(&reader->config.publisherId, &configType,
+                                 &configPublisherId) != UA_STATUSCODE_GOOD ||
+           msgPublisherId != configPublisherId)
+            return false;
     }
 
-    connection->channel->receive(connection->channel, &buffer, NULL, 1000);
-    if(buffer.length > 0) {
-        if (readerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
-            /* Considering max DSM as 1
-             * TODO:
-             * Process with the static value source
-             */
-            UA_DataSetReader *dataSetReader = LIST_FIRST(&readerGroup->readers);
-            /* Decode only the necessary offset and update the networkMessage */
-            if(UA_NetworkMessage_updateBufferedNwMessage(&dataSetReader->bufferedMessage, &buffer) != UA_STATUSCODE_GOOD) {
-                UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                             "PubSub receive. Unknown field type.");
-                UA_ByteString_deleteMembers(&buffer);
-                return;
-            }
+    if(pMsg->groupHeaderEnabled && pMsg->groupHeader.writerGroupIdEnabled &&
+       pMsg->groupHeader.writerGroupId != reader->config.writerGroupId)
+        return false;
 
-            /* Check the decoded message is the expected one
-             * TODO: PublisherID check after modification in NM to support all datatypes
-             *  */
-            if((dataSetReader->bufferedMessage.nm->groupHeader.writerGroupId != dataSetReader->config.writerGroupId) ||
-               (*dataSetReader->bufferedMessage.nm->payloadHeader.dataSetPayloadHeader.dataSetWriterIds != dataSetReader->config.dataSetWriterId)) {
-                UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                             "PubSub receive. Unknown message received. Will not be processed.");
-                UA_ByteString_deleteMembers(&buffer);
-                return;
-            }
+    if(pMsg->payloadHeaderEnabled &&
+       pMsg->payloadHeader.dataSetPayloadHeader.dataSetWriterIds &&
+       pMsg->payloadHeader.dataSetPayloadHeader.dataSetWriterIds[0] !=
+       reader->config.dataSetWriterId)
+        return false;
 
-            UA_Server_DataSetReader_process(server, dataSetReader,
-                                            dataSetReader->bufferedMessage.nm->payload.dataSetPayload.dataSetMessages);
+    return true;
+}
 
-            /* Delete the payload value of every dsf's decoded */
-            UA_DataSetMessage *dsm = dataSetReader->bufferedMessage.nm->payload.dataSetPayload.dataSetMessages;
-            if(dsm->header.fieldEncoding == UA_FIELDENCODING_VARIANT) {
-                for(UA_UInt16 i = 0; i < dsm->data.keyFrameData.fieldCount; i++) {
-                    UA_Variant_deleteMembers(&dsm->data.keyFrameData.dataSetFields[i].value);
-                }
+static void
+processReceivedMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
+                       UA_PubSubConnection *connection, UA_ByteString *buffer) {
+    if(readerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
+        /* Considering max DSM as 1
+         * TODO:
+         * Process with the static value source
+         */
+        UA_DataSetReader *dataSetReader = LIST_FIRST(&readerGroup->readers);
+        /* Decode only the necessary offset and update the networkMessage */
+        if(UA_NetworkMessage_updateBufferedNwMessage(&dataSetReader->bufferedMessage, buffer) != UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "PubSub receive. Unknown field type.");
+            return;
+        }
+
+        /* Check the decoded message is the expected one */
+        if(!UA_DataSetReader_checkRTIdentifiers(dataSetReader,
+                                                dataSetReader->bufferedMessage.nm)) {
+            UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "PubSub receive. Unknown message received. Will not be processed.");
+            return;
+        }
+
+        UA_Server_DataSetReader_process(server, dataSetReader,
+                                        dataSetReader->bufferedMessage.nm->payload.dataSetPayload.dataSetMessages);
+
+        /* Delete the payload value of every dsf's decoded */
+        UA_DataSetMessage *dsm = dataSetReader->bufferedMessage.nm->payload.dataSetPayload.dataSetMessages;
+        if(dsm->header.fieldEncoding == UA_FIELDENCODING_VARIANT) {
+            for(UA_UInt16 i = 0; i < dsm->data.keyFrameData.fieldCount; i++) {
+                UA_Variant_deleteMembers(&dsm->data.keyFrameData.dataSetFields[i].value);
             }
-            else if(dsm->header.fieldEncoding == UA_FIELDENCODING_DATAVALUE) {
-                for(UA_UInt16 i = 0; i < dsm->data.keyFrameData.fieldCount; i++) {
-                    UA_DataValue_deleteMembers(&dsm->data.keyFrameData.dataSetFields[i]);
-                }
+        }
+        else if(dsm->header.fieldEncoding == UA_FIELDENCODING_DATAVALUE) {
+            for(UA_UInt16 i = 0; i < dsm->data.keyFrameData.fieldCount; i++) {
+                UA_DataValue_deleteMembers(&dsm->data.keyFrameData.dataSetFields[i]);
             }
+        }
+        return;
+    }
+
+    UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_USERLAND, "Message received:");
+    UA_NetworkMessage currentNetworkMessage;
+    memset(&currentNetworkMessage, 0, sizeof(UA_NetworkMessage));
+    size_t currentPosition = 0;
+    UA_NetworkMessage_decodeBinary(buffer, &currentPosition, &currentNetworkMessage);
+    UA_Server_processNetworkMessage(server, &currentNetworkMessage, connection);
+    UA_NetworkMessage_deleteMembers(&currentNetworkMessage);
+}
 
-            UA_ByteString_deleteMembers(&buffer);
+/* All pending messages are received in batches into the buffers of the
+ * ReaderGroup. Waits at most timeout (usec) for the first message. */
+static void
+receiveMessages(UA_Server *server, UA_ReaderGroup *readerGroup, UA_UInt32 timeout) {
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+    if(!readerGroup->receiveBuffer) {
+        readerGroup->receiveBuffer = (UA_Byte*)
+            UA_malloc(UA_READERGROUP_RECEIVEBATCH * UA_READERGROUP_RECEIVEBUFFERSIZE);
+        if(!readerGroup->receiveBuffer) {
+            UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER, "Message buffer alloc failed!");
             return;
         }
+    }
+
+    UA_PubSubChannel *channel = connection->channel;
+    UA_ByteString buffers[UA_READERGROUP_RECEIVEBATCH];
+    for(size_t batch = 0; batch < UA_READERGROUP_MAXBATCHES; batch++) {
+        for(size_t i = 0; i < UA_READERGROUP_RECEIVEBATCH; i++) {
+            buffers[i].data = &readerGroup->receiveBuffer[i * UA_READERGROUP_RECEIVEBUFFERSIZE];
+            buffers[i].length = UA_READERGROUP_RECEIVEBUFFERSIZE;
+        }
 
-        UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_USERLAND, "Message received:");
-        UA_NetworkMessage currentNetworkMessage;
-        memset(&currentNetworkMessage, 0, sizeof(UA_NetworkMessage));
-        size_t currentPosition = 0;
-        UA_NetworkMessage_decodeBinary(&buffer, &currentPosition, &currentNetworkMessage);
-        UA_Server_processNetworkMessage(server, &currentNetworkMessage, connection);
-        UA_NetworkMessage_deleteMembers(&currentNetworkMessage);
+        /* Channels without batched receive get one message per callback */
+        size_t received = 0;
+        if(!channel->receiveBatch) {
+            channel->receive(channel, &buffers[0], NULL, timeout);
+            if(buffers[0].length > 0)
+                processReceivedMessage(server, readerGroup, connection, &buffers[0]);
+            return;
+        }
+
+        UA_StatusCode res = channel->receiveBatch(channel, buffers, UA_READERGROUP_RECEIVEBATCH,
+                                                  &received, NULL, timeout);
+        for(size_t i = 0; i < received; i++) {
+            if(buffers[i].length > 0)
+                processReceivedMessage(server, readerGroup, connection, &buffers[i]);
+        }
+
+        /* All pending messages were received */
+        if(res != UA_STATUSCODE_GOOD || received < UA_READERGROUP_RECEIVEBATCH)
+            return;
+        timeout = 0;
     }
+}
+
+/* This callback triggers the collection and reception of NetworkMessages and the
+ * contained DataSetMessages */
+void UA_ReaderGroup_subscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    receiveMessages(server, readerGroup, 1000); /* Only wait for the first message */
+}
+
+/* Called from the network layer when the socket is readable. So the pending
+ * messages are received without waiting. */
+static void
+subscribeSocketCallback(UA_Server *server, void *readerGroup) {
+    receiveMessages(server, (UA_ReaderGroup*)readerGroup, 0);
+}
+
+/* Register the socket of the connection with the first network layer that can
+ * watch it. Channels with a yield function receive in there. */
+static UA_StatusCode
+watchSubscribeSocket(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+    if(!connection || !connection->channel || !connection->channel->receive ||
+       connection->channel->yield)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
 
-    UA_ByteString_deleteMembers(&buffer);
+    UA_StatusCode res = UA_STATUSCODE_BADNOTSUPPORTED;
+    for(size_t i = 0; i < server->config.networkLayersSize; i++) {
+        UA_ServerNetworkLayer *nl = &server->config.networkLayers[i];
+        if(!nl->watchSocket)
+            continue;
+        res = nl->watchSocket(nl, connection->channel->sockfd,
+                              subscribeSocketCallback, readerGroup);
+        if(res == UA_STATUSCODE_GOOD) {
+            readerGroup->subscribeNetworkLayer = nl;
+            break;
+        }
+    }
+    return res;
 }
 
-/* Add new subscribeCallback. The first execution is triggered directly after
- * creation. */
+/* Add new subscribeCallback. Messages are received when the socket of the
+ * connection is readable. Otherwise they are polled with a repeated callback.
+ * The first execution is triggered directly after creation. */
 UA_StatusCode
 UA_ReaderGroup_addSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    retval |= UA_PubSubManager_addRepeatedCallback(server,
-                                                   (UA_ServerCallback) UA_ReaderGroup_subscribeCallback,
-                                                   readerGroup, 5, &readerGroup->subscribeCallbackId); // TODO: Remove the hardcode of interval (5ms)
+    UA_StatusCode retval = watchSubscribeSocket(server, readerGroup);
+    if(retval != UA_STATUSCODE_GOOD)
+        retval = UA_PubSubManager_addRepeatedCallback(server,
+                                                      (UA_ServerCallback) UA_ReaderGroup_subscribeCallback,
+                                                      readerGroup, 5, &readerGroup->subscribeCallbackId); // TODO: Remove the hardcode of interval (5ms)
 
     if(retval == UA_STATUSCODE_GOOD)
         readerGroup->subscribeCallbackIsRegistered = true;
@@ -855,6 +1110,22 @@ UA_ReaderGroup_addSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGro
     return retval;
 }
 
+void
+UA_ReaderGroup_removeSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    if(readerGroup->subscribeNetworkLayer) {
+        UA_PubSubConnection *connection =
+            UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+        if(connection && connection->channel)
+            readerGroup->subscribeNetworkLayer->
+                unwatchSocket(readerGroup->subscribeNetworkLayer,
+                              connection->channel->sockfd);
+        readerGroup->subscribeNetworkLayer = NULL;
+    } else {
+        UA_PubSubManager_removeRepeatedPubSubCallback(server, readerGroup->subscribeCallbackId);
+    }
+    readerGroup->subscribeCallbackIsRegistered = false;
+}
+
 /**********/
 /* Reader */
 /**********/
@@ -887,9 +1158,13 @@ UA_Server_addDataSetReader(UA_Server *server, UA_NodeId readerGroupIdentifier,
         UA_NodeId_copy(&newDataSetReader->identifier, readerIdentifier);
     }
 
-    /* Add the new reader to the group */
+    /* Add the new reader to the group and the index of the connection */
     LIST_INSERT_HEAD(&readerGroup->readers, newDataSetReader, listEntry);
     readerGroup->readersCount++;
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+    if(connection)
+        UA_DataSetReader_addToIndex(connection, newDataSetReader);
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     addDataSetReaderRepresentation(server, newDataSetReader);
@@ -946,8 +1221,14 @@ UA_Server_DataSetReader_updateConfig(UA_Server *server, UA_NodeId dataSetReaderI
     /* The update functionality will be extended during the next PubSub batches.
      * Currently is only a change of the publishing interval possible. */
     if(currentDataSetReader->config.writerGroupId != config->writerGroupId) {
-       UA_PubSubManager_removeRepeatedPubSubCallback(server, currentReaderGroup->subscribeCallbackId);
+       UA_ReaderGroup_removeSubscribeCallback(server, currentReaderGroup);
+       UA_PubSubConnection *connection =
+           UA_PubSubConnection_findConnectionbyId(server, currentReaderGroup->linkedConnection);
+       if(connection)
+           UA_DataSetReader_removeFromIndex(connection, currentDataSetReader);
        currentDataSetReader->config.writerGroupId = config->writerGroupId;
+       if(connection)
+           UA_DataSetReader_addToIndex(connection, currentDataSetReader);
        UA_ReaderGroup_subscribeCallback(server, currentReaderGroup);
     }
     else {
@@ -1286,6 +1567,15 @@ UA_Server_DataSetReader_process(UA_Server *server, UA_DataSetReader *dataSetRead
 
 static void
 UA_DataSetReader_clear(UA_Server *server, UA_DataSetReader *dataSetReader) {
+    /* Remove from the index before the PublisherId of the key is deleted */
+    UA_ReaderGroup* pGroup = UA_ReaderGroup_findRGbyId(server, dataSetReader->linkedReaderGroup);
+    if(pGroup != NULL) {
+        UA_PubSubConnection *connection =
+            UA_PubSubConnection_findConnectionbyId(server, pGroup->linkedConnection);
+        if(connection)
+            UA_DataSetReader_removeFromIndex(connection, dataSetReader);
+    }
+
     /* Delete DataSetReader config */
     UA_String_deleteMembers(&dataSetReader->config.name);
     UA_Variant_deleteMembers(&dataSetReader->config.publisherId);
@@ -1295,7 +1585,6 @@ UA_DataSetReader_clear(UA_Server *server, UA_DataSetReader *dataSetReader) {
     UA_TargetVariablesDataType_deleteMembers(&dataSetReader->subscribedDataSetTarget);
 
     /* Delete DataSetReader */
-    UA_ReaderGroup* pGroup = UA_ReaderGroup_findRGbyId(server, dataSetReader->linkedReaderGroup);
     if(pGroup != NULL) {
         pGroup->readersCount--;
     }
@@ -121,6 +121,12 @@ UA_PubSubConnection_clear(UA_Server *server, UA_PubSubConnection *connection) {
     LIST_FOREACH_SAFE(readerGroups, &connection->readerGroups, listEntry, tmpReaderGroup)
         UA_Server_removeReaderGroup(server, readerGroups->identifier);
 
+    /* Stop receiving for the frozen ReaderGroups before the channel is closed */
+    LIST_FOREACH(readerGroups, &connection->readerGroups, listEntry) {
+        if(readerGroups->subscribeCallbackIsRegistered)
+            UA_ReaderGroup_removeSubscribeCallback(server, readerGroups);
+    }
+
     UA_NodeId_clear(&connection->identifier);
     if(connection->channel)
         connection->channel->close(connection->channel);
@@ -282,6 +288,7 @@ UA_Server_freezeWriterGroupConfiguration(UA_Server *server, const UA_NodeId writ
         /* Generate data set messages  */
         UA_STACKARRAY(UA_UInt16, dsWriterIds, wg->writersCount);
         UA_STACKARRAY(UA_DataSetMessage, dsmStore, wg->writersCount);
+        UA_STACKARRAY(UA_DataSetWriter*, dsWriters, wg->writersCount);
         UA_DataSetWriter *dsw;
         LIST_FOREACH(dsw, &wg->writers, listEntry) {
             /* Find the dataset */
@@ -304,7 +311,7 @@ UA_Server_freezeWriterGroupConfiguration(UA_Server *server, const UA_NodeId writ
                     UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
                                    "PubSub-RT configuration fail: PDS contains field without external data source.");
                     UA_NODESTORE_RELEASE(server, (const UA_Node *) rtNode);
-                    //return UA_STATUSCODE_BADNOTSUPPORTED;
+                    return UA_STATUSCODE_BADNOTSUPPORTED;
                 }
                 UA_NODESTORE_RELEASE(server, (const UA_Node *) rtNode);
                 if((UA_NodeId_equal(&dsf->fieldMetaData.dataType, &UA_TYPES[UA_TYPES_STRING].typeId) ||
@@ -331,6 +338,7 @@ UA_Server_freezeWriterGroupConfiguration(UA_Server *server, const UA_NodeId writ
                 continue;
             }
             dsWriterIds[dsmCount] = dsw->config.dataSetWriterId;
+            dsWriters[dsmCount] = dsw;
             dsmCount++;
         }
         UA_NetworkMessage networkMessage;
@@ -359,7 +367,33 @@ UA_Server_freezeWriterGroupConfiguration(UA_Server *server, const UA_NodeId writ
         const UA_Byte *bufEnd = &wg->bufferedMessage.buffer.data[wg->bufferedMessage.buffer.length];
         UA_Byte *bufPos = wg->bufferedMessage.buffer.data;
         UA_NetworkMessage_encodeBinary(&networkMessage, &bufPos, bufEnd);
-        
+
+        /* The sequence numbers of the generated message are on the stack. Take
+         * them from the WriterGroup and the DataSetWriters instead. */
+        for(size_t i = 0; i < wg->bufferedMessage.offsetsSize; i++) {
+            UA_NetworkMessageOffset *o = &wg->bufferedMessage.offsets[i];
+            UA_Variant *seq = &o->offsetData.value.value->value;
+            if(o->contentType == UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER) {
+                seq->data = &wg->sequenceNumber;
+                seq->storageType = UA_VARIANT_DATA_NODELETE;
+            } else if(o->contentType == UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER) {
+                for(size_t j = 0; j < dsmCount; j++) {
+                    if(seq->data != &dsmStore[j].header.dataSetMessageSequenceNr)
+                        continue;
+                    seq->data = &dsWriters[j]->actualDataSetMessageSequenceCount;
+                    seq->storageType = UA_VARIANT_DATA_NODELETE;
+                    break;
+                }
+            }
+        }
+
+        /* Compile the copy plan that is run in every publish cycle */
+        res = UA_NetworkMessage_compileBufferedMessage(&wg->bufferedMessage);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "PubSub-RT configuration: Cannot compile the copy plan. "
+                           "Encode the offsets in every cycle instead.");
+
         UA_free(networkMessage.payload.dataSetPayload.sizes);
         /* Clean up DSM */
         for(size_t i = 0; i < dsmCount; i++){
@@ -406,8 +440,12 @@ UA_Server_unfreezeWriterGroupConfiguration(UA_Server *server, const UA_NodeId wr
         }
         dataSetWriter->configurationFrozen = UA_FALSE;
     }
-    if(wg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
+    if(wg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
         UA_ByteString_clear(&wg->bufferedMessage.buffer);
+        UA_free(wg->bufferedMessage.copyPlan);
+        wg->bufferedMessage.copyPlan = NULL;
+        wg->bufferedMessage.copyPlanSize = 0;
+    }
 
     return UA_STATUSCODE_GOOD;
 }
@@ -1077,13 +1115,20 @@ UA_WriterGroup_clear(UA_Server *server, UA_WriterGroup *writerGroup) {
     }
     if(writerGroup->bufferedMessage.offsetsSize > 0){
         for (size_t i = 0; i < writerGroup->bufferedMessage.offsetsSize; i++) {
-            if(writerGroup->bufferedMessage.offsets[i].contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT){
+            switch(writerGroup->bufferedMessage.offsets[i].contentType) {
+            case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT:
+            case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+            case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
                 UA_DataValue_delete(writerGroup->bufferedMessage.offsets[i].offsetData.value.value);
+                break;
+            default:
+                break;
             }
         }
         UA_ByteString_deleteMembers(&writerGroup->bufferedMessage.buffer);
         UA_free(writerGroup->bufferedMessage.offsets);
     }
+    UA_free(writerGroup->bufferedMessage.copyPlan);
     UA_NodeId_clear(&writerGroup->identifier);
 }
 
@@ -2020,8 +2065,12 @@ UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
         UA_StatusCode res =
             sendBufferedNetworkMessage(server, connection, &writerGroup->bufferedMessage,
                                        &writerGroup->config.transportSettings);
-        if(res == UA_STATUSCODE_GOOD)
+        if(res == UA_STATUSCODE_GOOD) {
             writerGroup->sequenceNumber++;
+            UA_DataSetWriter *dsw;
+            LIST_FOREACH(dsw, &writerGroup->writers, listEntry)
+                dsw->actualDataSetMessageSequenceCount++;
+        }
         return;
     }
 
@@ -98,6 +98,12 @@ void UA_Node_clear(UA_Node *node) {
 static UA_StatusCode
 UA_ObjectNode_copy(const UA_ObjectNode *src, UA_ObjectNode *dst) {
     dst->eventNotifier = src->eventNotifier;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* The MonitoredItems are not owned by the node. Keep them registered when
+     * the copy replaces the original node (immutable nodes). Copies that are
+     * inserted as a new node have to reset the list. */
+    dst->monitoredItemQueue = src->monitoredItemQueue;
+#endif
     return UA_STATUSCODE_GOOD;
 }
 
@@ -126,6 +132,9 @@ UA_VariableNode_copy(const UA_VariableNode *src, UA_VariableNode *dst) {
     dst->accessLevel = src->accessLevel;
     dst->minimumSamplingInterval = src->minimumSamplingInterval;
     dst->historizing = src->historizing;
+#if UA_MULTITHREADING >= 200
+    dst->threadSafe = src->threadSafe;
+#endif
     return UA_CommonVariableNode_copy(src, dst);
 }
 
@@ -178,7 +187,8 @@ UA_ViewNode_copy(const UA_ViewNode *src, UA_ViewNode *dst) {
 
 static UA_StatusCode
 addReferenceTarget(UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target,
-                   UA_UInt32 targetIdHash, UA_UInt32 targetNameHash);
+                   UA_UInt32 targetIdHash, UA_UInt32 targetNameHash,
+                   UA_UInt32 sequence);
 
 UA_StatusCode
 UA_Node_copy(const UA_Node *src, UA_Node *dst) {
@@ -217,6 +227,7 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
             UA_NodeReferenceKind *drefs = &dsthead->references[i];
             drefs->referenceTypeIndex = srefs->referenceTypeIndex;
             drefs->isInverse = srefs->isInverse;
+            drefs->nextSequence = srefs->nextSequence;
             TAILQ_INIT(&drefs->queueHead);
             ZIP_INIT(&drefs->refTargetsIdTree);
             ZIP_INIT(&drefs->refTargetsNameTree);
@@ -224,7 +235,8 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
             UA_ReferenceTarget *sTarget;
             TAILQ_FOREACH(sTarget, &srefs->queueHead, queuePointers) {
                 retval = addReferenceTarget(drefs, &sTarget->targetId,
-                                            sTarget->targetIdHash, sTarget->targetNameHash);
+                                            sTarget->targetIdHash, sTarget->targetNameHash,
+                                            sTarget->sequence);
                 if(retval != UA_STATUSCODE_GOOD)
                     break;
             }
@@ -358,7 +370,7 @@ copyCommonVariableAttributes(UA_VariableNode *node,
     node->valueRank = attr->valueRank;
 
     /* Copy the value */
-    retval = UA_Variant_copy(&attr->value, &node->value.data.value.value);
+    retval = copyNodeValue(&attr->value, &node->value.data.value.value);
     node->valueSource = UA_VALUESOURCE_DATA;
     node->value.data.value.hasValue = (node->value.data.value.value.type != NULL);
 
@@ -489,9 +501,12 @@ UA_Node_setAttributes(UA_Node *node, const void *attributes, const UA_DataType *
 /* Manage References */
 /*********************/
 
+/* The sequence number keeps the position of the target for the continuation
+ * points of Browse. It is kept when the node is copied. */
 static UA_StatusCode
 addReferenceTarget(UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target,
-                   UA_UInt32 targetIdHash, UA_UInt32 targetNameHash) {
+                   UA_UInt32 targetIdHash, UA_UInt32 targetNameHash,
+                   UA_UInt32 sequence) {
     UA_ReferenceTarget *entry = (UA_ReferenceTarget*)
         UA_malloc(sizeof(UA_ReferenceTarget));
     if(!entry)
@@ -505,6 +520,7 @@ addReferenceTarget(UA_NodeReferenceKind *refs, const UA_ExpandedNodeId *target,
 
     entry->targetIdHash = targetIdHash;
     entry->targetNameHash = targetNameHash;
+    entry->sequence = sequence;
     unsigned char rank = ZIP_FFS32(UA_UInt32_random());
     TAILQ_INSERT_TAIL(&refs->queueHead, entry, queuePointers);
     ZIP_INSERT(UA_ReferenceTargetIdTree, &refs->refTargetsIdTree, entry, rank);
@@ -528,12 +544,13 @@ addReferenceKind(UA_NodeHead *head, UA_Byte refTypeIndex, UA_Boolean isForward,
     UA_NodeReferenceKind *newRef = &refs[head->referencesSize];
     newRef->referenceTypeIndex = refTypeIndex;
     newRef->isInverse = !isForward;
+    newRef->nextSequence = 1;
     TAILQ_INIT(&newRef->queueHead);
     ZIP_INIT(&newRef->refTargetsIdTree);
     ZIP_INIT(&newRef->refTargetsNameTree);
     UA_StatusCode retval = addReferenceTarget(newRef, targetNodeId,
                                               UA_ExpandedNodeId_hash(targetNodeId),
-                                              targetBrowseNameHash);
+                                              targetBrowseNameHash, 0);
     if(retval != UA_STATUSCODE_GOOD) {
         if(head->referencesSize == 0) {
             UA_free(head->references);
@@ -569,7 +586,7 @@ UA_Node_addReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
 
         /* Add to existing ReferenceKind */
         return addReferenceTarget(refs, targetNodeId, tmpTarget.targetIdHash,
-                                  targetBrowseNameHash);
+                                  targetBrowseNameHash, refs->nextSequence++);
     }
 
     /* Add new ReferenceKind for the target */
@@ -578,6 +595,23 @@ UA_Node_addReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
 
 }
 
+UA_StatusCode
+UA_Node_appendReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                        const UA_ExpandedNodeId *targetNodeId,
+                        UA_UInt32 targetBrowseNameHash) {
+    /* Append to the last ReferenceKind if it matches */
+    UA_NodeHead *head = &node->head;
+    if(head->referencesSize > 0) {
+        UA_NodeReferenceKind *last = &head->references[head->referencesSize-1];
+        if(last->referenceTypeIndex == refTypeIndex && last->isInverse != isForward)
+            return addReferenceTarget(last, targetNodeId,
+                                      UA_ExpandedNodeId_hash(targetNodeId),
+                                      targetBrowseNameHash, last->nextSequence++);
+    }
+    return addReferenceKind(head, refTypeIndex, isForward,
+                            targetNodeId, targetBrowseNameHash);
+}
+
 UA_StatusCode
 UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
                         const UA_ExpandedNodeId *targetNodeId) {
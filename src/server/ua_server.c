@@ -88,9 +88,9 @@ UA_UInt16 UA_Server_addNamespace(UA_Server *server, const char* name) {
     UA_String nameString;
     nameString.length = strlen(name);
     nameString.data = (UA_Byte*)(uintptr_t)name;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_UInt16 retVal = addNamespace(server, nameString);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retVal;
 }
 
@@ -120,19 +120,19 @@ getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
 UA_StatusCode
 UA_Server_getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
                              size_t *foundIndex) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode res = getNamespaceByName(server, namespaceUri, foundIndex);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return res;
 }
 
 UA_StatusCode
 UA_Server_forEachChildNodeCall(UA_Server *server, UA_NodeId parentNodeId,
                                UA_NodeIteratorCallback callback, void *handle) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     const UA_Node *parent = UA_NODESTORE_GET(server, &parentNodeId);
     if(!parent) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADNODEIDINVALID;
     }
 
@@ -146,7 +146,7 @@ UA_Server_forEachChildNodeCall(UA_Server *server, UA_NodeId parentNodeId,
     UA_Node *parentCopy = UA_Node_copy_alloc(parent);
     if(!parentCopy) {
         UA_NODESTORE_RELEASE(server, parent);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADUNEXPECTEDERROR;
     }
 
@@ -157,9 +157,9 @@ UA_Server_forEachChildNodeCall(UA_Server *server, UA_NodeId parentNodeId,
             *UA_NODESTORE_GETREFERENCETYPEID(server, ref->referenceTypeIndex);
         UA_ReferenceTarget *target;
         TAILQ_FOREACH(target, &ref->queueHead, queuePointers) {
-            UA_UNLOCK(server->serviceMutex);
+            UA_WRUNLOCK(server->serviceMutex);
             retval = callback(target->targetId.nodeId, ref->isInverse, refTypeId, handle);
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             if(retval != UA_STATUSCODE_GOOD)
                 goto cleanup;
         }
@@ -170,7 +170,7 @@ cleanup:
     UA_free(parentCopy);
 
     UA_NODESTORE_RELEASE(server, parent);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -180,29 +180,40 @@ cleanup:
 
 /* The server needs to be stopped before it can be deleted */
 void UA_Server_delete(UA_Server *server) {
+#if UA_MULTITHREADING >= 200
+    /* Complete the jobs that hold SecureChannels */
+    UA_AsyncManager_stopCryptoWorkers(&server->asyncManager, server);
+    while(server->asyncManager.serviceJobsCount > 0)
+        UA_AsyncManager_waitServiceResults(&server->asyncManager, server);
+#endif
+
     /* Delete all internal data */
     UA_Server_deleteSecureChannels(server);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     session_list_entry *current, *temp;
     LIST_FOREACH_SAFE(current, &server->sessions, pointers, temp) {
         UA_Server_removeSession(server, current, UA_DIAGNOSTICEVENT_CLOSE);
     }
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     UA_Array_delete(server->namespaces, server->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     UA_MonitoredItem *mon, *mon_tmp;
     LIST_FOREACH_SAFE(mon, &server->localMonitoredItems, listEntry, mon_tmp) {
         LIST_REMOVE(mon, listEntry);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         UA_MonitoredItem_delete(server, mon);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
     }
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     UA_ConditionList_delete(server);
 #endif//UA_ENABLE_ALARMS_CONDITIONS
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_Event_clearSources(server);
+#endif
+
 #endif
 
 #ifdef UA_ENABLE_PUBSUB
@@ -218,9 +229,11 @@ void UA_Server_delete(UA_Server *server) {
 #endif
 
     /* Clean up the Admin Session */
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_Session_deleteMembersCleanup(&server->adminSession, server);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
+
+    AddNode_clearPlans(server);
 
     /* Clean up the work queue */
     UA_WorkQueue_cleanup(&server->workQueue);
@@ -233,7 +246,11 @@ void UA_Server_delete(UA_Server *server) {
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(server->networkMutex)
-    UA_LOCK_DESTROY(server->serviceMutex)
+    UA_RWLOCK_DESTROY(server->serviceMutex)
+    UA_LOCK_DESTROY(server->continuationPointsMutex)
+#endif
+#if UA_MULTITHREADING >= 200
+    UA_LOCK_DESTROY(server->valueCallbackMutex)
 #endif
 
     /* Delete the server itself */
@@ -243,14 +260,14 @@ void UA_Server_delete(UA_Server *server) {
 /* Recurring cleanup. Removing unused and timed-out channels and sessions */
 static void
 UA_Server_cleanup(UA_Server *server, void *_) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_DateTime nowMonotonic = UA_DateTime_nowMonotonic();
     UA_Server_cleanupSessions(server, nowMonotonic);
     UA_Server_cleanupTimedOutSecureChannels(server, nowMonotonic);
 #ifdef UA_ENABLE_DISCOVERY
     UA_Discovery_cleanupTimedOut(server, nowMonotonic);
 #endif
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 /********************/
@@ -258,7 +275,7 @@ UA_Server_cleanup(UA_Server *server, void *_) {
 /********************/
 
 static UA_Server *
-UA_Server_init(UA_Server *server) {
+UA_Server_init(UA_Server *server, const UA_ByteString *image) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     
     if(!server->config.nodestore.getNode) {
@@ -278,7 +295,11 @@ UA_Server_init(UA_Server *server) {
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_INIT(server->networkMutex)
-    UA_LOCK_INIT(server->serviceMutex)
+    UA_RWLOCK_INIT(server->serviceMutex)
+    UA_LOCK_INIT(server->continuationPointsMutex)
+#endif
+#if UA_MULTITHREADING >= 200
+    UA_LOCK_INIT(server->valueCallbackMutex)
 #endif
 
     /* Initialize the handling of repeated callbacks */
@@ -305,12 +326,16 @@ UA_Server_init(UA_Server *server) {
 
     /* Initialize SecureChannel */
     TAILQ_INIT(&server->channels);
+    ZIP_INIT(&server->channelsByTimeout);
     /* TODO: use an ID that is likely to be unique after a restart */
     server->lastChannelId = STARTCHANNELID;
     server->lastTokenId = STARTTOKENID;
 
     /* Initialize Session Management */
     LIST_INIT(&server->sessions);
+    ZIP_INIT(&server->sessionsByToken);
+    ZIP_INIT(&server->sessionsById);
+    ZIP_INIT(&server->sessionsByTimeout);
     server->sessionCount = 0;
 
 #if UA_MULTITHREADING >= 100
@@ -321,14 +346,21 @@ UA_Server_init(UA_Server *server) {
     UA_Server_addRepeatedCallback(server, (UA_ServerCallback)UA_Server_cleanup, NULL,
                                   10000.0, NULL);
 
-    /* Initialize namespace 0*/
-    res = UA_Server_initNS0(server);
+    /* Initialize namespace 0 or restore the nodes from the image */
+    if(image)
+        res = UA_Server_loadNodestoreImage(server, image);
+    else
+        res = UA_Server_initNS0(server);
     if(res != UA_STATUSCODE_GOOD)
         goto cleanup;
 
-    /* Build PubSub information model */
+    /* Build PubSub information model. The nodes from the image only need the
+     * callbacks. */
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
-    UA_Server_initPubSubNS0(server);
+    if(image)
+        UA_Server_initPubSubNS0Callbacks(server);
+    else
+        UA_Server_initPubSubNS0(server);
 #endif
 
     return server;
@@ -346,7 +378,19 @@ UA_Server_newWithConfig(const UA_ServerConfig *config) {
     if(!server)
         return NULL;
     server->config = *config;
-    return UA_Server_init(server);
+    return UA_Server_init(server, NULL);
+}
+
+UA_Server *
+UA_Server_newWithNodestoreImage(const UA_ServerConfig *config,
+                                const UA_ByteString *image) {
+    if(!config || !image)
+        return NULL;
+    UA_Server *server = (UA_Server *)UA_calloc(1, sizeof(UA_Server));
+    if(!server)
+        return NULL;
+    server->config = *config;
+    return UA_Server_init(server, image);
 }
 
 /* Returns if the server should be shut down immediately */
@@ -369,11 +413,11 @@ setServerShutdown(UA_Server *server) {
 UA_StatusCode
 UA_Server_addTimedCallback(UA_Server *server, UA_ServerCallback callback,
                            void *data, UA_DateTime date, UA_UInt64 *callbackId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = UA_Timer_addTimedCallback(&server->timer,
                                                      (UA_ApplicationCallback)callback,
                                                       server, data, date, callbackId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -390,9 +434,9 @@ UA_StatusCode
 UA_Server_addRepeatedCallback(UA_Server *server, UA_ServerCallback callback,
                               void *data, UA_Double interval_ms,
                               UA_UInt64 *callbackId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = addRepeatedCallback(server, callback, data, interval_ms, callbackId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -406,9 +450,9 @@ changeRepeatedCallbackInterval(UA_Server *server, UA_UInt64 callbackId,
 UA_StatusCode
 UA_Server_changeRepeatedCallbackInterval(UA_Server *server, UA_UInt64 callbackId,
                                          UA_Double interval_ms) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = changeRepeatedCallbackInterval(server, callbackId, interval_ms);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -419,9 +463,9 @@ removeCallback(UA_Server *server, UA_UInt64 callbackId) {
 
 void
 UA_Server_removeCallback(UA_Server *server, UA_UInt64 callbackId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     removeCallback(server, callbackId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 UA_StatusCode
@@ -440,10 +484,10 @@ UA_Server_updateCertificate(UA_Server *server,
         LIST_FOREACH(current, &server->sessions, pointers) {
             if(UA_ByteString_equal(oldCertificate,
                                     &current->session.header.channel->securityPolicy->localCertificate)) {
-                UA_LOCK(server->serviceMutex);
+                UA_WRLOCK(server->serviceMutex);
                 UA_Server_removeSessionByToken(server, &current->session.header.authenticationToken,
                                                UA_DIAGNOSTICEVENT_CLOSE);
-                UA_UNLOCK(server->serviceMutex);
+                UA_WRUNLOCK(server->serviceMutex);
             }
         }
 
@@ -533,6 +577,18 @@ UA_ServerStatistics UA_Server_getStatistics(UA_Server *server)
  *          single-threaded architecture.
  * Stop: Stop workers, finish all callbacks, stop the network layer, clean up */
 
+#if UA_MULTITHREADING >= 200
+/* The crypto workers call into the SecurityPolicies concurrently */
+static UA_Boolean
+securityPoliciesThreadSafe(UA_Server *server) {
+    for(size_t i = 0; i < server->config.securityPoliciesSize; i++) {
+        if(!server->config.securityPolicies[i].threadSafe)
+            return false;
+    }
+    return true;
+}
+#endif
+
 UA_StatusCode
 UA_Server_run_startup(UA_Server *server) {
 
@@ -615,6 +671,17 @@ UA_Server_run_startup(UA_Server *server) {
     UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
                 "Spinning up %" PRIu16 " worker thread(s)", server->config.nThreads);
     UA_WorkQueue_start(&server->workQueue, server->config.nThreads);
+    if(server->config.nCryptoThreads > 0 && !securityPoliciesThreadSafe(server)) {
+        UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "Not all SecurityPolicies are thread-safe. "
+                       "The handshakes are processed without crypto workers.");
+    } else if(server->config.nCryptoThreads > 0) {
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Spinning up %" PRIu16 " crypto worker thread(s)",
+                    server->config.nCryptoThreads);
+        result |= UA_AsyncManager_startCryptoWorkers(&server->asyncManager, server,
+                                                     server->config.nCryptoThreads);
+    }
 #endif
 
     /* Start the multicast discovery server */
@@ -638,12 +705,31 @@ serverExecuteRepeatedCallback(UA_Server *server, UA_ApplicationCallback cb,
 #endif
 }
 
+#if UA_MULTITHREADING >= 200
+/* The batch is executed as one job of the work queue. The timer skips the
+ * callbacks whose entries were removed before their turn. */
+static void
+serverExecuteRepeatedCallbacks(UA_Server *server, UA_TimerBatch *batch) {
+    UA_WorkQueue_enqueue(&server->workQueue,
+                         (UA_ApplicationCallback)UA_Timer_executeBatch,
+                         &server->timer, batch);
+}
+#endif
+
 UA_UInt16
 UA_Server_run_iterate(UA_Server *server, UA_Boolean waitInternal) {
     /* Process repeated work */
     UA_DateTime now = UA_DateTime_nowMonotonic();
+#if UA_MULTITHREADING >= 200
+    UA_DateTime nextRepeated = UA_Timer_process(&server->timer, now,
+                     (UA_TimerExecutionCallback)serverExecuteRepeatedCallback,
+                     (UA_TimerBatchExecutionCallback)serverExecuteRepeatedCallbacks,
+                     server);
+#else
     UA_DateTime nextRepeated = UA_Timer_process(&server->timer, now,
-                     (UA_TimerExecutionCallback)serverExecuteRepeatedCallback, server);
+                     (UA_TimerExecutionCallback)serverExecuteRepeatedCallback,
+                     NULL, server);
+#endif
     UA_DateTime latest = now + (UA_MAXTIMEOUT * UA_DATETIME_MSEC);
     if(nextRepeated > latest)
         nextRepeated = latest;
@@ -655,6 +741,24 @@ UA_Server_run_iterate(UA_Server *server, UA_Boolean waitInternal) {
     if(waitInternal)
         timeout = (UA_UInt16)(((nextRepeated - now) + (UA_DATETIME_MSEC - 1)) / UA_DATETIME_MSEC);
 
+#if UA_MULTITHREADING >= 200
+    /* Complete the returned crypto and service jobs. The workers interrupt the
+     * waiting in the network layers when a job is returned. Network layers
+     * that cannot be woken up are polled with a short timeout while jobs are
+     * pending. */
+    UA_AsyncManager_processCryptoResults(&server->asyncManager, server);
+    UA_AsyncManager_processServiceResults(&server->asyncManager, server);
+    if((server->asyncManager.cryptoJobsCount > 0 ||
+        server->asyncManager.serviceJobsCount > 0) && timeout > 1) {
+        for(size_t i = 0; i < server->config.networkLayersSize; ++i) {
+            if(!server->config.networkLayers[i].wakeup) {
+                timeout = 1;
+                break;
+            }
+        }
+    }
+#endif
+
     /* Listen on the networklayer */
     for(size_t i = 0; i < server->config.networkLayersSize; ++i) {
         UA_ServerNetworkLayer *nl = &server->config.networkLayers[i];
@@ -698,6 +802,14 @@ UA_Server_run_iterate(UA_Server *server, UA_Boolean waitInternal) {
 
 UA_StatusCode
 UA_Server_run_shutdown(UA_Server *server) {
+#if UA_MULTITHREADING >= 200
+    /* Complete the pending handshakes and requests while the connections are
+     * open */
+    UA_AsyncManager_stopCryptoWorkers(&server->asyncManager, server);
+    while(server->asyncManager.serviceJobsCount > 0)
+        UA_AsyncManager_waitServiceResults(&server->asyncManager, server);
+#endif
+
     /* Stop the netowrk layer */
     for(size_t i = 0; i < server->config.networkLayersSize; ++i) {
         UA_ServerNetworkLayer *nl = &server->config.networkLayers[i];
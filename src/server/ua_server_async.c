@@ -22,9 +22,9 @@ UA_AsyncManager_sendAsyncResponse(UA_AsyncManager *am, UA_Server *server,
                                   UA_AsyncResponse *ar) {
     /* Get the session */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_Session* session = UA_Server_getSessionById(server, &ar->sessionId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     UA_SecureChannel* channel = NULL;
     UA_ResponseHeader *responseHeader = NULL;
     if(!session) {
@@ -150,6 +150,171 @@ checkTimeouts(UA_Server *server, void *_) {
     processAsyncResults(server, NULL);
 }
 
+#if UA_MULTITHREADING >= 200
+
+/***************/
+/* Crypto Jobs */
+/***************/
+
+/* Interrupt the server main loop waiting in the network layers, so that the
+ * returned job is completed right away */
+static void
+wakeupNetworkLayers(UA_Server *server) {
+    for(size_t i = 0; i < server->config.networkLayersSize; i++) {
+        UA_ServerNetworkLayer *nl = &server->config.networkLayers[i];
+        if(nl->wakeup)
+            nl->wakeup(nl);
+    }
+}
+
+/* The workers drain the queue before they stop */
+static void *
+cryptoWorkerLoop(UA_Server *server) {
+    UA_AsyncManager *am = &server->asyncManager;
+    pthread_mutex_lock(&am->cryptoMutex);
+    while(true) {
+        UA_AsyncCryptoJob *job = TAILQ_FIRST(&am->cryptoQueue);
+        if(!job) {
+            if(!am->cryptoRunning)
+                break;
+            pthread_cond_wait(&am->cryptoCondition, &am->cryptoMutex);
+            continue;
+        }
+        TAILQ_REMOVE(&am->cryptoQueue, job, pointers);
+        pthread_mutex_unlock(&am->cryptoMutex);
+        job->run(server, job);
+        pthread_mutex_lock(&am->cryptoMutex);
+        TAILQ_INSERT_TAIL(&am->cryptoResultQueue, job, pointers);
+        pthread_mutex_unlock(&am->cryptoMutex);
+        wakeupNetworkLayers(server);
+        pthread_mutex_lock(&am->cryptoMutex);
+    }
+    pthread_mutex_unlock(&am->cryptoMutex);
+    return NULL;
+}
+
+UA_StatusCode
+UA_AsyncManager_startCryptoWorkers(UA_AsyncManager *am, UA_Server *server,
+                                   size_t workersCount) {
+    if(workersCount == 0 || am->cryptoWorkersSize > 0)
+        return UA_STATUSCODE_GOOD;
+    am->cryptoWorkers = (pthread_t*)UA_calloc(workersCount, sizeof(pthread_t));
+    if(!am->cryptoWorkers)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    am->cryptoRunning = true;
+    for(size_t i = 0; i < workersCount; i++) {
+        if(pthread_create(&am->cryptoWorkers[i], NULL,
+                          (void* (*)(void*))cryptoWorkerLoop, server) != 0)
+            break;
+        am->cryptoWorkersSize++;
+    }
+    if(am->cryptoWorkersSize == workersCount)
+        return UA_STATUSCODE_GOOD;
+    UA_AsyncManager_stopCryptoWorkers(am, server);
+    return UA_STATUSCODE_BADINTERNALERROR;
+}
+
+void
+UA_AsyncManager_stopCryptoWorkers(UA_AsyncManager *am, UA_Server *server) {
+    pthread_mutex_lock(&am->cryptoMutex);
+    am->cryptoRunning = false;
+    pthread_cond_broadcast(&am->cryptoCondition);
+    pthread_mutex_unlock(&am->cryptoMutex);
+    for(size_t i = 0; i < am->cryptoWorkersSize; i++)
+        pthread_join(am->cryptoWorkers[i], NULL);
+    UA_free(am->cryptoWorkers);
+    am->cryptoWorkers = NULL;
+    am->cryptoWorkersSize = 0;
+
+    /* Completing a job can enqueue another one. It is run right away as the
+     * workers are gone. */
+    while(am->cryptoJobsCount > 0)
+        UA_AsyncManager_processCryptoResults(am, server);
+}
+
+void
+UA_AsyncManager_enqueueCryptoJob(UA_AsyncManager *am, UA_Server *server,
+                                 UA_AsyncCryptoJob *job) {
+    am->cryptoJobsCount++;
+    if(am->cryptoWorkersSize == 0)
+        job->run(server, job);
+    pthread_mutex_lock(&am->cryptoMutex);
+    if(am->cryptoWorkersSize == 0) {
+        TAILQ_INSERT_TAIL(&am->cryptoResultQueue, job, pointers);
+    } else {
+        TAILQ_INSERT_TAIL(&am->cryptoQueue, job, pointers);
+        pthread_cond_signal(&am->cryptoCondition);
+    }
+    pthread_mutex_unlock(&am->cryptoMutex);
+}
+
+void
+UA_AsyncManager_processCryptoResults(UA_AsyncManager *am, UA_Server *server) {
+    while(am->cryptoJobsCount > 0) {
+        pthread_mutex_lock(&am->cryptoMutex);
+        UA_AsyncCryptoJob *job = TAILQ_FIRST(&am->cryptoResultQueue);
+        if(job)
+            TAILQ_REMOVE(&am->cryptoResultQueue, job, pointers);
+        pthread_mutex_unlock(&am->cryptoMutex);
+        if(!job)
+            break;
+        am->cryptoJobsCount--;
+        job->complete(server, job);
+    }
+}
+
+/****************/
+/* Service Jobs */
+/****************/
+
+/* Executed in a worker */
+static void
+serviceJobCallback(UA_Server *server, UA_AsyncServiceJob *job) {
+    UA_AsyncManager *am = &server->asyncManager;
+    job->run(server, job);
+    pthread_mutex_lock(&am->serviceJobsMutex);
+    TAILQ_INSERT_TAIL(&am->serviceResultQueue, job, pointers);
+    pthread_cond_signal(&am->serviceJobsCondition);
+    pthread_mutex_unlock(&am->serviceJobsMutex);
+    wakeupNetworkLayers(server);
+}
+
+void
+UA_AsyncManager_enqueueServiceJob(UA_AsyncManager *am, UA_Server *server,
+                                  UA_AsyncServiceJob *job) {
+    UA_assert(server->workQueue.workersSize > 0);
+    am->serviceJobsCount++;
+    UA_WorkQueue_enqueue(&server->workQueue,
+                         (UA_ApplicationCallback)serviceJobCallback, server, job);
+}
+
+void
+UA_AsyncManager_processServiceResults(UA_AsyncManager *am, UA_Server *server) {
+    while(am->serviceJobsCount > 0) {
+        pthread_mutex_lock(&am->serviceJobsMutex);
+        UA_AsyncServiceJob *job = TAILQ_FIRST(&am->serviceResultQueue);
+        if(job)
+            TAILQ_REMOVE(&am->serviceResultQueue, job, pointers);
+        pthread_mutex_unlock(&am->serviceJobsMutex);
+        if(!job)
+            break;
+        am->serviceJobsCount--;
+        job->complete(server, job);
+    }
+}
+
+void
+UA_AsyncManager_waitServiceResults(UA_AsyncManager *am, UA_Server *server) {
+    UA_assert(am->serviceJobsCount > 0);
+    pthread_mutex_lock(&am->serviceJobsMutex);
+    while(TAILQ_EMPTY(&am->serviceResultQueue))
+        pthread_cond_wait(&am->serviceJobsCondition, &am->serviceJobsMutex);
+    pthread_mutex_unlock(&am->serviceJobsMutex);
+    UA_AsyncManager_processServiceResults(am, server);
+}
+
+#endif
+
 void
 UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server) {
     memset(am, 0, sizeof(UA_AsyncManager));
@@ -158,6 +323,15 @@ UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server) {
     TAILQ_INIT(&am->dispatchedQueue);
     TAILQ_INIT(&am->resultQueue);
     UA_LOCK_INIT(am->queueLock);
+#if UA_MULTITHREADING >= 200
+    TAILQ_INIT(&am->cryptoQueue);
+    TAILQ_INIT(&am->cryptoResultQueue);
+    pthread_mutex_init(&am->cryptoMutex, NULL);
+    pthread_cond_init(&am->cryptoCondition, NULL);
+    TAILQ_INIT(&am->serviceResultQueue);
+    pthread_mutex_init(&am->serviceJobsMutex, NULL);
+    pthread_cond_init(&am->serviceJobsCondition, NULL);
+#endif
 
     /* Add a regular callback for cleanup and sending finished responses at a
      * 100s interval. */
@@ -169,6 +343,15 @@ void
 UA_AsyncManager_clear(UA_AsyncManager *am, UA_Server *server) {
     UA_Server_removeCallback(server, am->checkTimeoutCallbackId);
 
+#if UA_MULTITHREADING >= 200
+    UA_AsyncManager_stopCryptoWorkers(am, server);
+    pthread_mutex_destroy(&am->cryptoMutex);
+    pthread_cond_destroy(&am->cryptoCondition);
+    UA_assert(am->serviceJobsCount == 0);
+    pthread_mutex_destroy(&am->serviceJobsMutex);
+    pthread_cond_destroy(&am->serviceJobsCondition);
+#endif
+
     UA_AsyncOperation *ar;
 
     /* Clean up queues */
@@ -19,6 +19,10 @@
 #include "open62541_queue.h"
 #include "ua_util_internal.h"
 
+#if UA_MULTITHREADING >= 200
+#include <pthread.h>
+#endif
+
 _UA_BEGIN_DECLS
 
 #if UA_MULTITHREADING >= 100
@@ -55,6 +59,41 @@ struct UA_AsyncResponse {
 
 typedef TAILQ_HEAD(UA_AsyncOperationQueue, UA_AsyncOperation) UA_AsyncOperationQueue;
 
+#if UA_MULTITHREADING >= 200
+
+/* The asymmetric cryptography of the handshakes (OpenSecureChannel,
+ * ActivateSession) is expensive. It runs in a dedicated pool of crypto workers
+ * so that the thread processing the network is not blocked. Jobs are
+ * typically embedded in a larger structure with the context. */
+struct UA_AsyncCryptoJob;
+typedef struct UA_AsyncCryptoJob UA_AsyncCryptoJob;
+
+typedef void (*UA_AsyncCryptoJobCallback)(UA_Server *server, UA_AsyncCryptoJob *job);
+
+struct UA_AsyncCryptoJob {
+    TAILQ_ENTRY(UA_AsyncCryptoJob) pointers;
+    UA_AsyncCryptoJobCallback run;      /* Executed in a crypto worker */
+    UA_AsyncCryptoJobCallback complete; /* Executed in the server main loop.
+                                         * Frees the job. */
+};
+
+/* The read-only services (Read, Browse, ...) of the client sessions are
+ * processed in the worker threads of the WorkQueue. The response is sent from
+ * the server main loop. */
+struct UA_AsyncServiceJob;
+typedef struct UA_AsyncServiceJob UA_AsyncServiceJob;
+
+typedef void (*UA_AsyncServiceJobCallback)(UA_Server *server, UA_AsyncServiceJob *job);
+
+struct UA_AsyncServiceJob {
+    TAILQ_ENTRY(UA_AsyncServiceJob) pointers;
+    UA_AsyncServiceJobCallback run;      /* Executed in a worker */
+    UA_AsyncServiceJobCallback complete; /* Executed in the server main loop.
+                                          * Frees the job. */
+};
+
+#endif
+
 typedef struct {
     /* Requests / Responses */
     TAILQ_HEAD(, UA_AsyncResponse) asyncResponses;
@@ -71,11 +110,68 @@ typedef struct {
     size_t opsCount; /* How many operations are transient (in one of the three queues)? */
 
     UA_UInt64 checkTimeoutCallbackId; /* Registered repeated callbacks */
+
+#if UA_MULTITHREADING >= 200
+    /* Crypto workers */
+    pthread_t *cryptoWorkers;
+    size_t cryptoWorkersSize;
+    UA_Boolean cryptoRunning;
+    pthread_mutex_t cryptoMutex;  /* Protects the queues and cryptoRunning */
+    pthread_cond_t cryptoCondition; /* Signals new jobs */
+    TAILQ_HEAD(, UA_AsyncCryptoJob) cryptoQueue;
+    TAILQ_HEAD(, UA_AsyncCryptoJob) cryptoResultQueue;
+    size_t cryptoJobsCount; /* Jobs that are not completed. Only accessed from
+                             * the server main loop. */
+
+    /* Service jobs in the WorkQueue */
+    pthread_mutex_t serviceJobsMutex;  /* Protects the result queue */
+    pthread_cond_t serviceJobsCondition; /* Signals returned jobs */
+    TAILQ_HEAD(, UA_AsyncServiceJob) serviceResultQueue;
+    size_t serviceJobsCount; /* Jobs that are not completed. Only accessed from
+                              * the server main loop. */
+#endif
 } UA_AsyncManager;
 
 void UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server);
 void UA_AsyncManager_clear(UA_AsyncManager *am, UA_Server *server);
 
+#if UA_MULTITHREADING >= 200
+
+UA_StatusCode
+UA_AsyncManager_startCryptoWorkers(UA_AsyncManager *am, UA_Server *server,
+                                   size_t workersCount);
+
+/* Stop the workers and complete the remaining jobs in the calling thread */
+void
+UA_AsyncManager_stopCryptoWorkers(UA_AsyncManager *am, UA_Server *server);
+
+/* Without running workers, the job is run in the calling thread. In both
+ * cases it is completed from _processCryptoResults. */
+void
+UA_AsyncManager_enqueueCryptoJob(UA_AsyncManager *am, UA_Server *server,
+                                 UA_AsyncCryptoJob *job);
+
+/* Complete the jobs returned by the workers */
+void
+UA_AsyncManager_processCryptoResults(UA_AsyncManager *am, UA_Server *server);
+
+/* Requires running workers in the WorkQueue. The job is completed from
+ * _processServiceResults. */
+void
+UA_AsyncManager_enqueueServiceJob(UA_AsyncManager *am, UA_Server *server,
+                                  UA_AsyncServiceJob *job);
+
+/* Complete the service jobs returned by the workers */
+void
+UA_AsyncManager_processServiceResults(UA_AsyncManager *am, UA_Server *server);
+
+/* Block until a pending service job is returned and complete the returned
+ * jobs. Must only be called with pending jobs. */
+void
+UA_AsyncManager_waitServiceResults(UA_AsyncManager *am, UA_Server *server);
+
+#endif
+
 UA_StatusCode
 UA_AsyncManager_createAsyncResponse(UA_AsyncManager *am, UA_Server *server,
                                     const UA_NodeId *sessionId,
@@ -480,13 +480,114 @@ getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
 static const UA_String securityPolicyNone =
     UA_STRING_STATIC("http://opcfoundation.org/UA/SecurityPolicy#None");
 
+/* Services that don't modify the information model and can run concurrently
+ * with the service lock held shared */
+static UA_Boolean
+isReadOnlyService(const UA_DataType *requestType) {
+    return (requestType == &UA_TYPES[UA_TYPES_READREQUEST] ||
+            requestType == &UA_TYPES[UA_TYPES_BROWSEREQUEST] ||
+            requestType == &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST]);
+}
+
+#if UA_MULTITHREADING >= 200
+
+/* A read-only request processed in a worker. The decoded request is moved into
+ * the job. The requests of a SecureChannel are processed one after the other.
+ * But the requests of different SecureChannels (sessions) run concurrently. */
+typedef struct {
+    UA_AsyncServiceJob job;
+    UA_SecureChannel *channel;
+    UA_NodeId sessionId;
+    UA_UInt32 requestId;
+    UA_Service service;
+    const UA_DataType *requestType;
+    const UA_DataType *responseType;
+    UA_Request request;
+    UA_Response response;
+} ReadOnlyServiceJob;
+
+/* Executed in a worker. The session is looked up again as it might have been
+ * removed in the meantime. */
+static void
+runReadOnlyServiceJob(UA_Server *server, UA_AsyncServiceJob *job) {
+    ReadOnlyServiceJob *rj = (ReadOnlyServiceJob*)job;
+    UA_RDLOCK(server->serviceMutex);
+    UA_Session *session = UA_Server_getSessionById(server, &rj->sessionId);
+    if(session)
+        rj->service(server, session, &rj->request, &rj->response);
+    else
+        rj->response.responseHeader.serviceResult = UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_RDUNLOCK(server->serviceMutex);
+}
+
+/* Executed in the server main loop */
+static void
+completeReadOnlyServiceJob(UA_Server *server, UA_AsyncServiceJob *job) {
+    ReadOnlyServiceJob *rj = (ReadOnlyServiceJob*)job;
+    if(UA_Server_endServiceJob(server, rj->channel))
+        sendResponse(server, NULL, rj->channel, rj->requestId,
+                     &rj->response, rj->responseType);
+    UA_NodeId_clear(&rj->sessionId);
+    UA_clear(&rj->request, rj->requestType);
+    UA_clear(&rj->response, rj->responseType);
+    UA_free(rj);
+}
+
+/* Returns false if the request could not be moved to a worker. Then it is
+ * processed right away. */
+static UA_Boolean
+dispatchReadOnlyService(UA_Server *server, UA_Session *session,
+                        UA_SecureChannel *channel, UA_UInt32 requestId,
+                        UA_Service service, UA_Request *request,
+                        const UA_DataType *requestType, UA_Response *response,
+                        const UA_DataType *responseType) {
+    if(server->workQueue.workersSize == 0)
+        return false;
+    ReadOnlyServiceJob *rj = (ReadOnlyServiceJob*)
+        UA_malloc(sizeof(ReadOnlyServiceJob));
+    if(!rj)
+        return false;
+    if(UA_NodeId_copy(&session->sessionId, &rj->sessionId) != UA_STATUSCODE_GOOD) {
+        UA_free(rj);
+        return false;
+    }
+    rj->job.run = runReadOnlyServiceJob;
+    rj->job.complete = completeReadOnlyServiceJob;
+    rj->channel = channel;
+    rj->requestId = requestId;
+    rj->service = service;
+    rj->requestType = requestType;
+    rj->responseType = responseType;
+    memcpy(&rj->request, request, requestType->memSize);
+    memcpy(&rj->response, response, responseType->memSize);
+    UA_init(request, requestType);
+    UA_init(response, responseType);
+    UA_Server_beginServiceJob(server, channel);
+    UA_AsyncManager_enqueueServiceJob(&server->asyncManager, server, &rj->job);
+    return true;
+}
+
+/* Wait until the request of the SecureChannel in a worker is completed */
+static void
+waitServiceJob(UA_Server *server, UA_SecureChannel *channel) {
+    while(UA_Server_hasServiceJob(channel))
+        UA_AsyncManager_waitServiceResults(&server->asyncManager, server);
+}
+
+#endif
+
 static UA_StatusCode
 processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
-                  UA_Service service, const UA_Request *request,
+                  UA_Service service, UA_Request *request,
                   const UA_DataType *requestType, UA_Response *response,
                   const UA_DataType *responseType, UA_Boolean sessionRequired) {
     const UA_RequestHeader *requestHeader = &request->requestHeader;
 
+#if UA_MULTITHREADING >= 200
+    /* Complete the previous request of the SecureChannel first */
+    waitServiceJob(server, channel);
+#endif
+
     /* If it is an unencrypted (#None) channel, only allow the discovery services */
     if(server->config.securityPolicyNoneDiscoveryOnly &&
        UA_String_equal(&channel->securityPolicy->policyUri, &securityPolicyNone ) &&
@@ -500,13 +601,29 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
                                 responseType, UA_STATUSCODE_BADSECURITYPOLICYREJECTED);
     }
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* ActivateSession might not be answered immediately */
+    if(requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST] &&
+       server->asyncManager.cryptoWorkersSize > 0) {
+        UA_Boolean finished = true;
+        UA_WRLOCK(server->serviceMutex);
+        Service_ActivateSessionAsync(server, channel, requestId,
+                                     &request->activateSessionRequest,
+                                     &response->activateSessionResponse, &finished);
+        UA_WRUNLOCK(server->serviceMutex);
+        if(!finished)
+            return UA_STATUSCODE_GOOD;
+        return sendResponse(server, NULL, channel, requestId, response, responseType);
+    }
+#endif
+
     /* Session lifecycle services. */
     if(requestType == &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST] ||
        requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST] ||
        requestType == &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST]) {
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         ((UA_ChannelService)(uintptr_t)service)(server, channel, request, response);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
         /* Store the authentication token so we can help fuzzing by setting
          * these values in the next request automatically */
@@ -565,10 +682,10 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
                                requestType->binaryEncodingId);
 #endif
         if(session != &anonymousSession) {
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             UA_Server_removeSessionByToken(server, &session->header.authenticationToken,
                                            UA_DIAGNOSTICEVENT_ABORT);
-            UA_UNLOCK(server->serviceMutex);
+            UA_WRUNLOCK(server->serviceMutex);
         }
         return sendServiceFault(channel, requestId, requestHeader->requestHandle,
                                 responseType, UA_STATUSCODE_BADSESSIONNOTACTIVATED);
@@ -580,9 +697,9 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The publish request is not answered immediately */
     if(requestType == &UA_TYPES[UA_TYPES_PUBLISHREQUEST]) {
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         Service_Publish(server, session, &request->publishRequest, requestId);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_GOOD;
     }
 #endif
@@ -591,10 +708,10 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
     /* The call request might not be answered immediately */
     if(requestType == &UA_TYPES[UA_TYPES_CALLREQUEST]) {
         UA_Boolean finished = true;
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         Service_CallAsync(server, session, requestId, &request->callRequest,
                           &response->callResponse, &finished);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
 
         /* Async method calls remain. Don't send a response now */
         if(!finished)
@@ -605,10 +722,26 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
     }
 #endif
 
-    /* Dispatch the synchronous service call and send the response */
-    UA_LOCK(server->serviceMutex);
-    service(server, session, request, response);
-    UA_UNLOCK(server->serviceMutex);
+    /* Dispatch the synchronous service call and send the response. The
+     * read-only services share the service lock. With worker threads, they are
+     * processed in a worker and the response is sent once the job returns to
+     * the main loop. So the requests of different sessions run concurrently
+     * with each other and with the local API of other threads. */
+    if(isReadOnlyService(requestType)) {
+#if UA_MULTITHREADING >= 200
+        if(session != &anonymousSession &&
+           dispatchReadOnlyService(server, session, channel, requestId, service,
+                                   request, requestType, response, responseType))
+            return UA_STATUSCODE_GOOD;
+#endif
+        UA_RDLOCK(server->serviceMutex);
+        service(server, session, request, response);
+        UA_RDUNLOCK(server->serviceMutex);
+    } else {
+        UA_WRLOCK(server->serviceMutex);
+        service(server, session, request, response);
+        UA_WRUNLOCK(server->serviceMutex);
+    }
     return sendResponse(server, session, channel, requestId, response, responseType);
 }
 
@@ -763,6 +896,79 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
     return retval;
 }
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+typedef struct {
+    UA_AsyncCryptoJob job;
+    UA_SecureChannel *channel;
+} AsymmetricChannelJob;
+
+static void
+runAsymmetricChannelJob(UA_Server *server, UA_AsyncCryptoJob *job) {
+    UA_SecureChannel_runAsymmetricJob(((AsymmetricChannelJob*)job)->channel);
+}
+
+/* Send an ERR message and close the connection */
+static void
+abortSecureChannel(UA_Server *server, UA_SecureChannel *channel, UA_StatusCode res) {
+    UA_Connection *connection = channel->connection;
+    if(!connection)
+        return;
+    UA_LOG_INFO_CHANNEL(&server->config.logger, channel,
+                        "Processing the message failed with error %s",
+                        UA_StatusCode_name(res));
+    UA_TcpErrorMessage error;
+    error.error = res;
+    error.reason = UA_STRING_NULL;
+    UA_Connection_sendError(connection, &error);
+    connection->close(connection);
+}
+
+static void
+completeAsymmetricChannelJob(UA_Server *server, UA_AsyncCryptoJob *job) {
+    UA_SecureChannel *channel = ((AsymmetricChannelJob*)job)->channel;
+    UA_free(job);
+
+    UA_WRLOCK(server->serviceMutex);
+    UA_Boolean alive = UA_Server_releaseSecureChannel(server, channel);
+    UA_WRUNLOCK(server->serviceMutex);
+    if(!alive)
+        return;
+
+    UA_StatusCode res =
+        UA_SecureChannel_completeAsymmetricJob(channel, server, processSecureChannelMessage);
+    if(res != UA_STATUSCODE_GOOD)
+        abortSecureChannel(server, channel, res);
+}
+
+UA_StatusCode
+UA_Server_offloadAsymmetricJob(void *application, UA_SecureChannel *channel) {
+    UA_Server *server = (UA_Server*)application;
+    AsymmetricChannelJob *job = (AsymmetricChannelJob*)
+        UA_malloc(sizeof(AsymmetricChannelJob));
+    if(!job)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    job->job.run = runAsymmetricChannelJob;
+    job->job.complete = completeAsymmetricChannelJob;
+    job->channel = channel;
+
+    UA_WRLOCK(server->serviceMutex);
+    UA_Server_holdSecureChannel(server, channel);
+    UA_WRUNLOCK(server->serviceMutex);
+    UA_AsyncManager_enqueueCryptoJob(&server->asyncManager, server, &job->job);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Server_resumeSecureChannel(UA_Server *server, UA_SecureChannel *channel) {
+    UA_StatusCode res =
+        UA_SecureChannel_resume(channel, server, processSecureChannelMessage);
+    if(res != UA_STATUSCODE_GOOD)
+        abortSecureChannel(server, channel, res);
+}
+
+#endif
+
 void
 UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
                                UA_ByteString *message) {
@@ -775,7 +981,9 @@ UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
 
     /* Add a SecureChannel to a new connection */
     if(!channel) {
+        UA_WRLOCK(server->serviceMutex);
         retval = UA_Server_createSecureChannel(server, connection);
+        UA_WRUNLOCK(server->serviceMutex);
         if(retval != UA_STATUSCODE_GOOD)
             goto error;
         channel = connection->channel;
@@ -816,7 +1024,13 @@ deleteConnection(UA_Server *server, UA_Connection *connection) {
 
 void
 UA_Server_removeConnection(UA_Server *server, UA_Connection *connection) {
+    /* The SecureChannels are cleaned up with the service lock. In a worker
+     * thread if multithreading is enabled. */
+    UA_WRLOCK(server->serviceMutex);
+    if(connection->channel)
+        UA_Server_markSecureChannelForCleanup(server, connection->channel);
     UA_Connection_detachSecureChannel(connection);
+    UA_WRUNLOCK(server->serviceMutex);
 #if UA_MULTITHREADING >= 200
     UA_DelayedCallback *dc = (UA_DelayedCallback*)UA_malloc(sizeof(UA_DelayedCallback));
     if(!dc)
@@ -0,0 +1,566 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+#include "ua_types_encoding_binary.h"
+
+/* The image is a sequence of values in the binary encoding:
+ *
+ * - Magic number and version
+ * - The namespace array
+ * - The ReferenceTypeNodes ordered by their ReferenceTypeIndex
+ * - All other nodes
+ *
+ * Every node starts with the NodeClass and the attributes of the node head.
+ * The references follow grouped by their ReferenceKind. Then the attributes
+ * specific to the NodeClass. The members of the nodes that are pointers
+ * (contexts and callbacks) are not saved. Neither is the threadSafe flag of
+ * VariableNodes, as it describes the callbacks. The async flag of MethodNodes
+ * is saved in every build so that the format does not depend on
+ * UA_MULTITHREADING. */
+
+#define UA_NODESTOREIMAGE_MAGIC 0x494E4155 /* "UANI" */
+#define UA_NODESTOREIMAGE_VERSION 2
+
+/**********/
+/* Saving */
+/**********/
+
+typedef struct {
+    UA_ByteString buf;
+    size_t length; /* Used part of the buffer */
+    UA_StatusCode retval; /* The first error stops the encoding */
+    UA_UInt32 nodesSize;
+} ImageWriter;
+
+static void
+writeField(ImageWriter *w, const void *p, const UA_DataType *type) {
+    if(w->retval != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Grow the buffer */
+    size_t size = UA_calcSizeBinary(p, type);
+    if(size == 0) {
+        w->retval = UA_STATUSCODE_BADENCODINGERROR;
+        return;
+    }
+    if(w->length + size > w->buf.length) {
+        size_t newLength = (w->buf.length > 0) ? w->buf.length * 2 : 65536;
+        while(newLength < w->length + size)
+            newLength *= 2;
+        UA_Byte *data = (UA_Byte*)UA_realloc(w->buf.data, newLength);
+        if(!data) {
+            w->retval = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        w->buf.data = data;
+        w->buf.length = newLength;
+    }
+
+    UA_Byte *pos = &w->buf.data[w->length];
+    const UA_Byte *end = &w->buf.data[w->buf.length];
+    w->retval = UA_encodeBinary(p, type, &pos, &end, NULL, NULL);
+    w->length = (size_t)(pos - w->buf.data);
+}
+
+static void
+writeUInt32(ImageWriter *w, UA_UInt32 v) {
+    writeField(w, &v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+writeReferences(ImageWriter *w, const UA_NodeHead *head) {
+    writeUInt32(w, (UA_UInt32)head->referencesSize);
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &head->references[i];
+        UA_Boolean isForward = !rk->isInverse;
+        writeField(w, &rk->referenceTypeIndex, &UA_TYPES[UA_TYPES_BYTE]);
+        writeField(w, &isForward, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+        /* Count the targets. Then write them in the order of the queue. */
+        UA_UInt32 targetsSize = 0;
+        const UA_ReferenceTarget *target;
+        for(target = rk->queueHead.tqh_first; target;
+            target = target->queuePointers.tqe_next)
+            targetsSize++;
+        writeUInt32(w, targetsSize);
+        for(target = rk->queueHead.tqh_first; target;
+            target = target->queuePointers.tqe_next) {
+            writeField(w, &target->targetId, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+            writeField(w, &target->targetNameHash, &UA_TYPES[UA_TYPES_UINT32]);
+        }
+    }
+}
+
+/* The value is only saved if it is stored in the node. Variables with a
+ * DataSource or an external value are saved with an empty value. */
+static void
+writeVariableAttributes(ImageWriter *w, const UA_VariableNode *vn) {
+    writeField(w, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    writeField(w, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+    writeUInt32(w, (UA_UInt32)vn->arrayDimensionsSize);
+    for(size_t i = 0; i < vn->arrayDimensionsSize; i++)
+        writeUInt32(w, vn->arrayDimensions[i]);
+
+    UA_DataValue empty;
+    UA_DataValue_init(&empty);
+    const UA_DataValue *value = &empty;
+    if(vn->valueSource == UA_VALUESOURCE_DATA &&
+       (vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE ||
+        vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_INTERNAL))
+        value = &vn->value.data.value;
+    writeField(w, value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static void
+writeImageNode(ImageWriter *w, const UA_Node *node) {
+    const UA_NodeHead *head = &node->head;
+    writeUInt32(w, (UA_UInt32)head->nodeClass);
+    writeField(w, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    writeField(w, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    writeField(w, &head->displayName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    writeField(w, &head->description, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    writeField(w, &head->writeMask, &UA_TYPES[UA_TYPES_UINT32]);
+    writeField(w, &head->constructed, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    writeReferences(w, head);
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        const UA_VariableNode *vn = &node->variableNode;
+        writeVariableAttributes(w, vn);
+        writeField(w, &vn->accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        writeField(w, &vn->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeField(w, &vn->historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        writeVariableAttributes(w, (const UA_VariableNode*)node);
+        writeField(w, &node->variableTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD: {
+        UA_Boolean async = false;
+#if UA_MULTITHREADING >= 100
+        async = node->methodNode.async;
+#endif
+        writeField(w, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeField(w, &async, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    }
+    case UA_NODECLASS_OBJECT:
+        writeField(w, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        writeField(w, &node->objectTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE: {
+        const UA_ReferenceTypeNode *rn = &node->referenceTypeNode;
+        writeField(w, &rn->isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeField(w, &rn->symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeField(w, &rn->inverseName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        writeField(w, &rn->referenceTypeIndex, &UA_TYPES[UA_TYPES_BYTE]);
+        for(size_t i = 0; i < UA_REFERENCETYPESET_MAX / 32; i++)
+            writeUInt32(w, rn->subTypes.bits[i]);
+        break;
+    }
+    case UA_NODECLASS_DATATYPE:
+        writeField(w, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        writeField(w, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        writeField(w, &node->viewNode.containsNoLoops, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        w->retval = UA_STATUSCODE_BADINTERNALERROR;
+        break;
+    }
+}
+
+/* The ReferenceTypeNodes were already written in the order of their index */
+static void
+writeImageNodeVisitor(void *context, const UA_Node *node) {
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        return;
+    ImageWriter *w = (ImageWriter*)context;
+    writeImageNode(w, node);
+    w->nodesSize++;
+}
+
+static UA_StatusCode
+saveNodestoreImage(UA_Server *server, UA_ByteString *image) {
+    ImageWriter w;
+    memset(&w, 0, sizeof(ImageWriter));
+    writeUInt32(&w, UA_NODESTOREIMAGE_MAGIC);
+    writeUInt32(&w, UA_NODESTOREIMAGE_VERSION);
+
+    /* Namespaces */
+    writeUInt32(&w, (UA_UInt32)server->namespacesSize);
+    for(size_t i = 0; i < server->namespacesSize; i++)
+        writeField(&w, &server->namespaces[i], &UA_TYPES[UA_TYPES_STRING]);
+
+    /* ReferenceTypes. They get their index when they are inserted into the
+     * Nodestore. So they are restored first and in order. */
+    const UA_NodeId *refTypeIds[UA_REFERENCETYPESET_MAX];
+    UA_UInt32 refTypesSize = 0;
+    for(; refTypesSize < UA_REFERENCETYPESET_MAX; refTypesSize++) {
+        refTypeIds[refTypesSize] =
+            UA_NODESTORE_GETREFERENCETYPEID(server, (UA_Byte)refTypesSize);
+        if(!refTypeIds[refTypesSize] || UA_NodeId_isNull(refTypeIds[refTypesSize]))
+            break;
+    }
+    writeUInt32(&w, refTypesSize);
+    for(size_t i = 0; i < refTypesSize; i++) {
+        const UA_Node *node = UA_NODESTORE_GET(server, refTypeIds[i]);
+        if(!node) {
+            w.retval = UA_STATUSCODE_BADINTERNALERROR;
+            break;
+        }
+        writeImageNode(&w, node);
+        UA_NODESTORE_RELEASE(server, node);
+    }
+
+    /* All other nodes. The number of nodes is known afterwards. */
+    size_t nodesSizePos = w.length;
+    writeUInt32(&w, 0);
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     writeImageNodeVisitor, &w);
+    if(w.retval == UA_STATUSCODE_GOOD) {
+        UA_Byte *pos = &w.buf.data[nodesSizePos];
+        const UA_Byte *end = &w.buf.data[w.length];
+        w.retval = UA_encodeBinary(&w.nodesSize, &UA_TYPES[UA_TYPES_UINT32],
+                                   &pos, &end, NULL, NULL);
+    }
+
+    if(w.retval != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&w.buf);
+        return w.retval;
+    }
+
+    /* Shrink the buffer to the used length */
+    UA_Byte *data = (UA_Byte*)UA_realloc(w.buf.data, w.length);
+    if(data)
+        w.buf.data = data;
+    image->data = w.buf.data;
+    image->length = w.length;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_saveNodestoreImage(UA_Server *server, UA_ByteString *image) {
+    UA_RDLOCK(server->serviceMutex);
+    UA_StatusCode retval = saveNodestoreImage(server, image);
+    UA_RDUNLOCK(server->serviceMutex);
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Saved the nodestore image with %lu bytes",
+                    (long unsigned)image->length);
+    return retval;
+}
+
+/***********/
+/* Loading */
+/***********/
+
+typedef struct {
+    const UA_ByteString *image;
+    size_t offset;
+    const UA_DataTypeArray *customTypes;
+    UA_UInt32 refTypesSize;
+} ImageReader;
+
+static UA_StatusCode
+readField(ImageReader *r, void *p, const UA_DataType *type) {
+    return UA_decodeBinary(r->image, &r->offset, p, type, r->customTypes);
+}
+
+static UA_StatusCode
+readUInt32(ImageReader *r, UA_UInt32 *v) {
+    return readField(r, v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static UA_StatusCode
+readReferences(ImageReader *r, UA_Node *node) {
+    UA_UInt32 kindsSize = 0;
+    UA_StatusCode retval = readUInt32(r, &kindsSize);
+    for(UA_UInt32 i = 0; i < kindsSize && retval == UA_STATUSCODE_GOOD; i++) {
+        UA_Byte refTypeIndex = 0;
+        UA_Boolean isForward = false;
+        UA_UInt32 targetsSize = 0;
+        retval |= readField(r, &refTypeIndex, &UA_TYPES[UA_TYPES_BYTE]);
+        retval |= readField(r, &isForward, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= readUInt32(r, &targetsSize);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
+        if(refTypeIndex >= r->refTypesSize || targetsSize == 0)
+            return UA_STATUSCODE_BADDECODINGERROR;
+
+        for(UA_UInt32 j = 0; j < targetsSize; j++) {
+            UA_ExpandedNodeId targetId;
+            UA_UInt32 targetNameHash = 0;
+            retval = readField(r, &targetId, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+            if(retval != UA_STATUSCODE_GOOD)
+                break;
+            retval = readUInt32(r, &targetNameHash);
+            if(retval == UA_STATUSCODE_GOOD)
+                retval = UA_Node_appendReference(node, refTypeIndex, isForward,
+                                                 &targetId, targetNameHash);
+            UA_ExpandedNodeId_clear(&targetId);
+            if(retval != UA_STATUSCODE_GOOD)
+                break;
+        }
+    }
+    return retval;
+}
+
+static UA_StatusCode
+readVariableAttributes(ImageReader *r, UA_VariableNode *vn) {
+    UA_UInt32 arrayDimensionsSize = 0;
+    UA_StatusCode retval = readField(r, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    retval |= readField(r, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+    retval |= readUInt32(r, &arrayDimensionsSize);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(arrayDimensionsSize > 0) {
+        if(arrayDimensionsSize > r->image->length - r->offset)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        vn->arrayDimensions = (UA_UInt32*)
+            UA_Array_new(arrayDimensionsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(!vn->arrayDimensions)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        vn->arrayDimensionsSize = arrayDimensionsSize;
+        for(size_t i = 0; i < arrayDimensionsSize; i++)
+            retval |= readUInt32(r, &vn->arrayDimensions[i]);
+    }
+
+    /* The value is stored in the node. Large arrays are shared between the
+     * reads (see copyNodeValue). */
+    vn->valueSource = UA_VALUESOURCE_DATA;
+    retval |= readField(r, &vn->value.data.value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    UA_Variant *v = &vn->value.data.value.value;
+    if(retval == UA_STATUSCODE_GOOD && v->type && !UA_Variant_isScalar(v)) {
+        UA_Variant shared;
+        retval = copyNodeValue(v, &shared);
+        if(retval == UA_STATUSCODE_GOOD) {
+            UA_Variant_clear(v);
+            *v = shared;
+        }
+    }
+    return retval;
+}
+
+/* Decode a node into a new node from the Nodestore */
+static UA_StatusCode
+readImageNode(UA_Server *server, ImageReader *r, UA_Node **outNode) {
+    UA_UInt32 nodeClass = 0;
+    UA_StatusCode retval = readUInt32(r, &nodeClass);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT: case UA_NODECLASS_VARIABLE:
+    case UA_NODECLASS_METHOD: case UA_NODECLASS_OBJECTTYPE:
+    case UA_NODECLASS_VARIABLETYPE: case UA_NODECLASS_REFERENCETYPE:
+    case UA_NODECLASS_DATATYPE: case UA_NODECLASS_VIEW:
+        break;
+    default:
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
+    UA_Node *node = UA_NODESTORE_NEW(server, (UA_NodeClass)nodeClass);
+    if(!node)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_NodeHead *head = &node->head;
+    retval |= readField(r, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    retval |= readField(r, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    retval |= readField(r, &head->displayName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    retval |= readField(r, &head->description, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    retval |= readField(r, &head->writeMask, &UA_TYPES[UA_TYPES_UINT32]);
+    retval |= readField(r, &head->constructed, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = readReferences(r, node);
+    if(retval != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        UA_VariableNode *vn = &node->variableNode;
+        retval |= readVariableAttributes(r, vn);
+        retval |= readField(r, &vn->accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        retval |= readField(r, &vn->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+        retval |= readField(r, &vn->historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        retval |= readVariableAttributes(r, (UA_VariableNode*)node);
+        retval |= readField(r, &node->variableTypeNode.isAbstract,
+                            &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD: {
+        UA_Boolean async = false;
+        retval |= readField(r, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= readField(r, &async, &UA_TYPES[UA_TYPES_BOOLEAN]);
+#if UA_MULTITHREADING >= 100
+        node->methodNode.async = async;
+#else
+        /* The async methods cannot be called in this build */
+        if(async && retval == UA_STATUSCODE_GOOD)
+            retval = UA_STATUSCODE_BADNOTSUPPORTED;
+#endif
+        break;
+    }
+    case UA_NODECLASS_OBJECT:
+        retval |= readField(r, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        retval |= readField(r, &node->objectTypeNode.isAbstract,
+                            &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE: {
+        UA_ReferenceTypeNode *rn = &node->referenceTypeNode;
+        retval |= readField(r, &rn->isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= readField(r, &rn->symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= readField(r, &rn->inverseName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        retval |= readField(r, &rn->referenceTypeIndex, &UA_TYPES[UA_TYPES_BYTE]);
+        for(size_t i = 0; i < UA_REFERENCETYPESET_MAX / 32; i++)
+            retval |= readUInt32(r, &rn->subTypes.bits[i]);
+        break;
+    }
+    case UA_NODECLASS_DATATYPE:
+        retval |= readField(r, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        retval |= readField(r, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        retval |= readField(r, &node->viewNode.containsNoLoops,
+                            &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        break;
+    }
+
+ cleanup:
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return retval;
+    }
+    *outNode = node;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+setSubTypes(UA_Server *server, UA_Session *session,
+            UA_ReferenceTypeNode *node, const UA_ReferenceTypeSet *subTypes) {
+    node->subTypes = *subTypes;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+loadReferenceTypes(UA_Server *server, ImageReader *r) {
+    UA_StatusCode retval = readUInt32(r, &r->refTypesSize);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(r->refTypesSize > UA_REFERENCETYPESET_MAX)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* The Nodestore assigns the ReferenceTypeIndex when the node is inserted
+     * and resets the set of subtypes. The nodes are inserted in the order of
+     * their index. */
+    UA_ReferenceTypeSet subTypes[UA_REFERENCETYPESET_MAX];
+    for(UA_UInt32 i = 0; i < r->refTypesSize; i++) {
+        UA_Node *node = NULL;
+        retval = readImageNode(server, r, &node);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        if(node->head.nodeClass != UA_NODECLASS_REFERENCETYPE ||
+           node->referenceTypeNode.referenceTypeIndex != i) {
+            UA_NODESTORE_DELETE(server, node);
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        subTypes[i] = node->referenceTypeNode.subTypes;
+        retval = UA_NODESTORE_INSERT(server, node, NULL);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    for(UA_UInt32 i = 0; i < r->refTypesSize; i++) {
+        const UA_NodeId *refTypeId = UA_NODESTORE_GETREFERENCETYPEID(server, (UA_Byte)i);
+        if(!refTypeId)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        retval = UA_Server_editNode(server, &server->adminSession, refTypeId,
+                                    (UA_EditNodeCallback)setSubTypes, &subTypes[i]);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+loadNodes(UA_Server *server, const UA_ByteString *image) {
+    ImageReader r;
+    memset(&r, 0, sizeof(ImageReader));
+    r.image = image;
+    r.customTypes = server->config.customDataTypes;
+
+    UA_UInt32 magic = 0, version = 0;
+    UA_StatusCode retval = readUInt32(&r, &magic);
+    retval |= readUInt32(&r, &version);
+    if(retval != UA_STATUSCODE_GOOD || magic != UA_NODESTOREIMAGE_MAGIC)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    if(version != UA_NODESTOREIMAGE_VERSION)
+        return UA_STATUSCODE_BADDATAENCODINGUNSUPPORTED;
+
+    /* Namespaces. The first two are set up by the server. */
+    UA_UInt32 namespacesSize = 0;
+    retval = readUInt32(&r, &namespacesSize);
+    for(UA_UInt32 i = 0; i < namespacesSize && retval == UA_STATUSCODE_GOOD; i++) {
+        UA_String ns;
+        retval = readField(&r, &ns, &UA_TYPES[UA_TYPES_STRING]);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
+        if((i == 0 && !UA_String_equal(&ns, &server->namespaces[0])) ||
+           (i > 1 && addNamespace(server, ns) != i))
+            retval = UA_STATUSCODE_BADDECODINGERROR;
+        UA_String_clear(&ns);
+    }
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    retval = loadReferenceTypes(server, &r);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* The nodes contain the references in both directions. So they are
+     * inserted without further checks. */
+    UA_UInt32 nodesSize = 0;
+    retval = readUInt32(&r, &nodesSize);
+    for(UA_UInt32 i = 0; i < nodesSize && retval == UA_STATUSCODE_GOOD; i++) {
+        UA_Node *node = NULL;
+        retval = readImageNode(server, &r, &node);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = UA_NODESTORE_INSERT(server, node, NULL);
+    }
+    if(retval == UA_STATUSCODE_GOOD && r.offset != image->length)
+        retval = UA_STATUSCODE_BADDECODINGERROR;
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_loadNodestoreImage(UA_Server *server, const UA_ByteString *image) {
+    UA_StatusCode retval = loadNodes(server, image);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                     "Loading the nodestore image failed with %s",
+                     UA_StatusCode_name(retval));
+        return retval;
+    }
+
+    retval = UA_Server_initNS0Callbacks(server);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                     "Setting the callbacks of Namespace 0 after loading the "
+                     "nodestore image failed with %s",
+                     UA_StatusCode_name(retval));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
@@ -68,15 +68,70 @@ typedef enum {
 typedef struct channel_entry {
     UA_DelayedCallback cleanupCallback;
     TAILQ_ENTRY(channel_entry) pointers;
+    ZIP_ENTRY(channel_entry) timeoutFields;
+    UA_DateTime timeout; /* Next check in the cleanup. Updated lazily when the
+                          * SecurityToken is renewed. */
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    UA_Boolean held; /* Used by a crypto job. Not deleted until released. */
+#endif
+#if UA_MULTITHREADING >= 200
+    UA_Boolean serviceJob; /* A request is processed in a worker. Not deleted
+                            * before the job is completed. */
+#endif
     UA_SecureChannel channel;
 } channel_entry;
 
+ZIP_HEAD(UA_ChannelTimeoutTree, channel_entry);
+typedef struct UA_ChannelTimeoutTree UA_ChannelTimeoutTree;
+
+/* Sessions are indexed by the hash of the AuthenticationToken and the
+ * SessionId. The identifier points into the session. */
+typedef struct {
+    UA_UInt32 hash;
+    const UA_NodeId *id;
+} UA_SessionKey;
+
 typedef struct session_list_entry {
     UA_DelayedCallback cleanupCallback;
     LIST_ENTRY(session_list_entry) pointers;
+    ZIP_ENTRY(session_list_entry) tokenFields;
+    UA_SessionKey tokenKey;
+    ZIP_ENTRY(session_list_entry) idFields;
+    UA_SessionKey idKey;
+    ZIP_ENTRY(session_list_entry) timeoutFields;
+    UA_DateTime timeout; /* Next check in the cleanup. Updated lazily when the
+                          * lifetime of the session is extended. */
     UA_Session session;
 } session_list_entry;
 
+ZIP_HEAD(UA_SessionTokenTree, session_list_entry);
+typedef struct UA_SessionTokenTree UA_SessionTokenTree;
+ZIP_HEAD(UA_SessionIdTree, session_list_entry);
+typedef struct UA_SessionIdTree UA_SessionIdTree;
+ZIP_HEAD(UA_SessionTimeoutTree, session_list_entry);
+typedef struct UA_SessionTimeoutTree UA_SessionTimeoutTree;
+
+/* The children of a type (or of an instance declaration below a type) that are
+ * copied during the instantiation. They are browsed once and cached until the
+ * declarations change. See ua_services_nodemanagement.c. */
+typedef struct UA_InstantiationPlan {
+    ZIP_ENTRY(UA_InstantiationPlan) zipfields;
+    UA_NodeId nodeId;
+    size_t refCount; /* The tree and the running instantiations. The service
+                      * lock is released during the lifecycle callbacks. */
+    UA_Boolean childrenResolved;
+    size_t childrenSize;
+    UA_ReferenceDescription *children; /* Objects, Variables and Methods
+                                        * referenced with Aggregates */
+    UA_Boolean *mandatory; /* ModellingRule of the children */
+    UA_Boolean hierarchyResolved;
+    size_t hierarchySize;
+    UA_NodeId *hierarchy; /* The type with its supertypes and interfaces */
+} UA_InstantiationPlan;
+
+ZIP_HEAD(UA_InstantiationPlanTree, UA_InstantiationPlan);
+typedef struct UA_InstantiationPlanTree UA_InstantiationPlanTree;
+
 typedef enum {
     UA_SERVERLIFECYCLE_FRESH,
     UA_SERVERLIFECYLE_RUNNING
@@ -93,6 +148,7 @@ struct UA_Server {
 
     /* SecureChannels */
     TAILQ_HEAD(, channel_entry) channels;
+    UA_ChannelTimeoutTree channelsByTimeout;
     UA_UInt32 lastChannelId;
     UA_UInt32 lastTokenId;
 
@@ -102,6 +158,9 @@ struct UA_Server {
 
     /* Session Management */
     LIST_HEAD(session_list, session_list_entry) sessions;
+    UA_SessionTokenTree sessionsByToken;
+    UA_SessionIdTree sessionsById;
+    UA_SessionTimeoutTree sessionsByTimeout;
     UA_UInt32 sessionCount;
     UA_Session adminSession; /* Local access to the services (for startup and
                               * maintenance) uses this Session with all possible
@@ -121,6 +180,9 @@ struct UA_Server {
      * the parent and member instantiation */
     UA_Boolean bootstrapNS0;
 
+    /* Cached children of the types that are instantiated */
+    UA_InstantiationPlanTree instantiationPlans;
+
     /* Discovery */
 #ifdef UA_ENABLE_DISCOVERY
     UA_DiscoveryManager discoveryManager;
@@ -134,6 +196,15 @@ struct UA_Server {
     /* To be cast to UA_LocalMonitoredItem to get the callback and context */
     LIST_HEAD(LocalMonitoredItems, UA_MonitoredItem) localMonitoredItems;
     UA_UInt32 lastLocalMonitoredItemId;
+    UA_SamplerTree samplers; /* Shared between the DataChange MonitoredItems */
+    size_t samplersOnWrite; /* Number of samplers that are not polled */
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_EventFilterTree eventFilters; /* Shared between the Event MonitoredItems */
+    UA_UInt64 eventCounter; /* Identifies the event for the cached filter results */
+    UA_EventSourceTree eventSources; /* Cached propagation of the events */
+    UA_UInt64 eventSourcesVersion; /* Incremented when cached sources are deleted */
+    UA_ReferenceTypeSet eventRefTypes; /* Events propagate over these references */
+#endif
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     LIST_HEAD(conditionSourcelisthead, UA_ConditionSource) headConditionSource;
@@ -148,13 +219,111 @@ struct UA_Server {
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_TYPE(networkMutex)
-    UA_LOCK_TYPE(serviceMutex)
+    /* The read-only services (Read, Browse, TranslateBrowsePaths) take the
+     * service lock shared. Everything else takes it exclusively. */
+    UA_RWLOCK_TYPE(serviceMutex)
+    /* Guards the continuation points of the sessions. Browse can attach a
+     * continuation point while holding the service lock shared. */
+    UA_LOCK_TYPE(continuationPointsMutex)
+#endif
+
+#if UA_MULTITHREADING >= 200
+    /* Number of requests whose operations are currently processed in parallel
+     * slices. The value callbacks of VariableNodes that are not marked as
+     * thread-safe are then serialized with the valueCallbackMutex. A callback
+     * that reads another such node takes the mutex again (recursively). The
+     * owner and the depth are only changed by the thread holding the mutex. */
+    volatile UA_UInt32 parallelOperations;
+    UA_LOCK_TYPE(valueCallbackMutex)
+    pthread_t valueCallbackOwner;
+    volatile UA_UInt32 valueCallbackDepth;
 #endif
 
     /* Statistics */
     UA_ServerStatistics serverStats;
 };
 
+/****************/
+/* Service Lock */
+/****************/
+
+/* Release the service lock before calling into userland (callbacks may use
+ * the public API) and reacquire it in the same mode afterwards. Returns
+ * whether the lock was held exclusively. */
+static UA_INLINE UA_Boolean
+releaseServiceLock(UA_Server *server) {
+#if UA_MULTITHREADING >= 100
+    UA_Boolean exclusive = UA_RWLOCK_ISEXCLUSIVE(server->serviceMutex);
+    if(exclusive) {
+        UA_WRUNLOCK(server->serviceMutex);
+    } else {
+        UA_RDUNLOCK(server->serviceMutex);
+    }
+    return exclusive;
+#else
+    (void)server;
+    return true;
+#endif
+}
+
+static UA_INLINE void
+reacquireServiceLock(UA_Server *server, UA_Boolean exclusive) {
+#if UA_MULTITHREADING >= 100
+    if(exclusive) {
+        UA_WRLOCK(server->serviceMutex);
+    } else {
+        UA_RDLOCK(server->serviceMutex);
+    }
+#else
+    (void)server;
+    (void)exclusive;
+#endif
+}
+
+/* Serialize the value callbacks (onRead, DataSource, external value) of a
+ * VariableNode while operations are processed in parallel slices. Unless the
+ * node is marked as thread-safe. Returns whether the lock was taken. The
+ * service lock must be released before. Otherwise a callback that writes
+ * (exclusive service lock) deadlocks with a slice waiting for the mutex. A
+ * callback that reads another serialized node re-enters the mutex. */
+static UA_INLINE UA_Boolean
+lockValueCallbacks(UA_Server *server, const UA_VariableNode *vn) {
+#if UA_MULTITHREADING >= 200
+    /* The owner is set before the depth. So a positive depth together with
+     * the own thread as the owner is only seen by the holding thread. */
+    if(server->valueCallbackDepth > 0 &&
+       pthread_equal(server->valueCallbackOwner, pthread_self())) {
+        server->valueCallbackDepth++;
+        return true;
+    }
+    if(server->parallelOperations == 0)
+        return false;
+    if(vn->head.nodeClass == UA_NODECLASS_VARIABLE && vn->threadSafe)
+        return false;
+    UA_LOCK(server->valueCallbackMutex);
+    server->valueCallbackOwner = pthread_self();
+    UA_atomic_sync();
+    server->valueCallbackDepth = 1;
+    return true;
+#else
+    (void)server;
+    (void)vn;
+    return false;
+#endif
+}
+
+static UA_INLINE void
+unlockValueCallbacks(UA_Server *server, UA_Boolean locked) {
+#if UA_MULTITHREADING >= 200
+    if(locked && --server->valueCallbackDepth == 0) {
+        UA_UNLOCK(server->valueCallbackMutex);
+    }
+#else
+    (void)server;
+    (void)locked;
+#endif
+}
+
 /**************************/
 /* SecureChannel Handling */
 /**************************/
@@ -171,6 +340,12 @@ UA_Server_cleanupTimedOutSecureChannels(UA_Server *server, UA_DateTime nowMonoto
 UA_StatusCode
 UA_Server_createSecureChannel(UA_Server *server, UA_Connection *connection);
 
+/* Check the SecureChannel in the next cleanup. Called when the connection is
+ * removed. Otherwise the channel is only checked when its SecurityToken
+ * times out. */
+void
+UA_Server_markSecureChannelForCleanup(UA_Server *server, UA_SecureChannel *channel);
+
 UA_StatusCode
 UA_Server_configSecureChannel(void *application, UA_SecureChannel *channel,
                               const UA_AsymmetricAlgorithmSecurityHeader *asymHeader);
@@ -183,6 +358,44 @@ void
 UA_Server_closeSecureChannel(UA_Server *server, UA_SecureChannel *channel,
                              UA_DiagnosticEvent event);
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+/* The SecureChannel is not deleted while a crypto job uses it. Both methods
+ * require the service lock. _release returns false if the channel was removed
+ * in the meantime. It must not be used afterwards. */
+void
+UA_Server_holdSecureChannel(UA_Server *server, UA_SecureChannel *channel);
+
+UA_Boolean
+UA_Server_releaseSecureChannel(UA_Server *server, UA_SecureChannel *channel);
+
+/* Hand the asymmetric job of the SecureChannel to the crypto workers */
+UA_StatusCode
+UA_Server_offloadAsymmetricJob(void *application, UA_SecureChannel *channel);
+
+/* Continue with the buffered messages after an asynchronous operation */
+void
+UA_Server_resumeSecureChannel(UA_Server *server, UA_SecureChannel *channel);
+
+#endif
+
+#if UA_MULTITHREADING >= 200
+
+/* The SecureChannel is not deleted while one of its requests is processed in a
+ * worker. The methods are only called from the server main loop. _end returns
+ * false if the channel was removed in the meantime. It must not be used
+ * afterwards. */
+void
+UA_Server_beginServiceJob(UA_Server *server, UA_SecureChannel *channel);
+
+UA_Boolean
+UA_Server_endServiceJob(UA_Server *server, UA_SecureChannel *channel);
+
+UA_Boolean
+UA_Server_hasServiceJob(const UA_SecureChannel *channel);
+
+#endif
+
 /********************/
 /* Session Handling */
 /********************/
@@ -240,6 +453,15 @@ UA_UInt16 addNamespace(UA_Server *server, const UA_String name);
 UA_Boolean
 UA_Node_hasSubTypeOrInstances(const UA_NodeHead *head);
 
+/* Add the reference to the last ReferenceKind of the node if the type and
+ * direction match. Otherwise a new ReferenceKind is started. Unlike
+ * UA_Node_addReference, the order of the ReferenceKinds is kept and no check
+ * for duplicates is done. Used to restore nodes from a nodestore image. */
+UA_StatusCode
+UA_Node_appendReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                        const UA_ExpandedNodeId *targetNodeId,
+                        UA_UInt32 targetBrowseNameHash);
+
 /* Recursively searches "upwards" in the tree following specific reference types */
 UA_Boolean
 isNodeInTree(UA_Server *server, const UA_NodeId *leafNode,
@@ -304,7 +526,14 @@ sendResponse(UA_Server *server, UA_Session *session, UA_SecureChannel *channel,
              UA_UInt32 requestId, UA_Response *response, const UA_DataType *responseType);
 
 /* Many services come as an array of operations. This function generalizes the
- * processing of the operations. */
+ * processing of the operations.
+ *
+ * If the service lock is held shared (read-only services), worker threads are
+ * running and the config sets an operationSliceSize, then large operation
+ * arrays are split into slices. The slices are processed in parallel by the
+ * worker threads and the calling thread. Since the slices are pushed to the
+ * work queue, this is only done in the thread that runs the server main
+ * loop. */
 typedef void (*UA_ServiceOperation)(UA_Server *server, UA_Session *session,
                                     const void *context,
                                     const void *requestOperation,
@@ -417,6 +646,20 @@ UA_StatusCode
 readValueAttribute(UA_Server *server, UA_Session *session,
                    const UA_VariableNode *vn, UA_DataValue *v);
 
+/* Array values of VariableNodes with at least this many bytes are stored with
+ * UA_VARIANT_DATA_SHARED. Read responses and MonitoredItem samples then take a
+ * reference to the value instead of copying it. */
+#define UA_NODEVALUE_SHARED_MINSIZE 1024
+
+/* Copy a value for storage in a VariableNode. Large arrays are shared. */
+UA_StatusCode
+copyNodeValue(const UA_Variant *src, UA_Variant *dst);
+
+/* Check the AccessLevel and UserAccessLevel of the session before reading the
+ * value attribute of a variable node */
+UA_StatusCode
+checkReadValueAccess(UA_Server *server, UA_Session *session, const UA_Node *node);
+
 /* Test whether the value matches a variable definition given by
  * - datatype
  * - valueranke
@@ -484,12 +727,30 @@ AddNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
 UA_StatusCode
 AddNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId);
 
+/* Drop the cached instantiation plans */
+void
+AddNode_clearPlans(UA_Server *server);
+
+/* Drop the cached instantiation plans if the node is planned or is a child in
+ * a plan */
+void
+AddNode_attributeChangedPlans(UA_Server *server, const UA_NodeId *nodeId);
+
 /**********************/
 /* Create Namespace 0 */
 /**********************/
 
 UA_StatusCode UA_Server_initNS0(UA_Server *server);
 
+/* Set the callbacks of ns0 that are not part of the nodes in a nodestore
+ * image */
+UA_StatusCode UA_Server_initNS0Callbacks(UA_Server *server);
+
+/* Restore the nodes from a nodestore image instead of creating namespace zero.
+ * Defined in ua_server_image.c. */
+UA_StatusCode
+UA_Server_loadNodestoreImage(UA_Server *server, const UA_ByteString *image);
+
 UA_StatusCode writeNs0VariableArray(UA_Server *server, UA_UInt32 id, void *v,
                       size_t length, const UA_DataType *type);
 
@@ -298,6 +298,168 @@ UA_Server_editNode(UA_Server *server, UA_Session *session,
 #endif
 }
 
+#if UA_MULTITHREADING >= 200
+
+/* The slices of a request are taken out one after the other by the calling
+ * thread and the helper jobs in the workers. The calling thread takes out the
+ * slices that were not claimed by a helper and then sleeps until the helper
+ * that finishes the last slice wakes it up. It releases the service lock while
+ * it sleeps. Otherwise a value callback in a helper that writes to the
+ * information model would wait forever for the exclusive lock. The helper jobs
+ * may start only after all slices are done. So the context is
+ * reference-counted and freed by the last user. */
+typedef struct {
+    UA_Server *server;
+    UA_Session *session;
+    UA_ServiceOperation operationCallback;
+    const void *context;
+    uintptr_t requestOperations;
+    uintptr_t responseOperations;
+    size_t requestOperationSize;
+    size_t responseOperationSize;
+    size_t ops;
+    size_t sliceSize;
+    UA_UInt32 slices;
+    volatile UA_UInt32 nextSlice;
+    volatile UA_UInt32 doneSlices;
+    volatile UA_UInt32 refCount;
+    pthread_t caller;
+    pthread_mutex_t doneMutex;
+    pthread_cond_t doneCondition;
+} UA_OperationSlices;
+
+static void
+processOperationSlices(UA_OperationSlices *os) {
+    while(true) {
+        UA_UInt32 slice = UA_atomic_addUInt32(&os->nextSlice, 1) - 1;
+        if(slice >= os->slices)
+            return;
+        size_t first = slice * os->sliceSize;
+        size_t last = first + os->sliceSize;
+        if(last > os->ops)
+            last = os->ops;
+        uintptr_t reqOp = os->requestOperations + (first * os->requestOperationSize);
+        uintptr_t respOp = os->responseOperations + (first * os->responseOperationSize);
+        for(size_t i = first; i < last; i++) {
+            os->operationCallback(os->server, os->session, os->context,
+                                  (void*)reqOp, (void*)respOp);
+            reqOp += os->requestOperationSize;
+            respOp += os->responseOperationSize;
+        }
+
+        /* Wake up the calling thread after the last slice */
+        if(UA_atomic_addUInt32(&os->doneSlices, 1) == os->slices) {
+            pthread_mutex_lock(&os->doneMutex);
+            pthread_cond_signal(&os->doneCondition);
+            pthread_mutex_unlock(&os->doneMutex);
+        }
+    }
+}
+
+static void
+releaseOperationSlices(UA_OperationSlices *os) {
+    if(UA_atomic_subUInt32(&os->refCount, 1) != 0)
+        return;
+    pthread_cond_destroy(&os->doneCondition);
+    pthread_mutex_destroy(&os->doneMutex);
+    UA_free(os);
+}
+
+/* Executed in a worker thread. The helper takes the service lock shared, as
+ * the operations release and reacquire it around user callbacks. It never
+ * waits for the lock. If a writer is queued, the calling thread processes the
+ * slices alone. When all deques are full, the job is executed inline by the
+ * calling thread. Then it is skipped. */
+static void
+operationSlicesJob(UA_Server *server, UA_OperationSlices *os) {
+    UA_Boolean locked = false;
+    if(!pthread_equal(pthread_self(), os->caller)) {
+        UA_RDLOCK_TRY(server->serviceMutex, locked);
+    }
+    if(locked) {
+        processOperationSlices(os);
+        UA_RDUNLOCK(server->serviceMutex);
+    }
+    releaseOperationSlices(os);
+}
+
+/* Returns false if the operations shall be processed sequentially */
+static UA_Boolean
+processServiceOperationsParallel(UA_Server *server, UA_Session *session,
+                                 UA_ServiceOperation operationCallback,
+                                 const void *context, size_t ops,
+                                 uintptr_t reqOp, const UA_DataType *requestOperationsType,
+                                 uintptr_t respOp, const UA_DataType *responseOperationsType) {
+    /* Only if the service lock is held shared. The operations of the
+     * services with an exclusive lock cannot run concurrently. */
+    size_t sliceSize = server->config.operationSliceSize;
+    size_t workers = server->workQueue.workersSize;
+    if(sliceSize == 0 || ops <= sliceSize || workers == 0 ||
+       UA_RWLOCK_ISEXCLUSIVE(server->serviceMutex))
+        return false;
+    size_t slices = (ops + sliceSize - 1) / sliceSize;
+    if(slices > UA_UINT32_MAX)
+        return false;
+
+    UA_OperationSlices *os = (UA_OperationSlices*)UA_malloc(sizeof(UA_OperationSlices));
+    if(!os)
+        return false;
+    if(pthread_mutex_init(&os->doneMutex, NULL) != 0) {
+        UA_free(os);
+        return false;
+    }
+    if(pthread_cond_init(&os->doneCondition, NULL) != 0) {
+        pthread_mutex_destroy(&os->doneMutex);
+        UA_free(os);
+        return false;
+    }
+    os->server = server;
+    os->session = session;
+    os->operationCallback = operationCallback;
+    os->context = context;
+    os->requestOperations = reqOp;
+    os->responseOperations = respOp;
+    os->requestOperationSize = requestOperationsType->memSize;
+    os->responseOperationSize = responseOperationsType->memSize;
+    os->ops = ops;
+    os->sliceSize = sliceSize;
+    os->slices = (UA_UInt32)slices;
+    os->nextSlice = 0;
+    os->doneSlices = 0;
+    os->caller = pthread_self();
+
+    /* One helper job per worker. The calling thread takes out slices as
+     * well. */
+    size_t helpers = slices - 1;
+    if(helpers > workers)
+        helpers = workers;
+    os->refCount = (UA_UInt32)helpers + 1;
+    UA_atomic_addUInt32(&server->parallelOperations, 1);
+    UA_atomic_sync();
+    for(size_t i = 0; i < helpers; i++)
+        UA_WorkQueue_enqueue(&server->workQueue,
+                             (UA_ApplicationCallback)operationSlicesJob, server, os);
+
+    processOperationSlices(os);
+
+    /* Sleep until the helpers have finished the slices they took out. The
+     * service lock is released in the meantime, as the operations of the
+     * helpers may call into userland. */
+    UA_Boolean exclusive = releaseServiceLock(server);
+    pthread_mutex_lock(&os->doneMutex);
+    while(os->doneSlices < os->slices)
+        pthread_cond_wait(&os->doneCondition, &os->doneMutex);
+    pthread_mutex_unlock(&os->doneMutex);
+    reacquireServiceLock(server, exclusive);
+
+    UA_atomic_sync();
+    UA_atomic_subUInt32(&server->parallelOperations, 1);
+    releaseOperationSlices(os);
+    return true;
+}
+
+#endif
+
 UA_StatusCode
 UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    UA_ServiceOperation operationCallback,
@@ -319,6 +481,15 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     uintptr_t respOp = (uintptr_t)*respPos;
     /* No padding after size_t */
     uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
+
+#if UA_MULTITHREADING >= 200
+    /* Process large operation arrays in parallel slices */
+    if(processServiceOperationsParallel(server, session, operationCallback, context,
+                                        ops, reqOp, requestOperationsType,
+                                        respOp, responseOperationsType))
+        return UA_STATUSCODE_GOOD;
+#endif
+
     for(size_t i = 0; i < ops; i++) {
         operationCallback(server, session, context, (void*)reqOp, (void*)respOp);
         reqOp += requestOperationsType->memSize;
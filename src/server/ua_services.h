@@ -159,6 +159,17 @@ void Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
                              const UA_ActivateSessionRequest *request,
                              UA_ActivateSessionResponse *response);
 
+/* The signature check and password decryption run in a crypto worker. If
+ * finished is set to false, the SecureChannel is paused and the response is
+ * sent once the job has completed. */
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+void Service_ActivateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                                  UA_UInt32 requestId,
+                                  const UA_ActivateSessionRequest *request,
+                                  UA_ActivateSessionResponse *response,
+                                  UA_Boolean *finished);
+#endif
+
 /**
  * CloseSession
  * ^^^^^^^^^^^^
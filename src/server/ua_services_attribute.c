@@ -35,11 +35,11 @@ getUserWriteMask(UA_Server *server, const UA_Session *session, const UA_NodeHead
     if(session == &server->adminSession)
         return 0xFFFFFFFF; /* the local admin user has all rights */
     UA_UInt32 mask = head->writeMask;
-    UA_UNLOCK(server->serviceMutex);
+    UA_Boolean exclusive = releaseServiceLock(server);
     mask &= server->config.accessControl.getUserRightsMask(server, &server->config.accessControl,
                                                            &session->sessionId, session->sessionHandle,
                                                            &head->nodeId, head->context);
-    UA_LOCK(server->serviceMutex);
+    reacquireServiceLock(server, exclusive);
     return mask;
 }
 
@@ -57,12 +57,12 @@ getUserAccessLevel(UA_Server *server, const UA_Session *session,
     if(session == &server->adminSession)
         return 0xFF; /* the local admin user has all rights */
     UA_Byte retval = node->accessLevel;
-    UA_UNLOCK(server->serviceMutex);
+    UA_Boolean exclusive = releaseServiceLock(server);
     retval &= server->config.accessControl.
         getUserAccessLevel(server, &server->config.accessControl,
                            &session->sessionId, session->sessionHandle,
                            &node->head.nodeId, node->head.context);
-    UA_LOCK(server->serviceMutex);
+    reacquireServiceLock(server, exclusive);
     return retval;
 }
 
@@ -71,13 +71,13 @@ getUserExecutable(UA_Server *server, const UA_Session *session,
                   const UA_MethodNode *node) {
     if(session == &server->adminSession)
         return true; /* the local admin user has all rights */
-    UA_UNLOCK(server->serviceMutex);
+    UA_Boolean exclusive = releaseServiceLock(server);
     UA_Boolean userExecutable = node->executable;
     userExecutable &=
         server->config.accessControl.getUserExecutable(server, &server->config.accessControl,
                                                        &session->sessionId, session->sessionHandle,
                                                        &node->head.nodeId, node->head.context);
-    UA_LOCK(server->serviceMutex);
+    reacquireServiceLock(server, exclusive);
     return userExecutable;
 }
 
@@ -114,17 +114,21 @@ readValueAttributeFromNode(UA_Server *server, UA_Session *session,
                            UA_NumericRange *rangeptr) {
     /* Update the value by the user callback */
     if(vn->value.data.callback.onRead) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_Boolean exclusive = releaseServiceLock(server);
+        UA_Boolean serialized = lockValueCallbacks(server, vn);
         vn->value.data.callback.onRead(server, &session->sessionId,
                                        session->sessionHandle, &vn->head.nodeId,
                                        vn->head.context, rangeptr, &vn->value.data.value);
-        UA_LOCK(server->serviceMutex);
+        unlockValueCallbacks(server, serialized);
+        reacquireServiceLock(server, exclusive);
         vn = (const UA_VariableNode*)UA_NODESTORE_GET(server, &vn->head.nodeId);
         if(!vn)
             return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
 
-    /* Set the result */
+    /* Set the result. Copying a value with UA_VARIANT_DATA_SHARED only takes a
+     * reference. The reference is released when the response is cleaned up
+     * after encoding. */
     if(rangeptr)
         return UA_Variant_copyRange(&vn->value.data.value.value, &v->value, *rangeptr);
     UA_StatusCode retval = UA_DataValue_copy(&vn->value.data.value, v);
@@ -146,11 +150,13 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
                                   timestamps == UA_TIMESTAMPSTORETURN_BOTH);
     UA_DataValue v2;
     UA_DataValue_init(&v2);
-    UA_UNLOCK(server->serviceMutex);
+    UA_Boolean exclusive = releaseServiceLock(server);
+    UA_Boolean serialized = lockValueCallbacks(server, vn);
     UA_StatusCode retval = vn->value.dataSource.
         read(server, &session->sessionId, session->sessionHandle,
              &vn->head.nodeId, vn->head.context, sourceTimeStamp, rangeptr, &v2);
-    UA_LOCK(server->serviceMutex);
+    unlockValueCallbacks(server, serialized);
+    reacquireServiceLock(server, exclusive);
     if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
         retval = UA_DataValue_copy(&v2, v);
         UA_DataValue_clear(&v2);
@@ -184,7 +190,13 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
             retval = readValueAttributeFromDataSource(server, session, vn, v, timestamps, rangeptr);
             //TODO change old structure to value backend
             break;
-        case UA_VALUEBACKENDTYPE_EXTERNAL:
+        case UA_VALUEBACKENDTYPE_EXTERNAL: {
+            /* The notification and the copy of the external value are
+             * serialized if the node is not thread-safe. The service lock is
+             * released first. The valueCallbackMutex is never taken while the
+             * service lock is held. */
+            UA_Boolean exclusive = releaseServiceLock(server);
+            UA_Boolean serialized = lockValueCallbacks(server, vn);
             if(vn->valueBackend.backend.external.callback.notificationRead){
                 retval = vn->valueBackend.backend.external.callback.notificationRead(server,
                                                                                      &session->sessionId,
@@ -197,14 +209,17 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
             }
             if(retval != UA_STATUSCODE_GOOD){
                 retval = UA_STATUSCODE_BADNOTREADABLE;
-                break;
-            }
-            /* Set the result */
-            if(rangeptr)
-                return UA_Variant_copyRange(
+            } else if(rangeptr) {
+                /* Set the result */
+                retval = UA_Variant_copyRange(
                     (const UA_Variant *) &vn->valueBackend.backend.external.value, &v->value, *rangeptr);
-            UA_DataValue_copy(*vn->valueBackend.backend.external.value, v);
+            } else {
+                UA_DataValue_copy(*vn->valueBackend.backend.external.value, v);
+            }
+            unlockValueCallbacks(server, serialized);
+            reacquireServiceLock(server, exclusive);
             break;
+        }
         case UA_VALUEBACKENDTYPE_NONE:
             /* Read the value */
             if(vn->valueSource == UA_VALUESOURCE_DATA)
@@ -227,6 +242,22 @@ readValueAttribute(UA_Server *server, UA_Session *session,
     return readValueAttributeComplete(server, session, vn, UA_TIMESTAMPSTORETURN_NEITHER, NULL, v);
 }
 
+/* The access to a value variable is granted via the AccessLevel and
+ * UserAccessLevel attributes */
+UA_StatusCode
+checkReadValueAccess(UA_Server *server, UA_Session *session, const UA_Node *node) {
+    /* VariableTypes don't have the AccessLevel concept */
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_GOOD;
+    UA_Byte accessLevel = getAccessLevel(server, session, &node->variableNode);
+    if(!(accessLevel & (UA_ACCESSLEVELMASK_READ)))
+        return UA_STATUSCODE_BADNOTREADABLE;
+    accessLevel = getUserAccessLevel(server, session, &node->variableNode);
+    if(!(accessLevel & (UA_ACCESSLEVELMASK_READ)))
+        return UA_STATUSCODE_BADUSERACCESSDENIED;
+    return UA_STATUSCODE_GOOD;
+}
+
 static const UA_String binEncoding = {sizeof("Default Binary")-1, (UA_Byte*)"Default Binary"};
 static const UA_String xmlEncoding = {sizeof("Default XML")-1, (UA_Byte*)"Default XML"};
 static const UA_String jsonEncoding = {sizeof("Default JSON")-1, (UA_Byte*)"Default JSON"};
@@ -387,21 +418,9 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
         break;
     case UA_ATTRIBUTEID_VALUE: {
         CHECK_NODECLASS(UA_NODECLASS_VARIABLE | UA_NODECLASS_VARIABLETYPE);
-        /* VariableTypes don't have the AccessLevel concept. Always allow reading the value. */
-        if(node->head.nodeClass == UA_NODECLASS_VARIABLE) {
-            /* The access to a value variable is granted via the AccessLevel
-             * and UserAccessLevel attributes */
-            UA_Byte accessLevel = getAccessLevel(server, session, &node->variableNode);
-            if(!(accessLevel & (UA_ACCESSLEVELMASK_READ))) {
-                retval = UA_STATUSCODE_BADNOTREADABLE;
-                break;
-            }
-            accessLevel = getUserAccessLevel(server, session, &node->variableNode);
-            if(!(accessLevel & (UA_ACCESSLEVELMASK_READ))) {
-                retval = UA_STATUSCODE_BADUSERACCESSDENIED;
-                break;
-            }
-        }
+        retval = checkReadValueAccess(server, session, node);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
         retval = readValueAttributeComplete(server, session, &node->variableNode,
                                             timestampsToReturn, &id->indexRange, v);
         break;
@@ -535,7 +554,7 @@ void
 Service_Read(UA_Server *server, UA_Session *session,
              const UA_ReadRequest *request, UA_ReadResponse *response) {
     UA_LOG_DEBUG_SESSION(&server->config.logger, session, "Processing ReadRequest");
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     /* Check if the timestampstoreturn is valid */
     if(request->timestampsToReturn > UA_TIMESTAMPSTORETURN_NEITHER) {
@@ -556,8 +575,6 @@ Service_Read(UA_Server *server, UA_Session *session,
         return;
     }
 
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
-
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session, (UA_ServiceOperation)Operation_Read,
                                            request,
@@ -591,14 +608,14 @@ UA_Server_readWithSession(UA_Server *server, UA_Session *session,
 UA_DataValue
 readAttribute(UA_Server *server, const UA_ReadValueId *item,
                UA_TimestampsToReturn timestamps) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
     return UA_Server_readWithSession(server, &server->adminSession, item, timestamps);
 }
 
 UA_StatusCode
 readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
                                 const UA_AttributeId attributeId, void *v) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     /* Call the read service */
     UA_ReadValueId item;
@@ -620,7 +637,13 @@ readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
 
     if(attributeId == UA_ATTRIBUTEID_VALUE ||
        attributeId == UA_ATTRIBUTEID_ARRAYDIMENSIONS) {
-        /* Return the entire variant */
+        /* Return the entire variant. The caller may modify the value. So it
+         * must not be shared. */
+        retval = UA_Variant_unshare(&dv.value);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_DataValue_clear(&dv);
+            return retval;
+        }
         memcpy(v, &dv.value, sizeof(UA_Variant));
     } else {
         /* Return the variant content only */
@@ -634,9 +657,16 @@ readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
 UA_DataValue
 UA_Server_read(UA_Server *server, const UA_ReadValueId *item,
                UA_TimestampsToReturn timestamps) {
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
     UA_DataValue dv = readAttribute(server, item, timestamps);
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
+
+    /* The user may modify the returned value. Don't hand out shared data. */
+    if(dv.hasValue && UA_Variant_unshare(&dv.value) != UA_STATUSCODE_GOOD) {
+        UA_DataValue_clear(&dv);
+        dv.hasStatus = true;
+        dv.status = UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     return dv;
 }
 
@@ -645,9 +675,9 @@ UA_Server_read(UA_Server *server, const UA_ReadValueId *item,
 UA_StatusCode
 __UA_Server_read(UA_Server *server, const UA_NodeId *nodeId,
                  const UA_AttributeId attributeId, void *v) {
-   UA_LOCK(server->serviceMutex);
+   UA_RDLOCK(server->serviceMutex);
    UA_StatusCode retval = readWithReadValue(server, nodeId, attributeId, v);
-   UA_UNLOCK(server->serviceMutex);
+   UA_RDUNLOCK(server->serviceMutex);
    return retval;
 }
 
@@ -655,7 +685,7 @@ UA_StatusCode
 readObjectProperty(UA_Server *server, const UA_NodeId objectId,
                    const UA_QualifiedName propertyName,
                    UA_Variant *value) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
     UA_RelativePathElement rpe;
     UA_RelativePathElement_init(&rpe);
     rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY);
@@ -688,9 +718,9 @@ UA_StatusCode
 UA_Server_readObjectProperty(UA_Server *server, const UA_NodeId objectId,
                              const UA_QualifiedName propertyName,
                              UA_Variant *value) {
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
     UA_StatusCode retval = readObjectProperty(server, objectId, propertyName, value);
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -1132,10 +1162,18 @@ writeDataTypeAttribute(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+copyNodeValue(const UA_Variant *src, UA_Variant *dst) {
+    if(src->type && !UA_Variant_isScalar(src) &&
+       src->arrayLength * src->type->memSize >= UA_NODEVALUE_SHARED_MINSIZE)
+        return UA_Variant_copyShared(src, dst);
+    return UA_Variant_copy(src, dst);
+}
+
 static UA_StatusCode
 writeValueAttributeWithoutRange(UA_VariableNode *node, const UA_DataValue *value) {
-    UA_DataValue new_value;
-    UA_StatusCode retval = UA_DataValue_copy(value, &new_value);
+    UA_DataValue new_value = *value;
+    UA_StatusCode retval = copyNodeValue(&value->value, &new_value.value);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     UA_DataValue_clear(&node->value.data.value);
@@ -1254,30 +1292,30 @@ writeValueAttribute(UA_Server *server, UA_Session *session,
         if(retval == UA_STATUSCODE_GOOD &&
            node->head.nodeClass == UA_NODECLASS_VARIABLE &&
            server->config.historyDatabase.setValue) {
-            UA_UNLOCK(server->serviceMutex);
+            UA_WRUNLOCK(server->serviceMutex);
             server->config.historyDatabase.
                 setValue(server, server->config.historyDatabase.context,
                          &session->sessionId, session->sessionHandle,
                          &node->head.nodeId, node->historizing, &adjustedValue);
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
         }
 #endif
                 /* Callback after writing */
                 if(retval == UA_STATUSCODE_GOOD && node->value.data.callback.onWrite) {
-                    UA_UNLOCK(server->serviceMutex)
+                    UA_WRUNLOCK(server->serviceMutex)
                     node->value.data.callback.
                         onWrite(server, &session->sessionId, session->sessionHandle,
                                 &node->head.nodeId, node->head.context, rangeptr, &adjustedValue);
-                    UA_LOCK(server->serviceMutex);
+                    UA_WRLOCK(server->serviceMutex);
 
                 }
             } else {
                 if(node->value.dataSource.write) {
-                    UA_UNLOCK(server->serviceMutex);
+                    UA_WRUNLOCK(server->serviceMutex);
                     retval = node->value.dataSource.
                         write(server, &session->sessionId, session->sessionHandle,
                               &node->head.nodeId, node->head.context, rangeptr, &adjustedValue);
-                    UA_LOCK(server->serviceMutex);
+                    UA_WRLOCK(server->serviceMutex);
                 } else {
                     retval = UA_STATUSCODE_BADWRITENOTSUPPORTED;
                 }
@@ -1532,11 +1570,30 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+/* Write into the node. Then sample the MonitoredItems that are not polled but
+ * sampled when the value is written. The instantiation plans do not contain
+ * the value. They are dropped when another attribute of a planned node was
+ * written. */
+static UA_StatusCode
+writeNode(UA_Server *server, UA_Session *session, const UA_WriteValue *wv) {
+    UA_StatusCode retval =
+        UA_Server_editNode(server, session, &wv->nodeId,
+                           (UA_EditNodeCallback)copyAttributeIntoNode,
+                           /* casting away const qualifier because callback uses const anyway */
+                           (UA_WriteValue *)(uintptr_t)wv);
+    if(retval == UA_STATUSCODE_GOOD && wv->attributeId != UA_ATTRIBUTEID_VALUE)
+        AddNode_attributeChangedPlans(server, &wv->nodeId);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(retval == UA_STATUSCODE_GOOD && wv->attributeId == UA_ATTRIBUTEID_VALUE)
+        UA_Sampler_sampleOnWrite(server, &wv->nodeId);
+#endif
+    return retval;
+}
+
 static void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 UA_WriteValue *wv, UA_StatusCode *result) {
-    *result = UA_Server_editNode(server, session, &wv->nodeId,
-                        (UA_EditNodeCallback)copyAttributeIntoNode, wv);
+    *result = writeNode(server, session, wv);
 }
 
 void
@@ -1564,26 +1621,20 @@ Service_Write(UA_Server *server, UA_Session *session,
 UA_StatusCode
 writeWithSession(UA_Server *server, UA_Session *session,
                            const UA_WriteValue *value) {
-    return UA_Server_editNode(server, session, &value->nodeId,
-                              (UA_EditNodeCallback)copyAttributeIntoNode,
-                              /* casting away const qualifier because callback uses const anyway */
-                              (UA_WriteValue *)(uintptr_t)value);
+    return writeNode(server, session, value);
 }
 
 UA_StatusCode
 writeAttribute(UA_Server *server, const UA_WriteValue *value) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
-    return UA_Server_editNode(server, &server->adminSession, &value->nodeId,
-                              (UA_EditNodeCallback)copyAttributeIntoNode,
-                               /* casting away const qualifier because callback uses const anyway */
-                              (UA_WriteValue *)(uintptr_t)value);
+    return writeNode(server, &server->adminSession, value);
 }
 
 UA_StatusCode
 UA_Server_write(UA_Server *server, const UA_WriteValue *value) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = writeAttribute(server, value);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -1616,9 +1667,9 @@ __UA_Server_write(UA_Server *server, const UA_NodeId *nodeId,
                   const UA_AttributeId attributeId,
                   const UA_DataType *attr_type,
                   const void *attr) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = writeWithWriteValue(server, nodeId, attributeId, attr_type, attr);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -1717,7 +1768,7 @@ Service_HistoryRead(UA_Server *server, UA_Session *session,
         response->results[i].historyData.content.decoded.data = data;
         historyData[i] = data;
     }
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     readHistory(server, server->config.historyDatabase.context,
                 &session->sessionId, session->sessionHandle,
                 &request->requestHeader,
@@ -1726,7 +1777,7 @@ Service_HistoryRead(UA_Server *server, UA_Session *session,
                 request->releaseContinuationPoints,
                 request->nodesToReadSize, request->nodesToRead,
                 response, historyData);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_free(historyData);
 }
 
@@ -1757,14 +1808,14 @@ Service_HistoryUpdate(UA_Server *server, UA_Session *session,
         void *updateDetailsData = request->historyUpdateDetails[i].content.decoded.data;
         if(updateDetailsType == &UA_TYPES[UA_TYPES_UPDATEDATADETAILS]) {
             if(server->config.historyDatabase.updateData) {
-                UA_UNLOCK(server->serviceMutex);
+                UA_WRUNLOCK(server->serviceMutex);
                 server->config.historyDatabase.
                     updateData(server, server->config.historyDatabase.context,
                                &session->sessionId, session->sessionHandle,
                                &request->requestHeader,
                                (UA_UpdateDataDetails*)updateDetailsData,
                                &response->results[i]);
-                UA_LOCK(server->serviceMutex);
+                UA_WRLOCK(server->serviceMutex);
             } else {
                 response->results[i].statusCode = UA_STATUSCODE_BADNOTSUPPORTED;
             }
@@ -1773,14 +1824,14 @@ Service_HistoryUpdate(UA_Server *server, UA_Session *session,
 
         if(updateDetailsType == &UA_TYPES[UA_TYPES_DELETERAWMODIFIEDDETAILS]) {
             if(server->config.historyDatabase.deleteRawModified) {
-                UA_UNLOCK(server->serviceMutex);
+                UA_WRUNLOCK(server->serviceMutex);
                 server->config.historyDatabase.
                     deleteRawModified(server, server->config.historyDatabase.context,
                                       &session->sessionId, session->sessionHandle,
                                       &request->requestHeader,
                                       (UA_DeleteRawModifiedDetails*)updateDetailsData,
                                       &response->results[i]);
-                UA_LOCK(server->serviceMutex);
+                UA_WRLOCK(server->serviceMutex);
             } else {
                 response->results[i].statusCode = UA_STATUSCODE_BADNOTSUPPORTED;
             }
@@ -1797,9 +1848,9 @@ UA_StatusCode UA_EXPORT
 UA_Server_writeObjectProperty(UA_Server *server, const UA_NodeId objectId,
                               const UA_QualifiedName propertyName,
                               const UA_Variant value) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retVal = writeObjectProperty(server, objectId, propertyName, value);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retVal;
 }
 
@@ -1843,8 +1894,8 @@ UA_Server_writeObjectProperty_scalar(UA_Server *server, const UA_NodeId objectId
     UA_Variant var;
     UA_Variant_init(&var);
     UA_Variant_setScalar(&var, (void*)(uintptr_t)value, type);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = writeObjectProperty(server, objectId, propertyName, var);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
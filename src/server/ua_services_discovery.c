@@ -416,11 +416,11 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
         }
 
         if(server->discoveryManager.registerServerCallback) {
-            UA_UNLOCK(server->serviceMutex);
+            UA_WRUNLOCK(server->serviceMutex);
             server->discoveryManager.
                     registerServerCallback(requestServer,
                                            server->discoveryManager.registerServerCallbackData);
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
         }
 
         // server found, remove from list
@@ -466,11 +466,11 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
     // registered before, then crashed, restarts and registeres again. In that case the entry is not deleted
     // and the callback would not be called.
     if(server->discoveryManager.registerServerCallback) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->discoveryManager.
                 registerServerCallback(requestServer,
                                        server->discoveryManager.registerServerCallbackData);
-        UA_LOCK(server->serviceMutex)
+        UA_WRLOCK(server->serviceMutex)
     }
 
     // copy the data from the request into the list
@@ -578,7 +578,7 @@ void UA_Discovery_cleanupTimedOut(UA_Server *server, UA_DateTime nowMonotonic) {
 static void
 periodicServerRegister(UA_Server *server, void *data) {
     UA_assert(data != NULL);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
 
     struct PeriodicServerRegisterCallback *cb = (struct PeriodicServerRegisterCallback *)data;
 
@@ -623,7 +623,7 @@ periodicServerRegister(UA_Server *server, void *data) {
 
         cb->this_interval = nextInterval;
         changeRepeatedCallbackInterval(server, cb->id, nextInterval);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return;
     }
 
@@ -638,7 +638,7 @@ periodicServerRegister(UA_Server *server, void *data) {
         if(retval == UA_STATUSCODE_GOOD)
             cb->registered = true;
     }
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 UA_StatusCode
@@ -648,18 +648,18 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
                                             UA_Double intervalMs,
                                             UA_Double delayFirstRegisterMs,
                                             UA_UInt64 *periodicCallbackId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     /* No valid server URL */
     if(!discoveryServerUrl) {
         UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
                      "No discovery server URL provided");
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
 
     if (client->connection.state != UA_CONNECTIONSTATE_CLOSED) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADINVALIDSTATE;
     }
 
@@ -685,7 +685,7 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
     struct PeriodicServerRegisterCallback* cb = (struct PeriodicServerRegisterCallback*)
         UA_malloc(sizeof(struct PeriodicServerRegisterCallback));
     if(!cb) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
@@ -700,7 +700,7 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
     cb->discovery_server_url = (char*)UA_malloc(len+1);
     if (!cb->discovery_server_url) {
         UA_free(cb);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
     memcpy(cb->discovery_server_url, discoveryServerUrl, len+1);
@@ -714,7 +714,7 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
                      "Could not create periodic job for server register. "
                      "StatusCode %s", UA_StatusCode_name(retval));
         UA_free(cb);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return retval;
     }
 
@@ -725,7 +725,7 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
     if(!newEntry) {
         removeCallback(server, cb->id);
         UA_free(cb);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
     newEntry->callback = cb;
@@ -734,7 +734,7 @@ UA_Server_addPeriodicServerRegisterCallback(UA_Server *server,
 
     if(periodicCallbackId)
         *periodicCallbackId = cb->id;
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -742,10 +742,10 @@ void
 UA_Server_setRegisterServerCallback(UA_Server *server,
                                     UA_Server_registerServerCallback cb,
                                     void* data) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     server->discoveryManager.registerServerCallback = cb;
     server->discoveryManager.registerServerCallbackData = data;
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 #endif /* UA_ENABLE_DISCOVERY */
@@ -83,6 +83,9 @@ setMonitoredItemSettings(UA_Server *server, UA_Session *session, UA_MonitoredIte
     UA_LOCK_ASSERT(server->serviceMutex, 1);
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_CompiledEventFilter *eventFilter = NULL;
+#endif
 
     if(mon->attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
         /* Event MonitoredItem */
@@ -94,9 +97,9 @@ setMonitoredItemSettings(UA_Server *server, UA_Session *session, UA_MonitoredIte
             return UA_STATUSCODE_BADEVENTFILTERINVALID;
         if(params->filter.content.decoded.type != &UA_TYPES[UA_TYPES_EVENTFILTER])
             return UA_STATUSCODE_BADEVENTFILTERINVALID;
-        UA_EventFilter_clear(&mon->filter.eventFilter);
-        retval = UA_EventFilter_copy((UA_EventFilter *)params->filter.content.decoded.data,
-                                     &mon->filter.eventFilter);
+        retval = UA_Server_acquireEventFilter(server, (UA_EventFilter *)
+                                              params->filter.content.decoded.data,
+                                              &eventFilter);
 #endif
     } else {
         /* DataChange MonitoredItem */
@@ -138,6 +141,15 @@ setMonitoredItemSettings(UA_Server *server, UA_Session *session, UA_MonitoredIte
 
     /* <-- The point of no return --> */
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Replace the compiled EventFilter */
+    if(eventFilter) {
+        if(mon->filter.eventFilter)
+            UA_Server_releaseEventFilter(server, mon->filter.eventFilter);
+        mon->filter.eventFilter = eventFilter;
+    }
+#endif
+
     /* Unregister the callback */
     UA_MonitoredItem_unregisterSampleCallback(server, mon);
 
@@ -288,6 +300,10 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session, struct cre
         return;
     }
 
+    /* Preallocate the notifications. Local MonitoredItems have no queue. */
+    if(cmc->sub)
+        UA_MonitoredItem_resizeNotificationPool(newMon);
+
     /* Add to the subscriptions or the local MonitoredItems */
     if(cmc->sub) {
         newMon->monitoredItemId = ++cmc->sub->lastMonitoredItemId;
@@ -326,6 +342,7 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session, struct cre
             /* Insert the monitored item into the node's queue */
             UA_Server_editNode(server, NULL, &newMon->monitoredNodeId,
                                UA_Server_addMonitoredItemToNodeEditNodeCallback, newMon);
+            UA_Event_clearSources(server);
         }
 #endif
     } else {
@@ -341,12 +358,12 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session, struct cre
     if(server->config.monitoredItemRegisterCallback) {
         void *targetContext = NULL;
         getNodeContext(server, request->itemToMonitor.nodeId, &targetContext);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->config.monitoredItemRegisterCallback(server, &session->sessionId,
                                                      session->sessionHandle,
                                                      &request->itemToMonitor.nodeId,
                                                      targetContext, newMon->attributeId, false);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         newMon->registered = true;
     }
 
@@ -418,9 +435,9 @@ UA_Server_createDataChangeMonitoredItem(UA_Server *server,
 
     UA_MonitoredItemCreateResult result;
     UA_MonitoredItemCreateResult_init(&result);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Operation_CreateMonitoredItem(server, &server->adminSession, &cmc, &item, &result);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return result;
 }
 
@@ -457,6 +474,9 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
 
     /* Remove some notifications if the queue is now too small */
     UA_MonitoredItem_ensureQueueSpace(server, mon);
+
+    /* Adjust the preallocated notifications to the queue size */
+    UA_MonitoredItem_resizeNotificationPool(mon);
 }
 
 void
@@ -646,17 +666,17 @@ Service_DeleteMonitoredItems(UA_Server *server, UA_Session *session,
 
 UA_StatusCode
 UA_Server_deleteMonitoredItem(UA_Server *server, UA_UInt32 monitoredItemId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_MonitoredItem *mon;
     LIST_FOREACH(mon, &server->localMonitoredItems, listEntry) {
         if(mon->monitoredItemId != monitoredItemId)
             continue;
         LIST_REMOVE(mon, listEntry);
         UA_MonitoredItem_delete(server, mon);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_GOOD;
     }
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 }
 
@@ -26,9 +26,9 @@
 UA_StatusCode
 UA_Server_getNodeContext(UA_Server *server, UA_NodeId nodeId,
                          void **nodeContext) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = getNodeContext(server, nodeId, nodeContext);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -68,10 +68,10 @@ editNodeContext(UA_Server *server, UA_Session* session,
 UA_StatusCode
 UA_Server_setNodeContext(UA_Server *server, UA_NodeId nodeId,
                          void *nodeContext) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
                               (UA_EditNodeCallback)editNodeContext, nodeContext);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -343,41 +343,78 @@ useVariableTypeAttributes(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+static const UA_NodeId aggregatesId =
+    {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_AGGREGATES}};
+
+#define UA_INSTANTIATE_CLASSMASK \
+    (UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD)
+
+/* Search the targets with the BrowseName hash for a child with the
+ * BrowseName. Targets with the same hash can lie on both sides of a match. */
+static UA_Boolean
+findNamedTarget(UA_Server *server, const UA_ReferenceTarget *rt, UA_UInt32 nameHash,
+                const UA_QualifiedName *browseName, UA_NodeId **outTargetId) {
+    while(rt) {
+        if(rt->targetNameHash < nameHash) {
+            rt = ZIP_RIGHT(rt, nameTreeFields);
+            continue;
+        }
+        if(rt->targetNameHash > nameHash) {
+            rt = ZIP_LEFT(rt, nameTreeFields);
+            continue;
+        }
+        const UA_Node *target = UA_NODESTORE_GET(server, &rt->targetId.nodeId);
+        if(target) {
+            UA_Boolean found = (target->head.nodeClass & UA_INSTANTIATE_CLASSMASK) &&
+                UA_QualifiedName_equal(&target->head.browseName, browseName);
+            UA_NODESTORE_RELEASE(server, target);
+            if(found) {
+                *outTargetId = (UA_NodeId*)(uintptr_t)&rt->targetId.nodeId;
+                return true;
+            }
+        }
+        if(findNamedTarget(server, ZIP_LEFT(rt, nameTreeFields), nameHash,
+                           browseName, outTargetId))
+            return true;
+        rt = ZIP_RIGHT(rt, nameTreeFields);
+    }
+    return false;
+}
+
 /* Search for an instance of "browseName" in node searchInstance. Used during
  * copyChildNodes to find overwritable/mergable nodes. Does not touch
- * outInstanceNodeId if no child is found. */
+ * outInstanceNodeId if no child is found. The lookup uses the BrowseName index
+ * of the references instead of browsing all children. */
 static UA_StatusCode
 findChildByBrowsename(UA_Server *server, UA_Session *session,
                       const UA_NodeId *searchInstance,
                       const UA_QualifiedName *browseName,
                       UA_NodeId *outInstanceNodeId) {
-    UA_BrowseDescription bd;
-    UA_BrowseDescription_init(&bd);
-    bd.nodeId = *searchInstance;
-    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_AGGREGATES);
-    bd.includeSubtypes = true;
-    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-    bd.nodeClassMask = UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD;
-    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    UA_ReferenceTypeSet aggregates;
+    UA_StatusCode retval = referenceTypeIndices(server, &aggregatesId, &aggregates, true);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
 
-    UA_BrowseResult br;
-    UA_BrowseResult_init(&br);
-    UA_UInt32 maxrefs = 0;
-    Operation_Browse(server, session, &maxrefs, &bd, &br);
-    if(br.statusCode != UA_STATUSCODE_GOOD)
-        return br.statusCode;
+    const UA_Node *node = UA_NODESTORE_GET(server, searchInstance);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    for(size_t i = 0; i < br.referencesSize; ++i) {
-        UA_ReferenceDescription *rd = &br.references[i];
-        if(rd->browseName.namespaceIndex == browseName->namespaceIndex &&
-           UA_String_equal(&rd->browseName.name, &browseName->name)) {
-            retval = UA_NodeId_copy(&rd->nodeId.nodeId, outInstanceNodeId);
+    UA_UInt32 nameHash = UA_QualifiedName_hash(browseName);
+    for(size_t i = 0; i < node->head.referencesSize; ++i) {
+        UA_NodeReferenceKind *rk = &node->head.references[i];
+        if(rk->isInverse)
+            continue;
+        if(!UA_ReferenceTypeSet_contains(&aggregates, rk->referenceTypeIndex))
+            continue;
+        UA_NodeId *targetId;
+        if(findNamedTarget(server, ZIP_ROOT(&rk->refTargetsNameTree), nameHash,
+                           browseName, &targetId)) {
+            retval = UA_NodeId_copy(targetId, outInstanceNodeId);
             break;
         }
     }
 
-    UA_BrowseResult_clear(&br);
+    UA_NODESTORE_RELEASE(server, node);
     return retval;
 }
 
@@ -412,6 +449,208 @@ isMandatoryChild(UA_Server *server, UA_Session *session,
     return false;
 }
 
+/* The children of the types and instance declarations are browsed once and
+ * kept in a plan. Instantiating a type then walks the plans instead of browsing
+ * the declarations again for every instance. All plans are dropped when a
+ * forward reference of a planned node, or a reference that changes the type
+ * hierarchy or the ModellingRules, is added or deleted. Also when the
+ * TypeDefinition or an attribute of a planned node or of a child in a plan is
+ * changed.
+ * The plans are browsed with the admin session. The access of the session is
+ * checked every time a plan is used. */
+
+static enum ZIP_CMP
+cmpInstantiationPlan(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_PROTOTYPE(UA_InstantiationPlanTree, UA_InstantiationPlan, UA_NodeId)
+ZIP_IMPL(UA_InstantiationPlanTree, UA_InstantiationPlan, zipfields,
+         UA_NodeId, nodeId, cmpInstantiationPlan)
+
+static void
+releasePlan(UA_InstantiationPlan *plan) {
+    UA_assert(plan->refCount > 0);
+    plan->refCount--;
+    if(plan->refCount > 0)
+        return;
+    UA_NodeId_clear(&plan->nodeId);
+    UA_Array_delete(plan->children, plan->childrenSize,
+                    &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    UA_free(plan->mandatory);
+    UA_Array_delete(plan->hierarchy, plan->hierarchySize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(plan);
+}
+
+void
+AddNode_clearPlans(UA_Server *server) {
+    UA_InstantiationPlan *plan;
+    while((plan = ZIP_ROOT(&server->instantiationPlans))) {
+        ZIP_REMOVE(UA_InstantiationPlanTree, &server->instantiationPlans, plan);
+        releasePlan(plan);
+    }
+}
+
+typedef struct {
+    const UA_NodeId *nodeId;
+    UA_Boolean found;
+} PlanChildSearch;
+
+static void
+findPlanChild(UA_InstantiationPlan *plan, void *data) {
+    PlanChildSearch *search = (PlanChildSearch*)data;
+    for(size_t i = 0; i < plan->childrenSize && !search->found; i++)
+        search->found = UA_NodeId_equal(&plan->children[i].nodeId.nodeId,
+                                        search->nodeId);
+}
+
+/* Is the node planned or a child in a plan? */
+static UA_Boolean
+isInPlans(UA_Server *server, const UA_NodeId *nodeId) {
+    PlanChildSearch search = {nodeId,
+        ZIP_FIND(UA_InstantiationPlanTree, &server->instantiationPlans,
+                 nodeId) != NULL};
+    if(!search.found)
+        ZIP_ITER(UA_InstantiationPlanTree, &server->instantiationPlans,
+                 findPlanChild, &search);
+    return search.found;
+}
+
+/* A reference of the node was added or deleted. The TypeDefinition of a child
+ * is kept in the plan. A HasTypeDefinition reference only matters if its
+ * source is planned or a child in a plan. The new instances of an
+ * instantiation are neither. */
+static void
+referenceChangedPlans(UA_Server *server, const UA_NodeId *nodeId,
+                      UA_Byte refTypeIndex, UA_Boolean isForward) {
+    if(!ZIP_ROOT(&server->instantiationPlans))
+        return;
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASTYPEDEFINITION) {
+        if(isForward && isInPlans(server, nodeId))
+            AddNode_clearPlans(server);
+        return;
+    }
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE ||
+       refTypeIndex == UA_REFERENCETYPEINDEX_HASINTERFACE ||
+       refTypeIndex == UA_REFERENCETYPEINDEX_HASMODELLINGRULE ||
+       (isForward && ZIP_FIND(UA_InstantiationPlanTree,
+                              &server->instantiationPlans, nodeId)))
+        AddNode_clearPlans(server);
+}
+
+void
+AddNode_attributeChangedPlans(UA_Server *server, const UA_NodeId *nodeId) {
+    if(!ZIP_ROOT(&server->instantiationPlans))
+        return;
+    if(isInPlans(server, nodeId))
+        AddNode_clearPlans(server);
+}
+
+/* The plan does not depend on the session. The children are browsed and the
+ * ModellingRules are checked with the admin session. */
+static UA_StatusCode
+resolvePlanChildren(UA_Server *server, UA_InstantiationPlan *plan) {
+    UA_Session *session = &server->adminSession;
+    /* Browse to get all children of the source */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = plan->nodeId;
+    bd.referenceTypeId = aggregatesId;
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.nodeClassMask = UA_INSTANTIATE_CLASSMASK;
+    bd.resultMask = UA_BROWSERESULTMASK_REFERENCETYPEID | UA_BROWSERESULTMASK_NODECLASS |
+        UA_BROWSERESULTMASK_BROWSENAME | UA_BROWSERESULTMASK_TYPEDEFINITION;
+
+    UA_BrowseResult br;
+    UA_BrowseResult_init(&br);
+    UA_UInt32 maxrefs = 0;
+    Operation_Browse(server, session, &maxrefs, &bd, &br);
+    if(br.statusCode != UA_STATUSCODE_GOOD)
+        return br.statusCode;
+
+    if(br.referencesSize > 0) {
+        plan->mandatory = (UA_Boolean*)UA_malloc(sizeof(UA_Boolean) * br.referencesSize);
+        if(!plan->mandatory) {
+            UA_BrowseResult_clear(&br);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        for(size_t i = 0; i < br.referencesSize; ++i)
+            plan->mandatory[i] =
+                isMandatoryChild(server, session, &br.references[i].nodeId.nodeId);
+    }
+
+    plan->children = br.references;
+    plan->childrenSize = br.referencesSize;
+    br.references = NULL;
+    br.referencesSize = 0;
+    UA_BrowseResult_clear(&br);
+    plan->childrenResolved = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The session must be allowed to browse the children of the node. Like the
+ * browse of the children without a plan. */
+static UA_StatusCode
+checkPlanAccess(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
+    if(session == &server->adminSession)
+        return UA_STATUSCODE_GOOD;
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_Boolean allowed = server->config.accessControl.
+        allowBrowseNode(server, &server->config.accessControl, &session->sessionId,
+                        session->sessionHandle, nodeId, node->head.context);
+    UA_NODESTORE_RELEASE(server, node);
+    return (allowed) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADUSERACCESSDENIED;
+}
+
+/* Get the plan with the resolved children (and the type hierarchy). The plan
+ * is released after use. */
+static UA_StatusCode
+getPlan(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+        UA_Boolean withHierarchy, UA_InstantiationPlan **outPlan) {
+    UA_StatusCode res = checkPlanAccess(server, session, nodeId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_InstantiationPlan *plan =
+        ZIP_FIND(UA_InstantiationPlanTree, &server->instantiationPlans, nodeId);
+    if(!plan) {
+        plan = (UA_InstantiationPlan*)UA_calloc(1, sizeof(UA_InstantiationPlan));
+        if(!plan)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode retval = UA_NodeId_copy(nodeId, &plan->nodeId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_free(plan);
+            return retval;
+        }
+        plan->refCount = 1; /* Held by the tree */
+        ZIP_INSERT(UA_InstantiationPlanTree, &server->instantiationPlans, plan,
+                   ZIP_FFS32(UA_UInt32_random()));
+    }
+
+    if(!plan->childrenResolved) {
+        UA_StatusCode retval = resolvePlanChildren(server, plan);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    if(withHierarchy && !plan->hierarchyResolved) {
+        UA_StatusCode retval =
+            getParentTypeAndInterfaceHierarchy(server, nodeId, &plan->hierarchy,
+                                               &plan->hierarchySize);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        UA_assert(plan->hierarchySize < 1000);
+        plan->hierarchyResolved = true;
+    }
+
+    plan->refCount++;
+    *outPlan = plan;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
                 const UA_NodeId *source, const UA_NodeId *destination);
@@ -426,7 +665,7 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
 
 static UA_StatusCode
 copyChild(UA_Server *server, UA_Session *session, const UA_NodeId *destinationNodeId,
-          const UA_ReferenceDescription *rd) {
+          const UA_ReferenceDescription *rd, UA_Boolean mandatory) {
     /* Is there an existing child with the browsename? */
     UA_NodeId existingChild = UA_NODEID_NULL;
     UA_StatusCode retval = findChildByBrowsename(server, session, destinationNodeId,
@@ -445,18 +684,18 @@ copyChild(UA_Server *server, UA_Session *session, const UA_NodeId *destinationNo
 
     /* Is the child mandatory? If not, ask callback whether child should be instantiated.
      * If not, skip. */
-    if(!isMandatoryChild(server, session, &rd->nodeId.nodeId)) {
+    if(!mandatory) {
         if(!server->config.nodeLifecycle.createOptionalChild)
             return UA_STATUSCODE_GOOD;
 
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         retval = server->config.nodeLifecycle.createOptionalChild(server,
                                                                  &session->sessionId,
                                                                  session->sessionHandle,
                                                                  &rd->nodeId.nodeId,
                                                                  destinationNodeId,
                                                                  &rd->referenceTypeId);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         if(retval == UA_FALSE) {
             return UA_STATUSCODE_GOOD;
         }
@@ -487,20 +726,26 @@ copyChild(UA_Server *server, UA_Session *session, const UA_NodeId *destinationNo
         /* Remove the context of the copied node */
         node->head.context = NULL;
         node->head.constructed = false;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        /* The copy becomes a new node. The event MonitoredItems registered at
+         * the declaration are not carried over. */
+        if(node->head.nodeClass == UA_NODECLASS_OBJECT)
+            node->objectNode.monitoredItemQueue = NULL;
+#endif
 
         /* Reset the NodeId (random numeric id will be assigned in the nodestore) */
         UA_NodeId_clear(&node->head.nodeId);
         node->head.nodeId.namespaceIndex = destinationNodeId->namespaceIndex;
 
         if (server->config.nodeLifecycle.generateChildNodeId) {
-            UA_UNLOCK(server->serviceMutex);
+            UA_WRUNLOCK(server->serviceMutex);
             retval = server->config.nodeLifecycle.generateChildNodeId(server,
                                                                       &session->sessionId, session->sessionHandle,
                                                                       &rd->nodeId.nodeId,
                                                                       destinationNodeId,
                                                                       &rd->referenceTypeId,
                                                                       &node->head.nodeId);
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             if(retval != UA_STATUSCODE_GOOD) {
                 UA_NODESTORE_DELETE(server, node);
                 return retval;
@@ -543,33 +788,20 @@ copyChild(UA_Server *server, UA_Session *session, const UA_NodeId *destinationNo
 static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
                 const UA_NodeId *source, const UA_NodeId *destination) {
-    /* Browse to get all children of the source */
-    UA_BrowseDescription bd;
-    UA_BrowseDescription_init(&bd);
-    bd.nodeId = *source;
-    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_AGGREGATES);
-    bd.includeSubtypes = true;
-    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-    bd.nodeClassMask = UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD;
-    bd.resultMask = UA_BROWSERESULTMASK_REFERENCETYPEID | UA_BROWSERESULTMASK_NODECLASS |
-        UA_BROWSERESULTMASK_BROWSENAME | UA_BROWSERESULTMASK_TYPEDEFINITION;
-
-    UA_BrowseResult br;
-    UA_BrowseResult_init(&br);
-    UA_UInt32 maxrefs = 0;
-    Operation_Browse(server, session, &maxrefs, &bd, &br);
-    if(br.statusCode != UA_STATUSCODE_GOOD)
-        return br.statusCode;
+    /* Get the (cached) children of the source */
+    UA_InstantiationPlan *plan;
+    UA_StatusCode retval = getPlan(server, session, source, false, &plan);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    for(size_t i = 0; i < br.referencesSize; ++i) {
-        UA_ReferenceDescription *rd = &br.references[i];
-        retval = copyChild(server, session, destination, rd);
+    for(size_t i = 0; i < plan->childrenSize; ++i) {
+        retval = copyChild(server, session, destination,
+                           &plan->children[i], plan->mandatory[i]);
         if(retval != UA_STATUSCODE_GOOD)
-            return retval;
+            break;
     }
 
-    UA_BrowseResult_clear(&br);
+    releasePlan(plan);
     return retval;
 }
 
@@ -577,22 +809,19 @@ static UA_StatusCode
 addTypeChildren(UA_Server *server, UA_Session *session,
                 const UA_NodeHead *head, const UA_NodeHead *typeHead) {
     /* Get the hierarchy of the type and all its supertypes */
-    UA_NodeId *hierarchy = NULL;
-    size_t hierarchySize = 0;
-    UA_StatusCode retval = getParentTypeAndInterfaceHierarchy(server, &typeHead->nodeId,
-                                                              &hierarchy, &hierarchySize);
+    UA_InstantiationPlan *plan;
+    UA_StatusCode retval = getPlan(server, session, &typeHead->nodeId, true, &plan);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    UA_assert(hierarchySize < 1000);
 
     /* Copy members of the type and supertypes (and instantiate them) */
-    for(size_t i = 0; i < hierarchySize; ++i) {
-        retval = copyAllChildren(server, session, &hierarchy[i], &head->nodeId);
+    for(size_t i = 0; i < plan->hierarchySize; ++i) {
+        retval = copyAllChildren(server, session, &plan->hierarchy[i], &head->nodeId);
         if(retval != UA_STATUSCODE_GOOD)
             break;
     }
 
-    UA_Array_delete(hierarchy, hierarchySize, &UA_TYPES[UA_TYPES_NODEID]);
+    releasePlan(plan);
     return retval;
 }
 
@@ -865,13 +1094,13 @@ AddNode_raw(UA_Server *server, UA_Session *session, void *nodeContext,
             const UA_AddNodesItem *item, UA_NodeId *outNewNodeId) {
     /* Do not check access for server */
     if(session != &server->adminSession && server->config.accessControl.allowAddNode) {
-        UA_UNLOCK(server->serviceMutex)
+        UA_WRUNLOCK(server->serviceMutex)
         if (!server->config.accessControl.allowAddNode(server, &server->config.accessControl,
                                                        &session->sessionId, session->sessionHandle, item)) {
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             return UA_STATUSCODE_BADUSERACCESSDENIED;
         }
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* Check the namespaceindex */
@@ -1178,20 +1407,20 @@ recursiveCallConstructors(UA_Server *server, UA_Session *session,
     /* Call the global constructor */
     void *context = head->context;
     if(server->config.nodeLifecycle.constructor) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         retval = server->config.nodeLifecycle.constructor(server, &session->sessionId,
                                                           session->sessionHandle,
                                                           &head->nodeId, &context);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* Call the type constructor */
     if(retval == UA_STATUSCODE_GOOD && lifecycle && lifecycle->constructor) {
-        UA_UNLOCK(server->serviceMutex)
+        UA_WRUNLOCK(server->serviceMutex)
         retval = lifecycle->constructor(server, &session->sessionId,
                                         session->sessionHandle, &type->head.nodeId,
                                         type->head.context, &head->nodeId, &context);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
     if(retval != UA_STATUSCODE_GOOD)
         goto fail1;
@@ -1208,21 +1437,21 @@ recursiveCallConstructors(UA_Server *server, UA_Session *session,
 
     /* Fail. Call the destructors. */
     if(lifecycle && lifecycle->destructor) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         lifecycle->destructor(server, &session->sessionId,
                               session->sessionHandle, &type->head.nodeId,
                               type->head.context, &head->nodeId, &context);
-        UA_LOCK(server->serviceMutex)
+        UA_WRLOCK(server->serviceMutex)
     }
 
 
  fail1:
     if(server->config.nodeLifecycle.destructor) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->config.nodeLifecycle.destructor(server, &session->sessionId,
                                                 session->sessionHandle,
                                                 &head->nodeId, context);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     return retval;
@@ -1322,6 +1551,15 @@ AddNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
                            nodeIdStr.data, UA_StatusCode_name(retval)));
     }
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* MonitoredItems can exist for the NodeId of a deleted node. Decide again
+     * whether they are sampled on write. Then report the new value. */
+    if(retval == UA_STATUSCODE_GOOD && head->nodeClass == UA_NODECLASS_VARIABLE) {
+        UA_Sampler_updateMode(server, &head->nodeId);
+        UA_Sampler_sampleOnWrite(server, &head->nodeId);
+    }
+#endif
+
  cleanup:
     if(type)
         UA_NODESTORE_RELEASE(server, type);
@@ -1414,12 +1652,12 @@ __UA_Server_addNode(UA_Server *server, const UA_NodeClass nodeClass,
                     const UA_NodeAttributes *attr,
                     const UA_DataType *attributeType,
                     void *nodeContext, UA_NodeId *outNewNodeId) {
-    UA_LOCK(server->serviceMutex)
+    UA_WRLOCK(server->serviceMutex)
     UA_StatusCode reval =
         addNode(server, nodeClass, requestedNewNodeId, parentNodeId,
                 referenceTypeId, browseName, typeDefinition, attr,
                 attributeType, nodeContext, outNewNodeId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return reval;
 }
 
@@ -1440,19 +1678,19 @@ UA_Server_addNode_begin(UA_Server *server, const UA_NodeClass nodeClass,
     item.nodeAttributes.content.decoded.type = attributeType;
     item.nodeAttributes.content.decoded.data = (void*)(uintptr_t)attr;
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval =
         Operation_addNode_begin(server, &server->adminSession, nodeContext, &item,
                                 &parentNodeId, &referenceTypeId, outNewNodeId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
 UA_StatusCode
 UA_Server_addNode_finish(UA_Server *server, const UA_NodeId nodeId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = AddNode_finish(server, &server->adminSession, &nodeId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -1525,12 +1763,12 @@ recursiveDeconstructNode(UA_Server *server, UA_Session *session,
             else
                 lifecycle = &type->variableTypeNode.lifecycle;
             if(lifecycle->destructor) {
-                UA_UNLOCK(server->serviceMutex);
+                UA_WRUNLOCK(server->serviceMutex);
                 lifecycle->destructor(server,
                                       &session->sessionId, session->sessionHandle,
                                       &type->head.nodeId, type->head.context,
                                       &head->nodeId, &context);
-                UA_LOCK(server->serviceMutex);
+                UA_WRLOCK(server->serviceMutex);
             }
             UA_NODESTORE_RELEASE(server, type);
         }
@@ -1538,11 +1776,11 @@ recursiveDeconstructNode(UA_Server *server, UA_Session *session,
 
     /* Call the global destructor */
     if(server->config.nodeLifecycle.destructor) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->config.nodeLifecycle.destructor(server, &session->sessionId,
                                                 session->sessionHandle,
                                                 &head->nodeId, context);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* Set the constructed flag to false */
@@ -1617,7 +1855,23 @@ recursiveDeleteNode(UA_Server *server, UA_Session *session,
     if(removeTargetRefs)
         removeIncomingReferences(server, session, head);
 
+    /* The references of the node are removed without deleteOneWayReference */
+    if(ZIP_FIND(UA_InstantiationPlanTree, &server->instantiationPlans, &head->nodeId))
+        AddNode_clearPlans(server);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Drop the cached event propagation of the node */
+    UA_Event_nodeRemoved(server, (const UA_Node*)head);
+#endif
+
     UA_NODESTORE_REMOVE(server, &head->nodeId);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* The MonitoredItems that are not polled report the deleted node. Then
+     * they are polled until a node with the NodeId is added again. */
+    UA_Sampler_sampleOnWrite(server, &head->nodeId);
+    UA_Sampler_updateMode(server, &head->nodeId);
+#endif
 }
 
 static void
@@ -1625,14 +1879,14 @@ deleteNodeOperation(UA_Server *server, UA_Session *session, void *context,
                     const UA_DeleteNodesItem *item, UA_StatusCode *result) {
     /* Do not check access for server */
     if(session != &server->adminSession && server->config.accessControl.allowDeleteNode) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         if ( !server->config.accessControl.allowDeleteNode(server, &server->config.accessControl,
                 &session->sessionId, session->sessionHandle, item)) {
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             *result = UA_STATUSCODE_BADUSERACCESSDENIED;
             return;
         }
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     const UA_Node *node = UA_NODESTORE_GET(server, &item->nodeId);
@@ -1694,9 +1948,9 @@ Service_DeleteNodes(UA_Server *server, UA_Session *session,
 UA_StatusCode
 UA_Server_deleteNode(UA_Server *server, const UA_NodeId nodeId,
                      UA_Boolean deleteReferences) {
-    UA_LOCK(server->serviceMutex)
+    UA_WRLOCK(server->serviceMutex)
     UA_StatusCode retval = deleteNode(server, nodeId, deleteReferences);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -1726,8 +1980,16 @@ struct AddNodeInfo {
 static UA_StatusCode
 addOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
                    const struct AddNodeInfo *info) {
-    return UA_Node_addReference(node, info->refTypeIndex, info->isForward,
-                                info->targetNodeId, info->targetBrowseNameHash);
+    UA_StatusCode retval =
+        UA_Node_addReference(node, info->refTypeIndex, info->isForward,
+                             info->targetNodeId, info->targetBrowseNameHash);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    referenceChangedPlans(server, &node->head.nodeId, info->refTypeIndex, info->isForward);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_Event_referenceChanged(server, info->refTypeIndex);
+#endif
+    return retval;
 }
 
 static UA_StatusCode
@@ -1742,7 +2004,15 @@ deleteOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
     }
     UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
     UA_NODESTORE_RELEASE(server, refType);
-    return UA_Node_deleteReference(node, refTypeIndex, item->isForward, &item->targetNodeId);
+    UA_StatusCode retval =
+        UA_Node_deleteReference(node, refTypeIndex, item->isForward, &item->targetNodeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    referenceChangedPlans(server, &node->head.nodeId, refTypeIndex, item->isForward);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_Event_referenceChanged(server, refTypeIndex);
+#endif
+    return retval;
 }
 
 static void
@@ -1750,15 +2020,15 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
                        const UA_AddReferencesItem *item, UA_StatusCode *retval) {
     /* Check access rights */
     if(session != &server->adminSession && server->config.accessControl.allowAddReference) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         if (!server->config.accessControl.
                 allowAddReference(server, &server->config.accessControl,
                                   &session->sessionId, session->sessionHandle, item)) {
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             *retval = UA_STATUSCODE_BADUSERACCESSDENIED;
             return;
         }
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* TODO: Currently no expandednodeids are allowed */
@@ -1886,9 +2156,9 @@ UA_Server_addReference(UA_Server *server, const UA_NodeId sourceId,
     item.targetNodeId = targetId;
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Operation_addReference(server, &server->adminSession, NULL, &item, &retval);
-    UA_UNLOCK(server->serviceMutex)
+    UA_WRUNLOCK(server->serviceMutex)
     return retval;
 }
 
@@ -1901,15 +2171,15 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
                           const UA_DeleteReferencesItem *item, UA_StatusCode *retval) {
     /* Do not check access for server */
     if(session != &server->adminSession && server->config.accessControl.allowDeleteReference) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         if (!server->config.accessControl.
                 allowDeleteReference(server, &server->config.accessControl,
                                      &session->sessionId, session->sessionHandle, item)){
-            UA_LOCK(server->serviceMutex);
+            UA_WRLOCK(server->serviceMutex);
             *retval = UA_STATUSCODE_BADUSERACCESSDENIED;
             return;
         }
-        UA_LOCK(server->serviceMutex)
+        UA_WRLOCK(server->serviceMutex)
     }
 
     // TODO: Check consistency constraints, remove the references.
@@ -1969,9 +2239,662 @@ UA_Server_deleteReference(UA_Server *server, const UA_NodeId sourceNodeId,
     item.deleteBidirectional = deleteBidirectional;
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Operation_deleteReference(server, &server->adminSession, NULL, &item, &retval);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
+    return retval;
+}
+
+/**********************/
+/* Bulk Instantiation */
+/**********************/
+
+/* The instances and their children are created from the cached plans without
+ * browsing the new nodes again. The references from the new nodes to existing
+ * nodes (the parent, the type definitions and the methods) are collected and
+ * added with a single edit of every existing node at the end. Otherwise every
+ * instance edits (and, with UA_ENABLE_IMMUTABLE_NODES, copies) the type nodes
+ * with their growing list of inverse HasTypeDefinition references. */
+
+typedef struct {
+    UA_Byte refTypeIndex;
+    UA_Boolean isForward;
+    UA_ExpandedNodeId targetId;
+    UA_UInt32 targetNameHash;
+} BulkReference;
+
+/* The references that are added to one node */
+typedef struct BulkReferences {
+    ZIP_ENTRY(BulkReferences) zipfields;
+    UA_NodeId nodeId;
+    size_t refsSize;
+    size_t refsCapacity;
+    BulkReference *refs;
+    UA_Boolean constructed; /* Mark the node as constructed */
+} BulkReferences;
+
+ZIP_HEAD(BulkReferencesTree, BulkReferences);
+typedef struct BulkReferencesTree BulkReferencesTree;
+
+static enum ZIP_CMP
+cmpBulkReferences(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_PROTOTYPE(BulkReferencesTree, BulkReferences, UA_NodeId)
+ZIP_IMPL(BulkReferencesTree, BulkReferences, zipfields, UA_NodeId, nodeId,
+         cmpBulkReferences)
+
+typedef struct {
+    UA_Session *session;
+    BulkReferencesTree existing; /* Added to the existing nodes at the end */
+    size_t createdSize;
+    size_t createdCapacity;
+    UA_NodeId *created; /* The new nodes of the current instance */
+} BulkContext;
+
+/* A child with the declarations it is copied from. Declarations with the same
+ * BrowseName in the type hierarchy are merged into one child. */
+typedef struct {
+    const UA_ReferenceDescription *rd; /* The first declaration */
+    UA_UInt32 nameHash;
+    size_t sourcesSize;
+    const UA_NodeId **sources;
+} BulkChild;
+
+/* Make room for one more element in the array */
+static UA_StatusCode
+growArray(void **array, size_t *capacity, size_t size, size_t elementSize) {
+    if(size < *capacity)
+        return UA_STATUSCODE_GOOD;
+    size_t newCapacity = (*capacity == 0) ? 8 : *capacity * 2;
+    void *newArray = UA_realloc(*array, newCapacity * elementSize);
+    if(!newArray)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    *array = newArray;
+    *capacity = newCapacity;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+addBulkReference(BulkReferences *br, UA_Byte refTypeIndex, UA_Boolean isForward,
+                 const UA_NodeId *targetId, UA_UInt32 targetNameHash) {
+    UA_StatusCode retval = growArray((void**)&br->refs, &br->refsCapacity,
+                                     br->refsSize, sizeof(BulkReference));
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    BulkReference *ref = &br->refs[br->refsSize];
+    UA_ExpandedNodeId_init(&ref->targetId);
+    retval = UA_NodeId_copy(targetId, &ref->targetId.nodeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    ref->refTypeIndex = refTypeIndex;
+    ref->isForward = isForward;
+    ref->targetNameHash = targetNameHash;
+    br->refsSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+clearBulkReferences(BulkReferences *br) {
+    for(size_t i = 0; i < br->refsSize; i++)
+        UA_ExpandedNodeId_clear(&br->refs[i].targetId);
+    UA_free(br->refs);
+    br->refs = NULL;
+    br->refsSize = 0;
+    br->refsCapacity = 0;
+}
+
+/* Collect a reference that is added to an existing node at the end */
+static UA_StatusCode
+addExistingReference(BulkContext *ctx, const UA_NodeId *nodeId, UA_Byte refTypeIndex,
+                     UA_Boolean isForward, const UA_NodeId *targetId,
+                     UA_UInt32 targetNameHash) {
+    BulkReferences *br = ZIP_FIND(BulkReferencesTree, &ctx->existing, nodeId);
+    if(!br) {
+        br = (BulkReferences*)UA_calloc(1, sizeof(BulkReferences));
+        if(!br)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode retval = UA_NodeId_copy(nodeId, &br->nodeId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_free(br);
+            return retval;
+        }
+        ZIP_INSERT(BulkReferencesTree, &ctx->existing, br, ZIP_FFS32(UA_UInt32_random()));
+    }
+    return addBulkReference(br, refTypeIndex, isForward, targetId, targetNameHash);
+}
+
+static UA_StatusCode
+addCreatedNode(BulkContext *ctx, const UA_NodeId *nodeId) {
+    UA_StatusCode retval = growArray((void**)&ctx->created, &ctx->createdCapacity,
+                                     ctx->createdSize, sizeof(UA_NodeId));
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_NodeId_copy(nodeId, &ctx->created[ctx->createdSize]);
+    if(retval == UA_STATUSCODE_GOOD)
+        ctx->createdSize++;
+    return retval;
+}
+
+/* Remove the new nodes of an instance that could not be completed. The
+ * existing nodes have not been edited so far. */
+static void
+removeCreatedNodes(UA_Server *server, BulkContext *ctx) {
+    for(size_t i = ctx->createdSize; i > 0; i--) {
+        UA_NODESTORE_REMOVE(server, &ctx->created[i-1]);
+        UA_NodeId_clear(&ctx->created[i-1]);
+    }
+    ctx->createdSize = 0;
+}
+
+static UA_StatusCode
+addBulkReferencesEdit(UA_Server *server, UA_Session *session,
+                      UA_Node *node, BulkReferences *br) {
+    for(size_t i = 0; i < br->refsSize; i++) {
+        BulkReference *ref = &br->refs[i];
+        struct AddNodeInfo info;
+        info.refTypeIndex = ref->refTypeIndex;
+        info.isForward = ref->isForward;
+        info.targetNodeId = &ref->targetId;
+        info.targetBrowseNameHash = ref->targetNameHash;
+        UA_StatusCode retval = addOneWayReference(server, session, node, &info);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+    if(br->constructed)
+        node->head.constructed = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+getReferenceTypeIndex(UA_Server *server, const UA_NodeId *refTypeId,
+                      UA_Byte *outIndex) {
+    const UA_Node *refType = UA_NODESTORE_GET(server, refTypeId);
+    if(!refType)
+        return UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(refType->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        *outIndex = refType->referenceTypeNode.referenceTypeIndex;
+    else
+        retval = UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+    UA_NODESTORE_RELEASE(server, refType);
+    return retval;
+}
+
+static UA_StatusCode
+bulkAddChildren(UA_Server *server, BulkContext *ctx, const UA_NodeId *parentId,
+                UA_UInt32 parentNameHash, size_t sourcesSize,
+                const UA_NodeId **sources, UA_Boolean parentHasConstructor,
+                UA_Boolean *outConstructed);
+
+/* Copy the declaration and recursively add the children of the declarations */
+static UA_StatusCode
+bulkCopyChild(UA_Server *server, BulkContext *ctx, const UA_NodeId *parentId,
+              UA_UInt32 parentNameHash, const BulkChild *child, UA_Byte refTypeIndex,
+              UA_NodeId *outChildId, UA_Boolean *outConstructed) {
+    const UA_ReferenceDescription *rd = child->rd;
+    UA_Session *session = ctx->session;
+
+    /* Get the type definition. Is there a constructor to call for the child? */
+    const UA_NodeId *typeId = &rd->typeDefinition.nodeId;
+    if(UA_NodeId_isNull(typeId))
+        typeId = (rd->nodeClass == UA_NODECLASS_VARIABLE) ?
+            &baseDataVariableType : &baseObjectType;
+    const UA_Node *type = UA_NODESTORE_GET(server, typeId);
+    if(!type)
+        return UA_STATUSCODE_BADTYPEDEFINITIONINVALID;
+    UA_UInt32 typeNameHash = UA_QualifiedName_hash(&type->head.browseName);
+    UA_Boolean hasConstructor = (server->config.nodeLifecycle.constructor != NULL);
+    if(type->head.nodeClass == UA_NODECLASS_OBJECTTYPE)
+        hasConstructor |= (type->objectTypeNode.lifecycle.constructor != NULL);
+    else if(type->head.nodeClass == UA_NODECLASS_VARIABLETYPE)
+        hasConstructor |= (type->variableTypeNode.lifecycle.constructor != NULL);
+    UA_NODESTORE_RELEASE(server, type);
+
+    /* Make a copy of the declaration without context and NodeId */
+    UA_Node *node;
+    UA_StatusCode retval = UA_NODESTORE_GETCOPY(server, &rd->nodeId.nodeId, &node);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    node->head.context = NULL;
+    node->head.constructed = false;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(node->head.nodeClass == UA_NODECLASS_OBJECT)
+        node->objectNode.monitoredItemQueue = NULL;
+#endif
+    UA_NodeId_clear(&node->head.nodeId);
+    node->head.nodeId.namespaceIndex = parentId->namespaceIndex;
+
+    if(server->config.nodeLifecycle.generateChildNodeId) {
+        UA_WRUNLOCK(server->serviceMutex);
+        retval = server->config.nodeLifecycle.
+            generateChildNodeId(server, &session->sessionId, session->sessionHandle,
+                                &rd->nodeId.nodeId, parentId, &rd->referenceTypeId,
+                                &node->head.nodeId);
+        UA_WRLOCK(server->serviceMutex);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_NODESTORE_DELETE(server, node);
+            return retval;
+        }
+    }
+
+    /* Keep the ModellingRule. Add the references to the parent and to the type
+     * definition before the node is inserted. */
+    UA_ReferenceTypeSet reftypes_modellingrule =
+        UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASMODELLINGRULE);
+    UA_Node_deleteReferencesSubset(node, &reftypes_modellingrule);
+    UA_ExpandedNodeId target;
+    UA_ExpandedNodeId_init(&target);
+    target.nodeId = *parentId;
+    retval = UA_Node_addReference(node, refTypeIndex, false, &target, parentNameHash);
+    target.nodeId = *typeId;
+    retval |= UA_Node_addReference(node, UA_REFERENCETYPEINDEX_HASTYPEDEFINITION,
+                                   true, &target, typeNameHash);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return retval;
+    }
+
+    /* Add the node to the nodestore */
+    retval = UA_NODESTORE_INSERT(server, node, outChildId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = addCreatedNode(ctx, outChildId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_REMOVE(server, outChildId);
+        UA_NodeId_clear(outChildId);
+        return retval;
+    }
+
+    /* The inverse reference is added to the type definition at the end */
+    retval = addExistingReference(ctx, typeId, UA_REFERENCETYPEINDEX_HASTYPEDEFINITION,
+                                  false, outChildId, child->nameHash);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Copy the members of the declarations */
+    return bulkAddChildren(server, ctx, outChildId, child->nameHash, child->sourcesSize,
+                           child->sources, hasConstructor, outConstructed);
+}
+
+/* Add the children of the declarations in the sources to the new parent node.
+ * Then add the references to the children in one edit of the parent. The
+ * parent is marked as constructed if neither the parent nor its children have
+ * a constructor to call. */
+static UA_StatusCode
+bulkAddChildren(UA_Server *server, BulkContext *ctx, const UA_NodeId *parentId,
+                UA_UInt32 parentNameHash, size_t sourcesSize,
+                const UA_NodeId **sources, UA_Boolean parentHasConstructor,
+                UA_Boolean *outConstructed) {
+    UA_Session *session = ctx->session;
+    BulkReferences parentRefs;
+    memset(&parentRefs, 0, sizeof(BulkReferences));
+    parentRefs.constructed = !parentHasConstructor;
+    size_t childrenSize = 0;
+    size_t childrenCapacity = 0;
+    BulkChild *children = NULL;
+    UA_InstantiationPlan **plans = (UA_InstantiationPlan**)
+        UA_calloc(sourcesSize, sizeof(UA_InstantiationPlan*));
+    if(!plans && sourcesSize > 0)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Merge the children of the declarations by their BrowseName */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for(size_t s = 0; s < sourcesSize; s++) {
+        retval = getPlan(server, session, sources[s], false, &plans[s]);
+        if(retval != UA_STATUSCODE_GOOD)
+            goto cleanup;
+        UA_InstantiationPlan *plan = plans[s];
+        for(size_t i = 0; i < plan->childrenSize; i++) {
+            const UA_ReferenceDescription *rd = &plan->children[i];
+            UA_UInt32 nameHash = UA_QualifiedName_hash(&rd->browseName);
+            BulkChild *child = NULL;
+            for(size_t j = 0; j < childrenSize; j++) {
+                if(children[j].nameHash == nameHash &&
+                   UA_QualifiedName_equal(&children[j].rd->browseName, &rd->browseName)) {
+                    child = &children[j];
+                    break;
+                }
+            }
+
+            /* Have a child with that BrowseName. Deep-copy missing members. */
+            if(child) {
+                if(child->rd->nodeClass == UA_NODECLASS_METHOD ||
+                   rd->nodeClass == UA_NODECLASS_METHOD)
+                    continue;
+                const UA_NodeId **newSources = (const UA_NodeId**)
+                    UA_realloc((void*)child->sources,
+                               sizeof(UA_NodeId*) * (child->sourcesSize + 1));
+                if(!newSources) {
+                    retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                    goto cleanup;
+                }
+                newSources[child->sourcesSize] = &rd->nodeId.nodeId;
+                child->sources = newSources;
+                child->sourcesSize++;
+                continue;
+            }
+
+            /* Is the child mandatory? If not, ask the callback whether the
+             * child should be instantiated. */
+            if(!plan->mandatory[i]) {
+                if(!server->config.nodeLifecycle.createOptionalChild)
+                    continue;
+                UA_WRUNLOCK(server->serviceMutex);
+                UA_Boolean create = server->config.nodeLifecycle.
+                    createOptionalChild(server, &session->sessionId,
+                                        session->sessionHandle, &rd->nodeId.nodeId,
+                                        parentId, &rd->referenceTypeId);
+                UA_WRLOCK(server->serviceMutex);
+                if(!create)
+                    continue;
+            }
+
+            retval = growArray((void**)&children, &childrenCapacity,
+                               childrenSize, sizeof(BulkChild));
+            if(retval != UA_STATUSCODE_GOOD)
+                goto cleanup;
+            child = &children[childrenSize];
+            child->rd = rd;
+            child->nameHash = nameHash;
+            child->sourcesSize = 0;
+            child->sources = (const UA_NodeId**)UA_malloc(sizeof(UA_NodeId*));
+            if(!child->sources) {
+                retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                goto cleanup;
+            }
+            child->sources[0] = &rd->nodeId.nodeId;
+            child->sourcesSize = 1;
+            childrenSize++;
+        }
+    }
+
+    /* Create the children */
+    for(size_t i = 0; i < childrenSize; i++) {
+        BulkChild *child = &children[i];
+        const UA_ReferenceDescription *rd = child->rd;
+        UA_Byte refTypeIndex;
+        retval = getReferenceTypeIndex(server, &rd->referenceTypeId, &refTypeIndex);
+        if(retval != UA_STATUSCODE_GOOD)
+            goto cleanup;
+
+        /* Child is a method -> reference the method of the declaration. The
+         * constructor call checks whether the method is constructed. */
+        if(rd->nodeClass == UA_NODECLASS_METHOD) {
+            retval = addBulkReference(&parentRefs, refTypeIndex, true,
+                                      &rd->nodeId.nodeId, child->nameHash);
+            if(retval == UA_STATUSCODE_GOOD)
+                retval = addExistingReference(ctx, &rd->nodeId.nodeId, refTypeIndex,
+                                              false, parentId, parentNameHash);
+            if(retval != UA_STATUSCODE_GOOD)
+                goto cleanup;
+            parentRefs.constructed = false;
+            continue;
+        }
+
+        /* Child is a variable or object */
+        UA_NodeId childId;
+        UA_Boolean childConstructed = false;
+        retval = bulkCopyChild(server, ctx, parentId, parentNameHash, child,
+                               refTypeIndex, &childId, &childConstructed);
+        if(retval != UA_STATUSCODE_GOOD)
+            goto cleanup;
+        retval = addBulkReference(&parentRefs, refTypeIndex, true,
+                                  &childId, child->nameHash);
+        UA_NodeId_clear(&childId);
+        if(retval != UA_STATUSCODE_GOOD)
+            goto cleanup;
+        parentRefs.constructed &= childConstructed;
+    }
+
+    /* Add the references to the children in one edit */
+    if(parentRefs.refsSize > 0 || parentRefs.constructed)
+        retval = UA_Server_editNode(server, session, parentId,
+                                    (UA_EditNodeCallback)addBulkReferencesEdit,
+                                    &parentRefs);
+    *outConstructed = parentRefs.constructed;
+
+ cleanup:
+    for(size_t i = 0; i < childrenSize; i++)
+        UA_free((void*)children[i].sources);
+    UA_free(children);
+    for(size_t s = 0; s < sourcesSize; s++) {
+        if(plans[s])
+            releasePlan(plans[s]);
+    }
+    UA_free(plans);
+    clearBulkReferences(&parentRefs);
+    return retval;
+}
+
+/* Create the instance with the references to the parent and to the type
+ * definition. Then add the children. */
+static UA_StatusCode
+bulkAddInstance(UA_Server *server, BulkContext *ctx, const UA_NodeId *requestedNewNodeId,
+                const UA_NodeId *parentNodeId, UA_Byte parentRefTypeIndex,
+                UA_UInt32 parentNameHash, const UA_QualifiedName *browseName,
+                const UA_Node *type, const UA_InstantiationPlan *typePlan,
+                const UA_NodeId **hierarchy, const UA_ObjectAttributes *attr,
+                void *nodeContext, UA_NodeId *outNewNodeId) {
+    UA_Node *node = UA_NODESTORE_NEW(server, UA_NODECLASS_OBJECT);
+    if(!node)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    node->head.context = nodeContext;
+    UA_StatusCode retval = UA_NodeId_copy(requestedNewNodeId, &node->head.nodeId);
+    retval |= UA_QualifiedName_copy(browseName, &node->head.browseName);
+    retval |= UA_Node_setAttributes(node, attr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES]);
+    UA_ExpandedNodeId target;
+    UA_ExpandedNodeId_init(&target);
+    if(!UA_NodeId_isNull(parentNodeId)) {
+        target.nodeId = *parentNodeId;
+        retval |= UA_Node_addReference(node, parentRefTypeIndex, false,
+                                       &target, parentNameHash);
+    }
+    target.nodeId = type->head.nodeId;
+    retval |= UA_Node_addReference(node, UA_REFERENCETYPEINDEX_HASTYPEDEFINITION, true,
+                                   &target, UA_QualifiedName_hash(&type->head.browseName));
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return retval;
+    }
+
+    retval = UA_NODESTORE_INSERT(server, node, outNewNodeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = addCreatedNode(ctx, outNewNodeId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_REMOVE(server, outNewNodeId);
+        UA_NodeId_clear(outNewNodeId);
+        return retval;
+    }
+
+    /* The references from the parent and the type are added at the end */
+    UA_UInt32 nameHash = UA_QualifiedName_hash(browseName);
+    if(!UA_NodeId_isNull(parentNodeId))
+        retval = addExistingReference(ctx, parentNodeId, parentRefTypeIndex, true,
+                                      outNewNodeId, nameHash);
+    retval |= addExistingReference(ctx, &type->head.nodeId,
+                                   UA_REFERENCETYPEINDEX_HASTYPEDEFINITION,
+                                   false, outNewNodeId, nameHash);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Copy the members of the type and supertypes. The constructors of the
+     * instance are called at the end. */
+    UA_Boolean constructed;
+    return bulkAddChildren(server, ctx, outNewNodeId, nameHash, typePlan->hierarchySize,
+                           hierarchy, true, &constructed);
+}
+
+static UA_StatusCode
+addObjectNodes(UA_Server *server, UA_Session *session, size_t instancesSize,
+               const UA_NodeId *requestedNewNodeIds, const UA_NodeId *parentNodeId,
+               const UA_NodeId *referenceTypeId, const UA_QualifiedName *browseNames,
+               const UA_NodeId *typeDefinition, const UA_ObjectAttributes *attr,
+               void **nodeContexts, UA_NodeId *ids) {
+    /* Check the arguments once for all instances */
+    for(size_t i = 0; i < instancesSize; i++) {
+        if(UA_QualifiedName_isNull(&browseNames[i]))
+            return UA_STATUSCODE_BADBROWSENAMEINVALID;
+        if(requestedNewNodeIds &&
+           requestedNewNodeIds[i].namespaceIndex >= server->namespacesSize)
+            return UA_STATUSCODE_BADNODEIDINVALID;
+    }
+
+    UA_StatusCode retval = checkParentReference(server, session, UA_NODECLASS_OBJECT,
+                                                parentNodeId, referenceTypeId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO_SESSION(&server->config.logger, session,
+                            "AddNodes: The parent reference for the instances is "
+                            "invalid with status code %s", UA_StatusCode_name(retval));
+        return retval;
+    }
+    UA_Byte parentRefTypeIndex = 0;
+    UA_UInt32 parentNameHash = 0;
+    if(!UA_NodeId_isNull(parentNodeId)) {
+        retval = getReferenceTypeIndex(server, referenceTypeId, &parentRefTypeIndex);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        const UA_Node *parent = UA_NODESTORE_GET(server, parentNodeId);
+        if(!parent)
+            return UA_STATUSCODE_BADPARENTNODEIDINVALID;
+        parentNameHash = UA_QualifiedName_hash(&parent->head.browseName);
+        UA_NODESTORE_RELEASE(server, parent);
+    }
+
+    const UA_Node *type = UA_NODESTORE_GET(server, typeDefinition);
+    if(!type)
+        return UA_STATUSCODE_BADTYPEDEFINITIONINVALID;
+    if(type->head.nodeClass != UA_NODECLASS_OBJECTTYPE ||
+       type->objectTypeNode.isAbstract) {
+        UA_LOG_INFO_SESSION(&server->config.logger, session,
+                            "AddNodes: The type of the instances must be an "
+                            "ObjectType and not be abstract");
+        UA_NODESTORE_RELEASE(server, type);
+        return UA_STATUSCODE_BADTYPEDEFINITIONINVALID;
+    }
+
+    /* Get the type hierarchy with the (cached) declarations */
+    BulkContext ctx;
+    memset(&ctx, 0, sizeof(BulkContext));
+    ctx.session = session;
+    const UA_NodeId **hierarchy = NULL;
+    UA_InstantiationPlan *typePlan;
+    retval = getPlan(server, session, typeDefinition, true, &typePlan);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_RELEASE(server, type);
+        return retval;
+    }
+    hierarchy = (const UA_NodeId**)UA_malloc(sizeof(UA_NodeId*) * typePlan->hierarchySize);
+    if(!hierarchy) {
+        retval = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    for(size_t i = 0; i < typePlan->hierarchySize; i++)
+        hierarchy[i] = &typePlan->hierarchy[i];
+
+    /* Create the instances with their children */
+    size_t done = 0;
+    for(; done < instancesSize; done++) {
+        retval = bulkAddInstance(server, &ctx,
+                                 requestedNewNodeIds ? &requestedNewNodeIds[done] :
+                                 &UA_NODEID_NULL, parentNodeId, parentRefTypeIndex,
+                                 parentNameHash, &browseNames[done], type, typePlan,
+                                 hierarchy, attr, nodeContexts ? nodeContexts[done] : NULL,
+                                 &ids[done]);
+        if(retval != UA_STATUSCODE_GOOD) {
+            removeCreatedNodes(server, &ctx);
+            UA_NodeId_clear(&ids[done]);
+            break;
+        }
+        for(size_t i = 0; i < ctx.createdSize; i++)
+            UA_NodeId_clear(&ctx.created[i]);
+        ctx.createdSize = 0;
+    }
+
+    /* Add the references to the parent, the types and the methods */
+    BulkReferences *br;
+    while((br = ZIP_ROOT(&ctx.existing))) {
+        ZIP_REMOVE(BulkReferencesTree, &ctx.existing, br);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = UA_Server_editNode(server, session, &br->nodeId,
+                                        (UA_EditNodeCallback)addBulkReferencesEdit, br);
+        UA_NodeId_clear(&br->nodeId);
+        clearBulkReferences(br);
+        UA_free(br);
+    }
+
+    /* Call the constructors */
+    for(size_t i = 0; i < done && retval == UA_STATUSCODE_GOOD; i++) {
+        const UA_Node *node = UA_NODESTORE_GET(server, &ids[i]);
+        if(!node) {
+            retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            break;
+        }
+        retval = recursiveCallConstructors(server, session, &node->head, type);
+        UA_NODESTORE_RELEASE(server, node);
+    }
+
+    /* Remove all instances if one failed */
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO_SESSION(&server->config.logger, session,
+                            "AddNodes: Adding the instances failed with "
+                            "status code %s", UA_StatusCode_name(retval));
+        UA_ReferenceTypeSet emptyRefs;
+        UA_ReferenceTypeSet_init(&emptyRefs);
+        for(size_t i = 0; i < done; i++) {
+            const UA_Node *node = UA_NODESTORE_GET(server, &ids[i]);
+            if(node) {
+                recursiveDeconstructNode(server, session, &emptyRefs, &node->head);
+                recursiveDeleteNode(server, session, &emptyRefs, &node->head, true);
+                UA_NODESTORE_RELEASE(server, node);
+            }
+            UA_NodeId_clear(&ids[i]);
+        }
+    }
+
+ cleanup:
+    UA_free(hierarchy);
+    UA_free(ctx.created);
+    releasePlan(typePlan);
+    UA_NODESTORE_RELEASE(server, type);
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_addObjectNodes(UA_Server *server, size_t instancesSize,
+                         const UA_NodeId *requestedNewNodeIds,
+                         const UA_NodeId parentNodeId,
+                         const UA_NodeId referenceTypeId,
+                         const UA_QualifiedName *browseNames,
+                         const UA_NodeId typeDefinition,
+                         const UA_ObjectAttributes attr,
+                         void **nodeContexts, UA_NodeId *outNewNodeIds) {
+    if(instancesSize == 0)
+        return UA_STATUSCODE_GOOD;
+    if(!browseNames)
+        return UA_STATUSCODE_BADBROWSENAMEINVALID;
+
+    UA_NodeId *ids = outNewNodeIds;
+    if(!ids) {
+        ids = (UA_NodeId*)UA_Array_new(instancesSize, &UA_TYPES[UA_TYPES_NODEID]);
+        if(!ids)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    } else {
+        for(size_t i = 0; i < instancesSize; i++)
+            UA_NodeId_init(&ids[i]);
+    }
+
+    UA_WRLOCK(server->serviceMutex);
+    UA_StatusCode retval =
+        addObjectNodes(server, &server->adminSession, instancesSize, requestedNewNodeIds,
+                       &parentNodeId, &referenceTypeId, browseNames, &typeDefinition,
+                       &attr, nodeContexts, ids);
+    UA_WRUNLOCK(server->serviceMutex);
+
+    if(ids != outNewNodeIds)
+        UA_Array_delete(ids, instancesSize, &UA_TYPES[UA_TYPES_NODEID]);
     return retval;
 }
 
@@ -1994,12 +2917,16 @@ UA_StatusCode
 UA_Server_setVariableNode_valueCallback(UA_Server *server,
                                         const UA_NodeId nodeId,
                                         const UA_ValueCallback callback) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
                                               (UA_EditNodeCallback)setValueCallback,
                                               /* cast away const because callback uses const anyway */
                                               (UA_ValueCallback *)(uintptr_t) &callback);
-    UA_UNLOCK(server->serviceMutex);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_Sampler_updateMode(server, &nodeId);
+#endif
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -2031,7 +2958,7 @@ UA_Server_addDataSourceVariableNode(UA_Server *server, const UA_NodeId requested
         outNewNodeId = &newNodeId;
     }
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     /* Create the node and add it to the nodestore */
     UA_StatusCode retval = AddNode_raw(server, &server->adminSession, nodeContext,
                                        &item, outNewNodeId);
@@ -2053,7 +2980,7 @@ UA_Server_addDataSourceVariableNode(UA_Server *server, const UA_NodeId requested
     retval = AddNode_finish(server, &server->adminSession, outNewNodeId);
 
  cleanup:
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     if(outNewNodeId == &newNodeId)
         UA_NodeId_clear(&newNodeId);
 
@@ -2076,18 +3003,24 @@ UA_StatusCode
 setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
-    return UA_Server_editNode(server, &server->adminSession, &nodeId,
-                              (UA_EditNodeCallback)setDataSource,
-                              /* casting away const because callback casts it back anyway */
-                              (UA_DataSource *) (uintptr_t)&dataSource);
+    UA_StatusCode retval =
+        UA_Server_editNode(server, &server->adminSession, &nodeId,
+                           (UA_EditNodeCallback)setDataSource,
+                           /* casting away const because callback casts it back anyway */
+                           (UA_DataSource *) (uintptr_t)&dataSource);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_Sampler_updateMode(server, &nodeId);
+#endif
+    return retval;
 }
 
 UA_StatusCode
 UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = setVariableNode_dataSource(server, nodeId, dataSource);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -2114,10 +3047,11 @@ UA_StatusCode
 UA_Server_setVariableNode_valueBackend(UA_Server *server, const UA_NodeId nodeId,
                                        const UA_ValueBackend valueBackend){
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     switch(valueBackend.backendType){
         case UA_VALUEBACKENDTYPE_NONE:
-            return UA_STATUSCODE_BADCONFIGURATIONERROR;
+            retval = UA_STATUSCODE_BADCONFIGURATIONERROR;
+            break;
         case UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK:
             retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
                                         (UA_EditNodeCallback) setValueCallback,
@@ -2140,11 +3074,38 @@ UA_Server_setVariableNode_valueBackend(UA_Server *server, const UA_NodeId nodeId
     /* cast away const because callback uses const anyway */
     // (UA_ValueCallback *)(uintptr_t) &callback);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_Sampler_updateMode(server, &nodeId);
+#endif
+
+    UA_WRUNLOCK(server->serviceMutex);
+    return retval;
+}
+
+#if UA_MULTITHREADING >= 200
+
+static UA_StatusCode
+setVariableNodeThreadSafe(UA_Server *server, UA_Session *session,
+                          UA_Node *node, UA_Boolean *threadSafe) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    node->variableNode.threadSafe = *threadSafe;
+    return UA_STATUSCODE_GOOD;
+}
 
-    UA_UNLOCK(server->serviceMutex);
+UA_StatusCode
+UA_Server_setVariableNodeThreadSafe(UA_Server *server, const UA_NodeId nodeId,
+                                    UA_Boolean threadSafe) {
+    UA_WRLOCK(server->serviceMutex);
+    UA_StatusCode retval =
+        UA_Server_editNode(server, &server->adminSession, &nodeId,
+                           (UA_EditNodeCallback)setVariableNodeThreadSafe, &threadSafe);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
 
+#endif
 
 /************************************/
 /* Special Handling of Method Nodes */
@@ -2273,11 +3234,11 @@ UA_Server_addMethodNode_finish(UA_Server *server, const UA_NodeId nodeId,
                                UA_MethodCallback method,
                                size_t inputArgumentsSize, const UA_Argument* inputArguments,
                                size_t outputArgumentsSize, const UA_Argument* outputArguments) {
-    UA_LOCK(server->serviceMutex)
+    UA_WRLOCK(server->serviceMutex)
     UA_StatusCode retval = UA_Server_addMethodNodeEx_finish(server, nodeId, method,
                                             inputArgumentsSize, inputArguments, UA_NODEID_NULL, NULL,
                                             outputArgumentsSize, outputArguments, UA_NODEID_NULL, NULL);
-    UA_UNLOCK(server->serviceMutex)
+    UA_WRUNLOCK(server->serviceMutex)
     return retval;
 }
 
@@ -2308,12 +3269,12 @@ UA_Server_addMethodNodeEx(UA_Server *server, const UA_NodeId requestedNewNodeId,
         UA_NodeId_init(&newId);
         outNewNodeId = &newId;
     }
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = Operation_addNode_begin(server, &server->adminSession,
                                                    nodeContext, &item, &parentNodeId,
                                                    &referenceTypeId, outNewNodeId);
     if(retval != UA_STATUSCODE_GOOD) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return retval;
     }
 
@@ -2324,7 +3285,7 @@ UA_Server_addMethodNodeEx(UA_Server *server, const UA_NodeId requestedNewNodeId,
                                               outputArgumentsSize, outputArguments,
                                               outputArgumentsRequestedNewNodeId,
                                               outputArgumentsOutNewNodeId);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     if(outNewNodeId == &newId)
         UA_NodeId_clear(&newId);
     return retval;
@@ -2353,9 +3314,9 @@ UA_StatusCode
 UA_Server_setMethodNode_callback(UA_Server *server,
                                  const UA_NodeId methodNodeId,
                                  UA_MethodCallback methodCallback) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retVal = setMethodNode_callback(server, methodNodeId, methodCallback);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retVal;
 }
 
@@ -2387,10 +3348,10 @@ setNodeTypeLifecycle(UA_Server *server, UA_Session *session,
 UA_StatusCode
 UA_Server_setNodeTypeLifecycle(UA_Server *server, UA_NodeId nodeId,
                                UA_NodeTypeLifecycle lifecycle) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
                                              (UA_EditNodeCallback)setNodeTypeLifecycle,
                                               &lifecycle);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return retval;
 }
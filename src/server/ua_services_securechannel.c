@@ -17,11 +17,48 @@
     (type *)((uintptr_t)ptr - offsetof(type,member))
 #endif
 
+/* There may be several channels with the same timeout. The memory address
+ * breaks ties. */
+static enum ZIP_CMP
+cmpChannelTimeout(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a < *b)
+        return ZIP_CMP_LESS;
+    if(*a > *b)
+        return ZIP_CMP_MORE;
+    if(a == b)
+        return ZIP_CMP_EQ;
+    if(a < b)
+        return ZIP_CMP_LESS;
+    return ZIP_CMP_MORE;
+}
+
+ZIP_PROTOTYPE(UA_ChannelTimeoutTree, channel_entry, UA_DateTime)
+ZIP_IMPL(UA_ChannelTimeoutTree, channel_entry, timeoutFields,
+         UA_DateTime, timeout, cmpChannelTimeout)
+
+static void
+setChannelTimeout(UA_Server *server, channel_entry *entry, UA_DateTime timeout) {
+    ZIP_REMOVE(UA_ChannelTimeoutTree, &server->channelsByTimeout, entry);
+    entry->timeout = timeout;
+    ZIP_INSERT(UA_ChannelTimeoutTree, &server->channelsByTimeout, entry,
+               ZIP_FFS32(UA_UInt32_random()));
+}
+
 static void
 removeSecureChannelCallback(void *_, channel_entry *entry) {
     UA_SecureChannel_close(&entry->channel);
 }
 
+/* Add a delayed callback to remove the channel when the currently scheduled
+ * jobs have completed */
+static void
+enqueueSecureChannelCleanup(UA_Server *server, channel_entry *entry) {
+    entry->cleanupCallback.callback = (UA_ApplicationCallback)removeSecureChannelCallback;
+    entry->cleanupCallback.application = NULL;
+    entry->cleanupCallback.data = entry;
+    UA_WorkQueue_enqueueDelayed(&server->workQueue, &entry->cleanupCallback);
+}
+
 /* Half-closes the channel. Will be completely closed / deleted in a deferred
  * callback. Deferring is necessary so we don't remove lists that are still
  * processed upwards the call stack. */
@@ -41,6 +78,7 @@ removeSecureChannel(UA_Server *server, channel_entry *entry,
 
     /* Detach the channel */
     TAILQ_REMOVE(&server->channels, entry, pointers);
+    ZIP_REMOVE(UA_ChannelTimeoutTree, &server->channelsByTimeout, entry);
 
     /* Update the statistics */
     UA_SecureChannelStatistics *scs = &server->serverStats.scs;
@@ -66,14 +104,80 @@ removeSecureChannel(UA_Server *server, channel_entry *entry,
         break;
     }
 
-    /* Add a delayed callback to remove the channel when the currently
-     * scheduled jobs have completed */
-    entry->cleanupCallback.callback = (UA_ApplicationCallback)removeSecureChannelCallback;
-    entry->cleanupCallback.application = NULL;
-    entry->cleanupCallback.data = entry;
-    UA_WorkQueue_enqueueDelayed(&server->workQueue, &entry->cleanupCallback);
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* Cleaned up when the crypto job releases the channel */
+    if(entry->held)
+        return;
+#endif
+
+#if UA_MULTITHREADING >= 200
+    /* Cleaned up when the service job is completed */
+    if(entry->serviceJob)
+        return;
+#endif
+
+    enqueueSecureChannelCleanup(server, entry);
 }
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+void
+UA_Server_holdSecureChannel(UA_Server *server, UA_SecureChannel *channel) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    channel_entry *entry = container_of(channel, channel_entry, channel);
+    UA_assert(!entry->held);
+    entry->held = true;
+}
+
+UA_Boolean
+UA_Server_releaseSecureChannel(UA_Server *server, UA_SecureChannel *channel) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    channel_entry *entry = container_of(channel, channel_entry, channel);
+    entry->held = false;
+    if(entry->channel.state != UA_SECURECHANNELSTATE_CLOSING)
+        return true;
+#if UA_MULTITHREADING >= 200
+    if(entry->serviceJob)
+        return false;
+#endif
+    enqueueSecureChannelCleanup(server, entry);
+    return false;
+}
+
+#endif
+
+#if UA_MULTITHREADING >= 200
+
+void
+UA_Server_beginServiceJob(UA_Server *server, UA_SecureChannel *channel) {
+    (void)server;
+    channel_entry *entry = container_of(channel, channel_entry, channel);
+    UA_assert(!entry->serviceJob);
+    entry->serviceJob = true;
+}
+
+UA_Boolean
+UA_Server_endServiceJob(UA_Server *server, UA_SecureChannel *channel) {
+    channel_entry *entry = container_of(channel, channel_entry, channel);
+    entry->serviceJob = false;
+    if(entry->channel.state != UA_SECURECHANNELSTATE_CLOSING)
+        return true;
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    if(entry->held)
+        return false;
+#endif
+    enqueueSecureChannelCleanup(server, entry);
+    return false;
+}
+
+UA_Boolean
+UA_Server_hasServiceJob(const UA_SecureChannel *channel) {
+    const channel_entry *entry = container_of(channel, channel_entry, channel);
+    return entry->serviceJob;
+}
+
+#endif
+
 void
 UA_Server_deleteSecureChannels(UA_Server *server) {
     channel_entry *entry, *temp;
@@ -81,12 +185,23 @@ UA_Server_deleteSecureChannels(UA_Server *server) {
         removeSecureChannel(server, entry, UA_DIAGNOSTICEVENT_CLOSE);
 }
 
-/* remove channels that were not renewed or who have no connection attached */
+void
+UA_Server_markSecureChannelForCleanup(UA_Server *server, UA_SecureChannel *channel) {
+    channel_entry *entry = container_of(channel, channel_entry, channel);
+    if(entry->channel.state == UA_SECURECHANNELSTATE_CLOSING)
+        return; /* Already removed */
+    setChannelTimeout(server, entry, UA_INT64_MIN);
+}
+
+/* remove channels that were not renewed or who have no connection attached.
+ * Only the channels whose timeout has passed are visited. The position in the
+ * timeout index is updated here when the SecurityToken was renewed. */
 void
 UA_Server_cleanupTimedOutSecureChannels(UA_Server *server,
                                         UA_DateTime nowMonotonic) {
-    channel_entry *entry, *temp;
-    TAILQ_FOREACH_SAFE(entry, &server->channels, pointers, temp) {
+    channel_entry *entry;
+    while((entry = ZIP_MIN(UA_ChannelTimeoutTree, &server->channelsByTimeout)) &&
+          entry->timeout < nowMonotonic) {
         /* The channel was closed internally */
         if(entry->channel.state == UA_SECURECHANNELSTATE_CLOSED ||
            !entry->channel.connection) {
@@ -123,7 +238,11 @@ UA_Server_cleanupTimedOutSecureChannels(UA_Server *server,
             UA_LOG_INFO_CHANNEL(&server->config.logger, &entry->channel,
                                 "SecureChannel has timed out");
             removeSecureChannel(server, entry, UA_DIAGNOSTICEVENT_TIMEOUT);
+            continue;
         }
+
+        /* Check again when the current SecurityToken times out */
+        setChannelTimeout(server, entry, timeout);
     }
 }
 
@@ -165,8 +284,20 @@ UA_Server_createSecureChannel(UA_Server *server, UA_Connection *connection) {
     UA_SecureChannel_init(&entry->channel, &server->config.networkLayers[0].localConnectionConfig);
     entry->channel.certificateVerification = &server->config.certificateVerification;
     entry->channel.processOPNHeader = UA_Server_configSecureChannel;
+#if UA_MULTITHREADING >= 200
+    entry->serviceJob = false;
+#endif
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    entry->held = false;
+    if(server->asyncManager.cryptoWorkersSize > 0)
+        entry->channel.offloadAsymmetricJob = UA_Server_offloadAsymmetricJob;
+#endif
 
     TAILQ_INSERT_TAIL(&server->channels, entry, pointers);
+    /* Check in the next cleanup. The SecurityToken is not set so far. */
+    entry->timeout = UA_DateTime_nowMonotonic();
+    ZIP_INSERT(UA_ChannelTimeoutTree, &server->channelsByTimeout, entry,
+               ZIP_FFS32(UA_UInt32_random()));
     UA_Connection_attachSecureChannel(connection, &entry->channel);
     UA_atomic_addSize(&server->serverStats.scs.currentChannelCount, 1);
     UA_atomic_addSize(&server->serverStats.scs.cumulatedChannelCount, 1);
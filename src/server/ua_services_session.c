@@ -17,12 +17,57 @@
 #include "ua_services.h"
 #include <open62541/types_generated_encoding_binary.h>
 
+/* The sessions are indexed by the hash of their identifier. Ties are broken by
+ * the NodeId order. */
+static enum ZIP_CMP
+cmpSessionKey(const UA_SessionKey *a, const UA_SessionKey *b) {
+    if(a->hash < b->hash)
+        return ZIP_CMP_LESS;
+    if(a->hash > b->hash)
+        return ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(a->id, b->id);
+}
+
+ZIP_PROTOTYPE(UA_SessionTokenTree, session_list_entry, UA_SessionKey)
+ZIP_IMPL(UA_SessionTokenTree, session_list_entry, tokenFields,
+         UA_SessionKey, tokenKey, cmpSessionKey)
+ZIP_PROTOTYPE(UA_SessionIdTree, session_list_entry, UA_SessionKey)
+ZIP_IMPL(UA_SessionIdTree, session_list_entry, idFields,
+         UA_SessionKey, idKey, cmpSessionKey)
+
+/* There may be several sessions with the same timeout. The memory address
+ * breaks ties. */
+static enum ZIP_CMP
+cmpSessionTimeout(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a < *b)
+        return ZIP_CMP_LESS;
+    if(*a > *b)
+        return ZIP_CMP_MORE;
+    if(a == b)
+        return ZIP_CMP_EQ;
+    if(a < b)
+        return ZIP_CMP_LESS;
+    return ZIP_CMP_MORE;
+}
+
+ZIP_PROTOTYPE(UA_SessionTimeoutTree, session_list_entry, UA_DateTime)
+ZIP_IMPL(UA_SessionTimeoutTree, session_list_entry, timeoutFields,
+         UA_DateTime, timeout, cmpSessionTimeout)
+
+static session_list_entry *
+findSessionByToken(UA_Server *server, const UA_NodeId *token) {
+    UA_SessionKey key;
+    key.hash = UA_NodeId_hash(token);
+    key.id = token;
+    return ZIP_FIND(UA_SessionTokenTree, &server->sessionsByToken, &key);
+}
+
 /* Delayed callback to free the session memory */
 static void
 removeSessionCallback(UA_Server *server, session_list_entry *entry) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_Session_deleteMembersCleanup(&entry->session, server);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 void
@@ -48,10 +93,10 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
 
     /* Callback into userland access control */
     if(server->config.accessControl.closeSession) {
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->config.accessControl.closeSession(server, &server->config.accessControl,
                                                   &session->sessionId, session->sessionHandle);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* Detach the Session from the SecureChannel */
@@ -63,6 +108,9 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     /* Detach the session from the session manager and make the capacity
      * available */
     LIST_REMOVE(sentry, pointers);
+    ZIP_REMOVE(UA_SessionTokenTree, &server->sessionsByToken, sentry);
+    ZIP_REMOVE(UA_SessionIdTree, &server->sessionsById, sentry);
+    ZIP_REMOVE(UA_SessionTimeoutTree, &server->sessionsByTimeout, sentry);
     UA_atomic_subUInt32(&server->sessionCount, 1);
     UA_atomic_subSize(&server->serverStats.ss.currentSessionCount, 1);
 
@@ -99,26 +147,35 @@ UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_DiagnosticEvent event) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
-    session_list_entry *entry;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.header.authenticationToken, token)) {
-            UA_Server_removeSession(server, entry, event);
-            return UA_STATUSCODE_GOOD;
-        }
-    }
-    return UA_STATUSCODE_BADSESSIONIDINVALID;
+    session_list_entry *entry = findSessionByToken(server, token);
+    if(!entry)
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_Server_removeSession(server, entry, event);
+    return UA_STATUSCODE_GOOD;
 }
 
+/* Only the sessions whose timeout has passed are visited. The lifetime of a
+ * session is extended with every request. The position in the timeout index is
+ * updated only here when the old timeout is reached. */
 void
 UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
-    session_list_entry *sentry, *temp;
-    LIST_FOREACH_SAFE(sentry, &server->sessions, pointers, temp) {
+    session_list_entry *sentry;
+    while((sentry = ZIP_MIN(UA_SessionTimeoutTree, &server->sessionsByTimeout)) &&
+          sentry->timeout < nowMonotonic) {
         /* Session has timed out? */
-        if(sentry->session.validTill >= nowMonotonic)
+        if(sentry->session.validTill < nowMonotonic) {
+            UA_LOG_INFO_SESSION(&server->config.logger, &sentry->session,
+                                "Session has timed out");
+            UA_Server_removeSession(server, sentry, UA_DIAGNOSTICEVENT_TIMEOUT);
             continue;
-        UA_LOG_INFO_SESSION(&server->config.logger, &sentry->session, "Session has timed out");
-        UA_Server_removeSession(server, sentry, UA_DIAGNOSTICEVENT_TIMEOUT);
+        }
+
+        /* Move to the current timeout */
+        ZIP_REMOVE(UA_SessionTimeoutTree, &server->sessionsByTimeout, sentry);
+        sentry->timeout = sentry->session.validTill;
+        ZIP_INSERT(UA_SessionTimeoutTree, &server->sessionsByTimeout, sentry,
+                   ZIP_FFS32(UA_UInt32_random()));
     }
 }
 
@@ -130,46 +187,40 @@ UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.header.authenticationToken, token))
-            continue;
+    session_list_entry *current = findSessionByToken(server, token);
+    if(!current)
+        return NULL;
 
-        /* Session has timed out */
-        if(UA_DateTime_nowMonotonic() > current->session.validTill) {
-            UA_LOG_INFO_SESSION(&server->config.logger, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    /* Session has timed out */
+    if(UA_DateTime_nowMonotonic() > current->session.validTill) {
+        UA_LOG_INFO_SESSION(&server->config.logger, &current->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &current->session;
 }
 
 UA_Session *
 UA_Server_getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
-
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
-        /* Session has timed out */
-        if(UA_DateTime_nowMonotonic() > current->session.validTill) {
-            UA_LOG_INFO_SESSION(&server->config.logger, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    UA_RWLOCK_ASSERT(server->serviceMutex);
+
+    UA_SessionKey key;
+    key.hash = UA_NodeId_hash(sessionId);
+    key.id = sessionId;
+    session_list_entry *current =
+        ZIP_FIND(UA_SessionIdTree, &server->sessionsById, &key);
+    if(!current)
+        return NULL;
+
+    /* Session has timed out */
+    if(UA_DateTime_nowMonotonic() > current->session.validTill) {
+        UA_LOG_INFO_SESSION(&server->config.logger, &current->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &current->session;
 }
 
 static UA_StatusCode
@@ -241,6 +292,20 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
     UA_Session_updateLifetime(&newentry->session);
 
     LIST_INSERT_HEAD(&server->sessions, newentry, pointers);
+
+    /* Add to the indexes */
+    newentry->tokenKey.id = &newentry->session.header.authenticationToken;
+    newentry->tokenKey.hash = UA_NodeId_hash(newentry->tokenKey.id);
+    ZIP_INSERT(UA_SessionTokenTree, &server->sessionsByToken, newentry,
+               ZIP_FFS32(UA_UInt32_random()));
+    newentry->idKey.id = &newentry->session.sessionId;
+    newentry->idKey.hash = UA_NodeId_hash(newentry->idKey.id);
+    ZIP_INSERT(UA_SessionIdTree, &server->sessionsById, newentry,
+               ZIP_FFS32(UA_UInt32_random()));
+    newentry->timeout = newentry->session.validTill;
+    ZIP_INSERT(UA_SessionTimeoutTree, &server->sessionsByTimeout, newentry,
+               ZIP_FFS32(UA_UInt32_random()));
+
     *session = &newentry->session;
     return UA_STATUSCODE_GOOD;
 }
@@ -387,8 +452,8 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
 }
 
 static UA_StatusCode
-checkSignature(const UA_Server *server, const UA_SecureChannel *channel,
-               UA_Session *session, const UA_ActivateSessionRequest *request) {
+checkSignature(const UA_SecureChannel *channel, const UA_ByteString *serverNonce,
+               const UA_ActivateSessionRequest *request) {
     if(channel->securityMode != UA_MESSAGESECURITYMODE_SIGN &&
        channel->securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
         return UA_STATUSCODE_GOOD;
@@ -404,14 +469,14 @@ checkSignature(const UA_Server *server, const UA_SecureChannel *channel,
     const UA_ByteString *localCertificate = &securityPolicy->localCertificate;
 
     UA_ByteString dataToVerify;
-    size_t dataToVerifySize = localCertificate->length + session->serverNonce.length;
+    size_t dataToVerifySize = localCertificate->length + serverNonce->length;
     UA_StatusCode retval = UA_ByteString_allocBuffer(&dataToVerify, dataToVerifySize);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
     memcpy(dataToVerify.data, localCertificate->data, localCertificate->length);
     memcpy(dataToVerify.data + localCertificate->length,
-           session->serverNonce.data, session->serverNonce.length);
+           serverNonce->data, serverNonce->length);
     retval = securityPolicy->certificateSigningAlgorithm.
         verify(securityPolicy, channel->channelContext, &dataToVerify,
                &request->clientSignature.signature);
@@ -478,6 +543,35 @@ decryptPassword(UA_SecurityPolicy *securityPolicy, void *tempChannelContext,
     UA_ByteString_clear(&decryptedTokenSecret);
     return retval;
 }
+
+static UA_StatusCode
+decryptUserPassword(const UA_SecureChannel *channel, UA_SecurityPolicy *securityPolicy,
+                    const UA_ByteString *serverNonce, UA_UserNameIdentityToken *userToken) {
+    /* Create a temporary channel context if a different SecurityPolicy is
+     * used for the password from the SecureChannel */
+    void *tempChannelContext = channel->channelContext;
+    if(securityPolicy != channel->securityPolicy) {
+        /* TODO: This is a hack. We use our own certificate to create a
+         * channel context. Because the client does not provide one in a
+         * #None SecureChannel. We should not need a ChannelContext at all
+         * for asymmetric decryption where the remote certificate is not
+         * used. */
+        UA_StatusCode retval = securityPolicy->channelModule.
+            newContext(securityPolicy, &securityPolicy->localCertificate,
+                       &tempChannelContext);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    /* Decrypt */
+    UA_StatusCode retval =
+        decryptPassword(securityPolicy, tempChannelContext, serverNonce, userToken);
+
+    /* Remove the temporary channel context */
+    if(securityPolicy != channel->securityPolicy)
+        securityPolicy->channelModule.deleteContext(tempChannelContext);
+    return retval;
+}
 #endif
 
 static void
@@ -545,6 +639,24 @@ selectEndpointAndTokenPolicy(UA_Server *server, UA_SecureChannel *channel,
     }
 }
 
+/* If the userTokenPolicy doesn't specify a security policy the security policy
+ * of the endpoint is used. */
+static UA_SecurityPolicy *
+getUserTokenSecurityPolicy(UA_Server *server, const UA_EndpointDescription *ed,
+                           const UA_UserTokenPolicy *utp) {
+    if(!utp->securityPolicyUri.data)
+        return UA_SecurityPolicy_getSecurityPolicyByUri(server, &ed->securityPolicyUri);
+    return UA_SecurityPolicy_getSecurityPolicyByUri(server, &utp->securityPolicyUri);
+}
+
+/* Results of the asymmetric cryptography that was executed in advance */
+typedef struct {
+    UA_ByteString serverNonce; /* The nonce of the Session used for verification */
+    UA_SecurityPolicy *passwordPolicy; /* NULL if the password is not encrypted */
+    UA_StatusCode signatureResult;
+    UA_StatusCode passwordResult;
+} ActivateSessionVerification;
+
 /* TODO: Check all of the following: The Server shall verify that the
  * Certificate the Client used to create the new SecureChannel is the same as
  * the Certificate used to create the original SecureChannel. In addition, the
@@ -553,10 +665,11 @@ selectEndpointAndTokenPolicy(UA_Server *server, UA_SecureChannel *channel,
  * accepts the new SecureChannel it shall reject requests sent via the old
  * SecureChannel. */
 
-void
-Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
-                        const UA_ActivateSessionRequest *request,
-                        UA_ActivateSessionResponse *response) {
+static void
+activateSession(UA_Server *server, UA_SecureChannel *channel,
+                const UA_ActivateSessionRequest *request,
+                UA_ActivateSessionResponse *response,
+                const ActivateSessionVerification *verified) {
     const UA_EndpointDescription *ed = NULL;
     const UA_UserTokenPolicy *utp = NULL;
     UA_LOCK_ASSERT(server->serviceMutex, 1);
@@ -590,9 +703,23 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
         goto rejected;
     }
 
+    /* The verification was done in advance for a nonce that is no longer
+     * current */
+    if(verified && !UA_ByteString_equal(&verified->serverNonce, &session->serverNonce)) {
+        UA_LOG_WARNING_SESSION(&server->config.logger, session,
+                               "ActivateSession: The ServerNonce has changed "
+                               "during the verification");
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADNONCEINVALID;
+        goto securityRejected;
+    }
+
     /* Check if the signature corresponds to the ServerNonce that was last sent
      * to the client */
-    response->responseHeader.serviceResult = checkSignature(server, channel, session, request);
+    if(verified)
+        response->responseHeader.serviceResult = verified->signatureResult;
+    else
+        response->responseHeader.serviceResult =
+            checkSignature(channel, &session->serverNonce, request);
     if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(&server->config.logger, session,
                                "ActivateSession: Signature check failed with StatusCode %s",
@@ -612,13 +739,7 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
        UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken *)
            request->userIdentityToken.content.decoded.data;
 
-       /* If the userTokenPolicy doesn't specify a security policy the security
-        * policy of the secure channel is used. */
-       UA_SecurityPolicy* securityPolicy;
-       if(!utp->securityPolicyUri.data)
-           securityPolicy = UA_SecurityPolicy_getSecurityPolicyByUri(server, &ed->securityPolicyUri);
-       else
-           securityPolicy = UA_SecurityPolicy_getSecurityPolicyByUri(server, &utp->securityPolicyUri);
+       UA_SecurityPolicy *securityPolicy = getUserTokenSecurityPolicy(server, ed, utp);
        if(!securityPolicy) {
           response->responseHeader.serviceResult = UA_STATUSCODE_BADINTERNALERROR;
           goto rejected;
@@ -634,35 +755,13 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
 #ifdef UA_ENABLE_ENCRYPTION
        /* Encrypted password? */
        if(!UA_String_equal(&securityPolicy->policyUri, &UA_SECURITY_POLICY_NONE_URI)) {
-           /* Create a temporary channel context if a different SecurityPolicy is
-            * used for the password from the SecureChannel */
-           void *tempChannelContext = channel->channelContext;
-           if(securityPolicy != channel->securityPolicy) {
-               /* TODO: This is a hack. We use our own certificate to create a
-                * channel context. Because the client does not provide one in a
-                * #None SecureChannel. We should not need a ChannelContext at all
-                * for asymmetric decryption where the remote certificate is not
-                * used. */
+           if(!verified)
                response->responseHeader.serviceResult =
-                   securityPolicy->channelModule.
-                   newContext(securityPolicy, &securityPolicy->localCertificate,
-                              &tempChannelContext);
-               if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
-                   UA_LOG_WARNING_SESSION(&server->config.logger, session, "ActivateSession: "
-                                          "Failed to create a context for the SecurityPolicy %.*s",
-                                          (int)securityPolicy->policyUri.length,
-                                          securityPolicy->policyUri.data);
-                   goto rejected;
-               }
-           }
-
-           /* Decrypt */
-           response->responseHeader.serviceResult =
-               decryptPassword(securityPolicy, tempChannelContext, &session->serverNonce, userToken);
-
-           /* Remove the temporary channel context */
-           if(securityPolicy != channel->securityPolicy)
-               securityPolicy->channelModule.deleteContext(tempChannelContext);
+                   decryptUserPassword(channel, securityPolicy, &session->serverNonce, userToken);
+           else if(verified->passwordPolicy == securityPolicy)
+               response->responseHeader.serviceResult = verified->passwordResult;
+           else
+               response->responseHeader.serviceResult = UA_STATUSCODE_BADINTERNALERROR;
        }
 
        if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
@@ -725,6 +824,139 @@ rejected:
     UA_atomic_addSize(&server->serverStats.ss.rejectedSessionCount, 1);
 }
 
+void
+Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
+                        const UA_ActivateSessionRequest *request,
+                        UA_ActivateSessionResponse *response) {
+    activateSession(server, channel, request, response, NULL);
+}
+
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+typedef struct {
+    UA_AsyncCryptoJob job;
+    UA_SecureChannel *channel;
+    UA_UInt32 requestId;
+    UA_ActivateSessionRequest request; /* The password is decrypted in-situ */
+    ActivateSessionVerification verification;
+} ActivateSessionJob;
+
+/* Returns NULL if the password of the identity token is not encrypted */
+static UA_SecurityPolicy *
+getPasswordPolicy(UA_Server *server, UA_SecureChannel *channel,
+                  const UA_ExtensionObject *identityToken) {
+    const UA_EndpointDescription *ed = NULL;
+    const UA_UserTokenPolicy *utp = NULL;
+    selectEndpointAndTokenPolicy(server, channel, identityToken, &ed, &utp);
+    if(!ed || utp->tokenType != UA_USERTOKENTYPE_USERNAME)
+        return NULL;
+    UA_SecurityPolicy *securityPolicy = getUserTokenSecurityPolicy(server, ed, utp);
+    if(!securityPolicy ||
+       UA_String_equal(&securityPolicy->policyUri, &UA_SECURITY_POLICY_NONE_URI))
+        return NULL;
+    const UA_UserNameIdentityToken *userToken = (const UA_UserNameIdentityToken*)
+        identityToken->content.decoded.data;
+    if(!UA_String_equal(&userToken->encryptionAlgorithm,
+                        &securityPolicy->asymmetricModule.cryptoModule.encryptionAlgorithm.uri))
+        return NULL;
+    return securityPolicy;
+}
+
+/* Does not access the Session. It might be removed in the meantime. */
+static void
+runActivateSessionJob(UA_Server *server, UA_AsyncCryptoJob *job) {
+    ActivateSessionJob *asj = (ActivateSessionJob*)job;
+    ActivateSessionVerification *v = &asj->verification;
+    v->signatureResult = checkSignature(asj->channel, &v->serverNonce, &asj->request);
+    if(v->signatureResult != UA_STATUSCODE_GOOD || !v->passwordPolicy)
+        return;
+    UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken*)
+        asj->request.userIdentityToken.content.decoded.data;
+    v->passwordResult =
+        decryptUserPassword(asj->channel, v->passwordPolicy, &v->serverNonce, userToken);
+}
+
+static void
+deleteActivateSessionJob(ActivateSessionJob *asj) {
+    UA_ActivateSessionRequest_clear(&asj->request);
+    UA_ByteString_clear(&asj->verification.serverNonce);
+    UA_free(asj);
+}
+
+static void
+completeActivateSessionJob(UA_Server *server, UA_AsyncCryptoJob *job) {
+    ActivateSessionJob *asj = (ActivateSessionJob*)job;
+    UA_SecureChannel *channel = asj->channel;
+    UA_ActivateSessionResponse response;
+    UA_ActivateSessionResponse_init(&response);
+    response.responseHeader.requestHandle = asj->request.requestHeader.requestHandle;
+
+    UA_WRLOCK(server->serviceMutex);
+    UA_Boolean alive = UA_Server_releaseSecureChannel(server, channel);
+    if(alive)
+        activateSession(server, channel, &asj->request, &response, &asj->verification);
+    UA_WRUNLOCK(server->serviceMutex);
+
+    if(alive) {
+        sendResponse(server, NULL, channel, asj->requestId, (UA_Response*)&response,
+                     &UA_TYPES[UA_TYPES_ACTIVATESESSIONRESPONSE]);
+        UA_Server_resumeSecureChannel(server, channel);
+    }
+
+    UA_ActivateSessionResponse_clear(&response);
+    deleteActivateSessionJob(asj);
+}
+
+void
+Service_ActivateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                             UA_UInt32 requestId,
+                             const UA_ActivateSessionRequest *request,
+                             UA_ActivateSessionResponse *response,
+                             UA_Boolean *finished) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+
+    /* Process synchronously if no asymmetric cryptography is required. Also
+     * the errors are created there. */
+    UA_Session *session = getSessionByToken(server, &request->requestHeader.authenticationToken);
+    UA_SecurityPolicy *passwordPolicy = NULL;
+    if(session)
+        passwordPolicy = getPasswordPolicy(server, channel, &request->userIdentityToken);
+    UA_Boolean signature =
+        (channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
+         channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+    if(!session || (!signature && !passwordPolicy)) {
+        activateSession(server, channel, request, response, NULL);
+        return;
+    }
+
+    /* Prepare the job */
+    ActivateSessionJob *asj = (ActivateSessionJob*)UA_calloc(1, sizeof(ActivateSessionJob));
+    if(!asj) {
+        activateSession(server, channel, request, response, NULL);
+        return;
+    }
+    UA_StatusCode res = UA_ActivateSessionRequest_copy(request, &asj->request);
+    res |= UA_ByteString_copy(&session->serverNonce, &asj->verification.serverNonce);
+    if(res != UA_STATUSCODE_GOOD) {
+        deleteActivateSessionJob(asj);
+        activateSession(server, channel, request, response, NULL);
+        return;
+    }
+    asj->job.run = runActivateSessionJob;
+    asj->job.complete = completeActivateSessionJob;
+    asj->channel = channel;
+    asj->requestId = requestId;
+    asj->verification.passwordPolicy = passwordPolicy;
+
+    /* The next messages on the channel are processed after the response */
+    channel->paused = true;
+    UA_Server_holdSecureChannel(server, channel);
+    UA_AsyncManager_enqueueCryptoJob(&server->asyncManager, server, &asj->job);
+    *finished = false;
+}
+
+#endif
+
 void
 Service_CloseSession(UA_Server *server, UA_SecureChannel *channel,
                      const UA_CloseSessionRequest *request,
@@ -265,7 +265,7 @@ referenceTypeIndices(UA_Server *server, const UA_NodeId *refType,
 UA_StatusCode
 UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
                           size_t *resultsSize, UA_ExpandedNodeId **results) {
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
 
     /* Set the list of relevant reference types */
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
@@ -275,7 +275,7 @@ UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
         retval = referenceTypeIndices(server, &bd->referenceTypeId,
                                       &refTypes, bd->includeSubtypes);
         if(retval != UA_STATUSCODE_GOOD) {
-            UA_UNLOCK(server->serviceMutex);
+            UA_RDUNLOCK(server->serviceMutex);
             return retval;
         }
     }
@@ -284,7 +284,7 @@ UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
     retval = browseRecursive(server, 1, &bd->nodeId, &refTypes,
                              bd->browseDirection, false, resultsSize, results);
 
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
     return retval;
 }
 
@@ -339,18 +339,87 @@ struct ContinuationPoint {
 
     UA_ReferenceTypeSet relevantReferences;
 
-    /* The last point in the node references? */
+    /* Cursor into the node references. The ReferenceKind is remembered by its
+     * index and by its ReferenceType/direction, in case the node references
+     * were rearranged in the meantime. Inside the ReferenceKind, the cursor is
+     * the target to be visited next. It is looked up in the id-tree of the
+     * ReferenceKind. So resuming does not depend on the number of references
+     * already returned and targets that are added or removed in the meantime
+     * do not shift the position. If the next target was removed (or removed
+     * and added again), browsing resumes at the first target that was added
+     * after it. The targets are queued in the order of their sequence number. */
+    UA_Boolean resume;
     size_t referenceKindIndex;
-    size_t targetIndex;
+    UA_Byte referenceTypeIndex;
+    UA_Boolean isInverse;
+    UA_UInt32 nextSequence; /* Sequence number of the next target */
+    UA_ReferenceTarget nextTarget; /* Key for the lookup in the id-tree. The
+                                    * targetId is a deep copy. */
 };
 
 ContinuationPoint *
 ContinuationPoint_clear(ContinuationPoint *cp) {
     UA_ByteString_clear(&cp->identifier);
     UA_BrowseDescription_clear(&cp->browseDescription);
+    UA_ExpandedNodeId_clear(&cp->nextTarget.targetId);
     return cp->next;
 }
 
+/* Find the ReferenceKind where the cp stopped. If it no longer exists (all
+ * its targets were removed), the ReferenceKind that took its place is browsed
+ * from the start. */
+static size_t
+resumeReferenceKind(const UA_NodeHead *head, const ContinuationPoint *cp,
+                    UA_Boolean *found) {
+    *found = true;
+    size_t rkIndex = cp->referenceKindIndex;
+    if(rkIndex < head->referencesSize &&
+       head->references[rkIndex].referenceTypeIndex == cp->referenceTypeIndex &&
+       head->references[rkIndex].isInverse == cp->isInverse)
+        return rkIndex;
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        if(head->references[i].referenceTypeIndex == cp->referenceTypeIndex &&
+           head->references[i].isInverse == cp->isInverse)
+            return i;
+    }
+    *found = false;
+    return rkIndex;
+}
+
+/* Find the first target that was not visited before the cp stopped */
+static UA_ReferenceTarget *
+resumeTarget(UA_NodeReferenceKind *rk, ContinuationPoint *cp) {
+    /* Lookup the next target in the id-tree */
+    UA_ReferenceTarget *next =
+        ZIP_FIND(UA_ReferenceTargetIdTree, &rk->refTargetsIdTree, &cp->nextTarget);
+    if(next && next->sequence == cp->nextSequence)
+        return next;
+
+    /* The next target was removed in the meantime. Continue with the first
+     * target that was added after it. The comparison allows the sequence
+     * numbers to wrap around. */
+    UA_ReferenceTarget *targetRef = NULL;
+    TAILQ_FOREACH(targetRef, &rk->queueHead, queuePointers) {
+        if((UA_Int32)(targetRef->sequence - cp->nextSequence) >= 0)
+            break;
+    }
+    return targetRef;
+}
+
+/* Remember where browsing stopped */
+static UA_StatusCode
+saveCursor(ContinuationPoint *cp, size_t referenceKindIndex,
+           const UA_NodeReferenceKind *rk, const UA_ReferenceTarget *next) {
+    UA_ExpandedNodeId_clear(&cp->nextTarget.targetId);
+    cp->resume = true;
+    cp->referenceKindIndex = referenceKindIndex;
+    cp->referenceTypeIndex = rk->referenceTypeIndex;
+    cp->isInverse = rk->isInverse;
+    cp->nextSequence = next->sequence;
+    cp->nextTarget.targetIdHash = next->targetIdHash;
+    return UA_ExpandedNodeId_copy(&next->targetId, &cp->nextTarget.targetId);
+}
+
 /* Target node on top of the stack */
 static UA_StatusCode UA_FUNC_ATTR_WARN_UNUSED_RESULT
 addReferenceDescription(UA_Server *server, RefResult *rr, const UA_NodeReferenceKind *ref,
@@ -419,8 +488,11 @@ browseReferences(UA_Server *server, const UA_NodeHead *head,
     UA_assert(cp != NULL);
     const UA_BrowseDescription *bd= &cp->browseDescription;
 
-    size_t referenceKindIndex = cp->referenceKindIndex;
-    size_t targetIndex = cp->targetIndex;
+    /* Resume where the cp stopped */
+    size_t referenceKindIndex = 0;
+    UA_Boolean resume = cp->resume;
+    if(resume)
+        referenceKindIndex = resumeReferenceKind(head, cp, &resume);
 
     /* Loop over the node's references */
     const UA_Node *target = NULL;
@@ -438,17 +510,15 @@ browseReferences(UA_Server *server, const UA_NodeHead *head,
         if(!UA_ReferenceTypeSet_contains(&cp->relevantReferences, rk->referenceTypeIndex))
             continue;
 
-        /* Loop until we arrive at the saved index */
-        size_t i = 0;
-        UA_ReferenceTarget *targetRef = NULL;
-        TAILQ_FOREACH(targetRef, &rk->queueHead, queuePointers) {
-            if(i == targetIndex)
-                break;
-            i++;
+        /* Resume at the next target of the cp */
+        UA_ReferenceTarget *targetRef = TAILQ_FIRST(&rk->queueHead);
+        if(resume) {
+            targetRef = resumeTarget(rk, cp);
+            resume = false;
         }
 
         /* Loop over the remaining targets */
-        for(; targetRef; ++targetIndex, targetRef = TAILQ_NEXT(targetRef, queuePointers)) {
+        for(; targetRef; targetRef = TAILQ_NEXT(targetRef, queuePointers)) {
             target = NULL;
 
             /* Get the node if it is not a remote reference */
@@ -466,11 +536,9 @@ browseReferences(UA_Server *server, const UA_NodeHead *head,
 
             /* A match! Did we reach maxrefs? */
             if(rr->size >= cp->maxReferences) {
-                cp->referenceKindIndex = referenceKindIndex;
-                cp->targetIndex = targetIndex;
                 if(target)
                     UA_NODESTORE_RELEASE(server, target);
-                return UA_STATUSCODE_GOOD;
+                return saveCursor(cp, referenceKindIndex, rk, targetRef);
             }
 
             /* Copy the node description. Target is on top of the stack */
@@ -480,8 +548,6 @@ browseReferences(UA_Server *server, const UA_NodeHead *head,
             if(retval != UA_STATUSCODE_GOOD)
                 return retval;
         }
-
-        targetIndex = 0; /* Start at index 0 for the next reference kind */
     }
 
     /* The node is done */
@@ -605,8 +671,10 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     UA_Boolean done = browseWithContinuation(server, session, cp, result);
 
     /* Exit early if done or an error occurred */
-    if(done || result->statusCode != UA_STATUSCODE_GOOD)
+    if(done || result->statusCode != UA_STATUSCODE_GOOD) {
+        UA_ExpandedNodeId_clear(&cp->nextTarget.targetId);
         return;
+    }
 
     /* Persist the new continuation point */
 
@@ -614,6 +682,10 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     UA_Guid *ident = NULL;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
 
+    /* Browse can run with the service lock held shared. Serialize the access
+     * to the continuation points of the session. */
+    UA_LOCK(server->continuationPointsMutex);
+
     /* Enough space for the continuation point? */
     if(session->availableContinuationPoints <= 0) {
         retval = UA_STATUSCODE_BADNOCONTINUATIONPOINTS;
@@ -627,8 +699,14 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
         goto cleanup;
     }
     memset(cp2, 0, sizeof(ContinuationPoint));
+    cp2->resume = cp->resume;
     cp2->referenceKindIndex = cp->referenceKindIndex;
-    cp2->targetIndex = cp->targetIndex;
+    cp2->referenceTypeIndex = cp->referenceTypeIndex;
+    cp2->isInverse = cp->isInverse;
+    cp2->nextSequence = cp->nextSequence;
+    cp2->nextTarget.targetIdHash = cp->nextTarget.targetIdHash;
+    cp2->nextTarget.targetId = cp->nextTarget.targetId; /* Move the cursor */
+    UA_ExpandedNodeId_init(&cp->nextTarget.targetId);
     cp2->maxReferences = cp->maxReferences;
     cp2->relevantReferences = cp->relevantReferences;
 
@@ -656,9 +734,12 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     cp2->next = session->continuationPoints;
     session->continuationPoints = cp2;
     --session->availableContinuationPoints;
+    UA_UNLOCK(server->continuationPointsMutex);
     return;
 
  cleanup:
+    UA_UNLOCK(server->continuationPointsMutex);
+    UA_ExpandedNodeId_clear(&cp->nextTarget.targetId);
     if(cp2) {
         ContinuationPoint_clear(cp2);
         UA_free(cp2);
@@ -670,7 +751,7 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
 void Service_Browse(UA_Server *server, UA_Session *session,
                     const UA_BrowseRequest *request, UA_BrowseResponse *response) {
     UA_LOG_DEBUG_SESSION(&server->config.logger, session, "Processing BrowseRequest");
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerBrowse != 0 &&
@@ -697,9 +778,9 @@ UA_Server_browse(UA_Server *server, UA_UInt32 maxReferences,
                  const UA_BrowseDescription *bd) {
     UA_BrowseResult result;
     UA_BrowseResult_init(&result);
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
     Operation_Browse(server, &server->adminSession, &maxReferences, bd, &result);
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
     return result;
 }
 
@@ -766,10 +847,10 @@ UA_Server_browseNext(UA_Server *server, UA_Boolean releaseContinuationPoint,
                      const UA_ByteString *continuationPoint) {
     UA_BrowseResult result;
     UA_BrowseResult_init(&result);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Operation_BrowseNext(server, &server->adminSession, &releaseContinuationPoint,
                          continuationPoint, &result);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return result;
 }
 
@@ -884,7 +965,7 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
                                        const UA_UInt32 *nodeClassMask,
                                        const UA_BrowsePath *path,
                                        UA_BrowsePathResult *result) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     if(path->relativePath.elementsSize <= 0) {
         result->statusCode = UA_STATUSCODE_BADNOTHINGTODO;
@@ -1001,7 +1082,7 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
 UA_BrowsePathResult
 translateBrowsePathToNodeIds(UA_Server *server,
                                        const UA_BrowsePath *browsePath) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
     UA_BrowsePathResult result;
     UA_BrowsePathResult_init(&result);
     UA_UInt32 nodeClassMask = 0; /* All node classes */
@@ -1013,9 +1094,9 @@ translateBrowsePathToNodeIds(UA_Server *server,
 UA_BrowsePathResult
 UA_Server_translateBrowsePathToNodeIds(UA_Server *server,
                                        const UA_BrowsePath *browsePath) {
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
     UA_BrowsePathResult result = translateBrowsePathToNodeIds(server, browsePath);
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
     return result;
 }
 
@@ -1025,7 +1106,7 @@ Service_TranslateBrowsePathsToNodeIds(UA_Server *server, UA_Session *session,
                                       UA_TranslateBrowsePathsToNodeIdsResponse *response) {
     UA_LOG_DEBUG_SESSION(&server->config.logger, session,
                          "Processing TranslateBrowsePathsToNodeIdsRequest");
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerTranslateBrowsePathsToNodeIds != 0 &&
@@ -1046,7 +1127,7 @@ Service_TranslateBrowsePathsToNodeIds(UA_Server *server, UA_Session *session,
 UA_BrowsePathResult
 browseSimplifiedBrowsePath(UA_Server *server, const UA_NodeId origin,
                            size_t browsePathSize, const UA_QualifiedName *browsePath) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_RWLOCK_ASSERT(server->serviceMutex);
 
     /* Construct the BrowsePath */
     UA_BrowsePath bp;
@@ -1077,9 +1158,9 @@ browseSimplifiedBrowsePath(UA_Server *server, const UA_NodeId origin,
 UA_BrowsePathResult
 UA_Server_browseSimplifiedBrowsePath(UA_Server *server, const UA_NodeId origin,
                            size_t browsePathSize, const UA_QualifiedName *browsePath) {
-    UA_LOCK(server->serviceMutex);
+    UA_RDLOCK(server->serviceMutex);
     UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, origin, browsePathSize, browsePath);
-    UA_UNLOCK(server->serviceMutex);
+    UA_RDUNLOCK(server->serviceMutex);
     return bpr;
 }
 
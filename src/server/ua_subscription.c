@@ -282,8 +282,10 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
 #endif
         default:
             UA_assert(dcn != NULL); /* Have at least one change notification */
-            dcn->monitoredItems[dcnPos] = notification->data.dataChange;
-            UA_DataValue_init(&notification->data.dataChange.value);
+            dcn->monitoredItems[dcnPos].clientHandle =
+                notification->data.dataChange.clientHandle;
+            UA_Notification_takeDataValue(notification,
+                                          &dcn->monitoredItems[dcnPos].value);
             dcnPos++;
             break;
         }
@@ -327,9 +329,9 @@ UA_Subscription_nextSequenceNumber(UA_UInt32 sequenceNumber) {
 static void
 publishCallback(UA_Server *server, UA_Subscription *sub) {
     sub->readyNotifications = sub->notificationQueueSize;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_Subscription_publish(server, sub);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 void
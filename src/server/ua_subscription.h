@@ -126,6 +126,11 @@ typedef struct UA_Notification {
     } data;
 } UA_Notification;
 
+/* Take a notification from the pool of the MonitoredItem. Allocates on the heap
+ * if the pool is exhausted. The mon field is set, the content is not
+ * initialized. */
+UA_Notification * UA_Notification_new(UA_MonitoredItem *mon);
+
 /* Ensure enough space is available; Add notification to the linked lists;
  * Increase the counters */
 void UA_Notification_enqueue(UA_Server *server, UA_Subscription *sub,
@@ -135,11 +140,114 @@ void UA_Notification_enqueue(UA_Server *server, UA_Subscription *sub,
  * global queue. Reduce the respective counters. */
 void UA_Notification_dequeue(UA_Server *server, UA_Notification *n);
 
-/* Delete the notification. Must be dequeued first. */
+/* Delete the notification and return it to the pool of the MonitoredItem.
+ * Must be dequeued first. */
 void UA_Notification_delete(UA_Notification *n);
 
+/* Move the DataValue out of a DataChange notification. The value of the
+ * notification can be stored with UA_VARIANT_DATA_SHARED. */
+void UA_Notification_takeDataValue(UA_Notification *n, UA_DataValue *dst);
+
 typedef TAILQ_HEAD(NotificationQueue, UA_Notification) NotificationQueue;
 
+/**
+ * MonitoredItems that sample the same attribute with the same sampling
+ * interval share a sampler. The sampler reads the value once per interval and
+ * hands the sample to all of its MonitoredItems. The filter is then applied
+ * for every MonitoredItem individually. The attributes that depend on the user
+ * (UserWriteMask, UserAccessLevel, UserExecutable) and the values that come
+ * from a callback (onRead, DataSource, external value backend) are sampled per
+ * session. All other samples are read with the admin session and the access
+ * level of the MonitoredItem's session is checked before the value is handed
+ * out.
+ *
+ * With the samplingOnWrite config option, the samplers of variables that store
+ * their value in the node are not polled. They are sampled when the value is
+ * written or the node is deleted. */
+
+typedef struct {
+    UA_NodeId nodeId;
+    UA_UInt32 attributeId;
+    UA_String indexRange;
+    UA_Double samplingInterval;
+    UA_Session *session; /* Only set for the samples that depend on the session */
+} UA_SamplerKey;
+
+typedef struct UA_Sampler {
+    UA_DelayedCallback delayedFreePointers;
+    ZIP_ENTRY(UA_Sampler) zipfields;
+    UA_SamplerKey key;
+    UA_UInt64 callbackId;
+    UA_Boolean registered; /* Cleared when the sampler is removed */
+    UA_Boolean onWrite; /* Sampled when the value is written. Not polled. */
+    LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+    size_t monitoredItemsSize;
+} UA_Sampler;
+
+ZIP_HEAD(UA_SamplerTree, UA_Sampler);
+typedef struct UA_SamplerTree UA_SamplerTree;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+
+/* The where clause is compiled to a single operation. Only the first element
+ * of the ContentFilter is evaluated and only the OfType operator is
+ * supported. */
+typedef enum {
+    UA_EVENTWHEREOP_RESULT, /* Return the result without evaluation */
+    UA_EVENTWHEREOP_OFTYPE  /* Match if the EventType is a subtype of typeId */
+} UA_EventWhereOp;
+
+/* EventFilters are compiled when the MonitoredItem is created. Identical
+ * filters are shared between the MonitoredItems. The result of the last event
+ * is cached. So an event is resolved once per filter and then only projected
+ * into the notifications of the individual MonitoredItems. */
+typedef struct UA_CompiledEventFilter {
+    ZIP_ENTRY(UA_CompiledEventFilter) zipfields;
+    UA_ByteString key; /* Binary encoding of the filter */
+    size_t refCount;
+    UA_EventFilter filter;
+
+    /* Where clause */
+    UA_EventWhereOp whereOp;
+    UA_StatusCode whereResult;
+    UA_NodeId whereTypeId;
+
+    /* Identical select clauses are resolved once. Every select clause points
+     * to a field. Every field points to its first select clause. */
+    size_t *selectFields;
+    size_t fieldsSize;
+    size_t *fieldClauses;
+    UA_Boolean readsNodes; /* Select clauses without a BrowsePath read the
+                            * type node also for transient events */
+
+    /* Result for the last event */
+    UA_UInt64 lastEvent;
+    const UA_Session *lastSession; /* The values are read with the session */
+    UA_StatusCode lastResult;
+    UA_Variant *lastValues; /* fieldsSize entries */
+} UA_CompiledEventFilter;
+
+ZIP_HEAD(UA_EventFilterTree, UA_CompiledEventFilter);
+typedef struct UA_EventFilterTree UA_EventFilterTree;
+
+/* The propagation of events from a source node is resolved once and cached.
+ * The cache is dropped when a reference over which events propagate or the
+ * MonitoredItems of an emitting node change. */
+typedef struct UA_EventSource {
+    ZIP_ENTRY(UA_EventSource) zipfields;
+    UA_NodeId nodeId;
+    UA_StatusCode originResult; /* The source exists below the ObjectsFolder */
+    size_t emitNodesSize;
+    UA_NodeId *emitNodes; /* Objects that emit the events of the source */
+    size_t monitoredItemsSize;
+    UA_MonitoredItem **monitoredItems; /* Listening at the emit nodes */
+} UA_EventSource;
+
+ZIP_HEAD(UA_EventSourceTree, UA_EventSource);
+typedef struct UA_EventSourceTree UA_EventSourceTree;
+
+#endif
+
 struct UA_MonitoredItem {
     UA_DelayedCallback delayedFreePointers;
     LIST_ENTRY(UA_MonitoredItem) listEntry;
@@ -160,7 +268,7 @@ struct UA_MonitoredItem {
     union {
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
         /* If attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER */
-        UA_EventFilter eventFilter;
+        UA_CompiledEventFilter *eventFilter;
 #endif
         /* The DataChangeFilter always contains an absolute deadband definition.
          * Part 8, §6.2 gives the following formula to test for percentage
@@ -179,7 +287,8 @@ struct UA_MonitoredItem {
     UA_Variant lastValue; // TODO: dataEncoding is hardcoded to UA binary
 
     /* Sample Callback */
-    UA_UInt64 sampleCallbackId;
+    UA_Sampler *sampler; /* The sampler shared with other MonitoredItems */
+    LIST_ENTRY(UA_MonitoredItem) samplerEntry;
     UA_ByteString lastSampledValue;
     UA_Boolean sampleCallbackIsRegistered;
 
@@ -191,6 +300,12 @@ struct UA_MonitoredItem {
     UA_UInt32 eventOverflows; /* Separate counter for the queue. Can at most
                                * double the queue size */
 
+    /* Preallocated notifications. The unused notifications form a singly-linked
+     * free list through listEntry.tqe_next. */
+    UA_Notification *notificationPool;
+    size_t notificationPoolSize;
+    UA_Notification *freeNotifications;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     UA_MonitoredItem *next;
 #endif
@@ -202,13 +317,55 @@ struct UA_MonitoredItem {
 
 void UA_MonitoredItem_init(UA_MonitoredItem *mon, UA_Subscription *sub);
 void UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem);
+
+/* Resize the notification pool after mon->maxQueueSize has changed. Queued
+ * notifications are moved into the new pool. The old pool is kept if the
+ * allocation fails. */
+void UA_MonitoredItem_resizeNotificationPool(UA_MonitoredItem *mon);
+
+/* Sample the MonitoredItem individually (outside of its sampler) */
 void UA_MonitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem);
+
+/* Attach the MonitoredItem to the sampler with the same node, attribute and
+ * sampling interval. A new sampler is created if none exists. */
 UA_StatusCode UA_MonitoredItem_registerSampleCallback(UA_Server *server, UA_MonitoredItem *mon);
+
+/* Detach the MonitoredItem from its sampler. The sampler is removed together
+ * with its last MonitoredItem. */
 void UA_MonitoredItem_unregisterSampleCallback(UA_Server *server, UA_MonitoredItem *mon);
 
+/* Sample the value of the node for the samplers that are not polled. Called
+ * after the value was written or the node was deleted. */
+void UA_Sampler_sampleOnWrite(UA_Server *server, const UA_NodeId *nodeId);
+
+/* Decide again whether the samplers of the node are polled or sampled on
+ * write. Called when the value source of the node has changed (DataSource,
+ * value callback or value backend) and when the node was deleted or added. */
+void UA_Sampler_updateMode(UA_Server *server, const UA_NodeId *nodeId);
+
 UA_StatusCode UA_Event_addEventToMonitoredItem(UA_Server *server, const UA_NodeId *event, UA_MonitoredItem *mon);
 UA_StatusCode UA_Event_generateEventId(UA_ByteString *generatedId);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* Get the compiled EventFilter. An identical filter is reused if it exists. */
+UA_StatusCode
+UA_Server_acquireEventFilter(UA_Server *server, const UA_EventFilter *filter,
+                             UA_CompiledEventFilter **out);
+
+/* The compiled filter is removed together with the last MonitoredItem */
+void
+UA_Server_releaseEventFilter(UA_Server *server, UA_CompiledEventFilter *cf);
+
+/* Drop the cached event sources */
+void UA_Event_clearSources(UA_Server *server);
+
+/* A reference was added or removed */
+void UA_Event_referenceChanged(UA_Server *server, UA_Byte refTypeIndex);
+
+/* The node is about to be removed from the nodestore */
+void UA_Event_nodeRemoved(UA_Server *server, const UA_Node *node);
+#endif
+
 /* Remove entries until mon->maxQueueSize is reached. Sets infobits for lost
  * data if required. */
 UA_StatusCode UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon);
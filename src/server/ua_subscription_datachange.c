@@ -75,23 +75,62 @@ updateNeededForFilteredValue(const UA_Variant *value, const UA_Variant *oldValue
     return false;
 }
 
-/* When a change is detected, encoding contains the heap-allocated binary
- * encoded value. The default for changed is false. */
-static UA_StatusCode
-detectValueChangeWithFilter(UA_Server *server, UA_Session *session, UA_MonitoredItem *mon,
-                            UA_DataValue *value, UA_ByteString *encoding, UA_Boolean *changed) {
-    /* Check for absolute deadband */
-    if(UA_DataType_isNumeric(value->value.type) &&
-       mon->filter.dataChangeFilter.deadbandType == UA_DEADBANDTYPE_ABSOLUTE) {
-        UA_assert(value->value.type);
-        if(mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUE ||
-           mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
-            if(!updateNeededForFilteredValue(&value->value, &mon->lastValue,
-                                             mon->filter.dataChangeFilter.deadbandValue))
-                return UA_STATUSCODE_GOOD;
-        }
+/* The binary encoding for the change detection depends on the trigger and
+ * whether the source timestamp is returned. So there are at most four
+ * different encodings for the MonitoredItems of a sampler. */
+#define UA_SAMPLE_ENCODINGS 4
+
+/* Process at most this many MonitoredItems of a sampler without allocating
+ * memory for the list */
+#define UA_SAMPLER_STACKITEMS 64
+
+/* A value that was read for one or more MonitoredItems */
+typedef struct {
+    const UA_Node *node; /* Held with a reference. Can be NULL. */
+    UA_Session *session; /* The session used for reading */
+    UA_DataValue value;  /* Can point into the node. Moved into shared
+                          * storage for the notifications. */
+    UA_ByteString encodings[UA_SAMPLE_ENCODINGS]; /* Cached for the change
+                                                   * detection */
+} UA_Sample;
+
+/* Read the sample. The value can still point into the node. */
+static void
+sampleValue(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+            UA_UInt32 attributeId, const UA_String *indexRange,
+            UA_TimestampsToReturn timestampsToReturn, UA_Sample *sample) {
+    UA_RWLOCK_ASSERT(server->serviceMutex);
+    UA_assert(attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
+
+    memset(sample, 0, sizeof(UA_Sample));
+    sample->session = session;
+    sample->node = UA_NODESTORE_GET(server, nodeId);
+    if(!sample->node) {
+        sample->value.hasStatus = true;
+        sample->value.status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
     }
 
+    UA_ReadValueId rvid;
+    UA_ReadValueId_init(&rvid);
+    rvid.nodeId = *nodeId;
+    rvid.attributeId = attributeId;
+    rvid.indexRange = *indexRange;
+    ReadWithNode(sample->node, server, session, timestampsToReturn, &rvid, &sample->value);
+}
+
+static void
+clearSample(UA_Server *server, UA_Sample *sample) {
+    UA_DataValue_clear(&sample->value); /* Does nothing for UA_VARIANT_DATA_NODELETE */
+    for(size_t i = 0; i < UA_SAMPLE_ENCODINGS; i++)
+        UA_ByteString_clear(&sample->encodings[i]);
+    if(sample->node)
+        UA_NODESTORE_RELEASE(server, sample->node);
+}
+
+/* Encode into a heap-allocated buffer */
+static UA_StatusCode
+encodeDataValue(const UA_DataValue *value, UA_ByteString *encoding) {
     /* Stack-allocate some memory for the value encoding. We might heap-allocate
      * more memory if needed. This is just enough for scalars and small
      * structures. */
@@ -126,74 +165,126 @@ detectValueChangeWithFilter(UA_Server *server, UA_Session *session, UA_Monitored
         return retval;
     }
 
-    /* Has the value changed? */
+    /* Copy the encoding on the heap if necessary */
     valueEncoding.length = (uintptr_t)bufPos - (uintptr_t)valueEncoding.data;
-    *changed = (!mon->lastSampledValue.data ||
-                !UA_String_equal(&valueEncoding, &mon->lastSampledValue));
-
-    /* No change */
-    if(!(*changed)) {
-        if(valueEncoding.data != stackValueEncoding)
-            UA_ByteString_clear(&valueEncoding);
-        return UA_STATUSCODE_GOOD;
-    }
-
-    /* Change detected. Copy encoding on the heap if necessary. */
     if(valueEncoding.data == stackValueEncoding)
         return UA_ByteString_copy(&valueEncoding, encoding);
-
     *encoding = valueEncoding;
     return UA_STATUSCODE_GOOD;
 }
 
-/* Has this sample changed from the last one? The method may allocate additional
- * space for the encoding buffer. Detect the change in encoding->data. */
+/* Has this sample changed from the last one? If cached is set, the encoding is
+ * taken from (or stored in) the sample. Otherwise it is written to
+ * tmpEncoding. The default for changed is false. */
 static UA_StatusCode
-    detectValueChange(UA_Server *server, UA_Session *session, UA_MonitoredItem *mon,
-                  UA_DataValue value, UA_ByteString *encoding, UA_Boolean *changed) {
+detectValueChange(UA_Server *server, UA_MonitoredItem *mon, UA_Sample *sample,
+                  UA_DataValue value, UA_Boolean cached, UA_ByteString *tmpEncoding,
+                  const UA_ByteString **encoding, UA_Boolean *changed) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
 
+    /* Check for absolute deadband */
+    if(UA_DataType_isNumeric(value.value.type) &&
+       mon->filter.dataChangeFilter.deadbandType == UA_DEADBANDTYPE_ABSOLUTE) {
+        if(mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUE ||
+           mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
+            if(!updateNeededForFilteredValue(&value.value, &mon->lastValue,
+                                             mon->filter.dataChangeFilter.deadbandValue))
+                return UA_STATUSCODE_GOOD;
+        }
+    }
+
     /* Apply Filter */
-    if(mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUS)
+    size_t encodingIndex = 1;
+    if(mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUS) {
         value.hasValue = false;
+        encodingIndex = 0;
+    }
 
     value.hasServerTimestamp = false;
     value.hasServerPicoseconds = false;
     if(mon->filter.dataChangeFilter.trigger < UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
         value.hasSourceTimestamp = false;
         value.hasSourcePicoseconds = false;
+    } else {
+        encodingIndex = (value.hasSourceTimestamp) ? 3 : 2;
     }
 
-    /* Detect the value change */
-    return detectValueChangeWithFilter(server, session, mon, &value, encoding, changed);
+    /* Encode the value (if not already cached) */
+    UA_ByteString *enc = tmpEncoding;
+    if(cached)
+        enc = &sample->encodings[encodingIndex];
+    if(!enc->data) {
+        UA_StatusCode retval = encodeDataValue(&value, enc);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    /* Has the value changed? */
+    *encoding = enc;
+    *changed = (!mon->lastSampledValue.data ||
+                !UA_String_equal(enc, &mon->lastSampledValue));
+    return UA_STATUSCODE_GOOD;
 }
 
-/* movedValue returns whether the sample was moved to the notification. The
- * default is false. */
+/* Apply the filter of the MonitoredItem to the sample and enqueue a
+ * notification if required. The sampler is NULL if the MonitoredItem is sampled
+ * individually. */
 static UA_StatusCode
-sampleCallbackWithValue(UA_Server *server, UA_Session *session,
-                        UA_Subscription *sub, UA_MonitoredItem *mon,
-                        UA_DataValue *value, UA_Boolean *movedValue) {
+processSample(UA_Server *server, UA_MonitoredItem *mon,
+              UA_Sampler *sampler, UA_Sample *sample) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
     UA_assert(mon->attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
 
-    /* Contains heap-allocated binary encoding of the value if a change was detected */
-    UA_ByteString binValueEncoding = UA_BYTESTRING_NULL;
+    UA_Subscription *sub = mon->subscription;
+    UA_Session *session = &server->adminSession;
+    if(sub)
+        session = sub->session;
 
-    /* Has the value changed? Allocates memory in binValueEncoding if necessary.
-     * value is edited internally so we make a shallow copy. */
+    /* The view of the MonitoredItem on the sample. Shared samples are read with
+     * the admin session. Check the access level of the MonitoredItem's session
+     * before handing out the value. */
+    UA_DataValue value = sample->value;
+    UA_Boolean cached = true;
+    if(session != sample->session && session && sample->node &&
+       mon->attributeId == UA_ATTRIBUTEID_VALUE) {
+        UA_StatusCode res = checkReadValueAccess(server, session, sample->node);
+        /* The lock was released to check the user access level. The
+         * MonitoredItem could have been removed from the sampler meanwhile. */
+        if(mon->sampler != sampler)
+            return UA_STATUSCODE_GOOD;
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_DataValue_init(&value);
+            value.hasStatus = true;
+            value.status = res;
+            cached = false;
+        }
+    }
+
+    /* Remove the timestamps that were not requested */
+    if(mon->timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE ||
+       mon->timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER) {
+        value.hasServerTimestamp = false;
+        value.hasServerPicoseconds = false;
+    }
+    if(mon->timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER ||
+       mon->timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER) {
+        value.hasSourceTimestamp = false;
+        value.hasSourcePicoseconds = false;
+    }
+
+    /* Has the value changed? */
+    UA_ByteString tmpEncoding = UA_BYTESTRING_NULL;
+    const UA_ByteString *encoding = NULL;
     UA_Boolean changed = false;
-    UA_StatusCode retval = detectValueChange(server, session, mon, *value, &binValueEncoding, &changed);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(&server->config.logger, session, "Subscription %" PRIu32 " | "
-                               "MonitoredItem %" PRIi32 " | Value change detection failed with StatusCode %s",
-                               sub ? sub->subscriptionId : 0, mon->monitoredItemId,
-                               UA_StatusCode_name(retval));
+    UA_StatusCode retval = detectValueChange(server, mon, sample, value, cached,
+                                             &tmpEncoding, &encoding, &changed);
+    if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    }
     if(!changed) {
         UA_LOG_DEBUG_SESSION(&server->config.logger, session, "Subscription %" PRIu32 " | "
                              "MonitoredItem %" PRIi32 " | The value has not changed",
                              sub ? sub->subscriptionId : 0, mon->monitoredItemId);
+        UA_ByteString_clear(&tmpEncoding);
         return UA_STATUSCODE_GOOD;
     }
 
@@ -201,22 +292,28 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
      * Prepare a notification and enqueue it. */
     if(sub) {
         /* Allocate a new notification */
-        UA_Notification *newNotification = (UA_Notification *)UA_malloc(sizeof(UA_Notification));
+        UA_Notification *newNotification = UA_Notification_new(mon);
         if(!newNotification) {
-            UA_ByteString_clear(&binValueEncoding);
+            UA_ByteString_clear(&tmpEncoding);
             return UA_STATUSCODE_BADOUTOFMEMORY;
         }
 
-        /* Set the MonitoredItemNotification */
+        /* Set the MonitoredItemNotification. The sampled value is moved into
+         * shared storage (or copied if it points into the node) on the first
+         * use. The notifications of all MonitoredItems of the sampler then
+         * take a reference. The value may have moved. */
         newNotification->data.dataChange.clientHandle = mon->clientHandle;
-        if(value->value.storageType == UA_VARIANT_DATA) {
-            newNotification->data.dataChange.value = *value; /* Move the value to the notification */
-            *movedValue = true;
-        } else { /* => (value->value.storageType == UA_VARIANT_DATA_NODELETE) */
-            retval = UA_DataValue_copy(value, &newNotification->data.dataChange.value);
+        newNotification->data.dataChange.value = value;
+        UA_Variant_init(&newNotification->data.dataChange.value.value);
+        if(value.value.type) {
+            retval = UA_Variant_share(&sample->value.value);
+            value.value = sample->value.value;
+            if(retval == UA_STATUSCODE_GOOD)
+                retval = UA_Variant_copy(&value.value,
+                                         &newNotification->data.dataChange.value.value);
             if(retval != UA_STATUSCODE_GOOD) {
-                UA_ByteString_clear(&binValueEncoding);
-                UA_free(newNotification);
+                UA_ByteString_clear(&tmpEncoding);
+                UA_Notification_delete(newNotification);
                 return retval;
             }
         }
@@ -228,13 +325,17 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
                              sub ? sub->subscriptionId : 0, mon->monitoredItemId);
 
         /* Enqueue the notification */
-        newNotification->mon = mon;
         UA_Notification_enqueue(server, sub, mon, newNotification);
     }
 
-    /* Store the encoding for comparison */
+    /* Store the encoding for comparison. Don't test the return code of the
+     * copy. If this fails, lastSampledValue is empty and a notification will
+     * be forced for the next sample. */
     UA_ByteString_clear(&mon->lastSampledValue);
-    mon->lastSampledValue = binValueEncoding;
+    if(encoding == &tmpEncoding)
+        mon->lastSampledValue = tmpEncoding;
+    else
+        UA_ByteString_copy(encoding, &mon->lastSampledValue);
 
     /* Store the value for filter comparison (we don't want to decode
      * lastSampledValue in every iteration). Don't test the return code here. If
@@ -247,9 +348,9 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
         mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUE ||
         mon->filter.dataChangeFilter.trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP)) {
         UA_Variant_clear(&mon->lastValue);
-        UA_Variant_copy(&value->value, &mon->lastValue);
+        UA_Variant_copy(&value.value, &mon->lastValue);
 #ifdef UA_ENABLE_DA
-        mon->lastStatus = value->status;
+        mon->lastStatus = value.status;
 #endif
     }
 
@@ -260,74 +361,434 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
         UA_LocalMonitoredItem *localMon = (UA_LocalMonitoredItem*) mon;
         void *nodeContext = NULL;
         getNodeContext(server, mon->monitoredNodeId, &nodeContext);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         localMon->callback.dataChangeCallback(server, mon->monitoredItemId,
                                               localMon->context,
                                               &mon->monitoredNodeId,
                                               nodeContext, mon->attributeId,
-                                              value);
-        UA_LOCK(server->serviceMutex);
+                                              &value);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+processSampleLogged(UA_Server *server, UA_MonitoredItem *mon,
+                    UA_Sampler *sampler, UA_Sample *sample) {
+    UA_StatusCode retval = processSample(server, mon, sampler, sample);
+    if(retval == UA_STATUSCODE_GOOD)
+        return;
+    UA_Subscription *sub = mon->subscription;
+    UA_LOG_WARNING_SESSION(&server->config.logger, sub ? sub->session : &server->adminSession,
+                           "Subscription %" PRIu32 " | MonitoredItem %" PRIi32 " | "
+                           "Sampling returned the statuscode %s",
+                           sub ? sub->subscriptionId : 0, mon->monitoredItemId,
+                           UA_StatusCode_name(retval));
+}
+
+/***********/
+/* Sampler */
+/***********/
+
+/* Order by the NodeId first. So all samplers of a node are adjacent in the
+ * tree. */
+static enum ZIP_CMP
+cmpSamplerKey(const UA_SamplerKey *a, const UA_SamplerKey *b) {
+    UA_Order order = UA_NodeId_order(&a->nodeId, &b->nodeId);
+    if(order != UA_ORDER_EQ)
+        return (enum ZIP_CMP)order;
+    if(a->attributeId != b->attributeId)
+        return (a->attributeId < b->attributeId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->samplingInterval != b->samplingInterval)
+        return (a->samplingInterval < b->samplingInterval) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->session != b->session)
+        return ((uintptr_t)a->session < (uintptr_t)b->session) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->indexRange.length != b->indexRange.length)
+        return (a->indexRange.length < b->indexRange.length) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->indexRange.length == 0)
+        return ZIP_CMP_EQ;
+    int cmp = memcmp(a->indexRange.data, b->indexRange.data, a->indexRange.length);
+    if(cmp == 0)
+        return ZIP_CMP_EQ;
+    return (cmp < 0) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_PROTOTYPE(UA_SamplerTree, UA_Sampler, UA_SamplerKey)
+ZIP_IMPL(UA_SamplerTree, UA_Sampler, zipfields, UA_SamplerKey, key, cmpSamplerKey)
+
+/* Process the sample for all MonitoredItems of the sampler */
+static void
+processSampler(UA_Server *server, UA_Sampler *sampler, UA_Sample *sample) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+
+    /* Processing the sample can release the lock (e.g. for the callback of
+     * local MonitoredItems). Take a snapshot of the MonitoredItems first. The
+     * memory of removed MonitoredItems is freed only in a delayed callback. */
+    UA_MonitoredItem *stackItems[UA_SAMPLER_STACKITEMS];
+    UA_MonitoredItem **items = stackItems;
+    if(sampler->monitoredItemsSize > UA_SAMPLER_STACKITEMS) {
+        items = (UA_MonitoredItem**)
+            UA_malloc(sizeof(UA_MonitoredItem*) * sampler->monitoredItemsSize);
+        if(!items) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Sampling failed with StatusCode %s",
+                           UA_StatusCode_name(UA_STATUSCODE_BADOUTOFMEMORY));
+            return;
+        }
+    }
+
+    size_t itemsSize = 0;
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &sampler->monitoredItems, samplerEntry)
+        items[itemsSize++] = mon;
+
+    for(size_t i = 0; i < itemsSize; i++) {
+        /* Removed from the sampler while the lock was released */
+        if(items[i]->sampler != sampler)
+            continue;
+        processSampleLogged(server, items[i], sampler, sample);
+    }
+
+    if(items != stackItems)
+        UA_free(items);
+}
+
+/* The value is read once with the service lock held shared. So the sampling of
+ * many samplers (and the Read service) can run in parallel on the workers. The
+ * lock is upgraded to apply the filters of the individual MonitoredItems and
+ * to enqueue the notifications. */
+static void
+samplerCallback(UA_Server *server, UA_Sampler *sampler) {
+    UA_RDLOCK(server->serviceMutex);
+    /* The sampler was removed. The memory is freed only in a delayed
+     * callback. */
+    if(!sampler->registered) {
+        UA_RDUNLOCK(server->serviceMutex);
+        return;
+    }
+
+    UA_Session *session = sampler->key.session;
+    if(!session)
+        session = &server->adminSession;
+    UA_Sample sample;
+    sampleValue(server, session, &sampler->key.nodeId, sampler->key.attributeId,
+                &sampler->key.indexRange, UA_TIMESTAMPSTORETURN_BOTH, &sample);
+    UA_RDUNLOCK(server->serviceMutex);
+
+    UA_WRLOCK(server->serviceMutex);
+    if(sampler->registered)
+        processSampler(server, sampler, &sample);
+    clearSample(server, &sample);
+    UA_WRUNLOCK(server->serviceMutex);
+}
+
+/* Sample on write for the variables that store the value in the node */
+static UA_Boolean
+isSampledOnWrite(UA_Server *server, const UA_SamplerKey *key) {
+    if(!server->config.samplingOnWrite || key->attributeId != UA_ATTRIBUTEID_VALUE)
+        return false;
+    const UA_Node *node = UA_NODESTORE_GET(server, &key->nodeId);
+    if(!node)
+        return false;
+    UA_Boolean onWrite =
+        (node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+         node->variableNode.valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+         node->variableNode.valueSource == UA_VALUESOURCE_DATA &&
+         !node->variableNode.value.data.callback.onRead);
+    UA_NODESTORE_RELEASE(server, node);
+    return onWrite;
+}
+
+/* The value of a variable with an onRead callback, a DataSource or an external
+ * value backend is produced for the session that reads. The attributes that
+ * depend on the user also differ between sessions. Such samplers are not
+ * shared between sessions. Local MonitoredItems sample with the admin
+ * session. */
+static UA_Session *
+samplerSession(UA_Server *server, const UA_MonitoredItem *mon) {
+    if(!mon->subscription)
+        return NULL;
+    if(mon->attributeId == UA_ATTRIBUTEID_USERWRITEMASK ||
+       mon->attributeId == UA_ATTRIBUTEID_USERACCESSLEVEL ||
+       mon->attributeId == UA_ATTRIBUTEID_USEREXECUTABLE)
+        return mon->subscription->session;
+    if(mon->attributeId != UA_ATTRIBUTEID_VALUE)
+        return NULL;
+    const UA_Node *node = UA_NODESTORE_GET(server, &mon->monitoredNodeId);
+    if(!node)
+        return NULL;
+    UA_Boolean perSession =
+        (node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+         (node->variableNode.valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE ||
+          node->variableNode.valueSource != UA_VALUESOURCE_DATA ||
+          node->variableNode.value.data.callback.onRead));
+    UA_NODESTORE_RELEASE(server, node);
+    return (perSession) ? mon->subscription->session : NULL;
+}
+
+UA_StatusCode
+UA_MonitoredItem_registerSampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    if(mon->sampleCallbackIsRegistered)
+        return UA_STATUSCODE_GOOD;
+
+    /* Only DataChange MonitoredItems have a callback with a sampling interval */
+    if(mon->attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+        return UA_STATUSCODE_GOOD;
+
+    UA_SamplerKey key;
+    key.nodeId = mon->monitoredNodeId;
+    key.attributeId = mon->attributeId;
+    key.indexRange = mon->indexRange;
+    key.samplingInterval = mon->samplingInterval;
+    key.session = samplerSession(server, mon);
+
+    /* Create a new sampler if none exists */
+    UA_Sampler *sampler = ZIP_FIND(UA_SamplerTree, &server->samplers, &key);
+    if(!sampler) {
+        sampler = (UA_Sampler*)UA_calloc(1, sizeof(UA_Sampler));
+        if(!sampler)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        sampler->key = key;
+        sampler->onWrite = isSampledOnWrite(server, &key);
+        UA_StatusCode retval = UA_NodeId_copy(&key.nodeId, &sampler->key.nodeId);
+        retval |= UA_String_copy(&key.indexRange, &sampler->key.indexRange);
+        if(retval == UA_STATUSCODE_GOOD && !sampler->onWrite)
+            retval = addRepeatedCallback(server, (UA_ServerCallback)samplerCallback,
+                                         sampler, key.samplingInterval,
+                                         &sampler->callbackId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_NodeId_clear(&sampler->key.nodeId);
+            UA_String_clear(&sampler->key.indexRange);
+            UA_free(sampler);
+            return retval;
+        }
+        sampler->registered = true;
+        if(sampler->onWrite)
+            server->samplersOnWrite++;
+        LIST_INIT(&sampler->monitoredItems);
+        ZIP_INSERT(UA_SamplerTree, &server->samplers, sampler,
+                   ZIP_FFS32(UA_UInt32_random()));
+    }
+
+    /* Attach the MonitoredItem */
+    LIST_INSERT_HEAD(&sampler->monitoredItems, mon, samplerEntry);
+    sampler->monitoredItemsSize++;
+    mon->sampler = sampler;
+    mon->sampleCallbackIsRegistered = true;
+    return UA_STATUSCODE_GOOD;
+}
+
 void
-UA_MonitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem)
-{
-    UA_LOCK(server->serviceMutex);
-    monitoredItem_sampleCallback(server, monitoredItem);
-    UA_UNLOCK(server->serviceMutex)
+UA_MonitoredItem_unregisterSampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    if(!mon->sampleCallbackIsRegistered)
+        return;
+
+    /* Detach the MonitoredItem */
+    UA_Sampler *sampler = mon->sampler;
+    LIST_REMOVE(mon, samplerEntry);
+    sampler->monitoredItemsSize--;
+    mon->sampler = NULL;
+    mon->sampleCallbackIsRegistered = false;
+    if(sampler->monitoredItemsSize > 0)
+        return;
+
+    /* Remove the sampler together with the last MonitoredItem. A sampler
+     * callback that is already dispatched checks the registered flag. */
+    if(sampler->onWrite)
+        server->samplersOnWrite--;
+    else
+        removeCallback(server, sampler->callbackId);
+    ZIP_REMOVE(UA_SamplerTree, &server->samplers, sampler);
+    sampler->registered = false;
+    UA_NodeId_clear(&sampler->key.nodeId);
+    UA_String_clear(&sampler->key.indexRange);
+
+    /* No actual callback, just remove the structure */
+    sampler->delayedFreePointers.callback = NULL;
+    UA_WorkQueue_enqueueDelayed(&server->workQueue, &sampler->delayedFreePointers);
+}
+
+/* Collect the samplers of the node. Only those that are sampled on write if
+ * onlyOnWrite is set. Returns the total number of matching samplers. Only the
+ * first foundSize are returned in the found array. */
+static size_t
+findSamplers(UA_Sampler *s, const UA_NodeId *nodeId, UA_Boolean onlyOnWrite,
+             UA_Sampler **found, size_t foundSize, size_t count) {
+    while(s) {
+        UA_Order order = UA_NodeId_order(nodeId, &s->key.nodeId);
+        if(order == UA_ORDER_LESS) {
+            s = ZIP_LEFT(s, zipfields);
+            continue;
+        }
+        if(order == UA_ORDER_MORE) {
+            s = ZIP_RIGHT(s, zipfields);
+            continue;
+        }
+        /* Matching samplers can be in both subtrees */
+        count = findSamplers(ZIP_LEFT(s, zipfields), nodeId, onlyOnWrite,
+                             found, foundSize, count);
+        if(s->onWrite || !onlyOnWrite) {
+            if(count < foundSize)
+                found[count] = s;
+            count++;
+        }
+        s = ZIP_RIGHT(s, zipfields);
+    }
+    return count;
+}
+
+void
+UA_Sampler_sampleOnWrite(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    if(server->samplersOnWrite == 0)
+        return;
+
+    /* Collect the samplers first. Processing the samples can release the
+     * lock. */
+    UA_Sampler *stackSamplers[UA_SAMPLER_STACKITEMS];
+    UA_Sampler **samplers = stackSamplers;
+    size_t samplersSize =
+        findSamplers(ZIP_ROOT(&server->samplers), nodeId, true,
+                     samplers, UA_SAMPLER_STACKITEMS, 0);
+    if(samplersSize == 0)
+        return;
+    if(samplersSize > UA_SAMPLER_STACKITEMS) {
+        samplers = (UA_Sampler**)UA_malloc(sizeof(UA_Sampler*) * samplersSize);
+        if(!samplers) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Sampling failed with StatusCode %s",
+                           UA_StatusCode_name(UA_STATUSCODE_BADOUTOFMEMORY));
+            return;
+        }
+        findSamplers(ZIP_ROOT(&server->samplers), nodeId, true,
+                     samplers, samplersSize, 0);
+    }
+
+    /* Sample and process. The memory of removed samplers is freed only in a
+     * delayed callback. */
+    for(size_t i = 0; i < samplersSize; i++) {
+        UA_Sampler *sampler = samplers[i];
+        if(!sampler->registered)
+            continue;
+        UA_Sample sample;
+        sampleValue(server, &server->adminSession, &sampler->key.nodeId,
+                    sampler->key.attributeId, &sampler->key.indexRange,
+                    UA_TIMESTAMPSTORETURN_BOTH, &sample);
+        processSampler(server, sampler, &sample);
+        clearSample(server, &sample);
+    }
+
+    if(samplers != stackSamplers)
+        UA_free(samplers);
+}
+
+/* The node can get or lose a value callback. Register the MonitoredItems again
+ * if the sampler is (no longer) shared between sessions. The sampler is removed
+ * with its last MonitoredItem. */
+static void
+moveToSessionSamplers(UA_Server *server, UA_Sampler *sampler) {
+    UA_MonitoredItem *mon, *mon_tmp;
+    LIST_FOREACH_SAFE(mon, &sampler->monitoredItems, samplerEntry, mon_tmp) {
+        if(samplerSession(server, mon) == sampler->key.session)
+            continue;
+        UA_MonitoredItem_unregisterSampleCallback(server, mon);
+        UA_StatusCode retval = UA_MonitoredItem_registerSampleCallback(server, mon);
+        if(retval != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Registering the sampler failed with StatusCode %s",
+                           UA_StatusCode_name(retval));
+    }
 }
 
+void
+UA_Sampler_updateMode(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+
+    UA_Sampler *stackSamplers[UA_SAMPLER_STACKITEMS];
+    UA_Sampler **samplers = stackSamplers;
+    size_t samplersSize =
+        findSamplers(ZIP_ROOT(&server->samplers), nodeId, false,
+                     samplers, UA_SAMPLER_STACKITEMS, 0);
+    if(samplersSize == 0)
+        return;
+    if(samplersSize > UA_SAMPLER_STACKITEMS) {
+        samplers = (UA_Sampler**)UA_malloc(sizeof(UA_Sampler*) * samplersSize);
+        if(!samplers) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Updating the sampling mode failed with StatusCode %s",
+                           UA_StatusCode_name(UA_STATUSCODE_BADOUTOFMEMORY));
+            return;
+        }
+        findSamplers(ZIP_ROOT(&server->samplers), nodeId, false,
+                     samplers, samplersSize, 0);
+    }
+
+    for(size_t i = 0; i < samplersSize; i++) {
+        UA_Sampler *sampler = samplers[i];
+        moveToSessionSamplers(server, sampler);
+        if(!server->config.samplingOnWrite || !sampler->registered)
+            continue;
+        UA_Boolean onWrite = isSampledOnWrite(server, &sampler->key);
+        if(onWrite == sampler->onWrite)
+            continue;
+        if(onWrite) {
+            /* Stop polling */
+            removeCallback(server, sampler->callbackId);
+            sampler->onWrite = true;
+            server->samplersOnWrite++;
+            continue;
+        }
+        /* Start polling */
+        UA_StatusCode retval =
+            addRepeatedCallback(server, (UA_ServerCallback)samplerCallback,
+                                sampler, sampler->key.samplingInterval,
+                                &sampler->callbackId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Polling the sampler failed with StatusCode %s",
+                           UA_StatusCode_name(retval));
+            continue;
+        }
+        sampler->onWrite = false;
+        server->samplersOnWrite--;
+    }
+
+    if(samplers != stackSamplers)
+        UA_free(samplers);
+}
+
+/* Sample the MonitoredItem individually with the session of its subscription
+ * (e.g. for the first sample after the MonitoredItem was created) */
 void
 monitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
 
-    UA_Subscription *sub = monitoredItem->subscription;
     UA_Session *session = &server->adminSession;
-    if(sub)
-        session = sub->session;
+    if(monitoredItem->subscription)
+        session = monitoredItem->subscription->session;
 
     UA_LOG_DEBUG_SESSION(&server->config.logger, session, "Subscription %" PRIu32 " | "
                          "MonitoredItem %" PRIi32 " | Sample callback called",
-                         sub ? sub->subscriptionId : 0, monitoredItem->monitoredItemId);
-
-    UA_assert(monitoredItem->attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
-
-    /* Get the node */
-    const UA_Node *node = UA_NODESTORE_GET(server, &monitoredItem->monitoredNodeId);
-
-    /* Sample the value. The sample can still point into the node. */
-    UA_DataValue value;
-    UA_DataValue_init(&value);
-    if(node) {
-        UA_ReadValueId rvid;
-        UA_ReadValueId_init(&rvid);
-        rvid.nodeId = monitoredItem->monitoredNodeId;
-        rvid.attributeId = monitoredItem->attributeId;
-        rvid.indexRange = monitoredItem->indexRange;
-        ReadWithNode(node, server, session, monitoredItem->timestampsToReturn, &rvid, &value);
-    } else {
-        value.hasStatus = true;
-        value.status = UA_STATUSCODE_BADNODEIDUNKNOWN;
-    }
-
-    /* Operate on the sample */
-    UA_Boolean movedValue = false;
-    UA_StatusCode retval = sampleCallbackWithValue(server, session, sub, monitoredItem, &value, &movedValue);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(&server->config.logger, session, "Subscription %" PRIu32 " | "
-                               "MonitoredItem %" PRIi32 " | Sampling returned the statuscode %s",
-                               sub ? sub->subscriptionId : 0, monitoredItem->monitoredItemId,
-                               UA_StatusCode_name(retval));
-    }
+                         monitoredItem->subscription ?
+                         monitoredItem->subscription->subscriptionId : 0,
+                         monitoredItem->monitoredItemId);
+
+    UA_Sample sample;
+    sampleValue(server, session, &monitoredItem->monitoredNodeId,
+                monitoredItem->attributeId, &monitoredItem->indexRange,
+                monitoredItem->timestampsToReturn, &sample);
+    processSampleLogged(server, monitoredItem, NULL, &sample);
+    clearSample(server, &sample);
+}
 
-    /* Delete the sample if it was not moved to the notification. */
-    if(!movedValue)
-        UA_DataValue_clear(&value); /* Does nothing for UA_VARIANT_DATA_NODELETE */
-    if(node)
-        UA_NODESTORE_RELEASE(server, node);
+void
+UA_MonitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem) {
+    UA_WRLOCK(server->serviceMutex);
+    monitoredItem_sampleCallback(server, monitoredItem);
+    UA_WRUNLOCK(server->serviceMutex);
 }
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
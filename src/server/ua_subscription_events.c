@@ -8,6 +8,7 @@
 
 #include "ua_server_internal.h"
 #include "ua_subscription.h"
+#include "ua_types_encoding_binary.h"
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
 
@@ -56,15 +57,84 @@ UA_Event_generateEventId(UA_ByteString *generatedId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* An event is either represented by a node or by a list of fields (transient
+ * event). The fields of transient events are evaluated without the
+ * nodestore. */
+#define UA_EVENT_STANDARDFIELDS 4
+typedef struct {
+    const UA_NodeId *eventNode; /* NULL for transient events */
+
+    /* Transient events only. The standard fields are found before the fields
+     * set by the user. */
+    const UA_NodeId *eventType;
+    UA_EventField standardFields[UA_EVENT_STANDARDFIELDS];
+    size_t fieldsSize;
+    const UA_EventField *fields;
+} UA_EventDescription;
+
+static UA_QualifiedName eventIdName = {0, UA_STRING_STATIC("EventId")};
+static UA_QualifiedName eventTypeName = {0, UA_STRING_STATIC("EventType")};
+static UA_QualifiedName sourceNodeName = {0, UA_STRING_STATIC("SourceNode")};
+static UA_QualifiedName receiveTimeName = {0, UA_STRING_STATIC("ReceiveTime")};
+
+static void
+setStandardField(UA_EventField *field, UA_QualifiedName *name,
+                 void *value, const UA_DataType *type) {
+    field->browsePathSize = 1;
+    field->browsePath = name;
+    UA_Variant_setScalar(&field->value, value, type);
+}
+
+static UA_Boolean
+eventFieldMatches(const UA_EventField *field, size_t browsePathSize,
+                  const UA_QualifiedName *browsePath) {
+    if(field->browsePathSize != browsePathSize)
+        return false;
+    for(size_t i = 0; i < browsePathSize; i++) {
+        if(!UA_QualifiedName_equal(&field->browsePath[i], &browsePath[i]))
+            return false;
+    }
+    return true;
+}
+
+static const UA_EventField *
+findEventField(const UA_EventDescription *ed, size_t browsePathSize,
+               const UA_QualifiedName *browsePath) {
+    for(size_t i = 0; i < UA_EVENT_STANDARDFIELDS; i++) {
+        if(eventFieldMatches(&ed->standardFields[i], browsePathSize, browsePath))
+            return &ed->standardFields[i];
+    }
+    for(size_t i = 0; i < ed->fieldsSize; i++) {
+        if(eventFieldMatches(&ed->fields[i], browsePathSize, browsePath))
+            return &ed->fields[i];
+    }
+    return NULL;
+}
+
+/* Copy the (range of the) field value */
+static UA_StatusCode
+readEventField(const UA_EventField *field, const UA_String *indexRange,
+               UA_Variant *value) {
+    if(indexRange->length == 0)
+        return UA_Variant_copy(&field->value, value);
+    UA_NumericRange range;
+    UA_StatusCode res = UA_NumericRange_parse(&range, *indexRange);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = UA_Variant_copyRange(&field->value, value, range);
+    UA_free(range.dimensions);
+    return res;
+}
+
 UA_StatusCode
 UA_Server_createEvent(UA_Server *server, const UA_NodeId eventType,
                       UA_NodeId *outNodeId) {
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     if(!outNodeId) {
         UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
                      "outNodeId must not be NULL. The event's NodeId must be returned "
                      "so it can be triggered.");
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
@@ -74,7 +144,7 @@ UA_Server_createEvent(UA_Server *server, const UA_NodeId eventType,
                                UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
         UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
                      "Event type must be a subtype of BaseEventType!");
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
@@ -108,7 +178,7 @@ UA_Server_createEvent(UA_Server *server, const UA_NodeId eventType,
         UA_BrowsePathResult_clear(&bpr);
         deleteNode(server, newNodeId, true);
         UA_NodeId_clear(&newNodeId);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return retval;
     }
 
@@ -121,12 +191,12 @@ UA_Server_createEvent(UA_Server *server, const UA_NodeId eventType,
     if(retval != UA_STATUSCODE_GOOD) {
         deleteNode(server, newNodeId, true);
         UA_NodeId_clear(&newNodeId);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         return retval;
     }
 
     *outNodeId = newNodeId;
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -182,10 +252,13 @@ isValidEvent(UA_Server *server, const UA_NodeId *validEventParent,
 
 /* Part 4: 7.4.4.5 SimpleAttributeOperand
  * The clause can point to any attribute of nodes. Either a child of the event
- * node and also the event type. */
+ * node and also the event type. For transient events, only the value of the
+ * fields can be selected. */
 static UA_StatusCode
-resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session, const UA_NodeId *origin,
+resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
+                              const UA_EventDescription *ed,
                               const UA_SimpleAttributeOperand *sao, UA_Variant *value) {
+    const UA_NodeId *origin = ed->eventNode;
     /* Prepare the ReadValueId */
     UA_ReadValueId rvi;
     UA_ReadValueId_init(&rvi);
@@ -201,6 +274,8 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session, const UA_N
       //TODO check for Branches! One Condition could have multiple Branches
       // Set ConditionId
       if(UA_NodeId_equal(&sao->typeDefinitionId, &conditionTypeId)){
+        if(!origin)
+          return UA_STATUSCODE_BADNOTSUPPORTED;
         UA_NodeId conditionId;
         UA_StatusCode retval = UA_getConditionId(server, origin, &conditionId);
         if(retval != UA_STATUSCODE_GOOD)
@@ -223,6 +298,17 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session, const UA_N
         return v.status;
     }
 
+    /* Look up the field of a transient event */
+    if(!origin) {
+        if(sao->attributeId != UA_ATTRIBUTEID_VALUE)
+            return UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+        const UA_EventField *field =
+            findEventField(ed, sao->browsePathSize, sao->browsePath);
+        if(!field)
+            return UA_STATUSCODE_BADNOTFOUND;
+        return readEventField(field, &sao->indexRange, value);
+    }
+
     /* Resolve the browse path */
     UA_BrowsePathResult bpr =
         browseSimplifiedBrowsePath(server, *origin, sao->browsePathSize, sao->browsePath);
@@ -245,16 +331,18 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session, const UA_N
     return v.status;
 }
 
-UA_StatusCode
-UA_Server_evaluateWhereClauseContentFilter(
-    UA_Server *server,
-    const UA_NodeId *eventNode,
-    const UA_ContentFilter *contentFilter) {
-    if(contentFilter->elements == NULL || contentFilter->elementsSize == 0)
-    {
+/**************************/
+/* Compiled Event Filters */
+/**************************/
+
+static void
+compileWhereClause(UA_CompiledEventFilter *cf, const UA_ContentFilter *contentFilter) {
+    cf->whereOp = UA_EVENTWHEREOP_RESULT;
+    cf->whereResult = UA_STATUSCODE_GOOD;
+    if(contentFilter->elements == NULL || contentFilter->elementsSize == 0) {
         /* Nothing to do.*/
         /** @todo Whats the default result?*/
-        return UA_STATUSCODE_GOOD;
+        return;
     }
 
     /* The first element needs to be evaluated, this might be linked to */
@@ -262,149 +350,322 @@ UA_Server_evaluateWhereClauseContentFilter(
     /* See 7.4.1 in Part 4, v1.04-Nov 22, 2017 */
     UA_ContentFilterElement *pElement = &contentFilter->elements[0];
     /** @todo Verify retun types in specification or CTT */
-    switch (pElement->filterOperator)
-    {
-        case UA_FILTEROPERATOR_INVIEW:
-        case UA_FILTEROPERATOR_RELATEDTO:
-        {
-            /*Not allowed for event WhereClause according to 7.17.3 in */
-            /* Part 4, v1.04-Nov 22, 2017*/
-            return UA_STATUSCODE_BADEVENTFILTERINVALID;
+    switch(pElement->filterOperator) {
+    case UA_FILTEROPERATOR_INVIEW:
+    case UA_FILTEROPERATOR_RELATEDTO:
+        /*Not allowed for event WhereClause according to 7.17.3 in */
+        /* Part 4, v1.04-Nov 22, 2017*/
+        cf->whereResult = UA_STATUSCODE_BADEVENTFILTERINVALID;
+        return;
+    case UA_FILTEROPERATOR_EQUALS:
+    case UA_FILTEROPERATOR_ISNULL:
+    case UA_FILTEROPERATOR_GREATERTHAN:
+    case UA_FILTEROPERATOR_LESSTHAN:
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL:
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL:
+    case UA_FILTEROPERATOR_LIKE:
+    case UA_FILTEROPERATOR_NOT:
+    case UA_FILTEROPERATOR_BETWEEN:
+    case UA_FILTEROPERATOR_INLIST:
+    case UA_FILTEROPERATOR_AND:
+    case UA_FILTEROPERATOR_OR:
+    case UA_FILTEROPERATOR_CAST:
+    case UA_FILTEROPERATOR_BITWISEAND:
+    case UA_FILTEROPERATOR_BITWISEOR:
+        cf->whereResult = UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
+        return;
+    case UA_FILTEROPERATOR_OFTYPE: {
+        if(pElement->filterOperandsSize != 1) {
+            cf->whereResult = UA_STATUSCODE_BADFILTEROPERANDCOUNTMISMATCH;
+            return;
         }
-        case UA_FILTEROPERATOR_EQUALS:
-        case UA_FILTEROPERATOR_ISNULL:
-        case UA_FILTEROPERATOR_GREATERTHAN:
-        case UA_FILTEROPERATOR_LESSTHAN:
-        case UA_FILTEROPERATOR_GREATERTHANOREQUAL:
-        case UA_FILTEROPERATOR_LESSTHANOREQUAL:
-        case UA_FILTEROPERATOR_LIKE:
-        case UA_FILTEROPERATOR_NOT:
-        case UA_FILTEROPERATOR_BETWEEN:
-        case UA_FILTEROPERATOR_INLIST:
-        case UA_FILTEROPERATOR_AND:
-        case UA_FILTEROPERATOR_OR:
-        case UA_FILTEROPERATOR_CAST:
-        case UA_FILTEROPERATOR_BITWISEAND:
-        case UA_FILTEROPERATOR_BITWISEOR:
-        {
-            return UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
+        if(pElement->filterOperands[0].content.decoded.type !=
+           &UA_TYPES[UA_TYPES_LITERALOPERAND]) {
+            cf->whereResult = UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
+            return;
         }
-        case UA_FILTEROPERATOR_OFTYPE:
-        {
-            UA_Boolean result = UA_FALSE;
-            if(pElement->filterOperandsSize != 1)
-            {
-                return UA_STATUSCODE_BADFILTEROPERANDCOUNTMISMATCH;
-            }
-            if(pElement->filterOperands[0].content.decoded.type !=
-                &UA_TYPES[UA_TYPES_LITERALOPERAND])
-            {
-                return UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
-            }
-            UA_LiteralOperand *pOperand =
-                (UA_LiteralOperand *) pElement->filterOperands[0].content.decoded.data;
-            if(!UA_Variant_isScalar(&pOperand->value))
-            {
-                return UA_STATUSCODE_BADEVENTFILTERINVALID;
-            }
-
-            if(pOperand->value.type != &UA_TYPES[UA_TYPES_NODEID]
-                || pOperand->value.data == NULL)
-            {
-                result = UA_FALSE;
-            }
-            else {
-                UA_NodeId *pOperandNodeId = (UA_NodeId *) pOperand->value.data;
-                UA_QualifiedName eventTypeQualifiedName = UA_QUALIFIEDNAME(0, "EventType");
-                UA_Variant typeNodeIdVariant;
-                UA_Variant_init(&typeNodeIdVariant);
-                UA_StatusCode readStatusCode =
-                    UA_Server_readObjectProperty(server, *eventNode,
-                                                 eventTypeQualifiedName, &typeNodeIdVariant);
-                if(readStatusCode != UA_STATUSCODE_GOOD)
-                    return readStatusCode;
-
-                if(!UA_Variant_isScalar(&typeNodeIdVariant) ||
-                   typeNodeIdVariant.type != &UA_TYPES[UA_TYPES_NODEID] ||
-                   typeNodeIdVariant.data == NULL) {
-                    UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                                 "EventType has an invalid type.");
-                    UA_Variant_clear(&typeNodeIdVariant);
-                    return UA_STATUSCODE_BADINTERNALERROR;
-                }
-
-                result = isNodeInTree_singleRef(server, (UA_NodeId*) typeNodeIdVariant.data,
-                                                pOperandNodeId, UA_REFERENCETYPEINDEX_HASSUBTYPE);
-                UA_Variant_clear(&typeNodeIdVariant);
-            }
-
-            if(result)
-            {
-                return UA_STATUSCODE_GOOD;
-            }
-            else
-            {
-                return UA_STATUSCODE_BADNOMATCH;
-            }
+        UA_LiteralOperand *pOperand =
+            (UA_LiteralOperand *) pElement->filterOperands[0].content.decoded.data;
+        if(!UA_Variant_isScalar(&pOperand->value)) {
+            cf->whereResult = UA_STATUSCODE_BADEVENTFILTERINVALID;
+            return;
         }
-            break;
-        default:
-            return UA_STATUSCODE_BADFILTEROPERATORINVALID;
-            break;
+        if(pOperand->value.type != &UA_TYPES[UA_TYPES_NODEID] ||
+           pOperand->value.data == NULL) {
+            cf->whereResult = UA_STATUSCODE_BADNOMATCH;
+            return;
         }
+        cf->whereResult = UA_NodeId_copy((UA_NodeId*)pOperand->value.data,
+                                         &cf->whereTypeId);
+        if(cf->whereResult == UA_STATUSCODE_GOOD)
+            cf->whereOp = UA_EVENTWHEREOP_OFTYPE;
+        return;
+    }
+    default:
+        cf->whereResult = UA_STATUSCODE_BADFILTEROPERATORINVALID;
+        return;
+    }
 }
 
-/* Filters the given event with the given filter and writes the results into a
- * notification */
 static UA_StatusCode
-UA_Server_filterEvent(UA_Server *server, UA_Session *session,
-                      const UA_NodeId *eventNode, UA_EventFilter *filter,
-                      UA_EventFieldList *efl) {
-    if(filter->selectClausesSize == 0)
-        return UA_STATUSCODE_BADEVENTFILTERINVALID;
+evaluateWhereClause(UA_Server *server, const UA_EventDescription *ed,
+                    const UA_CompiledEventFilter *cf) {
+    if(cf->whereOp == UA_EVENTWHEREOP_RESULT)
+        return cf->whereResult;
+
+    /* OfType. The type of transient events is known. */
+    UA_Boolean result;
+    if(!ed->eventNode) {
+        result = isNodeInTree_singleRef(server, ed->eventType, &cf->whereTypeId,
+                                        UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    } else {
+        UA_Variant typeNodeIdVariant;
+        UA_Variant_init(&typeNodeIdVariant);
+        UA_StatusCode readStatusCode =
+            readObjectProperty(server, *ed->eventNode, UA_QUALIFIEDNAME(0, "EventType"),
+                               &typeNodeIdVariant);
+        if(readStatusCode != UA_STATUSCODE_GOOD)
+            return readStatusCode;
+
+        if(!UA_Variant_isScalar(&typeNodeIdVariant) ||
+           typeNodeIdVariant.type != &UA_TYPES[UA_TYPES_NODEID] ||
+           typeNodeIdVariant.data == NULL) {
+            UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "EventType has an invalid type.");
+            UA_Variant_clear(&typeNodeIdVariant);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
 
-    UA_StatusCode res =
-        UA_Server_evaluateWhereClauseContentFilter(server, eventNode, &filter->whereClause);
+        result = isNodeInTree_singleRef(server, (UA_NodeId*)typeNodeIdVariant.data,
+                                        &cf->whereTypeId, UA_REFERENCETYPEINDEX_HASSUBTYPE);
+        UA_Variant_clear(&typeNodeIdVariant);
+    }
+    return (result) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADNOMATCH;
+}
+
+static UA_Boolean
+operandEqual(const UA_SimpleAttributeOperand *a, const UA_SimpleAttributeOperand *b) {
+    if(a->attributeId != b->attributeId ||
+       a->browsePathSize != b->browsePathSize ||
+       !UA_NodeId_equal(&a->typeDefinitionId, &b->typeDefinitionId) ||
+       !UA_String_equal(&a->indexRange, &b->indexRange))
+        return false;
+    for(size_t i = 0; i < a->browsePathSize; i++) {
+        if(!UA_QualifiedName_equal(&a->browsePath[i], &b->browsePath[i]))
+            return false;
+    }
+    return true;
+}
+
+static void
+clearCompiledEventFilter(UA_CompiledEventFilter *cf) {
+    UA_ByteString_clear(&cf->key);
+    UA_EventFilter_clear(&cf->filter);
+    UA_NodeId_clear(&cf->whereTypeId);
+    UA_free(cf->selectFields);
+    UA_free(cf->fieldClauses);
+    UA_Array_delete(cf->lastValues, cf->fieldsSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    memset(cf, 0, sizeof(UA_CompiledEventFilter));
+}
+
+static UA_StatusCode
+compileEventFilter(UA_CompiledEventFilter *cf, const UA_EventFilter *filter) {
+    UA_StatusCode res = UA_EventFilter_copy(filter, &cf->filter);
     if(res != UA_STATUSCODE_GOOD)
         return res;
 
-    UA_EventFieldList_init(efl);
-    efl->eventFields = (UA_Variant *)
-        UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(!efl->eventFields)
+    /* A filter without select clauses never matches */
+    if(filter->selectClausesSize == 0) {
+        cf->whereOp = UA_EVENTWHEREOP_RESULT;
+        cf->whereResult = UA_STATUSCODE_BADEVENTFILTERINVALID;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    compileWhereClause(cf, &filter->whereClause);
+
+    /* Map the select clauses to the fields */
+    size_t n = filter->selectClausesSize;
+    cf->selectFields = (size_t*)UA_calloc(n, sizeof(size_t));
+    cf->fieldClauses = (size_t*)UA_calloc(n, sizeof(size_t));
+    if(!cf->selectFields || !cf->fieldClauses)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    efl->eventFieldsSize = filter->selectClausesSize;
-
-    /* EventFilterResult currently isn't being used
-    notification->result.selectClauseResultsSize = filter->selectClausesSize;
-    notification->result.selectClauseResults = (UA_StatusCode *)
-        UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
-    if(!notification->result->selectClauseResults) {
-        UA_EventFieldList_clear(&notification->fields);
-        UA_EventFilterResult_clear(&notification->result);
+    for(size_t i = 0; i < n; i++) {
+        const UA_SimpleAttributeOperand *sao = &filter->selectClauses[i];
+        cf->readsNodes |= (sao->browsePathSize == 0);
+        size_t j = 0;
+        for(; j < cf->fieldsSize; j++) {
+            if(operandEqual(&filter->selectClauses[cf->fieldClauses[j]], sao))
+                break;
+        }
+        if(j == cf->fieldsSize)
+            cf->fieldClauses[cf->fieldsSize++] = i;
+        cf->selectFields[i] = j;
+    }
+
+    cf->lastValues = (UA_Variant*)
+        UA_Array_new(cf->fieldsSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    if(!cf->lastValues)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    return UA_STATUSCODE_GOOD;
+}
+
+static enum ZIP_CMP
+cmpEventFilterKey(const UA_ByteString *a, const UA_ByteString *b) {
+    if(a->length != b->length)
+        return (a->length < b->length) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    int cmp = memcmp(a->data, b->data, a->length);
+    if(cmp == 0)
+        return ZIP_CMP_EQ;
+    return (cmp < 0) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_PROTOTYPE(UA_EventFilterTree, UA_CompiledEventFilter, UA_ByteString)
+ZIP_IMPL(UA_EventFilterTree, UA_CompiledEventFilter, zipfields,
+         UA_ByteString, key, cmpEventFilterKey)
+
+UA_StatusCode
+UA_Server_acquireEventFilter(UA_Server *server, const UA_EventFilter *filter,
+                             UA_CompiledEventFilter **out) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+
+    /* The binary encoding identifies the filter */
+    UA_ByteString key = UA_BYTESTRING_NULL;
+    UA_StatusCode res =
+        UA_ByteString_allocBuffer(&key, UA_calcSizeBinary(filter, &UA_TYPES[UA_TYPES_EVENTFILTER]));
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Byte *bufPos = key.data;
+    const UA_Byte *bufEnd = &key.data[key.length];
+    res = UA_encodeBinary(filter, &UA_TYPES[UA_TYPES_EVENTFILTER],
+                          &bufPos, &bufEnd, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&key);
+        return res;
+    }
+
+    /* Reuse an identical filter */
+    UA_CompiledEventFilter *cf = ZIP_FIND(UA_EventFilterTree, &server->eventFilters, &key);
+    if(cf) {
+        UA_ByteString_clear(&key);
+        cf->refCount++;
+        *out = cf;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Compile a new filter */
+    cf = (UA_CompiledEventFilter*)UA_calloc(1, sizeof(UA_CompiledEventFilter));
+    if(!cf) {
+        UA_ByteString_clear(&key);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
-    */
+    res = compileEventFilter(cf, filter);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&key);
+        clearCompiledEventFilter(cf);
+        UA_free(cf);
+        return res;
+    }
+    cf->key = key;
+    cf->refCount = 1;
+    ZIP_INSERT(UA_EventFilterTree, &server->eventFilters, cf,
+               ZIP_FFS32(UA_UInt32_random()));
+    *out = cf;
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Apply the filter */
+void
+UA_Server_releaseEventFilter(UA_Server *server, UA_CompiledEventFilter *cf) {
+    UA_LOCK_ASSERT(server->serviceMutex, 1);
+    UA_assert(cf->refCount > 0);
+    cf->refCount--;
+    if(cf->refCount > 0)
+        return;
+    ZIP_REMOVE(UA_EventFilterTree, &server->eventFilters, cf);
+    clearCompiledEventFilter(cf);
+    UA_free(cf);
+}
+
+UA_StatusCode
+UA_Server_evaluateWhereClauseContentFilter(
+    UA_Server *server,
+    const UA_NodeId *eventNode,
+    const UA_ContentFilter *contentFilter) {
+    UA_EventDescription ed;
+    memset(&ed, 0, sizeof(UA_EventDescription));
+    ed.eventNode = eventNode;
+    UA_CompiledEventFilter cf;
+    memset(&cf, 0, sizeof(UA_CompiledEventFilter));
+    compileWhereClause(&cf, contentFilter);
+    UA_WRLOCK(server->serviceMutex);
+    UA_StatusCode res = evaluateWhereClause(server, &ed, &cf);
+    UA_WRUNLOCK(server->serviceMutex);
+    clearCompiledEventFilter(&cf);
+    return res;
+}
+
+/* Resolve the fields of the event for the filter. The result is cached for the
+ * current event. The values are read with the session. So the result is only
+ * shared between sessions for transient events where the fields are taken
+ * from the map. */
+static UA_StatusCode
+evaluateEventFilter(UA_Server *server, UA_Session *session,
+                    const UA_EventDescription *ed, UA_CompiledEventFilter *cf) {
+    if(cf->lastEvent == server->eventCounter &&
+       (cf->lastSession == session || (!ed->eventNode && !cf->readsNodes)))
+        return cf->lastResult;
+
+    for(size_t i = 0; i < cf->fieldsSize; i++)
+        UA_Variant_clear(&cf->lastValues[i]);
+    cf->lastEvent = server->eventCounter;
+    cf->lastSession = session;
+    cf->lastResult = evaluateWhereClause(server, ed, cf);
+    if(cf->lastResult != UA_STATUSCODE_GOOD)
+        return cf->lastResult;
 
     /* Check if the browsePath is BaseEventType, in which case nothing more
-     * needs to be checked */
+     * needs to be checked. Otherwise the event must be of the type given in
+     * the select clause. The type of transient events is known. */
     UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
-    for(size_t i = 0; i < filter->selectClausesSize; i++) {
-        if(!UA_NodeId_equal(&filter->selectClauses[i].typeDefinitionId, &baseEventTypeId) &&
-           !isValidEvent(server, &filter->selectClauses[i].typeDefinitionId, eventNode)) {
-            UA_Variant_init(&efl->eventFields[i]);
-            /* EventFilterResult currently isn't being used
-            notification->result.selectClauseResults[i] = UA_STATUSCODE_BADTYPEDEFINITIONINVALID; */
+    for(size_t i = 0; i < cf->fieldsSize; i++) {
+        const UA_SimpleAttributeOperand *sao = &cf->filter.selectClauses[cf->fieldClauses[i]];
+        if(UA_NodeId_equal(&sao->typeDefinitionId, &baseEventTypeId)) {
+            /* Nothing to check */
+        } else if(!ed->eventNode) {
+            if(!isNodeInTree_singleRef(server, ed->eventType, &sao->typeDefinitionId,
+                                       UA_REFERENCETYPEINDEX_HASSUBTYPE))
+                continue;
+        } else if(!isValidEvent(server, &sao->typeDefinitionId, ed->eventNode)) {
             continue;
         }
-
         /* TODO: Put the result into the selectClausResults */
-        resolveSimpleAttributeOperand(server, session, eventNode,
-                                      &filter->selectClauses[i], &efl->eventFields[i]);
+        resolveSimpleAttributeOperand(server, session, ed, sao, &cf->lastValues[i]);
     }
+    return UA_STATUSCODE_GOOD;
+}
 
+/* Filters the given event with the given filter and writes the results into a
+ * notification */
+static UA_StatusCode
+UA_Server_filterEvent(UA_Server *server, UA_Session *session,
+                      const UA_EventDescription *ed, UA_CompiledEventFilter *cf,
+                      UA_EventFieldList *efl) {
+    UA_StatusCode res = evaluateEventFilter(server, session, ed, cf);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Project the fields into the select clauses */
+    UA_EventFieldList_init(efl);
+    efl->eventFields = (UA_Variant *)
+        UA_Array_new(cf->filter.selectClausesSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    if(!efl->eventFields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    efl->eventFieldsSize = cf->filter.selectClausesSize;
+    for(size_t i = 0; i < efl->eventFieldsSize; i++)
+        res |= UA_Variant_copy(&cf->lastValues[cf->selectFields[i]], &efl->eventFields[i]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_EventFieldList_clear(efl);
+        return res;
+    }
     return UA_STATUSCODE_GOOD;
 }
 
@@ -480,10 +741,10 @@ eventSetStandardFields(UA_Server *server, const UA_NodeId *event,
 
 /* Filters an event according to the filter specified by mon and then adds it to
  * mons notification queue */
-UA_StatusCode
-UA_Event_addEventToMonitoredItem(UA_Server *server, const UA_NodeId *event,
-                                 UA_MonitoredItem *mon) {
-    UA_Notification *notification = (UA_Notification *)UA_malloc(sizeof(UA_Notification));
+static UA_StatusCode
+addEventToMonitoredItem(UA_Server *server, const UA_EventDescription *ed,
+                        UA_MonitoredItem *mon) {
+    UA_Notification *notification = UA_Notification_new(mon);
     if(!notification)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -492,10 +753,11 @@ UA_Event_addEventToMonitoredItem(UA_Server *server, const UA_NodeId *event,
 
     /* Apply the filter */
     UA_StatusCode retval =
-        UA_Server_filterEvent(server, session, event, &mon->filter.eventFilter,
+        UA_Server_filterEvent(server, session, ed, mon->filter.eventFilter,
                               &notification->data.event);
     if(retval != UA_STATUSCODE_GOOD) {
-        UA_free(notification);
+        UA_EventFieldList_init(&notification->data.event);
+        UA_Notification_delete(notification);
         if(retval == UA_STATUSCODE_BADNOMATCH)
             return UA_STATUSCODE_GOOD;
         return retval;
@@ -503,15 +765,24 @@ UA_Event_addEventToMonitoredItem(UA_Server *server, const UA_NodeId *event,
     notification->data.event.clientHandle = mon->clientHandle;
 
     /* Enqueue the notification */
-    notification->mon = mon;
     UA_Notification_enqueue(server, sub, mon, notification);
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Event_addEventToMonitoredItem(UA_Server *server, const UA_NodeId *event,
+                                 UA_MonitoredItem *mon) {
+    UA_EventDescription ed;
+    memset(&ed, 0, sizeof(UA_EventDescription));
+    ed.eventNode = event;
+    server->eventCounter++; /* Don't reuse cached filter results */
+    return addEventToMonitoredItem(server, &ed, mon);
+}
+
 #ifdef UA_ENABLE_HISTORIZING
 static void
 setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
-                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId) {
+                   const UA_NodeId *emitNodeId, const UA_EventDescription *ed) {
     UA_Variant historicalEventFilterValue;
     UA_Variant_init(&historicalEventFilterValue);
 
@@ -543,12 +814,17 @@ setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
 
     /* Finally, if found and valid then filter */
     UA_EventFilter *filter = (UA_EventFilter*)historicalEventFilterValue.data;
+    UA_CompiledEventFilter cf;
+    memset(&cf, 0, sizeof(UA_CompiledEventFilter));
     UA_EventFieldList efl;
-    retval = UA_Server_filterEvent(server, &server->adminSession,
-                                   eventNodeId, filter, &efl);
+    UA_EventFieldList_init(&efl);
+    retval = compileEventFilter(&cf, filter);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = UA_Server_filterEvent(server, &server->adminSession, ed, &cf, &efl);
     if(retval == UA_STATUSCODE_GOOD)
         server->config.historyDatabase.setEvent(server, server->config.historyDatabase.context,
                                                 origin, emitNodeId, filter, &efl);
+    clearCompiledEventFilter(&cf);
     UA_Variant_clear(&historicalEventFilterValue);
     UA_EventFieldList_clear(&efl);
 }
@@ -562,39 +838,91 @@ static const UA_NodeId emitReferencesRoots[EMIT_REFS_ROOT_COUNT] =
      {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASEVENTSOURCE}},
      {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASNOTIFIER}}};
 
-UA_StatusCode
-UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
-                       const UA_NodeId origin, UA_ByteString *outEventId,
-                       const UA_Boolean deleteEventNode) {
-    UA_LOCK(server->serviceMutex);
+/*****************/
+/* Event Sources */
+/*****************/
 
-#if UA_LOGLEVEL <= 200
-    UA_LOG_NODEID_WRAP(&origin,
-                       UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                                    "Events: An event is triggered on node %.*s",
-                                    (int)nodeIdStr.length, nodeIdStr.data));
-#endif
+static enum ZIP_CMP
+cmpEventSource(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
 
-#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
-    UA_Boolean isCallerAC = false;
-    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
-        if(!isCallerAC) {
-          UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
-                                  UA_STATUSCODE_BADINVALIDARGUMENT);
-          UA_UNLOCK(server->serviceMutex);
-          return UA_STATUSCODE_BADINVALIDARGUMENT;
+ZIP_PROTOTYPE(UA_EventSourceTree, UA_EventSource, UA_NodeId)
+ZIP_IMPL(UA_EventSourceTree, UA_EventSource, zipfields, UA_NodeId, nodeId, cmpEventSource)
+
+static void
+deleteEventSource(UA_EventSource *es) {
+    UA_NodeId_clear(&es->nodeId);
+    UA_Array_delete(es->emitNodes, es->emitNodesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(es->monitoredItems);
+    UA_free(es);
+}
+
+void
+UA_Event_clearSources(UA_Server *server) {
+    server->eventSourcesVersion++;
+    UA_EventSource *es;
+    while((es = ZIP_ROOT(&server->eventSources))) {
+        ZIP_REMOVE(UA_EventSourceTree, &server->eventSources, es);
+        deleteEventSource(es);
+    }
+}
+
+void
+UA_Event_referenceChanged(UA_Server *server, UA_Byte refTypeIndex) {
+    if(!ZIP_ROOT(&server->eventSources))
+        return;
+    /* A new subtype can change the ReferenceTypes that propagate events */
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE ||
+       UA_ReferenceTypeSet_contains(&server->eventRefTypes, refTypeIndex))
+        UA_Event_clearSources(server);
+}
+
+void
+UA_Event_nodeRemoved(UA_Server *server, const UA_Node *node) {
+    /* The MonitoredItems of the node no longer receive events */
+    if(node->head.nodeClass == UA_NODECLASS_OBJECT &&
+       node->objectNode.monitoredItemQueue) {
+        UA_Event_clearSources(server);
+        return;
+    }
+    UA_EventSource *es =
+        ZIP_FIND(UA_EventSourceTree, &server->eventSources, &node->head.nodeId);
+    if(!es)
+        return;
+    server->eventSourcesVersion++;
+    ZIP_REMOVE(UA_EventSourceTree, &server->eventSources, es);
+    deleteEventSource(es);
+}
+
+/* Get all ReferenceTypes over which the events propagate */
+static UA_StatusCode
+getEventRefTypes(UA_Server *server, UA_ReferenceTypeSet *emitRefTypes) {
+    UA_ReferenceTypeSet_init(emitRefTypes);
+    for(size_t i = 0; i < EMIT_REFS_ROOT_COUNT; i++) {
+        UA_ReferenceTypeSet tmpRefTypes;
+        UA_StatusCode retval =
+            referenceTypeIndices(server, &emitReferencesRoots[i], &tmpRefTypes, true);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Events: Could not create the list of references for event "
+                           "propagation with StatusCode %s", UA_StatusCode_name(retval));
+            return retval;
         }
+        *emitRefTypes = UA_ReferenceTypeSet_union(*emitRefTypes, tmpRefTypes);
     }
-#endif /*UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS*/
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Check that the origin node exists */
-    const UA_Node *originNode = UA_NODESTORE_GET(server, &origin);
+/* Resolve the nodes that emit the events of the source and their
+ * MonitoredItems */
+static UA_StatusCode
+resolveEventSource(UA_Server *server, UA_EventSource *es) {
+    /* Make sure the origin exists */
+    const UA_Node *originNode = UA_NODESTORE_GET(server, &es->nodeId);
     if(!originNode) {
-        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
-                     "Origin node for event does not exist.");
-        UA_UNLOCK(server->serviceMutex);
-        return UA_STATUSCODE_BADNOTFOUND;
+        es->originResult = UA_STATUSCODE_BADNOTFOUND;
+        return UA_STATUSCODE_GOOD;
     }
     UA_NODESTORE_RELEASE(server, originNode);
 
@@ -603,21 +931,9 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
     UA_ReferenceTypeSet reftypes =
         UA_ReferenceTypeSet_union(UA_REFTYPESET(UA_REFERENCETYPEINDEX_ORGANIZES),
                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASCOMPONENT));
-    if(!isNodeInTree(server, &origin, &objectsFolderId, &reftypes)) {
-        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
-                     "Node for event must be in ObjectsFolder!");
-        UA_UNLOCK(server->serviceMutex);
-        return UA_STATUSCODE_BADINVALIDARGUMENT;
-    }
-
-    /* Update the standard fields of the event */
-    UA_StatusCode retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                       "Events: Could not set the standard event fields with StatusCode %s",
-                       UA_StatusCode_name(retval));
-        UA_UNLOCK(server->serviceMutex);
-        return retval;
+    if(!isNodeInTree(server, &es->nodeId, &objectsFolderId, &reftypes)) {
+        es->originResult = UA_STATUSCODE_BADINVALIDARGUMENT;
+        return UA_STATUSCODE_GOOD;
     }
 
     /* List of nodes that emit the node. Events propagate upwards (bubble up) in
@@ -633,38 +949,28 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
      * a Server and as such has implied HasEventSource References to every event
      * source in a Server. */
     UA_NodeId emitStartNodes[2];
-    emitStartNodes[0] = origin;
+    emitStartNodes[0] = es->nodeId;
     emitStartNodes[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
 
-    /* Get all ReferenceTypes over which the events propagate */
-    UA_ReferenceTypeSet emitRefTypes;
-    UA_ReferenceTypeSet_init(&emitRefTypes);
-    for(size_t i = 0; i < EMIT_REFS_ROOT_COUNT; i++) {
-        UA_ReferenceTypeSet tmpRefTypes;
-        retval = referenceTypeIndices(server, &emitReferencesRoots[i], &tmpRefTypes, true);
-        if(retval != UA_STATUSCODE_GOOD) {
-            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                           "Events: Could not create the list of references for event "
-                           "propagation with StatusCode %s", UA_StatusCode_name(retval));
-            goto cleanup;
-        }
-        emitRefTypes = UA_ReferenceTypeSet_union(emitRefTypes, tmpRefTypes);
-    }
-
     /* Get the list of nodes in the hierarchy that emits the event. */
-    retval = browseRecursive(server, 2, emitStartNodes, &emitRefTypes,
-                             UA_BROWSEDIRECTION_INVERSE, true,
-                             &emitNodesSize, &emitNodes);
+    UA_StatusCode retval =
+        browseRecursive(server, 2, emitStartNodes, &server->eventRefTypes,
+                        UA_BROWSEDIRECTION_INVERSE, true, &emitNodesSize, &emitNodes);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
                        "Events: Could not create the list of nodes listening on the "
                        "event with StatusCode %s", UA_StatusCode_name(retval));
-        goto cleanup;
+        return retval;
+    }
+
+    es->emitNodes = (UA_NodeId*)UA_Array_new(emitNodesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    if(!es->emitNodes) {
+        UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* Add the event to the listening MonitoredItems at each relevant node */
+    /* Collect the objects and their MonitoredItems */
     for(size_t i = 0; i < emitNodesSize; i++) {
-        /* Get the node */
         const UA_ObjectNode *node = (const UA_ObjectNode*)
             UA_NODESTORE_GET(server, &emitNodes[i].nodeId);
         if(!node)
@@ -676,24 +982,230 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
             continue;
         }
 
-        /* Add event to monitoreditems */
-        for(UA_MonitoredItem *mi = node->monitoredItemQueue; mi != NULL; mi = mi->next) {
-            retval = UA_Event_addEventToMonitoredItem(server, &eventNodeId, mi);
-            if(retval != UA_STATUSCODE_GOOD) {
-                UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                               "Events: Could not add the event to a listening node with StatusCode %s",
-                               UA_StatusCode_name(retval));
-                retval = UA_STATUSCODE_GOOD; /* Only log problems with individual emit nodes */
+        size_t monsSize = 0;
+        for(UA_MonitoredItem *mi = node->monitoredItemQueue; mi != NULL; mi = mi->next)
+            monsSize++;
+        if(monsSize > 0) {
+            UA_MonitoredItem **mons = (UA_MonitoredItem**)
+                UA_realloc(es->monitoredItems, sizeof(UA_MonitoredItem*) *
+                           (es->monitoredItemsSize + monsSize));
+            if(!mons) {
+                UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
+                retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                break;
             }
+            es->monitoredItems = mons;
+            for(UA_MonitoredItem *mi = node->monitoredItemQueue; mi != NULL; mi = mi->next)
+                es->monitoredItems[es->monitoredItemsSize++] = mi;
         }
-
         UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
 
-        /* Add event entry in the historical database */
+        /* Take the NodeId from the ExpandedNodeId */
+        es->emitNodes[es->emitNodesSize++] = emitNodes[i].nodeId;
+        UA_NodeId_init(&emitNodes[i].nodeId);
+    }
+
+    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return retval;
+}
+
+static UA_StatusCode
+getEventSource(UA_Server *server, const UA_NodeId *origin, UA_EventSource **out) {
+    UA_EventSource *es = ZIP_FIND(UA_EventSourceTree, &server->eventSources, origin);
+    if(es) {
+        *out = es;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* The ReferenceTypes can only change while the cache is empty */
+    UA_StatusCode retval;
+    if(!ZIP_ROOT(&server->eventSources)) {
+        retval = getEventRefTypes(server, &server->eventRefTypes);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    es = (UA_EventSource*)UA_calloc(1, sizeof(UA_EventSource));
+    if(!es)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    retval = UA_NodeId_copy(origin, &es->nodeId);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = resolveEventSource(server, es);
+    if(retval != UA_STATUSCODE_GOOD) {
+        deleteEventSource(es);
+        return retval;
+    }
+    ZIP_INSERT(UA_EventSourceTree, &server->eventSources, es,
+               ZIP_FFS32(UA_UInt32_random()));
+    *out = es;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Check that the origin node exists and is in the ObjectsFolder */
+static UA_StatusCode
+checkEventOrigin(UA_Server *server, const UA_NodeId *origin) {
+    UA_EventSource *es;
+    UA_StatusCode retval = getEventSource(server, origin, &es);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(es->originResult == UA_STATUSCODE_BADNOTFOUND)
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
+                     "Origin node for event does not exist.");
+    else if(es->originResult != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
+                     "Node for event must be in ObjectsFolder!");
+    return es->originResult;
+}
+
+/* The MonitoredItems of an event source are snapshotted before the event is
+ * added. Evaluating the filter can release the service lock (e.g. for value
+ * callbacks). Then the cache entry and the MonitoredItems can be deleted
+ * concurrently. */
+typedef struct {
+    UA_MonitoredItem *mon;
+    UA_NodeId sessionId;
+    UA_UInt32 subscriptionId;
+    UA_UInt32 monitoredItemId;
+} UA_EventTarget;
+
+/* Look up the MonitoredItem again after the cached sources have changed */
+static UA_MonitoredItem *
+findEventTarget(UA_Server *server, const UA_EventTarget *target) {
+    UA_Session *session = &server->adminSession;
+    if(!UA_NodeId_equal(&target->sessionId, &session->sessionId))
+        session = UA_Server_getSessionById(server, &target->sessionId);
+    if(!session)
+        return NULL;
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, target->subscriptionId);
+    if(!sub)
+        return NULL;
+    return UA_Subscription_getMonitoredItem(sub, target->monitoredItemId);
+}
+
+/* Add the event to the MonitoredItems of the origin and of the nodes above */
+static UA_StatusCode
+emitEvent(UA_Server *server, const UA_NodeId *origin, const UA_EventDescription *ed) {
+    /* A new event for the cached filter results */
+    server->eventCounter++;
+
+    UA_EventSource *es;
+    UA_StatusCode retval = getEventSource(server, origin, &es);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Copy the emit nodes and the MonitoredItems. The cache entry is not used
+     * after this point. */
+#ifdef UA_ENABLE_HISTORIZING
+    UA_NodeId *emitNodes = NULL;
+    size_t emitNodesSize = 0;
+    if(server->config.historyDatabase.setEvent) {
+        retval = UA_Array_copy(es->emitNodes, es->emitNodesSize, (void**)&emitNodes,
+                               &UA_TYPES[UA_TYPES_NODEID]);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        emitNodesSize = es->emitNodesSize;
+    }
+#endif
+
+    size_t targetsSize = es->monitoredItemsSize;
+    UA_EventTarget *targets = NULL;
+    if(targetsSize > 0) {
+        targets = (UA_EventTarget*)UA_malloc(sizeof(UA_EventTarget) * targetsSize);
+        if(!targets) {
 #ifdef UA_ENABLE_HISTORIZING
-        if(server->config.historyDatabase.setEvent)
-            setHistoricalEvent(server, &origin, &emitNodes[i].nodeId, &eventNodeId);
+            UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_NODEID]);
 #endif
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+    for(size_t i = 0; i < targetsSize; i++) {
+        UA_MonitoredItem *mon = es->monitoredItems[i];
+        targets[i].mon = mon;
+        /* Shallow copy. Session ids are Guid NodeIds. */
+        targets[i].sessionId = mon->subscription->session->sessionId;
+        targets[i].subscriptionId = mon->subscription->subscriptionId;
+        targets[i].monitoredItemId = mon->monitoredItemId;
+    }
+    UA_UInt64 version = server->eventSourcesVersion;
+
+    /* Add the event to the listening MonitoredItems */
+    for(size_t i = 0; i < targetsSize; i++) {
+        UA_MonitoredItem *mon = targets[i].mon;
+        if(version != server->eventSourcesVersion) {
+            mon = findEventTarget(server, &targets[i]);
+            if(!mon)
+                continue; /* Deleted in the meantime */
+        }
+        retval = addEventToMonitoredItem(server, ed, mon);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "Events: Could not add the event to a listening node with StatusCode %s",
+                           UA_StatusCode_name(retval));
+            retval = UA_STATUSCODE_GOOD; /* Only log problems with individual emit nodes */
+        }
+    }
+    UA_free(targets);
+
+    /* Add event entry in the historical database. The emit nodes are a copy as
+     * the userland callback can change the information model. */
+#ifdef UA_ENABLE_HISTORIZING
+    for(size_t i = 0; i < emitNodesSize; i++)
+        setHistoricalEvent(server, origin, &emitNodes[i], ed);
+    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_NODEID]);
+#endif
+
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
+                       const UA_NodeId origin, UA_ByteString *outEventId,
+                       const UA_Boolean deleteEventNode) {
+    UA_WRLOCK(server->serviceMutex);
+
+#if UA_LOGLEVEL <= 200
+    UA_LOG_NODEID_WRAP(&origin,
+                       UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                                    "Events: An event is triggered on node %.*s",
+                                    (int)nodeIdStr.length, nodeIdStr.data));
+#endif
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    UA_Boolean isCallerAC = false;
+    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
+        if(!isCallerAC) {
+          UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
+                                  UA_STATUSCODE_BADINVALIDARGUMENT);
+          UA_WRUNLOCK(server->serviceMutex);
+          return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+    }
+#endif /*UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS*/
+
+    UA_StatusCode retval = checkEventOrigin(server, &origin);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_WRUNLOCK(server->serviceMutex);
+        return retval;
+    }
+
+    /* Update the standard fields of the event */
+    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "Events: Could not set the standard event fields with StatusCode %s",
+                       UA_StatusCode_name(retval));
+        UA_WRUNLOCK(server->serviceMutex);
+        return retval;
+    }
+
+    UA_EventDescription ed;
+    memset(&ed, 0, sizeof(UA_EventDescription));
+    ed.eventNode = &eventNodeId;
+    retval = emitEvent(server, &origin, &ed);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_WRUNLOCK(server->serviceMutex);
+        return retval;
     }
 
     /* Delete the node representation of the event */
@@ -706,9 +1218,63 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         }
     }
 
- cleanup:
-    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_triggerTransientEvent(UA_Server *server, const UA_NodeId eventType,
+                                const UA_NodeId origin, size_t fieldsSize,
+                                const UA_EventField *fields, UA_ByteString *outEventId) {
+    UA_WRLOCK(server->serviceMutex);
+
+    /* Make sure the eventType is a subtype of BaseEventType */
+    UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    if(!isNodeInTree_singleRef(server, &eventType, &baseEventTypeId,
+                               UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_USERLAND,
+                     "Event type must be a subtype of BaseEventType!");
+        UA_WRUNLOCK(server->serviceMutex);
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    UA_StatusCode retval = checkEventOrigin(server, &origin);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_WRUNLOCK(server->serviceMutex);
+        return retval;
+    }
+
+    /* Generate the standard fields */
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    retval = UA_Event_generateEventId(&eventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_WRUNLOCK(server->serviceMutex);
+        return retval;
+    }
+    UA_DateTime receiveTime = UA_DateTime_now();
+
+    UA_EventDescription ed;
+    memset(&ed, 0, sizeof(UA_EventDescription));
+    ed.eventType = &eventType;
+    setStandardField(&ed.standardFields[0], &eventIdName,
+                     &eventId, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    setStandardField(&ed.standardFields[1], &eventTypeName,
+                     (void*)(uintptr_t)&eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    setStandardField(&ed.standardFields[2], &sourceNodeName,
+                     (void*)(uintptr_t)&origin, &UA_TYPES[UA_TYPES_NODEID]);
+    setStandardField(&ed.standardFields[3], &receiveTimeName,
+                     &receiveTime, &UA_TYPES[UA_TYPES_DATETIME]);
+    ed.fieldsSize = fieldsSize;
+    ed.fields = fields;
+
+    retval = emitEvent(server, &origin, &ed);
+    UA_WRUNLOCK(server->serviceMutex);
+
+    /* Return the EventId */
+    if(outEventId && retval == UA_STATUSCODE_GOOD)
+        *outEventId = eventId;
+    else
+        UA_ByteString_clear(&eventId);
     return retval;
 }
 
@@ -59,17 +59,15 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
      * possible overflows. */
 
     /* Allocate the notification */
-    UA_Notification *overflowNotification = (UA_Notification *)
-        UA_malloc(sizeof(UA_Notification));
+    UA_Notification *overflowNotification = UA_Notification_new(mon);
     if(!overflowNotification)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Set the notification fields */
-    overflowNotification->mon = mon;
     UA_EventFieldList_init(&overflowNotification->data.event);
     overflowNotification->data.event.eventFields = UA_Variant_new();
     if(!overflowNotification->data.event.eventFields) {
-        UA_free(overflowNotification);
+        UA_Notification_delete(overflowNotification);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
     overflowNotification->data.event.eventFieldsSize = 1;
@@ -77,8 +75,7 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
         UA_Variant_setScalarCopy(overflowNotification->data.event.eventFields,
                                  &simpleOverflowEventType, &UA_TYPES[UA_TYPES_NODEID]);
     if(retval != UA_STATUSCODE_GOOD) {
-        UA_EventFieldList_clear(&overflowNotification->data.event);
-        UA_free(overflowNotification);
+        UA_Notification_delete(overflowNotification);
         return retval;
     }
 
@@ -100,6 +97,34 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
 
 #endif
 
+/* The pool holds maxQueueSize notifications plus two: the new notification
+ * before the queue is trimmed and one overflow event. Large queues are not
+ * preallocated completely. Beyond the pool, notifications are allocated on the
+ * heap. */
+#define UA_NOTIFICATIONPOOL_MAXQUEUESIZE 32
+#define UA_NOTIFICATIONPOOL_EXTRA 2
+
+static UA_Boolean
+isPoolNotification(const UA_Notification *pool, size_t poolSize,
+                   const UA_Notification *n) {
+    return ((uintptr_t)n >= (uintptr_t)pool &&
+            (uintptr_t)n < (uintptr_t)&pool[poolSize]);
+}
+
+UA_Notification *
+UA_Notification_new(UA_MonitoredItem *mon) {
+    UA_Notification *n = mon->freeNotifications;
+    if(n) {
+        mon->freeNotifications = TAILQ_NEXT(n, listEntry);
+    } else {
+        n = (UA_Notification*)UA_malloc(sizeof(UA_Notification));
+        if(!n)
+            return NULL;
+    }
+    n->mon = mon;
+    return n;
+}
+
 /* !!! The enqueue and dequeue operations need to match the reporting
  * disable/enable logic in Operation_SetMonitoringMode !!! */
 
@@ -199,9 +224,23 @@ UA_Notification_delete(UA_Notification *n) {
         UA_MonitoredItemNotification_clear(&n->data.dataChange);
         break;
     }
+
+    /* Return to the pool */
+    UA_MonitoredItem *mon = n->mon;
+    if(isPoolNotification(mon->notificationPool, mon->notificationPoolSize, n)) {
+        TAILQ_NEXT(n, listEntry) = mon->freeNotifications;
+        mon->freeNotifications = n;
+        return;
+    }
     UA_free(n);
 }
 
+void
+UA_Notification_takeDataValue(UA_Notification *n, UA_DataValue *dst) {
+    *dst = n->data.dataChange.value;
+    UA_DataValue_init(&n->data.dataChange.value);
+}
+
 /*****************/
 /* MonitoredItem */
 /*****************/
@@ -213,6 +252,66 @@ UA_MonitoredItem_init(UA_MonitoredItem *mon, UA_Subscription *sub) {
     TAILQ_INIT(&mon->queue);
 }
 
+void
+UA_MonitoredItem_resizeNotificationPool(UA_MonitoredItem *mon) {
+    size_t poolSize = mon->maxQueueSize;
+    if(poolSize > UA_NOTIFICATIONPOOL_MAXQUEUESIZE)
+        poolSize = UA_NOTIFICATIONPOOL_MAXQUEUESIZE;
+    poolSize += UA_NOTIFICATIONPOOL_EXTRA;
+    if(poolSize == mon->notificationPoolSize)
+        return;
+
+    UA_Notification *pool = (UA_Notification*)
+        UA_malloc(sizeof(UA_Notification) * poolSize);
+    if(!pool)
+        return;
+
+    /* The queued notifications from the old pool must fit into the new pool.
+     * Otherwise keep the old pool. This does not happen if the queue was
+     * trimmed to maxQueueSize before. */
+    UA_Notification *oldPool = mon->notificationPool;
+    size_t oldPoolSize = mon->notificationPoolSize;
+    size_t pooled = 0;
+    UA_Notification *n, *n_tmp;
+    TAILQ_FOREACH(n, &mon->queue, listEntry) {
+        if(isPoolNotification(oldPool, oldPoolSize, n))
+            pooled++;
+    }
+    if(pooled > poolSize) {
+        UA_free(pool);
+        return;
+    }
+
+    /* Switch to the new pool */
+    mon->notificationPool = pool;
+    mon->notificationPoolSize = poolSize;
+    mon->freeNotifications = NULL;
+    for(size_t i = poolSize; i > 0; i--) {
+        TAILQ_NEXT(&pool[i-1], listEntry) = mon->freeNotifications;
+        mon->freeNotifications = &pool[i-1];
+    }
+
+    /* Move the queued notifications out of the old pool. Replace them at the
+     * same position in both queues. */
+    TAILQ_FOREACH_SAFE(n, &mon->queue, listEntry, n_tmp) {
+        if(!isPoolNotification(oldPool, oldPoolSize, n))
+            continue;
+        UA_Notification *moved = mon->freeNotifications;
+        mon->freeNotifications = TAILQ_NEXT(moved, listEntry);
+        moved->mon = mon;
+        moved->data = n->data;
+        TAILQ_INSERT_BEFORE(n, moved, listEntry);
+        TAILQ_REMOVE(&mon->queue, n, listEntry);
+        if(TAILQ_NEXT(n, globalEntry) != UA_SUBSCRIPTION_QUEUE_SENTINEL) {
+            TAILQ_INSERT_BEFORE(n, moved, globalEntry);
+            TAILQ_REMOVE(&mon->subscription->notificationQueue, n, globalEntry);
+        } else {
+            TAILQ_NEXT(moved, globalEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+        }
+    }
+    UA_free(oldPool);
+}
+
 void
 UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
     UA_LOCK_ASSERT(server->serviceMutex, 1);
@@ -231,13 +330,20 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
             UA_Notification_delete(notification);
         }
     }
+    UA_free(monitoredItem->notificationPool);
+    monitoredItem->notificationPool = NULL;
+    monitoredItem->notificationPoolSize = 0;
+    monitoredItem->freeNotifications = NULL;
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     if(monitoredItem->attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
         /* Remove the monitored item from the node queue */
         UA_Server_editNode(server, NULL, &monitoredItem->monitoredNodeId,
                            UA_MonitoredItem_removeNodeEventCallback, monitoredItem);
-        UA_EventFilter_clear(&monitoredItem->filter.eventFilter);
+        UA_Event_clearSources(server);
+        if(monitoredItem->filter.eventFilter)
+            UA_Server_releaseEventFilter(server, monitoredItem->filter.eventFilter);
+        monitoredItem->filter.eventFilter = NULL;
     } else
 #endif
     {
@@ -259,12 +365,12 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
         getNodeContext(server, monitoredItem->monitoredNodeId, &targetContext);
 
         /* Deregister */
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
         server->config.monitoredItemRegisterCallback(server, &session->sessionId,
                                                      session->sessionHandle,
                                                      &monitoredItem->monitoredNodeId,
                                                      targetContext, monitoredItem->attributeId, true);
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
     }
 
     /* Remove the monitored item */
@@ -367,31 +473,4 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     return UA_STATUSCODE_GOOD;
 }
 
-UA_StatusCode
-UA_MonitoredItem_registerSampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
-    if(mon->sampleCallbackIsRegistered)
-        return UA_STATUSCODE_GOOD;
-
-    /* Only DataChange MonitoredItems have a callback with a sampling interval */
-    if(mon->attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
-        return UA_STATUSCODE_GOOD;
-
-    UA_StatusCode retval =
-        addRepeatedCallback(server, (UA_ServerCallback)UA_MonitoredItem_sampleCallback,
-                            mon, mon->samplingInterval, &mon->sampleCallbackId);
-    if(retval == UA_STATUSCODE_GOOD)
-        mon->sampleCallbackIsRegistered = true;
-    return retval;
-}
-
-void
-UA_MonitoredItem_unregisterSampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
-    UA_LOCK_ASSERT(server->serviceMutex, 1);
-    if(!mon->sampleCallbackIsRegistered)
-        return;
-    removeCallback(server, mon->sampleCallbackId);
-    mon->sampleCallbackIsRegistered = false;
-}
-
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
@@ -88,6 +88,18 @@ UA_Chunk_delete(UA_Chunk *chunk) {
     UA_free(chunk);
 }
 
+/* Remove the first bytes. Copied chunks keep the pointer to the start of the
+ * allocated memory. */
+static void
+UA_Chunk_hideBytes(UA_Chunk *chunk, size_t offset) {
+    if(chunk->copied)
+        memmove(chunk->bytes.data, &chunk->bytes.data[offset],
+                chunk->bytes.length - offset);
+    else
+        chunk->bytes.data += offset;
+    chunk->bytes.length -= offset;
+}
+
 static void
 deleteChunks(UA_ChunkQueue *queue) {
     UA_Chunk *chunk;
@@ -102,6 +114,14 @@ UA_SecureChannel_deleteBuffered(UA_SecureChannel *channel) {
     deleteChunks(&channel->completeChunks);
     deleteChunks(&channel->decryptedChunks);
     UA_ByteString_clear(&channel->incompleteChunk);
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* The job was returned from the worker when the channel is closed */
+    if(channel->asymmetricJob.chunk)
+        UA_Chunk_delete(channel->asymmetricJob.chunk);
+    UA_ByteString_clear(&channel->asymmetricJob.buf);
+    memset(&channel->asymmetricJob, 0, sizeof(UA_AsymmetricJob));
+    channel->paused = false;
+#endif
 }
 
 void
@@ -171,63 +191,121 @@ UA_SecureChannel_processHELACK(UA_SecureChannel *channel,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Sends an OPN message using asymmetric encryption if defined */
-UA_StatusCode
-UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
-                                          UA_UInt32 requestId, const void *content,
-                                          const UA_DataType *contentType) {
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_INVALID)
-        return UA_STATUSCODE_BADSECURITYMODEREJECTED;
-
+/* Encode the OPN message with headers and padding. The signature is not yet
+ * added and the content is not yet encrypted. */
+static UA_StatusCode
+encodeAsymmetricOPNMessage(UA_SecureChannel *channel, UA_ByteString *buf,
+                           UA_UInt32 requestId, const void *content,
+                           const UA_DataType *contentType, size_t *preSignLength,
+                           size_t *securityHeaderLength, size_t *totalLength,
+                           size_t *finalLength) {
     const UA_SecurityPolicy *sp = channel->securityPolicy;
-    if(!sp)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_Connection *connection = channel->connection;
-    if(!connection)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Allocate the message buffer */
-    UA_ByteString buf = UA_BYTESTRING_NULL;
-    UA_StatusCode retval =
-        connection->getSendBuffer(connection, channel->config.sendBufferSize, &buf);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
 
     /* Restrict buffer to the available space for the payload */
-    UA_Byte *buf_pos = buf.data;
-    const UA_Byte *buf_end = &buf.data[buf.length];
+    UA_Byte *buf_pos = buf->data;
+    const UA_Byte *buf_end = &buf->data[buf->length];
     hideBytesAsym(channel, &buf_pos, &buf_end);
 
     /* Encode the message type and content */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
     retval |= UA_encodeBinary(&contentType->binaryEncodingId, &UA_TYPES[UA_TYPES_NODEID],
                               &buf_pos, &buf_end, NULL, NULL);
     retval |= UA_encodeBinary(content, contentType, &buf_pos, &buf_end, NULL, NULL);
-    if(retval != UA_STATUSCODE_GOOD) {
-        connection->releaseSendBuffer(connection, &buf);
+    if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    }
 
-    const size_t securityHeaderLength = calculateAsymAlgSecurityHeaderLength(channel);
+    *securityHeaderLength = calculateAsymAlgSecurityHeaderLength(channel);
 
     /* Add padding to the chunk */
 #ifdef UA_ENABLE_ENCRYPTION
-    padChunkAsym(channel, &buf, securityHeaderLength, &buf_pos);
+    padChunkAsym(channel, buf, *securityHeaderLength, &buf_pos);
 #endif
 
     /* The total message length */
-    size_t pre_sig_length = (uintptr_t)buf_pos - (uintptr_t)buf.data;
-    size_t total_length = pre_sig_length;
+    *preSignLength = (uintptr_t)buf_pos - (uintptr_t)buf->data;
+    *totalLength = *preSignLength;
     if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
        channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
-        total_length += sp->asymmetricModule.cryptoModule.signatureAlgorithm.
+        *totalLength += sp->asymmetricModule.cryptoModule.signatureAlgorithm.
             getLocalSignatureSize(sp, channel->channelContext);
 
     /* The total message length is known here which is why we encode the headers
      * at this step and not earlier. */
+    return prependHeadersAsym(channel, buf->data, buf_end, *totalLength,
+                              *securityHeaderLength, requestId, finalLength);
+}
+
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+/* The message is encoded into a separate buffer. The send buffer of the
+ * connection is only taken once the job has completed. */
+static UA_StatusCode
+offloadAsymmetricOPNMessage(UA_SecureChannel *channel, UA_UInt32 requestId,
+                            const void *content, const UA_DataType *contentType) {
+    UA_AsymmetricJob *job = &channel->asymmetricJob;
+    UA_StatusCode retval =
+        UA_ByteString_allocBuffer(&job->buf, channel->config.sendBufferSize);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    size_t finalLength = 0;
+    retval = encodeAsymmetricOPNMessage(channel, &job->buf, requestId, content,
+                                        contentType, &job->preSignLength,
+                                        &job->securityHeaderLength,
+                                        &job->totalLength, &finalLength);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&job->buf);
+        return retval;
+    }
+    job->buf.length = finalLength;
+
+    job->type = UA_ASYMMETRICJOB_ENCRYPT;
+    channel->paused = true;
+    retval = channel->offloadAsymmetricJob(job->application, channel);
+    if(retval != UA_STATUSCODE_GOOD) {
+        job->type = UA_ASYMMETRICJOB_NONE;
+        channel->paused = false;
+        UA_ByteString_clear(&job->buf);
+    }
+    return retval;
+}
+#endif
+
+/* Sends an OPN message using asymmetric encryption if defined */
+UA_StatusCode
+UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                          UA_UInt32 requestId, const void *content,
+                                          const UA_DataType *contentType) {
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_INVALID)
+        return UA_STATUSCODE_BADSECURITYMODEREJECTED;
+
+    const UA_SecurityPolicy *sp = channel->securityPolicy;
+    if(!sp)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_Connection *connection = channel->connection;
+    if(!connection)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* The response to an offloaded OPN request */
+    if(channel->asymmetricJob.type == UA_ASYMMETRICJOB_RESPOND &&
+       (channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
+        channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT))
+        return offloadAsymmetricOPNMessage(channel, requestId, content, contentType);
+#endif
+
+    /* Allocate the message buffer */
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval =
+        connection->getSendBuffer(connection, channel->config.sendBufferSize, &buf);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    size_t pre_sig_length, securityHeaderLength, total_length;
     size_t finalLength = 0;
-    retval = prependHeadersAsym(channel, buf.data, buf_end, total_length,
-                                securityHeaderLength, requestId, &finalLength);
+    retval = encodeAsymmetricOPNMessage(channel, &buf, requestId, content, contentType,
+                                        &pre_sig_length, &securityHeaderLength,
+                                        &total_length, &finalLength);
     if(retval != UA_STATUSCODE_GOOD) {
         connection->releaseSendBuffer(connection, &buf);
         return retval;
@@ -508,6 +586,40 @@ processSequenceNumberNop(UA_SecureChannel *channel, UA_UInt32 sequenceNumber) {
 }
 #endif
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+/* The chunk is owned by the job until it has completed. Returns
+ * UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY if the job was handed over. */
+static UA_StatusCode
+offloadDecryptChunk(UA_SecureChannel *channel, UA_Chunk *chunk,
+                    size_t offset, void *application) {
+    /* Don't point into the network buffer */
+    if(!chunk->copied) {
+        UA_ByteString copy;
+        UA_StatusCode res = UA_ByteString_copy(&chunk->bytes, &copy);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        chunk->bytes = copy;
+        chunk->copied = true;
+    }
+
+    UA_AsymmetricJob *job = &channel->asymmetricJob;
+    job->type = UA_ASYMMETRICJOB_DECRYPT;
+    job->result = UA_STATUSCODE_GOOD;
+    job->application = application;
+    job->chunk = chunk;
+    job->offset = offset;
+    channel->paused = true;
+    UA_StatusCode res = channel->offloadAsymmetricJob(application, channel);
+    if(res != UA_STATUSCODE_GOOD) {
+        job->type = UA_ASYMMETRICJOB_NONE;
+        job->chunk = NULL;
+        channel->paused = false;
+        return res;
+    }
+    return UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY;
+}
+#endif
+
 static UA_StatusCode
 decryptMessageChunk(UA_SecureChannel *channel, UA_Chunk *chunk, void *application) {
     size_t offset = UA_CONNECTION_PROTOCOL_MESSAGE_HEADER_SIZE; /* Skip the message header */
@@ -600,6 +712,16 @@ decryptMessageChunk(UA_SecureChannel *channel, UA_Chunk *chunk, void *applicatio
     if(res != UA_STATUSCODE_GOOD)
         return res;
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* Offload the asymmetric decryption when the channel is opened */
+    if(chunk->messageType == UA_MESSAGETYPE_OPN &&
+       channel->state == UA_SECURECHANNELSTATE_ACK_SENT &&
+       channel->offloadAsymmetricJob &&
+       !UA_ByteString_equal(&channel->securityPolicy->policyUri,
+                            &UA_SECURITY_POLICY_NONE_URI))
+        return offloadDecryptChunk(channel, chunk, offset, application);
+#endif
+
     /* Decrypt the chunk payload */
     res = decryptAndVerifyChunk(channel, cryptoModule, chunk->messageType,
                                 &chunk->bytes, offset);
@@ -616,8 +738,7 @@ decryptMessageChunk(UA_SecureChannel *channel, UA_Chunk *chunk, void *applicatio
         return res;
 
     chunk->requestId = sequenceHeader.requestId;
-    chunk->bytes.data += offset;
-    chunk->bytes.length -= offset;
+    UA_Chunk_hideBytes(chunk, offset);
     return res;
 
 error:
@@ -715,53 +836,74 @@ persistIncompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Processes chunks and puts them into the payloads queue. Once a final chunk is
- * put into the queue, the message is assembled and the callback is called. The
- * queue will be cleared for the next message. */
+/* Add a decrypted chunk to the queue. Once a final chunk is put into the
+ * queue, the message is assembled and the callback is called. The queue will
+ * be cleared for the next message. */
+static UA_StatusCode
+processDecryptedChunk(UA_SecureChannel *channel, UA_Chunk *chunk, void *application,
+                      UA_ProcessMessageCallback callback) {
+    SIMPLEQ_INSERT_TAIL(&channel->decryptedChunks, chunk, pointers);
+
+    /* Check the ressource limits */
+    channel->decryptedChunksCount++;
+    channel->decryptedChunksLength += chunk->bytes.length;
+    if((channel->config.localMaxChunkCount != 0 &&
+        channel->decryptedChunksCount > channel->config.localMaxChunkCount) ||
+       (channel->config.localMaxMessageSize != 0 &&
+        channel->decryptedChunksLength > channel->config.localMaxMessageSize)) {
+        return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
+    }
+
+    /* Continue */
+    if(chunk->chunkType != UA_CHUNKTYPE_FINAL)
+        return UA_STATUSCODE_GOOD;
+
+    /* The decrypted queue contains a full message. Process it. */
+    UA_StatusCode retval = assembleProcessMessage(channel, application, callback);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Reset the counters */
+    channel->decryptedChunksCount = 0;
+    channel->decryptedChunksLength = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Processes chunks and puts them into the payloads queue */
 static UA_StatusCode
 processChunks(UA_SecureChannel *channel, void *application,
               UA_ProcessMessageCallback callback) {
     UA_Chunk *chunk;
     UA_StatusCode retval;
     while((chunk = SIMPLEQ_FIRST(&channel->completeChunks))) {
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+        /* Keep the remaining chunks until the channel is resumed */
+        if(channel->paused)
+            break;
+#endif
+
         /* Decrypt and add to the decrypted queue */
         SIMPLEQ_REMOVE_HEAD(&channel->completeChunks, pointers);
         if(chunk->messageType == UA_MESSAGETYPE_OPN ||
            chunk->messageType == UA_MESSAGETYPE_MSG ||
            chunk->messageType == UA_MESSAGETYPE_CLO) {
             retval = decryptMessageChunk(channel, chunk, application);
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+            /* The chunk was taken over by a worker */
+            if(retval == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY)
+                break;
+#endif
             if(retval != UA_STATUSCODE_GOOD) {
                 UA_Chunk_delete(chunk);
                 return retval;
             }
         } else {
-            chunk->bytes.data += UA_CONNECTION_PROTOCOL_MESSAGE_HEADER_SIZE;
-            chunk->bytes.length -= UA_CONNECTION_PROTOCOL_MESSAGE_HEADER_SIZE;
+            UA_Chunk_hideBytes(chunk, UA_CONNECTION_PROTOCOL_MESSAGE_HEADER_SIZE);
         }
-        SIMPLEQ_INSERT_TAIL(&channel->decryptedChunks, chunk, pointers);
-
-        /* Check the ressource limits */
-        channel->decryptedChunksCount++;
-        channel->decryptedChunksLength += chunk->bytes.length;
-        if((channel->config.localMaxChunkCount != 0 &&
-            channel->decryptedChunksCount > channel->config.localMaxChunkCount) ||
-           (channel->config.localMaxMessageSize != 0 &&
-            channel->decryptedChunksLength > channel->config.localMaxMessageSize)) {
-            return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
-        }
-
-        /* Continue */
-        if(chunk->chunkType != UA_CHUNKTYPE_FINAL)
-            continue;
 
-        /* The decrypted queue contains a full message. Process it. */
-        retval = assembleProcessMessage(channel, application, callback);
+        retval = processDecryptedChunk(channel, chunk, application, callback);
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
-
-        /* Reset the counters */
-        channel->decryptedChunksCount = 0;
-        channel->decryptedChunksLength = 0;
     }
 
     return UA_STATUSCODE_GOOD;
@@ -909,3 +1051,101 @@ UA_SecureChannel_receive(UA_SecureChannel *channel, void *application,
     connection->releaseRecvBuffer(connection, &buffer);
     return retval;
 }
+
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+void
+UA_SecureChannel_runAsymmetricJob(UA_SecureChannel *channel) {
+    UA_AsymmetricJob *job = &channel->asymmetricJob;
+    const UA_SecurityPolicy *sp = channel->securityPolicy;
+    if(job->type == UA_ASYMMETRICJOB_DECRYPT)
+        job->result = decryptAndVerifyChunk(channel, &sp->asymmetricModule.cryptoModule,
+                                            UA_MESSAGETYPE_OPN, &job->chunk->bytes,
+                                            job->offset);
+    else if(job->type == UA_ASYMMETRICJOB_ENCRYPT)
+        job->result = signAndEncryptAsym(channel, job->preSignLength, &job->buf,
+                                         job->securityHeaderLength, job->totalLength);
+}
+
+/* Check the sequence number and process the OPN message */
+static UA_StatusCode
+completeDecryptJob(UA_SecureChannel *channel, void *application,
+                   UA_ProcessMessageCallback callback) {
+    UA_AsymmetricJob *job = &channel->asymmetricJob;
+    UA_Chunk *chunk = job->chunk;
+    job->chunk = NULL;
+
+    UA_SequenceHeader sequenceHeader;
+    UA_StatusCode res = job->result;
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_SequenceHeader_decodeBinary(&chunk->bytes, &job->offset, &sequenceHeader);
+    if(res == UA_STATUSCODE_GOOD)
+        res = processSequenceNumberAsym(channel, sequenceHeader.sequenceNumber);
+    if(res != UA_STATUSCODE_GOOD) {
+        job->type = UA_ASYMMETRICJOB_NONE;
+        UA_Chunk_delete(chunk);
+        return res;
+    }
+    chunk->requestId = sequenceHeader.requestId;
+    UA_Chunk_hideBytes(chunk, job->offset);
+
+    /* The response is sent from the callback. Reset unless the response was
+     * offloaded as well. */
+    job->type = UA_ASYMMETRICJOB_RESPOND;
+    res = processDecryptedChunk(channel, chunk, application, callback);
+    if(job->type == UA_ASYMMETRICJOB_RESPOND)
+        job->type = UA_ASYMMETRICJOB_NONE;
+    return res;
+}
+
+/* Send the signed and encrypted OPN response */
+static UA_StatusCode
+completeEncryptJob(UA_SecureChannel *channel) {
+    UA_AsymmetricJob *job = &channel->asymmetricJob;
+    job->type = UA_ASYMMETRICJOB_NONE;
+    UA_StatusCode res = job->result;
+    UA_Connection *connection = channel->connection;
+    if(res == UA_STATUSCODE_GOOD && !connection)
+        res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    if(res == UA_STATUSCODE_GOOD)
+        res = connection->getSendBuffer(connection, job->buf.length, &buf);
+    if(res == UA_STATUSCODE_GOOD) {
+        memcpy(buf.data, job->buf.data, job->buf.length);
+        buf.length = job->buf.length;
+        res = connection->send(connection, &buf);
+#ifdef UA_ENABLE_UNIT_TEST_FAILURE_HOOKS
+        res |= sendAsym_sendFailure;
+#endif
+    }
+    UA_ByteString_clear(&job->buf);
+    return res;
+}
+
+UA_StatusCode
+UA_SecureChannel_completeAsymmetricJob(UA_SecureChannel *channel, void *application,
+                                       UA_ProcessMessageCallback callback) {
+    channel->paused = false;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(channel->asymmetricJob.type == UA_ASYMMETRICJOB_DECRYPT)
+        res = completeDecryptJob(channel, application, callback);
+    else if(channel->asymmetricJob.type == UA_ASYMMETRICJOB_ENCRYPT)
+        res = completeEncryptJob(channel);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return UA_SecureChannel_resume(channel, application, callback);
+}
+
+UA_StatusCode
+UA_SecureChannel_resume(UA_SecureChannel *channel, void *application,
+                        UA_ProcessMessageCallback callback) {
+    /* Paused again when the response is offloaded */
+    if(channel->asymmetricJob.type != UA_ASYMMETRICJOB_NONE)
+        return UA_STATUSCODE_GOOD;
+    channel->paused = false;
+
+    /* The buffered chunks were already persisted */
+    return processChunks(channel, application, callback);
+}
+
+#endif
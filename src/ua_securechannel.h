@@ -56,6 +56,37 @@ typedef struct UA_Chunk {
 
 typedef SIMPLEQ_HEAD(UA_ChunkQueue, UA_Chunk) UA_ChunkQueue;
 
+/* The asymmetric cryptography of the OPN handshake can be offloaded from the
+ * thread processing the network to the crypto workers of the server. */
+#if UA_MULTITHREADING >= 200 && defined(UA_ENABLE_ENCRYPTION)
+#define UA_SECURECHANNEL_ASYNCCRYPTO
+
+typedef enum {
+    UA_ASYMMETRICJOB_NONE,
+    UA_ASYMMETRICJOB_DECRYPT, /* Decrypt and verify a received OPN chunk */
+    UA_ASYMMETRICJOB_RESPOND, /* The decrypted OPN is processed. The response is
+                               * offloaded as well. */
+    UA_ASYMMETRICJOB_ENCRYPT  /* Sign and encrypt the OPN response */
+} UA_AsymmetricJobType;
+
+typedef struct {
+    UA_AsymmetricJobType type;
+    UA_StatusCode result;
+    void *application;
+
+    /* Decrypt */
+    UA_Chunk *chunk;
+    size_t offset; /* Start of the encrypted content */
+
+    /* Encrypt */
+    UA_ByteString buf; /* Copied into a send buffer of the connection when the
+                        * job has completed */
+    size_t preSignLength;
+    size_t securityHeaderLength;
+    size_t totalLength;
+} UA_AsymmetricJob;
+#endif
+
 typedef enum {
     UA_SECURECHANNELRENEWSTATE_NORMAL,
 
@@ -131,6 +162,18 @@ struct UA_SecureChannel {
     UA_CertificateVerification *certificateVerification;
     UA_StatusCode (*processOPNHeader)(void *application, UA_SecureChannel *channel,
                                       const UA_AsymmetricAlgorithmSecurityHeader *asymHeader);
+
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+    /* If set, the asymmetric cryptography for opening the channel is handed to
+     * the application. The application calls _runAsymmetricJob in a worker
+     * thread and then _completeAsymmetricJob in the thread that processes the
+     * network. While paused, received chunks are buffered but not processed.
+     * The application can also pause the channel for its own asynchronous
+     * operations and continue with _resume. */
+    UA_StatusCode (*offloadAsymmetricJob)(void *application, UA_SecureChannel *channel);
+    UA_AsymmetricJob asymmetricJob;
+    UA_Boolean paused;
+#endif
 };
 
 void UA_SecureChannel_init(UA_SecureChannel *channel,
@@ -253,6 +296,26 @@ UA_StatusCode
 UA_SecureChannel_receive(UA_SecureChannel *channel, void *application,
                          UA_ProcessMessageCallback callback, UA_UInt32 timeout);
 
+#ifdef UA_SECURECHANNEL_ASYNCCRYPTO
+
+/* Executed in the worker thread. Only uses the SecurityPolicy and the channel
+ * context. */
+void
+UA_SecureChannel_runAsymmetricJob(UA_SecureChannel *channel);
+
+/* Integrate the result of the job and continue with the buffered chunks. A
+ * decrypted OPN is processed with the callback. */
+UA_StatusCode
+UA_SecureChannel_completeAsymmetricJob(UA_SecureChannel *channel, void *application,
+                                       UA_ProcessMessageCallback callback);
+
+/* Unpause and process the buffered chunks */
+UA_StatusCode
+UA_SecureChannel_resume(UA_SecureChannel *channel, void *application,
+                        UA_ProcessMessageCallback callback);
+
+#endif
+
 /* Internal methods in ua_securechannel_crypto.h */
 
 void
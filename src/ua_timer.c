@@ -10,39 +10,30 @@
 #include "ua_timer.h"
 
 struct UA_TimerEntry {
-    ZIP_ENTRY(UA_TimerEntry) zipfields;
-    UA_DateTime nextTime;                    /* The next time when the callback
-                                              * is to be executed */
-    UA_UInt64 interval;                      /* Interval in 100ns resolution. If
-                                                the interval is zero, the
-                                                callback is not repeated and
-                                                removed after execution. */
+    ZIP_ENTRY(UA_TimerEntry) idZipfields;
+    UA_UInt64 id;                            /* Id of the entry */
+    UA_TimerGroup *group;
+    LIST_ENTRY(UA_TimerEntry) groupPointers;
     UA_ApplicationCallback callback;
     void *application;
     void *data;
-
-    ZIP_ENTRY(UA_TimerEntry) idZipfields;
-    UA_UInt64 id;                            /* Id of the entry */
 };
 
-/* There may be several entries with the same nextTime in the tree. We give them
- * an absolute order by considering the memory address to break ties. Because of
- * this, the nextTime property cannot be used to lookup specific entries. */
-static enum ZIP_CMP
-cmpDateTime(const UA_DateTime *a, const UA_DateTime *b) {
-    if(*a < *b)
-        return ZIP_CMP_LESS;
-    if(*a > *b)
-        return ZIP_CMP_MORE;
-    if(a == b)
-        return ZIP_CMP_EQ;
-    if(a < b)
-        return ZIP_CMP_LESS;
-    return ZIP_CMP_MORE;
-}
+typedef struct {
+    UA_DateTime nextTime;                    /* The next time when the callbacks
+                                              * are to be executed */
+    UA_UInt64 interval;                      /* Interval in 100ns resolution. If
+                                                the interval is zero, the
+                                                callbacks are not repeated and
+                                                removed after execution. */
+} UA_TimerGroupKey;
 
-ZIP_PROTOTYPE(UA_TimerZip, UA_TimerEntry, UA_DateTime)
-ZIP_IMPL(UA_TimerZip, UA_TimerEntry, zipfields, UA_DateTime, nextTime, cmpDateTime)
+struct UA_TimerGroup {
+    ZIP_ENTRY(UA_TimerGroup) keyZipfields;
+    LIST_ENTRY(UA_TimerGroup) slotPointers;
+    UA_TimerGroupKey key;                    /* Unique among the groups */
+    LIST_HEAD(, UA_TimerEntry) entries;
+};
 
 /* The identifiers of entries are unique */
 static enum ZIP_CMP
@@ -57,9 +48,110 @@ cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
 ZIP_PROTOTYPE(UA_TimerIdZip, UA_TimerEntry, UA_UInt64)
 ZIP_IMPL(UA_TimerIdZip, UA_TimerEntry, idZipfields, UA_UInt64, id, cmpId)
 
+static enum ZIP_CMP
+cmpGroupKey(const UA_TimerGroupKey *a, const UA_TimerGroupKey *b) {
+    if(a->nextTime != b->nextTime)
+        return (a->nextTime < b->nextTime) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->interval != b->interval)
+        return (a->interval < b->interval) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return ZIP_CMP_EQ;
+}
+
+ZIP_PROTOTYPE(UA_TimerGroupZip, UA_TimerGroup, UA_TimerGroupKey)
+ZIP_IMPL(UA_TimerGroupZip, UA_TimerGroup, keyZipfields, UA_TimerGroupKey, key, cmpGroupKey)
+
+#define UA_TIMER_WHEEL_MASK (UA_TIMER_WHEEL_SLOTS - 1)
+
 void
 UA_Timer_init(UA_Timer *t) {
     memset(t, 0, sizeof(UA_Timer));
+    t->base = UA_DateTime_nowMonotonic();
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_INIT(t->timerMutex)
+#endif
+}
+
+static UA_UInt64
+timeToTick(const UA_Timer *t, UA_DateTime time) {
+    if(time <= t->base)
+        return 0;
+    return (UA_UInt64)(time - t->base) / UA_TIMER_TICK;
+}
+
+/* Round up to the next tick */
+static UA_DateTime
+alignToTick(const UA_Timer *t, UA_DateTime time) {
+    if(time <= t->base || time > UA_INT64_MAX - UA_TIMER_TICK)
+        return time;
+    UA_UInt64 offset = (UA_UInt64)(time - t->base) % UA_TIMER_TICK;
+    if(offset == 0)
+        return time;
+    return time + (UA_DateTime)(UA_TIMER_TICK - offset);
+}
+
+/* Get the slot relative to the current tick. Use the lowest level where the
+ * time lies within the current block of the next-higher level. */
+static UA_TimerSlot *
+getSlot(UA_Timer *t, UA_DateTime time) {
+    UA_UInt64 tick = timeToTick(t, time);
+    if(tick < t->currentTick)
+        tick = t->currentTick;
+    for(size_t level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        size_t shift = level * UA_TIMER_WHEEL_BITS;
+        if((tick >> (shift + UA_TIMER_WHEEL_BITS)) ==
+           (t->currentTick >> (shift + UA_TIMER_WHEEL_BITS)))
+            return &t->slots[level][(tick >> shift) & UA_TIMER_WHEEL_MASK];
+    }
+    return &t->overflow;
+}
+
+/* Find the group with the same time and interval or create a new one */
+static UA_TimerGroup *
+getGroup(UA_Timer *t, UA_DateTime nextTime, UA_UInt64 interval) {
+    UA_TimerGroupKey key;
+    key.nextTime = nextTime;
+    key.interval = interval;
+    UA_TimerGroup *g = ZIP_FIND(UA_TimerGroupZip, &t->groupRoot, &key);
+    if(g)
+        return g;
+
+    g = (UA_TimerGroup*)UA_malloc(sizeof(UA_TimerGroup));
+    if(!g)
+        return NULL;
+    g->key = key;
+    LIST_INIT(&g->entries);
+    LIST_INSERT_HEAD(getSlot(t, nextTime), g, slotPointers);
+    ZIP_INSERT(UA_TimerGroupZip, &t->groupRoot, g, ZIP_FFS32(UA_UInt32_random()));
+    return g;
+}
+
+/* Remove the entry from its group. Empty groups are removed. */
+static void
+unlinkEntry(UA_Timer *t, UA_TimerEntry *te) {
+    /* Don't break the processing of the group */
+    if(t->processNext == te)
+        t->processNext = LIST_NEXT(te, groupPointers);
+    if(t->processEnd == te)
+        t->processEnd = LIST_NEXT(te, groupPointers);
+
+    UA_TimerGroup *g = te->group;
+    LIST_REMOVE(te, groupPointers);
+    te->group = NULL;
+    if(LIST_EMPTY(&g->entries)) {
+        /* The group of the timed callbacks being processed is already taken
+         * out of the tree. Another group can have the same key then. */
+        if(ZIP_FIND(UA_TimerGroupZip, &t->groupRoot, &g->key) == g)
+            ZIP_REMOVE(UA_TimerGroupZip, &t->groupRoot, g);
+        LIST_REMOVE(g, slotPointers);
+        UA_free(g);
+    }
+}
+
+static void
+removeEntry(UA_Timer *t, UA_TimerEntry *te) {
+    unlinkEntry(t, te);
+    ZIP_REMOVE(UA_TimerIdZip, &t->idRoot, te);
+    UA_free(te);
 }
 
 static UA_StatusCode
@@ -74,20 +166,28 @@ addCallback(UA_Timer *t, UA_ApplicationCallback callback, void *application, voi
     if(!te)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
+    /* Add to the group */
+    UA_LOCK(t->timerMutex);
+    te->group = getGroup(t, nextTime, interval);
+    if(!te->group) {
+        UA_UNLOCK(t->timerMutex);
+        UA_free(te);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    LIST_INSERT_HEAD(&te->group->entries, te, groupPointers);
+
     /* Set the repeated callback */
-    te->interval = (UA_UInt64)interval;
     te->id = ++t->idCounter;
     te->callback = callback;
     te->application = application;
     te->data = data;
-    te->nextTime = nextTime;
 
     /* Set the output identifier */
     if(callbackId)
         *callbackId = te->id;
 
-    ZIP_INSERT(UA_TimerZip, &t->root, te, ZIP_FFS32(UA_UInt32_random()));
-    ZIP_INSERT(UA_TimerIdZip, &t->idRoot, te, ZIP_RANK(te, zipfields));
+    ZIP_INSERT(UA_TimerIdZip, &t->idRoot, te, ZIP_FFS32(UA_UInt32_random()));
+    UA_UNLOCK(t->timerMutex);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -113,7 +213,8 @@ UA_Timer_addRepeatedCallback(UA_Timer *t, UA_ApplicationCallback callback,
     if(interval == 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_DateTime nextTime = UA_DateTime_nowMonotonic() + (UA_DateTime)interval;
+    UA_DateTime nextTime =
+        alignToTick(t, UA_DateTime_nowMonotonic() + (UA_DateTime)interval);
     return addCallback(t, callback, application, data, nextTime,
                        interval, callbackId);
 }
@@ -125,74 +226,364 @@ UA_Timer_changeRepeatedCallbackInterval(UA_Timer *t, UA_UInt64 callbackId,
     if(interval_ms <= 0.0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Remove from the sorted list */
+    UA_LOCK(t->timerMutex);
     UA_TimerEntry *te = ZIP_FIND(UA_TimerIdZip, &t->idRoot, &callbackId);
-    if(!te)
+    if(!te) {
+        UA_UNLOCK(t->timerMutex);
         return UA_STATUSCODE_BADNOTFOUND;
+    }
 
-    /* Set the repeated callback */
-    ZIP_REMOVE(UA_TimerZip, &t->root, te);
-    te->interval = (UA_UInt64)(interval_ms * UA_DATETIME_MSEC); /* in 100ns resolution */
-    te->nextTime = UA_DateTime_nowMonotonic() + (UA_DateTime)te->interval;
-    ZIP_INSERT(UA_TimerZip, &t->root, te, ZIP_RANK(te, zipfields));
-    return UA_STATUSCODE_GOOD;
+    /* Move to the group with the new interval */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    UA_UInt64 interval = (UA_UInt64)(interval_ms * UA_DATETIME_MSEC); /* in 100ns resolution */
+    UA_DateTime nextTime =
+        alignToTick(t, UA_DateTime_nowMonotonic() + (UA_DateTime)interval);
+    UA_TimerGroup *g = getGroup(t, nextTime, interval);
+    if(!g) {
+        retval = UA_STATUSCODE_BADOUTOFMEMORY;
+    } else if(g != te->group) {
+        unlinkEntry(t, te);
+        te->group = g;
+        LIST_INSERT_HEAD(&g->entries, te, groupPointers);
+    }
+    UA_UNLOCK(t->timerMutex);
+    return retval;
 }
 
 void
 UA_Timer_removeCallback(UA_Timer *t, UA_UInt64 callbackId) {
+    UA_LOCK(t->timerMutex);
+
+    /* Skip the entry in the batches that are not yet executed. Also the timed
+     * callbacks that were already taken out of the timer. */
+    UA_TimerBatch *batch;
+    LIST_FOREACH(batch, &t->batches, pointers) {
+        for(size_t i = 0; i < batch->callbacksSize; i++) {
+            if(batch->callbacks[i].id == callbackId)
+                batch->callbacks[i].callback = NULL;
+        }
+    }
+
     UA_TimerEntry *te = ZIP_FIND(UA_TimerIdZip, &t->idRoot, &callbackId);
-    if(!te)
-        return;
+    if(te)
+        removeEntry(t, te);
+    UA_UNLOCK(t->timerMutex);
+}
 
-    ZIP_REMOVE(UA_TimerZip, &t->root, te);
-    ZIP_REMOVE(UA_TimerIdZip, &t->idRoot, te);
-    UA_free(te);
+static void
+moveSlot(UA_TimerSlot *dst, UA_TimerSlot *src) {
+    UA_TimerGroup *g;
+    while((g = LIST_FIRST(src))) {
+        LIST_REMOVE(g, slotPointers);
+        LIST_INSERT_HEAD(dst, g, slotPointers);
+    }
+}
+
+/* Take out all groups from the slots that were passed since the last
+ * processing. They are either executed or moved to a lower level. */
+static void
+advanceWheel(UA_Timer *t, UA_UInt64 nowTick, UA_TimerSlot *pending) {
+    for(size_t level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        size_t shift = level * UA_TIMER_WHEEL_BITS;
+        UA_UInt64 begin = t->currentTick >> shift;
+        UA_UInt64 end = nowTick >> shift;
+
+        /* Only the slots within the current block of the next-higher level are
+         * in use */
+        UA_Boolean lastBlock = ((begin >> UA_TIMER_WHEEL_BITS) == (end >> UA_TIMER_WHEEL_BITS));
+        if(!lastBlock)
+            end = begin | UA_TIMER_WHEEL_MASK;
+        for(UA_UInt64 i = begin; i <= end; i++)
+            moveSlot(pending, &t->slots[level][i & UA_TIMER_WHEEL_MASK]);
+
+        /* The higher levels are unchanged */
+        if(lastBlock) {
+            t->currentTick = nowTick;
+            return;
+        }
+    }
+    moveSlot(pending, &t->overflow);
+    t->currentTick = nowTick;
+}
+
+/* Sort the groups by their next execution time (merge sort). So that the
+ * callbacks are executed in the order of their scheduled time. */
+static void
+sortGroups(UA_TimerSlot *slot) {
+    UA_TimerGroup *list = LIST_FIRST(slot);
+    for(size_t width = 1; list; width *= 2) {
+        UA_TimerGroup *head = NULL;
+        UA_TimerGroup **tail = &head;
+        size_t merges = 0;
+        UA_TimerGroup *a = list;
+        while(a) {
+            merges++;
+            /* Split off two sublists with up to width elements */
+            UA_TimerGroup *b = a;
+            size_t aSize = 0;
+            for(; b && aSize < width; aSize++)
+                b = b->slotPointers.le_next;
+            size_t bSize = width;
+            /* Merge */
+            while(aSize > 0 || (bSize > 0 && b)) {
+                UA_TimerGroup *next;
+                if(aSize == 0 || (bSize > 0 && b && b->key.nextTime < a->key.nextTime)) {
+                    next = b;
+                    b = b->slotPointers.le_next;
+                    bSize--;
+                } else {
+                    next = a;
+                    a = a->slotPointers.le_next;
+                    aSize--;
+                }
+                *tail = next;
+                tail = &next->slotPointers.le_next;
+            }
+            a = b;
+        }
+        *tail = NULL;
+        list = head;
+        if(merges <= 1)
+            break;
+    }
+
+    /* Restore the back-pointers */
+    LIST_FIRST(slot) = list;
+    UA_TimerGroup **prev = &LIST_FIRST(slot);
+    for(UA_TimerGroup *g = list; g; g = g->slotPointers.le_next) {
+        g->slotPointers.le_prev = prev;
+        prev = &g->slotPointers.le_next;
+    }
+}
+
+/* Move the entries in front of the entries of the group with the same key.
+ * Their processing stops at the first entry of the other group. */
+static void
+mergeGroup(UA_Timer *t, UA_TimerGroup *g, UA_TimerGroup *dst) {
+    t->processEnd = LIST_FIRST(&dst->entries);
+    UA_TimerEntry *te, *prev = NULL;
+    while((te = LIST_FIRST(&g->entries))) {
+        LIST_REMOVE(te, groupPointers);
+        te->group = dst;
+        if(prev)
+            LIST_INSERT_AFTER(prev, te, groupPointers);
+        else
+            LIST_INSERT_HEAD(&dst->entries, te, groupPointers);
+        prev = te;
+    }
+    UA_free(g);
+}
+
+/* Take out the next entries of the group. The timed callbacks are removed
+ * before they are dispatched. The batch is registered until it is executed.
+ * Returns NULL if only a single entry is left or if the allocation failed. */
+static UA_TimerBatch *
+collectBatch(UA_Timer *t, UA_TimerEntry *te, UA_Boolean repeated) {
+    size_t batchSize = 0;
+    for(UA_TimerEntry *e = te; e && e != t->processEnd && batchSize < UA_TIMER_BATCHSIZE;
+        e = LIST_NEXT(e, groupPointers))
+        batchSize++;
+    if(batchSize < 2)
+        return NULL;
+
+    UA_TimerBatch *batch = (UA_TimerBatch*)
+        UA_malloc(sizeof(UA_TimerBatch) + batchSize * sizeof(UA_TimerCallback));
+    if(!batch)
+        return NULL;
+    batch->callbacksSize = batchSize;
+    batch->callbacks = (UA_TimerCallback*)&batch[1];
+    for(size_t i = 0; i < batchSize; i++) {
+        UA_TimerEntry *next = LIST_NEXT(te, groupPointers);
+        batch->callbacks[i].id = te->id;
+        batch->callbacks[i].callback = te->callback;
+        batch->callbacks[i].application = te->application;
+        batch->callbacks[i].data = te->data;
+        if(!repeated)
+            removeEntry(t, te);
+        te = next;
+    }
+    t->processNext = te;
+    LIST_INSERT_HEAD(&t->batches, batch, pointers);
+    return batch;
+}
+
+static void
+processGroup(UA_Timer *t, UA_TimerGroup *g, UA_DateTime nowMonotonic,
+             UA_TimerExecutionCallback executionCallback,
+             UA_TimerBatchExecutionCallback batchExecutionCallback,
+             void *executionApplication) {
+    /* Reinsert / remove to their new position first. Because the callback can
+     * interact with the timer. */
+    UA_TimerEntry *te = LIST_FIRST(&g->entries);
+    UA_Boolean repeated = (g->key.interval > 0);
+    ZIP_REMOVE(UA_TimerGroupZip, &t->groupRoot, g);
+    if(repeated) {
+        /* Set the time for the next execution. Prevent an infinite loop by
+         * forcing the next processing into the next iteration. */
+        g->key.nextTime += (UA_Int64)g->key.interval;
+        if(g->key.nextTime < nowMonotonic)
+            g->key.nextTime = nowMonotonic + 1;
+
+        /* A group with the same key was added in the meantime */
+        UA_TimerGroup *dst = ZIP_FIND(UA_TimerGroupZip, &t->groupRoot, &g->key);
+        if(dst) {
+            mergeGroup(t, g, dst);
+        } else {
+            LIST_INSERT_HEAD(getSlot(t, g->key.nextTime), g, slotPointers);
+            ZIP_INSERT(UA_TimerGroupZip, &t->groupRoot, g,
+                       ZIP_FFS32(UA_UInt32_random()));
+        }
+    } else {
+        /* Only keep the group in a list for unlinkEntry. So that no entries
+         * are added from within the callbacks. */
+        LIST_INSERT_HEAD(&t->executing, g, slotPointers);
+    }
+
+    /* Execute all entries of the group. The group may be freed from within a
+     * callback when the last entry is removed. processNext (and processEnd)
+     * is moved forward if the entry is removed. */
+    while(te && te != t->processEnd) {
+        /* Dispatch the entries of the group in batches */
+        if(batchExecutionCallback) {
+            UA_TimerBatch *batch = collectBatch(t, te, repeated);
+            if(batch) {
+                UA_UNLOCK(t->timerMutex);
+                batchExecutionCallback(executionApplication, batch);
+                UA_LOCK(t->timerMutex);
+                te = t->processNext;
+                continue;
+            }
+        }
+
+        t->processNext = LIST_NEXT(te, groupPointers);
+        UA_ApplicationCallback cb = te->callback;
+        void *application = te->application;
+        void *data = te->data;
+        if(!repeated)
+            removeEntry(t, te);
+        UA_UNLOCK(t->timerMutex);
+        executionCallback(executionApplication, cb, application, data);
+        UA_LOCK(t->timerMutex);
+        te = t->processNext;
+    }
+    t->processNext = NULL;
+    t->processEnd = NULL;
+}
+
+void
+UA_Timer_executeBatch(UA_Timer *t, UA_TimerBatch *batch) {
+    /* Look up every callback right before the execution. The earlier callbacks
+     * of the batch can remove the later entries. */
+    for(size_t i = 0; i < batch->callbacksSize; i++) {
+        UA_LOCK(t->timerMutex);
+        UA_TimerCallback tc = batch->callbacks[i];
+        UA_UNLOCK(t->timerMutex);
+        if(tc.callback)
+            tc.callback(tc.application, tc.data);
+    }
+
+    UA_LOCK(t->timerMutex);
+    LIST_REMOVE(batch, pointers);
+    UA_UNLOCK(t->timerMutex);
+    UA_free(batch);
+}
+
+static UA_DateTime
+earliestInSlot(UA_TimerSlot *slot) {
+    UA_DateTime earliest = UA_INT64_MAX;
+    UA_TimerGroup *g;
+    LIST_FOREACH(g, slot, slotPointers) {
+        if(g->key.nextTime < earliest)
+            earliest = g->key.nextTime;
+    }
+    return earliest;
+}
+
+/* The first non-empty slot (starting at the lowest level from the current
+ * tick) contains the earliest group */
+static UA_DateTime
+earliestTime(UA_Timer *t) {
+    for(size_t level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        size_t shift = level * UA_TIMER_WHEEL_BITS;
+        for(size_t i = (t->currentTick >> shift) & UA_TIMER_WHEEL_MASK;
+            i < UA_TIMER_WHEEL_SLOTS; i++) {
+            if(!LIST_EMPTY(&t->slots[level][i]))
+                return earliestInSlot(&t->slots[level][i]);
+        }
+    }
+    return earliestInSlot(&t->overflow);
 }
 
 UA_DateTime
 UA_Timer_process(UA_Timer *t, UA_DateTime nowMonotonic,
                  UA_TimerExecutionCallback executionCallback,
+                 UA_TimerBatchExecutionCallback batchExecutionCallback,
                  void *executionApplication) {
-    UA_TimerEntry *first;
-    while((first = ZIP_MIN(UA_TimerZip, &t->root)) &&
-          first->nextTime <= nowMonotonic) {
-        ZIP_REMOVE(UA_TimerZip, &t->root, first);
-
-        /* Reinsert / remove to their new position first. Because the callback
-         * can interact with the zip tree and expects the same entries in the
-         * root and idRoot trees. */
-
-        if(first->interval == 0) {
-            ZIP_REMOVE(UA_TimerIdZip, &t->idRoot, first);
-            executionCallback(executionApplication, first->callback,
-                              first->application, first->data);
-            UA_free(first);
+    UA_LOCK(t->timerMutex);
+    UA_UInt64 nowTick = timeToTick(t, nowMonotonic);
+    if(nowTick < t->currentTick)
+        nowTick = t->currentTick;
+
+    UA_TimerSlot pending;
+    LIST_INIT(&pending);
+    advanceWheel(t, nowTick, &pending);
+
+    /* Groups that are not yet due move to a lower level */
+    UA_TimerGroup *g, *g_tmp;
+    LIST_FOREACH_SAFE(g, &pending, slotPointers, g_tmp) {
+        if(g->key.nextTime <= nowMonotonic)
             continue;
-        }
+        LIST_REMOVE(g, slotPointers);
+        LIST_INSERT_HEAD(getSlot(t, g->key.nextTime), g, slotPointers);
+    }
 
-        /* Set the time for the next execution. Prevent an infinite loop by
-         * forcing the next processing into the next iteration. */
-        first->nextTime += (UA_Int64)first->interval;
-        if(first->nextTime < nowMonotonic)
-            first->nextTime = nowMonotonic + 1;
-        ZIP_INSERT(UA_TimerZip, &t->root, first, ZIP_RANK(first, zipfields));
-        executionCallback(executionApplication, first->callback,
-                          first->application, first->data);
+    /* Execute the due groups in the order of their time */
+    sortGroups(&pending);
+    while((g = LIST_FIRST(&pending))) {
+        LIST_REMOVE(g, slotPointers);
+        processGroup(t, g, nowMonotonic, executionCallback,
+                     batchExecutionCallback, executionApplication);
     }
 
     /* Return the timestamp of the earliest next callback */
-    first = ZIP_MIN(UA_TimerZip, &t->root);
-    return (first) ? first->nextTime : UA_INT64_MAX;
+    UA_DateTime earliest = earliestTime(t);
+    UA_UNLOCK(t->timerMutex);
+    return earliest;
 }
 
 static void
-freeEntry(UA_TimerEntry *te, void *data) {
-    UA_free(te);
+freeSlot(UA_TimerSlot *slot) {
+    UA_TimerGroup *g;
+    while((g = LIST_FIRST(slot))) {
+        UA_TimerEntry *te, *te_tmp;
+        LIST_FOREACH_SAFE(te, &g->entries, groupPointers, te_tmp)
+            UA_free(te);
+        LIST_REMOVE(g, slotPointers);
+        UA_free(g);
+    }
 }
 
 void
 UA_Timer_deleteMembers(UA_Timer *t) {
-    /* Free all nodes and reset the root */
-    ZIP_ITER(UA_TimerZip, &t->root, freeEntry, NULL);
-    ZIP_INIT(&t->root);
+    /* Free all groups and entries and reset the roots */
+    for(size_t level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        for(size_t i = 0; i < UA_TIMER_WHEEL_SLOTS; i++)
+            freeSlot(&t->slots[level][i]);
+    }
+    freeSlot(&t->overflow);
+    ZIP_INIT(&t->idRoot);
+    ZIP_INIT(&t->groupRoot);
+    t->processNext = NULL;
+    t->processEnd = NULL;
+
+    /* The batches are executed before the timer is deleted. Free the batches
+     * that were never handed to UA_Timer_executeBatch. */
+    UA_TimerBatch *batch;
+    while((batch = LIST_FIRST(&t->batches))) {
+        LIST_REMOVE(batch, pointers);
+        UA_free(batch);
+    }
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_DESTROY(t->timerMutex)
+#endif
 }
@@ -18,17 +18,66 @@ _UA_BEGIN_DECLS
 struct UA_TimerEntry;
 typedef struct UA_TimerEntry UA_TimerEntry;
 
-ZIP_HEAD(UA_TimerZip, UA_TimerEntry);
-typedef struct UA_TimerZip UA_TimerZip;
-
 ZIP_HEAD(UA_TimerIdZip, UA_TimerEntry);
 typedef struct UA_TimerIdZip UA_TimerIdZip;
 
-/* Only for a single thread. Protect by a mutex if required. */
+/* Entries with the same interval and the same next execution time are batched
+ * in a group. Groups are sorted into the slots of a hashed hierarchical timing
+ * wheel (Varghese and Lauck, 1987). Every level has UA_TIMER_WHEEL_SLOTS slots.
+ * A slot on level n covers UA_TIMER_WHEEL_SLOTS^n ticks. Inserting, removing
+ * and expiring a group takes constant time. Groups are moved to the lower
+ * levels when their time approaches. */
+struct UA_TimerGroup;
+typedef struct UA_TimerGroup UA_TimerGroup;
+
+LIST_HEAD(UA_TimerSlot, UA_TimerGroup);
+typedef struct UA_TimerSlot UA_TimerSlot;
+
+/* The groups are also found by their time and interval */
+ZIP_HEAD(UA_TimerGroupZip, UA_TimerGroup);
+typedef struct UA_TimerGroupZip UA_TimerGroupZip;
+
+#define UA_TIMER_TICK UA_DATETIME_MSEC
+#define UA_TIMER_WHEEL_BITS 6
+#define UA_TIMER_WHEEL_SLOTS (1 << UA_TIMER_WHEEL_BITS)
+#define UA_TIMER_WHEEL_LEVELS 6 /* 2^36 ticks (~795 days) */
+
+/* The callbacks of a group are dispatched in batches of up to
+ * UA_TIMER_BATCHSIZE. The batch is registered in the timer until it is
+ * executed. The callback is cleared when the entry is removed in the
+ * meantime. */
+typedef struct {
+    UA_UInt64 id;
+    UA_ApplicationCallback callback;
+    void *application;
+    void *data;
+} UA_TimerCallback;
+
+#define UA_TIMER_BATCHSIZE 64
+
+typedef struct UA_TimerBatch {
+    LIST_ENTRY(UA_TimerBatch) pointers;
+    size_t callbacksSize;
+    UA_TimerCallback *callbacks;
+} UA_TimerBatch;
+
+/* The timer can be used from several threads. The mutex is released while the
+ * callbacks are dispatched. */
 typedef struct {
-    UA_TimerZip root; /* The root of the time-sorted zip tree */
-    UA_TimerIdZip idRoot; /* The root of the id-sorted zip tree */
+    UA_TimerSlot slots[UA_TIMER_WHEEL_LEVELS][UA_TIMER_WHEEL_SLOTS];
+    UA_TimerSlot overflow; /* Groups beyond the range of the wheel */
+    UA_TimerSlot executing; /* The timed callbacks being processed */
+    UA_DateTime base;      /* Origin of the ticks */
+    UA_UInt64 currentTick; /* The slots of earlier ticks are processed */
+    UA_TimerIdZip idRoot;  /* The root of the id-sorted zip tree */
+    UA_TimerGroupZip groupRoot; /* The groups sorted by time and interval */
     UA_UInt64 idCounter;
+    UA_TimerEntry *processNext; /* Next entry of the group being processed */
+    UA_TimerEntry *processEnd;  /* The processing stops before this entry */
+    LIST_HEAD(, UA_TimerBatch) batches; /* Dispatched but not yet executed */
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_TYPE(timerMutex)
+#endif
 } UA_Timer;
 
 void UA_Timer_init(UA_Timer *t);
@@ -38,6 +87,9 @@ UA_Timer_addTimedCallback(UA_Timer *t, UA_ApplicationCallback callback,
                           void *application, void *data, UA_DateTime date,
                           UA_UInt64 *callbackId);
 
+/* The first execution of repeated callbacks is aligned to the next tick. So
+ * callbacks with the same interval that are added close together are batched
+ * in the same group. */
 UA_StatusCode
 UA_Timer_addRepeatedCallback(UA_Timer *t, UA_ApplicationCallback callback,
                              void *application, void *data, UA_Double interval_ms,
@@ -51,18 +103,34 @@ void
 UA_Timer_removeCallback(UA_Timer *t, UA_UInt64 callbackId);
 
 /* Process (dispatch) the repeated callbacks that have timed out. Returns the
- * timestamp of the next scheduled repeated callback. Not thread-safe.
- * Application is a pointer to the client / server environment for the callback.
- * Dispatched is set to true when at least one callback was run / dispatched. */
+ * timestamp of the next scheduled repeated callback. Only one thread processes
+ * the timer. Application is a pointer to the client / server environment for
+ * the callback.
+ *
+ * If the batchExecutionCallback is set, the entries of a group are dispatched
+ * in batches. It is meant to hand the batch over to a worker that runs
+ * UA_Timer_executeBatch. Otherwise the due entries are dispatched one by one.
+ * An entry that is removed from within a callback (also the following entries
+ * of the same group and batch) is not executed afterwards. */
 typedef void
 (*UA_TimerExecutionCallback)(void *executionApplication, UA_ApplicationCallback cb,
                              void *callbackApplication, void *data);
 
+typedef void
+(*UA_TimerBatchExecutionCallback)(void *executionApplication, UA_TimerBatch *batch);
+
 UA_DateTime
 UA_Timer_process(UA_Timer *t, UA_DateTime nowMonotonic,
                  UA_TimerExecutionCallback executionCallback,
+                 UA_TimerBatchExecutionCallback batchExecutionCallback,
                  void *executionApplication);
 
+/* Execute the callbacks of the batch whose entries were not removed since the
+ * dispatch. Then the batch is freed. Can be called from a different thread
+ * than UA_Timer_process. */
+void
+UA_Timer_executeBatch(UA_Timer *t, UA_TimerBatch *batch);
+
 void UA_Timer_deleteMembers(UA_Timer *t);
 
 _UA_END_DECLS
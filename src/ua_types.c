@@ -537,14 +537,48 @@ ExtensionObject_copy(UA_ExtensionObject const *src, UA_ExtensionObject *dst,
 }
 
 /* Variant */
+
+/* Shared variant data is prefixed with a header that holds the reference
+ * count. The header is padded so that the data keeps the alignment of the
+ * allocation. */
+typedef union {
+    volatile UA_UInt32 refCount;
+    UA_Byte padding[16];
+} SharedDataHeader;
+
+static SharedDataHeader *
+getSharedDataHeader(const UA_Variant *v) {
+    return (SharedDataHeader*)((uintptr_t)v->data - sizeof(SharedDataHeader));
+}
+
+static void
+Variant_releaseShared(UA_Variant *p) {
+    SharedDataHeader *header = getSharedDataHeader(p);
+    if(UA_atomic_subUInt32(&header->refCount, 1) > 0)
+        return;
+    if(!p->type->pointerFree) {
+        size_t length = (p->arrayLength == 0) ? 1 : p->arrayLength;
+        uintptr_t ptr = (uintptr_t)p->data;
+        for(size_t i = 0; i < length; ++i) {
+            UA_clear((void*)ptr, p->type);
+            ptr += p->type->memSize;
+        }
+    }
+    UA_free(header);
+}
+
 static void
 Variant_clear(UA_Variant *p, const UA_DataType *_) {
-    if(p->storageType != UA_VARIANT_DATA)
+    if(p->storageType == UA_VARIANT_DATA_NODELETE)
         return;
     if(p->type && p->data > UA_EMPTY_ARRAY_SENTINEL) {
-        if(p->arrayLength == 0)
-            p->arrayLength = 1;
-        UA_Array_delete(p->data, p->arrayLength, p->type);
+        if(p->storageType == UA_VARIANT_DATA_SHARED) {
+            Variant_releaseShared(p);
+        } else {
+            if(p->arrayLength == 0)
+                p->arrayLength = 1;
+            UA_Array_delete(p->data, p->arrayLength, p->type);
+        }
         p->data = NULL;
     }
     if((void*)p->arrayDimensions > UA_EMPTY_ARRAY_SENTINEL)
@@ -553,18 +587,27 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
 static UA_StatusCode
 Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
-    size_t length = src->arrayLength;
-    if(UA_Variant_isScalar(src))
-        length = 1;
-    UA_StatusCode retval = UA_Array_copy(src->data, length,
-                                         &dst->data, src->type);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    if(src->storageType == UA_VARIANT_DATA_SHARED &&
+       src->data > UA_EMPTY_ARRAY_SENTINEL) {
+        /* Take a reference instead of copying the data */
+        UA_atomic_addUInt32(&getSharedDataHeader(src)->refCount, 1);
+        dst->data = src->data;
+        dst->storageType = UA_VARIANT_DATA_SHARED;
+    } else {
+        size_t length = src->arrayLength;
+        if(UA_Variant_isScalar(src))
+            length = 1;
+        UA_StatusCode retval = UA_Array_copy(src->data, length,
+                                             &dst->data, src->type);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
     dst->arrayLength = src->arrayLength;
     dst->type = src->type;
     if(src->arrayDimensions) {
-        retval = UA_Array_copy(src->arrayDimensions, src->arrayDimensionsSize,
-            (void**)&dst->arrayDimensions, &UA_TYPES[UA_TYPES_INT32]);
+        UA_StatusCode retval =
+            UA_Array_copy(src->arrayDimensions, src->arrayDimensionsSize,
+                          (void**)&dst->arrayDimensions, &UA_TYPES[UA_TYPES_INT32]);
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
         dst->arrayDimensionsSize = src->arrayDimensionsSize;
@@ -572,6 +615,113 @@ Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Allocate the data with a shared data header (refCount 1) */
+static void *
+Variant_allocShared(size_t length, const UA_DataType *type) {
+    if(length > (SIZE_MAX - sizeof(SharedDataHeader)) / type->memSize)
+        return NULL;
+    SharedDataHeader *header = (SharedDataHeader*)
+        UA_malloc(sizeof(SharedDataHeader) + (length * type->memSize));
+    if(!header)
+        return NULL;
+    header->refCount = 1;
+    return (void*)((uintptr_t)header + sizeof(SharedDataHeader));
+}
+
+/* Copy the data of src into new shared storage. Nobody else references the new
+ * data yet. So it can still be written. */
+static UA_StatusCode
+Variant_copyIntoShared(const UA_Variant *src, UA_Variant *dst) {
+    size_t length = (src->arrayLength == 0) ? 1 : src->arrayLength;
+    UA_Variant_init(dst);
+    dst->data = Variant_allocShared(length, src->type);
+    if(!dst->data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    dst->type = src->type;
+    dst->storageType = UA_VARIANT_DATA_SHARED;
+    dst->arrayLength = src->arrayLength;
+
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(src->type->pointerFree) {
+        memcpy(dst->data, src->data, length * src->type->memSize);
+    } else {
+        uintptr_t ptrs = (uintptr_t)src->data;
+        uintptr_t ptrd = (uintptr_t)dst->data;
+        for(size_t i = 0; i < length; ++i) {
+            /* UA_copy initializes the target. So the entire array is
+             * initialized before a failure is handled in UA_Variant_clear. */
+            retval |= UA_copy((void*)ptrs, (void*)ptrd, src->type);
+            ptrs += src->type->memSize;
+            ptrd += src->type->memSize;
+        }
+    }
+
+    if(retval == UA_STATUSCODE_GOOD && src->arrayDimensions) {
+        retval = UA_Array_copy(src->arrayDimensions, src->arrayDimensionsSize,
+                               (void**)&dst->arrayDimensions,
+                               &UA_TYPES[UA_TYPES_UINT32]);
+        if(retval == UA_STATUSCODE_GOOD)
+            dst->arrayDimensionsSize = src->arrayDimensionsSize;
+    }
+    if(retval != UA_STATUSCODE_GOOD)
+        UA_Variant_clear(dst);
+    return retval;
+}
+
+UA_StatusCode
+UA_Variant_copyShared(const UA_Variant *src, UA_Variant *dst) {
+    /* Already shared or nothing to share */
+    if(src->storageType == UA_VARIANT_DATA_SHARED || !src->type ||
+       src->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return UA_Variant_copy(src, dst);
+    return Variant_copyIntoShared(src, dst);
+}
+
+UA_StatusCode
+UA_Variant_share(UA_Variant *v) {
+    if(v->storageType == UA_VARIANT_DATA_SHARED || !v->type ||
+       v->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return UA_STATUSCODE_GOOD;
+
+    /* Borrowed data (and array dimensions) are copied */
+    if(v->storageType == UA_VARIANT_DATA_NODELETE) {
+        UA_Variant shared;
+        UA_StatusCode retval = Variant_copyIntoShared(v, &shared);
+        if(retval == UA_STATUSCODE_GOOD)
+            *v = shared;
+        return retval;
+    }
+
+    /* Move the members into the shared storage */
+    size_t length = (v->arrayLength == 0) ? 1 : v->arrayLength;
+    void *data = Variant_allocShared(length, v->type);
+    if(!data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    memcpy(data, v->data, length * v->type->memSize);
+    UA_free(v->data);
+    v->data = data;
+    v->storageType = UA_VARIANT_DATA_SHARED;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Variant_unshare(UA_Variant *v) {
+    if(v->storageType != UA_VARIANT_DATA_SHARED)
+        return UA_STATUSCODE_GOOD;
+    UA_Variant unshared;
+    UA_Variant_init(&unshared);
+    if(v->data > UA_EMPTY_ARRAY_SENTINEL) {
+        size_t length = (v->arrayLength == 0) ? 1 : v->arrayLength;
+        UA_StatusCode retval = UA_Array_copy(v->data, length, &unshared.data, v->type);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        Variant_releaseShared(v);
+        v->data = unshared.data;
+    }
+    v->storageType = UA_VARIANT_DATA;
+    return UA_STATUSCODE_GOOD;
+}
+
 void
 UA_Variant_setScalar(UA_Variant *v, void * UA_RESTRICT p,
                      const UA_DataType *type) {
@@ -871,13 +1021,23 @@ Variant_setRange(UA_Variant *v, void *array, size_t arraySize,
                  const UA_NumericRange range, UA_Boolean copy) {
     /* Compute the strides */
     size_t count, block, stride, first;
-    UA_StatusCode retval = computeStrides(v, range, &count,
-                                          &block, &stride, &first);
+    UA_StatusCode retval = computeStrides(v, range, &count, &block, &stride, &first);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     if(count != arraySize)
         return UA_STATUSCODE_BADINDEXRANGEINVALID;
 
+    /* Shared data is immutable. Write into a new shared copy that is not
+     * referenced elsewhere yet. So the variant remains shared. */
+    if(v->storageType == UA_VARIANT_DATA_SHARED && v->data > UA_EMPTY_ARRAY_SENTINEL) {
+        UA_Variant privateCopy;
+        retval = Variant_copyIntoShared(v, &privateCopy);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        UA_Variant_clear(v);
+        *v = privateCopy;
+    }
+
     /* Move/copy the elements */
     size_t block_count = count / block;
     size_t elem_size = v->type->memSize;
@@ -51,6 +51,18 @@ typedef UA_StatusCode status;
 size_t UA_EXPORT
 getCountOfOptionalFields(const UA_DataType *type);
 
+/* Copy the variant into reference-counted storage (UA_VARIANT_DATA_SHARED).
+ * Further copies of dst take a reference instead of copying the data. If src
+ * is already shared, a reference is taken. */
+UA_StatusCode UA_EXPORT
+UA_Variant_copyShared(const UA_Variant *src, UA_Variant *dst);
+
+/* Move the data of the variant into reference-counted storage. Borrowed data
+ * (UA_VARIANT_DATA_NODELETE) is copied. Does nothing if the variant is already
+ * shared or empty. */
+UA_StatusCode UA_EXPORT
+UA_Variant_share(UA_Variant *v);
+
 /* Dump packet for debugging / fuzzing */
 #ifdef UA_DEBUG_DUMP_PKGS
 void UA_EXPORT
@@ -21,14 +21,18 @@ void UA_WorkQueue_init(UA_WorkQueue *wq) {
     SIMPLEQ_INIT(&wq->delayedCallbacks);
 
 #if UA_MULTITHREADING >= 200
-    wq->delayedCallbacks_checkpoint = NULL;
+    wq->workers = NULL;
+    wq->workersSize = 0;
+    wq->nextWorker = 0;
+    wq->jobsPushed = 0;
+    wq->sleepingWorkers = 0;
+    wq->inlineJobs = 0;
+    wq->inlineSeq = 0;
+    wq->delayedCallbacksSize = 0;
+    wq->delayedCallbacks_checkpoint = 0;
+    SIMPLEQ_INIT(&wq->readyCallbacks);
     UA_LOCK_INIT(wq->delayedCallbacks_accessMutex)
-
-    /* Initialize the dispatch queue for worker threads */
-    SIMPLEQ_INIT(&wq->dispatchQueue);
-    UA_LOCK_INIT(wq->dispatchQueue_accessMutex)
-    pthread_cond_init(&wq->dispatchQueue_condition, NULL);
-    UA_LOCK_INIT(wq->dispatchQueue_conditionMutex)
+    UA_LOCK_INIT(wq->enqueueMutex)
 #endif
 }
 
@@ -39,33 +43,16 @@ static void UA_WorkQueue_manuallyProcessDelayed(UA_WorkQueue *wq);
 
 void UA_WorkQueue_cleanup(UA_WorkQueue *wq) {
 #if UA_MULTITHREADING >= 200
-    /* Shut down workers */
+    /* Shut down workers. This also executes the remaining jobs. */
     UA_WorkQueue_stop(wq);
-
-    /* Execute remaining work in the dispatch queue */
-    while(true) {
-        UA_LOCK(wq->dispatchQueue_accessMutex);
-        UA_DelayedCallback *dc = SIMPLEQ_FIRST(&wq->dispatchQueue);
-        if(!dc) {
-            UA_UNLOCK(wq->dispatchQueue_accessMutex);
-            break;
-        }
-        SIMPLEQ_REMOVE_HEAD(&wq->dispatchQueue, next);
-        UA_UNLOCK(wq->dispatchQueue_accessMutex);
-        dc->callback(dc->application, dc->data);
-        UA_free(dc);
-    }
 #endif
 
     /* All workers are shut down. Execute remaining delayed work here. */
     UA_WorkQueue_manuallyProcessDelayed(wq);
 
 #if UA_MULTITHREADING >= 200
-    wq->delayedCallbacks_checkpoint = NULL;
-    UA_LOCK_DESTROY(wq->dispatchQueue_accessMutex);
-    pthread_cond_destroy(&wq->dispatchQueue_condition);
-    UA_LOCK_DESTROY(wq->dispatchQueue_conditionMutex);
     UA_LOCK_DESTROY(wq->delayedCallbacks_accessMutex);
+    UA_LOCK_DESTROY(wq->enqueueMutex);
 #endif
 }
 
@@ -75,62 +62,169 @@ void UA_WorkQueue_cleanup(UA_WorkQueue *wq) {
 
 #if UA_MULTITHREADING >= 200
 
+#define UA_WORKQUEUE_DEQUEMASK (UA_WORKQUEUE_DEQUESIZE - 1)
+
+/* Busy workers look for ready delayed callbacks after every nth job */
+#define UA_WORKQUEUE_DELAYEDINTERVAL 64
+
+/* Compare sequence numbers that can wrap around */
+#define UA_SEQ_LESS(a, b) ((UA_Int32)((a) - (b)) < 0)
+
+/* Push a job at the bottom of the deque. Only called with the enqueue
+ * mutex. */
+static UA_Boolean
+pushJob(UA_Worker *w, const UA_WorkJob *job) {
+    UA_UInt32 b = w->bottom;
+    UA_UInt32 t = w->top;
+    if(b - t >= UA_WORKQUEUE_DEQUESIZE)
+        return false; /* Full */
+    w->jobs[b & UA_WORKQUEUE_DEQUEMASK] = *job;
+    UA_atomic_sync(); /* The job is written before it becomes visible */
+    w->bottom = b + 1;
+    return true;
+}
+
+/* Take a job from the top of the deque. Can be called from any worker. The job
+ * is marked as busy in the taking worker before the CAS. So it remains visible
+ * for the delayed callbacks in between. */
+static UA_Boolean
+takeJob(UA_Worker *victim, UA_Worker *thief, UA_WorkJob *job) {
+    while(true) {
+        UA_UInt32 t = victim->top;
+        UA_atomic_sync();
+        UA_UInt32 b = victim->bottom;
+        if(!UA_SEQ_LESS(t, b))
+            return false; /* Empty */
+        *job = victim->jobs[t & UA_WORKQUEUE_DEQUEMASK];
+        thief->busySeq = job->seq;
+        thief->busy = true;
+        UA_atomic_sync();
+        if(UA_atomic_cmpxchgUInt32(&victim->top, t, t + 1) == t)
+            return true;
+        thief->busy = false; /* Lost the race. Try again. */
+    }
+}
+
+static UA_Boolean
+hasJobs(UA_WorkQueue *wq) {
+    for(size_t i = 0; i < wq->workersSize; i++) {
+        UA_Worker *w = &wq->workers[i];
+        if(UA_SEQ_LESS(w->top, w->bottom))
+            return true;
+    }
+    return false;
+}
+
+/* Forward declaration */
+static UA_DelayedCallback * takeReadyCallback(UA_WorkQueue *wq);
+
 static void *
 workerLoop(UA_Worker *worker) {
     UA_WorkQueue *wq = worker->queue;
-    UA_UInt32 *counter = &worker->counter;
-    volatile UA_Boolean *running = &worker->running;
+    size_t index = (size_t)(worker - wq->workers);
 
     /* Initialize the (thread local) random seed with the ram address
      * of the worker. Not for security-critical entropy! */
     UA_random_seed((uintptr_t)worker);
 
-    while(*running) {
-        UA_atomic_addUInt32(counter, 1);
-
-        /* Remove a callback from the queue */
-        UA_LOCK(wq->dispatchQueue_accessMutex);
-        UA_DelayedCallback *dc = SIMPLEQ_FIRST(&wq->dispatchQueue);
-        if(dc)
-            SIMPLEQ_REMOVE_HEAD(&wq->dispatchQueue, next);
-        UA_UNLOCK(wq->dispatchQueue_accessMutex);
-
-        /* Nothing to do. Sleep until a callback is dispatched */
-        if(!dc) {
-            UA_LOCK(wq->dispatchQueue_conditionMutex);
-            pthread_cond_wait(&wq->dispatchQueue_condition,
-                              &wq->dispatchQueue_conditionMutex);
-            UA_UNLOCK(wq->dispatchQueue_conditionMutex);
-            continue;
+    UA_WorkJob job;
+    UA_UInt32 executed = 0;
+    while(worker->running) {
+        /* Take a job from the own deque first. Then steal from the others. */
+        UA_Boolean found = false;
+        for(size_t i = 0; i < wq->workersSize && !found; i++) {
+            UA_Worker *victim = &wq->workers[(index + i) % wq->workersSize];
+            found = takeJob(victim, worker, &job);
         }
 
         /* Execute */
-        if(dc->callback)
-            dc->callback(dc->application, dc->data);
-        UA_free(dc);
+        if(found) {
+            job.callback(job.application, job.data);
+            UA_atomic_sync(); /* Finish before no longer marked as busy */
+            worker->busy = false;
+            /* Look at the delayed callbacks also when the workers never idle */
+            if((++executed % UA_WORKQUEUE_DELAYEDINTERVAL) != 0)
+                continue;
+        }
+
+        /* Execute delayed callbacks that are ready */
+        UA_DelayedCallback *dc = takeReadyCallback(wq);
+        if(dc) {
+            if(dc->callback)
+                dc->callback(dc->application, dc->data);
+            UA_free(dc);
+            continue;
+        }
+        if(found)
+            continue;
+
+        /* Nothing to do. Sleep until a job is pushed and this worker is
+         * selected for the wakeup. The sleeping flag is set (with a barrier)
+         * before checking the deques for the last time. The enqueueing thread
+         * pushes (with a barrier) before looking for sleeping workers. So
+         * either the job is seen here or the worker is seen by the enqueueing
+         * thread. */
+        pthread_mutex_lock(&worker->sleepMutex);
+        worker->sleeping = true;
+        UA_atomic_addUInt32(&wq->sleepingWorkers, 1);
+        if(!hasJobs(wq)) {
+            while(!worker->wakeup && worker->running)
+                pthread_cond_wait(&worker->sleepCondition, &worker->sleepMutex);
+        }
+        worker->wakeup = false;
+        worker->sleeping = false;
+        UA_atomic_subUInt32(&wq->sleepingWorkers, 1);
+        pthread_mutex_unlock(&worker->sleepMutex);
     }
 
     return NULL;
 }
 
+/* Wake up a single sleeping worker. Start looking at the preferred worker. */
+static void
+wakeupWorker(UA_WorkQueue *wq, size_t preferred) {
+    UA_atomic_sync();
+    if(wq->sleepingWorkers == 0)
+        return;
+    for(size_t i = 0; i < wq->workersSize; i++) {
+        UA_Worker *w = &wq->workers[(preferred + i) % wq->workersSize];
+        if(!w->sleeping)
+            continue;
+        pthread_mutex_lock(&w->sleepMutex);
+        UA_Boolean woken = (w->sleeping && !w->wakeup);
+        if(woken) {
+            w->wakeup = true;
+            pthread_cond_signal(&w->sleepCondition);
+        }
+        pthread_mutex_unlock(&w->sleepMutex);
+        if(woken)
+            return;
+    }
+}
+
 /* Can be called repeatedly and starts additional workers */
 UA_StatusCode
 UA_WorkQueue_start(UA_WorkQueue *wq, size_t workersCount) {
     if(wq->workersSize > 0 || workersCount == 0)
         return UA_STATUSCODE_BADINTERNALERROR;
     
-    /* Create the worker array */
+    /* Create the worker array. This preallocates the job rings. */
     wq->workers = (UA_Worker*)UA_calloc(workersCount, sizeof(UA_Worker));
     if(!wq->workers)
         return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < workersCount; ++i) {
+        UA_Worker *w = &wq->workers[i];
+        w->queue = wq;
+        w->running = true;
+        pthread_mutex_init(&w->sleepMutex, NULL);
+        pthread_cond_init(&w->sleepCondition, NULL);
+    }
     wq->workersSize = workersCount;
+    wq->nextWorker = 0;
 
     /* Spin up the workers */
     for(size_t i = 0; i < workersCount; ++i) {
         UA_Worker *w = &wq->workers[i];
-        w->queue = wq;
-        w->counter = 0;
-        w->running = true;
         pthread_create(&w->thread, NULL, (void* (*)(void*))workerLoop, w);
     }
     return UA_STATUSCODE_GOOD;
@@ -140,17 +234,32 @@ void UA_WorkQueue_stop(UA_WorkQueue *wq) {
     if(wq->workersSize == 0)
         return;
 
-    /* Signal the workers to stop */
-    for(size_t i = 0; i < wq->workersSize; ++i)
-        wq->workers[i].running = false;
-
-    /* Wake up all workers */
-    pthread_cond_broadcast(&wq->dispatchQueue_condition);
+    /* Signal the workers to stop and wake them up */
+    for(size_t i = 0; i < wq->workersSize; ++i) {
+        UA_Worker *w = &wq->workers[i];
+        pthread_mutex_lock(&w->sleepMutex);
+        w->running = false;
+        pthread_cond_signal(&w->sleepCondition);
+        pthread_mutex_unlock(&w->sleepMutex);
+    }
 
-    /* Wait for the workers to finish, then clean up */
+    /* Wait for the workers to finish */
     for(size_t i = 0; i < wq->workersSize; ++i)
         pthread_join(wq->workers[i].thread, NULL);
 
+    /* Execute the remaining jobs in the calling thread */
+    UA_WorkJob job;
+    for(size_t i = 0; i < wq->workersSize; ++i) {
+        UA_Worker *w = &wq->workers[i];
+        while(takeJob(w, w, &job))
+            job.callback(job.application, job.data);
+    }
+
+    /* Clean up */
+    for(size_t i = 0; i < wq->workersSize; ++i) {
+        pthread_mutex_destroy(&wq->workers[i].sleepMutex);
+        pthread_cond_destroy(&wq->workers[i].sleepCondition);
+    }
     UA_free(wq->workers);
     wq->workers = NULL;
     wq->workersSize = 0;
@@ -158,23 +267,38 @@ void UA_WorkQueue_stop(UA_WorkQueue *wq) {
 
 void UA_WorkQueue_enqueue(UA_WorkQueue *wq, UA_ApplicationCallback cb,
                           void *application, void *data) {
-    UA_DelayedCallback *dc = (UA_DelayedCallback*)UA_malloc(sizeof(UA_DelayedCallback));
-    if(!dc) {
-        cb(application, data); /* Execute immediately if the memory could not be allocated */
+    UA_WorkJob job;
+    job.callback = cb;
+    job.application = application;
+    job.data = data;
+
+    /* Push to the next worker in round-robin order. Skip full deques. The
+     * sequence numbers are increasing in every deque. */
+    UA_LOCK(wq->enqueueMutex);
+    job.seq = wq->jobsPushed;
+    for(size_t i = 0; i < wq->workersSize; i++) {
+        size_t index = (wq->nextWorker + i) % wq->workersSize;
+        if(!pushJob(&wq->workers[index], &job))
+            continue;
+        wq->jobsPushed++;
+        wq->nextWorker = (index + 1) % wq->workersSize;
+        UA_UNLOCK(wq->enqueueMutex);
+        wakeupWorker(wq, index);
         return;
     }
 
-    dc->callback = cb;
-    dc->application = application;
-    dc->data = data;
-
-    /* Enqueue for the worker threads */
-    UA_LOCK(wq->dispatchQueue_accessMutex);
-    SIMPLEQ_INSERT_TAIL(&wq->dispatchQueue, dc, next);
-    UA_UNLOCK(wq->dispatchQueue_accessMutex);
-
-    /* Wake up sleeping workers */
-    pthread_cond_broadcast(&wq->dispatchQueue_condition);
+    /* No workers or all deques are full. Execute immediately. Other threads
+     * may execute jobs inline at the same time. Then the sequence number of
+     * the first job is kept until all of them are finished. */
+    if(wq->inlineJobs == 0)
+        wq->inlineSeq = job.seq;
+    UA_atomic_sync();
+    UA_atomic_addUInt32(&wq->inlineJobs, 1);
+    wq->jobsPushed++;
+    UA_UNLOCK(wq->enqueueMutex);
+    cb(application, data);
+    UA_atomic_sync();
+    UA_atomic_subUInt32(&wq->inlineJobs, 1);
 }
 
 #endif
@@ -185,44 +309,76 @@ void UA_WorkQueue_enqueue(UA_WorkQueue *wq, UA_ApplicationCallback cb,
 
 #if UA_MULTITHREADING >= 200
 
-/* Delayed Callbacks are called only when all callbacks that were dispatched
- * prior are finished. After every UA_MAX_DELAYED_SAMPLE delayed Callbacks that
- * were added to the queue, we sample the counters from the workers. The
- * counters are compared to the last counters that were sampled. If every worker
- * has proceeded the counter, then we know that all delayed callbacks prior to
- * the last sample-point are safe to execute. */
+/* Delayed callbacks are called only when all jobs that were enqueued prior are
+ * finished. Every job gets a sequence number when it is enqueued. When a
+ * checkpoint is made, the sequence number of the next job is stored. All
+ * delayed callbacks enqueued before the checkpoint are safe to execute once no
+ * job with a lower sequence number is waiting in a deque or is currently being
+ * executed. The deques are FIFO. So only the top job of every deque needs to
+ * be checked. */
+static UA_Boolean
+checkpointPassed(UA_WorkQueue *wq, UA_UInt32 seq) {
+    /* Waiting jobs. Read the deques before the busy flags. A job is marked
+     * as busy before it is taken from the deque. */
+    for(size_t i = 0; i < wq->workersSize; i++) {
+        UA_Worker *w = &wq->workers[i];
+        UA_UInt32 t = w->top;
+        UA_atomic_sync();
+        UA_UInt32 b = w->bottom;
+        if(UA_SEQ_LESS(t, b) &&
+           UA_SEQ_LESS(w->jobs[t & UA_WORKQUEUE_DEQUEMASK].seq, seq))
+            return false;
+    }
 
-/* Sample the worker counter for every nth delayed callback. This is used to
- * test that all workers have **finished** their current job before the delayed
- * callback is processed. */
-#define UA_MAX_DELAYED_SAMPLE 100
+    /* Jobs being executed */
+    UA_atomic_sync();
+    for(size_t i = 0; i < wq->workersSize; i++) {
+        UA_Worker *w = &wq->workers[i];
+        if(w->busy && UA_SEQ_LESS(w->busySeq, seq))
+            return false;
+    }
+    if(wq->inlineJobs > 0 && UA_SEQ_LESS(wq->inlineSeq, seq))
+        return false;
+    return true;
+}
 
 /* Call only with a held mutex for the delayed callbacks */
 static void
-dispatchDelayedCallbacks(UA_WorkQueue *wq, UA_DelayedCallback *cb) {
-    /* Are callbacks before the last checkpoint ready? */
-    for(size_t i = 0; i < wq->workersSize; ++i) {
-        if(wq->workers[i].counter == wq->workers[i].checkpointCounter)
+dispatchDelayedCallbacks(UA_WorkQueue *wq) {
+    /* Move the delayed callbacks up to the checkpoint to the ready queue */
+    if(wq->delayedCallbacks_checkpoint > 0) {
+        if(!checkpointPassed(wq, wq->delayedCallbacks_checkpointSeq))
             return;
+        for(; wq->delayedCallbacks_checkpoint > 0; wq->delayedCallbacks_checkpoint--) {
+            UA_DelayedCallback *dc = SIMPLEQ_FIRST(&wq->delayedCallbacks);
+            SIMPLEQ_REMOVE_HEAD(&wq->delayedCallbacks, next);
+            SIMPLEQ_INSERT_TAIL(&wq->readyCallbacks, dc, next);
+            wq->delayedCallbacksSize--;
+        }
     }
 
-    /* Dispatch all delayed callbacks up to the checkpoint.
-     * TODO: Move over the entire queue up to the checkpoint in one step. */
-    if(wq->delayedCallbacks_checkpoint != NULL) {
-        UA_DelayedCallback *iter, *tmp_iter;
-        SIMPLEQ_FOREACH_SAFE(iter, &wq->delayedCallbacks, next, tmp_iter) {
-            UA_LOCK(wq->dispatchQueue_accessMutex);
-            SIMPLEQ_INSERT_TAIL(&wq->dispatchQueue, iter, next);
-            UA_UNLOCK(wq->dispatchQueue_accessMutex);
-            if(iter == wq->delayedCallbacks_checkpoint)
-                break;
-        }
+    /* Create the new checkpoint */
+    if(wq->delayedCallbacksSize > 0) {
+        wq->delayedCallbacks_checkpoint = wq->delayedCallbacksSize;
+        UA_atomic_sync();
+        wq->delayedCallbacks_checkpointSeq = wq->jobsPushed;
     }
+}
 
-    /* Create the new sample point */
-    for(size_t i = 0; i < wq->workersSize; ++i)
-        wq->workers[i].checkpointCounter = wq->workers[i].counter;
-    wq->delayedCallbacks_checkpoint = cb;
+static UA_DelayedCallback *
+takeReadyCallback(UA_WorkQueue *wq) {
+    /* Racy early exit without taking the mutex */
+    if(wq->delayedCallbacksSize == 0 && SIMPLEQ_EMPTY(&wq->readyCallbacks))
+        return NULL;
+
+    UA_LOCK(wq->delayedCallbacks_accessMutex);
+    if(SIMPLEQ_EMPTY(&wq->readyCallbacks))
+        dispatchDelayedCallbacks(wq);
+    UA_DelayedCallback *dc = SIMPLEQ_FIRST(&wq->readyCallbacks);
+    if(dc)
+        SIMPLEQ_REMOVE_HEAD(&wq->readyCallbacks, next);
+    UA_UNLOCK(wq->delayedCallbacks_accessMutex);
+    return dc;
 }
 
 #endif
@@ -230,32 +386,36 @@ dispatchDelayedCallbacks(UA_WorkQueue *wq, UA_DelayedCallback *cb) {
 void
 UA_WorkQueue_enqueueDelayed(UA_WorkQueue *wq, UA_DelayedCallback *cb) {
 #if UA_MULTITHREADING >= 200
-    UA_LOCK(wq->dispatchQueue_accessMutex);
+    UA_LOCK(wq->delayedCallbacks_accessMutex);
 #endif
 
-    SIMPLEQ_INSERT_HEAD(&wq->delayedCallbacks, cb, next);
+    SIMPLEQ_INSERT_TAIL(&wq->delayedCallbacks, cb, next);
 
 #if UA_MULTITHREADING >= 200
-    wq->delayedCallbacks_sinceDispatch++;
-    if(wq->delayedCallbacks_sinceDispatch > UA_MAX_DELAYED_SAMPLE) {
-        dispatchDelayedCallbacks(wq, cb);
-        wq->delayedCallbacks_sinceDispatch = 0;
-    }
-
-    UA_UNLOCK(wq->dispatchQueue_accessMutex);
+    wq->delayedCallbacksSize++;
+    dispatchDelayedCallbacks(wq);
+    UA_UNLOCK(wq->delayedCallbacks_accessMutex);
 #endif
 }
 
 /* Assumes all workers are shut down */
 void UA_WorkQueue_manuallyProcessDelayed(UA_WorkQueue *wq) {
     UA_DelayedCallback *dc, *dc_tmp;
+#if UA_MULTITHREADING >= 200
+    /* The ready callbacks were enqueued first */
+    SIMPLEQ_FOREACH_SAFE(dc, &wq->readyCallbacks, next, dc_tmp) {
+        SIMPLEQ_REMOVE_HEAD(&wq->readyCallbacks, next);
+        if(dc->callback)
+            dc->callback(dc->application, dc->data);
+        UA_free(dc);
+    }
+    wq->delayedCallbacksSize = 0;
+    wq->delayedCallbacks_checkpoint = 0;
+#endif
     SIMPLEQ_FOREACH_SAFE(dc, &wq->delayedCallbacks, next, dc_tmp) {
         SIMPLEQ_REMOVE_HEAD(&wq->delayedCallbacks, next);
         if(dc->callback)
             dc->callback(dc->application, dc->data);
         UA_free(dc);
     }
-#if UA_MULTITHREADING >= 200
-    wq->delayedCallbacks_checkpoint = NULL;
-#endif
 }
@@ -45,22 +45,46 @@ typedef struct UA_WorkQueue UA_WorkQueue;
 
 #if UA_MULTITHREADING >= 200
 
-/* Workers take out callbacks from the work queue and execute them.
+/* Size of the per-worker job ring. Must be a power of two. */
+#define UA_WORKQUEUE_DEQUESIZE 256
+
+typedef struct {
+    UA_ApplicationCallback callback;
+    void *application;
+    void *data;
+    UA_UInt32 seq; /* Sequence number in the order of enqueueing */
+} UA_WorkJob;
+
+/* Workers take out jobs from the work queue and execute them. Every worker has
+ * its own Chase-Lev deque with a preallocated ring of jobs. Jobs are pushed at
+ * the bottom by the enqueueing thread. The deques have a single owner end. So
+ * the enqueueing threads are serialized by a mutex. The owner and other
+ * (stealing) workers take jobs from the top with a CAS. Since the workers never
+ * push, the owner does not need the pop-at-the-bottom path.
  *
- * Future Plans: Use work-stealing to load-balance between cores.
  * Le, Nhat Minh, et al. "Correct and efficient work-stealing for weak memory
  * models." ACM SIGPLAN Notices. Vol. 48. No. 8. ACM, 2013. */
 typedef struct {
     pthread_t thread;
     volatile UA_Boolean running;
     UA_WorkQueue *queue;
-    UA_UInt32 counter;
-    UA_UInt32 checkpointCounter; /* Counter when the last checkpoint was made
-                                  * for the delayed callbacks */
 
-    /* separate cache lines */
-    char padding[64 - sizeof(void*) - sizeof(pthread_t) -
-                 sizeof(UA_UInt32) - sizeof(UA_Boolean)];
+    /* Deque */
+    volatile UA_UInt32 top;    /* Taken from here with a CAS */
+    char padding[64 - sizeof(UA_UInt32)]; /* separate cache lines */
+    volatile UA_UInt32 bottom; /* Pushed to here by the enqueueing thread */
+    UA_WorkJob jobs[UA_WORKQUEUE_DEQUESIZE];
+
+    /* The sequence number of the job that is currently executed. Used to
+     * decide when delayed callbacks are safe to execute. */
+    volatile UA_Boolean busy;
+    volatile UA_UInt32 busySeq;
+
+    /* Sleep until woken up individually when there is no work */
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t sleepCondition;
+    volatile UA_Boolean sleeping;
+    UA_Boolean wakeup;
 } UA_Worker;
 
 #endif
@@ -71,12 +95,15 @@ struct UA_WorkQueue {
 #if UA_MULTITHREADING >= 200
     UA_Worker *workers;
     size_t workersSize;
-
-    /* Work queue */
-    SIMPLEQ_HEAD(, UA_DelayedCallback) dispatchQueue; /* Dispatch queue for the worker threads */
-    UA_LOCK_TYPE(dispatchQueue_accessMutex) /* mutex for access to queue */
-    pthread_cond_t dispatchQueue_condition; /* so the workers don't spin if the queue is empty */
-    UA_LOCK_TYPE(dispatchQueue_conditionMutex) /* mutex for access to condition variable */
+    UA_LOCK_TYPE(enqueueMutex) /* Serializes the pushing threads */
+    size_t nextWorker;       /* Round-robin target for the next job */
+    UA_UInt32 jobsPushed;    /* Sequence number of the next job */
+    volatile UA_UInt32 sleepingWorkers;
+
+    /* Jobs that are executed by the enqueueing thread when all deques are
+     * full. The sequence number is a lower bound for the executing jobs. */
+    volatile UA_UInt32 inlineJobs;
+    volatile UA_UInt32 inlineSeq;
 #endif
 
     /* Delayed callbacks
@@ -84,9 +111,14 @@ struct UA_WorkQueue {
     SIMPLEQ_HEAD(, UA_DelayedCallback) delayedCallbacks;
 #if UA_MULTITHREADING >= 200
     UA_LOCK_TYPE(delayedCallbacks_accessMutex)
-    UA_DelayedCallback *delayedCallbacks_checkpoint;
-    size_t delayedCallbacks_sinceDispatch; /* How many have been added since we
-                                            * tried to dispatch callbacks? */
+    size_t delayedCallbacksSize;
+    size_t delayedCallbacks_checkpoint; /* Number of delayed callbacks (from the
+                                         * head) that were enqueued before the
+                                         * checkpoint */
+    UA_UInt32 delayedCallbacks_checkpointSeq; /* jobsPushed at the checkpoint */
+
+    /* Delayed callbacks that are safe to execute. Taken out by idle workers. */
+    SIMPLEQ_HEAD(, UA_DelayedCallback) readyCallbacks;
 #endif
 };
 
@@ -97,7 +129,7 @@ void UA_WorkQueue_init(UA_WorkQueue *wq);
  * have a NULL callback that is not executed.
  *
  * This method checks internally if existing delayed work can be moved from the
- * delayed queue to the worker dispatch queue. */
+ * delayed queue to the ready queue of the workers. */
 void UA_WorkQueue_enqueueDelayed(UA_WorkQueue *wq, UA_DelayedCallback *cb);
 
 /* Stop the workers, process all enqueued work in the calling thread, clean up
@@ -111,7 +143,10 @@ UA_StatusCode UA_WorkQueue_start(UA_WorkQueue *wq, size_t workersCount);
 
 void UA_WorkQueue_stop(UA_WorkQueue *wq);
 
-/* Enqueue work for the worker threads */
+/* Enqueue work for the worker threads. Jobs are distributed round-robin over
+ * the worker deques and only one sleeping worker is woken up. If all deques are
+ * full, the job is executed in the calling thread. Can be called from any
+ * thread (the main loop and threads processing a request). */
 void UA_WorkQueue_enqueue(UA_WorkQueue *wq, UA_ApplicationCallback cb,
                           void *application, void *data);
 
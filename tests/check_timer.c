@@ -4,6 +4,7 @@
 
 #include "ua_timer.h"
 #include "check.h"
+#include "testing_clock.h"
 
 #include <time.h>
 #include <stdio.h>
@@ -42,7 +43,7 @@ START_TEST(benchmarkTimer) {
     clock_t begin = clock();
     UA_DateTime now = 0;
     for(size_t i = 0; i < 1000; i++) {
-        UA_DateTime next = UA_Timer_process(&timer, now, executionCallback, NULL);
+        UA_DateTime next = UA_Timer_process(&timer, now, executionCallback, NULL, NULL);
         /* At least 100 msec distance between _process */
         now = next + (UA_DATETIME_MSEC * 100);
         if(next > now)
@@ -57,10 +58,251 @@ START_TEST(benchmarkTimer) {
     UA_Timer_deleteMembers(&timer);
 } END_TEST
 
+#define N_BATCHED 1000
+
+UA_Timer batchTimer;
+UA_UInt64 batchIds[N_BATCHED];
+
+/* Removes all entries, including itself */
+static void
+removeAllCallback(void *application, void *data) {
+    count++;
+    for(size_t i = 0; i < N_BATCHED; i++)
+        UA_Timer_removeCallback(&batchTimer, batchIds[i]);
+}
+
+START_TEST(batchedCallbacks) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+
+    /* All entries share the interval and the phase */
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, timerCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    UA_DateTime next = UA_Timer_process(&batchTimer, now, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 0);
+    ck_assert_int_eq(next, now + (10 * UA_DATETIME_MSEC));
+
+    next = UA_Timer_process(&batchTimer, next, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, N_BATCHED);
+
+    /* Remove every second entry */
+    for(size_t i = 0; i < N_BATCHED; i += 2)
+        UA_Timer_removeCallback(&batchTimer, batchIds[i]);
+    next = UA_Timer_process(&batchTimer, next, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, N_BATCHED + (N_BATCHED / 2));
+
+    /* Change the interval of one entry */
+    UA_StatusCode retval =
+        UA_Timer_changeRepeatedCallbackInterval(&batchTimer, batchIds[1], 1000.0);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    next = UA_Timer_process(&batchTimer, next, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, N_BATCHED + (N_BATCHED / 2) + (N_BATCHED / 2) - 1);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+static size_t batches;
+
+/* Execute the batch right away */
+static void
+batchExecutionCallback(void *executionApplication, UA_TimerBatch *batch) {
+    ck_assert_uint_le(batch->callbacksSize, UA_TIMER_BATCHSIZE);
+    batches++;
+    UA_Timer_executeBatch(&batchTimer, batch);
+}
+
+START_TEST(batchedDispatch) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+    batches = 0;
+
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, timerCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* The group is dispatched in full batches */
+    UA_DateTime now = UA_DateTime_nowMonotonic() + (10 * UA_DATETIME_MSEC);
+    UA_DateTime next = UA_Timer_process(&batchTimer, now, executionCallback,
+                                        batchExecutionCallback, NULL);
+    ck_assert_uint_eq(count, N_BATCHED);
+    ck_assert_uint_eq(batches, (N_BATCHED + UA_TIMER_BATCHSIZE - 1) / UA_TIMER_BATCHSIZE);
+
+    /* Timed callbacks are removed when they are dispatched */
+    for(size_t i = 0; i < N_BATCHED; i++)
+        UA_Timer_removeCallback(&batchTimer, batchIds[i]);
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addTimedCallback(&batchTimer, timerCallback, NULL, NULL, next, NULL);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    next = UA_Timer_process(&batchTimer, next, executionCallback,
+                            batchExecutionCallback, NULL);
+    ck_assert_uint_eq(count, 2 * N_BATCHED);
+    ck_assert_int_eq(next, UA_INT64_MAX);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+#define N_DEFERRED 4
+
+static UA_TimerBatch *deferred[N_DEFERRED];
+static size_t deferredSize;
+
+/* Keep the batch for a later execution (as by a worker) */
+static void
+deferBatchCallback(void *executionApplication, UA_TimerBatch *batch) {
+    ck_assert_uint_lt(deferredSize, N_DEFERRED);
+    deferred[deferredSize++] = batch;
+}
+
+START_TEST(removeBeforeBatchExecution) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+    deferredSize = 0;
+
+    for(size_t i = 0; i < 2 * UA_TIMER_BATCHSIZE; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, timerCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    UA_DateTime now = UA_DateTime_nowMonotonic() + (10 * UA_DATETIME_MSEC);
+    UA_Timer_process(&batchTimer, now, executionCallback, deferBatchCallback, NULL);
+    ck_assert_uint_eq(deferredSize, 2);
+    ck_assert_uint_eq(count, 0);
+
+    /* The removed entries are skipped when the batches are executed */
+    for(size_t i = 0; i < 2 * UA_TIMER_BATCHSIZE; i += 2)
+        UA_Timer_removeCallback(&batchTimer, batchIds[i]);
+    for(size_t i = 0; i < deferredSize; i++)
+        UA_Timer_executeBatch(&batchTimer, deferred[i]);
+    ck_assert_uint_eq(count, UA_TIMER_BATCHSIZE);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+START_TEST(mergeGroups) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+
+    /* The first group is rescheduled to the time of the second group */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        if(i == N_BATCHED / 2)
+            UA_fakeSleep(10);
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, timerCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    UA_DateTime next = UA_Timer_process(&batchTimer, now + (10 * UA_DATETIME_MSEC),
+                                        executionCallback, batchExecutionCallback, NULL);
+    ck_assert_uint_eq(count, N_BATCHED / 2);
+    ck_assert_int_eq(next, now + (20 * UA_DATETIME_MSEC));
+
+    /* Both groups are executed together */
+    next = UA_Timer_process(&batchTimer, next, executionCallback,
+                            batchExecutionCallback, NULL);
+    ck_assert_uint_eq(count, N_BATCHED + (N_BATCHED / 2));
+
+    /* Remove the entries of the first group */
+    for(size_t i = 0; i < N_BATCHED / 2; i++)
+        UA_Timer_removeCallback(&batchTimer, batchIds[i]);
+    next = UA_Timer_process(&batchTimer, next, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 2 * N_BATCHED);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+START_TEST(removeWithinCallback) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, removeAllCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* The first executed callback removes all entries */
+    UA_DateTime now = UA_DateTime_nowMonotonic() + (10 * UA_DATETIME_MSEC);
+    UA_DateTime next = UA_Timer_process(&batchTimer, now, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 1);
+    ck_assert_int_eq(next, UA_INT64_MAX);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+START_TEST(removeWithinBatch) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+
+    for(size_t i = 0; i < N_BATCHED; i++) {
+        UA_StatusCode retval =
+            UA_Timer_addRepeatedCallback(&batchTimer, removeAllCallback, NULL, NULL,
+                                         10.0, &batchIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* The later entries of the batch are skipped */
+    UA_DateTime now = UA_DateTime_nowMonotonic() + (10 * UA_DATETIME_MSEC);
+    UA_DateTime next = UA_Timer_process(&batchTimer, now, executionCallback,
+                                        batchExecutionCallback, NULL);
+    ck_assert_uint_eq(count, 1);
+    ck_assert_int_eq(next, UA_INT64_MAX);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
+START_TEST(timedCallbacks) {
+    UA_Timer_init(&batchTimer);
+    count = 0;
+
+    /* Timed callbacks can be far in the future */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    UA_DateTime later = now + (5 * UA_DATETIME_MSEC) + 1;
+    UA_DateTime muchLater = now + (UA_DateTime)(UA_DATETIME_SEC * 3600 * 24 * 1000);
+    UA_Timer_addTimedCallback(&batchTimer, timerCallback, NULL, NULL, muchLater, NULL);
+    UA_Timer_addTimedCallback(&batchTimer, timerCallback, NULL, NULL, later, NULL);
+
+    UA_DateTime next = UA_Timer_process(&batchTimer, later - 1, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 0);
+    ck_assert_int_eq(next, later);
+
+    next = UA_Timer_process(&batchTimer, later, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 1);
+    ck_assert_int_eq(next, muchLater);
+
+    next = UA_Timer_process(&batchTimer, muchLater, executionCallback, NULL, NULL);
+    ck_assert_uint_eq(count, 2);
+    ck_assert_int_eq(next, UA_INT64_MAX);
+
+    UA_Timer_deleteMembers(&batchTimer);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Event Timer");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, batchedCallbacks);
+    tcase_add_test(tc, batchedDispatch);
+    tcase_add_test(tc, removeBeforeBatchExecution);
+    tcase_add_test(tc, mergeGroups);
+    tcase_add_test(tc, removeWithinCallback);
+    tcase_add_test(tc, removeWithinBatch);
+    tcase_add_test(tc, timedCallbacks);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
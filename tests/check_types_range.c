@@ -88,6 +88,82 @@ START_TEST(copyIntoStringArrayRange) {
 }
 END_TEST
 
+START_TEST(setRangeOfSharedArray) {
+    UA_String arr[3];
+    arr[0] = UA_STRING("abcd");
+    arr[1] = UA_STRING("efgh");
+    arr[2] = UA_STRING("ijkl");
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, 3, &UA_TYPES[UA_TYPES_STRING]);
+
+    /* Copies of a shared variant reference the same data */
+    UA_Variant shared, copy;
+    UA_StatusCode retval = UA_Variant_copyShared(&v, &shared);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(shared.storageType, UA_VARIANT_DATA_SHARED);
+    retval = UA_Variant_copy(&shared, &copy);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copy.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(copy.data, shared.data);
+
+    /* Writing a range writes into a new shared copy. The other references
+     * keep the old data. */
+    UA_NumericRange r;
+    UA_String sr = UA_STRING("1");
+    retval = UA_NumericRange_parseFromString(&r, &sr);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String str = UA_STRING("mnop");
+    retval = UA_Variant_setRangeCopy(&copy, &str, 1, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copy.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_ne(copy.data, shared.data);
+    ck_assert(UA_String_equal(&((UA_String*)copy.data)[1], &str));
+    ck_assert(UA_String_equal(&((UA_String*)shared.data)[1], &arr[1]));
+
+    /* Copies of the written variant reference its new data */
+    UA_Variant copy2;
+    retval = UA_Variant_copy(&copy, &copy2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(copy2.data, copy.data);
+
+    UA_Variant_clear(&shared);
+    UA_Variant_clear(&copy);
+    UA_Variant_clear(&copy2);
+    UA_free(r.dimensions);
+}
+END_TEST
+
+START_TEST(shareArray) {
+    UA_String arr[2];
+    arr[0] = UA_STRING("abcd");
+    arr[1] = UA_STRING("efgh");
+    UA_Variant v;
+    UA_StatusCode retval =
+        UA_Variant_setArrayCopy(&v, arr, 2, &UA_TYPES[UA_TYPES_STRING]);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The members are moved into the shared storage */
+    UA_Byte *member = ((UA_String*)v.data)[1].data;
+    retval = UA_Variant_share(&v);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(v.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(((UA_String*)v.data)[1].data, member);
+
+    /* Borrowed data is copied */
+    UA_Variant borrowed;
+    UA_Variant_setArray(&borrowed, arr, 2, &UA_TYPES[UA_TYPES_STRING]);
+    borrowed.storageType = UA_VARIANT_DATA_NODELETE;
+    retval = UA_Variant_share(&borrowed);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(borrowed.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_ne(borrowed.data, arr);
+    ck_assert(UA_String_equal(&((UA_String*)borrowed.data)[0], &arr[0]));
+
+    UA_Variant_clear(&v);
+    UA_Variant_clear(&borrowed);
+}
+END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Variant Range Access");
     TCase *tc = tcase_create("test cases");
@@ -95,6 +171,8 @@ int main(void) {
     tcase_add_test(tc, parseRangeMinEqualMax);
     tcase_add_test(tc, copySimpleArrayRange);
     tcase_add_test(tc, copyIntoStringArrayRange);
+    tcase_add_test(tc, setRangeOfSharedArray);
+    tcase_add_test(tc, shareArray);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -169,6 +169,49 @@ START_TEST(Client_read) {
 }
 END_TEST
 
+#define BUFFERPOOL_READS 10
+
+START_TEST(Client_read_bufferPool) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefault(cc);
+    /* The server sends chunks of the receive buffer size of the client */
+    cc->localConnectionConfig.recvBufferSize = 8192;
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The first read fills the buffer pool */
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "my.variable");
+    UA_Variant val;
+    retval = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    /* The large value does not fit into a single chunk */
+    size_t chunks = (VARLENGTH * sizeof(UA_Int32)) /
+        cc->localConnectionConfig.recvBufferSize + 1;
+    ck_assert_uint_gt(chunks, 1);
+
+    UA_ServerStatistics before = UA_Server_getStatistics(server);
+    for(size_t i = 0; i < BUFFERPOOL_READS; i++) {
+        retval = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(val.arrayLength, VARLENGTH);
+        UA_Variant_clear(&val);
+    }
+    UA_ServerStatistics after = UA_Server_getStatistics(server);
+
+    /* The request and every chunk of the response use a buffer that is reused
+     * from the pool. No buffer is allocated. */
+    ck_assert_uint_eq(after.ns.bufferPoolMissCount, before.ns.bufferPoolMissCount);
+    ck_assert_uint_ge(after.ns.bufferPoolHitCount - before.ns.bufferPoolHitCount,
+                      BUFFERPOOL_READS * (chunks + 1));
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_renewSecureChannel) {
     UA_Client *client = UA_Client_new();
     UA_ClientConfig_setDefault(UA_Client_getConfig(client));
@@ -384,6 +427,7 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_endpoints);
     tcase_add_test(tc_client, Client_endpoints_empty);
     tcase_add_test(tc_client, Client_read);
+    tcase_add_test(tc_client, Client_read_bufferPool);
     suite_add_tcase(s,tc_client);
     TCase *tc_client_reconnect = tcase_create("Client Reconnect");
     tcase_add_checked_fixture(tc_client_reconnect, setup, teardown);
@@ -85,6 +85,15 @@ START_TEST(Client_connect_async) {
             break;
     } while(reqId < 10);
 
+    /* With worker threads, the browse requests are processed in a worker and
+     * answered in a later iteration */
+    for(size_t i = 0; i < 1000 && asyncCounter < 10-4 &&
+            retval == UA_STATUSCODE_GOOD; i++) {
+        UA_realSleep(1);
+        UA_Server_run_iterate(server, false);
+        retval = UA_Client_run_iterate(client, 0);
+    }
+
     UA_BrowseRequest_deleteMembers(&bReq);
     ck_assert_uint_eq(connected, true);
     ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
@@ -0,0 +1,247 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* The asymmetric cryptography of OpenSecureChannel and ActivateSession is
+ * processed by the crypto worker threads of the server. Several encrypted
+ * clients connect at the same time. The password of the UserNameIdentityToken
+ * is encrypted with a different SecurityPolicy than the SecureChannel. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "ua_server_internal.h"
+
+#include <stdlib.h>
+
+#include "certificates.h"
+#include "check.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_CLIENTS 8
+#define CONNECTS_PER_CLIENT 4
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+typedef struct {
+    const char *username;
+    const char *password;
+    UA_StatusCode expected;
+    THREAD_HANDLE handle;
+} ClientContext;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefaultWithSecurityPolicies(config, 4840, &certificate, &privateKey,
+                                                   NULL, 0, NULL, 0, NULL, 0);
+    UA_String_clear(&config->applicationDescription.applicationUri);
+    config->applicationDescription.applicationUri =
+        UA_STRING_ALLOC("urn:unconfigured:application");
+    config->nCryptoThreads = 2;
+
+    UA_Server_run_startup(server);
+    ck_assert_uint_eq(server->asyncManager.cryptoWorkersSize, 2);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* The main loop is run by the test itself */
+static void setupNoThread(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setMinimal(config, 4840, NULL);
+    config->nCryptoThreads = 1;
+    UA_Server_run_startup(server);
+    ck_assert_uint_eq(server->asyncManager.cryptoWorkersSize, 1);
+}
+
+static void teardownNoThread(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_Client *
+newEncryptedClient(void) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_Client *client = UA_Client_new();
+    ck_assert_ptr_ne(client, NULL);
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey, NULL, 0, NULL, 0);
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    return client;
+}
+
+static void
+connectAndRead(const ClientContext *ctx) {
+    UA_Client *client = newEncryptedClient();
+    UA_StatusCode res;
+    if(ctx->username)
+        res = UA_Client_connectUsername(client, "opc.tcp://localhost:4840",
+                                        ctx->username, ctx->password);
+    else
+        res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, ctx->expected);
+
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_Variant val;
+        UA_Variant_init(&val);
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+        res = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+THREAD_CALLBACK_PARAM(clientLoop, val) {
+    ClientContext *ctx = (ClientContext*)val;
+    for(size_t i = 0; i < CONNECTS_PER_CLIENT; i++)
+        connectAndRead(ctx);
+    return 0;
+}
+
+START_TEST(connectAnonymous) {
+    ClientContext ctx = {NULL, NULL, UA_STATUSCODE_GOOD, 0};
+    connectAndRead(&ctx);
+} END_TEST
+
+START_TEST(connectUsername) {
+    ClientContext ctx = {"user1", "password", UA_STATUSCODE_GOOD, 0};
+    connectAndRead(&ctx);
+} END_TEST
+
+START_TEST(connectWrongPassword) {
+    ClientContext ctx = {"user1", "wrong", UA_STATUSCODE_BADUSERACCESSDENIED, 0};
+    connectAndRead(&ctx);
+} END_TEST
+
+START_TEST(connectParallel) {
+    ClientContext ctx[NUMBER_OF_CLIENTS];
+    memset(ctx, 0, sizeof(ctx));
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++) {
+        if(i % 2 == 0) {
+            ctx[i].username = "user2";
+            ctx[i].password = "password1";
+        }
+        ctx[i].expected = UA_STATUSCODE_GOOD;
+        THREAD_CREATE_PARAM(ctx[i].handle, clientLoop, ctx[i]);
+    }
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_JOIN(ctx[i].handle);
+    ck_assert_uint_eq(server->asyncManager.cryptoJobsCount, 0);
+} END_TEST
+
+typedef struct {
+    UA_AsyncCryptoJob job;
+    UA_Double finished;
+    UA_Double completed;
+} SlowJob;
+
+static void
+runSlowJob(UA_Server *s, UA_AsyncCryptoJob *job) {
+    UA_realSleep(200);
+    ((SlowJob*)job)->finished = UA_realTime();
+}
+
+static void
+completeSlowJob(UA_Server *s, UA_AsyncCryptoJob *job) {
+    ((SlowJob*)job)->completed = UA_realTime();
+}
+
+/* The worker interrupts the waiting main loop when the job is returned. The
+ * main loop neither polls while the job is pending nor sleeps after it was
+ * returned. */
+START_TEST(wakeupOnReturnedJob) {
+    SlowJob sj;
+    memset(&sj, 0, sizeof(SlowJob));
+    sj.job.run = runSlowJob;
+    sj.job.complete = completeSlowJob;
+    UA_AsyncManager_enqueueCryptoJob(&server->asyncManager, server, &sj.job);
+
+    size_t iterations = 0;
+    while(sj.completed == 0) {
+        UA_Server_run_iterate(server, true);
+        iterations++;
+    }
+    ck_assert_uint_eq(server->asyncManager.cryptoJobsCount, 0);
+
+    /* At most 50ms per iteration while the job runs. Polling with 1ms takes
+     * about 200 iterations. */
+    ck_assert_uint_lt(iterations, 50);
+    ck_assert(sj.completed - sj.finished < 0.02);
+} END_TEST
+
+/* The crypto workers call the SecurityPolicies concurrently. They are not
+ * started if a SecurityPolicy is not thread-safe. */
+START_TEST(noWorkersForUnsafePolicy) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setMinimal(config, 4840, NULL);
+    ck_assert(config->securityPolicies[0].threadSafe);
+    config->securityPolicies[0].threadSafe = false;
+    config->nCryptoThreads = 2;
+    UA_Server_run_startup(server);
+    ck_assert_uint_eq(server->asyncManager.cryptoWorkersSize, 0);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+} END_TEST
+
+static Suite* testSuite_encryption_async_handshake(void) {
+    Suite *s = suite_create("Encryption");
+    TCase *tc = tcase_create("Handshakes in the crypto workers");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, connectAnonymous);
+    tcase_add_test(tc, connectUsername);
+    tcase_add_test(tc, connectWrongPassword);
+    tcase_add_test(tc, connectParallel);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+
+    TCase *tc_wakeup = tcase_create("Wake up the main loop");
+    tcase_add_checked_fixture(tc_wakeup, setupNoThread, teardownNoThread);
+    tcase_add_test(tc_wakeup, wakeupOnReturnedJob);
+    suite_add_tcase(s, tc_wakeup);
+
+    TCase *tc_unsafe = tcase_create("Thread-safety of the SecurityPolicies");
+    tcase_add_test(tc_unsafe, noWorkersForUnsafePolicy);
+    suite_add_tcase(s, tc_unsafe);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_async_handshake();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
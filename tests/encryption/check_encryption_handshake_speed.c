@@ -0,0 +1,301 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Asymmetric operations per OpenSecureChannel handshake on the server side.
+ * For every handshake a channel context is created for the client certificate.
+ * The request is decrypted and its signature verified. Then the response is
+ * signed and encrypted. The client uses the same certificate as the server. The
+ * 4096 bit keys are generated at startup. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy_default.h>
+
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "certificates.h"
+#include "check.h"
+
+#define HANDSHAKES 100
+#define MESSAGE_BLOCKS 3 /* An OPN with the sender certificate */
+
+typedef UA_StatusCode
+(*PolicyConstructor)(UA_SecurityPolicy *policy, const UA_ByteString localCertificate,
+                     const UA_ByteString localPrivateKey, const UA_Logger *logger);
+
+static UA_ByteString certificate2048 = {CERT_DER_LENGTH, CERT_DER_DATA};
+static UA_ByteString privateKey2048 = {KEY_DER_LENGTH, KEY_DER_DATA};
+static UA_ByteString certificate4096;
+static UA_ByteString privateKey4096;
+static UA_Logger logger; /* Don't log every created channel context */
+
+static void
+toByteString(unsigned char *der, int length, UA_ByteString *out) {
+    ck_assert_int_gt(length, 0);
+    UA_StatusCode res = UA_ByteString_allocBuffer(out, (size_t)length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memcpy(out->data, der, (size_t)length);
+    OPENSSL_free(der);
+}
+
+/* Generate a self-signed certificate with a fresh RSA key */
+static void
+generateKeyPair(int bits, UA_ByteString *cert, UA_ByteString *key) {
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    ck_assert_ptr_ne(ctx, NULL);
+    ck_assert_int_eq(EVP_PKEY_keygen_init(ctx), 1);
+    ck_assert_int_eq(EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, bits), 1);
+    ck_assert_int_eq(EVP_PKEY_keygen(ctx, &pkey), 1);
+    EVP_PKEY_CTX_free(ctx);
+
+    X509 *x509 = X509_new();
+    ck_assert_ptr_ne(x509, NULL);
+    X509_set_version(x509, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+    X509_gmtime_adj(X509_get_notBefore(x509), 0);
+    X509_gmtime_adj(X509_get_notAfter(x509), 3600);
+    X509_set_pubkey(x509, pkey);
+    X509_NAME *name = X509_get_subject_name(x509);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               (const unsigned char*)"open62541", -1, -1, 0);
+    X509_set_issuer_name(x509, name);
+    ck_assert_int_gt(X509_sign(x509, pkey, EVP_sha256()), 0);
+
+    unsigned char *der = NULL;
+    int length = i2d_X509(x509, &der);
+    toByteString(der, length, cert);
+    der = NULL;
+    length = i2d_PrivateKey(pkey, &der);
+    toByteString(der, length, key);
+
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+}
+
+static void setup(void) {
+    logger = UA_Log_Stdout_withLevel(UA_LOGLEVEL_WARNING);
+    generateKeyPair(4096, &certificate4096, &privateKey4096);
+}
+
+static void teardown(void) {
+    UA_ByteString_clear(&certificate4096);
+    UA_ByteString_clear(&privateKey4096);
+}
+
+/* Sign the message in the front of the buffer and encrypt everything */
+static void
+signAndEncrypt(const UA_SecurityPolicy *policy, void *cc,
+               UA_ByteString *buf, size_t plainLength) {
+    const UA_SecurityPolicyCryptoModule *cm = &policy->asymmetricModule.cryptoModule;
+    size_t sigSize = cm->signatureAlgorithm.getLocalSignatureSize(policy, cc);
+    UA_ByteString message = {plainLength - sigSize, buf->data};
+    UA_ByteString signature = {sigSize, &buf->data[plainLength - sigSize]};
+    UA_StatusCode res = cm->signatureAlgorithm.sign(policy, cc, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    buf->length = plainLength;
+    res = cm->encryptionAlgorithm.encrypt(policy, cc, buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+decryptAndVerify(const UA_SecurityPolicy *policy, void *cc, UA_ByteString *buf) {
+    const UA_SecurityPolicyCryptoModule *cm = &policy->asymmetricModule.cryptoModule;
+    UA_StatusCode res = cm->encryptionAlgorithm.decrypt(policy, cc, buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    size_t sigSize = cm->signatureAlgorithm.getRemoteSignatureSize(policy, cc);
+    ck_assert_uint_gt(buf->length, sigSize);
+    UA_ByteString message = {buf->length - sigSize, buf->data};
+    UA_ByteString signature = {sigSize, &buf->data[buf->length - sigSize]};
+    res = cm->signatureAlgorithm.verify(policy, cc, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+measureHandshakes(PolicyConstructor constructor, const UA_ByteString *certificate,
+                  const UA_ByteString *privateKey) {
+    UA_SecurityPolicy policy;
+    memset(&policy, 0, sizeof(UA_SecurityPolicy));
+    UA_StatusCode res = constructor(&policy, *certificate, *privateKey, &logger);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Prepare the request. The plaintext fills MESSAGE_BLOCKS blocks. */
+    void *cc = NULL;
+    res = policy.channelModule.newContext(&policy, certificate, &cc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_SecurityPolicyEncryptionAlgorithm *ea =
+        &policy.asymmetricModule.cryptoModule.encryptionAlgorithm;
+    size_t plainLength = ea->getRemotePlainTextBlockSize(&policy, cc) * MESSAGE_BLOCKS;
+    size_t bufLength = ea->getRemoteBlockSize(&policy, cc) * MESSAGE_BLOCKS;
+    size_t keyBits = ea->getLocalKeyLength(&policy, cc);
+    UA_ByteString request, buf;
+    res = UA_ByteString_allocBuffer(&request, bufLength);
+    res |= UA_ByteString_allocBuffer(&buf, bufLength);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < bufLength; i++)
+        request.data[i] = (UA_Byte)i;
+    signAndEncrypt(&policy, cc, &request, plainLength);
+    ck_assert_uint_eq(request.length, bufLength);
+    policy.channelModule.deleteContext(cc);
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < HANDSHAKES; i++) {
+        res = policy.channelModule.newContext(&policy, certificate, &cc);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = policy.channelModule.compareCertificate(cc, certificate);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        memcpy(buf.data, request.data, bufLength);
+        buf.length = bufLength;
+        decryptAndVerify(&policy, cc, &buf);
+        ck_assert_uint_eq(buf.length, plainLength);
+
+        buf.length = bufLength;
+        signAndEncrypt(&policy, cc, &buf, plainLength);
+
+        policy.channelModule.deleteContext(cc);
+    }
+    double duration = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+    printf("%.*s (%u bit): %.1f handshakes/s\n",
+           (int)policy.policyUri.length, (char*)policy.policyUri.data,
+           (unsigned)keyBits, HANDSHAKES / duration);
+
+    UA_ByteString_clear(&request);
+    UA_ByteString_clear(&buf);
+    policy.clear(&policy);
+}
+
+START_TEST(handshakes_basic128rsa15_2048) {
+    measureHandshakes(UA_SecurityPolicy_Basic128Rsa15, &certificate2048, &privateKey2048);
+} END_TEST
+
+START_TEST(handshakes_basic256_2048) {
+    measureHandshakes(UA_SecurityPolicy_Basic256, &certificate2048, &privateKey2048);
+} END_TEST
+
+START_TEST(handshakes_basic256sha256_2048) {
+    measureHandshakes(UA_SecurityPolicy_Basic256Sha256, &certificate2048, &privateKey2048);
+} END_TEST
+
+START_TEST(handshakes_basic256sha256_4096) {
+    measureHandshakes(UA_SecurityPolicy_Basic256Sha256, &certificate4096, &privateKey4096);
+} END_TEST
+
+START_TEST(handshakes_aes128sha256rsaoaep_2048) {
+    measureHandshakes(UA_SecurityPolicy_Aes128Sha256RsaOaep, &certificate2048, &privateKey2048);
+} END_TEST
+
+START_TEST(handshakes_aes128sha256rsaoaep_4096) {
+    measureHandshakes(UA_SecurityPolicy_Aes128Sha256RsaOaep, &certificate4096, &privateKey4096);
+} END_TEST
+
+/* The thumbprint of a certificate chain is the digest of the first
+ * certificate */
+START_TEST(thumbprintOfChain) {
+    UA_SecurityPolicy policy;
+    memset(&policy, 0, sizeof(UA_SecurityPolicy));
+    UA_StatusCode res = UA_SecurityPolicy_Basic256Sha256(&policy, certificate2048,
+                                                         privateKey2048, &logger);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_ByteString chain;
+    res = UA_ByteString_allocBuffer(&chain, certificate2048.length + certificate4096.length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memcpy(chain.data, certificate2048.data, certificate2048.length);
+    memcpy(&chain.data[certificate2048.length], certificate4096.data,
+           certificate4096.length);
+
+    UA_Byte tp[SHA_DIGEST_LENGTH];
+    UA_ByteString thumbprint = {SHA_DIGEST_LENGTH, tp};
+    res = policy.asymmetricModule.makeCertificateThumbprint(&policy, &chain, &thumbprint);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    const unsigned char *p = certificate2048.data;
+    X509 *x509 = d2i_X509(NULL, &p, (long)certificate2048.length);
+    ck_assert_ptr_ne(x509, NULL);
+    unsigned char expected[SHA_DIGEST_LENGTH];
+    unsigned int expectedLength = 0;
+    ck_assert_int_eq(X509_digest(x509, EVP_sha1(), expected, &expectedLength), 1);
+    ck_assert_uint_eq(expectedLength, SHA_DIGEST_LENGTH);
+    ck_assert_int_eq(memcmp(tp, expected, SHA_DIGEST_LENGTH), 0);
+    X509_free(x509);
+
+    UA_ByteString_clear(&chain);
+    policy.clear(&policy);
+} END_TEST
+
+/* Only the first certificate of a chain is compared with the remote
+ * certificate of the channel */
+START_TEST(compareCertificateOfChain) {
+    UA_SecurityPolicy policy;
+    memset(&policy, 0, sizeof(UA_SecurityPolicy));
+    UA_StatusCode res = UA_SecurityPolicy_Basic256Sha256(&policy, certificate2048,
+                                                         privateKey2048, &logger);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_ByteString chain;
+    res = UA_ByteString_allocBuffer(&chain, certificate2048.length + certificate4096.length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memcpy(chain.data, certificate2048.data, certificate2048.length);
+    memcpy(&chain.data[certificate2048.length], certificate4096.data,
+           certificate4096.length);
+
+    /* Channel with a single certificate */
+    void *cc = NULL;
+    res = policy.channelModule.newContext(&policy, &certificate2048, &cc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.compareCertificate(cc, &certificate2048);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.compareCertificate(cc, &chain);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.compareCertificate(cc, &certificate4096);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    policy.channelModule.deleteContext(cc);
+
+    /* Channel with a chain of certificates */
+    res = policy.channelModule.newContext(&policy, &chain, &cc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.compareCertificate(cc, &certificate2048);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.compareCertificate(cc, &chain);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    policy.channelModule.deleteContext(cc);
+
+    UA_ByteString_clear(&chain);
+    policy.clear(&policy);
+} END_TEST
+
+static Suite *testSuite_encryption_handshake_speed(void) {
+    Suite *s = suite_create("Encryption Handshake Speed");
+    TCase *tc = tcase_create("Asymmetric handshakes");
+    tcase_add_unchecked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, handshakes_basic128rsa15_2048);
+    tcase_add_test(tc, handshakes_basic256_2048);
+    tcase_add_test(tc, handshakes_basic256sha256_2048);
+    tcase_add_test(tc, handshakes_basic256sha256_4096);
+    tcase_add_test(tc, handshakes_aes128sha256rsaoaep_2048);
+    tcase_add_test(tc, handshakes_aes128sha256rsaoaep_4096);
+    tcase_add_test(tc, thumbprintOfChain);
+    tcase_add_test(tc, compareCertificateOfChain);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_handshake_speed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,155 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Throughput of the symmetric operations of the SecurityPolicies for a
+ * single core. A chunk is signed and encrypted with the local keys and then
+ * decrypted and verified with the remote keys. Both use the same key material
+ * so the original chunk is restored. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy_default.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "certificates.h"
+#include "check.h"
+
+#define CHUNK_SIZE 65536
+#define CHUNKS 1024
+
+typedef UA_StatusCode
+(*PolicyConstructor)(UA_SecurityPolicy *policy, const UA_ByteString localCertificate,
+                     const UA_ByteString localPrivateKey, const UA_Logger *logger);
+
+static void
+setRandomKey(UA_ByteString *key, size_t length) {
+    UA_StatusCode res = UA_ByteString_allocBuffer(key, length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < length; i++)
+        key->data[i] = (UA_Byte)UA_UInt32_random();
+}
+
+static void
+measurePolicy(PolicyConstructor constructor) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+
+    UA_SecurityPolicy policy;
+    memset(&policy, 0, sizeof(UA_SecurityPolicy));
+    UA_StatusCode res = constructor(&policy, certificate, privateKey,
+                                    UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    void *cc = NULL;
+    res = policy.channelModule.newContext(&policy, &certificate, &cc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The same keys in both directions */
+    const UA_SecurityPolicyCryptoModule *cm = &policy.symmetricModule.cryptoModule;
+    UA_ByteString signingKey, encryptingKey, iv;
+    setRandomKey(&signingKey, cm->signatureAlgorithm.getLocalKeyLength(&policy, cc));
+    setRandomKey(&encryptingKey, cm->encryptionAlgorithm.getLocalKeyLength(&policy, cc));
+    setRandomKey(&iv, cm->encryptionAlgorithm.getLocalBlockSize(&policy, cc));
+    res = policy.channelModule.setLocalSymSigningKey(cc, &signingKey);
+    res |= policy.channelModule.setLocalSymEncryptingKey(cc, &encryptingKey);
+    res |= policy.channelModule.setLocalSymIv(cc, &iv);
+    res |= policy.channelModule.setRemoteSymSigningKey(cc, &signingKey);
+    res |= policy.channelModule.setRemoteSymEncryptingKey(cc, &encryptingKey);
+    res |= policy.channelModule.setRemoteSymIv(cc, &iv);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The signature is appended to the message. Then the entire chunk is
+     * encrypted. Every round starts from a fresh copy of the input (the
+     * plaintext or the ciphertext). */
+    size_t sigSize = cm->signatureAlgorithm.getLocalSignatureSize(&policy, cc);
+    UA_ByteString plain, cipher, chunk;
+    res = UA_ByteString_allocBuffer(&plain, CHUNK_SIZE);
+    res |= UA_ByteString_allocBuffer(&cipher, CHUNK_SIZE);
+    res |= UA_ByteString_allocBuffer(&chunk, CHUNK_SIZE);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < CHUNK_SIZE; i++)
+        plain.data[i] = (UA_Byte)i;
+    UA_ByteString message = {CHUNK_SIZE - sigSize, chunk.data};
+    UA_ByteString signature = {sigSize, &chunk.data[CHUNK_SIZE - sigSize]};
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < CHUNKS; i++) {
+        memcpy(chunk.data, plain.data, CHUNK_SIZE);
+        res = cm->signatureAlgorithm.sign(&policy, cc, &message, &signature);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        chunk.length = CHUNK_SIZE;
+        res = cm->encryptionAlgorithm.encrypt(&policy, cc, &chunk);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    double encTime = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    memcpy(cipher.data, chunk.data, CHUNK_SIZE);
+
+    begin = clock();
+    for(size_t i = 0; i < CHUNKS; i++) {
+        memcpy(chunk.data, cipher.data, CHUNK_SIZE);
+        chunk.length = CHUNK_SIZE;
+        res = cm->encryptionAlgorithm.decrypt(&policy, cc, &chunk);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = cm->signatureAlgorithm.verify(&policy, cc, &message, &signature);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    double decTime = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+    /* The content is restored */
+    ck_assert(memcmp(chunk.data, plain.data, CHUNK_SIZE - sigSize) == 0);
+
+    double mb = (double)CHUNK_SIZE * CHUNKS / (1024.0 * 1024.0);
+    printf("%.*s: sign+encrypt %.1f MB/s, decrypt+verify %.1f MB/s\n",
+           (int)policy.policyUri.length, (char*)policy.policyUri.data,
+           mb / encTime, mb / decTime);
+
+    UA_ByteString_clear(&plain);
+    UA_ByteString_clear(&cipher);
+    UA_ByteString_clear(&chunk);
+    UA_ByteString_clear(&signingKey);
+    UA_ByteString_clear(&encryptingKey);
+    UA_ByteString_clear(&iv);
+    policy.channelModule.deleteContext(cc);
+    policy.clear(&policy);
+}
+
+START_TEST(throughput_basic128rsa15) {
+    measurePolicy(UA_SecurityPolicy_Basic128Rsa15);
+} END_TEST
+
+START_TEST(throughput_basic256) {
+    measurePolicy(UA_SecurityPolicy_Basic256);
+} END_TEST
+
+START_TEST(throughput_basic256sha256) {
+    measurePolicy(UA_SecurityPolicy_Basic256Sha256);
+} END_TEST
+
+START_TEST(throughput_aes128sha256rsaoaep) {
+    measurePolicy(UA_SecurityPolicy_Aes128Sha256RsaOaep);
+} END_TEST
+
+static Suite *testSuite_encryption_speed(void) {
+    Suite *s = suite_create("Encryption Speed");
+    TCase *tc = tcase_create("Symmetric throughput");
+    tcase_add_test(tc, throughput_basic128rsa15);
+    tcase_add_test(tc, throughput_basic256);
+    tcase_add_test(tc, throughput_basic256sha256);
+    tcase_add_test(tc, throughput_aes128sha256rsaoaep);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_speed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* The read-only services (Read, Browse, TranslateBrowsePaths) of the client
+ * sessions are processed in the worker threads. This benchmark drives N
+ * clients against a server with N workers. The value is read from a
+ * DataSource that takes a millisecond. So the throughput grows with N as long
+ * as the requests of the sessions are processed concurrently.
+ *
+ * The throughput depends on the machine and is only printed. The test fails
+ * if the DataSource is never entered by more than one worker at a time. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include "thread_wrapper.h"
+#include "testing_clock.h"
+#include "mt_testing.h"
+
+#define MAX_NUMBER_OF_CLIENTS 4
+#define ITERATIONS_PER_CLIENT 200
+
+UA_NodeId slowNodeId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+static volatile UA_UInt32 inside;
+static volatile UA_UInt32 maxInside;
+
+static UA_StatusCode
+readSlow(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+         const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+         const UA_NumericRange *range, UA_DataValue *value) {
+    UA_UInt32 now = UA_atomic_addUInt32(&inside, 1);
+    UA_UInt32 max = maxInside;
+    while(now > max && UA_atomic_cmpxchgUInt32(&maxInside, max, now) != max)
+        max = maxInside;
+    UA_sleep_ms(1);
+    UA_atomic_subUInt32(&inside, 1);
+    UA_Int32 v = 42;
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &v, &UA_TYPES[UA_TYPES_INT32]);
+}
+
+static
+void addSlowNode(void) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US","Slow");
+    UA_DataSource ds;
+    ds.read = readSlow;
+    ds.write = NULL;
+    UA_StatusCode res =
+        UA_Server_addDataSourceVariableNode(tc.server, slowNodeId,
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "Slow"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                            attr, ds, NULL, NULL);
+    ck_assert_int_eq(UA_STATUSCODE_GOOD, res);
+}
+
+static void
+startServer(size_t workers) {
+    tc.running = true;
+    tc.server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    UA_ServerConfig_setDefault(config);
+    config->nThreads = (UA_UInt16)workers;
+    addSlowNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static
+void client_read(void *value) {
+    ThreadContext tmp = (*(ThreadContext *) value);
+    UA_Variant val;
+    UA_StatusCode retval = UA_Client_readValueAttribute(tc.clients[tmp.index], slowNodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(42, *(UA_Int32 *)val.data);
+    UA_Variant_clear(&val);
+}
+
+static void
+runClients(size_t clients) {
+    startServer(clients);
+    initThreadContext(0, clients, NULL);
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        setThreadContext(&tc.clientContext[i], i, ITERATIONS_PER_CLIENT, client_read);
+
+    maxInside = 0;
+    double begin = UA_realTime();
+    startMultithreading();
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        THREAD_JOIN(tc.clientContext[i].handle);
+    double duration = UA_realTime() - begin;
+
+    size_t ops = clients * ITERATIONS_PER_CLIENT;
+    printf("%lu client(s), %lu worker(s): %lu reads in %.3f s (%.0f reads/s), "
+           "at most %lu concurrent\n", (unsigned long)clients, (unsigned long)clients,
+           (unsigned long)ops, duration, (double)ops / duration,
+           (unsigned long)maxInside);
+
+    /* The client threads are joined already */
+    tc.numberofClients = 0;
+    teardown();
+    UA_free(tc.workerContext);
+    UA_free(tc.clientContext);
+    UA_free(tc.clients);
+}
+
+START_TEST(readScalingClients) {
+    for(size_t clients = 1; clients <= MAX_NUMBER_OF_CLIENTS; clients *= 2) {
+        runClients(clients);
+        if(clients > 1)
+            ck_assert_uint_ge(maxInside, 2);
+    }
+} END_TEST
+
+static Suite* testSuite_readScaling(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_read = tcase_create("Read scaling");
+    tcase_set_timeout(tc_read, 60);
+    tcase_add_test(tc_read, readScalingClients);
+    suite_add_tcase(s, tc_read);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_readScaling();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,149 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Readers get and release nodes from the HashMap nodestore without a lock.
+ * Concurrently, a single writer replaces the nodes and inserts/removes
+ * additional nodes so that the table is resized. The readers check that they
+ * always see a consistent node. */
+
+#include <open62541/types.h>
+#include <open62541/util.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include "thread_wrapper.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#define NUMBER_OF_READERS 8
+#define NUMBER_OF_NODES 64
+#define WRITER_ROUNDS 200
+#define RESIZE_NODES 512
+
+static UA_Nodestore ns;
+static volatile UA_Boolean running;
+
+typedef struct {
+    UA_UInt32 seed;
+    size_t reads;
+    THREAD_HANDLE handle;
+} ReaderContext;
+
+static UA_Node *
+createNode(UA_UInt32 id) {
+    UA_Node *node = ns.newNode(ns.context, UA_NODECLASS_VARIABLE);
+    node->head.nodeId = UA_NODEID_NUMERIC(1, id);
+    /* An allocated member. Reading it after the node was freed is found by the
+     * address sanitizer. */
+    node->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "Node");
+    return node;
+}
+
+static void setup(void) {
+    UA_Nodestore_HashMap(&ns);
+    for(UA_UInt32 i = 1; i <= NUMBER_OF_NODES; i++) {
+        UA_StatusCode res = ns.insertNode(ns.context, createNode(i), NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+}
+
+static void teardown(void) {
+    ns.clear(ns.context);
+}
+
+THREAD_CALLBACK_PARAM(readerLoop, val) {
+    ReaderContext *rc = (ReaderContext*)val;
+    while(running) {
+        rc->seed = rc->seed * 1103515245 + 12345;
+        UA_NodeId id = UA_NODEID_NUMERIC(1, 1 + (rc->seed % NUMBER_OF_NODES));
+        const UA_Node *node = ns.getNode(ns.context, &id);
+        ck_assert_ptr_ne(node, NULL);
+        ck_assert(UA_NodeId_equal(&node->head.nodeId, &id));
+        ck_assert_uint_eq(node->head.browseName.name.length, 4);
+        ck_assert_uint_eq(node->head.browseName.name.data[0], 'N');
+        ck_assert_uint_le(node->head.writeMask, WRITER_ROUNDS);
+        ns.releaseNode(ns.context, node);
+        rc->reads++;
+    }
+    return 0;
+}
+
+static void
+replaceAll(UA_UInt32 round) {
+    for(UA_UInt32 i = 1; i <= NUMBER_OF_NODES; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        UA_Node *copy = NULL;
+        UA_StatusCode res = ns.getNodeCopy(ns.context, &id, &copy);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        copy->head.writeMask = round;
+        res = ns.replaceNode(ns.context, copy);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+}
+
+START_TEST(readDuringReplace) {
+    ReaderContext rc[NUMBER_OF_READERS];
+    memset(rc, 0, sizeof(rc));
+    running = true;
+    for(size_t i = 0; i < NUMBER_OF_READERS; i++) {
+        rc[i].seed = (UA_UInt32)i + 1;
+        THREAD_CREATE_PARAM(rc[i].handle, readerLoop, rc[i]);
+    }
+
+    for(UA_UInt32 round = 1; round <= WRITER_ROUNDS; round++) {
+        replaceAll(round);
+
+        /* Grow and shrink the table every few rounds */
+        if(round % 20 != 0)
+            continue;
+        for(UA_UInt32 i = 0; i < RESIZE_NODES; i++) {
+            UA_StatusCode res =
+                ns.insertNode(ns.context, createNode(100000 + i), NULL);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+        replaceAll(round);
+        for(UA_UInt32 i = 0; i < RESIZE_NODES; i++) {
+            UA_NodeId id = UA_NODEID_NUMERIC(1, 100000 + i);
+            UA_StatusCode res = ns.removeNode(ns.context, &id);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+    }
+
+    running = false;
+    size_t reads = 0;
+    for(size_t i = 0; i < NUMBER_OF_READERS; i++) {
+        THREAD_JOIN(rc[i].handle);
+        reads += rc[i].reads;
+    }
+    ck_assert_uint_gt(reads, 0);
+
+    /* All nodes have the latest version */
+    for(UA_UInt32 i = 1; i <= NUMBER_OF_NODES; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        const UA_Node *node = ns.getNode(ns.context, &id);
+        ck_assert_ptr_ne(node, NULL);
+        ck_assert_uint_eq(node->head.writeMask, WRITER_ROUNDS);
+        ns.releaseNode(ns.context, node);
+    }
+} END_TEST
+
+static Suite* testSuite_nodestoreReplace(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc = tcase_create("Nodestore read during replace");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, readDuringReplace);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_nodestoreReplace();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
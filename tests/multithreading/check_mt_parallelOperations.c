@@ -0,0 +1,594 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Large Read and Browse requests are split into slices that are processed in
+ * parallel by the worker threads. The results must keep their position in the
+ * response. The DataSource callbacks of nodes that are not marked thread-safe
+ * must not be called concurrently. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_services.h"
+#include "ua_server_internal.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUMBER_OF_WORKERS 4
+#define SLICE_SIZE 256
+#define VARIABLES 200
+#define READS 20000
+
+static UA_Server *server;
+
+/* Concurrency of the DataSource callbacks */
+static volatile UA_UInt32 inside[2];
+static volatile UA_UInt32 maxInside[2];
+
+static UA_StatusCode
+readIndex(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+          const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+          const UA_NumericRange *range, UA_DataValue *value) {
+    UA_UInt32 index = (UA_UInt32)(uintptr_t)nodeContext;
+    size_t threadSafe = index % 2;
+    UA_UInt32 now = UA_atomic_addUInt32(&inside[threadSafe], 1);
+    UA_UInt32 max = maxInside[threadSafe];
+    while(now > max) {
+        UA_UInt32 old = UA_atomic_cmpxchgUInt32(&maxInside[threadSafe], max, now);
+        if(old == max)
+            break;
+        max = old;
+    }
+
+    /* Take some time to make overlapping calls likely */
+    volatile UA_UInt32 spin = 0;
+    for(size_t i = 0; i < 2000; i++)
+        spin++;
+
+    UA_atomic_subUInt32(&inside[threadSafe], 1);
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &index, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+/* Update the value before it is read. As in the value callback tutorial. */
+static void
+beforeRead(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+           const UA_NodeId *nodeId, void *nodeContext,
+           const UA_NumericRange *range, const UA_DataValue *data) {
+    UA_UInt32 counter = 0;
+    if(data->hasValue && UA_Variant_hasScalarType(&data->value, &UA_TYPES[UA_TYPES_UINT32]))
+        counter = *(UA_UInt32*)data->value.data;
+    counter++;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &counter, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Server_writeValue(s, *nodeId, v);
+}
+
+/* Read a node that is not thread-safe from within a read callback. The
+ * serialization of the value callbacks is re-entered. */
+static void
+readOtherNode(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+              const UA_NodeId *nodeId, void *nodeContext,
+              const UA_NumericRange *range, const UA_DataValue *data) {
+    UA_Variant v;
+    UA_StatusCode res = UA_Server_readValue(s, UA_NODEID_NUMERIC(1, 10000), &v);
+    if(res == UA_STATUSCODE_GOOD)
+        UA_Variant_clear(&v);
+}
+
+/* An external value backend */
+static UA_DataValue externalValue;
+static UA_DataValue *externalValuePtr = &externalValue;
+
+static UA_StatusCode
+notifyExternalRead(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+                   const UA_NodeId *nodeId, void *nodeContext,
+                   const UA_NumericRange *range) {
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Releases the service lock around the call like every value callback */
+static void
+observeRead(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_NodeId *nodeId, void *nodeContext,
+            const UA_NumericRange *range, const UA_DataValue *data) {
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->nThreads = NUMBER_OF_WORKERS;
+    config->operationSliceSize = SLICE_SIZE;
+
+    /* Every second variable is thread-safe */
+    UA_DataSource ds;
+    ds.read = readIndex;
+    ds.write = NULL;
+    for(UA_UInt32 i = 0; i < VARIABLES; i++) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+        UA_StatusCode res = UA_Server_addDataSourceVariableNode(
+            server, UA_NODEID_NUMERIC(1, 10000 + i),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "Index"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, ds,
+            (void*)(uintptr_t)i, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        if(i % 2 == 1) {
+            res = UA_Server_setVariableNodeThreadSafe(server, UA_NODEID_NUMERIC(1, 10000 + i),
+                                                      true);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+    }
+
+    /* A variable that is written concurrently */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_UInt32 zero = 0;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_StatusCode res = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(1, 20000), UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "Counter"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A variable that is written from its read callback */
+    res = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(1, 30000), UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "ReadCounter"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ValueCallback callback;
+    callback.onRead = beforeRead;
+    callback.onWrite = NULL;
+    res = UA_Server_setVariableNode_valueCallback(server, UA_NODEID_NUMERIC(1, 30000),
+                                                  callback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A variable with a read callback that is written concurrently */
+    res = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(1, 40000), UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "ObservedCounter"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    callback.onRead = observeRead;
+    res = UA_Server_setVariableNode_valueCallback(server, UA_NODEID_NUMERIC(1, 40000),
+                                                  callback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A variable that reads another variable in its read callback */
+    res = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(1, 50000), UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "ReadOther"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    callback.onRead = readOtherNode;
+    res = UA_Server_setVariableNode_valueCallback(server, UA_NODEID_NUMERIC(1, 50000),
+                                                  callback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A variable with an external value */
+    res = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(1, 60000), UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(1, "External"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_DataValue_init(&externalValue);
+    UA_Variant_setScalar(&externalValue.value, &zero, &UA_TYPES[UA_TYPES_UINT32]);
+    externalValue.hasValue = true;
+    UA_ValueBackend backend;
+    memset(&backend, 0, sizeof(UA_ValueBackend));
+    backend.backendType = UA_VALUEBACKENDTYPE_EXTERNAL;
+    backend.backend.external.value = &externalValuePtr;
+    backend.backend.external.callback.notificationRead = notifyExternalRead;
+    res = UA_Server_setVariableNode_valueBackend(server, UA_NODEID_NUMERIC(1, 60000),
+                                                 backend);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Spins up the workers. The server main loop is not run. So the test
+     * thread calls the services like the main loop. */
+    UA_Server_run_startup(server);
+    ck_assert_uint_eq(server->workQueue.workersSize, NUMBER_OF_WORKERS);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static double
+timedRead(const UA_ReadRequest *request, UA_ReadResponse *response) {
+    double begin = UA_realTime();
+    UA_RDLOCK(server->serviceMutex);
+    Service_Read(server, &server->adminSession, request, response);
+    UA_RDUNLOCK(server->serviceMutex);
+    return UA_realTime() - begin;
+}
+
+START_TEST(readInSlices) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(READS, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < READS; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 10000 + (UA_UInt32)(i % VARIABLES));
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = READS;
+    request.nodesToRead = rvi;
+
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    double parallel = timedRead(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, READS);
+    for(size_t i = 0; i < READS; i++) {
+        ck_assert(response.results[i].hasValue);
+        ck_assert_ptr_eq(response.results[i].value.type, &UA_TYPES[UA_TYPES_UINT32]);
+        ck_assert_uint_eq(*(UA_UInt32*)response.results[i].value.data, i % VARIABLES);
+    }
+    UA_ReadResponse_clear(&response);
+
+    /* The callbacks of the nodes that are not thread-safe never overlap */
+    ck_assert_uint_eq(maxInside[0], 1);
+
+    /* Compare with the sequential processing */
+    UA_Server_getConfig(server)->operationSliceSize = 0;
+    double sequential = timedRead(&request, &response);
+    ck_assert_uint_eq(response.resultsSize, READS);
+    UA_ReadResponse_clear(&response);
+
+    printf("%u reads: sequential %f s, in slices of %u with %u workers %f s\n",
+           READS, sequential, SLICE_SIZE, NUMBER_OF_WORKERS, parallel);
+    printf("concurrent DataSource calls: %u (thread-safe nodes), %u (other nodes)\n",
+           maxInside[1], maxInside[0]);
+
+    UA_Array_delete(rvi, READS, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+START_TEST(browseInSlices) {
+    /* Browse the variables and the objects folder alternately */
+    UA_BrowseDescription *bd = (UA_BrowseDescription*)
+        UA_Array_new(SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+    ck_assert_ptr_ne(bd, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        if(i % 2 == 0)
+            bd[i].nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        else
+            bd[i].nodeId = UA_NODEID_NUMERIC(1, 10000 + (UA_UInt32)(i % VARIABLES));
+        bd[i].browseDirection = UA_BROWSEDIRECTION_INVERSE;
+        bd[i].resultMask = UA_BROWSERESULTMASK_ALL;
+    }
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.nodesToBrowseSize = SLICE_SIZE * 8;
+    request.nodesToBrowse = bd;
+
+    UA_BrowseResponse response;
+    UA_BrowseResponse_init(&response);
+    UA_RDLOCK(server->serviceMutex);
+    Service_Browse(server, &server->adminSession, &request, &response);
+    UA_RDUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 8);
+
+    /* The variables have the objects folder as their only inverse reference
+     * target */
+    UA_NodeId objects = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        UA_BrowseResult *br = &response.results[i];
+        ck_assert_uint_eq(br->statusCode, UA_STATUSCODE_GOOD);
+        if(i % 2 == 0) {
+            ck_assert_uint_eq(br->referencesSize, 1);
+            ck_assert_uint_eq(br->references[0].nodeId.nodeId.identifier.numeric,
+                              UA_NS0ID_ROOTFOLDER);
+        } else {
+            ck_assert_uint_eq(br->referencesSize, 1);
+            ck_assert(UA_NodeId_equal(&br->references[0].nodeId.nodeId, &objects));
+        }
+    }
+    UA_BrowseResponse_clear(&response);
+    UA_Array_delete(bd, SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+} END_TEST
+
+static volatile UA_Boolean writing;
+static UA_NodeId writtenNode;
+static volatile UA_UInt32 writesStarted;
+static volatile UA_UInt32 writesDone;
+
+THREAD_CALLBACK(writeCounter) {
+    UA_UInt32 counter = 0;
+    while(writing) {
+        counter++;
+        writesStarted = counter;
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &counter, &UA_TYPES[UA_TYPES_UINT32]);
+        UA_Server_writeValue(server, writtenNode, v);
+        writesDone = counter;
+    }
+    return 0;
+}
+
+/* The operations of the node do not call into userland. So the service lock is
+ * held by the calling thread or a helper until all slices are done. A
+ * concurrent write does not interleave with the operations of a request. */
+START_TEST(writeNotInterleaved) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 16, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 16; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 20000);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 16;
+    request.nodesToRead = rvi;
+
+    writing = true;
+    writtenNode = UA_NODEID_NUMERIC(1, 20000);
+    THREAD_HANDLE writer;
+    THREAD_CREATE(writer, writeCounter);
+    for(size_t j = 0; j < 200; j++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 16);
+        UA_UInt32 first = *(UA_UInt32*)response.results[0].value.data;
+        for(size_t i = 1; i < SLICE_SIZE * 16; i++)
+            ck_assert_uint_eq(*(UA_UInt32*)response.results[i].value.data, first);
+        UA_ReadResponse_clear(&response);
+    }
+    writing = false;
+    THREAD_JOIN(writer);
+    UA_Array_delete(rvi, SLICE_SIZE * 16, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+/* The read callback releases the service lock. A concurrent write can be
+ * processed between the operations of a sliced request. Every result is a
+ * value that was written during the request. The operations of a slice are
+ * processed in order and see the writes in order. */
+START_TEST(writeDuringSlicedRead) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 16, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 16; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 40000);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 16;
+    request.nodesToRead = rvi;
+
+    writing = true;
+    writesStarted = 0;
+    writesDone = 0;
+    writtenNode = UA_NODEID_NUMERIC(1, 40000);
+    THREAD_HANDLE writer;
+    THREAD_CREATE(writer, writeCounter);
+    size_t interleaved = 0;
+    for(size_t j = 0; j < 200; j++) {
+        UA_UInt32 lower = writesDone;
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        UA_UInt32 upper = writesStarted;
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 16);
+        UA_UInt32 last = 0;
+        for(size_t i = 0; i < SLICE_SIZE * 16; i++) {
+            ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+            ck_assert(UA_Variant_hasScalarType(&response.results[i].value,
+                                               &UA_TYPES[UA_TYPES_UINT32]));
+            UA_UInt32 value = *(UA_UInt32*)response.results[i].value.data;
+            ck_assert_uint_ge(value, lower);
+            ck_assert_uint_le(value, upper);
+            if(i % SLICE_SIZE > 0)
+                ck_assert_uint_ge(value, last);
+            if(i > 0 && value != last)
+                interleaved++;
+            last = value;
+        }
+        UA_ReadResponse_clear(&response);
+    }
+    writing = false;
+    THREAD_JOIN(writer);
+
+    /* The writer was not blocked by the sliced requests */
+    ck_assert_uint_gt(writesDone, 0);
+    printf("writes observed within a sliced read: %u\n", (unsigned)interleaved);
+    UA_Array_delete(rvi, SLICE_SIZE * 16, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+/* The read callbacks in the helpers write to the information model. The
+ * calling thread does not hold the service lock while it waits for them. */
+START_TEST(writeInReadCallback) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 30000);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 8;
+    request.nodesToRead = rvi;
+
+    for(size_t j = 0; j < 20; j++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 8);
+        for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+            ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+            ck_assert(UA_Variant_hasScalarType(&response.results[i].value,
+                                               &UA_TYPES[UA_TYPES_UINT32]));
+        }
+        UA_ReadResponse_clear(&response);
+    }
+
+    /* The callbacks have written the node. Callbacks that read an older
+     * version of the node can write the same counter value. */
+    UA_Variant v;
+    UA_StatusCode res = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, 30000), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(*(UA_UInt32*)v.data > 1);
+    UA_Variant_clear(&v);
+    UA_Array_delete(rvi, SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+/* The external value is read next to a read callback that writes. Neither
+ * waits for the serialization of the value callbacks while it holds the
+ * service lock. */
+START_TEST(externalValueAndWriteInReadCallback) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, (i % 2 == 0) ? 30000 : 60000);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 8;
+    request.nodesToRead = rvi;
+
+    for(size_t j = 0; j < 50; j++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 8);
+        for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+            ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+            ck_assert(UA_Variant_hasScalarType(&response.results[i].value,
+                                               &UA_TYPES[UA_TYPES_UINT32]));
+        }
+        UA_ReadResponse_clear(&response);
+    }
+    UA_Array_delete(rvi, SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+/* The read callback reads a node that is not thread-safe */
+START_TEST(readInReadCallback) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 50000);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 8;
+    request.nodesToRead = rvi;
+
+    for(size_t j = 0; j < 20; j++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 8);
+        for(size_t i = 0; i < SLICE_SIZE * 8; i++)
+            ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+        UA_ReadResponse_clear(&response);
+    }
+
+    /* The callbacks of the nodes that are not thread-safe never overlap */
+    ck_assert_uint_eq(maxInside[0], 1);
+    UA_Array_delete(rvi, SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+} END_TEST
+
+#define READ_THREADS 3
+
+/* Process the sliced requests in parallel. All threads enqueue the helper jobs
+ * of their requests for the workers. */
+THREAD_CALLBACK(readIndicesInSlices) {
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_ptr_ne(rvi, NULL);
+    for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 10000 + (UA_UInt32)(i % VARIABLES));
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = SLICE_SIZE * 8;
+    request.nodesToRead = rvi;
+
+    for(size_t j = 0; j < 20; j++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_RDLOCK(server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_RDUNLOCK(server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, SLICE_SIZE * 8);
+        for(size_t i = 0; i < SLICE_SIZE * 8; i++) {
+            ck_assert(response.results[i].hasValue);
+            ck_assert_uint_eq(*(UA_UInt32*)response.results[i].value.data, i % VARIABLES);
+        }
+        UA_ReadResponse_clear(&response);
+    }
+    UA_Array_delete(rvi, SLICE_SIZE * 8, &UA_TYPES[UA_TYPES_READVALUEID]);
+    return 0;
+}
+
+START_TEST(concurrentSlicedReads) {
+    THREAD_HANDLE readers[READ_THREADS];
+    for(size_t i = 0; i < READ_THREADS; i++)
+        THREAD_CREATE(readers[i], readIndicesInSlices);
+    for(size_t i = 0; i < READ_THREADS; i++)
+        THREAD_JOIN(readers[i]);
+
+    /* The callbacks of the nodes that are not thread-safe never overlap */
+    ck_assert_uint_eq(maxInside[0], 1);
+} END_TEST
+
+static Suite * testSuite_parallelOperations(void) {
+    Suite *s = suite_create("Parallel Operations");
+    TCase *tc = tcase_create("Operations in slices");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, readInSlices);
+    tcase_add_test(tc, browseInSlices);
+    tcase_add_test(tc, writeNotInterleaved);
+    tcase_add_test(tc, writeDuringSlicedRead);
+    tcase_add_test(tc, writeInReadCallback);
+    tcase_add_test(tc, externalValueAndWriteInReadCallback);
+    tcase_add_test(tc, readInReadCallback);
+    tcase_add_test(tc, concurrentSlicedReads);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_parallelOperations();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* The sampling of MonitoredItems is dispatched from the timer to the worker
+ * threads. This benchmark measures the throughput of the sampling callbacks
+ * for an increasing number of workers. Every MonitoredItem observes a different
+ * node. Otherwise the MonitoredItems would share a single sampler. */
+
+#include <open62541/client_subscriptions.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "testing_clock.h"
+
+#include <check.h>
+
+#define MAX_NUMBER_OF_WORKERS 16
+#define NUMBER_OF_ITEMS 256
+#define SAMPLING_INTERVAL 50 /* The minimum of the default config */
+#define ROUNDS 200
+
+static UA_Server *server;
+static volatile UA_UInt32 samples;
+
+/* Every sample reads from the DataSource. Do some work to simulate accessing
+ * the underlying hardware. */
+static UA_StatusCode
+readCounter(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+            const UA_NumericRange *range, UA_DataValue *value) {
+    UA_UInt32 work = 0;
+    for(UA_UInt32 i = 0; i < 1000; i++)
+        work = (work * 31) + i;
+    UA_UInt32 count = UA_atomic_addUInt32(&samples, 1);
+    UA_UInt32 v = count + (work & 1);
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+dataChangeHandler(UA_Server *s, UA_UInt32 monitoredItemId,
+                  void *monitoredItemContext, const UA_NodeId *nodeId,
+                  void *nodeContext, UA_UInt32 attributeId,
+                  const UA_DataValue *value) {
+}
+
+static void
+setup(UA_UInt16 workers) {
+    samples = 0;
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->nThreads = workers;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Counter");
+    UA_DataSource ds;
+    ds.read = readCounter;
+    ds.write = NULL;
+    for(UA_UInt32 i = 0; i < NUMBER_OF_ITEMS; i++) {
+        UA_NodeId counterId = UA_NODEID_NUMERIC(1, 10000 + i);
+        UA_StatusCode res =
+            UA_Server_addDataSourceVariableNode(server, counterId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                UA_QUALIFIEDNAME(1, "Counter"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                attr, ds, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(counterId);
+        item.requestedParameters.samplingInterval = SAMPLING_INTERVAL;
+        UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server, UA_TIMESTAMPSTORETURN_BOTH,
+                                                    item, NULL, dataChangeHandler);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+    }
+    /* Creating the MonitoredItems samples once */
+    samples = 0;
+
+    UA_StatusCode res = UA_Server_run_startup(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static void
+runSampling(UA_UInt16 workers) {
+    setup(workers);
+
+    double begin = UA_realTime();
+    for(size_t i = 0; i < ROUNDS; i++) {
+        UA_fakeSleep(SAMPLING_INTERVAL);
+        UA_Server_run_iterate(server, false);
+    }
+
+    /* Wait until the workers have processed all samples */
+    UA_UInt32 expected = NUMBER_OF_ITEMS * ROUNDS;
+    while(samples < expected && UA_realTime() - begin < 30.0)
+        UA_realSleep(1);
+    double duration = UA_realTime() - begin;
+    ck_assert_uint_eq(samples, expected);
+
+    printf("%u worker(s): %u samples in %.3f s (%.0f samples/s)\n",
+           (unsigned)workers, (unsigned)expected, duration,
+           (double)expected / duration);
+
+    teardown();
+}
+
+START_TEST(samplingScaling) {
+    for(UA_UInt16 workers = 1; workers <= MAX_NUMBER_OF_WORKERS; workers *= 2)
+        runSampling(workers);
+} END_TEST
+
+static Suite* testSuite_sampling(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_sampling = tcase_create("Sampling scaling");
+    tcase_add_test(tc_sampling, samplingScaling);
+    tcase_set_timeout(tc_sampling, 300);
+    suite_add_tcase(s, tc_sampling);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_sampling();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -11,11 +11,15 @@
 #include <open62541/types_generated_encoding_binary.h>
 
 #include "ua_server_internal.h"
+#include "ua_pubsub_networkmessage.h"
 
 #include <check.h>
 #include <stdio.h>
 #include <time.h>
 
+#define RT_FIELDS 64
+#define RT_CYCLES 100000
+
 UA_Server *server = NULL;
 UA_NodeId connection1, connection2, writerGroup1, writerGroup2, writerGroup3,
         publishedDataSet1, publishedDataSet2, dataSetWriter1, dataSetWriter2, dataSetWriter3;
@@ -93,10 +97,141 @@ START_TEST(PublishSpeedTest) {
 
 } END_TEST
 
+static void
+updateBufferedMessage(UA_NetworkMessageOffsetBuffer *bm, const char *name) {
+    clock_t begin = clock();
+    for(int i = 0; i < RT_CYCLES; i++)
+        ck_assert_uint_eq(UA_NetworkMessage_updateBufferedMessage(bm), UA_STATUSCODE_GOOD);
+    double time_spent = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("%s: %.3f us per cycle\n", name, time_spent * 1e6 / RT_CYCLES);
+}
+
+START_TEST(PublishSpeedTestRTFixedSize) {
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup RT");
+    writerGroupConfig.publishingInterval = 10;
+    writerGroupConfig.writerGroupId = 100;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    UA_UadpWriterGroupMessageDataType wgm;
+    UA_UadpWriterGroupMessageDataType_init(&wgm);
+    wgm.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_SEQUENCENUMBER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    writerGroupConfig.messageSettings.content.decoded.data = &wgm;
+    writerGroupConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    ck_assert_uint_eq(UA_Server_addWriterGroup(server, connection1, &writerGroupConfig,
+                                               &writerGroup2), UA_STATUSCODE_GOOD);
+
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet RT");
+    UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet2);
+
+    UA_UadpDataSetWriterMessageDataType dswm;
+    UA_UadpDataSetWriterMessageDataType_init(&dswm);
+    dswm.dataSetMessageContentMask = UA_UADPDATASETMESSAGECONTENTMASK_SEQUENCENUMBER;
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter RT");
+    dataSetWriterConfig.dataSetWriterId = 62541;
+    dataSetWriterConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    dataSetWriterConfig.messageSettings.content.decoded.data = &dswm;
+    dataSetWriterConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPDATASETWRITERMESSAGEDATATYPE];
+    ck_assert_uint_eq(UA_Server_addDataSetWriter(server, writerGroup2, publishedDataSet2,
+                                                 &dataSetWriterConfig, &dataSetWriter2),
+                      UA_STATUSCODE_GOOD);
+
+    /* Fields with a static value source */
+    UA_UInt32 values[RT_FIELDS];
+    UA_DataValue dataValues[RT_FIELDS];
+    UA_DataValue *dataValuePtrs[RT_FIELDS];
+    for(size_t i = 0; i < RT_FIELDS; i++) {
+        values[i] = (UA_UInt32)i;
+        UA_DataValue_init(&dataValues[i]);
+        UA_Variant_setScalar(&dataValues[i].value, &values[i], &UA_TYPES[UA_TYPES_UINT32]);
+        dataValues[i].value.storageType = UA_VARIANT_DATA_NODELETE;
+        dataValuePtrs[i] = &dataValues[i];
+        UA_DataSetFieldConfig dsfConfig;
+        memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+        dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
+        dsfConfig.field.variable.rtValueSource.staticValueSource = &dataValuePtrs[i];
+        dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+        ck_assert_uint_eq(UA_Server_addDataSetField(server, publishedDataSet2,
+                                                    &dsfConfig, NULL).result,
+                          UA_STATUSCODE_GOOD);
+    }
+
+    ck_assert_uint_eq(UA_Server_freezeWriterGroupConfiguration(server, writerGroup2),
+                      UA_STATUSCODE_GOOD);
+    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroup2);
+    UA_NetworkMessageOffsetBuffer *bm = &wg->bufferedMessage;
+    ck_assert_ptr_ne(bm->copyPlan, NULL);
+    ck_assert_uint_eq(bm->copyPlanSize, bm->offsetsSize);
+
+    /* The plan writes the current values and sequence numbers */
+    for(size_t i = 0; i < RT_FIELDS; i++)
+        values[i] = (UA_UInt32)(i * 1000);
+    wg->sequenceNumber = 4711;
+    UA_DataSetWriter *dsw = UA_DataSetWriter_findDSWbyId(server, dataSetWriter2);
+    dsw->actualDataSetMessageSequenceCount = 815;
+    ck_assert_uint_eq(UA_NetworkMessage_updateBufferedMessage(bm), UA_STATUSCODE_GOOD);
+    UA_NetworkMessage nm;
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    size_t offset = 0;
+    ck_assert_uint_eq(UA_NetworkMessage_decodeBinary(&bm->buffer, &offset, &nm),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(nm.groupHeader.sequenceNumber, 4711);
+    UA_DataSetMessage *dsm = nm.payload.dataSetPayload.dataSetMessages;
+    ck_assert_uint_eq(dsm->header.dataSetMessageSequenceNr, 815);
+    ck_assert_uint_eq(dsm->data.keyFrameData.fieldCount, RT_FIELDS);
+    for(size_t i = 0; i < RT_FIELDS; i++)
+        ck_assert_uint_eq(*(UA_UInt32*)dsm->data.keyFrameData.dataSetFields[i].value.data,
+                          i * 1000);
+    UA_NetworkMessage_deleteMembers(&nm);
+
+    /* A sent message increases the sequence numbers */
+    UA_WriterGroup_publishCallback(server, wg);
+    ck_assert_uint_eq(wg->sequenceNumber, 4712);
+    ck_assert_uint_eq(dsw->actualDataSetMessageSequenceCount, 816);
+
+    /* Per-cycle cost of the buffer update with the compiled plan and with the
+     * encoding of every offset */
+    printf("%u UInt32 fields in a fixed-size message of %u bytes\n",
+           (unsigned)RT_FIELDS, (unsigned)bm->buffer.length);
+    updateBufferedMessage(bm, "copy plan");
+    UA_NetworkMessageCopyOp *plan = bm->copyPlan;
+    bm->copyPlan = NULL;
+    updateBufferedMessage(bm, "offset encoding");
+    bm->copyPlan = plan;
+
+    /* Per-cycle cost including the send */
+    clock_t begin = clock();
+    for(int i = 0; i < 8000; i++)
+        UA_WriterGroup_publishCallback(server, wg);
+    double time_spent = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("publish cycle: %.3f us per cycle\n", time_spent * 1e6 / 8000);
+
+    UA_Server_unfreezeWriterGroupConfiguration(server, writerGroup2);
+    ck_assert_ptr_eq(bm->copyPlan, NULL);
+    UA_Server_removeWriterGroup(server, writerGroup2);
+    /* The static value sources are on the stack */
+    UA_Server_removePublishedDataSet(server, publishedDataSet2);
+} END_TEST
+
 int main(void) {
     TCase *tc_publishspeed = tcase_create("Speed of the publisher");
     tcase_add_checked_fixture(tc_publishspeed, setup, teardown);
     tcase_add_test(tc_publishspeed, PublishSpeedTest);
+    tcase_add_test(tc_publishspeed, PublishSpeedTestRTFixedSize);
 
     Suite *s = suite_create("PubSub Speed Test");
     suite_add_tcase(s, tc_publishspeed);
@@ -609,6 +609,86 @@ START_TEST(SinglePublishSubscribeDateTime) {
 
    }END_TEST
 
+START_TEST(DispatchNetworkMessageToManyDataSetReaders) {
+        /* The DataSetReaders of many publishers in several ReaderGroups */
+        UA_NodeId readerGroups[4];
+        UA_NodeId readers[400];
+        UA_ReaderGroupConfig readerGroupConfig;
+        memset(&readerGroupConfig, 0, sizeof(readerGroupConfig));
+        readerGroupConfig.name = UA_STRING("ReaderGroup Test");
+        for(size_t i = 0; i < 4; i++) {
+            UA_StatusCode retVal = UA_Server_addReaderGroup(server, connection_test,
+                                                            &readerGroupConfig, &readerGroups[i]);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        }
+
+        UA_DataSetReaderConfig readerConfig;
+        memset(&readerConfig, 0, sizeof(readerConfig));
+        readerConfig.name = UA_STRING("DataSetReader Test");
+        readerConfig.writerGroupId = WRITER_GROUP_ID;
+        for(UA_UInt16 i = 0; i < 400; i++) {
+            UA_UInt16 publisherIdentifier = i;
+            readerConfig.publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
+            readerConfig.publisherId.data = &publisherIdentifier;
+            readerConfig.dataSetWriterId = (UA_UInt16)(i + 1);
+            UA_StatusCode retVal = UA_Server_addDataSetReader(server, readerGroups[i % 4],
+                                                              &readerConfig, &readers[i]);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        }
+
+        /* NetworkMessages without DataSetMessages are only dispatched */
+        UA_PubSubConnection *connection =
+            UA_PubSubConnection_findConnectionbyId(server, connection_test);
+        ck_assert_ptr_ne(connection, NULL);
+        UA_UInt16 dataSetWriterId;
+        UA_NetworkMessage networkMessage;
+        memset(&networkMessage, 0, sizeof(networkMessage));
+        networkMessage.publisherIdEnabled = true;
+        networkMessage.publisherIdType = UA_PUBLISHERDATATYPE_UINT16;
+        networkMessage.groupHeaderEnabled = true;
+        networkMessage.groupHeader.writerGroupIdEnabled = true;
+        networkMessage.groupHeader.writerGroupId = WRITER_GROUP_ID;
+        networkMessage.payloadHeaderEnabled = true;
+        networkMessage.payloadHeader.dataSetPayloadHeader.dataSetWriterIds = &dataSetWriterId;
+        for(UA_UInt16 i = 0; i < 400; i++) {
+            networkMessage.publisherId.publisherIdUInt16 = i;
+            dataSetWriterId = (UA_UInt16)(i + 1);
+            ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                             UA_STATUSCODE_GOOD);
+        }
+
+        /* Unknown DataSetWriterId */
+        networkMessage.publisherId.publisherIdUInt16 = 7;
+        dataSetWriterId = 7;
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_BADNOTFOUND);
+
+        /* The PublisherId has a different type */
+        dataSetWriterId = 8;
+        networkMessage.publisherIdType = UA_PUBLISHERDATATYPE_BYTE;
+        networkMessage.publisherId.publisherIdByte = 7;
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_BADNOTFOUND);
+
+        /* Removed DataSetReaders are no longer found */
+        networkMessage.publisherIdType = UA_PUBLISHERDATATYPE_UINT16;
+        networkMessage.publisherId.publisherIdUInt16 = 7;
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(UA_Server_removeDataSetReader(server, readers[7]), UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_BADNOTFOUND);
+        ck_assert_int_eq(UA_Server_removeReaderGroup(server, readerGroups[0]), UA_STATUSCODE_GOOD);
+        networkMessage.publisherId.publisherIdUInt16 = 8;
+        dataSetWriterId = 9;
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_BADNOTFOUND);
+        networkMessage.publisherId.publisherIdUInt16 = 9;
+        dataSetWriterId = 10;
+        ck_assert_int_eq(UA_Server_processNetworkMessage(server, &networkMessage, connection),
+                         UA_STATUSCODE_GOOD);
+    } END_TEST
+
 START_TEST(SinglePublishSubscribeInt32) {
         /* To check status after running both publisher and subscriber */
         UA_StatusCode retVal = UA_STATUSCODE_GOOD;
@@ -1338,6 +1418,7 @@ int main(void) {
     tcase_add_test(tc_add_pubsub_readergroup, CreateTargetVariableWithInvalidConfiguration);
     tcase_add_test(tc_add_pubsub_readergroup, AddTargetVariableWithInvalidConfiguration);
     tcase_add_test(tc_add_pubsub_readergroup, AddTargetVariableWithValidConfiguration);
+    tcase_add_test(tc_add_pubsub_readergroup, DispatchNetworkMessageToManyDataSetReaders);
 
     /*Test case to run both publisher and subscriber */
     TCase *tc_pubsub_publish_subscribe = tcase_create("Publisher publishing and Subscriber subscribing");
@@ -0,0 +1,396 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Fixed-size RT subscriber that decodes the received fields directly into the
+ * external value of the target variables. The server publishes a static value
+ * source over the multicast loopback and subscribes to its own messages. */
+
+#include <open62541/plugin/pubsub_udp.h>
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+
+#include "ua_pubsub.h"
+#include "ua_pubsub_networkmessage.h"
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <stdio.h>
+#include <time.h>
+
+#define PUBLISHER_ID      2234
+#define WRITER_GROUP_ID   100
+#define DATASET_WRITER_ID 62541
+#define LATENCY_ROUNDS    1000
+
+UA_Server *server = NULL;
+UA_NodeId connectionId, writerGroupId, readerGroupId, readerId, publishedDataSetId;
+UA_NodeId subscribedVarId;
+UA_WriterGroup *writerGroup;
+UA_ReaderGroup *readerGroup;
+size_t maxBatch; /* Most messages returned from one receiveBatch call */
+UA_StatusCode (*channelReceiveBatch)(UA_PubSubChannel *channel, UA_ByteString *messages,
+                                     size_t messagesSize, size_t *received,
+                                     UA_ExtensionObject *transportSettings,
+                                     UA_UInt32 timeout);
+
+/* Publisher and subscriber storage */
+UA_UInt32 publishedValue;
+UA_DataValue publishedDataValue;
+UA_DataValue *publishedDataValuePtr;
+UA_UInt32 subscribedValue;
+UA_DataValue subscribedDataValue;
+UA_DataValue *subscribedDataValuePtr;
+
+#ifdef COUNT_ALLOCATIONS
+/* The test is linked with --wrap for malloc, calloc and realloc. So every
+ * allocation of the stack goes through the wrappers below. */
+static UA_Boolean countAllocations;
+static size_t allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nelem, size_t elsize);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t nelem, size_t elsize);
+void *__wrap_realloc(void *ptr, size_t size);
+
+void *
+__wrap_malloc(size_t size) {
+    if(countAllocations)
+        allocations++;
+    return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t nelem, size_t elsize) {
+    if(countAllocations)
+        allocations++;
+    return __real_calloc(nelem, elsize);
+}
+
+void *
+__wrap_realloc(void *ptr, size_t size) {
+    if(countAllocations)
+        allocations++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static UA_StatusCode
+notificationRead(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+                 const UA_NodeId *nodeId, void *nodeContext,
+                 const UA_NumericRange *range) {
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+addPublisher(void) {
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet");
+    UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSetId);
+
+    publishedValue = 0;
+    UA_DataValue_init(&publishedDataValue);
+    UA_Variant_setScalar(&publishedDataValue.value, &publishedValue,
+                         &UA_TYPES[UA_TYPES_UINT32]);
+    publishedDataValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+    publishedDataValuePtr = &publishedDataValue;
+    UA_DataSetFieldConfig fieldConfig;
+    memset(&fieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    fieldConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
+    fieldConfig.field.variable.rtValueSource.staticValueSource = &publishedDataValuePtr;
+    fieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataSetFieldResult fieldRes =
+        UA_Server_addDataSetField(server, publishedDataSetId, &fieldConfig, NULL);
+    ck_assert_uint_eq(fieldRes.result, UA_STATUSCODE_GOOD);
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup");
+    writerGroupConfig.publishingInterval = 1000000; /* Published manually */
+    writerGroupConfig.writerGroupId = WRITER_GROUP_ID;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_UadpWriterGroupMessageDataType writerGroupMessage;
+    UA_UadpWriterGroupMessageDataType_init(&writerGroupMessage);
+    writerGroupMessage.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    writerGroupConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    writerGroupConfig.messageSettings.content.decoded.data = &writerGroupMessage;
+    UA_StatusCode res =
+        UA_Server_addWriterGroup(server, connectionId, &writerGroupConfig, &writerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter");
+    dataSetWriterConfig.dataSetWriterId = DATASET_WRITER_ID;
+    res = UA_Server_addDataSetWriter(server, writerGroupId, publishedDataSetId,
+                                     &dataSetWriterConfig, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+addSubscriber(void) {
+    /* Subscribed variable with an external value */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Subscribed UInt32");
+    attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 1001),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Subscribed UInt32"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, &subscribedVarId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    subscribedValue = 0;
+    UA_DataValue_init(&subscribedDataValue);
+    UA_Variant_setScalar(&subscribedDataValue.value, &subscribedValue,
+                         &UA_TYPES[UA_TYPES_UINT32]);
+    subscribedDataValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+    subscribedDataValue.hasValue = true;
+    subscribedDataValuePtr = &subscribedDataValue;
+    UA_ValueBackend valueBackend;
+    memset(&valueBackend, 0, sizeof(UA_ValueBackend));
+    valueBackend.backendType = UA_VALUEBACKENDTYPE_EXTERNAL;
+    valueBackend.backend.external.value = &subscribedDataValuePtr;
+    valueBackend.backend.external.callback.notificationRead = notificationRead;
+    res = UA_Server_setVariableNode_valueBackend(server, subscribedVarId, valueBackend);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset(&readerGroupConfig, 0, sizeof(UA_ReaderGroupConfig));
+    readerGroupConfig.name = UA_STRING("ReaderGroup");
+    readerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    res = UA_Server_addReaderGroup(server, connectionId, &readerGroupConfig, &readerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING("DataSetReader");
+    UA_UInt16 publisherId = PUBLISHER_ID;
+    readerConfig.publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
+    readerConfig.publisherId.data = &publisherId;
+    readerConfig.writerGroupId = WRITER_GROUP_ID;
+    readerConfig.dataSetWriterId = DATASET_WRITER_ID;
+    UA_UadpDataSetReaderMessageDataType readerMessage;
+    UA_UadpDataSetReaderMessageDataType_init(&readerMessage);
+    readerMessage.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    readerConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    readerConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPDATASETREADERMESSAGEDATATYPE];
+    readerConfig.messageSettings.content.decoded.data = &readerMessage;
+    UA_FieldMetaData field;
+    UA_FieldMetaData_init(&field);
+    field.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    field.builtInType = UA_NS0ID_UINT32;
+    field.valueRank = -1; /* scalar */
+    readerConfig.dataSetMetaData.name = UA_STRING("DataSet");
+    readerConfig.dataSetMetaData.fieldsSize = 1;
+    readerConfig.dataSetMetaData.fields = &field;
+    res = UA_Server_addDataSetReader(server, readerGroupId, &readerConfig, &readerId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_FieldTargetDataType target;
+    UA_FieldTargetDataType_init(&target);
+    target.attributeId = UA_ATTRIBUTEID_VALUE;
+    target.targetNodeId = subscribedVarId;
+    UA_TargetVariablesDataType targetVars = {1, &target};
+    res = UA_Server_DataSetReader_createTargetVariables(server, readerId, &targetVars);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static UA_StatusCode
+countingReceiveBatch(UA_PubSubChannel *channel, UA_ByteString *messages,
+                     size_t messagesSize, size_t *received,
+                     UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    UA_StatusCode res = channelReceiveBatch(channel, messages, messagesSize, received,
+                                            transportSettings, timeout);
+    if(*received > maxBatch)
+        maxBatch = *received;
+    return res;
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setMinimal(config, 4803, NULL);
+    config->pubsubTransportLayers = (UA_PubSubTransportLayer*)
+        UA_malloc(sizeof(UA_PubSubTransportLayer));
+    config->pubsubTransportLayers[0] = UA_PubSubTransportLayerUDPMP();
+    config->pubsubTransportLayersSize++;
+    UA_Server_run_startup(server);
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4803/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    connectionConfig.publisherId.numeric = PUBLISHER_ID;
+    UA_StatusCode res =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_PubSubConnection_regist(server, &connectionId);
+
+    /* Count the messages per receiveBatch call */
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, connectionId);
+    ck_assert_ptr_ne(connection, NULL);
+    ck_assert_ptr_ne(connection->channel->receiveBatch, NULL);
+    channelReceiveBatch = connection->channel->receiveBatch;
+    connection->channel->receiveBatch = countingReceiveBatch;
+
+    addPublisher();
+    addSubscriber();
+
+    res = UA_Server_freezeWriterGroupConfiguration(server, writerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_freezeReaderGroupConfiguration(server, readerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The callbacks are triggered manually */
+    writerGroup = UA_WriterGroup_findWGbyId(server, writerGroupId);
+    readerGroup = UA_ReaderGroup_findRGbyId(server, readerGroupId);
+    ck_assert_ptr_ne(writerGroup, NULL);
+    ck_assert_ptr_ne(readerGroup, NULL);
+}
+
+static void teardown(void) {
+    UA_Server_unfreezeReaderGroupConfiguration(server, readerGroupId);
+    UA_Server_unfreezeWriterGroupConfiguration(server, writerGroupId);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static double
+nowUsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* Publish the value and receive until it arrives in the external value */
+static UA_Boolean
+publishAndReceive(UA_UInt32 value) {
+    publishedValue = value;
+    UA_WriterGroup_publishCallback(server, writerGroup);
+    for(size_t i = 0; i < 10 && subscribedValue != value; i++)
+        UA_ReaderGroup_subscribeCallback(server, readerGroup);
+    return (subscribedValue == value);
+}
+
+START_TEST(DecodeIntoExternalValue) {
+    UA_DataSetReader *reader = UA_ReaderGroup_findDSRbyId(server, readerId);
+    ck_assert_ptr_ne(reader, NULL);
+    size_t external = 0;
+    for(size_t i = 0; i < reader->bufferedMessage.offsetsSize; i++) {
+        if(reader->bufferedMessage.offsets[i].contentType ==
+           UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL)
+            external++;
+    }
+    ck_assert_uint_eq(external, 1);
+
+    ck_assert(publishAndReceive(4711));
+
+    /* The field is not decoded into the buffered message */
+    UA_DataSetMessage *dsm = reader->bufferedMessage.nm->payload.dataSetPayload.dataSetMessages;
+    ck_assert(!dsm->data.keyFrameData.dataSetFields[0].hasValue);
+    ck_assert_ptr_eq(dsm->data.keyFrameData.dataSetFields[0].value.data, NULL);
+
+    /* The variable reads from the external value */
+    UA_Variant value;
+    UA_StatusCode res = UA_Server_readValue(server, subscribedVarId, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(value.type, &UA_TYPES[UA_TYPES_UINT32]);
+    ck_assert_uint_eq(*(UA_UInt32*)value.data, 4711);
+    UA_Variant_clear(&value);
+} END_TEST
+
+#ifdef COUNT_ALLOCATIONS
+START_TEST(ReceiveWithoutAllocation) {
+    /* Allocate the receive buffer of the ReaderGroup */
+    ck_assert(publishAndReceive(1));
+    for(UA_UInt32 i = 2; i < 100; i++) {
+        publishedValue = i;
+        UA_WriterGroup_publishCallback(server, writerGroup);
+        allocations = 0;
+        countAllocations = true;
+        for(size_t j = 0; j < 10 && subscribedValue != i; j++)
+            UA_ReaderGroup_subscribeCallback(server, readerGroup);
+        countAllocations = false;
+        ck_assert_uint_eq(subscribedValue, i);
+        ck_assert_uint_eq(allocations, 0);
+    }
+} END_TEST
+#endif
+
+/* Several pending messages are received in one batch. The last one
+ * determines the external value. */
+START_TEST(ReceiveBurst) {
+    ck_assert(publishAndReceive(1));
+    maxBatch = 0;
+    for(UA_UInt32 i = 2; i < 10; i++) {
+        publishedValue = i;
+        UA_WriterGroup_publishCallback(server, writerGroup);
+    }
+    for(size_t i = 0; i < 10 && subscribedValue != 9; i++)
+        UA_ReaderGroup_subscribeCallback(server, readerGroup);
+    ck_assert_uint_eq(subscribedValue, 9);
+    ck_assert_uint_gt(maxBatch, 1);
+} END_TEST
+
+START_TEST(ReceiveLatency) {
+    double total = 0.0;
+    size_t rounds = 0;
+    for(UA_UInt32 i = 1; i <= LATENCY_ROUNDS; i++) {
+        double sent = nowUsec();
+        ck_assert(publishAndReceive(i));
+        total += nowUsec() - sent;
+        rounds++;
+    }
+    printf("Publish-to-external-value latency over %lu rounds: %.1f us\n",
+           (unsigned long)rounds, total / (double)rounds);
+} END_TEST
+
+static Suite *testSuite_pubsub_subscribe_rt_external(void) {
+    Suite *s = suite_create("PubSub RT Subscribe to External Values");
+    TCase *tc = tcase_create("Decode into external values");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, DecodeIntoExternalValue);
+#ifdef COUNT_ALLOCATIONS
+    tcase_add_test(tc, ReceiveWithoutAllocation);
+#endif
+    tcase_add_test(tc, ReceiveBurst);
+    tcase_add_test(tc, ReceiveLatency);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_pubsub_subscribe_rt_external();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -260,6 +260,180 @@ START_TEST(SubscribeSingleFieldWithFixedOffsets) {
     UA_DataValue_delete(dataValue);
 } END_TEST
 
+/* Receive through the subscribe callback of the ReaderGroup. The identifiers
+ * of the message are checked against the reader configuration. */
+static void
+subscribeWithReaderConfig(UA_UadpNetworkMessageContentMask contentMask,
+                          const UA_Variant *publisherId, UA_Boolean sharedKey) {
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
+    UA_PubSubConnection *connection = UA_PubSubConnection_findConnectionbyId(server, connectionIdentifier);
+    ck_assert(connection != NULL);
+    ck_assert(connection->channel->regist(connection->channel, NULL, NULL) == UA_STATUSCODE_GOOD);
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+    writerGroupConfig.name = UA_STRING("Demo WriterGroup");
+    writerGroupConfig.publishingInterval = 10;
+    writerGroupConfig.enabled = UA_FALSE;
+    writerGroupConfig.writerGroupId = 100;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_UadpWriterGroupMessageDataType *wgm = UA_UadpWriterGroupMessageDataType_new();
+    wgm->networkMessageContentMask = contentMask;
+    writerGroupConfig.messageSettings.content.decoded.data = wgm;
+    writerGroupConfig.messageSettings.content.decoded.type =
+            &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    ck_assert(UA_Server_addWriterGroup(server, connectionIdentifier, &writerGroupConfig, &writerGroupIdent) == UA_STATUSCODE_GOOD);
+    UA_UadpWriterGroupMessageDataType_delete(wgm);
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("Test DataSetWriter");
+    dataSetWriterConfig.dataSetWriterId = 62541;
+    ck_assert(UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent, &dataSetWriterConfig, &dataSetWriterIdent) == UA_STATUSCODE_GOOD);
+    UA_DataSetFieldConfig dsfConfig;
+    memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+    UA_UInt32 *intValue = UA_UInt32_new();
+    *intValue = 1000;
+    UA_DataValue *dataValue = UA_DataValue_new();
+    UA_Variant_setScalar(&dataValue->value, intValue, &UA_TYPES[UA_TYPES_UINT32]);
+    dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
+    dsfConfig.field.variable.rtValueSource.staticValueSource = &dataValue;
+    dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    ck_assert(UA_Server_addDataSetField(server, publishedDataSetIdent, &dsfConfig, &dataSetFieldIdent).result == UA_STATUSCODE_GOOD);
+
+    /* Reader Group */
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset (&readerGroupConfig, 0, sizeof (UA_ReaderGroupConfig));
+    readerGroupConfig.name = UA_STRING ("ReaderGroup Test");
+    readerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    retVal =  UA_Server_addReaderGroup(server, connectionIdentifier, &readerGroupConfig,
+                                       &readerGroupIdentifier);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    /* Data Set Reader */
+    UA_DataSetReaderConfig readerConfig;
+    memset (&readerConfig, 0, sizeof (UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING ("DataSetReader Test");
+    readerConfig.publisherId = *publisherId;
+    readerConfig.writerGroupId    = 100;
+    readerConfig.dataSetWriterId  = 62541;
+    readerConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    readerConfig.messageSettings.content.decoded.type = &UA_TYPES[UA_TYPES_UADPDATASETREADERMESSAGEDATATYPE];
+    UA_UadpDataSetReaderMessageDataType *dataSetReaderMessage = UA_UadpDataSetReaderMessageDataType_new();
+    dataSetReaderMessage->networkMessageContentMask = contentMask;
+    readerConfig.messageSettings.content.decoded.data = dataSetReaderMessage;
+    UA_DataSetMetaDataType *pMetaData = &readerConfig.dataSetMetaData;
+    UA_DataSetMetaDataType_init(pMetaData);
+    pMetaData->name = UA_STRING("DataSet Test");
+    pMetaData->fieldsSize = 1;
+    pMetaData->fields = (UA_FieldMetaData*)UA_Array_new (pMetaData->fieldsSize,
+                         &UA_TYPES[UA_TYPES_FIELDMETADATA]);
+    UA_FieldMetaData_init(&pMetaData->fields[0]);
+    UA_NodeId_copy(&UA_TYPES[UA_TYPES_UINT32].typeId,
+                   &pMetaData->fields[0].dataType);
+    pMetaData->fields[0].builtInType = UA_NS0ID_UINT32;
+    pMetaData->fields[0].valueRank = -1; /* scalar */
+    retVal = UA_Server_addDataSetReader (server, readerGroupIdentifier, &readerConfig,
+                                          &readerIdentifier);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* A reader with the same identifiers in a second ReaderGroup */
+    if(sharedKey) {
+        UA_NodeId readerGroupIdentifier2, readerIdentifier2;
+        readerGroupConfig.name = UA_STRING ("ReaderGroup Test 2");
+        readerGroupConfig.rtLevel = UA_PUBSUB_RT_NONE;
+        retVal = UA_Server_addReaderGroup(server, connectionIdentifier, &readerGroupConfig,
+                                          &readerGroupIdentifier2);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        readerConfig.name = UA_STRING ("DataSetReader Test 2");
+        retVal = UA_Server_addDataSetReader (server, readerGroupIdentifier2, &readerConfig,
+                                              &readerIdentifier2);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    }
+    UA_UadpDataSetReaderMessageDataType_delete(dataSetReaderMessage);
+    UA_free(readerConfig.dataSetMetaData.fields);
+
+    /* Add Subscribed Variable */
+    UA_NodeId newnodeId;
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    vAttr.displayName = UA_LOCALIZEDTEXT ("en-US", "Subscribed UInt32");
+    vAttr.dataType    = UA_TYPES[UA_TYPES_UINT32].typeId;
+    retVal = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 50002),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),  UA_QUALIFIEDNAME(1, "Subscribed UInt32"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, NULL, &newnodeId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_TargetVariablesDataType targetVars;
+    targetVars.targetVariablesSize = 1;
+    targetVars.targetVariables     = (UA_FieldTargetDataType *)
+                                      UA_calloc(targetVars.targetVariablesSize,
+                                      sizeof(UA_FieldTargetDataType));
+    UA_FieldTargetDataType_init(&targetVars.targetVariables[0]);
+    targetVars.targetVariables[0].attributeId  = UA_ATTRIBUTEID_VALUE;
+    targetVars.targetVariables[0].targetNodeId = newnodeId;
+    retVal = UA_Server_DataSetReader_createTargetVariables(server, readerIdentifier,
+                                                            &targetVars);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_TargetVariablesDataType_deleteMembers(&targetVars);
+
+    ck_assert(UA_Server_freezeReaderGroupConfiguration(server, readerGroupIdentifier) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_freezeWriterGroupConfiguration(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+    /* Publishes the first message */
+    ck_assert(UA_Server_setWriterGroupOperational(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+
+    UA_ReaderGroup *readerGroup = UA_ReaderGroup_findRGbyId(server, readerGroupIdentifier);
+    ck_assert(readerGroup != NULL);
+    UA_ReaderGroup_subscribeCallback(server, readerGroup);
+
+    /* Read data received by the Subscriber */
+    UA_Variant *subscribedNodeData = UA_Variant_new();
+    retVal = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, 50002), subscribedNodeData);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(subscribedNodeData, &UA_TYPES[UA_TYPES_UINT32]));
+    ck_assert_uint_eq(*(UA_UInt32 *)subscribedNodeData->data, 1000);
+    UA_Variant_delete(subscribedNodeData);
+
+    ck_assert(UA_Server_unfreezeReaderGroupConfiguration(server, readerGroupIdentifier) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_unfreezeWriterGroupConfiguration(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+    UA_DataValue_delete(dataValue);
+}
+
+START_TEST(SubscribeFixedOffsetsWithoutPublisherId) {
+    UA_UInt16 publisherIdentifier = 2234;
+    UA_Variant publisherId;
+    UA_Variant_setScalar(&publisherId, &publisherIdentifier, &UA_TYPES[UA_TYPES_UINT16]);
+    subscribeWithReaderConfig((UA_UadpNetworkMessageContentMask)
+                              (UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER),
+                              &publisherId, false);
+} END_TEST
+
+START_TEST(SubscribeFixedOffsetsUInt32PublisherId) {
+    UA_UInt32 publisherIdentifier = 2234;
+    UA_Variant publisherId;
+    UA_Variant_setScalar(&publisherId, &publisherIdentifier, &UA_TYPES[UA_TYPES_UINT32]);
+    subscribeWithReaderConfig((UA_UadpNetworkMessageContentMask)
+                              (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER),
+                              &publisherId, false);
+} END_TEST
+
+START_TEST(SubscribeFixedOffsetsSharedReaderKey) {
+    UA_UInt16 publisherIdentifier = 2234;
+    UA_Variant publisherId;
+    UA_Variant_setScalar(&publisherId, &publisherIdentifier, &UA_TYPES[UA_TYPES_UINT16]);
+    subscribeWithReaderConfig((UA_UadpNetworkMessageContentMask)
+                              (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+                               (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER),
+                              &publisherId, true);
+} END_TEST
+
 START_TEST(SetupInvalidPubSubConfig) {
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
     ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
@@ -424,6 +598,9 @@ int main(void) {
     TCase *tc_pubsub_subscribe_rt = tcase_create("PubSub RT subscribe with fixed offsets");
     tcase_add_checked_fixture(tc_pubsub_subscribe_rt, setup, teardown);
     tcase_add_test(tc_pubsub_subscribe_rt, SubscribeSingleFieldWithFixedOffsets);
+    tcase_add_test(tc_pubsub_subscribe_rt, SubscribeFixedOffsetsWithoutPublisherId);
+    tcase_add_test(tc_pubsub_subscribe_rt, SubscribeFixedOffsetsUInt32PublisherId);
+    tcase_add_test(tc_pubsub_subscribe_rt, SubscribeFixedOffsetsSharedReaderKey);
     tcase_add_test(tc_pubsub_subscribe_rt, SetupInvalidPubSubConfig);
 
     Suite *s = suite_create("PubSub RT configuration levels");
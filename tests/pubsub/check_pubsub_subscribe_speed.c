@@ -0,0 +1,296 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Receive throughput and latency of a ReaderGroup. The server publishes a
+ * counter over the multicast loopback and subscribes to its own messages. The
+ * subscribed variable counts the received DataSetMessages in a value
+ * callback. */
+
+#include <open62541/plugin/pubsub_udp.h>
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+
+#include "ua_pubsub.h"
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <stdio.h>
+
+#define PUBLISHER_ID      2234
+#define WRITER_GROUP_ID   100
+#define DATASET_WRITER_ID 62541
+#define MESSAGES          10240
+#define MESSAGES_PER_BURST 64
+#define LATENCY_ROUNDS    1000
+#define POLLING_INTERVAL_USEC 5000 /* Of the former repeated subscribe callback */
+
+UA_Server *server = NULL;
+UA_NodeId connectionId, writerGroupId, readerGroupId, publishedDataSetId;
+UA_NodeId publishedVarId, subscribedVarId;
+UA_WriterGroup *writerGroup;
+UA_ReaderGroup *readerGroup;
+size_t receivedCount;
+size_t maxBatch; /* Most messages returned from one receiveBatch call */
+UA_StatusCode (*channelReceiveBatch)(UA_PubSubChannel *channel, UA_ByteString *messages,
+                                     size_t messagesSize, size_t *received,
+                                     UA_ExtensionObject *transportSettings,
+                                     UA_UInt32 timeout);
+
+static UA_StatusCode
+countingReceiveBatch(UA_PubSubChannel *channel, UA_ByteString *messages,
+                     size_t messagesSize, size_t *received,
+                     UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    UA_StatusCode res = channelReceiveBatch(channel, messages, messagesSize, received,
+                                            transportSettings, timeout);
+    if(*received > maxBatch)
+        maxBatch = *received;
+    return res;
+}
+
+static void
+onWriteCounter(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+               const UA_NodeId *nodeId, void *nodeContext,
+               const UA_NumericRange *range, const UA_DataValue *data) {
+    receivedCount++;
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setMinimal(config, 4802, NULL);
+    config->pubsubTransportLayers = (UA_PubSubTransportLayer*)
+        UA_malloc(sizeof(UA_PubSubTransportLayer));
+    config->pubsubTransportLayers[0] = UA_PubSubTransportLayerUDPMP();
+    config->pubsubTransportLayersSize++;
+    UA_Server_run_startup(server);
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4802/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    connectionConfig.publisherId.numeric = PUBLISHER_ID;
+    UA_StatusCode res =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_PubSubConnection_regist(server, &connectionId);
+
+    /* Count the messages per receiveBatch call */
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, connectionId);
+    ck_assert_ptr_ne(connection, NULL);
+    ck_assert_ptr_ne(connection->channel->receiveBatch, NULL);
+    channelReceiveBatch = connection->channel->receiveBatch;
+    connection->channel->receiveBatch = countingReceiveBatch;
+
+    /* Published counter */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Published Counter");
+    attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    UA_UInt32 counter = 0;
+    UA_Variant_setScalar(&attr.value, &counter, &UA_TYPES[UA_TYPES_UINT32]);
+    res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 1000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Published Counter"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    attr, NULL, &publishedVarId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Subscribed counter */
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Subscribed Counter");
+    res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 1001),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Subscribed Counter"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    attr, NULL, &subscribedVarId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ValueCallback callback = {NULL, onWriteCounter};
+    res = UA_Server_setVariableNode_valueCallback(server, subscribedVarId, callback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Publisher */
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet");
+    UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSetId);
+
+    UA_DataSetFieldConfig fieldConfig;
+    memset(&fieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    fieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    fieldConfig.field.variable.fieldNameAlias = UA_STRING("Counter");
+    fieldConfig.field.variable.publishParameters.publishedVariable = publishedVarId;
+    fieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_Server_addDataSetField(server, publishedDataSetId, &fieldConfig, NULL);
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup");
+    writerGroupConfig.publishingInterval = 1000000; /* Published manually */
+    writerGroupConfig.writerGroupId = WRITER_GROUP_ID;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    writerGroupConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    UA_UadpWriterGroupMessageDataType *writerGroupMessage =
+        UA_UadpWriterGroupMessageDataType_new();
+    writerGroupMessage->networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    writerGroupConfig.messageSettings.content.decoded.data = writerGroupMessage;
+    res = UA_Server_addWriterGroup(server, connectionId, &writerGroupConfig, &writerGroupId);
+    UA_UadpWriterGroupMessageDataType_delete(writerGroupMessage);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter");
+    dataSetWriterConfig.dataSetWriterId = DATASET_WRITER_ID;
+    dataSetWriterConfig.keyFrameCount = 10;
+    res = UA_Server_addDataSetWriter(server, writerGroupId, publishedDataSetId,
+                                     &dataSetWriterConfig, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Subscriber */
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset(&readerGroupConfig, 0, sizeof(UA_ReaderGroupConfig));
+    readerGroupConfig.name = UA_STRING("ReaderGroup");
+    res = UA_Server_addReaderGroup(server, connectionId, &readerGroupConfig, &readerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING("DataSetReader");
+    UA_UInt16 publisherId = PUBLISHER_ID;
+    readerConfig.publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
+    readerConfig.publisherId.data = &publisherId;
+    readerConfig.writerGroupId = WRITER_GROUP_ID;
+    readerConfig.dataSetWriterId = DATASET_WRITER_ID;
+    UA_FieldMetaData field;
+    UA_FieldMetaData_init(&field);
+    field.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    field.builtInType = UA_NS0ID_UINT32;
+    field.valueRank = -1; /* scalar */
+    readerConfig.dataSetMetaData.name = UA_STRING("DataSet");
+    readerConfig.dataSetMetaData.fieldsSize = 1;
+    readerConfig.dataSetMetaData.fields = &field;
+    UA_NodeId readerId;
+    res = UA_Server_addDataSetReader(server, readerGroupId, &readerConfig, &readerId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_FieldTargetDataType target;
+    UA_FieldTargetDataType_init(&target);
+    target.attributeId = UA_ATTRIBUTEID_VALUE;
+    target.targetNodeId = subscribedVarId;
+    UA_TargetVariablesDataType targetVars = {1, &target};
+    res = UA_Server_DataSetReader_createTargetVariables(server, readerId, &targetVars);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The callbacks are triggered manually */
+    writerGroup = UA_WriterGroup_findWGbyId(server, writerGroupId);
+    readerGroup = UA_ReaderGroup_findRGbyId(server, readerGroupId);
+    ck_assert_ptr_ne(writerGroup, NULL);
+    ck_assert_ptr_ne(readerGroup, NULL);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static void
+publishCounter(UA_UInt32 counter) {
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &counter, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_StatusCode res = UA_Server_writeValue(server, publishedVarId, value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_WriterGroup_publishCallback(server, writerGroup);
+}
+
+/* Receive until the expected number of messages arrived. Gives up when no
+ * further messages are received. */
+static void
+receiveAll(size_t expected) {
+    size_t idle = 0;
+    while(receivedCount < expected && idle < 10) {
+        size_t before = receivedCount;
+        UA_ReaderGroup_subscribeCallback(server, readerGroup);
+        idle = (receivedCount == before) ? idle + 1 : 0;
+    }
+}
+
+START_TEST(SubscribeThroughput) {
+    receivedCount = 0;
+    maxBatch = 0;
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(UA_UInt32 i = 0; i < MESSAGES; i += MESSAGES_PER_BURST) {
+        size_t burstEnd = receivedCount + MESSAGES_PER_BURST;
+        for(UA_UInt32 j = 0; j < MESSAGES_PER_BURST; j++)
+            publishCounter(i + j);
+        receiveAll(burstEnd);
+    }
+    double duration = (double)(UA_DateTime_nowMonotonic() - begin) / UA_DATETIME_SEC;
+    printf("Received %lu of %lu messages in bursts of %u: %.0f messages/s\n",
+           (unsigned long)receivedCount, (unsigned long)MESSAGES,
+           MESSAGES_PER_BURST, (double)receivedCount / duration);
+    ck_assert_uint_eq(receivedCount, MESSAGES);
+
+    /* The messages of a burst were pending together */
+    ck_assert_uint_gt(maxBatch, 1);
+} END_TEST
+
+/* The server main loop receives when the socket of the ReaderGroup is
+ * readable. So the latency stays below the former polling interval. */
+START_TEST(SubscribeLatency) {
+    UA_StatusCode res = UA_Server_setReaderGroupOperational(server, readerGroupId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_ne(readerGroup->subscribeNetworkLayer, NULL);
+
+    receivedCount = 0;
+    UA_DateTime total = 0;
+    size_t rounds = 0;
+    for(UA_UInt32 i = 0; i < LATENCY_ROUNDS; i++) {
+        size_t before = receivedCount;
+        UA_DateTime sent = UA_DateTime_nowMonotonic();
+        publishCounter(i);
+        for(size_t j = 0; j < 100 && receivedCount == before; j++)
+            UA_Server_run_iterate(server, true);
+        ck_assert_uint_eq(receivedCount, before + 1);
+        total += UA_DateTime_nowMonotonic() - sent;
+        rounds++;
+    }
+    double latency = (double)total / UA_DATETIME_USEC / (double)rounds;
+    printf("Publish-to-subscribe latency over %lu rounds: %.1f us\n",
+           (unsigned long)rounds, latency);
+    ck_assert(latency < POLLING_INTERVAL_USEC);
+} END_TEST
+
+static Suite *testSuite_pubsub_subscribe_speed(void) {
+    Suite *s = suite_create("PubSub Subscribe Speed");
+    TCase *tc = tcase_create("Receive throughput and latency");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, SubscribeThroughput);
+    tcase_add_test(tc, SubscribeLatency);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_pubsub_subscribe_speed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
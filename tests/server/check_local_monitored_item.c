@@ -117,12 +117,177 @@ START_TEST(Server_LocalMonitoredItem) {
 }
 END_TEST
 
+static size_t onWriteCount = 0;
+static UA_StatusCode onWriteStatus = UA_STATUSCODE_GOOD;
+
+static void
+onWriteNotificationCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                            void *monitoredItemContext, const UA_NodeId *nodeId,
+                            void *nodeContext, UA_UInt32 attributeId,
+                            const UA_DataValue *value) {
+    onWriteStatus = value->status;
+    onWriteCount++;
+}
+
+START_TEST(Server_LocalMonitoredItem_samplingOnWrite) {
+    UA_Server_getConfig(server)->samplingOnWrite = true;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+            UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server,
+                                                    UA_TIMESTAMPSTORETURN_BOTH,
+                                                    monitorRequest,
+                                                    NULL,
+                                                    &onWriteNotificationCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 1);
+
+    /* The value is not polled */
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, 1);
+    }
+    ck_assert_uint_eq(onWriteCount, 1);
+
+    /* Writing samples immediately */
+    UA_UInt32 count = 41;
+    UA_Variant val;
+    UA_Variant_setScalar(&val, &count, &UA_TYPES[UA_TYPES_UINT32]);
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 2);
+
+    /* Writing the same value is not a change */
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 2);
+
+    /* Deleting the node is reported */
+    ASSERT_STATUSCODE(UA_Server_deleteNode(server, outNodeId, true), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 3);
+    ASSERT_STATUSCODE(onWriteStatus, UA_STATUSCODE_BADNODEIDUNKNOWN);
+}
+END_TEST
+
+static UA_UInt32 dataSourceValue = 100;
+
+static UA_StatusCode
+readCounter(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+            const UA_NumericRange *range, UA_DataValue *value) {
+    dataSourceValue++;
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &dataSourceValue,
+                                    &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+/* The sampler is polled once a DataSource is attached to the node */
+START_TEST(Server_LocalMonitoredItem_samplingOnWriteToDataSource) {
+    UA_Server_getConfig(server)->samplingOnWrite = true;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+            UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    onWriteCount = 0;
+    UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server,
+                                                    UA_TIMESTAMPSTORETURN_BOTH,
+                                                    monitorRequest,
+                                                    NULL,
+                                                    &onWriteNotificationCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 1);
+
+    UA_DataSource ds;
+    ds.read = readCounter;
+    ds.write = NULL;
+    ASSERT_STATUSCODE(UA_Server_setVariableNode_dataSource(server, outNodeId, ds),
+                      UA_STATUSCODE_GOOD);
+
+    /* Every sampling interval produces a new value */
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, 1);
+    }
+    ck_assert_uint_ge(onWriteCount, 10);
+}
+END_TEST
+
+/* The sampler is evaluated again when the node is deleted and added again */
+START_TEST(Server_LocalMonitoredItem_samplingOnWriteNodeReAdded) {
+    UA_Server_getConfig(server)->samplingOnWrite = true;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+            UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    onWriteCount = 0;
+    UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server,
+                                                    UA_TIMESTAMPSTORETURN_BOTH,
+                                                    monitorRequest,
+                                                    NULL,
+                                                    &onWriteNotificationCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 1);
+
+    /* Delete the node and add it again with a value */
+    ASSERT_STATUSCODE(UA_Server_deleteNode(server, outNodeId, true), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 2);
+    ASSERT_STATUSCODE(onWriteStatus, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_UInt32 myUint32 = 42;
+    UA_Variant_setScalar(&attr.value, &myUint32, &UA_TYPES[UA_TYPES_UINT32]);
+    attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    ASSERT_STATUSCODE(UA_Server_addVariableNode(server, outNodeId, parentNodeId,
+                                                parentReferenceNodeId,
+                                                UA_QUALIFIEDNAME(1, "the answer"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                attr, NULL, NULL), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 3);
+    ASSERT_STATUSCODE(onWriteStatus, UA_STATUSCODE_GOOD);
+
+    /* The value is not polled */
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, 1);
+    }
+    ck_assert_uint_eq(onWriteCount, 3);
+
+    /* Delete the node and add it again with a DataSource */
+    ASSERT_STATUSCODE(UA_Server_deleteNode(server, outNodeId, true), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(onWriteCount, 4);
+    UA_DataSource ds;
+    ds.read = readCounter;
+    ds.write = NULL;
+    ASSERT_STATUSCODE(UA_Server_addDataSourceVariableNode(server, outNodeId, parentNodeId,
+                                                          parentReferenceNodeId,
+                                                          UA_QUALIFIEDNAME(1, "the answer"),
+                                                          UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                          attr, ds, NULL, NULL),
+                      UA_STATUSCODE_GOOD);
+
+    /* Every sampling interval produces a new value */
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, 1);
+    }
+    ck_assert_uint_ge(onWriteCount, 14);
+    ASSERT_STATUSCODE(onWriteStatus, UA_STATUSCODE_GOOD);
+}
+END_TEST
+
 static Suite* testSuite_Client(void)
 {
     Suite *s = suite_create("Local Monitored Item");
     TCase *tc_server = tcase_create("Local Monitored Item Basic");
     tcase_add_checked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_LocalMonitoredItem);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_samplingOnWrite);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_samplingOnWriteToDataSource);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_samplingOnWriteNodeReAdded);
     suite_add_tcase(s, tc_server);
 
     return s;
@@ -0,0 +1,168 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+/* This example is just to see how fast we can page through the references of a
+ * large folder with continuation points. The server does not open a TCP
+ * port. */
+
+#include <open62541/server_config_default.h>
+
+#include "server/ua_services.h"
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <time.h>
+
+#define CHILDREN 200000 /* Number of nodes in the folder */
+#define PAGESIZE 1000 /* requestedMaxReferencesPerNode */
+
+static UA_Server *server;
+static UA_NodeId folderId;
+
+/* Adding the children with AddNodes takes long. Insert them directly into the
+ * Nodestore and add the references in one go. */
+static UA_StatusCode
+addChildReferences(UA_Server *s, UA_Session *session, UA_Node *node, void *data) {
+    UA_UInt32 nameHash = UA_QualifiedName_hash((UA_QualifiedName*)data);
+    for(UA_UInt32 i = 0; i < CHILDREN; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, 100000 + i);
+        UA_StatusCode retval =
+            UA_Node_addReference(node, UA_REFERENCETYPEINDEX_ORGANIZES, true,
+                                 &target, nameHash);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->logger.log = NULL;
+    config->maxReferencesPerNode = 0;
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    folderId = UA_NODEID_NUMERIC(1, 1000);
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, folderId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "LargeFolder"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE), oattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_QualifiedName childName = UA_QUALIFIEDNAME(1, "Child");
+    UA_ExpandedNodeId folder = UA_EXPANDEDNODEID_NUMERIC(1, 1000);
+    for(UA_UInt32 i = 0; i < CHILDREN; i++) {
+        UA_Node *child = UA_NODESTORE_NEW(server, UA_NODECLASS_OBJECT);
+        ck_assert_ptr_ne(child, NULL);
+        child->head.nodeId = UA_NODEID_NUMERIC(1, 100000 + i);
+        retval = UA_QualifiedName_copy(&childName, &child->head.browseName);
+        retval |= UA_Node_addReference(child, UA_REFERENCETYPEINDEX_ORGANIZES, false,
+                                       &folder, 0);
+        retval |= UA_NODESTORE_INSERT(server, child, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    retval = UA_Server_editNode(server, &server->adminSession, &folderId,
+                                addChildReferences, &childName);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+START_TEST(browseNextSpeed) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = folderId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.requestedMaxReferencesPerNode = PAGESIZE;
+    request.nodesToBrowseSize = 1;
+    request.nodesToBrowse = &bd;
+
+    UA_BrowseResponse response;
+    UA_BrowseResponse_init(&response);
+
+    clock_t begin = clock();
+    UA_RDLOCK(server->serviceMutex);
+    Service_Browse(server, &server->adminSession, &request, &response);
+    UA_RDUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].referencesSize, PAGESIZE);
+
+    size_t total = PAGESIZE;
+    size_t pages = 1;
+    clock_t firstPages = 0;
+    clock_t pageBegin;
+    UA_BrowseNextRequest nextRequest;
+    UA_BrowseNextRequest_init(&nextRequest);
+    nextRequest.continuationPointsSize = 1;
+    nextRequest.continuationPoints = &response.results[0].continuationPoint;
+    while(nextRequest.continuationPoints->length > 0) {
+        UA_BrowseNextResponse nextResponse;
+        UA_BrowseNextResponse_init(&nextResponse);
+        pageBegin = clock();
+        UA_WRLOCK(server->serviceMutex);
+        Service_BrowseNext(server, &server->adminSession, &nextRequest, &nextResponse);
+        UA_WRUNLOCK(server->serviceMutex);
+        if(pages <= 10)
+            firstPages += clock() - pageBegin;
+        ck_assert_uint_eq(nextResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(nextResponse.resultsSize, 1);
+        UA_BrowseResult *br = &nextResponse.results[0];
+        ck_assert_uint_eq(br->statusCode, UA_STATUSCODE_GOOD);
+        ck_assert(br->referencesSize <= PAGESIZE);
+
+        /* The children are returned in the order they were added */
+        ck_assert_uint_eq(br->references[0].nodeId.nodeId.identifier.numeric,
+                          100000 + total);
+        total += br->referencesSize;
+        pages++;
+
+        UA_BrowseResult_clear(&response.results[0]);
+        response.results[0] = *br;
+        UA_BrowseResult_init(br);
+        UA_BrowseNextResponse_clear(&nextResponse);
+    }
+    clock_t finish = clock();
+    ck_assert_uint_eq(total, CHILDREN);
+
+    double timeSpent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("browsing %u references in %u pages took %f s\n",
+           (unsigned)total, (unsigned)pages, timeSpent);
+    printf("average per page: %f s (first ten BrowseNext %f s)\n",
+           timeSpent / (double)pages, (double)firstPages / CLOCKS_PER_SEC / 10.0);
+
+    UA_BrowseResponse_clear(&response);
+}
+END_TEST
+
+static Suite * service_speed_suite (void) {
+    Suite *s = suite_create ("Service Speed");
+
+    TCase* tc_browse = tcase_create ("BrowseNext");
+    tcase_add_checked_fixture(tc_browse, setup, teardown);
+    tcase_add_test (tc_browse, browseNextSpeed);
+    tcase_set_timeout(tc_browse, 0);
+    suite_add_tcase (s, tc_browse);
+
+    return s;
+}
+
+int main (void) {
+    int number_failed = 0;
+    Suite *s = service_speed_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr,CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed (sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,380 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/nodestore_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <time.h>
+
+#define ARRAYSIZE 10000
+
+static UA_Server *server;
+static UA_UInt16 nsIndex;
+static UA_NodeId typeId;
+
+#ifdef UA_ENABLE_METHODCALLS
+static UA_StatusCode
+methodCallback(UA_Server *s, const UA_NodeId *sessionId, void *sessionHandle,
+               const UA_NodeId *methodId, void *methodContext,
+               const UA_NodeId *objectId, void *objectContext,
+               size_t inputSize, const UA_Variant *input,
+               size_t outputSize, UA_Variant *output) {
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
+static void
+addTypeAndNodes(UA_Server *s) {
+    nsIndex = UA_Server_addNamespace(s, "urn:test:nodestoreimage");
+    ck_assert_uint_eq(nsIndex, 2);
+
+    /* ObjectType with a mandatory variable */
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    otAttr.displayName = UA_LOCALIZEDTEXT("en-US", "DeviceType");
+    typeId = UA_NODEID_NUMERIC(nsIndex, 1000);
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(s, typeId, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(nsIndex, "DeviceType"),
+                                    otAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_Double temp = 21.5;
+    UA_Variant_setScalar(&vAttr.value, &temp, &UA_TYPES[UA_TYPES_DOUBLE]);
+    vAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Temperature");
+    UA_NodeId tempId = UA_NODEID_NUMERIC(nsIndex, 1001);
+    retval = UA_Server_addVariableNode(s, tempId, typeId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                       UA_QUALIFIEDNAME(nsIndex, "Temperature"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       vAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(s, tempId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* An instance of the type */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    oAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Device1");
+    retval = UA_Server_addObjectNode(s, UA_NODEID_NUMERIC(nsIndex, 2000),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_QUALIFIEDNAME(nsIndex, "Device1"),
+                                     typeId, oAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* A variable with a large array value */
+    UA_Int32 *array = (UA_Int32*)UA_Array_new(ARRAYSIZE, &UA_TYPES[UA_TYPES_INT32]);
+    for(UA_Int32 i = 0; i < ARRAYSIZE; i++)
+        array[i] = i;
+    vAttr = UA_VariableAttributes_default;
+    UA_Variant_setArray(&vAttr.value, array, ARRAYSIZE, &UA_TYPES[UA_TYPES_INT32]);
+    vAttr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    vAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Array");
+    retval = UA_Server_addVariableNode(s, UA_NODEID_NUMERIC(nsIndex, 3000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       UA_QUALIFIEDNAME(nsIndex, "Array"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       vAttr, NULL, NULL);
+    UA_Array_delete(array, ARRAYSIZE, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+#ifdef UA_ENABLE_METHODCALLS
+    /* An async method */
+    UA_MethodAttributes mAttr = UA_MethodAttributes_default;
+    mAttr.executable = true;
+    mAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Method");
+    retval = UA_Server_addMethodNode(s, UA_NODEID_NUMERIC(nsIndex, 4000),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                     UA_QUALIFIEDNAME(nsIndex, "Method"), mAttr,
+                                     methodCallback, 0, NULL, 0, NULL, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+#if UA_MULTITHREADING >= 100
+    retval = UA_Server_setMethodNodeAsync(s, UA_NODEID_NUMERIC(nsIndex, 4000), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+#endif
+#endif
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    ck_assert(server != NULL);
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    addTypeAndNodes(server);
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+/* Same as UA_Server_new, but with the nodes from the image */
+static UA_Server *
+newServerFromImage(const UA_ByteString *image) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    config.logger = UA_Log_Stdout_;
+    UA_Nodestore_HashMap(&config.nodestore);
+    UA_Server *s = UA_Server_newWithNodestoreImage(&config, image);
+    if(s)
+        UA_ServerConfig_setDefault(UA_Server_getConfig(s));
+    return s;
+}
+
+typedef struct {
+    UA_Server *other;
+    size_t nodes;
+    size_t missing;
+} CompareContext;
+
+static void
+compareNode(void *context, const UA_Node *node) {
+    CompareContext *ctx = (CompareContext*)context;
+    ctx->nodes++;
+    const UA_Node *other = UA_NODESTORE_GET(ctx->other, &node->head.nodeId);
+    if(!other) {
+        ctx->missing++;
+        return;
+    }
+    ck_assert_int_eq(other->head.nodeClass, node->head.nodeClass);
+    ck_assert(UA_QualifiedName_equal(&other->head.browseName, &node->head.browseName));
+    ck_assert_uint_eq(other->head.referencesSize, node->head.referencesSize);
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &node->head.references[i];
+        const UA_NodeReferenceKind *ork = &other->head.references[i];
+        ck_assert_uint_eq(ork->referenceTypeIndex, rk->referenceTypeIndex);
+        ck_assert_uint_eq(ork->isInverse, rk->isInverse);
+        const UA_ReferenceTarget *t = rk->queueHead.tqh_first;
+        const UA_ReferenceTarget *ot = ork->queueHead.tqh_first;
+        for(; t && ot; t = t->queuePointers.tqe_next, ot = ot->queuePointers.tqe_next)
+            ck_assert(UA_ExpandedNodeId_equal(&ot->targetId, &t->targetId));
+        ck_assert(t == NULL && ot == NULL);
+    }
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        ck_assert_uint_eq(other->referenceTypeNode.referenceTypeIndex,
+                          node->referenceTypeNode.referenceTypeIndex);
+        ck_assert(memcmp(&other->referenceTypeNode.subTypes,
+                         &node->referenceTypeNode.subTypes,
+                         sizeof(UA_ReferenceTypeSet)) == 0);
+    }
+    if(node->head.nodeClass == UA_NODECLASS_METHOD) {
+        ck_assert_uint_eq(other->methodNode.executable, node->methodNode.executable);
+#if UA_MULTITHREADING >= 100
+        ck_assert_uint_eq(other->methodNode.async, node->methodNode.async);
+#endif
+    }
+    UA_NODESTORE_RELEASE(ctx->other, other);
+}
+
+START_TEST(saveAndRestore) {
+    UA_ByteString image = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_Server_saveNodestoreImage(server, &image);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(image.length > 0);
+
+    UA_Server *restored = newServerFromImage(&image);
+    ck_assert(restored != NULL);
+
+    /* All nodes are restored with their references */
+    CompareContext ctx;
+    memset(&ctx, 0, sizeof(CompareContext));
+    ctx.other = restored;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     compareNode, &ctx);
+    ck_assert(ctx.nodes > 0);
+    ck_assert_uint_eq(ctx.missing, 0);
+
+    /* The namespace array is restored. Ns1 is set from the ApplicationUri of
+     * the config. */
+    UA_Variant nsa, nsb;
+    retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY), &nsa);
+    retval |= UA_Server_readValue(restored, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY), &nsb);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(nsa.arrayLength, nsb.arrayLength);
+    for(size_t i = 0; i < nsa.arrayLength; i++)
+        ck_assert(UA_String_equal(&((UA_String*)nsa.data)[i], &((UA_String*)nsb.data)[i]));
+    UA_Variant_clear(&nsa);
+    UA_Variant_clear(&nsb);
+
+    /* The image of the restored server has the same content. The order of the
+     * nodes depends on the Nodestore. */
+    UA_ByteString image2 = UA_BYTESTRING_NULL;
+    retval = UA_Server_saveNodestoreImage(restored, &image2);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(image.length, image2.length);
+    UA_ByteString_clear(&image2);
+
+    /* The DataSources of ns0 are set again */
+    UA_Variant v;
+    retval = UA_Server_readValue(restored, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME), &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DATETIME]));
+    UA_Variant_clear(&v);
+
+    /* The values stored in the nodes are restored */
+    retval = UA_Server_readValue(restored, UA_NODEID_NUMERIC(nsIndex, 3000), &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasArrayType(&v, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_uint_eq(v.arrayLength, ARRAYSIZE);
+    for(UA_Int32 i = 0; i < ARRAYSIZE; i++)
+        ck_assert_int_eq(((UA_Int32*)v.data)[i], i);
+    UA_Variant_clear(&v);
+    retval = UA_Server_readValue(restored, UA_NODEID_NUMERIC(nsIndex, 1001), &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)v.data == 21.5);
+    UA_Variant_clear(&v);
+
+    /* The other attributes are restored */
+    UA_LocalizedText dn;
+    retval = UA_Server_readDisplayName(restored, UA_NODEID_NUMERIC(nsIndex, 2000), &dn);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_LocalizedText expectedDn = UA_LOCALIZEDTEXT("en-US", "Device1");
+    ck_assert(UA_String_equal(&dn.text, &expectedDn.text));
+    ck_assert(UA_String_equal(&dn.locale, &expectedDn.locale));
+    UA_LocalizedText_clear(&dn);
+    UA_NodeId dataType;
+    retval = UA_Server_readDataType(restored, UA_NODEID_NUMERIC(nsIndex, 3000), &dataType);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&dataType, &UA_TYPES[UA_TYPES_INT32].typeId));
+
+    /* The restored type can be instantiated */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    retval = UA_Server_addObjectNode(restored, UA_NODEID_NUMERIC(nsIndex, 2001),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_QUALIFIEDNAME(nsIndex, "Device2"),
+                                     typeId, oAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe.targetName = UA_QUALIFIEDNAME(nsIndex, "Temperature");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = UA_NODEID_NUMERIC(nsIndex, 2001);
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(restored, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    retval = UA_Server_readValue(restored, bpr.targets[0].targetId.nodeId, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)v.data == 21.5);
+    UA_Variant_clear(&v);
+    UA_BrowsePathResult_clear(&bpr);
+
+#if defined(UA_ENABLE_METHODCALLS) && UA_MULTITHREADING >= 100
+    /* The method stays async */
+    UA_NodeId methodId = UA_NODEID_NUMERIC(nsIndex, 4000);
+    const UA_Node *method = UA_NODESTORE_GET(restored, &methodId);
+    ck_assert(method != NULL);
+    ck_assert(method->methodNode.async);
+    UA_NODESTORE_RELEASE(restored, method);
+#endif
+
+    /* The restored server starts up */
+    retval = UA_Server_run_startup(restored);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(restored, false);
+    UA_Server_run_shutdown(restored);
+
+    UA_Server_delete(restored);
+    UA_ByteString_clear(&image);
+}
+END_TEST
+
+START_TEST(loadInvalidImage) {
+    UA_ByteString image = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_Server_saveNodestoreImage(server, &image);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Truncated */
+    size_t length = image.length;
+    image.length = length / 2;
+    UA_Server *restored = newServerFromImage(&image);
+    ck_assert(restored == NULL);
+
+    /* Trailing bytes */
+    UA_ByteString longer;
+    retval = UA_ByteString_allocBuffer(&longer, length + 1);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memcpy(longer.data, image.data, length);
+    longer.data[length] = 0;
+    restored = newServerFromImage(&longer);
+    ck_assert(restored == NULL);
+    UA_ByteString_clear(&longer);
+
+    /* The complete image is accepted */
+    image.length = length;
+    restored = newServerFromImage(&image);
+    ck_assert(restored != NULL);
+    UA_Server_delete(restored);
+
+    /* Wrong magic number */
+    image.length = length;
+    image.data[0]++;
+    restored = newServerFromImage(&image);
+    ck_assert(restored == NULL);
+
+    UA_ByteString_clear(&image);
+}
+END_TEST
+
+START_TEST(loadSpeed) {
+    UA_ByteString image = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_Server_saveNodestoreImage(server, &image);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    clock_t begin = clock();
+    UA_Server *s = UA_Server_new();
+    ck_assert(s != NULL);
+    UA_ServerConfig_setDefault(UA_Server_getConfig(s));
+    addTypeAndNodes(s);
+    clock_t finish = clock();
+    UA_Server_delete(s);
+    printf("creating the nodes with AddNodes took %f s\n",
+           (double)(finish - begin) / CLOCKS_PER_SEC);
+
+    begin = clock();
+    s = newServerFromImage(&image);
+    finish = clock();
+    ck_assert(s != NULL);
+    UA_Server_delete(s);
+    printf("loading the nodestore image (%lu bytes) took %f s\n",
+           (long unsigned)image.length, (double)(finish - begin) / CLOCKS_PER_SEC);
+
+    UA_ByteString_clear(&image);
+}
+END_TEST
+
+static Suite * testSuite_nodestoreImage(void) {
+    Suite *s = suite_create("Nodestore Image");
+    TCase *tc = tcase_create("Save and Load");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, saveAndRestore);
+    tcase_add_test(tc, loadInvalidImage);
+    tcase_add_test(tc, loadSpeed);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_nodestoreImage();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
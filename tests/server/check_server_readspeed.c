@@ -81,9 +81,9 @@ START_TEST(readSpeed) {
         /* Set the NodeId */
         rvi.nodeId = readNodeIds[i % READNODES];
 
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         Service_Read(server, &server->adminSession, &request, &res);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
 
         UA_ReadResponse_deleteMembers(&res);
     }
@@ -161,9 +161,9 @@ START_TEST(readSpeedWithEncoding) {
         size_t offset = 0;
         retval |= UA_decodeBinary(&request_msg, &offset, &req, &UA_TYPES[UA_TYPES_READREQUEST], NULL);
 
-        UA_LOCK(server->serviceMutex);
+        UA_WRLOCK(server->serviceMutex);
         Service_Read(server, &server->adminSession, &req, &res);
-        UA_UNLOCK(server->serviceMutex);
+        UA_WRUNLOCK(server->serviceMutex);
 
         UA_Byte *rpos = response_msg.data;
         const UA_Byte *rend = &response_msg.data[response_msg.length];
@@ -189,6 +189,124 @@ START_TEST(readSpeedWithEncoding) {
 }
 END_TEST
 
+#define WAVEFORM_LENGTH 10000 /* Double array read without copying */
+
+START_TEST(readSpeedSharedArray) {
+    /* Add a large array variable. Its value is stored with
+     * UA_VARIANT_DATA_SHARED. */
+    UA_Double *waveform = (UA_Double*)
+        UA_Array_new(WAVEFORM_LENGTH, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_ptr_ne(waveform, NULL);
+    for(size_t i = 0; i < WAVEFORM_LENGTH; i++)
+        waveform[i] = (UA_Double)i;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setArray(&attr.value, waveform, WAVEFORM_LENGTH,
+                        &UA_TYPES[UA_TYPES_DOUBLE]);
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    UA_NodeId waveformId = UA_NODEID_STRING(1, "Waveform");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, waveformId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Waveform"),
+                                  UA_NODEID_NULL, attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    const UA_VariableNode *node = (const UA_VariableNode*)
+        UA_NODESTORE_GET(server, &waveformId);
+    ck_assert_ptr_ne(node, NULL);
+    ck_assert_int_eq(node->value.data.value.value.storageType, UA_VARIANT_DATA_SHARED);
+    const void *nodeData = node->value.data.value.value.data;
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
+
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = waveformId;
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = 1;
+    request.nodesToRead = &rvi;
+
+    /* The response references the value of the node */
+    UA_ReadResponse res;
+    UA_ReadResponse_init(&res);
+    UA_WRLOCK(server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &res);
+    UA_WRUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(res.resultsSize, 1);
+    ck_assert_ptr_eq(res.results[0].value.data, nodeData);
+
+    /* Overwrite the node value. The response keeps the old value alive. */
+    waveform[0] = -1.0;
+    retval = UA_Server_writeValue(server, waveformId, attr.value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(((UA_Double*)res.results[0].value.data)[0] == 0.0);
+    UA_ReadResponse_clear(&res);
+
+    /* The local read API returns a private copy that can be modified */
+    UA_Variant local;
+    retval = UA_Server_readValue(server, waveformId, &local);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(local.storageType, UA_VARIANT_DATA);
+    ck_assert(((UA_Double*)local.data)[0] == -1.0);
+    UA_Variant_clear(&local);
+
+    /* A write with an IndexRange keeps the node value shared */
+    UA_Double element = -5.0;
+    UA_WriteValue wv;
+    UA_WriteValue_init(&wv);
+    wv.nodeId = waveformId;
+    wv.attributeId = UA_ATTRIBUTEID_VALUE;
+    wv.indexRange = UA_STRING("5");
+    wv.value.hasValue = true;
+    UA_Variant_setArray(&wv.value.value, &element, 1, &UA_TYPES[UA_TYPES_DOUBLE]);
+    retval = UA_Server_write(server, &wv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    node = (const UA_VariableNode*)UA_NODESTORE_GET(server, &waveformId);
+    ck_assert_ptr_ne(node, NULL);
+    ck_assert_int_eq(node->value.data.value.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert(((UA_Double*)node->value.data.value.value.data)[5] == -5.0);
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
+
+    /* Read and encode the value. Compare with a deep copy of the value for
+     * every read. */
+    UA_ByteString response_msg;
+    retval = UA_ByteString_allocBuffer(&response_msg, 100 +
+                                       (WAVEFORM_LENGTH * sizeof(UA_Double)));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    clock_t durations[2];
+    for(size_t copy = 0; copy < 2; copy++) {
+        clock_t begin = clock();
+        for(size_t i = 0; i < READS; i++) {
+            UA_WRLOCK(server->serviceMutex);
+            Service_Read(server, &server->adminSession, &request, &res);
+            UA_WRUNLOCK(server->serviceMutex);
+            if(copy)
+                retval |= UA_Variant_unshare(&res.results[0].value);
+
+            UA_Byte *rpos = response_msg.data;
+            const UA_Byte *rend = &response_msg.data[response_msg.length];
+            retval |= UA_encodeBinary(&res, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                      &rpos, &rend, NULL, NULL);
+            UA_ReadResponse_clear(&res);
+        }
+        durations[copy] = clock() - begin;
+    }
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    printf("duration with a shared array was %f s\n",
+           (double)durations[0] / CLOCKS_PER_SEC);
+    printf("duration with a copied array was %f s\n",
+           (double)durations[1] / CLOCKS_PER_SEC);
+
+    UA_ByteString_clear(&response_msg);
+    UA_Array_delete(waveform, WAVEFORM_LENGTH, &UA_TYPES[UA_TYPES_DOUBLE]);
+}
+END_TEST
+
 static Suite * service_speed_suite (void) {
     Suite *s = suite_create ("Service Speed");
 
@@ -196,6 +314,7 @@ static Suite * service_speed_suite (void) {
     tcase_add_checked_fixture(tc_read, setup, teardown);
     tcase_add_test (tc_read, readSpeed);
     tcase_add_test (tc_read, readSpeedWithEncoding);
+    tcase_add_test (tc_read, readSpeedSharedArray);
     suite_add_tcase (s, tc_read);
 
     return s;
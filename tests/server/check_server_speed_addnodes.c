@@ -72,12 +72,206 @@ START_TEST(addVariable) {
 }
 END_TEST
 
+#define DEVICES 500
+#define DEVICE_PROPERTIES 10
+#define DEVICE_VARIABLES 28
+
+static UA_NodeId baseDeviceTypeId = {1, UA_NODEIDTYPE_NUMERIC, {1000}};
+static UA_NodeId deviceTypeId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+static void
+addMandatoryChild(UA_NodeClass nodeClass, const UA_NodeId parentId,
+                  const UA_NodeId refTypeId, const char *name, UA_NodeId *outId) {
+    UA_NodeId childId;
+    UA_StatusCode retval;
+    if(nodeClass == UA_NODECLASS_OBJECT) {
+        UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+        oattr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)name);
+        retval = UA_Server_addObjectNode(server, UA_NODEID_NULL, parentId, refTypeId,
+                                         UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                         oattr, NULL, &childId);
+    } else {
+        UA_VariableAttributes vattr = UA_VariableAttributes_default;
+        vattr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)name);
+        UA_Double value = 0.0;
+        UA_Variant_setScalar(&vattr.value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+        UA_NodeId typeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+        if(refTypeId.identifier.numeric == UA_NS0ID_HASPROPERTY)
+            typeId = UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE);
+        retval = UA_Server_addVariableNode(server, UA_NODEID_NULL, parentId, refTypeId,
+                                           UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                           typeId, vattr, NULL, &childId);
+    }
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(server, childId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    if(outId)
+        *outId = childId;
+    else
+        UA_NodeId_clear(&childId);
+}
+
+/* BaseDeviceType with properties and a status object. DeviceType adds
+ * variables and overrides the status object with an additional variable. */
+static void
+addDeviceTypes(void) {
+    UA_ObjectTypeAttributes tattr = UA_ObjectTypeAttributes_default;
+    tattr.displayName = UA_LOCALIZEDTEXT("", "BaseDeviceType");
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, baseDeviceTypeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "BaseDeviceType"), tattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    tattr.displayName = UA_LOCALIZEDTEXT("", "DeviceType");
+    retval = UA_Server_addObjectTypeNode(server, deviceTypeId, baseDeviceTypeId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(1, "DeviceType"), tattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    char name[32];
+    for(int i = 0; i < DEVICE_PROPERTIES; i++) {
+        UA_snprintf(name, sizeof(name), "Property%i", i);
+        addMandatoryChild(UA_NODECLASS_VARIABLE, baseDeviceTypeId,
+                          UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY), name, NULL);
+    }
+    UA_NodeId statusId;
+    addMandatoryChild(UA_NODECLASS_OBJECT, baseDeviceTypeId,
+                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), "Status", &statusId);
+    addMandatoryChild(UA_NODECLASS_VARIABLE, statusId,
+                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), "State", NULL);
+    UA_NodeId_clear(&statusId);
+
+    for(int i = 0; i < DEVICE_VARIABLES; i++) {
+        UA_snprintf(name, sizeof(name), "Variable%i", i);
+        addMandatoryChild(UA_NODECLASS_VARIABLE, deviceTypeId,
+                          UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), name, NULL);
+    }
+    addMandatoryChild(UA_NODECLASS_OBJECT, deviceTypeId,
+                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), "Status", &statusId);
+    addMandatoryChild(UA_NODECLASS_VARIABLE, statusId,
+                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), "ErrorCode", NULL);
+    UA_NodeId_clear(&statusId);
+}
+
+/* Count the nodes below the instance along the aggregates references */
+static size_t
+countChildren(const UA_NodeId nodeId) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_AGGREGATES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_NONE;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t count = br.referencesSize;
+    for(size_t i = 0; i < br.referencesSize; i++)
+        count += countChildren(br.references[i].nodeId.nodeId);
+    UA_BrowseResult_clear(&br);
+    return count;
+}
+
+START_TEST(instantiateDevices) {
+    addDeviceTypes();
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_NodeId deviceId = UA_NODEID_NULL;
+
+    clock_t begin = clock();
+    for(int i = 0; i < DEVICES; i++) {
+        UA_NodeId_clear(&deviceId);
+        UA_StatusCode retval =
+            UA_Server_addObjectNode(server, UA_NODEID_NULL, parentNodeId,
+                                    parentReferenceNodeId, UA_QUALIFIEDNAME(1, "Device"),
+                                    deviceTypeId, oattr, NULL, &deviceId);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    double timeSpent = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("%i device instances:\t Duration was %f s\n", DEVICES, timeSpent);
+
+    /* Properties, variables, the status object with its two variables */
+    ck_assert_uint_eq(countChildren(deviceId), DEVICE_PROPERTIES + DEVICE_VARIABLES + 3);
+    UA_NodeId_clear(&deviceId);
+}
+END_TEST
+
+START_TEST(instantiateDevicesBulk) {
+    addDeviceTypes();
+
+    UA_QualifiedName *names = (UA_QualifiedName*)
+        UA_malloc(sizeof(UA_QualifiedName) * DEVICES);
+    UA_NodeId *deviceIds = (UA_NodeId*)UA_Array_new(DEVICES, &UA_TYPES[UA_TYPES_NODEID]);
+    ck_assert_ptr_ne(names, NULL);
+    ck_assert_ptr_ne(deviceIds, NULL);
+    for(size_t i = 0; i < DEVICES; i++)
+        names[i] = UA_QUALIFIEDNAME(1, "Device");
+
+    clock_t begin = clock();
+    UA_StatusCode retval =
+        UA_Server_addObjectNodes(server, DEVICES, NULL,
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), names,
+                                 deviceTypeId, UA_ObjectAttributes_default, NULL, deviceIds);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    double timeSpent = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("%i device instances in bulk:\t Duration was %f s\n", DEVICES, timeSpent);
+
+    /* The instances have the same children as with UA_Server_addObjectNode */
+    ck_assert_uint_eq(countChildren(deviceIds[0]), DEVICE_PROPERTIES + DEVICE_VARIABLES + 3);
+    ck_assert_uint_eq(countChildren(deviceIds[DEVICES - 1]),
+                      DEVICE_PROPERTIES + DEVICE_VARIABLES + 3);
+
+    /* The overridden status object has the variables of both declarations */
+    UA_RelativePathElement rpe[2];
+    UA_RelativePathElement_init(&rpe[0]);
+    UA_RelativePathElement_init(&rpe[1]);
+    rpe[0].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe[0].targetName = UA_QUALIFIEDNAME(1, "Status");
+    rpe[1].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe[1].targetName = UA_QUALIFIEDNAME(1, "State");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = deviceIds[DEVICES - 1];
+    bp.relativePath.elementsSize = 2;
+    bp.relativePath.elements = rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* The instances are constructed and can be deleted */
+    UA_Boolean constructed = false;
+    for(size_t i = 0; i < DEVICES; i++) {
+        const UA_Node *node = UA_NODESTORE_GET(server, &deviceIds[i]);
+        ck_assert_ptr_ne(node, NULL);
+        constructed = node->head.constructed;
+        UA_NODESTORE_RELEASE(server, node);
+        ck_assert(constructed);
+    }
+    retval = UA_Server_deleteNode(server, deviceIds[0], true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_free(names);
+    UA_Array_delete(deviceIds, DEVICES, &UA_TYPES[UA_TYPES_NODEID]);
+}
+END_TEST
+
 static Suite * service_speed_suite (void) {
     Suite *s = suite_create ("Service Speed");
 
     TCase* tc_addnodes = tcase_create ("AddNodes");
     tcase_add_checked_fixture(tc_addnodes, setup, teardown);
     tcase_add_test(tc_addnodes, addVariable);
+    tcase_add_test(tc_addnodes, instantiateDevices);
+    tcase_add_test(tc_addnodes, instantiateDevicesBulk);
     suite_add_tcase(s, tc_addnodes);
 
     return s;
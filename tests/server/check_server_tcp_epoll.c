@@ -0,0 +1,322 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/accesscontrol_default.h>
+#include <open62541/server_config_default.h>
+#include <open62541/transport_generated.h>
+#include <open62541/transport_generated_encoding_binary.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define CLIENTS 32
+#define SOCKETS (FD_SETSIZE + 16) /* More than select can handle */
+#define PENDING 64 /* Less than the listen backlog */
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setBasics(config);
+    UA_ServerConfig_addNetworkLayerTCPEpoll(config, 4840, 0, 0);
+    UA_ServerConfig_addSecurityPolicyNone(config, NULL);
+    UA_AccessControl_default(config, true,
+                             &config->securityPolicies[0].policyUri, 0, NULL);
+    UA_ServerConfig_addAllEndpoints(config);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* The main loop is run by the test itself */
+static struct rlimit fdLimit;
+
+static void setupNoThread(void) {
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setBasics(config);
+    UA_ServerConfig_addNetworkLayerTCPEpoll(config, 4840, 0, 0);
+    UA_ServerConfig_addSecurityPolicyNone(config, NULL);
+    UA_ServerConfig_addAllEndpoints(config);
+    UA_Server_run_startup(server);
+    getrlimit(RLIMIT_NOFILE, &fdLimit);
+}
+
+static void teardownNoThread(void) {
+    setrlimit(RLIMIT_NOFILE, &fdLimit);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* Raw sockets are used for the connections. The client uses select and cannot
+ * handle descriptors beyond FD_SETSIZE. */
+static int
+connectSocket(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(4840);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void
+sendHello(int fd) {
+    UA_TcpHelloMessage hello;
+    memset(&hello, 0, sizeof(UA_TcpHelloMessage));
+    hello.receiveBufferSize = 65535;
+    hello.sendBufferSize = 65535;
+    hello.endpointUrl = UA_STRING("opc.tcp://localhost:4840");
+
+    UA_Byte buf[128];
+    UA_Byte *pos = &buf[8];
+    UA_StatusCode retval = UA_TcpHelloMessage_encodeBinary(&hello, &pos, &buf[128]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_TcpMessageHeader header;
+    header.messageTypeAndChunkType = UA_MESSAGETYPE_HEL + UA_CHUNKTYPE_FINAL;
+    header.messageSize = (UA_UInt32)(pos - buf);
+    pos = buf;
+    retval = UA_TcpMessageHeader_encodeBinary(&header, &pos, &buf[128]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(send(fd, buf, header.messageSize, 0),
+                     (ssize_t)header.messageSize);
+}
+
+/* Returns true if the beginning of an ACK message was received */
+static UA_Boolean
+receiveAck(int fd, int flags) {
+    char buf[4];
+    ssize_t len = recv(fd, buf, sizeof(buf), flags);
+    if(len < 3)
+        return false;
+    ck_assert(strncmp(buf, "ACK", 3) == 0);
+    return true;
+}
+
+START_TEST(Server_epoll_connect) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant val;
+    UA_Variant_init(&val);
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    retval = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+START_TEST(Server_epoll_manyClients) {
+    UA_Client *clients[CLIENTS];
+    for(size_t i = 0; i < CLIENTS; i++) {
+        clients[i] = UA_Client_new();
+        UA_ClientConfig_setDefault(UA_Client_getConfig(clients[i]));
+        UA_StatusCode retval =
+            UA_Client_connect(clients[i], "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* All connections are served while they stay open */
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    for(size_t i = 0; i < CLIENTS; i++) {
+        UA_Variant val;
+        UA_Variant_init(&val);
+        UA_StatusCode retval = UA_Client_readValueAttribute(clients[i], nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+
+    for(size_t i = 0; i < CLIENTS; i++) {
+        UA_Client_disconnect(clients[i]);
+        UA_Client_delete(clients[i]);
+    }
+}
+END_TEST
+
+/* The descriptors on both sides of the connections go beyond FD_SETSIZE */
+START_TEST(Server_epoll_beyondFdSetSize) {
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    rlim_t required = (2 * SOCKETS) + 64;
+    if(limit.rlim_cur < required) {
+        ck_assert(limit.rlim_max == RLIM_INFINITY || limit.rlim_max >= required);
+        limit.rlim_cur = required;
+        ck_assert_int_eq(setrlimit(RLIMIT_NOFILE, &limit), 0);
+    }
+
+    int *fds = (int*)UA_malloc(SOCKETS * sizeof(int));
+    ck_assert_ptr_ne(fds, NULL);
+    for(size_t i = 0; i < SOCKETS; i++) {
+        fds[i] = connectSocket();
+        ck_assert_int_ge(fds[i], 0);
+    }
+
+    /* The newest connection has the highest descriptor in the server */
+    struct timeval tv = {5, 0};
+    size_t check[2] = {SOCKETS - 1, 0};
+    for(size_t i = 0; i < 2; i++) {
+        int fd = fds[check[i]];
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sendHello(fd);
+        ck_assert(receiveAck(fd, 0));
+    }
+
+    for(size_t i = 0; i < SOCKETS; i++)
+        close(fds[i]);
+    UA_free(fds);
+}
+END_TEST
+
+/* The server runs out of descriptors with connections pending. It waits instead
+ * of spinning on the server socket. Accepting resumes when a connection is
+ * closed. */
+START_TEST(Server_epoll_outOfDescriptors) {
+    int fds[PENDING];
+    for(size_t i = 0; i < PENDING; i++) {
+        fds[i] = connectSocket();
+        ck_assert_int_ge(fds[i], 0);
+    }
+
+    /* Leave room for a few connections only. RLIMIT_NOFILE limits the number
+     * of the next descriptor. */
+    int lowest = dup(0);
+    ck_assert_int_ge(lowest, 0);
+    close(lowest);
+    struct rlimit limit = fdLimit;
+    limit.rlim_cur = (rlim_t)lowest + 8;
+    ck_assert_int_eq(setrlimit(RLIMIT_NOFILE, &limit), 0);
+
+    /* The main loop waits for its timeout (up to 50ms) and is not woken up by
+     * the pending connections */
+    UA_Server_run_iterate(server, true);
+    double start = UA_realTime();
+    for(size_t i = 0; i < 5; i++)
+        UA_Server_run_iterate(server, true);
+    ck_assert(UA_realTime() - start > 0.1);
+
+    /* Closing an accepted connection resumes accepting. The connections are
+     * accepted in order. */
+    setrlimit(RLIMIT_NOFILE, &fdLimit);
+    close(fds[0]);
+    int last = fds[PENDING - 1];
+    sendHello(last);
+    UA_Boolean acked = false;
+    for(size_t i = 0; i < 100 && !acked; i++) {
+        UA_Server_run_iterate(server, false);
+        acked = receiveAck(last, MSG_DONTWAIT);
+    }
+    ck_assert(acked);
+
+    for(size_t i = 1; i < PENDING; i++)
+        close(fds[i]);
+}
+END_TEST
+
+static size_t watchedCount;
+
+static void
+readWatched(UA_Server *s, void *context) {
+    char c;
+    ck_assert_int_eq(recv(*(int*)context, &c, 1, MSG_DONTWAIT), 1);
+    watchedCount++;
+}
+
+/* A watched socket wakes up the main loop when it is readable */
+START_TEST(Server_epoll_watchSocket) {
+    int sv[2];
+    ck_assert_int_eq(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv), 0);
+    UA_ServerNetworkLayer *nl = &UA_Server_getConfig(server)->networkLayers[0];
+    ck_assert_uint_eq(nl->watchSocket(nl, sv[0], readWatched, &sv[0]),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(nl->watchSocket(nl, sv[0], readWatched, &sv[0]),
+                      UA_STATUSCODE_BADENTRYEXISTS);
+
+    watchedCount = 0;
+    char c = 0;
+    for(size_t i = 1; i <= 3; i++) {
+        ck_assert_int_eq(send(sv[1], &c, 1, 0), 1);
+        double start = UA_realTime();
+        UA_Server_run_iterate(server, true);
+        ck_assert_uint_eq(watchedCount, i);
+        ck_assert(UA_realTime() - start < 0.04); /* Before the timeout */
+    }
+
+    /* No longer notified */
+    nl->unwatchSocket(nl, sv[0]);
+    ck_assert_int_eq(send(sv[1], &c, 1, 0), 1);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(watchedCount, 3);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+END_TEST
+
+static Suite* testSuite_Server_epoll(void) {
+    Suite *s = suite_create("Server TCP Epoll");
+    TCase *tc_epoll = tcase_create("Connect");
+    tcase_add_checked_fixture(tc_epoll, setup, teardown);
+    tcase_add_test(tc_epoll, Server_epoll_connect);
+    tcase_add_test(tc_epoll, Server_epoll_manyClients);
+    tcase_add_test(tc_epoll, Server_epoll_beyondFdSetSize);
+    suite_add_tcase(s, tc_epoll);
+
+    TCase *tc_limit = tcase_create("Descriptor limit");
+    tcase_add_checked_fixture(tc_limit, setupNoThread, teardownNoThread);
+    tcase_add_test(tc_limit, Server_epoll_outOfDescriptors);
+    tcase_add_test(tc_limit, Server_epoll_watchSocket);
+    suite_add_tcase(s, tc_limit);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_Server_epoll();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
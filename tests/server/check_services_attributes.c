@@ -209,6 +209,79 @@ START_TEST(ReadSingleDataSourceAttributeValueEmptyWithoutTimestamp) {
     ck_assert_int_eq(UA_STATUSCODE_GOOD, ret);
 } END_TEST
 
+#define SHAREDARRAY_LENGTH 512 /* Large enough to be shared */
+
+static UA_VariantStorageType sharedCallbackStorage;
+static UA_VariantStorageType sharedCopyStorage;
+
+/* The value in the callback is shared and read-only. A copy can be modified
+ * after it was unshared. */
+static void
+readSharedArray(UA_Server *server_, const UA_NodeId *sessionId, void *sessionContext,
+                const UA_NodeId *nodeid, void *nodeContext,
+                const UA_NumericRange *range, const UA_DataValue *data) {
+    sharedCallbackStorage = data->value.storageType;
+    UA_Variant copy;
+    UA_StatusCode retval = UA_Variant_copy(&data->value, &copy);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sharedCopyStorage = copy.storageType;
+    retval = UA_Variant_unshare(&copy);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copy.storageType, UA_VARIANT_DATA);
+    ((UA_UInt32*)copy.data)[0] = 1;
+    UA_Variant_clear(&copy);
+}
+
+START_TEST(ReadSharedArrayValue) {
+    UA_UInt32 array[SHAREDARRAY_LENGTH];
+    for(size_t i = 0; i < SHAREDARRAY_LENGTH; i++)
+        array[i] = (UA_UInt32)i;
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.valueRank = UA_VALUERANK_ANY;
+    UA_Variant_setArray(&vattr.value, array, SHAREDARRAY_LENGTH, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "shared.array");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "shared array"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_ValueCallback callback;
+    callback.onRead = readSharedArray;
+    callback.onWrite = NULL;
+    retval = UA_Server_setVariableNode_valueCallback(server, nodeId, callback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The returned value is a private copy */
+    UA_Variant value;
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(sharedCallbackStorage, UA_VARIANT_DATA_SHARED);
+    ck_assert_int_eq(sharedCopyStorage, UA_VARIANT_DATA_SHARED);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA);
+    ck_assert_uint_eq(value.arrayLength, SHAREDARRAY_LENGTH);
+    ((UA_UInt32*)value.data)[0] = 2;
+    UA_Variant_clear(&value);
+
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = nodeId;
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue resp = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert(resp.hasValue);
+    ck_assert_int_eq(resp.value.storageType, UA_VARIANT_DATA);
+    ((UA_UInt32*)resp.value.data)[1] = 2;
+    UA_DataValue_clear(&resp);
+
+    /* The node value was not modified */
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < SHAREDARRAY_LENGTH; i++)
+        ck_assert_uint_eq(((UA_UInt32*)value.data)[i], i);
+    UA_Variant_clear(&value);
+} END_TEST
+
 START_TEST(ReadSingleAttributeValueRangeWithoutTimestamp) {
     UA_ReadValueId rvi;
     UA_ReadValueId_init(&rvi);
@@ -929,6 +1002,7 @@ static Suite * testSuite_services_attributes(void) {
     TCase *tc_readSingleAttributes = tcase_create("readSingleAttributes");
     tcase_add_checked_fixture(tc_readSingleAttributes, setup, teardown);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeValueWithoutTimestamp);
+    tcase_add_test(tc_readSingleAttributes, ReadSharedArrayValue);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeValueRangeWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeNodeIdWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeNodeClassWithoutTimestamp);
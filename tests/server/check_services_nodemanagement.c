@@ -563,6 +563,332 @@ START_TEST(InstantiateObjectType) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+static UA_Boolean
+hasComponent(const UA_NodeId nodeId, char *name) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe.targetName = UA_QUALIFIEDNAME(1, name);
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = nodeId;
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    UA_Boolean found = (bpr.statusCode == UA_STATUSCODE_GOOD && bpr.targetsSize == 1);
+    UA_BrowsePathResult_clear(&bpr);
+    return found;
+}
+
+static UA_NodeId
+addMandatoryVariable(const UA_NodeId parentId, char *name) {
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_NodeId outNodeId;
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_NULL, parentId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                  UA_QUALIFIEDNAME(1, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vAttr, NULL, &outNodeId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+    retval = UA_Server_addReference(server, outNodeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+#endif
+    return outNodeId;
+}
+
+static UA_NodeId
+addInstance(const UA_NodeId typeId, char *name) {
+    UA_NodeId outNodeId;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, name), typeId,
+                                UA_ObjectAttributes_default, NULL, &outNodeId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    return outNodeId;
+}
+
+/* The children of a type are cached for the instantiation. Changes of the type
+ * are visible for the following instances. */
+START_TEST(InstantiateObjectTypeAfterTypeChange) {
+    UA_NodeId typeId = UA_NODEID_NUMERIC(1, 2000);
+    UA_ObjectTypeAttributes tAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, typeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "ChangingType"), tAttr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId firstId = addMandatoryVariable(typeId, "First");
+
+    UA_NodeId instance1 = addInstance(typeId, "Instance1");
+    ck_assert(hasComponent(instance1, "First"));
+
+    /* Add a child to the type */
+    UA_NodeId secondId = addMandatoryVariable(typeId, "Second");
+    UA_NodeId instance2 = addInstance(typeId, "Instance2");
+    ck_assert(hasComponent(instance2, "First"));
+    ck_assert(hasComponent(instance2, "Second"));
+    ck_assert(!hasComponent(instance1, "Second"));
+
+    /* Remove a child from the type */
+    retval = UA_Server_deleteNode(server, firstId, true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId instance3 = addInstance(typeId, "Instance3");
+    ck_assert(!hasComponent(instance3, "First"));
+    ck_assert(hasComponent(instance3, "Second"));
+
+    /* Add a child to the declaration of a child */
+    addMandatoryVariable(secondId, "Nested");
+    UA_NodeId instance4 = addInstance(typeId, "Instance4");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    UA_RelativePathElement rpe[2];
+    UA_RelativePathElement_init(&rpe[0]);
+    UA_RelativePathElement_init(&rpe[1]);
+    rpe[0].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe[0].targetName = UA_QUALIFIEDNAME(1, "Second");
+    rpe[1].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe[1].targetName = UA_QUALIFIEDNAME(1, "Nested");
+    bp.startingNode = instance4;
+    bp.relativePath.elementsSize = 2;
+    bp.relativePath.elements = rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_BrowsePathResult_clear(&bpr);
+
+    UA_NodeId_clear(&firstId);
+    UA_NodeId_clear(&secondId);
+    UA_NodeId_clear(&instance1);
+    UA_NodeId_clear(&instance2);
+    UA_NodeId_clear(&instance3);
+    UA_NodeId_clear(&instance4);
+} END_TEST
+
+/* The new instances add HasTypeDefinition references. This does not drop the
+ * plans. Changing the TypeDefinition of a child declaration does. */
+START_TEST(InstantiateObjectTypeReusesPlan) {
+    UA_NodeId typeId = UA_NODEID_NUMERIC(1, 2004);
+    UA_ObjectTypeAttributes tAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, typeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "PlannedType"), tAttr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId childId = addMandatoryVariable(typeId, "Child");
+    UA_NodeId instance1 = addInstance(typeId, "PlannedInstance1");
+
+    /* Hold the plan. It stays in the tree if it is reused. */
+    UA_InstantiationPlan *plan = ZIP_ROOT(&server->instantiationPlans);
+    ck_assert_ptr_ne(plan, NULL);
+    plan->refCount++;
+    UA_NodeId instance2 = addInstance(typeId, "PlannedInstance2");
+    ck_assert_ptr_eq(ZIP_ROOT(&server->instantiationPlans), plan);
+    plan->refCount--;
+
+    /* Change the TypeDefinition of the child declaration */
+    retval = UA_Server_deleteReference(server, childId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION),
+                                       true, UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(ZIP_ROOT(&server->instantiationPlans), NULL);
+
+    UA_NodeId_clear(&childId);
+    UA_NodeId_clear(&instance1);
+    UA_NodeId_clear(&instance2);
+} END_TEST
+
+static UA_NodeId deniedBrowseNode;
+
+static UA_Boolean
+denyBrowseNode(UA_Server *server_, UA_AccessControl *ac,
+               const UA_NodeId *sessionId, void *sessionContext,
+               const UA_NodeId *nodeId, void *nodeContext) {
+    return !UA_NodeId_equal(nodeId, &deniedBrowseNode);
+}
+
+/* The cached children of a type are only copied if the session may browse the
+ * type. Like for the browsed children, the instance is added without them. */
+START_TEST(InstantiateObjectTypeWithoutBrowseAccess) {
+    UA_NodeId typeId = UA_NODEID_NUMERIC(1, 2003);
+    UA_ObjectTypeAttributes tAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, typeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "HiddenType"), tAttr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId childId = addMandatoryVariable(typeId, "Hidden");
+    UA_NodeId_clear(&childId);
+
+    /* The admin session instantiates the type first */
+    UA_NodeId instance = addInstance(typeId, "AdminInstance");
+    ck_assert(hasComponent(instance, "Hidden"));
+    UA_NodeId_clear(&instance);
+
+    /* The session must not browse the type */
+    deniedBrowseNode = typeId;
+    UA_Server_getConfig(server)->accessControl.allowBrowseNode = denyBrowseNode;
+    UA_Session session;
+    UA_Session_init(&session);
+
+    UA_AddNodesItem item;
+    UA_AddNodesItem_init(&item);
+    item.parentNodeId.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    item.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    item.browseName = UA_QUALIFIEDNAME(1, "SessionInstance");
+    item.nodeClass = UA_NODECLASS_OBJECT;
+    item.typeDefinition.nodeId = typeId;
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    item.nodeAttributes.encoding = UA_EXTENSIONOBJECT_DECODED_NODELETE;
+    item.nodeAttributes.content.decoded.type = &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES];
+    item.nodeAttributes.content.decoded.data = &oAttr;
+    UA_AddNodesRequest request;
+    UA_AddNodesRequest_init(&request);
+    request.nodesToAdd = &item;
+    request.nodesToAddSize = 1;
+    UA_AddNodesResponse response;
+    UA_AddNodesResponse_init(&response);
+    UA_WRLOCK(server->serviceMutex);
+    Service_AddNodes(server, &session, &request, &response);
+    UA_Session_deleteMembersCleanup(&session, server);
+    UA_WRUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert(!hasComponent(response.results[0].addedNodeId, "Hidden"));
+    UA_AddNodesResponse_clear(&response);
+} END_TEST
+
+static UA_UInt32 typeConstructorCalled = 0;
+
+static UA_StatusCode
+countingConstructor(UA_Server *server_,
+                    const UA_NodeId *sessionId, void *sessionContext,
+                    const UA_NodeId *typeId, void *typeContext,
+                    const UA_NodeId *nodeId, void **nodeContext) {
+    typeConstructorCalled++;
+    return UA_STATUSCODE_GOOD;
+}
+
+START_TEST(AddObjectNodes) {
+    UA_NodeId typeId = UA_NODEID_NUMERIC(1, 2001);
+    UA_ObjectTypeAttributes tAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, typeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "BulkType"), tAttr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId speedId = addMandatoryVariable(typeId, "Speed");
+    UA_NodeId_clear(&speedId);
+
+    UA_NodeTypeLifecycle lifecycle;
+    lifecycle.constructor = countingConstructor;
+    lifecycle.destructor = NULL;
+    retval = UA_Server_setNodeTypeLifecycle(server, typeId, lifecycle);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_QualifiedName names[3] = {UA_QUALIFIEDNAME(1, "Bulk1"), UA_QUALIFIEDNAME(1, "Bulk2"),
+                                 UA_QUALIFIEDNAME(1, "Bulk3")};
+    UA_NodeId requested[3] = {UA_NODEID_NUMERIC(1, 3001), UA_NODEID_NUMERIC(1, 3002),
+                              UA_NODEID_NUMERIC(1, 3003)};
+    void *contexts[3] = {(void*)1, (void*)2, (void*)3};
+    UA_NodeId ids[3];
+    handleCalled = 0;
+    typeConstructorCalled = 0;
+    retval = UA_Server_addObjectNodes(server, 3, requested,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), names,
+                                      typeId, UA_ObjectAttributes_default, contexts, ids);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The instances and their variables are constructed */
+    ck_assert_uint_eq(typeConstructorCalled, 3);
+    ck_assert_int_eq(handleCalled, 6);
+    for(size_t i = 0; i < 3; i++) {
+        ck_assert(UA_NodeId_equal(&ids[i], &requested[i]));
+        ck_assert(hasComponent(ids[i], "Speed"));
+        void *context = NULL;
+        retval = UA_Server_getNodeContext(server, ids[i], &context);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_ptr_eq(context, contexts[i]);
+
+        UA_LocalizedText displayName;
+        retval = UA_Server_readDisplayName(server, ids[i], &displayName);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(UA_String_equal(&displayName.text, &names[i].name));
+        UA_LocalizedText_clear(&displayName);
+    }
+
+    /* The instances are referenced from the parent and the type */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = typeId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION);
+    bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 3);
+    UA_BrowseResult_clear(&br);
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    rpe.targetName = names[2];
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    ck_assert(UA_NodeId_equal(&bpr.targets[0].targetId.nodeId, &ids[2]));
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* Either all instances are added or none. The second NodeId exists. */
+    UA_NodeId requested2[2] = {UA_NODEID_NUMERIC(1, 3004), UA_NODEID_NUMERIC(1, 3001)};
+    retval = UA_Server_addObjectNodes(server, 2, requested2,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), names,
+                                      typeId, UA_ObjectAttributes_default, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADNODEIDEXISTS);
+    UA_NodeClass nodeClass;
+    retval = UA_Server_readNodeClass(server, requested2[0], &nodeClass);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Abstract types cannot be instantiated in bulk */
+    UA_NodeId abstractTypeId = UA_NODEID_NUMERIC(1, 2002);
+    tAttr.isAbstract = true;
+    retval = UA_Server_addObjectTypeNode(server, abstractTypeId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(1, "AbstractType"), tAttr,
+                                         NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addObjectNodes(server, 1, NULL,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), names,
+                                      abstractTypeId, UA_ObjectAttributes_default,
+                                      NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADTYPEDEFINITIONINVALID);
+
+    for(size_t i = 0; i < 3; i++) {
+        retval = UA_Server_deleteNode(server, ids[i], true);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        UA_NodeId_clear(&ids[i]);
+    }
+} END_TEST
+
 static UA_NodeId
 findReference(const UA_NodeId sourceId, const UA_NodeId refTypeId) {
 	UA_BrowseDescription * bDesc = UA_BrowseDescription_new();
@@ -669,6 +995,10 @@ int main(void) {
     tcase_add_test(tc_addnodes, AddNodeTwiceGivesError);
     tcase_add_test(tc_addnodes, AddObjectWithConstructor);
     tcase_add_test(tc_addnodes, InstantiateObjectType);
+    tcase_add_test(tc_addnodes, InstantiateObjectTypeAfterTypeChange);
+    tcase_add_test(tc_addnodes, InstantiateObjectTypeReusesPlan);
+    tcase_add_test(tc_addnodes, InstantiateObjectTypeWithoutBrowseAccess);
+    tcase_add_test(tc_addnodes, AddObjectNodes);
     suite_add_tcase(s, tc_addnodes);
 
     TCase *tc_deletenodes = tcase_create("deletenodes");
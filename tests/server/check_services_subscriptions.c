@@ -33,9 +33,9 @@ createSession(void) {
     UA_CreateSessionRequest request;
     UA_CreateSessionRequest_init(&request);
     request.requestedSessionTimeout = UA_UINT32_MAX;
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     UA_StatusCode retval = UA_Server_createSession(server, NULL, &request, &session);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(retval, 0);
 }
 
@@ -68,9 +68,9 @@ createSubscription(void) {
     UA_CreateSubscriptionResponse response;
     UA_CreateSubscriptionResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     subscriptionId = response.subscriptionId;
 
@@ -101,9 +101,9 @@ createMonitoredItem(void) {
     UA_CreateMonitoredItemsResponse response;
     UA_CreateMonitoredItemsResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateMonitoredItems(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
     ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -123,9 +123,9 @@ START_TEST(Server_createSubscription) {
 
     UA_CreateSubscriptionResponse response;
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     subscriptionId = response.subscriptionId;
 
@@ -151,9 +151,9 @@ START_TEST(Server_modifySubscription) {
     UA_ModifySubscriptionResponse response;
     UA_ModifySubscriptionResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_ModifySubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
 
     UA_ModifySubscriptionResponse_deleteMembers(&response);
@@ -172,9 +172,9 @@ START_TEST(Server_setPublishingMode) {
     UA_SetPublishingModeResponse response;
     UA_SetPublishingModeResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_SetPublishingMode(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
 
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
@@ -195,9 +195,9 @@ START_TEST(Server_republish) {
     UA_RepublishResponse response;
     UA_RepublishResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_Republish(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_BADMESSAGENOTAVAILABLE);
 
     UA_RepublishResponse_deleteMembers(&response);
@@ -214,9 +214,9 @@ START_TEST(Server_republish_invalid) {
     UA_RepublishResponse response;
     UA_RepublishResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_Republish(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID);
 
     UA_RepublishResponse_deleteMembers(&response);
@@ -235,9 +235,9 @@ START_TEST(Server_deleteSubscription) {
     UA_DeleteSubscriptionsResponse del_response;
     UA_DeleteSubscriptionsResponse_init(&del_response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_DeleteSubscriptions(server, session, &del_request, &del_response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(del_response.resultsSize, 1);
     ck_assert_uint_eq(del_response.results[0], UA_STATUSCODE_GOOD);
 
@@ -253,9 +253,9 @@ START_TEST(Server_publishCallback) {
     UA_CreateSubscriptionRequest_init(&request);
     request.publishingEnabled = true;
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     UA_UInt32 subscriptionId1 = response.subscriptionId;
     UA_CreateSubscriptionResponse_deleteMembers(&response);
@@ -264,9 +264,9 @@ START_TEST(Server_publishCallback) {
     UA_CreateSubscriptionRequest_init(&request);
     request.publishingEnabled = true;
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     UA_UInt32 subscriptionId2 = response.subscriptionId;
     UA_Double publishingInterval = response.revisedPublishingInterval;
@@ -298,9 +298,9 @@ START_TEST(Server_publishCallback) {
     UA_DeleteSubscriptionsResponse del_response;
     UA_DeleteSubscriptionsResponse_init(&del_response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_DeleteSubscriptions(server, session, &del_request, &del_response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(del_response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(del_response.resultsSize, 2);
     ck_assert_uint_eq(del_response.results[0], UA_STATUSCODE_GOOD);
@@ -341,9 +341,9 @@ START_TEST(Server_modifyMonitoredItems) {
     UA_ModifyMonitoredItemsResponse response;
     UA_ModifyMonitoredItemsResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_ModifyMonitoredItems(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
     ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -353,6 +353,23 @@ START_TEST(Server_modifyMonitoredItems) {
 }
 END_TEST
 
+/* All queued notifications are taken from the preallocated pool */
+static void
+checkNotificationPool(UA_MonitoredItem *mon) {
+    ck_assert_uint_eq(mon->notificationPoolSize, mon->maxQueueSize + 2);
+    UA_Notification *notification;
+    TAILQ_FOREACH(notification, &mon->queue, listEntry) {
+        ck_assert((uintptr_t)notification >= (uintptr_t)mon->notificationPool);
+        ck_assert((uintptr_t)notification <
+                  (uintptr_t)&mon->notificationPool[mon->notificationPoolSize]);
+    }
+    size_t freeNotifications = 0;
+    for(notification = mon->freeNotifications; notification;
+        notification = TAILQ_NEXT(notification, listEntry))
+        freeNotifications++;
+    ck_assert_uint_eq(freeNotifications + mon->queueSize, mon->notificationPoolSize);
+}
+
 START_TEST(Server_overflow) {
     /* Create a subscription */
     UA_CreateSubscriptionRequest createSubscriptionRequest;
@@ -361,9 +378,9 @@ START_TEST(Server_overflow) {
     UA_CreateSubscriptionRequest_init(&createSubscriptionRequest);
     createSubscriptionRequest.publishingEnabled = true;
     UA_CreateSubscriptionResponse_init(&createSubscriptionResponse);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &createSubscriptionRequest, &createSubscriptionResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(createSubscriptionResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     UA_UInt32 localSubscriptionId = createSubscriptionResponse.subscriptionId;
     UA_Double publishingInterval = createSubscriptionResponse.revisedPublishingInterval;
@@ -395,9 +412,9 @@ START_TEST(Server_overflow) {
     UA_CreateMonitoredItemsResponse createMonitoredItemsResponse;
     UA_CreateMonitoredItemsResponse_init(&createMonitoredItemsResponse);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateMonitoredItems(server, session, &createMonitoredItemsRequest, &createMonitoredItemsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(createMonitoredItemsResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(createMonitoredItemsResponse.resultsSize, 1);
     ck_assert_uint_eq(createMonitoredItemsResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -445,6 +462,8 @@ START_TEST(Server_overflow) {
     ck_assert_uint_eq(notification->data.dataChange.value.status,
                       UA_STATUSCODE_INFOTYPE_DATAVALUE | UA_STATUSCODE_INFOBITS_OVERFLOW);
 
+    checkNotificationPool(mon);
+
     /* Remove status for next test */
     notification->data.dataChange.value.hasStatus = false;
     notification->data.dataChange.value.status = 0;
@@ -467,10 +486,10 @@ START_TEST(Server_overflow) {
     UA_ModifyMonitoredItemsResponse modifyMonitoredItemsResponse;
     UA_ModifyMonitoredItemsResponse_init(&modifyMonitoredItemsResponse);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_ModifyMonitoredItems(server, session, &modifyMonitoredItemsRequest,
                                  &modifyMonitoredItemsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.resultsSize, 1);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -480,6 +499,7 @@ START_TEST(Server_overflow) {
 
     ck_assert_uint_eq(mon->queueSize, 2); 
     ck_assert_uint_eq(mon->maxQueueSize, 2); 
+    checkNotificationPool(mon);
     notification = TAILQ_FIRST(&mon->queue);
     ck_assert_uint_eq(notification->data.dataChange.value.hasStatus, true);
     ck_assert_uint_eq(notification->data.dataChange.value.status,
@@ -499,10 +519,10 @@ START_TEST(Server_overflow) {
 
     UA_ModifyMonitoredItemsResponse_init(&modifyMonitoredItemsResponse);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_ModifyMonitoredItems(server, session, &modifyMonitoredItemsRequest,
                                  &modifyMonitoredItemsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.resultsSize, 1);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -512,6 +532,7 @@ START_TEST(Server_overflow) {
 
     ck_assert_uint_eq(mon->queueSize, 1); 
     ck_assert_uint_eq(mon->maxQueueSize, 1); 
+    checkNotificationPool(mon);
     notification = TAILQ_LAST(&mon->queue, NotificationQueue);
     ck_assert_uint_eq(notification->data.dataChange.value.hasStatus, false);
 
@@ -530,10 +551,10 @@ START_TEST(Server_overflow) {
 
     UA_ModifyMonitoredItemsResponse_init(&modifyMonitoredItemsResponse);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_ModifyMonitoredItems(server, session, &modifyMonitoredItemsRequest,
                                  &modifyMonitoredItemsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.resultsSize, 1);
     ck_assert_uint_eq(modifyMonitoredItemsResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -557,10 +578,10 @@ START_TEST(Server_overflow) {
     UA_DeleteSubscriptionsResponse deleteSubscriptionsResponse;
     UA_DeleteSubscriptionsResponse_init(&deleteSubscriptionsResponse);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_DeleteSubscriptions(server, session, &deleteSubscriptionsRequest,
                                 &deleteSubscriptionsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(deleteSubscriptionsResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(deleteSubscriptionsResponse.resultsSize, 1);
     ck_assert_uint_eq(deleteSubscriptionsResponse.results[0], UA_STATUSCODE_GOOD);
@@ -584,9 +605,9 @@ START_TEST(Server_setMonitoringMode) {
     UA_SetMonitoringModeResponse response;
     UA_SetMonitoringModeResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_SetMonitoringMode(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
     ck_assert_uint_eq(response.results[0], UA_STATUSCODE_GOOD);
@@ -608,9 +629,9 @@ START_TEST(Server_deleteMonitoredItems) {
     UA_DeleteMonitoredItemsResponse response;
     UA_DeleteMonitoredItemsResponse_init(&response);
 
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_DeleteMonitoredItems(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
     ck_assert_uint_eq(response.results[0], UA_STATUSCODE_GOOD);
@@ -629,9 +650,9 @@ START_TEST(Server_lifeTimeCount) {
     request.requestedLifetimeCount = 3;
     request.requestedMaxKeepAliveCount = 1;
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.revisedMaxKeepAliveCount, 1);
     ck_assert_uint_eq(response.revisedLifetimeCount, 3);
@@ -643,9 +664,9 @@ START_TEST(Server_lifeTimeCount) {
     request.requestedLifetimeCount = 4;
     request.requestedMaxKeepAliveCount = 2;
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.revisedMaxKeepAliveCount, 2);
     /* revisedLifetimeCount is revised to 3*MaxKeepAliveCount == 3 */
@@ -678,9 +699,9 @@ START_TEST(Server_lifeTimeCount) {
 
     UA_CreateMonitoredItemsResponse mresponse;
     UA_CreateMonitoredItemsResponse_init(&mresponse);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateMonitoredItems(server, session, &mrequest, &mresponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(mresponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(mresponse.resultsSize, 1);
     ck_assert_uint_eq(mresponse.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -794,9 +815,9 @@ START_TEST(Server_invalidPublishingInterval) {
     request.publishingEnabled = true;
     request.requestedPublishingInterval = -5.0; // Must be positive
     UA_CreateSubscriptionResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateSubscription(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert(response.revisedPublishingInterval ==
               server->config.publishingIntervalLimits.min);
@@ -834,9 +855,9 @@ START_TEST(Server_invalidSamplingInterval) {
 
     UA_CreateMonitoredItemsResponse response;
     UA_CreateMonitoredItemsResponse_init(&response);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_CreateMonitoredItems(server, session, &request, &response);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(response.resultsSize, 1);
     ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
@@ -850,6 +871,189 @@ START_TEST(Server_invalidSamplingInterval) {
 }
 END_TEST
 
+static UA_UInt32 counterReads = 0;
+static UA_NodeId counterSession; /* The session of the last read */
+
+static UA_StatusCode
+readCounter(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+            const UA_NumericRange *range, UA_DataValue *value) {
+    counterReads++;
+    UA_NodeId_clear(&counterSession);
+    UA_NodeId_copy(sessionId, &counterSession);
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &counterReads,
+                                    &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static UA_MonitoredItem *
+createCounterMonitoredItem(UA_UInt32 subId, UA_Double deadband) {
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_STRING(1, "counter");
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.samplingInterval = 100.0;
+    item.requestedParameters.queueSize = 10;
+    UA_DataChangeFilter filter;
+    UA_DataChangeFilter_init(&filter);
+    if(deadband > 0.0) {
+        filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+        filter.deadbandType = UA_DEADBANDTYPE_ABSOLUTE;
+        filter.deadbandValue = deadband;
+        item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+        item.requestedParameters.filter.content.decoded.type =
+            &UA_TYPES[UA_TYPES_DATACHANGEFILTER];
+        item.requestedParameters.filter.content.decoded.data = &filter;
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.itemsToCreateSize = 1;
+    request.itemsToCreate = &item;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_WRLOCK(server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_WRUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subId);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_MonitoredItem *mon =
+        UA_Subscription_getMonitoredItem(sub, response.results[0].monitoredItemId);
+    ck_assert_ptr_ne(mon, NULL);
+    UA_CreateMonitoredItemsResponse_clear(&response);
+    return mon;
+}
+
+/* MonitoredItems on the same node with the same sampling interval share a
+ * sampler. The value is read once. The filter applies per MonitoredItem. */
+START_TEST(Server_sharedSampling) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Counter");
+    UA_DataSource ds;
+    ds.read = readCounter;
+    ds.write = NULL;
+    UA_StatusCode res =
+        UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, "counter"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "Counter"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                            attr, ds, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    createSubscription();
+
+    /* Every MonitoredItem is sampled individually when it is created */
+    UA_MonitoredItem *mon1 = createCounterMonitoredItem(subscriptionId, 0.0);
+    UA_MonitoredItem *mon2 = createCounterMonitoredItem(subscriptionId, 0.0);
+    UA_MonitoredItem *mon3 = createCounterMonitoredItem(subscriptionId, 5.0);
+    UA_UInt32 reads = counterReads;
+    ck_assert_ptr_ne(mon1->sampler, NULL);
+    ck_assert_ptr_eq(mon1->sampler, mon2->sampler);
+    ck_assert_ptr_eq(mon1->sampler, mon3->sampler);
+    ck_assert_uint_eq(mon1->sampler->monitoredItemsSize, 3);
+
+    /* One read for all MonitoredItems. The value changed by less than the
+     * deadband of the third MonitoredItem. */
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+#if UA_MULTITHREADING >= 200
+    /* The sampler runs in a worker thread. Wait until it has released the
+     * service lock. */
+    for(size_t i = 0; i < 1000 && mon1->queueSize < 2; i++)
+        UA_realSleep(1);
+    UA_WRLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
+#endif
+    ck_assert_uint_eq(counterReads, reads + 1);
+    ck_assert_uint_eq(mon1->queueSize, 2);
+    ck_assert_uint_eq(mon2->queueSize, 2);
+    ck_assert_uint_eq(mon3->queueSize, 1);
+
+    /* The notifications reference the same value */
+    UA_Notification *n1 = TAILQ_LAST(&mon1->queue, NotificationQueue);
+    UA_Notification *n2 = TAILQ_LAST(&mon2->queue, NotificationQueue);
+    ck_assert_int_eq(n1->data.dataChange.value.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_int_eq(n2->data.dataChange.value.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(n1->data.dataChange.value.value.data,
+                     n2->data.dataChange.value.value.data);
+    ck_assert_uint_eq(*(UA_UInt32*)n1->data.dataChange.value.value.data, counterReads);
+
+    /* The DataSource is read with the session of the MonitoredItems */
+    ck_assert_ptr_eq(mon1->sampler->key.session, session);
+    ck_assert(UA_NodeId_equal(&counterSession, &session->sessionId));
+    UA_NodeId_clear(&counterSession);
+
+    /* Remove the MonitoredItems. The sampler is removed with the last one. */
+    UA_DeleteSubscriptionsRequest del;
+    UA_DeleteSubscriptionsRequest_init(&del);
+    del.subscriptionIdsSize = 1;
+    del.subscriptionIds = &subscriptionId;
+    UA_DeleteSubscriptionsResponse delResponse;
+    UA_DeleteSubscriptionsResponse_init(&delResponse);
+    UA_WRLOCK(server->serviceMutex);
+    Service_DeleteSubscriptions(server, session, &del, &delResponse);
+    UA_WRUNLOCK(server->serviceMutex);
+    ck_assert_uint_eq(delResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteSubscriptionsResponse_clear(&delResponse);
+    ck_assert(ZIP_EMPTY(&server->samplers));
+}
+END_TEST
+
+/* The sampler of a variable that stores the value in the node is shared
+ * between sessions. When a DataSource is attached, the MonitoredItem moves to
+ * a sampler that reads with its session. */
+START_TEST(Server_sessionSampling) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Counter");
+    UA_UInt32 zero = 0;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "counter"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Counter"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    createSubscription();
+    UA_MonitoredItem *mon = createCounterMonitoredItem(subscriptionId, 0.0);
+    ck_assert_ptr_ne(mon->sampler, NULL);
+    ck_assert_ptr_eq(mon->sampler->key.session, NULL);
+
+    UA_DataSource ds;
+    ds.read = readCounter;
+    ds.write = NULL;
+    res = UA_Server_setVariableNode_dataSource(server, UA_NODEID_STRING(1, "counter"), ds);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_ne(mon->sampler, NULL);
+    ck_assert_ptr_eq(mon->sampler->key.session, session);
+    ck_assert_uint_eq(mon->sampler->monitoredItemsSize, 1);
+
+    UA_UInt32 reads = counterReads;
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+#if UA_MULTITHREADING >= 200
+    for(size_t i = 0; i < 1000 && counterReads == reads; i++)
+        UA_realSleep(1);
+    UA_WRLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
+#endif
+    ck_assert_uint_eq(counterReads, reads + 1);
+    ck_assert(UA_NodeId_equal(&counterSession, &session->sessionId));
+    UA_NodeId_clear(&counterSession);
+}
+END_TEST
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
 
 static Suite* testSuite_Client(void) {
@@ -872,6 +1076,8 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_server, Server_publishCallback);
     tcase_add_test(tc_server, Server_lifeTimeCount);
     tcase_add_test(tc_server, Server_invalidPublishingInterval);
+    tcase_add_test(tc_server, Server_sharedSampling);
+    tcase_add_test(tc_server, Server_sessionSampling);
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
     suite_add_tcase(s, tc_server);
 
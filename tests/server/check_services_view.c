@@ -107,6 +107,134 @@ START_TEST(Service_Browse_WithMaxResults) {
 }
 END_TEST
 
+static void
+addChildObject(UA_Server *server, UA_UInt32 id) {
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, id), UA_NODEID_NUMERIC(1, 1000),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Child"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void
+checkPage(const UA_BrowseResult *br, const UA_UInt32 *expected, size_t expectedSize) {
+    ck_assert_uint_eq(br->statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br->referencesSize, expectedSize);
+    for(size_t i = 0; i < expectedSize; i++)
+        ck_assert_uint_eq(br->references[i].nodeId.nodeId.identifier.numeric, expected[i]);
+}
+
+static UA_BrowseResult
+browseNextPage(UA_Server *server, UA_BrowseResult *br) {
+    UA_ByteString cp = br->continuationPoint;
+    ck_assert_uint_gt(cp.length, 0);
+    UA_ByteString_init(&br->continuationPoint); /* Cleared below */
+    UA_BrowseResult next = UA_Server_browseNext(server, false, &cp);
+    UA_ByteString_clear(&cp);
+    return next;
+}
+
+/* References are added and removed between the calls to BrowseNext */
+START_TEST(Service_BrowseNext_ModifiedReferences) {
+    UA_Server *server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 1000),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Folder"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE), oattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(UA_UInt32 i = 2000; i < 2030; i++)
+        addChildObject(server, i);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(1, 1000);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_NONE;
+
+    /* Remove a reference that was already returned, the reference where the
+     * next page would begin and add a new one. The next page starts with the
+     * first remaining reference after the first page. */
+    UA_BrowseResult br = UA_Server_browse(server, 10, &bd);
+    const UA_UInt32 page1[10] = {2000, 2001, 2002, 2003, 2004, 2005, 2006, 2007, 2008, 2009};
+    checkPage(&br, page1, 10);
+    retval = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(1, 1000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), true,
+                                       UA_EXPANDEDNODEID_NUMERIC(1, 2003), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(1, 1000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), true,
+                                       UA_EXPANDEDNODEID_NUMERIC(1, 2010), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    addChildObject(server, 2100);
+
+    UA_BrowseResult br2 = browseNextPage(server, &br);
+    UA_BrowseResult_clear(&br);
+    const UA_UInt32 page2[10] = {2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019, 2020};
+    checkPage(&br2, page2, 10);
+
+    br = browseNextPage(server, &br2);
+    UA_BrowseResult_clear(&br2);
+    const UA_UInt32 page3[10] = {2021, 2022, 2023, 2024, 2025, 2026, 2027, 2028, 2029, 2100};
+    checkPage(&br, page3, 10);
+    ck_assert_uint_eq(br.continuationPoint.length, 0);
+    UA_BrowseResult_clear(&br);
+
+    /* Remove the reference where the next page would begin */
+    br = UA_Server_browse(server, 10, &bd);
+    const UA_UInt32 page4[10] = {2000, 2001, 2002, 2004, 2005, 2006, 2007, 2008, 2009, 2011};
+    checkPage(&br, page4, 10);
+    retval = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(1, 1000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), true,
+                                       UA_EXPANDEDNODEID_NUMERIC(1, 2012), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    br2 = browseNextPage(server, &br);
+    UA_BrowseResult_clear(&br);
+    const UA_UInt32 page5[10] = {2013, 2014, 2015, 2016, 2017, 2018, 2019, 2020, 2021, 2022};
+    checkPage(&br2, page5, 10);
+
+    /* Remove and re-add the reference where the next page would begin. The
+     * re-added reference is now the last one and is returned at the end. */
+    retval = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(1, 1000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), true,
+                                       UA_EXPANDEDNODEID_NUMERIC(1, 2023), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(server, UA_NODEID_NUMERIC(1, 1000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_EXPANDEDNODEID_NUMERIC(1, 2023), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    br = browseNextPage(server, &br2);
+    UA_BrowseResult_clear(&br2);
+    const UA_UInt32 page6[8] = {2024, 2025, 2026, 2027, 2028, 2029, 2100, 2023};
+    checkPage(&br, page6, 8);
+    ck_assert_uint_eq(br.continuationPoint.length, 0);
+    UA_BrowseResult_clear(&br);
+
+    /* Release the continuation point */
+    br2 = UA_Server_browse(server, 10, &bd);
+    ck_assert_uint_gt(br2.continuationPoint.length, 0);
+    UA_ByteString cp = br2.continuationPoint;
+    UA_ByteString_init(&br2.continuationPoint);
+    UA_BrowseResult_clear(&br2);
+    br2 = UA_Server_browseNext(server, true, &cp);
+    ck_assert_uint_eq(br2.statusCode, UA_STATUSCODE_GOOD);
+    UA_BrowseResult_clear(&br2);
+    UA_ByteString_clear(&cp);
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(Service_Browse_WithBrowseName) {
     UA_Server *server = UA_Server_new();
     UA_ServerConfig_setDefault(UA_Server_getConfig(server));
@@ -228,6 +356,7 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     TCase *tc_browse = tcase_create("Browse Service");
     tcase_add_test(tc_browse, Service_Browse_WithBrowseName);
     tcase_add_test(tc_browse, Service_Browse_WithMaxResults);
+    tcase_add_test(tc_browse, Service_BrowseNext_ModifiedReferences);
     tcase_add_test(tc_browse, Service_Browse_Recursive);
     suite_add_tcase(s, tc_browse);
 
@@ -9,10 +9,12 @@
 #include <open62541/types.h>
 
 #include "server/ua_services.h"
+#include "server/ua_server_internal.h"
 #include "client/ua_client_internal.h"
 
 #include <check.h>
 
+#include "testing_clock.h"
 #include "thread_wrapper.h"
 
 UA_Server *server;
@@ -113,6 +115,54 @@ START_TEST(Session_updateLifetime_ShallWork) {
 }
 END_TEST
 
+START_TEST(Session_indexAndTimeout) {
+    UA_WRLOCK(server->serviceMutex);
+
+    /* Create sessions with different timeouts */
+    const UA_Double timeouts[3] = {1000.0, 2000.0, 1000.0};
+    UA_NodeId tokens[3];
+    UA_NodeId ids[3];
+    UA_Session *sessions[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_CreateSessionRequest req;
+        UA_CreateSessionRequest_init(&req);
+        req.requestedSessionTimeout = timeouts[i];
+        UA_StatusCode res = UA_Server_createSession(server, NULL, &req, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        tokens[i] = sessions[i]->header.authenticationToken;
+        ids[i] = sessions[i]->sessionId;
+    }
+
+    /* Lookup by the AuthenticationToken and the SessionId */
+    for(size_t i = 0; i < 3; i++) {
+        ck_assert_ptr_eq(getSessionByToken(server, &tokens[i]), sessions[i]);
+        ck_assert_ptr_eq(UA_Server_getSessionById(server, &ids[i]), sessions[i]);
+    }
+    ck_assert_ptr_eq(getSessionByToken(server, &ids[0]), NULL);
+
+    /* The first session times out. The lifetime of the third session is
+     * extended. */
+    UA_fakeSleep(1500);
+    UA_Session_updateLifetime(sessions[2]);
+    UA_Server_cleanupSessions(server, UA_DateTime_nowMonotonic());
+    ck_assert_ptr_eq(getSessionByToken(server, &tokens[0]), NULL);
+    ck_assert_ptr_eq(UA_Server_getSessionById(server, &ids[0]), NULL);
+    ck_assert_ptr_eq(getSessionByToken(server, &tokens[1]), sessions[1]);
+    ck_assert_ptr_eq(getSessionByToken(server, &tokens[2]), sessions[2]);
+
+    /* The second session times out. The third session was extended. */
+    UA_fakeSleep(700);
+    UA_Server_cleanupSessions(server, UA_DateTime_nowMonotonic());
+    ck_assert_ptr_eq(getSessionByToken(server, &tokens[1]), NULL);
+    ck_assert_ptr_eq(getSessionByToken(server, &tokens[2]), sessions[2]);
+
+    UA_Server_removeSessionByToken(server, &tokens[2], UA_DIAGNOSTICEVENT_CLOSE);
+    ck_assert_ptr_eq(UA_Server_getSessionById(server, &ids[2]), NULL);
+
+    UA_WRUNLOCK(server->serviceMutex);
+}
+END_TEST
+
 static Suite* testSuite_Session(void) {
     Suite *s = suite_create("Session");
     TCase *tc_session = tcase_create("Core");
@@ -120,6 +170,7 @@ static Suite* testSuite_Session(void) {
     tcase_add_test(tc_session, Session_close_before_activate);
     tcase_add_test(tc_session, Session_init_ShallWork);
     tcase_add_test(tc_session, Session_updateLifetime_ShallWork);
+    tcase_add_test(tc_session, Session_indexAndTimeout);
     suite_add_tcase(s,tc_session);
     return s;
 }
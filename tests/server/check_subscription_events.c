@@ -144,10 +144,10 @@ removeSubscription(void) {
 
     UA_DeleteSubscriptionsResponse deleteSubscriptionsResponse;
     UA_DeleteSubscriptionsResponse_init(&deleteSubscriptionsResponse);
-    UA_LOCK(server->serviceMutex);
+    UA_WRLOCK(server->serviceMutex);
     Service_DeleteSubscriptions(server, &server->adminSession, &deleteSubscriptionsRequest,
                                 &deleteSubscriptionsResponse);
-    UA_UNLOCK(server->serviceMutex);
+    UA_WRUNLOCK(server->serviceMutex);
     UA_DeleteSubscriptionsResponse_deleteMembers(&deleteSubscriptionsResponse);
 }
 
@@ -385,6 +385,598 @@ START_TEST(generateEvents) {
     UA_DeleteMonitoredItemsResponse_deleteMembers(&deleteResponse);
 } END_TEST
 
+static UA_StatusCode
+triggerTransientEventLocked(UA_ByteString *outEventId) {
+    UA_QualifiedName severityName = UA_QUALIFIEDNAME(0, "Severity");
+    UA_QualifiedName messageName = UA_QUALIFIEDNAME(0, "Message");
+    UA_UInt16 eventSeverity = 1000;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    UA_EventField fields[2];
+    fields[0].browsePathSize = 1;
+    fields[0].browsePath = &severityName;
+    UA_Variant_setScalar(&fields[0].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fields[1].browsePathSize = 1;
+    fields[1].browsePath = &messageName;
+    UA_Variant_setScalar(&fields[1].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerTransientEvent(server, eventType,
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                        2, fields, outEventId);
+    serverMutexUnlock();
+    return retval;
+}
+
+static void
+deleteMonitoredItem(void) {
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = &monitoredItemId;
+    deleteRequest.monitoredItemIdsSize = 1;
+
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(deleteResponse.resultsSize, 1);
+    ck_assert_uint_eq(*(deleteResponse.results), UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_deleteMembers(&deleteResponse);
+}
+
+/* Transient events are not represented as nodes */
+START_TEST(generateTransientEvents) {
+    UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_simple, true, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = triggerTransientEventLocked(&eventId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(eventId.length, 16);
+    UA_ByteString_clear(&eventId);
+
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    deleteMonitoredItem();
+    sleepUntilAnswer(publishingInterval + 100);
+} END_TEST
+
+/* The type of a transient event is evaluated by the where clause */
+START_TEST(transientEventWhereClause) {
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+
+    UA_NodeId otherType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE);
+    UA_LiteralOperand literalOperand;
+    UA_LiteralOperand_init(&literalOperand);
+    UA_Variant_setScalar(&literalOperand.value, &otherType, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject filterOperand;
+    UA_ExtensionObject_init(&filterOperand);
+    filterOperand.encoding = UA_EXTENSIONOBJECT_DECODED;
+    filterOperand.content.decoded.type = &UA_TYPES[UA_TYPES_LITERALOPERAND];
+    filterOperand.content.decoded.data = &literalOperand;
+    UA_ContentFilterElement element;
+    UA_ContentFilterElement_init(&element);
+    element.filterOperator = UA_FILTEROPERATOR_OFTYPE;
+    element.filterOperandsSize = 1;
+    element.filterOperands = &filterOperand;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = selectClauses;
+    filter.selectClausesSize = nSelectClauses;
+    filter.whereClause.elementsSize = 1;
+    filter.whereClause.elements = &element;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+
+    UA_MonitoredItemCreateResult createResult =
+        UA_Client_MonitoredItems_createEvent(client, subscriptionId,
+                                             UA_TIMESTAMPSTORETURN_BOTH, item,
+                                             &monitoredItemId, handler_events_simple, NULL);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    UA_StatusCode retval = triggerTransientEventLocked(NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, false);
+
+    deleteMonitoredItem();
+    sleepUntilAnswer(publishingInterval + 100);
+} END_TEST
+
+START_TEST(transientEventInvalidType) {
+    UA_NodeId objectType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE);
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerTransientEvent(server, objectType,
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                        0, NULL, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINVALIDARGUMENT);
+} END_TEST
+
+static size_t typedNotifications;
+
+static void
+handler_events_typed(UA_Client *lclient, UA_UInt32 subId, void *subContext,
+                     UA_UInt32 monId, void *monContext,
+                     size_t nEventFields, UA_Variant *eventFields) {
+    /* Only the fields of matching types are resolved */
+    ck_assert_uint_eq(nEventFields, 3);
+    ck_assert(UA_Variant_hasScalarType(&eventFields[0], &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert(UA_Variant_isEmpty(&eventFields[1]));
+    ck_assert(UA_Variant_hasScalarType(&eventFields[2], &UA_TYPES[UA_TYPES_UINT16]));
+    typedNotifications++;
+}
+
+/* The typeDefinitionId of the select clauses is checked for transient events */
+START_TEST(transientEventSelectClauseType) {
+    UA_QualifiedName severityName = UA_QUALIFIEDNAME(0, "Severity");
+    UA_SimpleAttributeOperand clauses[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_SimpleAttributeOperand_init(&clauses[i]);
+        clauses[i].browsePathSize = 1;
+        clauses[i].browsePath = &severityName;
+        clauses[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    clauses[0].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    clauses[1].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE);
+    clauses[2].typeDefinitionId = eventType;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = clauses;
+    filter.selectClausesSize = 3;
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+
+    UA_MonitoredItemCreateResult createResult =
+        UA_Client_MonitoredItems_createEvent(client, subscriptionId,
+                                             UA_TIMESTAMPSTORETURN_BOTH, item,
+                                             NULL, handler_events_typed, NULL);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    typedNotifications = 0;
+    UA_StatusCode retval = triggerTransientEventLocked(NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(typedNotifications, 1);
+
+    deleteMonitoredItem();
+    sleepUntilAnswer(publishingInterval + 100);
+} END_TEST
+
+static size_t sharedNotifications;
+
+static void
+handler_events_shared(UA_Client *lclient, UA_UInt32 subId, void *subContext,
+                      UA_UInt32 monId, void *monContext,
+                      size_t nEventFields, UA_Variant *eventFields) {
+    /* The duplicate select clause is resolved once and returned twice */
+    ck_assert_uint_eq(nEventFields, nSelectClauses + 1);
+    ck_assert(UA_Variant_hasScalarType(&eventFields[0], &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert(UA_Variant_hasScalarType(&eventFields[nSelectClauses],
+                                       &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert_uint_eq(*(UA_UInt16*)eventFields[nSelectClauses].data, 1000);
+    sharedNotifications++;
+}
+
+/* MonitoredItems with the same filter share the compiled filter */
+START_TEST(sharedEventFilter) {
+    UA_SimpleAttributeOperand clauses[5];
+    memcpy(clauses, selectClauses, nSelectClauses * sizeof(UA_SimpleAttributeOperand));
+    clauses[nSelectClauses] = selectClauses[0];
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = clauses;
+    filter.selectClausesSize = nSelectClauses + 1;
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+
+    UA_UInt32 monitoredItemIdAr[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_MonitoredItemCreateResult result =
+            UA_Client_MonitoredItems_createEvent(client, subscriptionId, UA_TIMESTAMPSTORETURN_BOTH,
+                                                 item, NULL, handler_events_shared, NULL);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        monitoredItemIdAr[i] = result.monitoredItemId;
+    }
+
+    serverMutexLock();
+    UA_CompiledEventFilter *cf = ZIP_ROOT(&server->eventFilters);
+    ck_assert_ptr_ne(cf, NULL);
+    ck_assert_ptr_eq(ZIP_LEFT(cf, zipfields), NULL);
+    ck_assert_ptr_eq(ZIP_RIGHT(cf, zipfields), NULL);
+    ck_assert_uint_eq(cf->refCount, 2);
+    ck_assert_uint_eq(cf->fieldsSize, nSelectClauses);
+    serverMutexUnlock();
+
+    sharedNotifications = 0;
+    UA_StatusCode retval = triggerTransientEventLocked(NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sharedNotifications, 2);
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = monitoredItemIdAr;
+    deleteRequest.monitoredItemIdsSize = 2;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_deleteMembers(&deleteResponse);
+
+    /* The last MonitoredItem removes the filter */
+    serverMutexLock();
+    ck_assert_ptr_eq(ZIP_ROOT(&server->eventFilters), NULL);
+    serverMutexUnlock();
+    sleepUntilAnswer(publishingInterval + 100);
+} END_TEST
+
+static UA_StatusCode
+triggerTransientEventFrom(const UA_NodeId origin) {
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerTransientEvent(server, eventType, origin, 0, NULL, NULL);
+    serverMutexUnlock();
+    return retval;
+}
+
+/* The propagation of events is cached per source until the references change */
+START_TEST(eventSourceCache) {
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId organizesId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_NodeId sourceId = UA_NODEID_STRING(1, "EventSource");
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, sourceId, objectsId, organizesId,
+                                UA_QUALIFIEDNAME(1, "EventSource"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = triggerTransientEventFrom(sourceId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    serverMutexLock();
+    UA_EventSource *es = ZIP_ROOT(&server->eventSources);
+    ck_assert_ptr_ne(es, NULL);
+    ck_assert(UA_NodeId_equal(&es->nodeId, &sourceId));
+    ck_assert_uint_eq(es->originResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_ge(es->emitNodesSize, 2); /* The source and the server */
+    serverMutexUnlock();
+
+    /* Not below the ObjectsFolder without the reference */
+    UA_ExpandedNodeId targetId = UA_EXPANDEDNODEID_NUMERIC(0, 0);
+    targetId.nodeId = sourceId;
+    serverMutexLock();
+    retval = UA_Server_deleteReference(server, objectsId, organizesId, true,
+                                       targetId, true);
+    ck_assert_ptr_eq(ZIP_ROOT(&server->eventSources), NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = triggerTransientEventFrom(sourceId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINVALIDARGUMENT);
+
+    serverMutexLock();
+    retval = UA_Server_addReference(server, objectsId, organizesId, targetId, true);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = triggerTransientEventFrom(sourceId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    serverMutexLock();
+    retval = UA_Server_deleteNode(server, sourceId, true);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = triggerTransientEventFrom(sourceId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+} END_TEST
+
+static UA_NodeId cacheResetId;
+static UA_Boolean cacheResetLinked;
+static size_t cacheResetNotifications;
+
+/* Reading the event field changes a propagating reference. This drops the
+ * cached event sources while the event is added to the MonitoredItems. */
+static UA_StatusCode
+readCacheReset(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+               const UA_NodeId *nodeId, void *nodeContext,
+               UA_Boolean includeSourceTimeStamp, const UA_NumericRange *range,
+               UA_DataValue *value) {
+    UA_ExpandedNodeId targetId = UA_EXPANDEDNODEID_NUMERIC(0, 0);
+    targetId.nodeId = cacheResetId;
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId organizesId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    if(cacheResetLinked)
+        UA_Server_deleteReference(s, objectsId, organizesId, true, targetId, true);
+    else
+        UA_Server_addReference(s, objectsId, organizesId, targetId, true);
+    cacheResetLinked = !cacheResetLinked;
+
+    UA_UInt16 severity = 1000;
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+}
+
+static void
+handler_events_cacheReset(UA_Client *lclient, UA_UInt32 subId, void *subContext,
+                          UA_UInt32 monId, void *monContext,
+                          size_t nEventFields, UA_Variant *eventFields) {
+    ck_assert_uint_eq(nEventFields, nSelectClauses + 1);
+    ck_assert(UA_Variant_hasScalarType(&eventFields[nSelectClauses],
+                                       &UA_TYPES[UA_TYPES_UINT16]));
+    cacheResetNotifications++;
+}
+
+/* The cached event source is dropped while the event is added to the first
+ * MonitoredItem. The second MonitoredItem still receives the event. */
+START_TEST(eventSourceCacheResetDuringEmit) {
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId organizesId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL, objectsId, organizesId,
+                                UA_QUALIFIEDNAME(1, "CacheReset"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oAttr, NULL, &cacheResetId);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    cacheResetLinked = true;
+
+    /* The event has a field that is read from a DataSource */
+    UA_NodeId eventNodeId;
+    retval = eventSetup(&eventNodeId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataSource ds;
+    ds.read = readCacheReset;
+    ds.write = NULL;
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    serverMutexLock();
+    retval = UA_Server_addDataSourceVariableNode(server, UA_NODEID_NULL, eventNodeId,
+                                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                                 UA_QUALIFIEDNAME(1, "CacheReset"),
+                                                 UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                                 vAttr, ds, NULL, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_SimpleAttributeOperand clauses[5];
+    memcpy(clauses, selectClauses, nSelectClauses * sizeof(UA_SimpleAttributeOperand));
+    UA_QualifiedName cacheResetName = UA_QUALIFIEDNAME(1, "CacheReset");
+    UA_SimpleAttributeOperand_init(&clauses[nSelectClauses]);
+    clauses[nSelectClauses].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    clauses[nSelectClauses].browsePathSize = 1;
+    clauses[nSelectClauses].browsePath = &cacheResetName;
+    clauses[nSelectClauses].attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = clauses;
+    filter.selectClausesSize = nSelectClauses + 1;
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+
+    UA_UInt32 monitoredItemIdAr[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_MonitoredItemCreateResult result =
+            UA_Client_MonitoredItems_createEvent(client, subscriptionId, UA_TIMESTAMPSTORETURN_BOTH,
+                                                 item, NULL, handler_events_cacheReset, NULL);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        monitoredItemIdAr[i] = result.monitoredItemId;
+    }
+
+    cacheResetNotifications = 0;
+    retval = triggerEventLocked(eventNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER), NULL, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cacheResetNotifications, 2);
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = monitoredItemIdAr;
+    deleteRequest.monitoredItemIdsSize = 2;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_deleteMembers(&deleteResponse);
+    sleepUntilAnswer(publishingInterval + 100);
+} END_TEST
+
+static UA_NodeId
+findChild(const UA_NodeId parent, const UA_QualifiedName name) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    rpe.targetName = name;
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = parent;
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_NodeId id;
+    UA_NodeId_copy(&bpr.targets[0].targetId.nodeId, &id);
+    UA_BrowsePathResult_clear(&bpr);
+    return id;
+}
+
+static UA_Boolean
+hasEventMonitoredItems(const UA_NodeId id) {
+    const UA_Node *node = UA_NODESTORE_GET(server, &id);
+    ck_assert_ptr_ne(node, NULL);
+    UA_Boolean res = (node->objectNode.monitoredItemQueue != NULL);
+    UA_NODESTORE_RELEASE(server, node);
+    return res;
+}
+
+/* The instances of a type do not inherit the event MonitoredItems that are
+ * registered at the declaration of a child */
+START_TEST(instantiateWithEventMonitoredItems) {
+    UA_NodeId typeId = UA_NODEID_STRING(1, "DeviceWithAlarms");
+    UA_NodeId declId = UA_NODEID_STRING(1, "DeviceWithAlarms.Alarms");
+    UA_QualifiedName alarmsName = UA_QUALIFIEDNAME(1, "Alarms");
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    oAttr.eventNotifier = 1; /* SubscribeToEvents */
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, typeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "DeviceWithAlarms"),
+                                    otAttr, NULL, NULL);
+    retval |= UA_Server_addObjectNode(server, declId, typeId,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                      alarmsName,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                      oAttr, NULL, NULL);
+    retval |= UA_Server_addReference(server, declId,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                     UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                     true);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Monitor the declaration */
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = declId;
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = selectClauses;
+    filter.selectClausesSize = nSelectClauses;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+    UA_MonitoredItemCreateResult result =
+        UA_Client_MonitoredItems_createEvent(client, subscriptionId, UA_TIMESTAMPSTORETURN_BOTH,
+                                             item, NULL, handler_events_simple, NULL);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+
+    /* Instantiate regularly and in bulk */
+    UA_NodeId deviceId = UA_NODEID_STRING(1, "Device");
+    UA_NodeId bulkIds[2];
+    UA_QualifiedName bulkNames[2] = {UA_QUALIFIEDNAME(1, "BulkDevice1"),
+                                     UA_QUALIFIEDNAME(1, "BulkDevice2")};
+    serverMutexLock();
+    ck_assert(hasEventMonitoredItems(declId));
+    retval = UA_Server_addObjectNode(server, deviceId,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_QUALIFIEDNAME(1, "Device"), typeId,
+                                     UA_ObjectAttributes_default, NULL, NULL);
+    retval |= UA_Server_addObjectNodes(server, 2, NULL,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       bulkNames, typeId, UA_ObjectAttributes_default,
+                                       NULL, bulkIds);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId childId = findChild(deviceId, alarmsName);
+    ck_assert(!hasEventMonitoredItems(childId));
+    UA_NodeId_clear(&childId);
+    for(size_t i = 0; i < 2; i++) {
+        childId = findChild(bulkIds[i], alarmsName);
+        ck_assert(!hasEventMonitoredItems(childId));
+        UA_NodeId_clear(&childId);
+    }
+    serverMutexUnlock();
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = &result.monitoredItemId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_deleteMembers(&deleteResponse);
+
+    serverMutexLock();
+    ck_assert(!hasEventMonitoredItems(declId));
+    retval = UA_Server_deleteNode(server, deviceId, true);
+    for(size_t i = 0; i < 2; i++) {
+        retval |= UA_Server_deleteNode(server, bulkIds[i], true);
+        UA_NodeId_clear(&bulkIds[i]);
+    }
+    retval |= UA_Server_deleteNode(server, typeId, true);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+} END_TEST
+
 static bool hasBaseModelChangeEventType(void) {
 
     UA_QualifiedName readBrowsename;
@@ -763,6 +1355,14 @@ static Suite *testSuite_Client(void) {
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEventEmptyFilter);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, generateTransientEvents);
+    tcase_add_test(tc_server, transientEventWhereClause);
+    tcase_add_test(tc_server, transientEventInvalidType);
+    tcase_add_test(tc_server, transientEventSelectClauseType);
+    tcase_add_test(tc_server, sharedEventFilter);
+    tcase_add_test(tc_server, eventSourceCache);
+    tcase_add_test(tc_server, eventSourceCacheResetDuringEmit);
+    tcase_add_test(tc_server, instantiateWithEventMonitoredItems);
     tcase_add_test(tc_server, createAbstractEvent);
     tcase_add_test(tc_server, createAbstractEventWithParent);
     tcase_add_test(tc_server, createNonAbstractEventWithParent);
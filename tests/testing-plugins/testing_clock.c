@@ -43,6 +43,17 @@ UA_realSleep(UA_UInt32 duration) {
 #endif
 }
 
+UA_Double
+UA_realTime(void) {
+#ifdef _WIN32
+    return (UA_Double)GetTickCount64() / 1e3;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UA_Double)ts.tv_sec + ((UA_Double)ts.tv_nsec / 1e9);
+#endif
+}
+
 void
 UA_comboSleep(unsigned long duration) {
     UA_fakeSleep((UA_UInt32)duration);
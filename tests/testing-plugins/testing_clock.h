@@ -20,4 +20,8 @@ void UA_fakeSleep(UA_UInt32 duration);
 /* Sleep for the duration in milliseconds. Used to wait for workers to complete. */
 void UA_realSleep(UA_UInt32 duration);
 
+/* Monotonic real time in seconds. The testing clock only advances with
+ * UA_fakeSleep. Use this to measure how long the actual work takes. */
+UA_Double UA_realTime(void);
+
 #endif /* TESTING_CLOCK_H_ */
@@ -58,6 +58,12 @@ if is_c:
 # define _CRT_SECURE_NO_WARNINGS
 #endif
 
+/* Enable the GNU extensions (e.g. recvmmsg) before the first system include.
+ * Defining it later in one of the amalgamated files has no effect. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE
+#endif
+
 #include "%s.h"
 ''' % outname)
 else: